@@ -0,0 +1,149 @@
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "GNU Lesser General Public License (LGPL)".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+#ifndef OSS_JSCODECACHE_H_INCLUDED
+#define OSS_JSCODECACHE_H_INCLUDED
+
+#include "OSS/build.h"
+#if ENABLE_FEATURE_V8
+
+#include "v8.h"
+#include <map>
+#include <list>
+#include <vector>
+#include <boost/shared_ptr.hpp>
+#include <boost/noncopyable.hpp>
+#include "OSS/UTL/CoreUtils.h"
+#include "OSS/UTL/Thread.h"
+
+
+namespace OSS {
+namespace JS {
+
+
+class JSCodeCache : boost::noncopyable
+  /// Compiled code shared by every isolate in the process.
+  ///
+  /// Scripts are keyed by a hash of their name and source.  The first
+  /// isolate that compiles a script does so eagerly and stores the V8 code
+  /// cache in memory.  Later isolates skip parsing and compiling.  Entries
+  /// that V8 rejects because the engine or its flags changed are replaced.
+  ///
+  /// Scripts loaded from a file also keep their code cache in the cache
+  /// directory so later processes benefit from it.  There is one file per
+  /// script file.  It is overwritten when the script changes so the
+  /// directory does not grow with every edit.  Scripts compiled from
+  /// strings, ie js_compile or inline isolate scripts, are only cached in
+  /// memory since their number is unbounded.
+  ///
+  /// The cache directory defaults to <localstatedir>/cache/oss_core/js and
+  /// can be changed with the OSS_JS_CODE_CACHE_DIR environment variable.
+  /// An empty value keeps the cache in memory only.  Setting
+  /// OSS_JS_CODE_CACHE=0 disables the cache altogether.
+  ///
+  /// The in-memory entries are bounded to OSS_JS_CODE_CACHE_SIZE bytes,
+  /// 32 MB by default.  The least recently used ones are dropped first and
+  /// are read back from their file when needed.
+{
+public:
+  typedef std::vector<uint8_t> Data;
+  typedef boost::shared_ptr<Data> DataPtr;
+  typedef std::list<OSS::UInt64> LruList;
+
+  struct Entry
+  {
+    DataPtr data;
+    LruList::iterator lru;
+  };
+  typedef std::map<OSS::UInt64, Entry> Entries;
+
+  enum
+  {
+    DEFAULT_MAX_SIZE = 32 * 1024 * 1024
+  };
+
+  struct Stats
+  {
+    Stats() : hits(0), misses(0), rejects(0), evictions(0), entries(0), size(0) {}
+    std::size_t hits;
+    std::size_t misses;
+    std::size_t rejects;
+    std::size_t evictions;
+    std::size_t entries;
+    std::size_t size;
+  };
+
+  static JSCodeCache& instance();
+
+  v8::MaybeLocal<v8::Script> compile(v8::Local<v8::Context> context, const std::string& source, const std::string& name);
+    /// Compiles source in context using the cached code when available.
+    /// An empty name leaves the script origin undefined.
+
+  void setEnabled(bool enabled);
+  bool isEnabled() const;
+
+  void setDirectory(const std::string& directory);
+    /// Sets the directory where code caches persist.  Empty disables
+    /// the on-disk cache.
+  std::string getDirectory() const;
+
+  void setMaxSize(std::size_t size);
+    /// Sets the number of bytes of code kept in memory.  Zero keeps
+    /// nothing in memory.
+  std::size_t getMaxSize() const;
+
+  void clear();
+    /// Drops the in-memory entries.  Files are left alone.
+
+  Stats getStats() const;
+
+private:
+  JSCodeCache();
+  ~JSCodeCache();
+
+  OSS::UInt64 getKey(const std::string& source, const std::string& name) const;
+  DataPtr find(OSS::UInt64 key, const std::string& name);
+  void store(OSS::UInt64 key, const std::string& name, const DataPtr& data);
+  void erase(OSS::UInt64 key, const std::string& name);
+  void insert(OSS::UInt64 key, const DataPtr& data);
+  void remove(Entries::iterator iter);
+  void evict();
+  bool isPersistent(const std::string& name) const;
+    /// Returns true if the code cache of the script named name is kept
+    /// in the cache directory
+  std::string getFileName(const std::string& name) const;
+    /// Returns the cache file of the script file named name.  The file
+    /// starts with the key of the source it was created from.
+
+  mutable OSS::mutex_critic_sec _mutex;
+  Entries _entries;
+  LruList _lru;
+    /// Keys from the most to the least recently used
+  std::size_t _size;
+  std::size_t _maxSize;
+  std::string _directory;
+  bool _enabled;
+  Stats _stats;
+};
+
+
+} } // OSS::JS
+
+#endif // ENABLE_FEATURE_V8
+#endif // OSS_JSCODECACHE_H_INCLUDED
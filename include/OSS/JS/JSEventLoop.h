@@ -55,15 +55,42 @@ public:
   typedef boost::function<void(std::string message)> StringQueueCallback;
   typedef boost::promise<std::string> Promise;
   typedef boost::future<std::string> Future;
-  typedef std::vector<pollfd> Descriptors;
 
+  enum WatchType
+  {
+    WATCH_WAKEUP,
+    WATCH_CALLBACK,
+    WATCH_QUEUE,
+    WATCH_DESCRIPTOR
+  };
+
+  enum
+  {
+    DEFAULT_TURN_BUDGET = 256,
+    IDLE_TIMEOUT_MS = 100,
+    MAX_EVENTS_PER_WAIT = 256
+  };
 
   JSEventLoop(JSIsolate* pIsolate);
   ~JSEventLoop();
   
   void processEvents();
+    /// Runs the loop until terminated.  Every turn drains the queued tasks,
+    /// inter-isolate calls, expired timers and each ready descriptor, each
+    /// up to the turn budget, before waiting again.
+
   void terminate();
   void join();
+
+  bool watch(int fd, int events, WatchType type);
+    /// Registers fd with the loop's epoll set for the poll(2) events given.
+    /// Registrations persist until unwatch() is called or the descriptor
+    /// is closed.  Returns false if the loop has no epoll set.
+
+  void unwatch(int fd);
+
+  void setTurnBudget(std::size_t budget);
+    /// Maximum number of items handled per source in a single turn
   
   JSIsolate* getIsolate();
   JSFileDescriptorManager& fdManager();
@@ -89,6 +116,8 @@ protected:
   JSTimerManager _timerManager;
   JSInterIsolateCallManager _interIsolate;
   OSS::UInt64  _garbageCollectionFrequency; 
+  int _epollFd;
+  std::size_t _turnBudget;
 };
 
 //
@@ -135,6 +164,11 @@ inline bool JSEventLoop::isTerminated() const
   return _isTerminated;
 }
 
+inline void JSEventLoop::setTurnBudget(std::size_t budget)
+{
+  _turnBudget = budget ? budget : 1;
+}
+
 
 } } 
 
@@ -41,7 +41,6 @@ class JSEventQueueManager : public JSEventLoopComponent
 public:
   typedef std::map<int, QueueObject*> QueueObjectMap;
   typedef QueueObject::Event::Ptr EventPtr;
-  typedef std::vector<pollfd> Descriptors;
 
   JSEventQueueManager(JSEventLoop* pEventLoop);
   ~JSEventQueueManager();
@@ -51,8 +50,9 @@ public:
   QueueObject* findQueue(int fd);
   bool enqueue(int fd, const EventPtr& pEvent);
   bool dequeue(int fd);
+  std::size_t dequeue(int fd, std::size_t budget);
+    /// Delivers up to budget queued events and returns how many were delivered
   std::size_t getSize();
-  void appendDescriptors(Descriptors& descriptors);
   
 private:
   OSS::mutex _queuesMutex;
@@ -37,7 +37,6 @@ class JSFileDescriptorManager : public JSEventLoopComponent
 {
 public:
   typedef std::map<int, JSFileDescriptor::Ptr> DescriptorMap;
-  typedef std::vector<pollfd> Descriptors;
   
   JSFileDescriptorManager(JSEventLoop* pEventLoop);
   ~JSFileDescriptorManager();
@@ -45,7 +44,6 @@ public:
   void addFileDescriptor(v8::Isolate* isolate, int fd, v8::Handle<v8::Value> ioHandler, int events);
   bool removeFileDescriptor(int fd);
   JSFileDescriptor::Ptr findDescriptor(int fd);
-  void appendDescriptors(Descriptors& descriptors);
   bool signalIO(v8::Isolate* isolate, pollfd pfd);
   
   //
@@ -44,6 +44,8 @@ public:
   void execute(v8::Handle<v8::Value> func, v8::Handle<v8::Value>  args, v8::Handle<v8::Value> resultHandler);
   void execute(const JSFunctionCallback::Ptr& fun);
   bool doOneWork();
+  std::size_t doWork(std::size_t budget);
+    /// Executes up to budget queued callbacks and returns how many were run
   int getFd() const;
 };
 
@@ -26,6 +26,7 @@
 
 #include "OSS/JS/JS.h"
 #include "OSS/JSON/Json.h"
+#include "OSS/JS/JSStructuredMessage.h"
 #include <boost/shared_ptr.hpp>
 #include <boost/noncopyable.hpp>
 #include <boost/thread.hpp>
@@ -56,18 +57,25 @@ public:
   uint32_t getTimeout() const;
   bool waitForResult();
   std::string json() const;
+  bool isStructured() const;
+  const JSStructuredMessage::Ptr& getStructuredRequest() const;
+  const JSStructuredMessage::Ptr& getStructuredResult() const;
 
 protected:
   JSInterIsolateCall();
   JSInterIsolateCall(const Request& request, uint32_t timeout, void* userData);
   JSInterIsolateCall(const Request& request, uint32_t timeout, void* userData, JSPersistentFunctionHandle* cb);
+  JSInterIsolateCall(const JSStructuredMessage::Ptr& request, uint32_t timeout, void* userData);
   void setValue(const std::string& value);
+  void setStructuredResult(const JSStructuredMessage::Ptr& result);
   Request _request;
   Result _result;
   void* _userData;
   uint32_t _timeout;
   Future _future;
   JSPersistentFunctionHandle* _cb;
+  JSStructuredMessage::Ptr _structuredRequest;
+  JSStructuredMessage::Ptr _structuredResult;
   friend class JSInterIsolateCallManager;
 };
 
@@ -102,6 +110,15 @@ inline JSInterIsolateCall::JSInterIsolateCall(const Request& request, uint32_t t
    _future = get_future();
 }
 
+inline JSInterIsolateCall::JSInterIsolateCall(const JSStructuredMessage::Ptr& request, uint32_t timeout, void* userData) :
+  _userData(userData),
+  _timeout(timeout),
+  _cb(0),
+  _structuredRequest(request)
+{
+   _future = get_future();
+}
+
 inline JSInterIsolateCall::~JSInterIsolateCall()
 {
 }
@@ -161,7 +178,16 @@ inline bool JSInterIsolateCall::waitForResult()
       return false;
     }
   }
-  return setResult(_future.get());
+  std::string value = _future.get();
+  if (_structuredRequest)
+  {
+    //
+    // The promise only signals completion.  The result was stored
+    // before it was fulfilled.
+    //
+    return _structuredResult && !_structuredResult->empty();
+  }
+  return setResult(value);
 }
 
 inline std::string JSInterIsolateCall::json() const
@@ -176,6 +202,27 @@ inline void JSInterIsolateCall::setValue(const std::string& value)
   set_value(value);
 }
 
+inline void JSInterIsolateCall::setStructuredResult(const JSStructuredMessage::Ptr& result)
+{
+  _structuredResult = result;
+  set_value(std::string());
+}
+
+inline bool JSInterIsolateCall::isStructured() const
+{
+  return !!_structuredRequest;
+}
+
+inline const JSStructuredMessage::Ptr& JSInterIsolateCall::getStructuredRequest() const
+{
+  return _structuredRequest;
+}
+
+inline const JSStructuredMessage::Ptr& JSInterIsolateCall::getStructuredResult() const
+{
+  return _structuredResult;
+}
+
 
  
 } } // OSS::JS
@@ -40,6 +40,13 @@ public:
   typedef std::queue<JSInterIsolateCall::Ptr> CallQueue;
   typedef JSInterIsolateCall::Request Request;
   typedef JSInterIsolateCall::Result Result;
+
+  struct Notification
+  {
+    JSStructuredMessage::Ptr message;
+    void* userData;
+  };
+  typedef std::deque<Notification> NotificationQueue;
   
   JSInterIsolateCallManager(JSEventLoop* pEventLoop);
   ~JSInterIsolateCallManager();
@@ -49,15 +56,35 @@ public:
   void notify(const Request& request, void* userData, JSPersistentFunctionHandle* cb);
   bool execute(const std::string& request, std::string& result, uint32_t timeout, void* userData);
   bool execute(const Request& request, Result& result, uint32_t timeout, void* userData);
+
+  bool execute(const JSStructuredMessage::Ptr& request, JSStructuredMessage::Ptr& result, uint32_t timeout, void* userData);
+    /// Calls the structured handler of the isolate with the decoded request
+    /// and waits for its encoded return value
+
+  void notify(const JSStructuredMessage::Ptr& request, void* userData);
+    /// Fire and forget.  Notifications are queued without a promise and
+    /// the loop is only woken up when the queue goes from empty to
+    /// non-empty, so a burst costs a single wakeup and is handled in one
+    /// turn.
+
   void setHandler(const JSCopyablePersistentFunctionHandle& handler);
+  void setStructuredHandler(const JSCopyablePersistentFunctionHandle& handler);
   bool doOneWork();
+  std::size_t doWork(std::size_t budget);
+    /// Handles up to budget queued calls and returns how many were handled
   bool isEnabled();
 protected:
   void enqueue(const JSInterIsolateCall::Ptr& pCall);
   JSInterIsolateCall::Ptr dequeue();
+  std::size_t doNotifications(std::size_t budget);
+  void executeStructured(const JSInterIsolateCall::Ptr& pCall);
+  v8::MaybeLocal<v8::Value> callStructuredHandler(const JSStructuredMessage::Ptr& message, void* userData);
   OSS::mutex_critic_sec _queueMutex;
   CallQueue _queue;
+  OSS::mutex_critic_sec _notificationMutex;
+  NotificationQueue _notifications;
   JSCopyablePersistentFunctionHandle _handler;
+  JSCopyablePersistentFunctionHandle _structuredHandler;
   friend class JSEventLoop;
 };
 
@@ -70,9 +97,14 @@ inline void JSInterIsolateCallManager::setHandler(const JSCopyablePersistentFunc
   _handler = handler;
 }
 
+inline void JSInterIsolateCallManager::setStructuredHandler(const JSCopyablePersistentFunctionHandle& handler)
+{
+  _structuredHandler = handler;
+}
+
 inline bool JSInterIsolateCallManager::isEnabled()
 {
-  return !_handler.IsEmpty();
+  return !_handler.IsEmpty() || !_structuredHandler.IsEmpty();
 }
 
 } }
@@ -0,0 +1,106 @@
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "GNU Lesser General Public License (LGPL)".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+#ifndef OSS_JSSTRUCTUREDMESSAGE_H_INCLUDED
+#define OSS_JSSTRUCTUREDMESSAGE_H_INCLUDED
+
+#include "OSS/build.h"
+#if ENABLE_FEATURE_V8
+
+#include "v8.h"
+#include <vector>
+#include <boost/shared_ptr.hpp>
+#include <boost/noncopyable.hpp>
+
+//
+// Backing stores can be shared between isolates starting with V8 7.9.
+// Older engines copy transferred buffers like any other value.
+//
+#if V8_MAJOR_VERSION > 7 || (V8_MAJOR_VERSION == 7 && V8_MINOR_VERSION >= 9)
+#define OSS_JS_HAVE_BACKING_STORE 1
+#include <memory>
+#else
+#define OSS_JS_HAVE_BACKING_STORE 0
+#endif
+
+
+namespace OSS {
+namespace JS {
+
+
+class JSStructuredMessage : boost::noncopyable
+  /// A JavaScript value encoded with the V8 structured clone format.
+  ///
+  /// The message is created in one isolate and decoded in another without
+  /// going through JSON.  Objects, arrays, strings, numbers, dates, maps,
+  /// sets, regular expressions and typed arrays are supported.
+  /// ArrayBuffers in the transfer list are moved instead of copied and are
+  /// detached in the sending isolate.
+{
+public:
+  typedef boost::shared_ptr<JSStructuredMessage> Ptr;
+
+  JSStructuredMessage();
+  ~JSStructuredMessage();
+
+  bool serialize(v8::Isolate* isolate, v8::Local<v8::Value> value);
+    /// Encodes value.  Returns false and leaves a pending exception in
+    /// the isolate if the value can not be cloned.
+
+  bool serialize(v8::Isolate* isolate, v8::Local<v8::Value> value, v8::Local<v8::Value> transferList);
+    /// Encodes value moving the ArrayBuffers of transferList, which must
+    /// be an array, into the message
+
+  v8::MaybeLocal<v8::Value> deserialize(v8::Isolate* isolate);
+    /// Decodes the message in the current context of isolate.  Transferred
+    /// buffers can only be claimed by the first call.
+
+  std::size_t size() const;
+    /// Size of the encoded value excluding transferred buffers
+
+  bool empty() const;
+
+private:
+  void clear();
+  uint8_t* _data;
+  std::size_t _size;
+#if OSS_JS_HAVE_BACKING_STORE
+  std::vector< std::shared_ptr<v8::BackingStore> > _transfers;
+#endif
+};
+
+//
+// Inlines
+//
+
+inline std::size_t JSStructuredMessage::size() const
+{
+  return _size;
+}
+
+inline bool JSStructuredMessage::empty() const
+{
+  return !_data;
+}
+
+
+} } // OSS::JS
+
+#endif // ENABLE_FEATURE_V8
+#endif // OSS_JSSTRUCTUREDMESSAGE_H_INCLUDED
@@ -44,6 +44,8 @@ public:
   void queueTask(const JSTask::Task& task, void* userData, const JSTask::Task& completionCallback = JSTask::Task());
   void queueTask(const JSTask::Ptr& pTask);
   bool doOneWork();
+  std::size_t doWork(std::size_t budget);
+    /// Executes up to budget queued tasks and returns how many were run
   
 private:
   OSS::mutex_critic_sec _mutex;
@@ -24,7 +24,6 @@
 #if ENABLE_FEATURE_V8
 #include "OSS/JS/JS.h"
 #include "OSS/JS/JSFunctionCallback.h"
-#include "OSS/Net/Net.h"
 
 
 namespace OSS {
@@ -41,13 +40,10 @@ public:
 protected:
   JSTimer(JSTimerManager* pManager, int id, int expire, const v8::Handle<v8::Value>& callback, const v8::Handle<v8::Value>& args);
   JSTimer(JSTimerManager* pManager, int id, int expire, const v8::Handle<v8::Value>& callback);
-  void onTimerExpire();
-  void cancel();
   int getIdentifier() const;
   int getExpireTime() const;
   int _expire;
   int _id;
-  OSS::NET_TIMER_HANDLE _timer;
   JSTimerManager* _pManager;
   friend class JSTimerManager;
 };
@@ -24,8 +24,9 @@
 #include "OSS/build.h"
 #if ENABLE_FEATURE_V8
 #include "OSS/JS/JS.h"
-#include "OSS/JS/JSFunctionCallbackQueue.h"
+#include "OSS/JS/JSEventLoopComponent.h"
 #include "OSS/JS/JSTimer.h"
+#include <vector>
 
 
 namespace OSS {
@@ -33,7 +34,11 @@ namespace JS {
 
 class JSEventLoop;
 
-class JSTimerManager : public JSFunctionCallbackQueue
+class JSTimerManager : public JSEventLoopComponent
+  /// One shot timers of the isolate.  Deadlines are kept in a binary heap
+  /// and fired by the event loop itself so no thread or descriptor is
+  /// needed per timer.  Cancelled timers are removed from the map right
+  /// away and skipped when their heap entry reaches the top.
 {
 public:
   typedef std::map<int, JSTimer::Ptr> TimerMap;
@@ -42,17 +47,50 @@ public:
   int scheduleTimer(int expire, const v8::Handle<v8::Value>& callback, const v8::Handle<v8::Value>& args);
   int scheduleTimer(int expire, const v8::Handle<v8::Value>& callback);
   void cancelTimer(int timerId);
-  
+
+  int getTimeout(int maxTimeout);
+    /// Returns the milliseconds until the earliest timer is due capped
+    /// at maxTimeout.  Returns 0 if a timer is already due.
+
+  std::size_t doWork(std::size_t budget);
+    /// Fires up to budget expired timers and returns how many were fired
+
+  std::size_t getSize();
+
 protected:
+  struct Deadline
+  {
+    OSS::UInt64 expire;
+    int id;
+    bool operator < (const Deadline& other) const
+    {
+      //
+      // std heap functions build a max heap.  Reverse the ordering so the
+      // earliest deadline, then the oldest timer, is on top.
+      //
+      return expire != other.expire ? expire > other.expire : id > other.id;
+    }
+  };
+  typedef std::vector<Deadline> Deadlines;
+
+  void addTimer(int id, int expire, const JSTimer::Ptr& pTimer);
   JSTimer::Ptr removeTimer(int timerId);
+  void compact();
 private:
   OSS::mutex_critic_sec _timersMutex;
   TimerMap _timers;
+  Deadlines _deadlines;
   int _timerIdCounter;
   friend class JSTimer;
   
 };
 
+inline std::size_t JSTimerManager::getSize()
+{
+  OSS::mutex_critic_sec_lock lock(_timersMutex);
+  return _timers.size();
+}
+
 } } // OSSJS
 
 
@@ -28,6 +28,7 @@
 
 
 #include <unistd.h>
+#include <fcntl.h>
 #include <boost/noncopyable.hpp>
 
 
@@ -41,6 +42,7 @@ public:
   ~JSWakeupPipe();
   void wakeup();
   void clearOne();
+  void clearAll();
   int getFd();
   
 protected:
@@ -54,6 +56,12 @@ protected:
 inline JSWakeupPipe::JSWakeupPipe()
 {
   pipe(_wakeupPipe);
+  //
+  // The event loop drains every pending byte on each turn so a full pipe
+  // can safely drop wakeups instead of blocking the writer
+  //
+  fcntl(_wakeupPipe[0], F_SETFL, fcntl(_wakeupPipe[0], F_GETFL) | O_NONBLOCK);
+  fcntl(_wakeupPipe[1], F_SETFL, fcntl(_wakeupPipe[1], F_GETFL) | O_NONBLOCK);
 }
 
 inline JSWakeupPipe::~JSWakeupPipe()
@@ -82,6 +90,12 @@ inline void JSWakeupPipe::clearOne()
   (void)r;
 }
 
+inline void JSWakeupPipe::clearAll()
+{
+  char buf[256];
+  while (read(_wakeupPipe[0], buf, sizeof(buf)) == (ssize_t)sizeof(buf));
+}
+
 } } // OSS::JS
 
 
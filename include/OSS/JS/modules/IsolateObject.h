@@ -36,6 +36,8 @@ public:
   JS_METHOD_DECLARE(join);
   JS_METHOD_DECLARE(execute);
   JS_METHOD_DECLARE(notify);
+  JS_METHOD_DECLARE(executeStructured);
+  JS_METHOD_DECLARE(notifyStructured);
   IsolateObject(bool isRoot = false);
   ~IsolateObject();
 protected:
@@ -23,6 +23,8 @@
 
 #include "OSS/JSON/reader.h"
 #include "OSS/JSON/writer.h"
+#include "OSS/JSON/JsonParser.h"
+#include "OSS/JSON/JsonWriter.h"
 
 namespace OSS {
 namespace JSON {
@@ -38,25 +40,24 @@ typedef json::Reader Reader;
 typedef json::Writer Writer;
 typedef json::Exception Exception;
 
+bool json_parse(const char* data, std::size_t size, OSS::JSON::UnknownElement& element, OSS::JSON::Exception& e);
+bool json_parse(const char* data, std::size_t size, OSS::JSON::Object& object, OSS::JSON::Exception& e);
+bool json_parse(const char* data, std::size_t size, OSS::JSON::Array& array, OSS::JSON::Exception& e);
+  /// Builds a DOM from the document in data using JsonParser.  The Object
+  /// and Array versions fail if the document is of a different type.
+
 bool json_parse_string(const std::string& jsonString, OSS::JSON::Object& object);
 bool json_parse_string(const std::string& jsonString, OSS::JSON::Object& object, OSS::JSON::Exception& e);
 bool json_object_to_string(const OSS::JSON::Object& object, std::string& jsonString);
 bool json_object_to_string(const OSS::JSON::Object& object, std::string& jsonString, OSS::JSON::Exception& e);
+  /// Writes compact JSON.  Use Writer::Write for the indented form.
 
 template <typename T>
 bool json_to_string(const T& object, std::string& jsonString, OSS::JSON::Exception& e)
 {
-  try
-  {
-    std::stringstream ostr;
-    OSS::JSON::Writer::Write(object, ostr);
-    jsonString = ostr.str();
-  }
-  catch(OSS::JSON::Exception& e_)
-  {
-    e = e_;
-    return false;
-  }
+  jsonString.clear();
+  OSS::JSON::JsonWriter writer(jsonString);
+  writer.write(object);
   return true;
 }
 
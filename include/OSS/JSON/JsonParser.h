@@ -0,0 +1,694 @@
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "GNU Lesser General Public License (LGPL)".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+#ifndef OSS_JSONPARSER_H_INCLUDED
+#define OSS_JSONPARSER_H_INCLUDED
+
+
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <cstring>
+#include "OSS/OSS.h"
+
+
+namespace OSS {
+namespace JSON {
+
+
+class JsonParser
+  /// Pull parser that walks a JSON document held in memory and reports
+  /// what it finds to a handler.  Nothing is allocated per value.
+  ///
+  /// The handler is any class with the following members.  Returning
+  /// false from any of them stops the parser with ERROR_HANDLER.
+  ///
+  ///   bool onNull();
+  ///   bool onBoolean(bool value);
+  ///   bool onNumber(double value);
+  ///   bool onString(const char* value, std::size_t size);
+  ///   bool onKey(const char* value, std::size_t size);
+  ///   bool onObjectBegin();
+  ///   bool onObjectEnd();
+  ///   bool onArrayBegin();
+  ///   bool onArrayEnd();
+  ///
+  /// Strings and keys are only valid during the call.  Those without
+  /// escape sequences point into the document.  The rest are decoded,
+  /// either in place by parseInSitu or into a buffer owned by the parser
+  /// that is reused across strings and documents.
+  ///
+  /// Raw control characters inside strings are accepted as the legacy
+  /// reader did, unless strict mode is turned on.
+{
+public:
+  enum Error
+  {
+    ERROR_NONE,
+    ERROR_UNEXPECTED_END,
+    ERROR_UNEXPECTED_CHARACTER,
+    ERROR_INVALID_NUMBER,
+    ERROR_INVALID_STRING,
+    ERROR_INVALID_ESCAPE,
+    ERROR_TOO_DEEP,
+    ERROR_TRAILING_DATA,
+    ERROR_HANDLER
+  };
+
+  enum
+  {
+    DEFAULT_MAX_DEPTH = 256
+  };
+
+  JsonParser(std::size_t maxDepth = DEFAULT_MAX_DEPTH);
+
+  template <typename Handler>
+  bool parse(const char* data, std::size_t size, Handler& handler);
+    /// Parses a single JSON value surrounded by optional white space.
+
+  template <typename Handler>
+  bool parse(const std::string& data, Handler& handler);
+
+  template <typename Handler>
+  bool parseInSitu(char* data, std::size_t size, Handler& handler);
+    /// Same as parse but escaped strings are decoded over the document
+    /// itself.  The content of data is undefined afterwards.
+
+  void setStrict(bool strict);
+    /// Reject strings holding unescaped control characters as RFC 8259
+    /// requires.  Off by default.
+
+  bool isStrict() const;
+
+  Error getError() const;
+    /// Returns the reason the last parse failed
+
+  std::size_t getErrorOffset() const;
+    /// Returns the offset in the document where the last parse failed
+
+  const char* getErrorMessage() const;
+    /// Returns a description of getError()
+
+private:
+  enum State
+  {
+    STATE_VALUE,
+    STATE_AFTER_VALUE,
+    STATE_KEY
+  };
+
+  template <typename Handler>
+  bool parse_i(const char* data, std::size_t size, bool inSitu, Handler& handler);
+
+  bool scanString(const char*& p, const char* end, bool inSitu, const char*& value, std::size_t& size);
+  bool scanNumber(const char*& p, const char* end, double& value);
+  bool fail(Error error, const char* p);
+  static void skipWhiteSpace(const char*& p, const char* end);
+  static bool matchLiteral(const char*& p, const char* end, const char* literal, std::size_t size);
+  static std::size_t encodeUtf8(unsigned long codePoint, char* out);
+  static bool decodeHex(const char* p, unsigned long& value);
+
+  std::size_t _maxDepth;
+  bool _strict;
+  std::vector<char> _stack;
+  std::string _buffer;
+  const char* _begin;
+  Error _error;
+  std::size_t _errorOffset;
+};
+
+//
+// Inlines
+//
+
+inline JsonParser::JsonParser(std::size_t maxDepth) :
+  _maxDepth(maxDepth),
+  _strict(false),
+  _begin(0),
+  _error(ERROR_NONE),
+  _errorOffset(0)
+{
+}
+
+inline void JsonParser::setStrict(bool strict)
+{
+  _strict = strict;
+}
+
+inline bool JsonParser::isStrict() const
+{
+  return _strict;
+}
+
+inline JsonParser::Error JsonParser::getError() const
+{
+  return _error;
+}
+
+inline std::size_t JsonParser::getErrorOffset() const
+{
+  return _errorOffset;
+}
+
+inline const char* JsonParser::getErrorMessage() const
+{
+  switch (_error)
+  {
+    case ERROR_NONE: return "No error";
+    case ERROR_UNEXPECTED_END: return "Unexpected end of document";
+    case ERROR_UNEXPECTED_CHARACTER: return "Unexpected character";
+    case ERROR_INVALID_NUMBER: return "Invalid number";
+    case ERROR_INVALID_STRING: return "Invalid string";
+    case ERROR_INVALID_ESCAPE: return "Invalid escape sequence";
+    case ERROR_TOO_DEEP: return "Document nested too deep";
+    case ERROR_TRAILING_DATA: return "Unexpected data after the document";
+    case ERROR_HANDLER: return "Parse aborted by handler";
+  }
+  return "Unknown error";
+}
+
+inline bool JsonParser::fail(Error error, const char* p)
+{
+  _error = error;
+  _errorOffset = p - _begin;
+  return false;
+}
+
+inline void JsonParser::skipWhiteSpace(const char*& p, const char* end)
+{
+  while (p < end && (*p == ' ' || *p == '\n' || *p == '\r' || *p == '\t'))
+  {
+    ++p;
+  }
+}
+
+inline bool JsonParser::matchLiteral(const char*& p, const char* end, const char* literal, std::size_t size)
+{
+  if ((std::size_t)(end - p) < size || memcmp(p, literal, size) != 0)
+  {
+    return false;
+  }
+  p += size;
+  return true;
+}
+
+inline bool JsonParser::decodeHex(const char* p, unsigned long& value)
+{
+  value = 0;
+  for (int i = 0; i < 4; i++)
+  {
+    char c = p[i];
+    value <<= 4;
+    if (c >= '0' && c <= '9')
+      value |= c - '0';
+    else if (c >= 'a' && c <= 'f')
+      value |= c - 'a' + 10;
+    else if (c >= 'A' && c <= 'F')
+      value |= c - 'A' + 10;
+    else
+      return false;
+  }
+  return true;
+}
+
+inline std::size_t JsonParser::encodeUtf8(unsigned long codePoint, char* out)
+{
+  if (codePoint < 0x80)
+  {
+    out[0] = (char)codePoint;
+    return 1;
+  }
+  else if (codePoint < 0x800)
+  {
+    out[0] = (char)(0xC0 | (codePoint >> 6));
+    out[1] = (char)(0x80 | (codePoint & 0x3F));
+    return 2;
+  }
+  else if (codePoint < 0x10000)
+  {
+    out[0] = (char)(0xE0 | (codePoint >> 12));
+    out[1] = (char)(0x80 | ((codePoint >> 6) & 0x3F));
+    out[2] = (char)(0x80 | (codePoint & 0x3F));
+    return 3;
+  }
+  out[0] = (char)(0xF0 | (codePoint >> 18));
+  out[1] = (char)(0x80 | ((codePoint >> 12) & 0x3F));
+  out[2] = (char)(0x80 | ((codePoint >> 6) & 0x3F));
+  out[3] = (char)(0x80 | (codePoint & 0x3F));
+  return 4;
+}
+
+inline bool JsonParser::scanString(const char*& p, const char* end, bool inSitu, const char*& value, std::size_t& size)
+{
+  //
+  // p is past the opening quote.  Most strings have no escapes and are
+  // returned as they are in the document.
+  //
+  const unsigned char minChar = _strict ? 0x20 : 0;
+  const char* start = p;
+  while (p < end && *p != '"' && *p != '\\' && (unsigned char)*p >= minChar)
+  {
+    ++p;
+  }
+  if (p == end)
+  {
+    return fail(ERROR_UNEXPECTED_END, p);
+  }
+  if (*p == '"')
+  {
+    value = start;
+    size = p - start;
+    ++p;
+    return true;
+  }
+  if (*p != '\\')
+  {
+    return fail(ERROR_INVALID_STRING, p);
+  }
+
+  //
+  // Decoded text is never longer than its escaped form so it can be
+  // written over the document when parsing in place
+  //
+  char* out = const_cast<char*>(p);
+  if (!inSitu)
+  {
+    _buffer.assign(start, p - start);
+  }
+
+  while (p < end)
+  {
+    const char* run = p;
+    while (p < end && *p != '"' && *p != '\\' && (unsigned char)*p >= minChar)
+    {
+      ++p;
+    }
+    if (p > run)
+    {
+      if (inSitu)
+      {
+        memmove(out, run, p - run);
+        out += p - run;
+      }
+      else
+      {
+        _buffer.append(run, p - run);
+      }
+    }
+    if (p == end)
+    {
+      break;
+    }
+    if (*p == '"')
+    {
+      if (inSitu)
+      {
+        value = start;
+        size = out - start;
+      }
+      else
+      {
+        value = _buffer.data();
+        size = _buffer.size();
+      }
+      ++p;
+      return true;
+    }
+    if (*p != '\\')
+    {
+      return fail(ERROR_INVALID_STRING, p);
+    }
+    if (end - p < 2)
+    {
+      return fail(ERROR_UNEXPECTED_END, end);
+    }
+
+    char decoded[4];
+    std::size_t decodedSize = 1;
+    switch (p[1])
+    {
+      case '"': decoded[0] = '"'; break;
+      case '\\': decoded[0] = '\\'; break;
+      case '/': decoded[0] = '/'; break;
+      case 'b': decoded[0] = '\b'; break;
+      case 'f': decoded[0] = '\f'; break;
+      case 'n': decoded[0] = '\n'; break;
+      case 'r': decoded[0] = '\r'; break;
+      case 't': decoded[0] = '\t'; break;
+      case 'u':
+      {
+        unsigned long codePoint;
+        if (end - p < 6 || !decodeHex(p + 2, codePoint))
+        {
+          return fail(ERROR_INVALID_ESCAPE, p);
+        }
+        if (codePoint >= 0xDC00 && codePoint <= 0xDFFF)
+        {
+          return fail(ERROR_INVALID_ESCAPE, p);
+        }
+        if (codePoint >= 0xD800 && codePoint <= 0xDBFF)
+        {
+          unsigned long low;
+          if (end - p < 12 || p[6] != '\\' || p[7] != 'u' || !decodeHex(p + 8, low) || low < 0xDC00 || low > 0xDFFF)
+          {
+            return fail(ERROR_INVALID_ESCAPE, p);
+          }
+          codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+          p += 6;
+        }
+        decodedSize = encodeUtf8(codePoint, decoded);
+        p += 4;
+        break;
+      }
+      default:
+        return fail(ERROR_INVALID_ESCAPE, p);
+    }
+    p += 2;
+
+    if (inSitu)
+    {
+      memcpy(out, decoded, decodedSize);
+      out += decodedSize;
+    }
+    else
+    {
+      _buffer.append(decoded, decodedSize);
+    }
+  }
+  return fail(ERROR_UNEXPECTED_END, p);
+}
+
+inline bool JsonParser::scanNumber(const char*& p, const char* end, double& value)
+{
+  static const double powers[] =
+  {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+  };
+
+  const char* start = p;
+  bool negative = false;
+  if (*p == '-')
+  {
+    negative = true;
+    ++p;
+  }
+  if (p == end || *p < '0' || *p > '9')
+  {
+    return fail(ERROR_INVALID_NUMBER, start);
+  }
+
+  OSS::UInt64 mantissa = 0;
+  int digits = 0;
+  int exponent = 0;
+  if (*p == '0')
+  {
+    ++p;
+  }
+  else
+  {
+    while (p < end && *p >= '0' && *p <= '9')
+    {
+      if (digits < 19)
+        mantissa = mantissa * 10 + (*p - '0');
+      else
+        exponent++;
+      if (mantissa)
+        digits++;
+      ++p;
+    }
+  }
+
+  if (p < end && *p == '.')
+  {
+    ++p;
+    if (p == end || *p < '0' || *p > '9')
+    {
+      return fail(ERROR_INVALID_NUMBER, start);
+    }
+    while (p < end && *p >= '0' && *p <= '9')
+    {
+      if (digits < 19)
+      {
+        mantissa = mantissa * 10 + (*p - '0');
+        exponent--;
+        if (mantissa)
+          digits++;
+      }
+      ++p;
+    }
+  }
+
+  if (p < end && (*p == 'e' || *p == 'E'))
+  {
+    ++p;
+    bool negativeExponent = false;
+    if (p < end && (*p == '+' || *p == '-'))
+    {
+      negativeExponent = *p == '-';
+      ++p;
+    }
+    if (p == end || *p < '0' || *p > '9')
+    {
+      return fail(ERROR_INVALID_NUMBER, start);
+    }
+    int explicitExponent = 0;
+    while (p < end && *p >= '0' && *p <= '9')
+    {
+      if (explicitExponent < 100000)
+        explicitExponent = explicitExponent * 10 + (*p - '0');
+      ++p;
+    }
+    exponent += negativeExponent ? -explicitExponent : explicitExponent;
+  }
+
+  //
+  // Up to 15 significant digits scaled by an exact power of ten round
+  // correctly with a single multiplication or division.  Anything else
+  // goes through strtod.
+  //
+  if (digits <= 15 && exponent >= -22 && exponent <= 22)
+  {
+    value = (double)mantissa;
+    if (exponent < 0)
+      value /= powers[-exponent];
+    else
+      value *= powers[exponent];
+    if (negative)
+      value = -value;
+    return true;
+  }
+
+  std::string text(start, p - start);
+  value = strtod(text.c_str(), 0);
+  return true;
+}
+
+template <typename Handler>
+bool JsonParser::parse(const char* data, std::size_t size, Handler& handler)
+{
+  return parse_i(data, size, false, handler);
+}
+
+template <typename Handler>
+bool JsonParser::parse(const std::string& data, Handler& handler)
+{
+  return parse_i(data.data(), data.size(), false, handler);
+}
+
+template <typename Handler>
+bool JsonParser::parseInSitu(char* data, std::size_t size, Handler& handler)
+{
+  return parse_i(data, size, true, handler);
+}
+
+template <typename Handler>
+bool JsonParser::parse_i(const char* data, std::size_t size, bool inSitu, Handler& handler)
+{
+  const char* p = data;
+  const char* end = data + size;
+  _begin = data;
+  _error = ERROR_NONE;
+  _errorOffset = 0;
+  _stack.clear();
+
+  State state = STATE_VALUE;
+  for (;;)
+  {
+    skipWhiteSpace(p, end);
+    if (state == STATE_VALUE)
+    {
+      if (p == end)
+      {
+        return fail(ERROR_UNEXPECTED_END, p);
+      }
+      switch (*p)
+      {
+        case '{':
+          if (_stack.size() >= _maxDepth)
+            return fail(ERROR_TOO_DEEP, p);
+          if (!handler.onObjectBegin())
+            return fail(ERROR_HANDLER, p);
+          ++p;
+          skipWhiteSpace(p, end);
+          if (p < end && *p == '}')
+          {
+            if (!handler.onObjectEnd())
+              return fail(ERROR_HANDLER, p);
+            ++p;
+            state = STATE_AFTER_VALUE;
+          }
+          else
+          {
+            _stack.push_back('{');
+            state = STATE_KEY;
+          }
+          continue;
+        case '[':
+          if (_stack.size() >= _maxDepth)
+            return fail(ERROR_TOO_DEEP, p);
+          if (!handler.onArrayBegin())
+            return fail(ERROR_HANDLER, p);
+          ++p;
+          skipWhiteSpace(p, end);
+          if (p < end && *p == ']')
+          {
+            if (!handler.onArrayEnd())
+              return fail(ERROR_HANDLER, p);
+            ++p;
+            state = STATE_AFTER_VALUE;
+          }
+          else
+          {
+            _stack.push_back('[');
+          }
+          continue;
+        case '"':
+        {
+          const char* value = 0;
+          std::size_t valueSize = 0;
+          const char* position = p++;
+          if (!scanString(p, end, inSitu, value, valueSize))
+            return false;
+          if (!handler.onString(value, valueSize))
+            return fail(ERROR_HANDLER, position);
+          break;
+        }
+        case 't':
+          if (!matchLiteral(p, end, "true", 4))
+            return fail(ERROR_UNEXPECTED_CHARACTER, p);
+          if (!handler.onBoolean(true))
+            return fail(ERROR_HANDLER, p);
+          break;
+        case 'f':
+          if (!matchLiteral(p, end, "false", 5))
+            return fail(ERROR_UNEXPECTED_CHARACTER, p);
+          if (!handler.onBoolean(false))
+            return fail(ERROR_HANDLER, p);
+          break;
+        case 'n':
+          if (!matchLiteral(p, end, "null", 4))
+            return fail(ERROR_UNEXPECTED_CHARACTER, p);
+          if (!handler.onNull())
+            return fail(ERROR_HANDLER, p);
+          break;
+        default:
+        {
+          double value = 0;
+          const char* position = p;
+          if (*p != '-' && (*p < '0' || *p > '9'))
+            return fail(ERROR_UNEXPECTED_CHARACTER, p);
+          if (!scanNumber(p, end, value))
+            return false;
+          if (!handler.onNumber(value))
+            return fail(ERROR_HANDLER, position);
+          break;
+        }
+      }
+      state = STATE_AFTER_VALUE;
+    }
+    else if (state == STATE_AFTER_VALUE)
+    {
+      if (_stack.empty())
+      {
+        if (p != end)
+          return fail(ERROR_TRAILING_DATA, p);
+        return true;
+      }
+      if (p == end)
+      {
+        return fail(ERROR_UNEXPECTED_END, p);
+      }
+      char container = _stack.back();
+      if (*p == ',')
+      {
+        ++p;
+        state = container == '{' ? STATE_KEY : STATE_VALUE;
+      }
+      else if (container == '{' && *p == '}')
+      {
+        if (!handler.onObjectEnd())
+          return fail(ERROR_HANDLER, p);
+        ++p;
+        _stack.pop_back();
+      }
+      else if (container == '[' && *p == ']')
+      {
+        if (!handler.onArrayEnd())
+          return fail(ERROR_HANDLER, p);
+        ++p;
+        _stack.pop_back();
+      }
+      else
+      {
+        return fail(ERROR_UNEXPECTED_CHARACTER, p);
+      }
+    }
+    else
+    {
+      if (p == end)
+      {
+        return fail(ERROR_UNEXPECTED_END, p);
+      }
+      if (*p != '"')
+      {
+        return fail(ERROR_UNEXPECTED_CHARACTER, p);
+      }
+      const char* key = 0;
+      std::size_t keySize = 0;
+      const char* position = p++;
+      if (!scanString(p, end, inSitu, key, keySize))
+        return false;
+      if (!handler.onKey(key, keySize))
+        return fail(ERROR_HANDLER, position);
+      skipWhiteSpace(p, end);
+      if (p == end)
+        return fail(ERROR_UNEXPECTED_END, p);
+      if (*p != ':')
+        return fail(ERROR_UNEXPECTED_CHARACTER, p);
+      ++p;
+      state = STATE_VALUE;
+    }
+  }
+}
+
+
+} } // OSS::JSON
+
+#endif // OSS_JSONPARSER_H_INCLUDED
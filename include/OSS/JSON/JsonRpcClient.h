@@ -250,9 +250,11 @@ public:
         json::Object* pResponse = new json::Object();
         try
         {
-          std::stringstream strm;
-          strm << event.data;
-          json::Reader::Read(*pResponse, strm);
+          OSS::JSON::Exception e;
+          if (!OSS::JSON::json_parse(event.data.data(), event.data.size(), *pResponse, e))
+          {
+            throw e;
+          }
           json::Object::const_iterator iter = pResponse->Find("id");
           if (iter != pResponse->End())
           {
@@ -260,7 +262,7 @@ public:
             JsonRpcTransaction::Ptr pTransaction = findTransaction(id.Value());
             if (pTransaction)
             {
-              pTransaction->queueResponse(pResponse, strm.str());
+              pTransaction->queueResponse(pResponse, event.data);
             }
             else
             {
@@ -303,14 +305,9 @@ public:
 
     try
     {
-      std::ostringstream requestStrm;
-      json::Object request;
-      request["jsonrpc"] = json::String("2.0");
-      request["method"] = json::String(method);
-      request["id"] = json::Number(pTransaction->id());
-      request["params"] = params;
-      json::Writer::Write(request, requestStrm);
-      if (!_connection.send(requestStrm.str()))
+      std::string request;
+      writeRequest(request, method, params, pTransaction->id());
+      if (!_connection.send(request))
       {
         OSS_LOG_DEBUG("Unable to send JSON-RPC request " << method);
         destroyTransaction(pTransaction->id());
@@ -353,13 +350,9 @@ public:
     
     try
     {
-      std::ostringstream requestStrm;
-      json::Object request;
-      request["jsonrpc"] = json::String("2.0");
-      request["method"] = json::String(method);
-      request["params"] = params;
-      json::Writer::Write(request, requestStrm);
-      _connection.send(requestStrm.str());
+      std::string request;
+      writeRequest(request, method, params, -1);
+      _connection.send(request);
     }
     catch(json::Exception& e)
     {
@@ -387,19 +380,36 @@ public:
   }
   
 protected:
+  static void writeRequest(std::string& request, const std::string& method, const json::Object& params, int id)
+  {
+    //
+    // The envelope is written around params instead of copying them into
+    // a request object.  A negative id makes it a notification.
+    //
+    OSS::JSON::JsonWriter writer(request);
+    writer.beginObject();
+    writer.key("jsonrpc");
+    writer.string("2.0", 3);
+    writer.key("method");
+    writer.string(method);
+    if (id >= 0)
+    {
+      writer.key("id");
+      writer.integer(id);
+    }
+    writer.key("params");
+    writer.write(params);
+    writer.endObject();
+  }
+
   bool callSendAndReceive(const std::string& method, const json::Object& params, json::Object& response, long timeout)
   {
     try
     {
-      std::ostringstream requestStrm;
-      json::Object request;
-      request["jsonrpc"] = json::String("2.0");
-      request["method"] = json::String(method);
-      request["id"] = json::Number(generateId());
-      request["params"] = params;
-      json::Writer::Write(request, requestStrm);
+      std::string request;
+      writeRequest(request, method, params, generateId());
       std::string result;
-      if (!_connection.sendAndReceive(requestStrm.str(), result, timeout))
+      if (!_connection.sendAndReceive(request, result, timeout))
       {
         OSS_LOG_DEBUG("Unable to send JSON-RPC request " << method);
         return false;
@@ -0,0 +1,129 @@
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "GNU Lesser General Public License (LGPL)".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+#ifndef OSS_JSONWRITER_H_INCLUDED
+#define OSS_JSONWRITER_H_INCLUDED
+
+
+#include <string>
+#include <vector>
+#include "OSS/OSS.h"
+#include "OSS/JSON/elements.h"
+#include "OSS/JSON/visitor.h"
+
+
+namespace OSS {
+namespace JSON {
+
+
+class JsonWriter : private json::ConstVisitor
+  /// Writes compact JSON by appending to a caller owned string.  Keeping
+  /// the string around between documents reuses its capacity so steady
+  /// state serialization does not allocate.
+  ///
+  /// Commas and colons are inserted automatically.  Inside an object
+  /// every value must be preceded by key().
+{
+public:
+  JsonWriter(std::string& buffer);
+
+  void beginObject();
+  void endObject();
+  void beginArray();
+  void endArray();
+
+  void key(const char* value, std::size_t size);
+  void key(const std::string& value);
+  void key(const char* value);
+
+  void string(const char* value, std::size_t size);
+  void string(const std::string& value);
+  void string(const char* value);
+
+  void number(double value);
+    /// Integral values are written without a fraction.  NaN and infinity
+    /// have no JSON representation and are written as null.
+
+  void integer(OSS::Int64 value);
+  void boolean(bool value);
+  void null();
+
+  void write(const json::UnknownElement& element);
+  void write(const json::Object& object);
+  void write(const json::Array& array);
+    /// Serializes a DOM element
+
+  std::string& buffer();
+
+  static void escape(const char* value, std::size_t size, std::string& buffer);
+    /// Appends value to buffer as a quoted JSON string
+
+private:
+  void separate();
+
+  virtual void Visit(const json::Array& array);
+  virtual void Visit(const json::Object& object);
+  virtual void Visit(const json::Number& number);
+  virtual void Visit(const json::String& string);
+  virtual void Visit(const json::Boolean& boolean);
+  virtual void Visit(const json::Null& null);
+
+  std::string& _buffer;
+  std::vector<char> _first;
+  bool _afterKey;
+};
+
+//
+// Inlines
+//
+
+inline std::string& JsonWriter::buffer()
+{
+  return _buffer;
+}
+
+inline void JsonWriter::separate()
+{
+  if (_afterKey)
+  {
+    _afterKey = false;
+  }
+  else if (!_first.empty())
+  {
+    if (_first.back())
+      _first.back() = 0;
+    else
+      _buffer.push_back(',');
+  }
+}
+
+inline void JsonWriter::key(const std::string& value)
+{
+  key(value.data(), value.size());
+}
+
+inline void JsonWriter::string(const std::string& value)
+{
+  string(value.data(), value.size());
+}
+
+
+} } // OSS::JSON
+
+#endif // OSS_JSONWRITER_H_INCLUDED
@@ -23,8 +23,11 @@
 
 #include "OSS/OSS.h"
 #include "OSS/UTL/Thread.h"
+#include "OSS/LMDB/liblmdb.h"
 #include <boost/noncopyable.hpp>
 #include <string>
+#include <vector>
+#include <utility>
 #include <ostream>
 
 
@@ -94,6 +97,8 @@ public:
     
     bool top();
     bool find(const std::string& key);
+    bool seek(const std::string& key);
+      /// Positions the cursor at the first key greater than or equal to key
     bool next();
     bool bottom();
     std::string value() const;
@@ -143,6 +148,13 @@ public:
 
   bool createCursor(Transaction& transaction, Cursor& cursor);
   
+  bool getKeys(Transaction& transaction, const std::string& prefix, std::vector<std::string>& keys);
+    /// Returns every key that starts with prefix.  Only the matching range
+    /// of the B-tree is visited.
+  
+  bool getRecords(Transaction& transaction, const std::string& prefix, std::vector<std::pair<std::string, std::string> >& records);
+    /// Returns the key and value of every record whose key starts with prefix
+  
 protected:
   friend class Transaction;
   friend class TransactionLock;
@@ -188,6 +200,62 @@ inline bool LMDatabase::set(Transaction& transaction, const std::string& key, in
   return set(transaction, key, (void*)&value, sizeof(int64_t));
 }
 
+inline bool LMDatabase::Cursor::seek(const std::string& key)
+{
+  _key.clear();
+  _value.clear();
+  if (!_cursor)
+  {
+    return false;
+  }
+  
+  MDB_val k;
+  MDB_val v;
+  k.mv_size = key.size();
+  k.mv_data = (void*)key.data();
+  if (mdb_cursor_get((MDB_cursor*)_cursor, &k, &v, MDB_SET_RANGE) != 0)
+  {
+    return false;
+  }
+  _key = std::string((const char*)k.mv_data, k.mv_size);
+  _value = std::string((const char*)v.mv_data, v.mv_size);
+  return true;
+}
+
+inline bool LMDatabase::getKeys(Transaction& transaction, const std::string& prefix, std::vector<std::string>& keys)
+{
+  Cursor cursor;
+  if (!createCursor(transaction, cursor))
+  {
+    return false;
+  }
+  
+  bool found = prefix.empty() ? cursor.top() : cursor.seek(prefix);
+  while (found && cursor.key().compare(0, prefix.size(), prefix) == 0)
+  {
+    keys.push_back(cursor.key());
+    found = cursor.next();
+  }
+  return !keys.empty();
+}
+
+inline bool LMDatabase::getRecords(Transaction& transaction, const std::string& prefix, std::vector<std::pair<std::string, std::string> >& records)
+{
+  Cursor cursor;
+  if (!createCursor(transaction, cursor))
+  {
+    return false;
+  }
+  
+  bool found = prefix.empty() ? cursor.top() : cursor.seek(prefix);
+  while (found && cursor.key().compare(0, prefix.size(), prefix) == 0)
+  {
+    records.push_back(std::make_pair(cursor.key(), cursor.value()));
+    found = cursor.next();
+  }
+  return !records.empty();
+}
+
 } } // OSS::LMDB
 
 
@@ -0,0 +1,127 @@
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare 
+// derivative works of the Software, all subject to the 
+// "GNU Lesser General Public License (LGPL)".
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+
+#ifndef OSS_INFLUXEXPORTER_H_INCLUDED
+#define	OSS_INFLUXEXPORTER_H_INCLUDED
+
+
+#include <map>
+#include <string>
+#include <boost/noncopyable.hpp>
+#include <boost/thread.hpp>
+#include <boost/asio.hpp>
+#include "OSS/Metrics/MetricsRegistry.h"
+
+
+namespace OSS {
+namespace Metrics {
+
+
+class InfluxExporter : boost::noncopyable
+  /// Periodically pushes a snapshot of a MetricsRegistry to InfluxDB using
+  /// the line protocol.
+  ///
+  /// Counters are written with their total and the per second rate since
+  /// the previous push.  Gauges are written as is.  Histograms are written
+  /// with their count, mean, percentiles and max.
+  ///
+  /// UDP pushes are split into datagrams of at most MAX_DATAGRAM_SIZE.  HTTP
+  /// pushes use the /write endpoint of the bundled influxdb_cpp client which
+  /// expects an IPv4 address as host.
+{
+public:
+  enum Transport
+  {
+    UDP,
+    HTTP
+  };
+
+  enum
+  {
+    DEFAULT_INTERVAL_MS = 10000,
+    MAX_DATAGRAM_SIZE = 1400
+  };
+
+  typedef std::map<std::string, std::string> Tags;
+
+  InfluxExporter(MetricsRegistry& registry = MetricsRegistry::instance());
+
+  ~InfluxExporter();
+
+  bool start(const std::string& host, int port, Transport transport = UDP, const std::string& database = "", unsigned int interval = DEFAULT_INTERVAL_MS);
+    /// Starts pushing every interval milliseconds.  The host tag is set to
+    /// the local host name unless it was set by setTag().
+
+  void stop();
+
+  bool isRunning() const;
+
+  void setTag(const std::string& key, const std::string& value);
+    /// Adds a tag to every line.  Must be called before start().
+
+  bool push();
+    /// Pushes a snapshot now.  Returns false if the write failed.
+
+  void formatLines(const MetricsRegistry::Samples& samples, OSS::UInt64 timestamp, std::string& lines);
+    /// Formats samples as line protocol.  timestamp is in nanoseconds.
+    /// Counter rates are computed against the previous call.
+
+  static void escape(const std::string& value, const char* special, std::string& out);
+
+private:
+  void run();
+  void updateTagString();
+  bool sendUdp(const std::string& lines);
+  bool sendHttp(const std::string& lines);
+
+  typedef std::map<std::string, std::pair<OSS::UInt64, OSS::UInt64> > CounterHistory;
+
+  MetricsRegistry& _registry;
+  std::string _host;
+  int _port;
+  Transport _transport;
+  std::string _database;
+  unsigned int _interval;
+  Tags _tags;
+  std::string _tagString;
+  CounterHistory _history;
+  boost::asio::io_service _ioService;
+  boost::asio::ip::udp::socket _socket;
+  boost::asio::ip::udp::endpoint _destination;
+  OSS::semaphore _wake;
+  bool _stopping;
+  boost::thread* _pThread;
+};
+
+
+//
+// Inlines
+//
+
+inline bool InfluxExporter::isRunning() const
+{
+  return _pThread != 0;
+}
+
+
+} } // OSS::Metrics
+
+
+#endif // OSS_INFLUXEXPORTER_H_INCLUDED
@@ -0,0 +1,355 @@
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare 
+// derivative works of the Software, all subject to the 
+// "GNU Lesser General Public License (LGPL)".
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+
+#ifndef OSS_METRICSREGISTRY_H_INCLUDED
+#define	OSS_METRICSREGISTRY_H_INCLUDED
+
+
+#include <map>
+#include <vector>
+#include <string>
+#include <boost/noncopyable.hpp>
+#include <boost/atomic.hpp>
+#include "OSS/OSS.h"
+#include "OSS/UTL/Thread.h"
+
+
+namespace OSS {
+namespace Metrics {
+
+
+enum
+{
+  METRIC_SHARDS = 8,
+    /// Number of per-thread slots of counters and histograms
+  METRIC_CACHE_LINE = 64
+};
+
+unsigned int nextThreadShard();
+  /// Assigns the shard of a thread that has not updated a metric yet
+
+inline unsigned int threadShard()
+  /// Returns the shard used by the calling thread.  Threads are spread
+  /// round robin so concurrent updates rarely touch the same cache line.
+{
+  static __thread int shard = -1;
+  if (shard < 0)
+    shard = nextThreadShard();
+  return shard;
+}
+
+
+class Counter : boost::noncopyable
+  /// Monotonic counter.  Each thread increments its own cache line and
+  /// value() sums the shards.
+{
+public:
+  explicit Counter(const std::string& name);
+
+  void increment();
+
+  void add(OSS::UInt64 count);
+
+  OSS::UInt64 value() const;
+
+  const std::string& name() const;
+
+private:
+  struct Shard
+  {
+    boost::atomic<OSS::UInt64> value;
+    char pad[METRIC_CACHE_LINE - sizeof(boost::atomic<OSS::UInt64>)];
+  };
+
+  std::string _name;
+  Shard _shards[METRIC_SHARDS];
+};
+
+
+class Gauge : boost::noncopyable
+  /// Value that goes up and down such as the number of live transactions
+{
+public:
+  explicit Gauge(const std::string& name);
+
+  void set(OSS::Int64 value);
+
+  void add(OSS::Int64 value);
+
+  void increment();
+
+  void decrement();
+
+  OSS::Int64 value() const;
+
+  const std::string& name() const;
+
+private:
+  std::string _name;
+  boost::atomic<OSS::Int64> _value;
+};
+
+
+class Histogram : boost::noncopyable
+  /// Log-linear latency histogram in the spirit of HdrHistogram.
+  ///
+  /// Values below SUB_BUCKET_COUNT are counted exactly.  Above that every
+  /// power of two is split in SUB_BUCKET_COUNT / 2 linear buckets which
+  /// bounds the error of a reported percentile to about 6%.  Values are
+  /// normally microseconds.  Anything above 2^40 lands in the last bucket.
+{
+public:
+  enum
+  {
+    SUB_BUCKET_BITS = 5,
+    SUB_BUCKET_COUNT = 1 << SUB_BUCKET_BITS,
+    SUB_BUCKET_HALF = SUB_BUCKET_COUNT / 2,
+    MAX_SHIFT = 36,
+    BUCKET_COUNT = SUB_BUCKET_COUNT + MAX_SHIFT * SUB_BUCKET_HALF
+  };
+
+  struct Snapshot
+  {
+    Snapshot();
+    OSS::UInt64 count;
+    OSS::UInt64 sum;
+    OSS::UInt64 max;
+    OSS::UInt64 p50;
+    OSS::UInt64 p90;
+    OSS::UInt64 p99;
+    OSS::UInt64 p999;
+    double mean() const;
+  };
+
+  explicit Histogram(const std::string& name);
+
+  ~Histogram();
+
+  void record(OSS::UInt64 value);
+
+  Snapshot snapshot() const;
+    /// Merges the shards and computes the percentiles
+
+  void reset();
+    /// Clears all samples.  Updates racing with reset() may survive it.
+
+  const std::string& name() const;
+
+  static std::size_t bucketIndex(OSS::UInt64 value);
+
+  static OSS::UInt64 bucketValue(std::size_t index);
+    /// Returns the highest value counted by the bucket
+
+  static OSS::UInt64 now();
+    /// Monotonic clock in microseconds
+
+private:
+  struct Shard
+  {
+    boost::atomic<OSS::UInt64> buckets[BUCKET_COUNT];
+    boost::atomic<OSS::UInt64> count;
+    boost::atomic<OSS::UInt64> sum;
+    boost::atomic<OSS::UInt64> max;
+    char pad[METRIC_CACHE_LINE];
+  };
+
+  std::string _name;
+  Shard* _shards;
+};
+
+
+class ScopedTimer : boost::noncopyable
+  /// Records the microseconds elapsed between construction and destruction
+{
+public:
+  explicit ScopedTimer(Histogram& histogram);
+
+  ~ScopedTimer();
+
+  OSS::UInt64 elapsed() const;
+
+private:
+  Histogram& _histogram;
+  OSS::UInt64 _start;
+};
+
+
+class MetricsRegistry : boost::noncopyable
+  /// Process wide registry of named metrics.
+  ///
+  /// Metrics are created on first use and live until the process exits so
+  /// call sites can keep a reference to them, typically in a function
+  /// static:
+  ///
+  ///   static OSS::Metrics::Histogram& dispatchTime =
+  ///     OSS::Metrics::MetricsRegistry::instance().histogram("sip.dispatch.us");
+  ///   OSS::Metrics::ScopedTimer timer(dispatchTime);
+  ///
+  /// Only creation takes the registry lock.  Updates are lock-free.
+{
+public:
+  enum Type
+  {
+    COUNTER,
+    GAUGE,
+    HISTOGRAM
+  };
+
+  struct Sample
+  {
+    Sample();
+    std::string name;
+    Type type;
+    OSS::Int64 value;
+      /// Counter or gauge value
+    Histogram::Snapshot histogram;
+  };
+
+  typedef std::vector<Sample> Samples;
+
+  static MetricsRegistry& instance();
+
+  MetricsRegistry();
+
+  ~MetricsRegistry();
+
+  Counter& counter(const std::string& name);
+
+  Gauge& gauge(const std::string& name);
+
+  Histogram& histogram(const std::string& name);
+
+  void snapshot(Samples& samples) const;
+    /// Returns the value of every metric sorted by type then name
+
+  std::string toString() const;
+    /// Returns a snapshot formatted as a table for the console
+
+private:
+  typedef std::map<std::string, Counter*> Counters;
+  typedef std::map<std::string, Gauge*> Gauges;
+  typedef std::map<std::string, Histogram*> Histograms;
+
+  mutable OSS::mutex _mutex;
+  Counters _counters;
+  Gauges _gauges;
+  Histograms _histograms;
+};
+
+
+//
+// Inlines
+//
+
+inline void Counter::increment()
+{
+  _shards[threadShard()].value.fetch_add(1, boost::memory_order_relaxed);
+}
+
+inline void Counter::add(OSS::UInt64 count)
+{
+  _shards[threadShard()].value.fetch_add(count, boost::memory_order_relaxed);
+}
+
+inline const std::string& Counter::name() const
+{
+  return _name;
+}
+
+inline void Gauge::set(OSS::Int64 value)
+{
+  _value.store(value, boost::memory_order_relaxed);
+}
+
+inline void Gauge::add(OSS::Int64 value)
+{
+  _value.fetch_add(value, boost::memory_order_relaxed);
+}
+
+inline void Gauge::increment()
+{
+  _value.fetch_add(1, boost::memory_order_relaxed);
+}
+
+inline void Gauge::decrement()
+{
+  _value.fetch_sub(1, boost::memory_order_relaxed);
+}
+
+inline OSS::Int64 Gauge::value() const
+{
+  return _value.load(boost::memory_order_relaxed);
+}
+
+inline const std::string& Gauge::name() const
+{
+  return _name;
+}
+
+inline std::size_t Histogram::bucketIndex(OSS::UInt64 value)
+{
+  if (value < SUB_BUCKET_COUNT)
+    return value;
+  std::size_t shift = (63 - __builtin_clzll(value)) - (SUB_BUCKET_BITS - 1);
+  if (shift > MAX_SHIFT)
+    return BUCKET_COUNT - 1;
+  return SUB_BUCKET_COUNT + (shift - 1) * SUB_BUCKET_HALF + ((value >> shift) - SUB_BUCKET_HALF);
+}
+
+inline void Histogram::record(OSS::UInt64 value)
+{
+  Shard& shard = _shards[threadShard()];
+  shard.buckets[bucketIndex(value)].fetch_add(1, boost::memory_order_relaxed);
+  shard.count.fetch_add(1, boost::memory_order_relaxed);
+  shard.sum.fetch_add(value, boost::memory_order_relaxed);
+  //
+  // Only the owning threads of a shard write its max.  A lost update
+  // between two threads sharing a shard only understates one sample.
+  //
+  if (value > shard.max.load(boost::memory_order_relaxed))
+    shard.max.store(value, boost::memory_order_relaxed);
+}
+
+inline const std::string& Histogram::name() const
+{
+  return _name;
+}
+
+inline ScopedTimer::ScopedTimer(Histogram& histogram) :
+  _histogram(histogram),
+  _start(Histogram::now())
+{
+}
+
+inline ScopedTimer::~ScopedTimer()
+{
+  _histogram.record(Histogram::now() - _start);
+}
+
+inline OSS::UInt64 ScopedTimer::elapsed() const
+{
+  return Histogram::now() - _start;
+}
+
+
+} } // OSS::Metrics
+
+
+#endif // OSS_METRICSREGISTRY_H_INCLUDED
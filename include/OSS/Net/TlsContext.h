@@ -25,6 +25,7 @@
 #include <boost/shared_ptr.hpp>
 
 #include "OSS/Net/Net.h"
+#include "OSS/Net/TlsSessionCache.h"
 #include "OSS/UTL/Logger.h"
 
 
@@ -67,13 +68,16 @@ public:
   const Context& getClientContext() const;
   std::string getTlsCertPassword() const;
   bool isInitialized() const;
+  TlsSessionCache& sessionCache();
+    /// Session resumption cache shared by every connection using
+    /// these contexts
 protected:
   boost::asio::io_service* _pIoService;
   Context _pClientContext;
   Context _pServerContext;
   std::string _certPassword;
   bool _isInitialized;
-  
+  TlsSessionCache _sessionCache; // Declared after the contexts so it is destroyed first
 };
 
 //
@@ -187,6 +191,13 @@ inline bool TlsContext::initialize(
     return false;
   }
 
+  //
+  // Resumption is an optimization.  TLS still works if it fails.
+  //
+  _sessionCache.enableServerCache(*_pServerContext);
+  _sessionCache.enableSessionTickets(*_pServerContext);
+  _sessionCache.enableClientCache(*_pClientContext);
+
   return (_isInitialized = true);
 }
 
@@ -210,6 +221,11 @@ inline bool TlsContext::isInitialized() const
   return _isInitialized;
 }
 
+inline TlsSessionCache& TlsContext::sessionCache()
+{
+  return _sessionCache;
+}
+
 
 } }
 
@@ -0,0 +1,112 @@
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare 
+// derivative works of the Software, all subject to the 
+// "GNU Lesser General Public License (LGPL)".
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+
+
+#ifndef OSS_TLSHANDSHAKEPOOL_H_INCLUDED
+#define OSS_TLSHANDSHAKEPOOL_H_INCLUDED
+
+#include <vector>
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/atomic.hpp>
+#include <boost/asio.hpp>
+#include <boost/thread.hpp>
+
+#include "OSS/OSS.h"
+#include "OSS/UTL/Thread.h"
+
+
+namespace OSS  {
+namespace Net {
+
+
+class TlsHandshakePool : boost::noncopyable
+  /// Pool of io_service threads that TLS connections are created on.
+  ///
+  /// TLS handshakes are CPU bound.  A burst of reconnecting trunks or
+  /// WebSocket clients doing full RSA or ECDHE handshakes on the transport
+  /// io_service delays every SIP message queued behind them.  Connections
+  /// created on an io_service returned by next() do their handshakes and
+  /// their reads and writes on a pool thread instead.
+  ///
+  /// Each thread runs its own io_service, so all the handlers of one
+  /// connection run on the same thread and need no strand.
+{
+public:
+  enum
+  {
+    DEFAULT_THREAD_COUNT = 2
+  };
+
+  TlsHandshakePool();
+
+  ~TlsHandshakePool();
+
+  bool start(std::size_t threadCount = DEFAULT_THREAD_COUNT);
+    /// Starts the pool threads.  Returns false if already running or if
+    /// threadCount is 0.
+
+  void stop();
+    /// Stops the io_services and joins the threads
+
+  bool isRunning() const;
+
+  std::size_t size() const;
+
+  boost::asio::io_service& next(boost::asio::io_service& fallback);
+    /// Returns the io_service of the next thread in round robin order or
+    /// fallback if the pool is not running
+
+private:
+  typedef boost::shared_ptr<boost::asio::io_service> IoServicePtr;
+  typedef boost::shared_ptr<boost::asio::io_service::work> WorkPtr;
+  typedef boost::shared_ptr<boost::thread> ThreadPtr;
+
+  void run(IoServicePtr pIoService);
+
+  mutable OSS::mutex_critic_sec _mutex;
+  std::vector<IoServicePtr> _ioServices;
+  std::vector<IoServicePtr> _retired;
+  std::vector<WorkPtr> _work;
+  std::vector<ThreadPtr> _threads;
+  boost::atomic<std::size_t> _roundRobin;
+  boost::atomic<bool> _isRunning;
+};
+
+//
+// Inlines
+//
+
+inline bool TlsHandshakePool::isRunning() const
+{
+  return _isRunning;
+}
+
+inline std::size_t TlsHandshakePool::size() const
+{
+  OSS::mutex_critic_sec_lock lock(_mutex);
+  return _ioServices.size();
+}
+
+
+} } // OSS::Net
+
+
+#endif // OSS_TLSHANDSHAKEPOOL_H_INCLUDED
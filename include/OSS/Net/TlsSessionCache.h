@@ -0,0 +1,187 @@
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare 
+// derivative works of the Software, all subject to the 
+// "GNU Lesser General Public License (LGPL)".
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+
+
+#ifndef OSS_TLSSESSIONCACHE_H_INCLUDED
+#define OSS_TLSSESSIONCACHE_H_INCLUDED
+
+#include <map>
+#include <string>
+#include <boost/noncopyable.hpp>
+#include <boost/atomic.hpp>
+#include <boost/asio/ssl.hpp>
+#include <openssl/hmac.h>
+
+#include "OSS/OSS.h"
+#include "OSS/UTL/Thread.h"
+
+
+namespace OSS  {
+namespace Net {
+
+
+class TlsSessionCache : boost::noncopyable
+  /// TLS session resumption for the SIP TLS and WSS transports.
+  ///
+  /// On the server side, the OpenSSL session cache of the server context is
+  /// enabled and stateless session tickets (RFC 5077) are issued using keys
+  /// owned by this object.  The ticket keys are rotated every keyLifetime
+  /// seconds.  The previous key is kept so tickets issued before a rotation
+  /// are still accepted, and are renewed using the new key.  All listeners
+  /// sharing the server context share the cache and the ticket keys.
+  ///
+  /// On the client side, the last session negotiated with each peer is kept
+  /// and offered again on the next connection to the same peer, so a trunk
+  /// reconnecting after a network blip does an abbreviated handshake.
+  ///
+  /// Every handshake is counted.  getStats() returns the number of full and
+  /// resumed handshakes and the handshake rate over the last second.
+{
+public:
+  enum
+  {
+    DEFAULT_CACHE_SIZE = 20480,
+    DEFAULT_SESSION_TIMEOUT = 3600,
+    DEFAULT_TICKET_KEY_LIFETIME = 43200,
+    DEFAULT_CLIENT_CACHE_SIZE = 1024
+  };
+
+  struct Stats
+  {
+    Stats();
+    OSS::UInt64 serverHandshakes;
+      /// Number of completed server handshakes including resumed ones
+    OSS::UInt64 serverResumed;
+      /// Number of server handshakes that resumed a session
+    OSS::UInt64 clientHandshakes;
+    OSS::UInt64 clientResumed;
+    OSS::UInt64 failedHandshakes;
+    OSS::UInt64 ticketKeyRotations;
+    OSS::UInt64 handshakesPerSecond;
+      /// Handshakes completed during the last full second
+    std::size_t serverCacheSize;
+      /// Number of sessions in the server session cache
+    std::size_t clientCacheSize;
+      /// Number of peers with a session to resume
+  };
+
+  TlsSessionCache();
+
+  ~TlsSessionCache();
+
+  bool enableServerCache(boost::asio::ssl::context& context,
+    const std::string& sessionIdContext = "oss_core",
+    long cacheSize = DEFAULT_CACHE_SIZE,
+    long timeout = DEFAULT_SESSION_TIMEOUT);
+    /// Enables the session cache of a server context.  The session id
+    /// context is required by OpenSSL to resume sessions when client
+    /// certificates are verified.
+
+  bool enableSessionTickets(boost::asio::ssl::context& context, unsigned int keyLifetime = DEFAULT_TICKET_KEY_LIFETIME);
+    /// Issues session tickets encrypted with keys owned by this cache
+
+  bool enableClientCache(boost::asio::ssl::context& context, std::size_t maxPeers = DEFAULT_CLIENT_CACHE_SIZE);
+    /// Keeps the sessions negotiated by a client context for resumption
+
+  void rotateTicketKeys();
+    /// Creates a new ticket key.  The current key becomes the previous key.
+
+  void prepareClientSession(SSL* ssl, const std::string& peer);
+    /// Called before a client handshake.  Offers the session last
+    /// negotiated with peer if there is one.
+
+  void removeClientSession(const std::string& peer);
+    /// Forgets the session of a peer.  Called when a handshake fails so
+    /// a stale session is not offered again.
+
+  void onHandshake(SSL* ssl, bool isServer, bool success);
+    /// Records the outcome of a handshake
+
+  void onDisconnect(SSL* ssl);
+    /// Called before the SSL object of a connection is freed.  SIP peers
+    /// rarely send close_notify and OpenSSL drops the session of a
+    /// connection freed without one.  This keeps it resumable.
+
+  Stats getStats() const;
+
+private:
+  struct TicketKey
+  {
+    unsigned char name[16];
+    unsigned char aesKey[32];
+    unsigned char hmacKey[32];
+    OSS::UInt64 created;
+  };
+
+  struct ClientSession
+  {
+    SSL_SESSION* session;
+    OSS::UInt64 lastUsed;
+  };
+
+  typedef std::map<std::string, ClientSession> ClientSessions;
+
+  static TlsSessionCache* fromContext(SSL_CTX* ctx);
+  static int onNewClientSession(SSL* ssl, SSL_SESSION* session);
+  static bool createTicketKey(TicketKey& key);
+  bool getTicketKey(const unsigned char* name, TicketKey& key, bool& isCurrent);
+  bool getCurrentTicketKey(TicketKey& key);
+  void storeClientSession(const std::string& peer, SSL_SESSION* session);
+  void countHandshake();
+
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+  static int onTicketKey(SSL* ssl, unsigned char* name, unsigned char* iv, EVP_CIPHER_CTX* cipherCtx, EVP_MAC_CTX* macCtx, int enc);
+#else
+  static int onTicketKey(SSL* ssl, unsigned char* name, unsigned char* iv, EVP_CIPHER_CTX* cipherCtx, HMAC_CTX* hmacCtx, int enc);
+#endif
+
+  mutable OSS::mutex_read_write _ticketMutex;
+  TicketKey _currentKey;
+  TicketKey _previousKey;
+  bool _hasTicketKeys;
+  bool _hasPreviousKey;
+  unsigned int _keyLifetime;
+
+  mutable OSS::mutex_critic_sec _clientMutex;
+  ClientSessions _clientSessions;
+  std::size_t _maxPeers;
+
+  SSL_CTX* _pServerContext;
+  SSL_CTX* _pClientContext;
+
+  boost::atomic<OSS::UInt64> _serverHandshakes;
+  boost::atomic<OSS::UInt64> _serverResumed;
+  boost::atomic<OSS::UInt64> _clientHandshakes;
+  boost::atomic<OSS::UInt64> _clientResumed;
+  boost::atomic<OSS::UInt64> _failedHandshakes;
+  boost::atomic<OSS::UInt64> _ticketKeyRotations;
+
+  mutable OSS::mutex_critic_sec _rateMutex;
+  OSS::UInt64 _rateWindowStart;
+  OSS::UInt64 _rateWindowCount;
+  OSS::UInt64 _lastRate;
+};
+
+
+} } // OSS::Net
+
+
+#endif // OSS_TLSSESSIONCACHE_H_INCLUDED
+
@@ -24,6 +24,8 @@
 #include <db_cxx.h>
 #include <string>
 #include <sstream>
+#include <vector>
+#include <utility>
 
 #include "OSS/UTL/CoreUtils.h"
 
@@ -107,7 +109,7 @@ public:
     return _isOpen;
   }
 
-  bool set(const std::string& key_, const std::string& value)
+  bool set(const std::string& key_, const std::string& value, bool flush = true)
   {
     if (!_pDb)
       return false;
@@ -118,10 +120,21 @@ public:
     ret = _pDb->put(0, &key, &data, 0);
     if ( ret != 0 )
       return false;
-    _pDb->sync(0);
+    if (flush)
+      _pDb->sync(0);
     return true;
   }
 
+  bool sync()
+  {
+    //
+    // Used after a series of set() and erase() calls with flush disabled
+    //
+    if (!_pDb)
+      return false;
+    return _pDb->sync(0) == 0;
+  }
+
   bool get(const std::string& key_, std::string& value) const
   {
     if (!_pDb)
@@ -160,14 +173,15 @@ public:
     return true;
   }
 
-  bool erase(const std::string& key_)
+  bool erase(const std::string& key_, bool flush = true)
   {
     if (!_pDb)
       return false;
 
     Dbt key( (void*) key_.data(), (::u_int32_t)key_.size() );
     _pDb->del(0, &key, 0);
-    _pDb->sync(0);
+    if (flush)
+      _pDb->sync(0);
     return true;
   }
 
@@ -202,16 +216,123 @@ bool getKeys(std::vector<std::string>& keys) const
   return !keys.empty();
 }
 
+typedef std::pair<std::string, std::string> Record;
+typedef std::vector<Record> Records;
+
+//
+// Returns the smallest key that is greater than every key starting with
+// prefix or an empty string if there is no such key
+//
+static std::string prefixUpperBound(const std::string& prefix)
+{
+  std::string bound = prefix;
+  while (!bound.empty() && (unsigned char)bound[bound.size() - 1] == 0xFF)
+    bound.erase(bound.size() - 1);
+  if (!bound.empty())
+    bound[bound.size() - 1] = (char)((unsigned char)bound[bound.size() - 1] + 1);
+  return bound;
+}
+
+//
+// Reads the records with start <= key < end in key order using a
+// DB_SET_RANGE cursor.  An empty end means no upper bound.  If includeStart
+// is false a record whose key equals start is skipped, which lets callers
+// resume an iteration after the last key they have seen.  At most limit
+// records are read if limit is not zero.  If keysOnly is true the values
+// are not copied out of the database.
+//
+bool getRange(const std::string& start, bool includeStart, const std::string& end, std::size_t limit, Records& records, bool keysOnly = false) const
+{
+  if (!_pDb)
+    return false;
+
+  Dbc* pCursor = 0;
+  if (_pDb->cursor(0, &pCursor, 0) != 0 || !pCursor)
+    return false;
+
+  Dbt key, data;
+  if (keysOnly)
+  {
+    data.set_flags(DB_DBT_PARTIAL);
+    data.set_dlen(0);
+    data.set_doff(0);
+  }
+
+  int ret;
+  if (start.empty())
+  {
+    ret = pCursor->get(&key, &data, DB_FIRST);
+  }
+  else
+  {
+    key.set_data((void*)start.data());
+    key.set_size((::u_int32_t)start.size());
+    ret = pCursor->get(&key, &data, DB_SET_RANGE);
+  }
+
+  std::size_t count = 0;
+  while (ret == 0 && (!limit || count < limit))
+  {
+    const char* keyData = reinterpret_cast<const char*>(key.get_data());
+    std::size_t keySize = key.get_size();
+    if (!end.empty() && end.compare(0, std::string::npos, keyData, keySize) <= 0)
+      break;
+
+    if (includeStart || start.compare(0, std::string::npos, keyData, keySize) != 0)
+    {
+      records.push_back(Record(std::string(keyData, keySize), keysOnly ? std::string() :
+        std::string(reinterpret_cast<const char*>(data.get_data()), data.get_size())));
+      count++;
+    }
+    ret = pCursor->get(&key, &data, DB_NEXT);
+  }
+
+  pCursor->close();
+  return count > 0;
+}
+
+bool getKeysWithPrefix(const std::string& prefix, std::vector<std::string>& keys) const
+{
+  Records records;
+  if (!getRange(prefix, true, prefixUpperBound(prefix), 0, records, true))
+    return false;
+  keys.reserve(keys.size() + records.size());
+  for (Records::const_iterator iter = records.begin(); iter != records.end(); iter++)
+    keys.push_back(iter->first);
+  return true;
+}
+
+//
+// Returns the key and value of every record whose key starts with prefix
+//
+bool getRecordsWithPrefix(const std::string& prefix, Records& records) const
+{
+  return getRange(prefix, true, prefixUpperBound(prefix), 0, records);
+}
+
+//
+// Returns the literal part of pattern before the first wildcard
+//
+static std::string wildcardPrefix(const std::string& pattern)
+{
+  std::size_t pos = pattern.find_first_of("*?");
+  return pos == std::string::npos ? pattern : pattern.substr(0, pos);
+}
+
 bool getKeys(const std::string& pattern, std::vector<std::string>& keys) const
 {
-  bool first = true;
-  std::string key;
-  while(nextKey(key, first))
+  //
+  // Only the range of keys that share the literal prefix of the pattern
+  // can match.  Seek to it instead of walking the whole database.
+  //
+  std::string prefix = wildcardPrefix(pattern);
+  Records records;
+  getRange(prefix, true, prefixUpperBound(prefix), 0, records, true);
+  for (Records::const_iterator iter = records.begin(); iter != records.end(); iter++)
   {
-    first = false;
-    if (OSS::string_wildcard_compare(pattern.c_str(), key))
+    if (OSS::string_wildcard_compare(pattern.c_str(), iter->first))
     {
-      keys.push_back(key);
+      keys.push_back(iter->first);
     }
   }
   return !keys.empty();
@@ -0,0 +1,177 @@
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "GNU Lesser General Public License (LGPL)".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+#ifndef OSS_REDISASYNCCLIENT_H_INCLUDED
+#define	OSS_REDISASYNCCLIENT_H_INCLUDED
+
+#include "OSS/build.h"
+
+#if ENABLE_FEATURE_REDIS
+#if OSS_HAVE_HIREDIS
+
+#include <vector>
+#include <map>
+#include <boost/function.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/atomic.hpp>
+#include <boost/thread/future.hpp>
+#include "OSS/Persistent/RedisClient.h"
+
+
+namespace OSS {
+
+namespace Persistent {
+
+
+struct RedisReply
+  /// Copy of a hiredis reply that can be handed across threads.
+  ///
+  /// Nested arrays are flattened into elements.  A SCAN reply for example
+  /// yields the cursor followed by the keys.
+{
+  RedisReply();
+
+  bool isError() const;
+  bool isNil() const;
+  bool isOk() const;
+    /// Returns true if the reply is an OK status, a non-nil string,
+    /// an integer or an array.
+
+  int type;
+    /// One of the REDIS_REPLY_XXX types.  REDIS_REPLY_ERROR is also used
+    /// for transport errors.
+  long long integer;
+  std::string str;
+  std::vector<std::string> elements;
+};
+
+
+class RedisAsyncClient : boost::noncopyable
+  /// Pipelined Redis client backed by a pool of connections.
+  ///
+  /// Each connection is served by its own thread.  Commands queued on a
+  /// connection while a batch is in flight are written together as the next
+  /// batch so that N commands cost one round-trip instead of N.  Commands
+  /// are assigned to connections by hashing their first argument (the key
+  /// for most commands), which preserves the order of commands per key.
+  ///
+  /// Completion handlers are called from the connection thread.  They must
+  /// not block or they will stall every request queued behind them.
+  ///
+  /// A connection that failed to connect or to write a batch completes the
+  /// commands assigned to it with an error reply right away.  Its thread
+  /// reconnects every RECONNECT_INTERVAL until the server is back.
+{
+public:
+  typedef RedisClient::Command Command;
+  typedef RedisClient::Commands Commands;
+  typedef boost::function<void(const RedisReply&)> ReplyHandler;
+  typedef boost::function<void(bool, const std::vector<std::string>&)> KeysHandler;
+  typedef boost::shared_future<RedisReply> ReplyFuture;
+
+  enum
+  {
+    DEFAULT_POOL_SIZE = 4,
+    DEFAULT_MAX_PIPELINE = 256,
+    RECONNECT_INTERVAL = 1000 // milliseconds
+  };
+
+  struct Stats
+  {
+    Stats();
+    OSS::UInt64 commands;
+      /// Number of commands written to the server
+    OSS::UInt64 batches;
+      /// Number of round-trips used to write them
+    OSS::UInt64 errors;
+      /// Number of commands completed with a transport error
+  };
+
+  RedisAsyncClient(const std::string& tcpHost, int tcpPort, std::size_t poolSize = DEFAULT_POOL_SIZE);
+
+  ~RedisAsyncClient();
+
+  bool connect(const std::string& password = "", int db = 0);
+    /// Connects every connection in the pool and starts their threads.
+    /// Returns false if any of the connections failed.
+
+  void disconnect();
+    /// Stops all threads.  Requests still queued complete with an error.
+
+  bool isConnected() const;
+    /// Returns true if every connection of the pool is up
+
+  void setMaxPipeline(std::size_t maxPipeline);
+    /// Maximum number of commands written in a single batch
+
+  void execute(const Command& command, const ReplyHandler& handler = ReplyHandler());
+    /// Queues a command.  The handler, if set, is called with the reply.
+
+  ReplyFuture execute(const Command& command, bool);
+    /// Queues a command and returns a future for its reply.  The second
+    /// argument only disambiguates this overload.
+
+  void execute(const Commands& commands, const ReplyHandler& handler);
+    /// Queues a group of commands that are written back to back on the same
+    /// connection.  The handler receives the first error if any of the
+    /// commands failed.  Otherwise it receives the reply of the last command.
+
+  void set(const std::string& key, const std::string& value, int seconds = -1, const ReplyHandler& handler = ReplyHandler());
+
+  void get(const std::string& key, const ReplyHandler& handler);
+
+  void del(const std::string& key, const ReplyHandler& handler = ReplyHandler());
+
+  void mset(const std::map<std::string, std::string>& values, int seconds = -1, const ReplyHandler& handler = ReplyHandler());
+    /// Stores all values in one batch.  Uses MSET if there is no expiration.
+    /// Otherwise, one SETEX per key is pipelined.
+
+  void hmset(const std::string& key, const std::map<std::string, std::string>& hmap, const ReplyHandler& handler = ReplyHandler());
+
+  void scan(const std::string& pattern, const KeysHandler& handler, std::size_t count = RedisClient::DEFAULT_SCAN_COUNT);
+    /// Iterates the keyspace using SCAN.  The handler is called once with
+    /// all matching keys when the iteration completes.
+
+  Stats getStats() const;
+
+private:
+  class Connection;
+  typedef std::vector<Connection*> Pool;
+
+  Connection* selectConnection(const Command& command);
+
+  static void executeOn(Connection* pConnection, const Command& command, const ReplyHandler& handler);
+
+  std::string _tcpHost;
+  int _tcpPort;
+  std::size_t _poolSize;
+  Pool _pool;
+  boost::atomic<std::size_t> _roundRobin;
+  bool _started;
+};
+
+
+} } // OSS::Persistent
+
+
+#endif // OSS_HAVE_HIREDIS
+
+#endif // ENABLE_FEATURE_REDIS
+
+#endif	/* OSS_REDISASYNCCLIENT_H_INCLUDED */
@@ -47,6 +47,16 @@ class RedisClient : boost::noncopyable
 public:
   typedef boost::recursive_mutex mutex;
   typedef boost::lock_guard<mutex> mutex_lock;
+  typedef std::vector<std::string> Command;
+  typedef std::vector<Command> Commands;
+  typedef std::pair<std::string, std::string> Record;
+  typedef std::vector<Record> Records;
+
+  enum
+  {
+    DEFAULT_SCAN_COUNT = 1000,
+    MGET_BATCH_SIZE = 500
+  };
 
   struct ConnectionInfo
   {
@@ -105,6 +115,13 @@ protected:
   std::vector<std::string> getReplyStringArray(const std::vector<std::string>& args) const;
 
   std::string getStatusString(const std::vector<std::string>& args) const;
+
+  bool pipeline(const Commands& commands, std::vector<redisReply*>& replies);
+    /// Writes all commands to the socket before reading any reply so that
+    /// the whole batch costs a single round-trip.  On success, replies holds
+    /// one reply per command in the same order.  The caller owns the replies
+    /// and must release them using freeReply().  On failure, the connection
+    /// is dropped and no reply is returned.
   
 public:
   void execute(const std::vector<std::string>& args, std::ostream& strm) const;
@@ -125,6 +142,14 @@ public:
 
   bool hmset(const std::string& key, const std::map<std::string, std::string>& hmap);
 
+  bool mset(const std::map<std::string, std::string>& values, int seconds = -1);
+    /// Stores all values in a single round-trip.  Uses MSET if there is no
+    /// expiration.  Otherwise, SETEX commands are pipelined.
+
+  bool mget(const std::vector<std::string>& keys, std::vector<std::string>& values) const;
+    /// Returns the values of keys in the same order.  Missing keys yield
+    /// an empty string.
+
   bool get(const std::string& key, json::Object& value) const;
 
   bool get(const std::string& key, std::string& value) const;
@@ -140,6 +165,28 @@ public:
   bool hmget(const std::string& key, const std::vector<std::string>& fields, std::vector<std::string>& value) const;
 
   bool getKeys(const std::string& pattern, std::vector<std::string>& keys);
+    /// Returns all keys matching pattern.  This uses SCAN instead of KEYS
+    /// so the server is never blocked for the duration of the iteration.
+    /// keys is cleared first and left empty if any SCAN step fails.
+
+  bool scan(unsigned long long& cursor, const std::string& pattern, std::vector<std::string>& keys, std::size_t count = DEFAULT_SCAN_COUNT);
+    /// Performs a single SCAN step starting at cursor.  Matching keys are
+    /// appended to keys and cursor is updated.  The iteration is complete
+    /// when cursor is set back to 0.
+
+  bool getKeysWithPrefix(const std::string& prefix, std::vector<std::string>& keys);
+    /// Returns all keys starting with prefix.  Glob characters in prefix
+    /// are matched literally.
+
+  bool getRecords(const std::string& pattern, Records& records);
+    /// Returns the keys matching pattern with their values.  The values of
+    /// each SCAN step are fetched with MGET pipelined with the next step.
+    /// records is cleared first and left empty if any round-trip fails.
+
+  bool getRecordsWithPrefix(const std::string& prefix, Records& records);
+
+  static std::string escapePattern(const std::string& literal);
+    /// Escapes the glob characters of literal for use in a MATCH pattern
 
   bool del(const std::string& key);
 
@@ -79,6 +79,13 @@ public:
     /// a call to parse exits due to encountering exit name
 
 protected:
+  SDPHeaderList(const char* rawHeader, char exitName, std::size_t& tailOffset);
+    /// Parses rawHeader without copying the tail.  tailOffset receives
+    /// the offset of the tail within rawHeader or 0 if there is none.
+
+  std::size_t parse(const char* rawHeader, bool storeTail);
+    /// Returns the offset of the tail within rawHeader or 0 if there is none
+
   int _parserState;
   bool _isValid;
   char _exitName;
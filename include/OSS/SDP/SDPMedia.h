@@ -78,6 +78,11 @@ public:
   explicit SDPMedia(const char* rawHeader);
     /// Create an SDP header from an unparsed header string
 
+  SDPMedia(const char* rawHeader, std::size_t& tailOffset);
+    /// Create an SDP header from the first media description in rawHeader.
+    /// The rest of the string is not copied.  tailOffset receives the
+    /// offset of the next media description or 0 if this is the last one.
+
   SDPMedia(const SDPMedia& header);
     /// SDP Header copy constructor
 
@@ -0,0 +1,281 @@
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "GNU Lesser General Public License (LGPL)".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+
+
+#ifndef SIP_SDPParser_H_INCLUDED
+#define SIP_SDPParser_H_INCLUDED
+
+
+#include <string>
+#include <vector>
+
+#include "OSS/SDP/SDP.h"
+#include "OSS/SDP/SDPMedia.h"
+
+
+namespace OSS {
+namespace SDP {
+
+
+class OSS_API SDPParser
+  /// Read-only index of an SDP body built in a single pass.
+  ///
+  /// Session and media level lines are recorded as spans into the
+  /// original body instead of being copied into SDPHeader objects.
+  /// The ports in m= lines and the addresses in c= lines are located
+  /// upfront so they can be patched in place using SDPRewriter.
+  ///
+  /// The parser holds no lock.  A parsed index is immutable and may be
+  /// shared by any number of readers.
+  ///
+  /// A body passed as a string is copied once so temporaries are safe to
+  /// parse.  A body passed as a pointer is not copied and must outlive
+  /// the parser.
+  ///
+  /// If parsing fails, the index is left empty.
+{
+public:
+  static const std::size_t npos;
+
+  struct Span
+  {
+    Span();
+    Span(std::size_t offset, std::size_t length);
+    bool empty() const;
+    std::size_t end() const;
+
+    std::size_t offset;
+    std::size_t length;
+  };
+
+  struct Line
+  {
+    char name;
+    Span line;
+      /// The whole line including its terminator
+    Span value;
+      /// The text after the '=' excluding the terminator
+  };
+
+  struct Media
+  {
+    Media();
+    SDPMedia::Type type;
+    std::size_t firstLine;
+      /// Index of the m= line
+    std::size_t lastLine;
+      /// Index one past the last line of this media description
+    std::size_t connectionLine;
+      /// Index of the media level c= line or npos
+    Span port;
+      /// The port in the m= line excluding the number of ports
+    Span address;
+      /// The address in the media level c= line.  Empty if the line
+      /// does not have exactly three tokens.
+  };
+
+  typedef std::vector<Line> Lines;
+  typedef std::vector<Media> MediaList;
+  typedef std::vector<Span> Spans;
+
+  SDPParser();
+    /// Creates an empty parser
+
+  SDPParser(const char* body, std::size_t size);
+    /// Parses body.  Check isValid() for the result.
+
+  explicit SDPParser(const std::string& body);
+    /// Parses a copy of body.  Check isValid() for the result.
+
+  bool parse(const char* body, std::size_t size);
+    /// Indexes body.  Returns false and leaves no line or media
+    /// description indexed if a line does not start with a single
+    /// character name followed by '='.
+
+  bool isValid() const;
+
+  const char* data() const;
+
+  std::size_t size() const;
+
+  const Lines& getLines() const;
+
+  const MediaList& getMediaList() const;
+
+  std::size_t getSessionLineCount() const;
+    /// Returns the number of lines preceding the first m= line
+
+  std::string getString(const Span& span) const;
+
+  std::string getValue(std::size_t line) const;
+
+  std::string findHeader(char name) const;
+    /// Returns the value of the first session level line named name
+
+  std::string getAddress() const;
+    /// Returns the session level connection address
+
+  std::size_t getConnectionLine() const;
+    /// Returns the index of the session level c= line or npos
+
+  const Span& getAddressSpan() const;
+    /// Returns the span of the session level connection address
+
+  std::size_t getMediaCount(SDPMedia::Type type = SDPMedia::TYPE_NONE) const;
+    /// Returns the number of media descriptions of the given type.
+    /// TYPE_NONE counts all of them.
+
+  const Media* getMedia(SDPMedia::Type type, std::size_t index = 0) const;
+    /// Returns the index-th media description of the given type or 0
+
+  std::string getAddress(const Media& media) const;
+
+  unsigned short getDataPort(const Media& media) const;
+
+  unsigned short getControlPort(const Media& media) const;
+    /// Returns the port in a=rtcp if present, the data port + 1 otherwise
+
+  std::size_t findAttribute(const Media& media, const char* attribute) const;
+    /// Returns the index of the first a=attribute:value line or npos
+
+  std::size_t findFlagAttribute(const Media& media, const char* flag) const;
+    /// Returns the index of the first a=flag line or npos
+
+  std::string getAttribute(const Media& media, const char* attribute) const;
+    /// Returns the value of the first a=attribute:value line
+
+  std::size_t getAttributes(const Media& media, const char* attribute, Spans& values) const;
+    /// Collects the values of every a=attribute:value line.  This is how
+    /// ICE candidates are read without copying them.
+
+private:
+  SDPParser(const SDPParser&);
+  SDPParser& operator=(const SDPParser&);
+    /// Not copyable.  The index points into the body.
+
+  void reset(const char* body, std::size_t size);
+  static bool parseAddress(const char* data, const Span& value, Span& address);
+  static void parseMediaLine(const char* data, const Span& value, Media& media);
+  std::size_t matchAttribute(const Line& line, const char* attribute, std::size_t len) const;
+
+  std::string _body;
+    /// Owned copy of the body if it was passed as a string
+  const char* _data;
+  std::size_t _size;
+  bool _isValid;
+  Lines _lines;
+  MediaList _media;
+  std::size_t _sessionLineCount;
+  std::size_t _connectionLine;
+  Span _address;
+};
+
+//
+// Inlines
+//
+
+inline SDPParser::Span::Span() :
+  offset(0),
+  length(0)
+{
+}
+
+inline SDPParser::Span::Span(std::size_t offset_, std::size_t length_) :
+  offset(offset_),
+  length(length_)
+{
+}
+
+inline bool SDPParser::Span::empty() const
+{
+  return length == 0;
+}
+
+inline std::size_t SDPParser::Span::end() const
+{
+  return offset + length;
+}
+
+inline bool SDPParser::isValid() const
+{
+  return _isValid;
+}
+
+inline const char* SDPParser::data() const
+{
+  return _data;
+}
+
+inline std::size_t SDPParser::size() const
+{
+  return _size;
+}
+
+inline const SDPParser::Lines& SDPParser::getLines() const
+{
+  return _lines;
+}
+
+inline const SDPParser::MediaList& SDPParser::getMediaList() const
+{
+  return _media;
+}
+
+inline std::size_t SDPParser::getSessionLineCount() const
+{
+  return _sessionLineCount;
+}
+
+inline std::string SDPParser::getString(const Span& span) const
+{
+  return std::string(_data + span.offset, span.length);
+}
+
+inline std::string SDPParser::getValue(std::size_t line) const
+{
+  return getString(_lines[line].value);
+}
+
+inline std::size_t SDPParser::getConnectionLine() const
+{
+  return _connectionLine;
+}
+
+inline const SDPParser::Span& SDPParser::getAddressSpan() const
+{
+  return _address;
+}
+
+inline std::string SDPParser::getAddress() const
+{
+  return getString(_address);
+}
+
+inline std::string SDPParser::getAddress(const Media& media) const
+{
+  return getString(media.address);
+}
+
+
+} } // OSS::SDP
+
+
+#endif // SIP_SDPParser_H_INCLUDED
+
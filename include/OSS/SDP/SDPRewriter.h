@@ -0,0 +1,170 @@
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "GNU Lesser General Public License (LGPL)".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+
+
+#ifndef SIP_SDPRewriter_H_INCLUDED
+#define SIP_SDPRewriter_H_INCLUDED
+
+
+#include <string>
+#include <vector>
+
+#include "OSS/SDP/SDPParser.h"
+
+
+namespace OSS {
+namespace SDP {
+
+
+class OSS_API SDPRewriter
+  /// Applies edits to an SDP body indexed by SDPParser as a list of patches.
+  ///
+  /// Edits only record the span they replace.  apply() sorts the patches
+  /// by offset and copies the untouched parts of the original body and the
+  /// replacement text into the result in a single pass.  A patch that
+  /// overlaps one applied before it is dropped, so removing a line wins
+  /// over any other edit within that line.
+  ///
+  /// Lookups through the parser see the original body.  Pending patches
+  /// are not visible until apply() is called.
+{
+public:
+  typedef SDPParser::Span Span;
+  typedef SDPParser::Media Media;
+
+  explicit SDPRewriter(const SDPParser& parser);
+    /// The parser must outlive the rewriter
+
+  void replace(const Span& span, const std::string& text);
+    /// Replaces span with text
+
+  void insert(std::size_t offset, const std::string& text);
+    /// Inserts text at offset
+
+  void insertLine(std::size_t offset, char name, const std::string& value);
+    /// Inserts a new line at offset.  offset must be at a line boundary.
+    /// The line is terminated like the first line of the body, or with
+    /// CRLF if no line has a terminator.
+
+  void replaceValue(std::size_t line, const std::string& value);
+    /// Replaces the value of a line keeping its name and terminator
+
+  void removeLine(std::size_t line);
+
+  void changeAddress(const std::string& address, const char* version = "IP4");
+    /// Rewrites every session level c= line like SDPSession::changeAddress
+
+  void setAddressV4(const std::string& address);
+
+  void setAddressV6(const std::string& address);
+
+  void setAddressV4(const Media& media, const std::string& address);
+    /// Rewrites the media level c= line.  A new line is inserted after
+    /// the m= and i= lines if there is none.
+
+  void setAddressV6(const Media& media, const std::string& address);
+
+  void setDataPort(const Media& media, unsigned short port);
+    /// Replaces the port in the m= line.  The number of ports, if any,
+    /// is preserved.
+
+  void setControlPort(const Media& media, unsigned short port);
+    /// Sets a=rtcp:port.  The attribute is appended if missing.
+
+  void setFlagAttribute(const Media& media, const char* flag);
+    /// Appends a=flag if the media does not have it yet
+
+  void removeCommonAttribute(const Media& media, const char* attribute);
+    /// Removes the first a=attribute:value line
+
+  void removePtime(const Media& media);
+
+  bool hasPatches() const;
+
+  std::size_t getPatchCount() const;
+
+  std::string apply() const;
+    /// Returns the original body with every patch applied
+
+private:
+  struct Patch
+  {
+    std::size_t offset;
+    std::size_t length;
+    std::string text;
+    bool isLine;
+      /// Set for lines inserted by insertLine()
+  };
+  typedef std::vector<Patch> Patches;
+
+  static bool comparePatch(const Patch& a, const Patch& b);
+  void internalSetAddress(const Media& media, const std::string& address, bool isV4);
+  std::size_t endOfMedia(const Media& media) const;
+
+  const SDPParser& _parser;
+  std::string _lineEnd;
+  Patches _patches;
+};
+
+//
+// Inlines
+//
+
+inline void SDPRewriter::setAddressV4(const std::string& address)
+{
+  changeAddress(address, "IP4");
+}
+
+inline void SDPRewriter::setAddressV6(const std::string& address)
+{
+  changeAddress(address, "IP6");
+}
+
+inline void SDPRewriter::setAddressV4(const Media& media, const std::string& address)
+{
+  internalSetAddress(media, address, true);
+}
+
+inline void SDPRewriter::setAddressV6(const Media& media, const std::string& address)
+{
+  internalSetAddress(media, address, false);
+}
+
+inline void SDPRewriter::removePtime(const Media& media)
+{
+  removeCommonAttribute(media, "ptime");
+}
+
+inline bool SDPRewriter::hasPatches() const
+{
+  return !_patches.empty();
+}
+
+inline std::size_t SDPRewriter::getPatchCount() const
+{
+  return _patches.size();
+}
+
+
+} } // OSS::SDP
+
+
+#endif // SIP_SDPRewriter_H_INCLUDED
+
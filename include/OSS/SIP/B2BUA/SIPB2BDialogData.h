@@ -31,9 +31,7 @@
 #include "OSS/OSS.h"
 #include "OSS/UTL/CoreUtils.h"
 #include "OSS/UTL/Logger.h"
-#include "OSS/JSON/reader.h"
-#include "OSS/JSON/writer.h"
-#include "OSS/JSON/elements.h"
+#include "OSS/JSON/Json.h"
 
 
 
@@ -211,39 +209,37 @@ public:
     
 #endif
     
+    void toJson(OSS::JSON::JsonWriter& writer) const
+    {
+      writer.beginObject();
+      writer.key("dialogId"); writer.string(dialogId);
+      writer.key("callId"); writer.string(callId);
+      writer.key("from"); writer.string(from);
+      writer.key("to"); writer.string(to);
+      writer.key("remoteContact"); writer.string(remoteContact);
+      writer.key("localContact"); writer.string(localContact);
+      writer.key("localRecordRoute"); writer.string(localRecordRoute);
+      writer.key("remoteIp"); writer.string(remoteIp);
+      writer.key("transportId"); writer.string(transportId);
+      writer.key("targetTransport"); writer.string(targetTransport);
+      writer.key("localSdp"); writer.string(localSdp);
+      writer.key("remoteSdp"); writer.string(remoteSdp);
+      writer.key("encryption"); writer.string(encryption);
+      writer.key("noRtpProxy"); writer.boolean(noRtpProxy);
+      writer.key("localCSeq"); writer.number(localCSeq);
+      writer.key("routeSet");
+      writer.beginArray();
+      for (std::vector<std::string>::const_iterator iter = routeSet.begin(); iter != routeSet.end(); iter++)
+        writer.string(*iter);
+      writer.endArray();
+      writer.endObject();
+    }
+
     void toJsonString(std::string& json) const
     {
-      std::ostringstream strm;
-      strm << "{" ;
-      strm << "dialogId : " << "\"" << dialogId << "\"" ;
-      strm << "," << "callId : " << "\"" << callId << "\"" ;
-      strm << "," << "from : " << "\"" << JsonHelper::escapeString(from) << "\"" ;
-      strm << "," << "to : " << "\"" << JsonHelper::escapeString(to) << "\"" ;
-      strm << "," << "remoteContact : " << "\"" << JsonHelper::escapeString(remoteContact) << "\"" ;
-      strm << "," << "localContact : " << "\"" << JsonHelper::escapeString(localContact) << "\"" ;
-      strm << "," << "localRecordRoute : " << "\"" << localRecordRoute << "\"" ;
-      strm << "," << "remoteIp : " << "\"" << remoteIp << "\"" ;
-      strm << "," << "transportId : " << "\"" << transportId << "\"" ;
-      strm << "," << "targetTransport : " << "\"" << targetTransport << "\"" ;
-      strm << "," << "localSdp : " << "\"" << JsonHelper::escapeString(localSdp) << "\"" ;
-      strm << "," << "remoteSdp : " << "\"" << JsonHelper::escapeString(remoteSdp) << "\"" ;
-      strm << "," << "encryption : " << "\"" << encryption << "\"" ;
-      strm << "," << "noRtpProxy : " << (noRtpProxy ? "true" : "false");
-      strm << "," << "localCSeq : " << localCSeq;
-      
-      if (!routeSet.empty())
-      {
-        strm << "," << "routeSet : [";
-        std::vector<std::string>::const_iterator iter = routeSet.begin();
-        strm << "" << "\"" << JsonHelper::escapeString(*iter) << "\"";
-        iter++;
-        for (;iter != routeSet.end(); iter++)
-          strm << "," << "\"" << JsonHelper::escapeString(*iter) << "\"";
-        strm << "]";
-      }
-      
-      strm << "}";
-      json = strm.str();
+      json.clear();
+      OSS::JSON::JsonWriter writer(json);
+      toJson(writer);
     }
     
     
@@ -386,40 +382,28 @@ public:
     }
   }
 
+  void toJson(OSS::JSON::JsonWriter& writer) const
+  {
+    writer.beginObject();
+    writer.key("sessionId"); writer.string(sessionId);
+    writer.key("leg1"); leg1.toJson(writer);
+    writer.key("leg2"); leg2.toJson(writer);
+    writer.key("timeStamp"); writer.number(timeStamp);
+    writer.key("connectTime"); writer.number(connectTime);
+    writer.key("disconnectTime"); writer.number(disconnectTime);
+    writer.key("sessionAge"); writer.number(sessionAge);
+    writer.endObject();
+  }
+
   void toJsonString(std::string& object) const
   {
-#if 0
-    json::Object jObject;
-    toJsonObject(jObject);
-    try
-    {
-      std::ostringstream strm;
-      json::Writer::Write(jObject, strm);
-      object = strm.str();
-    }
-    catch(json::Exception& e)
-    {
-      OSS_LOG_ERROR("SIPB2BDialogData: Unable to parse json object - " << e.what());
-    }
-#endif
-    
-    std::string sleg1;
-    std::string sleg2;
-    leg1.toJsonString(sleg1);
-    leg2.toJsonString(sleg2);
-    
-    std::ostringstream strm;
-      strm << "{" ;
-      strm << "" << "sessionId : " << "\"" << sessionId << "\"" ;
-      strm << "," << "timeStamp : " << timeStamp;
-      strm << "," << "connectTime : " << connectTime;
-      strm << "," << "disconnectTime : " << disconnectTime;
-      strm << "," << "sessionAge : " << sessionAge;
-      strm << "," << "leg1 : " << sleg1;
-      strm << "," << "leg2 : " << sleg2;
-        
-    strm << "}";
-    object = strm.str();
+    //
+    // Written directly instead of through a json::Object.  This runs on
+    // every dialog state update.
+    //
+    object.clear();
+    OSS::JSON::JsonWriter writer(object);
+    toJson(writer);
   }
  
   void fromJsonObject(const json::Object& object)
@@ -444,18 +428,14 @@ public:
 
   void fromJsonString(const std::string& jsonString)
   {
-    try
-    {
-      json::Object object;
-      std::stringstream strm;
-      strm << jsonString;
-      json::Reader::Read(object, strm);
-      fromJsonObject(object);
-    }
-    catch(json::Exception& e)
+    json::Object object;
+    OSS::JSON::Exception e;
+    if (!OSS::JSON::json_parse_string(jsonString, object, e))
     {
       OSS_LOG_ERROR("SIPB2BDialogData: Unable to parse json object - " << e.what());
+      return;
     }
+    fromJsonObject(object);
   }
 };
 
@@ -540,18 +520,20 @@ struct SIPB2BRegData
 
   void toJsonString(std::string& object) const
   {
-    json::Object jObject;
-    toJsonObject(jObject);
-    try
-    {
-      std::ostringstream strm;
-      json::Writer::Write(jObject, strm);
-      object = strm.str();
-    }
-    catch(json::Exception& e)
-    {
-      OSS_LOG_ERROR("SIPB2BRegData: Unable to parse json object - " << e.what());
-    }
+    object.clear();
+    OSS::JSON::JsonWriter writer(object);
+    writer.beginObject();
+    writer.key("key"); writer.string(key);
+    writer.key("callId"); writer.string(callId);
+    writer.key("contact"); writer.string(contact);
+    writer.key("packetSource"); writer.string(packetSource);
+    writer.key("localInterface"); writer.string(localInterface);
+    writer.key("transportId"); writer.string(transportId);
+    writer.key("targetTransport"); writer.string(targetTransport);
+    writer.key("aor"); writer.string(aor);
+    writer.key("expires"); writer.number(expires);
+    writer.key("enc"); writer.boolean(enc);
+    writer.endObject();
   }
 
   void fromJsonObject(const json::Object& object)
@@ -577,18 +559,14 @@ struct SIPB2BRegData
 
   void fromJsonString(const std::string& jsonString)
   {
-    try
-    {
-      json::Object object;
-      std::stringstream strm;
-      strm << jsonString;
-      json::Reader::Read(object, strm);
-      fromJsonObject(object);
-    }
-    catch(json::Exception& e)
+    json::Object object;
+    OSS::JSON::Exception e;
+    if (!OSS::JSON::json_parse_string(jsonString, object, e))
     {
       OSS_LOG_ERROR("SIPB2BRegData: Unable to parse json object - " << e.what());
+      return;
     }
+    fromJsonObject(object);
   }
 };
 
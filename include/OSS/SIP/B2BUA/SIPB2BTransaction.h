@@ -224,6 +224,9 @@ protected:
   SIPB2BDialogData _dialogData;
   bool _isChallenged;
   std::string _pendingSubscriptionId;
+  OSS::UInt64 _dispatchTime;
+    /// When the request arrived on the transport.  Zero for client
+    /// transactions.
   friend class SIPB2BTransactionManager;
 };
 
@@ -35,8 +35,21 @@ namespace SBC {
   
   
 class SBCAccounts
+  /// Local accounts used by SBCAuthenticator.
+  ///
+  /// Records read from the workspace are kept in memory, with their A1
+  /// hash, for cacheTtl milliseconds so a registration storm does not
+  /// parse the stored JSON on every challenge response.  Records written
+  /// through addAccount() invalidate their cache entry.  Anything else
+  /// that writes to the workspace directly should call invalidate().
 {
 public:
+  enum
+  {
+    DEFAULT_CACHE_TTL_MS = 60000,
+    MAX_CACHED_ACCOUNTS = 100000
+  };
+
   typedef std::map<std::string, SBCAccountRecord> VolatileAccounts;
   typedef std::set<std::string> Realms;
   SBCAccounts();
@@ -58,14 +71,36 @@ public:
   bool isKnownIdentity(const std::string& identity) const;
   
   void addRealm(const std::string& realm);
+
+  void invalidate(const std::string& identity);
+    /// Drops the cached record of identity
+
+  void invalidateAll();
+    /// Drops every cached record
+
+  void setCacheTtl(unsigned int cacheTtl);
+    /// Milliseconds a record read from the workspace is cached.  0 disables
+    /// the cache.
+
+  std::size_t getCacheSize() const;
 protected:
   void determineRealms();
 private:
+  struct CachedAccount
+  {
+    SBCAccountRecord record;
+    OSS::UInt64 expires;
+  };
+  typedef std::map<std::string, CachedAccount> AccountCache;
+
   SBCWorkSpaceManager::WorkSpace _workspace;
   VolatileAccounts _volatileAccounts;
   mutable OSS::mutex_critic_sec _volatileAccountsMutex;
   Realms _realms;
   bool _hasDeterminedRealms;
+  mutable OSS::mutex_read_write _cacheMutex;
+  mutable AccountCache _cache;
+  unsigned int _cacheTtl;
   
 };
   
@@ -30,6 +30,7 @@
 #include "OSS/SIP/B2BUA/SIPB2BTransaction.h"
 #include "OSS/SIP/SIPMessage.h"
 #include "OSS/SIP/SBC/SBCAccounts.h"
+#include "OSS/SIP/SIPDigestAuth.h"
 
 
 namespace OSS {
@@ -48,12 +49,23 @@ public:
   SIPMessage::Ptr onAuthenticateTransaction(
     const SIPMessage::Ptr& pRequest, SIPB2BTransaction::Ptr pTransaction);
   
-  bool isAuthorized(const SIPMessage::Ptr& pRequest, const SBCAccountRecord& record);
+  bool isAuthorized(const SIPMessage::Ptr& pRequest, const SBCAccountRecord& record, bool* pStale = 0);
+    /// Verifies the digest response of the request.  Unless the request
+    /// carries a force-nonce property, the nonce must be a timed nonce
+    /// issued for the realm of the account within the nonce lifetime and
+    /// its nonce-count must not have been used before.  pStale is set to
+    /// true if the digest response is correct but the nonce has expired.
 
   SBCAccounts& accounts();
+
+  void setNonceLifetime(unsigned int lifetime);
+    /// Seconds a challenge nonce remains valid
+
+  unsigned int getNonceLifetime() const;
 private:
   SBCAccounts _accounts;
-   
+  unsigned int _nonceLifetime;
+  SIPDigestNonceCounter _nonceCounts;
 };
 
 
@@ -67,6 +79,17 @@ inline SBCAccounts& SBCAuthenticator::accounts()
   return _accounts;
 }
 
+inline void SBCAuthenticator::setNonceLifetime(unsigned int lifetime)
+{
+  _nonceLifetime = lifetime;
+  _nonceCounts.setLifetime(lifetime);
+}
+
+inline unsigned int SBCAuthenticator::getNonceLifetime() const
+{
+  return _nonceLifetime;
+}
+
 } } } // OSS::SIP::SBC
 
 #endif	/* SBCAUTHENTICATOR_H */
@@ -76,11 +76,27 @@ public:
   
   const std::string& getSessionId() const;
   
+  void reset(
+    const SIPMessage::Ptr& pRequest,
+    const SIPTransaction::Ptr& pTransaction,
+    Type type
+  );
+    /// Reinitializes a pooled event.  The session id buffer is reused.
+  
+  void clear();
+    /// Releases the request and transaction before the event is pooled
+  
+  OSS::UInt64 getEnqueueTime() const;
+  
+  void setEnqueueTime(OSS::UInt64 enqueueTime);
+    /// Time in microseconds the event was queued.  Used for the queue lag.
+  
 private:
   SIPMessage::Ptr _pRequest;
   SIPTransaction::Ptr _pTransaction;
   Type _type;
   std::string _sessionId;
+  OSS::UInt64 _enqueueTime;
 };
 
 
@@ -89,7 +105,8 @@ private:
 //
 
 inline SBCCDREvent::SBCCDREvent() :
-  _type(EVENT_UNKNOWN)
+  _type(EVENT_UNKNOWN),
+  _enqueueTime(0)
 {
   
 }
@@ -99,10 +116,31 @@ inline SBCCDREvent::SBCCDREvent(
   const SIPTransaction::Ptr& pTransaction,
   Type type
 ) :
- _type(type)
+ _type(type),
+ _enqueueTime(0)
+{
+  reset(pRequest, pTransaction, type);
+}
+
+inline SBCCDREvent::SBCCDREvent(const SBCCDREvent& cdrEvent) :
+  _type(cdrEvent.getType()),
+  _enqueueTime(cdrEvent.getEnqueueTime())
+{
+  _pRequest = cdrEvent.getRequest();
+  _pTransaction = cdrEvent.getTransaction();
+  _sessionId = cdrEvent.getSessionId();
+}
+
+inline void SBCCDREvent::reset(
+  const SIPMessage::Ptr& pRequest,
+  const SIPTransaction::Ptr& pTransaction,
+  Type type
+)
 {
+  _type = type;
   _pRequest = pRequest;
   _pTransaction = pTransaction;
+  _sessionId.clear();
   if (_pTransaction->isParent())
   {
     _pTransaction->getProperty("session-id", _sessionId);
@@ -113,12 +151,13 @@ inline SBCCDREvent::SBCCDREvent(
   }
 }
 
-inline SBCCDREvent::SBCCDREvent(const SBCCDREvent& cdrEvent) :
-  _type(cdrEvent.getType())
+inline void SBCCDREvent::clear()
 {
-  _pRequest = cdrEvent.getRequest();
-  _pTransaction = cdrEvent.getTransaction();
-  _sessionId = cdrEvent.getSessionId();
+  _type = EVENT_UNKNOWN;
+  _pRequest.reset();
+  _pTransaction.reset();
+  _sessionId.clear();
+  _enqueueTime = 0;
 }
 
 inline SBCCDREvent::~SBCCDREvent()
@@ -136,6 +175,7 @@ inline SBCCDREvent& SBCCDREvent::operator= (const SBCCDREvent& event)
   _pRequest = event.getRequest();
   _pTransaction = event.getTransaction();
   _sessionId =  event.getSessionId();
+  _enqueueTime = event.getEnqueueTime();
   return *this;
 }
 
@@ -175,6 +215,16 @@ inline const std::string& SBCCDREvent::getSessionId() const
   return _sessionId;
 }
 
+inline OSS::UInt64 SBCCDREvent::getEnqueueTime() const
+{
+  return _enqueueTime;
+}
+
+inline void SBCCDREvent::setEnqueueTime(OSS::UInt64 enqueueTime)
+{
+  _enqueueTime = enqueueTime;
+}
+
 } } } // OSS::SIP::SBC
 
 
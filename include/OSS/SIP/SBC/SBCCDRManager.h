@@ -24,6 +24,8 @@
 #define	SBCCDRMANAGER_H_INCLUDED
 
 
+#include <map>
+#include <vector>
 #include "OSS/SIP/SBC/SBCWorkSpaceManager.h"
 #include "OSS/SIP/SBC/SBCCDREvent.h"
 #include "OSS/SIP/SBC/SBCCDRRecord.h"
@@ -42,10 +44,23 @@ class SBCManager;
 
   
 class SBCCDRManager
+  /// Records call detail records in the CDR workspace and the cdr.csv log.
+  ///
+  /// Call phase events are queued to a single writer thread.  The thread
+  /// drains up to the batch size or until the batch interval elapses, then
+  /// writes the workspace updates with one flush and the log lines with one
+  /// append.  Event objects are recycled through a free list.
 {
 public:
   typedef BlockingQueue<SBCCDREvent*> EventQueue;
   
+  enum
+  {
+    DEFAULT_BATCH_SIZE = 256,
+    DEFAULT_BATCH_INTERVAL = 50, // milliseconds
+    MAX_POOLED_EVENTS = 1024
+  };
+  
   SBCCDRManager();
   
   ~SBCCDRManager();
@@ -92,11 +107,62 @@ public:
   
   SBCManager* sbcManager();
   
+  void setBatchSize(std::size_t batchSize);
+  
+  std::size_t getBatchSize() const;
+  
+  void setBatchInterval(unsigned int milliseconds);
+    /// Longest time the writer waits for more events once the first event
+    /// of a batch arrives
+  
+  unsigned int getBatchInterval() const;
+  
+  std::size_t getQueueSize() const;
+    /// Number of events waiting for the writer thread.  The lag between
+    /// enqueue and commit is recorded in the sbc.cdr.lag.us histogram.
+  
+  bool readRecord(const std::string& sessionId, SBCCDRRecord& cdr);
+    /// Returns the record of a session including changes of the current
+    /// batch that are not written yet.  Only called by the writer thread.
+  
+  void writeRecord(const std::string& sessionId, SBCCDRRecord& cdr);
+  
+  void deleteRecord(const std::string& sessionId);
+  
+  void logRecord(SBCCDRRecord& cdr);
+    /// Queues the cdr.csv line of a completed call
+  
 protected:
   void onHandleEvent();
   
+  void enqueueEvent(
+    const SIPMessage::Ptr& pRequest,
+    const SIPTransaction::Ptr& pTransaction,
+    SBCCDREvent::Type type
+  );
+  
+  SBCCDREvent* acquireEvent();
+  
+  void releaseEvent(SBCCDREvent* pEvent);
+  
+  void commitBatch();
+  
 private:  
+  struct PendingRecord
+  {
+    SBCCDRRecord record;
+    bool deleted;
+  };
+  typedef std::map<std::string, PendingRecord> PendingRecords;
+  
   EventQueue _eventQueue;
+  std::vector<SBCCDREvent*> _eventPool;
+  OSS::mutex_critic_sec _eventPoolMutex;
+  std::size_t _batchSize;
+  unsigned int _batchInterval;
+  SBCWorkSpace::Batch _batch;
+  PendingRecords _pending;
+  std::string _logBuffer;
   boost::thread* _pEventQueueThread;
   SBCManager* _pManager;
   SBCWorkSpaceManager* _pWorkSpaceManager;
@@ -122,7 +188,7 @@ inline void SBCCDRManager::onCallProgress(
   const SIPTransaction::Ptr& pTransaction
 )
 {
-  _eventQueue.enqueue(new SBCCDREvent(pRequest, pTransaction, SBCCDREvent::EVENT_PROGRESS));
+  enqueueEvent(pRequest, pTransaction, SBCCDREvent::EVENT_PROGRESS);
 }
 
 inline void SBCCDRManager::onCallFinal(
@@ -130,7 +196,7 @@ inline void SBCCDRManager::onCallFinal(
   const SIPTransaction::Ptr& pTransaction
 )
 {
-  _eventQueue.enqueue(new SBCCDREvent(pRequest, pTransaction, SBCCDREvent::EVENT_FINAL));
+  enqueueEvent(pRequest, pTransaction, SBCCDREvent::EVENT_FINAL);
 }
 
 inline void SBCCDRManager::onCallTerminated(
@@ -138,7 +204,7 @@ inline void SBCCDRManager::onCallTerminated(
   const SIPTransaction::Ptr& pTransaction
 )
 {
-  _eventQueue.enqueue(new SBCCDREvent(pRequest, pTransaction, SBCCDREvent::EVENT_TERMINATED));
+  enqueueEvent(pRequest, pTransaction, SBCCDREvent::EVENT_TERMINATED);
 }
 
 inline void SBCCDRManager::onCallTransferred(
@@ -146,7 +212,7 @@ inline void SBCCDRManager::onCallTransferred(
   const SIPTransaction::Ptr& pTransaction
 )
 {
-  _eventQueue.enqueue(new SBCCDREvent(pRequest, pTransaction, SBCCDREvent::EVENT_TRANSFERRED));
+  enqueueEvent(pRequest, pTransaction, SBCCDREvent::EVENT_TRANSFERRED);
 }
 
 inline void SBCCDRManager::setCDRLifeTime(unsigned int cdrLifeTime)
@@ -178,6 +244,31 @@ inline SBCManager* SBCCDRManager::sbcManager()
 {
   return _pManager;
 }
+
+inline void SBCCDRManager::setBatchSize(std::size_t batchSize)
+{
+  _batchSize = batchSize ? batchSize : 1;
+}
+
+inline std::size_t SBCCDRManager::getBatchSize() const
+{
+  return _batchSize;
+}
+
+inline void SBCCDRManager::setBatchInterval(unsigned int milliseconds)
+{
+  _batchInterval = milliseconds;
+}
+
+inline unsigned int SBCCDRManager::getBatchInterval() const
+{
+  return _batchInterval;
+}
+
+inline std::size_t SBCCDRManager::getQueueSize() const
+{
+  return _eventQueue.size();
+}
   
 } } } // OSS::SIP::SBC
 
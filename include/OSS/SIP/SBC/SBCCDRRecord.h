@@ -65,8 +65,15 @@ public:
   std::string& sessionId();
   
   bool writeToWorkSpace(SBCWorkSpace& workspace, const std::string& key, unsigned int expire);
+  void writeToBatch(SBCWorkSpace::Batch& batch, const std::string& key);
+    /// Same as writeToWorkSpace but the record is stored when the batch is written
   bool readFromWorkSpace(SBCWorkSpace& workspace, const std::string& key);
+  bool readFromJson(const std::string& value);
+    /// Decodes a record returned by an SBCWorkSpace range read
+  bool readFromJson(json::Object& value);
   bool writeToLogFile(OSS::UTL::LogFile& logFile);
+  void toLogLine(std::string& line);
+    /// Appends the CSV line written by writeToLogFile without a line terminator
   void toJson(json::Object& object);
   
 protected:
@@ -25,10 +25,10 @@
 
 
 #include "OSS/SIP/SBC/SBCWorkSpaceManager.h"
+#include "OSS/SIP/SBC/SBCDialPrefixTrie.h"
 #include "OSS/SIP/B2BUA/SIPB2BTransaction.h"
 #include "OSS/UTL/BlockingQueue.h"
 #include "OSS/UTL/LogFile.h"
-#include <Poco/ExpireCache.h>
 
 
 namespace OSS {
@@ -40,13 +40,29 @@ class SBCManager;
 
   
 class SBCChannelLimits
+  /// Enforces the maximum number of concurrent calls per dial prefix.
+  ///
+  /// Dial strings are matched against the registered prefixes using a
+  /// longest prefix match on a digit trie.  Each prefix owns an atomic call
+  /// counter.  Lookups and getCallCount() never take a lock.  A session is
+  /// counted at most once and is forgotten after an hour if removeCall()
+  /// is never called for it.
+  ///
+  /// Sessions are keyed by session id alone and remember the counter they
+  /// were added to, so a session added before a reload is still removed
+  /// from the right counter.  They are spread over SESSION_SHARDS maps,
+  /// each with its own lock, so concurrent calls rarely contend.
 {
 public: 
-  typedef Poco::ExpireCache<std::string, std::string> ExpireCache;
-  typedef boost::shared_ptr<ExpireCache> ExpireCachePtr;
-  typedef std::map<std::string, ExpireCachePtr> ChannelMap;
+  enum
+  {
+    SESSION_SHARDS = 64
+  };
+
+  typedef SBCDialPrefixTrie::Counter Counter;
+  typedef SBCDialPrefixTrie::CounterPtr CounterPtr;
+  typedef boost::shared_ptr<SBCDialPrefixTrie> TriePtr;
   typedef std::map<std::string, std::size_t> Limits;
-  typedef std::map<std::string, std::string> PrefixAliases;
   
   SBCChannelLimits();
   
@@ -55,6 +71,13 @@ public:
   void initialize(SBCManager* pSBCManager);
   
   void registerDialPrefix(const std::string& prefix, std::size_t channelLimit);
+    /// Registers a prefix or updates its limit.  The prefix may be followed
+    /// by comma separated aliases, ie "1800,1888,1877", which share its counter.
+  
+  void loadDialPrefixes(const Limits& limits);
+    /// Replaces all registered prefixes.  The keys use the same format as
+    /// registerDialPrefix().  The new trie is built aside and swapped in
+    /// atomically.  Prefixes that survive the reload keep their call count.
   
   std::size_t addCall(const std::string& sessionId, const std::string& dialString, std::size_t& channelLimit);
   
@@ -64,16 +87,42 @@ public:
   
   std::size_t getCallCount(const std::string& prefix);
   
+  std::size_t getPrefixCount() const;
+    /// Number of registered prefixes including aliases
+  
 protected:
-  void resolveAliasPrefix(const std::string& dialString, std::string& prefix);
+  CounterPtr matchPrefix(const std::string& dialString) const;
+  
+  CounterPtr registerDialPrefix(SBCDialPrefixTrie& trie, const SBCDialPrefixTrie& previous, const std::string& prefix, std::size_t channelLimit);
+  
+  void updateWorkspaceCounter(const Counter& counter, std::size_t count);
   
 private:
-  ChannelMap _prefixes;
+  struct Session
+  {
+    CounterPtr counter;
+      /// The counter the session was added to
+    OSS::UInt64 expires;
+  };
+  typedef std::map<std::string, Session> Sessions;
+
+  struct SessionShard : boost::noncopyable
+  {
+    SessionShard();
+    OSS::mutex_critic_sec mutex;
+    Sessions sessions;
+    OSS::UInt64 nextExpireCheck;
+  };
+
+  SessionShard& getShard(const std::string& sessionId);
+
+  void expireSessions(SessionShard& shard, OSS::UInt64 now);
+  
+  TriePtr _trie;
   OSS::mutex_critic_sec _prefixesMutex;
-  std::size_t _shortestPrefix;
-  Poco::Timestamp::TimeDiff _cacheExpire;
-  Limits _limits;
-  PrefixAliases _aliases;
+    /// Serializes writers of the trie.  Readers do not use it.
+  SessionShard _shards[SESSION_SHARDS];
+  OSS::UInt64 _cacheExpire;
   SBCManager* _pManager;
   SBCWorkSpaceManager::WorkSpace _systemDb;
 };
@@ -86,6 +135,16 @@ inline void SBCChannelLimits::setSystemDb(const SBCWorkSpaceManager::WorkSpace&
   _systemDb = systemDb;
 }
 
+inline SBCChannelLimits::CounterPtr SBCChannelLimits::matchPrefix(const std::string& dialString) const
+{
+  return boost::atomic_load(&_trie)->match(dialString);
+}
+
+inline std::size_t SBCChannelLimits::getPrefixCount() const
+{
+  return boost::atomic_load(&_trie)->size();
+}
+
 } } } // OSS::SIP::SBC
 
 #endif // SBCCHANNELLIMITS_H_INCLUDED
@@ -99,6 +99,7 @@ protected:
   bool handleSyntaxRequest(const SBCConsole::CommandTokens& data, std::string& result);
   bool handleHelpRequest(const SBCConsole::CommandTokens& data, std::string& result);
   bool handlePublishRequest(const SBCConsole::CommandTokens& data, std::string& result);
+  bool handleMetricsRequest(const SBCConsole::CommandTokens& data, std::string& result);
   
   Client _internalClient;
   SBCAuxiliarySocket _socket;
@@ -0,0 +1,152 @@
+// OSS Software Solutions Application Programmer Interface
+//
+// Author: Joegen E. Baclor - mailto:joegen@ossapp.com
+//
+// Package: SBC
+//
+// Copyright (c) OSS Software Solutions
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "OSS Software Solutions OSS API General License Agreement".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+
+#ifndef SBCDIALPREFIXTRIE_H_INCLUDED
+#define	SBCDIALPREFIXTRIE_H_INCLUDED
+
+
+#include <set>
+#include <string>
+#include <vector>
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/enable_shared_from_this.hpp>
+#include <boost/atomic.hpp>
+#include "OSS/OSS.h"
+
+
+namespace OSS {
+namespace SIP {
+namespace SBC {
+
+
+class SBCDialPrefixTrie : boost::noncopyable
+  /// Digit trie mapping dial prefixes to channel counters.
+  ///
+  /// match() returns the counter of the longest registered prefix of a
+  /// dial string in O(length) regardless of the number of prefixes.
+  /// Several prefixes may share the same counter.  This is how prefix
+  /// aliases are represented.
+  ///
+  /// The trie is insert-only.  Nodes are published with release stores so
+  /// lookups never lock and may run concurrently with a single writer.
+  /// Writers must be serialized by the caller.
+  ///
+  /// Only the characters 0-9, *, # and + are valid in a prefix.  Matching
+  /// stops at the first character outside that set.
+{
+public:
+  enum
+  {
+    ALPHABET_SIZE = 13
+  };
+
+  struct Counter : boost::noncopyable, boost::enable_shared_from_this<Counter>
+  {
+    Counter(const std::string& prefix, std::size_t limit);
+    const std::string prefix;
+      /// The canonical prefix that owns the counter
+    boost::atomic<std::size_t> limit;
+    boost::atomic<std::size_t> count;
+  };
+
+  typedef boost::shared_ptr<Counter> CounterPtr;
+
+  SBCDialPrefixTrie();
+
+  ~SBCDialPrefixTrie();
+
+  bool insert(const std::string& prefix, const CounterPtr& counter);
+    /// Maps prefix to counter, replacing any previous mapping.
+    /// Returns false if the prefix is empty or has invalid characters.
+
+  CounterPtr match(const std::string& dialString) const;
+    /// Returns the counter of the longest prefix of dialString or
+    /// a null pointer if there is none.
+
+  CounterPtr find(const std::string& prefix) const;
+    /// Returns the counter mapped to exactly this prefix
+
+  std::size_t size() const;
+    /// Number of prefixes in the trie
+
+  std::size_t nodeCount() const;
+
+  static int charIndex(char ch);
+    /// Returns the child slot of ch or -1 if it can't be part of a prefix
+
+private:
+  struct Node : boost::noncopyable
+  {
+    Node();
+    boost::atomic<Node*> children[ALPHABET_SIZE];
+    boost::atomic<Counter*> counter;
+  };
+
+  static void destroy(Node* pNode);
+
+  Node* _root;
+  std::set<CounterPtr> _counters;
+    /// Owns every counter that was inserted so that a concurrent reader
+    /// never sees a counter being destroyed when a mapping is replaced.
+    /// Inserting a counter that is already owned does not add an entry.
+  boost::atomic<std::size_t> _size;
+  boost::atomic<std::size_t> _nodeCount;
+};
+
+//
+// Inlines
+//
+
+inline int SBCDialPrefixTrie::charIndex(char ch)
+{
+  if (ch >= '0' && ch <= '9')
+    return ch - '0';
+  switch (ch)
+  {
+  case '*':
+    return 10;
+  case '#':
+    return 11;
+  case '+':
+    return 12;
+  }
+  return -1;
+}
+
+inline std::size_t SBCDialPrefixTrie::size() const
+{
+  return _size.load(boost::memory_order_relaxed);
+}
+
+inline std::size_t SBCDialPrefixTrie::nodeCount() const
+{
+  return _nodeCount.load(boost::memory_order_relaxed);
+}
+
+
+} } } // OSS::SIP::SBC
+
+
+#endif	// SBCDIALPREFIXTRIE_H_INCLUDED
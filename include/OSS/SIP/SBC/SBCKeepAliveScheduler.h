@@ -0,0 +1,200 @@
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "GNU Lesser General Public License (LGPL)".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+
+#ifndef SBCKEEPALIVESCHEDULER_H_INCLUDED
+#define SBCKEEPALIVESCHEDULER_H_INCLUDED
+
+
+#include <map>
+#include <set>
+#include <vector>
+#include <boost/noncopyable.hpp>
+#include "OSS/UTL/CoreUtils.h"
+#include "OSS/UTL/Thread.h"
+
+
+namespace OSS {
+namespace SIP {
+namespace SBC {
+
+
+template <typename Key, typename Value>
+class SBCKeepAliveScheduler : boost::noncopyable
+  /// Timing wheel used to spread keep-alives evenly across an interval.
+  ///
+  /// The wheel has one slot per tick of the keep-alive interval.  Every
+  /// binding is assigned to the least loaded slot when it is first scheduled
+  /// and stays there until it is cancelled.  Calling advance() once per tick
+  /// returns the bindings that are due in the current slot.  A binding that
+  /// is scheduled with an expire time is dropped by advance() once that time
+  /// has passed.
+  ///
+  /// The scheduler is an in-memory index.  Callers keep it in sync with
+  /// the persistent store by calling schedule() and cancel() on changes.
+{
+public:
+  typedef std::pair<Key, Value> Binding;
+  typedef std::vector<Binding> Bindings;
+
+  explicit SBCKeepAliveScheduler(std::size_t slotCount) :
+    _slots(slotCount ? slotCount : 1),
+    _cursor(0)
+  {
+  }
+
+  void schedule(const Key& key, const Value& value, OSS::UInt64 expireTime = 0)
+    /// Insert a new binding or update the value of an existing one.
+    /// Updates keep the slot assigned to the binding.
+    /// An expireTime of 0 means the binding does not expire.
+  {
+    OSS::mutex_critic_sec_lock lock(_mutex);
+    typename Index::iterator iter = _index.find(key);
+    if (iter != _index.end())
+    {
+      iter->second.value = value;
+      iter->second.expireTime = expireTime;
+      return;
+    }
+    Entry entry;
+    entry.value = value;
+    entry.expireTime = expireTime;
+    entry.slot = findLeastLoadedSlot();
+    _slots[entry.slot].insert(key);
+    _index.insert(std::make_pair(key, entry));
+  }
+
+  bool cancel(const Key& key)
+    /// Remove the binding from the wheel.  Returns false if it does not exist.
+  {
+    OSS::mutex_critic_sec_lock lock(_mutex);
+    typename Index::iterator iter = _index.find(key);
+    if (iter == _index.end())
+      return false;
+    _slots[iter->second.slot].erase(key);
+    _index.erase(iter);
+    return true;
+  }
+
+  bool get(const Key& key, Value& value) const
+    /// Copy the value of the binding.  Returns false if it does not exist.
+  {
+    OSS::mutex_critic_sec_lock lock(_mutex);
+    typename Index::const_iterator iter = _index.find(key);
+    if (iter == _index.end())
+      return false;
+    value = iter->second.value;
+    return true;
+  }
+
+  bool has(const Key& key) const
+  {
+    OSS::mutex_critic_sec_lock lock(_mutex);
+    return _index.find(key) != _index.end();
+  }
+
+  std::size_t size() const
+  {
+    OSS::mutex_critic_sec_lock lock(_mutex);
+    return _index.size();
+  }
+
+  std::size_t slotCount() const
+  {
+    return _slots.size();
+  }
+
+  void clear()
+  {
+    OSS::mutex_critic_sec_lock lock(_mutex);
+    for (typename Slots::iterator iter = _slots.begin(); iter != _slots.end(); iter++)
+      iter->clear();
+    _index.clear();
+  }
+
+  std::size_t advance(Bindings& due, std::vector<Key>* expired = 0)
+    /// Move to the next slot and copy the bindings that are due into due.
+    /// Expired bindings are removed from the wheel and, if expired
+    /// is not null, reported there.  Returns the number of due bindings.
+  {
+    OSS::UInt64 now = OSS::getTime();
+    OSS::mutex_critic_sec_lock lock(_mutex);
+    _cursor = (_cursor + 1) % _slots.size();
+    std::set<Key>& slot = _slots[_cursor];
+    std::size_t count = 0;
+    for (typename std::set<Key>::iterator iter = slot.begin(); iter != slot.end();)
+    {
+      typename Index::iterator entry = _index.find(*iter);
+      if (entry == _index.end())
+      {
+        slot.erase(iter++);
+        continue;
+      }
+      if (entry->second.expireTime && entry->second.expireTime <= now)
+      {
+        if (expired)
+          expired->push_back(*iter);
+        _index.erase(entry);
+        slot.erase(iter++);
+        continue;
+      }
+      due.push_back(Binding(*iter, entry->second.value));
+      ++count;
+      ++iter;
+    }
+    return count;
+  }
+
+private:
+  struct Entry
+  {
+    Entry() : expireTime(0), slot(0) {}
+    Value value;
+    OSS::UInt64 expireTime;
+    std::size_t slot;
+  };
+  typedef std::map<Key, Entry> Index;
+  typedef std::vector< std::set<Key> > Slots;
+
+  std::size_t findLeastLoadedSlot() const
+  {
+    //
+    // Ties are resolved in favor of the slot that fires next so a new
+    // binding gets its first keep-alive as early as possible.
+    //
+    std::size_t best = (_cursor + 1) % _slots.size();
+    for (std::size_t i = 1; i < _slots.size(); i++)
+    {
+      std::size_t slot = (_cursor + 1 + i) % _slots.size();
+      if (_slots[slot].size() < _slots[best].size())
+        best = slot;
+    }
+    return best;
+  }
+
+  mutable OSS::mutex_critic_sec _mutex;
+  Slots _slots;
+  Index _index;
+  std::size_t _cursor;
+};
+
+
+} } } // OSS::SIP::SBC
+
+#endif // SBCKEEPALIVESCHEDULER_H_INCLUDED
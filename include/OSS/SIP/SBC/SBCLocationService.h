@@ -0,0 +1,150 @@
+// OSS Software Solutions Application Programmer Interface
+//
+// Author: Joegen E. Baclor - mailto:joegen@ossapp.com
+//
+// Package: SBC
+//
+// Copyright (c) OSS Software Solutions
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "OSS Software Solutions OSS API General License Agreement".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+
+#ifndef SBCLOCATIONSERVICE_H_INCLUDED
+#define	SBCLOCATIONSERVICE_H_INCLUDED
+
+
+#include <map>
+#include <vector>
+#include <string>
+#include <boost/noncopyable.hpp>
+#include <boost/unordered_map.hpp>
+#include "OSS/OSS.h"
+#include "OSS/UTL/Thread.h"
+#include "OSS/SIP/SBC/SBCRegistrationRecord.h"
+
+
+namespace OSS {
+namespace SIP {
+namespace SBC {
+
+
+class SBCLocationService : boost::noncopyable
+  /// In-memory index of the bindings stored in the registrar workspace.
+  ///
+  /// Bindings are grouped per AOR so a lookup costs one hash probe no matter
+  /// how many registrations exist.  Records are kept decoded so lookups do
+  /// not touch the database or parse JSON.  A deadline index ordered by
+  /// expiry time lets expired bindings be collected without visiting the
+  /// live ones.
+  ///
+  /// The index does not write to the workspace.  The registrar keeps both
+  /// coherent by updating the index after every successful store or delete.
+{
+public:
+  struct Binding
+  {
+    std::string key;
+      /// The workspace key of the record
+    SBCRegistrationRecord record;
+    OSS::UInt64 deadline;
+      /// Expiry time in milliseconds or 0 if the binding never expires
+  };
+
+  typedef std::vector<Binding> Bindings;
+  typedef std::vector<std::string> Keys;
+
+  SBCLocationService();
+
+  ~SBCLocationService();
+
+  void update(const std::string& key, const SBCRegistrationRecord& record);
+    /// Inserts or replaces the binding stored under key.  It is indexed
+    /// under record.aor().
+
+  bool remove(const std::string& key);
+    /// Removes the binding stored under key
+
+  bool getBindings(const std::string& aor, Bindings& bindings, OSS::UInt64 now) const;
+    /// Returns the bindings of aor that have not expired at time now
+
+  bool getKeys(const std::string& aor, Keys& keys) const;
+    /// Returns the keys of every binding of aor including expired ones
+
+  std::size_t expire(OSS::UInt64 now, Keys& expired);
+    /// Removes the bindings that have expired at time now and returns their keys
+
+  OSS::UInt64 nextDeadline() const;
+    /// Returns the earliest deadline or 0 if no binding expires
+
+  std::size_t size() const;
+    /// Number of bindings
+
+  std::size_t aorCount() const;
+
+  void clear();
+
+  static OSS::UInt64 deadline(const SBCRegistrationRecord& record);
+
+private:
+  typedef boost::unordered_map<std::string, Bindings> AorIndex;
+  typedef std::multimap<OSS::UInt64, std::string> DeadlineIndex;
+  struct KeyInfo
+  {
+    std::string aor;
+    DeadlineIndex::iterator deadline;
+  };
+  typedef boost::unordered_map<std::string, KeyInfo> KeyIndex;
+
+  void removeKey(KeyIndex::iterator iter);
+
+  mutable OSS::mutex_read_write _rwMutex;
+  AorIndex _aors;
+  KeyIndex _keys;
+  DeadlineIndex _deadlines;
+};
+
+//
+// Inlines
+//
+
+inline std::size_t SBCLocationService::size() const
+{
+  OSS::mutex_read_lock lock(_rwMutex);
+  return _keys.size();
+}
+
+inline std::size_t SBCLocationService::aorCount() const
+{
+  OSS::mutex_read_lock lock(_rwMutex);
+  return _aors.size();
+}
+
+inline OSS::UInt64 SBCLocationService::nextDeadline() const
+{
+  OSS::mutex_read_lock lock(_rwMutex);
+  return _deadlines.empty() ? 0 : _deadlines.begin()->first;
+}
+
+inline OSS::UInt64 SBCLocationService::deadline(const SBCRegistrationRecord& record)
+{
+  return record.expires() > 0 ? record.timeStamp() + (OSS::UInt64)record.expires() * 1000 : 0;
+}
+
+
+} } } // OSS::SIP::SBC
+
+
+#endif	// SBCLOCATIONSERVICE_H_INCLUDED
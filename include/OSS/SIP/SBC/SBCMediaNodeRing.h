@@ -0,0 +1,138 @@
+// OSS Software Solutions Application Programmer Interface
+//
+// Author: Joegen E. Baclor - mailto:joegen@ossapp.com
+//
+// Package: SBC
+//
+// Copyright (c) OSS Software Solutions
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "OSS Software Solutions OSS API General License Agreement".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+
+#ifndef SBCMEDIANODERING_H_INCLUDED
+#define	SBCMEDIANODERING_H_INCLUDED
+
+
+#include <map>
+#include <vector>
+#include <string>
+#include <boost/noncopyable.hpp>
+#include "OSS/OSS.h"
+#include "OSS/UTL/Thread.h"
+
+
+namespace OSS {
+namespace SIP {
+namespace SBC {
+
+
+class SBCMediaNodeRing : boost::noncopyable
+  /// Consistent hash ring of media nodes.
+  ///
+  /// Each node is placed on the ring at POINTS_PER_WEIGHT * weight points.
+  /// A key maps to the first healthy node found clockwise from its hash.
+  /// Adding or removing a node only remaps the keys that hashed to that
+  /// node's points, roughly 1/N of the keyspace.
+  ///
+  /// Nodes are ejected after maxFailures consecutive failures and are
+  /// given another chance once ejectTime milliseconds have elapsed.
+{
+public:
+  enum
+  {
+    POINTS_PER_WEIGHT = 100,
+    DEFAULT_MAX_FAILURES = 3,
+    DEFAULT_EJECT_TIME_MS = 30000
+  };
+
+  struct NodeInfo
+  {
+    NodeInfo();
+    std::string id;
+    unsigned int weight;
+    unsigned int failures;
+      /// Number of consecutive failures
+    OSS::UInt64 ejectedUntil;
+      /// Time in milliseconds when an ejected node is retried.  0 if healthy.
+  };
+
+  typedef std::vector<NodeInfo> Nodes;
+
+  SBCMediaNodeRing(unsigned int maxFailures = DEFAULT_MAX_FAILURES, unsigned int ejectTime = DEFAULT_EJECT_TIME_MS);
+
+  ~SBCMediaNodeRing();
+
+  bool addNode(const std::string& id, unsigned int weight = 1);
+    /// Adds a node or changes the weight of an existing one.
+    /// Returns false if weight is 0.
+
+  bool removeNode(const std::string& id);
+    /// Removes a node from the ring.  Returns false if it does not exist.
+
+  bool hasNode(const std::string& id) const;
+
+  bool getNode(const std::string& key, std::string& id) const;
+    /// Returns the node responsible for key.  Ejected nodes are skipped.
+    /// Returns false if there is no healthy node.
+
+  void markFailure(const std::string& id);
+    /// Records a failed request.  The node is ejected once maxFailures
+    /// consecutive failures are reached.
+
+  void markSuccess(const std::string& id);
+    /// Records a successful request and readmits the node if ejected
+
+  bool isHealthy(const std::string& id) const;
+
+  Nodes getNodes() const;
+
+  std::size_t size() const;
+
+  static OSS::UInt32 hash(const std::string& key);
+    /// 32 bit FNV-1a hash with a murmur3 finalizer.  It is stable across
+    /// processes and platforms so every SBC instance places keys on the
+    /// same node.
+
+private:
+  typedef std::map<OSS::UInt32, std::string> Ring;
+  typedef std::map<std::string, NodeInfo> NodeMap;
+
+  void insertPoints(const NodeInfo& node);
+  void erasePoints(const NodeInfo& node);
+  bool isHealthy(const NodeInfo& node, OSS::UInt64 now) const;
+
+  mutable OSS::mutex_read_write _rwMutex;
+  Ring _ring;
+  NodeMap _nodes;
+  unsigned int _maxFailures;
+  unsigned int _ejectTime;
+};
+
+//
+// Inlines
+//
+
+inline std::size_t SBCMediaNodeRing::size() const
+{
+  OSS::mutex_read_lock lock(_rwMutex);
+  return _nodes.size();
+}
+
+
+} } } // OSS::SIP::SBC
+
+
+#endif	// SBCMEDIANODERING_H_INCLUDED
@@ -25,7 +25,11 @@
 #define	SBCMEDIAPROXY_H_INCLUDED
 
 
+#include <map>
+#include <vector>
+#include <boost/shared_ptr.hpp>
 #include "OSS/SIP/SBC/SBCMediaProxyClient.h"
+#include "OSS/SIP/SBC/SBCMediaNodeRing.h"
 #include "OSS/RTP/RTPProxyManager.h"
 
 
@@ -36,8 +40,28 @@ namespace SBC {
 class SBCManager;
 
 class SBCMediaProxy
+  /// Routes media sessions to the local RTP proxy or to remote media nodes.
+  ///
+  /// Remote nodes are placed on a consistent hash ring keyed by session id.
+  /// Once a node accepts a session, the session stays pinned to that node
+  /// even if nodes are added or removed in between.  The pin is dropped
+  /// when the session is removed, when the node fails an SDP for it, or
+  /// when no SDP was handled for the session within the pin lifetime so
+  /// sessions that end without being removed do not pile up.
+  ///
+  /// If no node is configured, the five legacy local nodes are used with
+  /// the legacy mapping on the 5th character of the session id so sessions
+  /// created before an upgrade still reach the node that owns them.
+  /// Configuring a node at runtime ends the legacy mapping.  Sessions
+  /// created until then stay pinned to their legacy node.
+  ///
+  /// Only requests that get no reply from a node count against its health.
+  /// Errors returned by the node, ie the session limit, do not.
 {
 public:
+  typedef boost::shared_ptr<SBCMediaProxyClient> Node;
+  typedef std::map<std::string, unsigned int> NodeWeights;
+
   SBCMediaProxy(SBCManager* pManager);
   
   ~SBCMediaProxy();
@@ -65,14 +89,78 @@ public:
   unsigned int getMaxSession() const;
   
   unsigned int getSessionCount() const;
+
+  bool addNode(const std::string& address, unsigned int weight = 1);
+    /// Adds a remote media node (ie tcp://host:port) or changes its weight.
+    /// May be called at runtime.
+
+  bool removeNode(const std::string& address);
+    /// Removes a remote media node.  Sessions pinned to the node are
+    /// released.  May be called at runtime.
+
+  bool configureNodes(const NodeWeights& nodes);
+    /// Adds or updates the listed nodes (address to weight) and removes
+    /// the ones that are not listed.  Applied from the media_proxy_nodes
+    /// setting of the user agent configuration.
+
+  bool isLegacyMode() const;
+    /// Returns true if sessions are mapped to the legacy local nodes
+
+  void setSessionPinLifetime(unsigned int seconds);
+    /// Sets how long a session stays pinned after its last SDP.
+    /// Defaults to DEFAULT_SESSION_PIN_LIFETIME.
+
+  unsigned int getSessionPinLifetime() const;
+
+  std::size_t getPinnedSessionCount() const;
+    /// Returns the number of sessions pinned to a node
+
+  enum
+  {
+    DEFAULT_SESSION_PIN_LIFETIME = 43200, // seconds
+    SESSION_PIN_SWEEP_INTERVAL = 60 // seconds
+  };
+
+  SBCMediaNodeRing& ring();
   
 protected:
-  SBCMediaProxyClient* getNode(const std::string& sessionId, bool& spillOver);
-  SBCMediaProxyClient _node0;
-  SBCMediaProxyClient _node1;
-  SBCMediaProxyClient _node2;
-  SBCMediaProxyClient _node3;
-  SBCMediaProxyClient _node4;
+  Node getNode(const std::string& sessionId, std::string& address);
+    /// Returns the node serving sessionId and its address.  If the session
+    /// is not pinned, a node is picked from the ring.  The session is not
+    /// pinned by the lookup.
+
+  void pinSession(const std::string& sessionId, const std::string& address);
+    /// Pins the session to the node or refreshes the pin.  Called once the
+    /// node accepted an SDP for the session.
+
+  void releaseSession(const std::string& sessionId);
+
+  void expireSessions(OSS::UInt64 now);
+    /// Drops the pins that were not refreshed within the pin lifetime
+
+  void attachNode(const Node& node);
+  void updateHealth(const std::string& address, bool reachable);
+
+  struct Pin
+  {
+    std::string address;
+    OSS::UInt64 expires;
+  };
+
+  typedef std::map<std::string, Node> Nodes;
+  typedef std::map<std::string, Pin> Sessions;
+  typedef std::vector<Node> LegacyNodes;
+
+  mutable OSS::mutex_read_write _rwNodesMutex;
+  Nodes _nodes;
+  LegacyNodes _legacyNodes;
+    /// Indexed by the legacy mapping.  Empty unless in legacy mode.
+  Sessions _sessions;
+  unsigned int _sessionPinLifetime;
+  OSS::mutex_critic_sec _pinSweepMutex;
+  OSS::UInt64 _nextPinSweep;
+  SBCMediaNodeRing _ring;
+  unsigned int _maxSession;
   SBCManager* _pManager;
   OSS::RTP::RTPProxyManager _rtp;
   bool _remoteRtpEnabled;
@@ -82,6 +170,16 @@ protected:
 // Inlines
 //
 
+inline SBCMediaNodeRing& SBCMediaProxy::ring()
+{
+  return _ring;
+}
+
+inline bool SBCMediaProxy::isLegacyMode() const
+{
+  OSS::mutex_read_lock lock(_rwNodesMutex);
+  return !_legacyNodes.empty();
+}
 
 } } } // OSS::SIP::SBC
 
@@ -25,8 +25,12 @@
 #define	SBCMEDIAPROXYCLIENT_H_INCLUDED
 
 
+#include <map>
+#include <boost/function.hpp>
+#include <boost/atomic.hpp>
 #include "OSS/ZMQ/zmq.hpp"
 #include "OSS/UTL/Thread.h"
+#include "OSS/UTL/BlockingQueue.h"
 #include "OSS/RTP/RTPProxyManager.h"
 
 
@@ -35,14 +39,48 @@ namespace SIP {
 namespace SBC {
 
   
-class SBCMediaProxyClient
+class SBCMediaProxyClient : boost::noncopyable
+  /// RPC client for a remote media node.
+  ///
+  /// Requests are multiplexed over a single DEALER socket.  Every request
+  /// carries a request id in its envelope which the node echoes back in
+  /// its reply, so any number of requests can be in flight at once.  The
+  /// envelope is compatible with nodes that use a plain REP socket since
+  /// REP copies the envelope verbatim into the reply.
+  ///
+  /// The socket is owned by an I/O thread.  Callers hand over requests
+  /// through a queue that wakes the I/O thread using a pipe.
 {
 public:
+  typedef boost::function<void(bool, const json::Object&)> ResponseHandler;
+    /// Called from the I/O thread with false if the request failed or timed out
+
+  typedef boost::function<void(const std::string&, bool)> HealthHandler;
+    /// Called with the node address and false if a synchronous request got
+    /// no usable reply, ie it could not be sent, timed out or the reply could
+    /// not be parsed.  An error reported by the node in its reply still
+    /// counts as a reply.
+
+  enum
+  {
+    DEFAULT_TIMEOUT_MS = 2000
+  };
+
   SBCMediaProxyClient(int nodeIndex);
+    /// Creates a client for one of the legacy local nodes listening
+    /// on ports 40590 to 40594
+
+  SBCMediaProxyClient(const std::string& address);
+    /// Creates a client for the node at the ZeroMQ address (ie tcp://host:port)
   
   ~SBCMediaProxyClient();
   
   bool sendRequest(const std::string& logId, const std::string& cmd, const json::Object& params, json::Object& result);
+    /// Sends a request and blocks until the reply arrives or the request times out.
+    /// Other requests may be in flight on the same node while this call blocks.
+
+  void sendRequestAsync(const std::string& logId, const std::string& cmd, const json::Object& params, const ResponseHandler& handler);
+    /// Queues a request.  The handler is called from the I/O thread.
   
   bool handleSDP(
     const std::string& logId,
@@ -67,20 +105,65 @@ public:
   bool getSDP(const std::string& sessionId, std::string& lastOffer, std::string& lastAnswer);
   
   bool initialize();
+    /// Starts the I/O thread.  This is also done on the first request.
+
+  void stop();
+    /// Stops the I/O thread.  Pending requests fail.
+
+  void setTimeout(unsigned int timeoutMs);
+
+  void setHealthHandler(const HealthHandler& handler);
+    /// Must be set before the first request
+
+  const std::string& getAddress() const;
+
+  std::size_t getPendingCount() const;
+    /// Number of requests waiting for a reply
   
 protected:
+  struct OutboundRequest
+  {
+    std::string id;
+    std::string logId;
+    std::string cmd;
+    std::string payload;
+    ResponseHandler handler;
+  };
+
+  struct PendingRequest
+  {
+    std::string logId;
+    std::string cmd;
+    OSS::UInt64 deadline;
+    ResponseHandler handler;
+  };
+
+  typedef std::map<std::string, PendingRequest> PendingRequests;
+
+  void run();
+  bool sendOutbound(OutboundRequest& request);
+  void receiveReplies();
+  void expirePending(OSS::UInt64 now);
+  void failPending();
+  void complete(PendingRequest& request, const std::string& raw);
+
   OSS::mutex_critic_sec _mutex;
   zmq::context_t _context;
   zmq::socket_t* _pSocket;
-  bool _isConnected;
+  std::string _address;
+  boost::thread* _pThread;
+  bool _terminate;
+  OSS::BlockingQueue<OutboundRequest> _outbound;
+  PendingRequests _pending;
+  boost::atomic<std::size_t> _pendingCount;
+  boost::atomic<OSS::UInt64> _requestId;
+  unsigned int _timeout;
+  HealthHandler _healthHandler;
   unsigned int _maxSession;
   unsigned int _sessionCount;
   int _nodeIndex;
 };
 
-//
-// Inlines
-//
 inline unsigned int SBCMediaProxyClient::getMaxSession() const
 {
   return _maxSession;
@@ -91,6 +174,26 @@ inline unsigned int SBCMediaProxyClient::getSessionCount() const
   return _sessionCount;
 }
 
+inline const std::string& SBCMediaProxyClient::getAddress() const
+{
+  return _address;
+}
+
+inline std::size_t SBCMediaProxyClient::getPendingCount() const
+{
+  return _pendingCount;
+}
+
+inline void SBCMediaProxyClient::setTimeout(unsigned int timeoutMs)
+{
+  _timeout = timeoutMs;
+}
+
+inline void SBCMediaProxyClient::setHealthHandler(const HealthHandler& handler)
+{
+  _healthHandler = handler;
+}
+
 } } } // OSS::SIP::SBC
 
 
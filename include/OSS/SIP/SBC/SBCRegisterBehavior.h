@@ -37,6 +37,7 @@
 #include "OSS/UTL/BlockingQueue.h"
 #include "OSS/SIP/SBC/SBCDefaultBehavior.h"
 #include "OSS/SIP/SBC/SBCRegistrationRecord.h"
+#include "OSS/SIP/SBC/SBCKeepAliveScheduler.h"
 #include "OSS/Exec/Process.h"
 #include "SBCWorkSpaceManager.h"
 #include "SBCConsole.h"
@@ -226,6 +227,14 @@ public:
   
   bool cliGetGatewayStatus(const SBCConsole::CommandTokens& data, std::string& result);
     /// CLI request for gateway status
+
+  void scheduleOptionsKeepAlive(const std::string& regKey, const SBCRegistrationRecord& registration);
+    /// Add or update the registration in the OPTIONS keep-alive scheduler.
+    /// This must be called whenever a registration is written to the workspace.
+
+  void cancelOptionsKeepAlive(const std::string& regKey);
+    /// Remove the registration from the OPTIONS keep-alive scheduler.
+    /// This must be called whenever a registration is deleted from the workspace.
   
 private:
   void runOptionsThread();
@@ -234,8 +243,12 @@ private:
   void runOptionsResponseThread();
     /// This method runs the OPTIONS keep-alive response loop
 
-  void sendOptionsKeepAlive(const std::string& regRecord);
+  void sendOptionsKeepAlive(const std::string& regKey, const SBCRegistrationRecord& registration);
     /// Send an options keep-alive to the ua owning the registration record
+
+  void loadOptionsKeepAlive();
+    /// Populate the OPTIONS keep-alive scheduler from the workspace.
+    /// This is only done once when the keep-alive thread starts.
   
   void sendGatewayKeepAlive(Gateway& gateway);
     /// Send options to the gateway
@@ -252,9 +265,10 @@ private:
   boost::thread* _pOptionsResponseThread;
   OSS::semaphore _optionsResponseThreadExit;
   OSS::SIP::SIPTransaction::Callback _keepAliveResponseCb;
-  OSS::mutex_read_write _rwKeepAliveListMutex;
-  typedef std::map<OSS::Net::IPAddress, OSS::Net::IPAddress> KeepAliveList;
+  typedef SBCKeepAliveScheduler<OSS::Net::IPAddress, OSS::Net::IPAddress> KeepAliveList;
+  typedef SBCKeepAliveScheduler<std::string, SBCRegistrationRecord> OptionsKeepAliveList;
   KeepAliveList _keepAliveList;
+  OptionsKeepAliveList _optionsKeepAliveList;
   SBCWorkSpaceManager::WorkSpace _workspace;
   OSS::thread_pool _threadPool;
   bool _enableOptionsKeepAlive;
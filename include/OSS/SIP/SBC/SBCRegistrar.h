@@ -31,6 +31,8 @@
 #include "OSS/SIP/B2BUA/SIPB2BTransaction.h"
 #include "OSS/SIP/SBC/SBCWorkSpaceManager.h"
 #include "OSS/SIP/SBC/SBCRegistrationRecord.h"
+#include "OSS/SIP/SBC/SBCLocationService.h"
+#include <boost/atomic.hpp>
 
 
 namespace OSS {
@@ -68,7 +70,8 @@ public:
     /// handle a stop request.  This should not block
 
   void setDatabase(const SBCWorkSpaceManager::WorkSpace& regDb);
-    /// Set the database/workspace to be used by registrar
+    /// Set the database/workspace to be used by registrar.
+    /// The location service is rebuilt from its records.
   
   bool getBindings(const SIPURI& aor, ContactList& bindings);
     /// return the current bindings for the aor
@@ -90,6 +93,9 @@ public:
   
   void attachSBCManager(SBCManager* pManager);
   
+  const SBCLocationService& locations() const;
+    /// The in-memory index of the bindings in the workspace
+  
 protected:
   virtual void onHandleEvent(const SIPMessage::Ptr& pRequest);
     /// handle an incoming SIP event
@@ -103,19 +109,30 @@ protected:
   
   bool storeBinding(const std::string& key, const SBCRegistrationRecord& binding);
   
+  void deleteBinding(const std::string& key);
+  
   void dispatchContacts(const SIPMessage::Ptr& pRequest, const SIPURI& aor);
+  
+  void loadBindings();
+    /// Rebuilds the location service from the workspace
+  
+  void expireBindings();
+    /// Deletes the bindings whose deadline has passed.  This is rate limited
+    /// and cheap enough to call on every lookup.
 private:
   SBCWorkSpaceManager::WorkSpace _regDb;
   SBCManager* _pManager;
+  SBCLocationService _locations;
+  boost::atomic<OSS::UInt64> _nextExpireCheck;
 };
   
 //
 // Inlines
 //
 
-inline void SBCRegistrar::setDatabase(const SBCWorkSpaceManager::WorkSpace& regDb)
+inline const SBCLocationService& SBCRegistrar::locations() const
 {
-  _regDb = regDb;
+  return _locations;
 }
 
 } } }  // OSS::SIP::SBC
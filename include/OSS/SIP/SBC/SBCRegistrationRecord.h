@@ -67,6 +67,9 @@ public:
   bool writeToFile(const boost::filesystem::path& file) const;
   bool writeToFile(const std::string& file) const;
   bool readFromWorkSpace(SBCWorkSpace& client, const std::string& key);
+  bool readFromJson(const std::string& key, const std::string& value);
+    /// Decodes a record returned by an SBCWorkSpace range read
+  bool readFromJson(const std::string& key, json::Object& value);
   bool readFromFile(const boost::filesystem::path& file);
   bool readFromFile(const std::string& file);
 
@@ -13,6 +13,76 @@ class SBCWorkSpace
 {
 public:
   typedef OSS::BerkeleyDb LocalDb;
+  typedef std::vector<std::string> Keys;
+  typedef LocalDb::Record Record;
+  typedef LocalDb::Records Records;
+  
+  enum
+  {
+    DEFAULT_BATCH_SIZE = 1000
+  };
+  
+  class Cursor
+    /// Iterates the records of a key range in key order, one batch at a time.
+    ///
+    /// The workspace is locked only while a batch is read, so a long
+    /// iteration does not stall writers.  A key written or deleted during
+    /// the iteration may or may not be returned.
+  {
+  public:
+    Cursor(SBCWorkSpace& workspace, const std::string& prefix, std::size_t batchSize = DEFAULT_BATCH_SIZE);
+      /// Iterates the keys starting with prefix.  An empty prefix iterates all keys.
+    
+    Cursor(SBCWorkSpace& workspace, const std::string& first, const std::string& last, std::size_t batchSize);
+      /// Iterates the keys in [first, last).  An empty last means no upper bound.
+    
+    bool next(Records& records);
+      /// Appends the next batch to records.  Returns false once the range is exhausted.
+    
+    bool next(Keys& keys);
+      /// Same as above without reading the values
+    
+  private:
+    bool read(Records& records, bool keysOnly);
+    SBCWorkSpace& _workspace;
+    std::string _start;
+    std::string _end;
+    bool _includeStart;
+    bool _done;
+    std::size_t _batchSize;
+  };
+  
+  class Batch
+    /// Writes and deletes applied together by SBCWorkSpace::write().
+    ///
+    /// Operations are applied in the order they were added.  The workspace
+    /// is locked once for the whole batch and flushed to disk once at the
+    /// end instead of after every record.
+  {
+  public:
+    Batch();
+    void set(const std::string& key, const std::string& value);
+    void set(const std::string& key, const json::Object& value);
+    void del(const std::string& key);
+    void clear();
+    std::size_t size() const;
+    bool empty() const;
+    
+  private:
+    friend class SBCWorkSpace;
+    struct Operation
+    {
+      std::string key;
+      std::string value;
+      bool erase;
+    };
+    Operation& next();
+    std::vector<Operation> _operations;
+    std::size_t _count;
+      /// Operations in use.  Cleared entries are kept so their strings
+      /// are reused by the next batch.
+  };
+  
   SBCWorkSpace(const std::string& name);
   ~SBCWorkSpace();
   
@@ -22,6 +92,18 @@ public:
   bool get(const std::string& key, json::Object& value) const;
   bool del(const std::string& key);
   bool getKeys(const std::string& pattern, std::vector<std::string>& keys);
+    /// Returns the keys matching a glob pattern.  Only the range sharing the
+    /// literal prefix of the pattern is visited.  Prefer getKeysWithPrefix().
+  bool getKeysWithPrefix(const std::string& prefix, Keys& keys) const;
+  bool getRecordsWithPrefix(const std::string& prefix, Records& records) const;
+    /// Returns the keys and values of the records whose key starts with prefix
+  bool getRecordsInRange(const std::string& first, const std::string& last, Records& records, std::size_t limit = 0) const;
+    /// Returns the records in [first, last).  An empty last means no upper bound.
+  std::size_t delKeysWithPrefix(const std::string& prefix);
+    /// Deletes every record whose key starts with prefix and returns the count
+  bool write(const Batch& batch);
+    /// Applies the operations of batch and flushes the database once.
+    /// Returns false if any of the writes failed.
   bool open(const std::string& localDbFile);
   bool open();
   void close();
@@ -29,6 +111,8 @@ public:
   void setName(const std::string& name);
 
 private:
+  bool getRange(const std::string& start, bool includeStart, const std::string& end, std::size_t limit, Records& records, bool keysOnly) const;
+  
   mutable OSS::mutex_critic_sec _dbMutex;
   LocalDb _db;
   std::string _name;
@@ -22,8 +22,11 @@
 #define	_SIPDIGESTAUTH_H
 
 
+#include <map>
+#include <boost/noncopyable.hpp>
 #include "OSS/SIP/Parser.h"
 #include "OSS/UTL/CoreUtils.h"
+#include "OSS/UTL/Thread.h"
 
 
 namespace OSS {
@@ -33,6 +36,14 @@ namespace SIP {
 class OSS_API SIPDigestAuth
 {
 public:
+  enum
+  {
+    NONCE_BUCKET_SECONDS = 30,
+      /// Granularity of the time stamp carried by timed nonces
+    DEFAULT_NONCE_LIFETIME = 300
+      /// Seconds a timed nonce is accepted
+  };
+
   SIPDigestAuth();
     /// Creates a new digest authenticator
 
@@ -63,8 +74,64 @@ public:
     const std::string& a2);
     /// Create an authorization with QoP
   
+  static std::string digestCreateTimedNonce(const std::string& key);
+    /// Create a nonce that can be verified without keeping any state.
+    /// The nonce carries the time bucket it was created in followed by an
+    /// HMAC-SHA256 of the bucket and key using the secret key.  SBC
+    /// instances sharing the secret key accept each other's nonces.
+
+  static bool digestVerifyTimedNonce(const std::string& nonce, const std::string& key,
+    unsigned int lifetime = DEFAULT_NONCE_LIFETIME, bool* stale = 0);
+    /// Returns true if the nonce was created by digestCreateTimedNonce for
+    /// key less than lifetime seconds ago.  If stale is set it is true when
+    /// the nonce is authentic but has expired so the challenge can carry
+    /// stale=true.
+
   static void setSecretKey(const std::string& key);
-    /// Set the secret key used to generate nonce
+    /// Set the secret key used to generate nonce.  Timed nonces use a
+    /// random key generated at startup until this is called.
+};
+
+
+class OSS_API SIPDigestNonceCounter : boost::noncopyable
+  /// Rejects replayed nonce-count values.
+  ///
+  /// The highest nc seen for a nonce and user is kept together with a
+  /// WINDOW_SIZE bit mask of the ones below it so requests arriving out of
+  /// order are still accepted.  Entries are dropped one to two lifetimes
+  /// after they were last used by swapping two generations of the table.
+{
+public:
+  enum
+  {
+    WINDOW_SIZE = 64
+  };
+
+  explicit SIPDigestNonceCounter(unsigned int lifetime = SIPDigestAuth::DEFAULT_NONCE_LIFETIME);
+
+  bool accept(const std::string& nonce, const std::string& user, OSS::UInt32 nonceCount);
+    /// Returns false if nonceCount is 0, was already used, or fell out of
+    /// the window.  Otherwise it is recorded and true is returned.
+
+  void setLifetime(unsigned int lifetime);
+    /// Seconds the window of a nonce is kept.  Should match the nonce
+    /// lifetime.
+
+  std::size_t size() const;
+
+private:
+  struct Window
+  {
+    OSS::UInt32 highest;
+    OSS::UInt64 mask;
+  };
+  typedef std::map<std::string, Window> Windows;
+
+  mutable OSS::mutex_critic_sec _mutex;
+  Windows _current;
+  Windows _previous;
+  OSS::UInt64 _lifetime;
+  OSS::UInt64 _rotated;
 };
 
 
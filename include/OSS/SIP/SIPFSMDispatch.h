@@ -22,13 +22,14 @@
 #define SIP_SIPFSMDispatch_INCLUDED
 
 
-#include "OSS/UTL/Cache.h"
+#include "OSS/UTL/AutoExpireSet.h"
 #include "OSS/SIP/SIP.h"
 #include "OSS/SIP/SIPIctPool.h"
 #include "OSS/SIP/SIPNictPool.h"
 #include "OSS/SIP/SIPIstPool.h"
 #include "OSS/SIP/SIPNistPool.h"
 #include "OSS/SIP/SIPTransportService.h"
+#include "OSS/SIP/SIPOverloadControl.h"
 
 namespace OSS {
 namespace SIP {
@@ -120,7 +121,18 @@ public:
 
   bool getEnableIctForking() const;
     // Returns true if ICT forking is enabled
+
+  SIPOverloadControl& overloadControl();
+    /// Admission control applied to new dialogs before a transaction
+    /// is created for them
+
 private:
+  bool admitRequest(const SIPMessage::Ptr& pMsg, const SIPTransportSession::Ptr& pTransport, const std::string& id);
+    /// Returns false if the request was shed or is a retransmission or
+    /// an ACK of a shed request
+
+  void rejectRequest(const SIPMessage::Ptr& pMsg, const SIPTransportSession::Ptr& pTransport, const std::string& id);
+
   SIPTransportService _transport;
   SIPIctPool _ict;
   SIPNictPool _nict;
@@ -129,7 +141,11 @@ private:
   SIPTransaction::RequestCallback _requestHandler;
   SIPTransaction::ThrottleRequestCallback _throttleRequestHandler;
   UnknownTransactionCallback _ackOr2xxTransactionHandler;
-  StringPairCache _istBlocker;
+  OSS::UTL::AutoExpireSet<std::string> _istBlocker;
+  SIPOverloadControl _overload;
+  OSS::UTL::AutoExpireSet<std::string> _shedRequests;
+    /// Transactions of shed requests so their retransmissions get the
+    /// same answer and their ACK is absorbed
   bool _enableIctForking;
 };
 
@@ -148,6 +164,11 @@ inline bool SIPFSMDispatch::getEnableIctForking() const
   return _enableIctForking;
 }
 
+inline SIPOverloadControl& SIPFSMDispatch::overloadControl()
+{
+  return _overload;
+}
+
 inline SIPTransportService& SIPFSMDispatch::transport()
 {
   return _transport;
@@ -170,7 +191,7 @@ inline SIPFSMDispatch::UnknownTransactionCallback& SIPFSMDispatch::ackOr2xxTrans
 
 inline void SIPFSMDispatch::blockIst(const std::string& id)
 {
-  _istBlocker.add(id, id);
+  _istBlocker.insert(id);
 }
 
 } } // namespace OSS::SIP
@@ -33,6 +33,12 @@
 
 
 namespace OSS {
+namespace Metrics {
+
+class Counter;
+
+} // OSS::Metrics
+
 namespace SIP {
 
 
@@ -236,6 +242,9 @@ public:
 
   TransactionType getType() const;
 protected:
+  static OSS::Metrics::Counter& retransmissions();
+    /// Counter of requests sent again by the client transactions
+
   TransactionType _type;
   OSS_HANDLE _owner;  /// The transaction attached to the FSM.
                                  /// Take note that this can't be a share_ptr since it will 
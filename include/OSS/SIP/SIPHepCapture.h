@@ -0,0 +1,200 @@
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare 
+// derivative works of the Software, all subject to the 
+// "GNU Lesser General Public License (LGPL)".
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+
+#ifndef OSS_SIPHEPCAPTURE_H_INCLUDED
+#define	OSS_SIPHEPCAPTURE_H_INCLUDED
+
+
+#include <string>
+#include <vector>
+#include <boost/noncopyable.hpp>
+#include <boost/function.hpp>
+#include <boost/atomic.hpp>
+#include <boost/thread.hpp>
+#include <boost/asio.hpp>
+#include "OSS/OSS.h"
+#include "OSS/UTL/Thread.h"
+#include "OSS/Net/IPAddress.h"
+
+
+namespace OSS {
+namespace SIP {
+
+
+class SIPHepCapture : boost::noncopyable
+  /// Asynchronous Homer (HEP) capture pipeline.
+  ///
+  /// capture() is called from the SIP threads.  It copies the packet and its
+  /// addresses into a slot of a bounded lock-free ring and returns.  Encoding,
+  /// compression and the socket writes are done by a single capture thread
+  /// which drains the ring in batches of up to MAX_BATCH packets and sends
+  /// each batch with one sendmmsg() call.
+  ///
+  /// When the ring is full the packet is dropped and counted rather than
+  /// making the SIP thread wait.  Slot payload buffers are reused so the
+  /// capture path does not allocate once the ring has warmed up.
+{
+public:
+  typedef boost::function<void(void*, int)> Sender;
+    /// Optional replacement for the socket writes.  Called from the capture
+    /// thread with each encoded packet.
+
+  enum
+  {
+    DEFAULT_CAPACITY = 4096,
+    MAX_BATCH = 64,
+    FLUSH_INTERVAL_MS = 20
+  };
+
+  struct Stats
+  {
+    Stats();
+    OSS::UInt64 captured;
+      /// Number of packets queued by capture()
+    OSS::UInt64 dropped;
+      /// Number of packets dropped because the ring was full
+    OSS::UInt64 sent;
+      /// Number of encoded packets handed to the socket or the sender
+    OSS::UInt64 sendErrors;
+      /// Number of encoded packets the socket refused
+    OSS::UInt64 batches;
+      /// Number of batches flushed
+  };
+
+  SIPHepCapture(std::size_t capacity = DEFAULT_CAPACITY);
+    /// Creates the capture ring.  capacity is rounded up to a power of two.
+
+  ~SIPHepCapture();
+
+  bool start(const std::string& host, const std::string& port);
+    /// Resolves the collector address, opens the capture socket and starts
+    /// the capture thread.  Returns false if the address could not be
+    /// resolved or the socket could not be opened.
+
+  void stop();
+    /// Flushes the packets still in the ring and stops the capture thread
+
+  bool isRunning() const;
+
+  void setVersion(int version);
+    /// HEP version.  2 and 3 are supported.  Defaults to 3.
+
+  void setCaptureId(int captureId);
+
+  void setPassword(const std::string& password);
+
+  void setCompression(bool compress);
+    /// Compress payloads with zlib.  Only honored for HEPv3.
+
+  void setSender(const Sender& sender);
+    /// Must be called before start()
+
+  bool capture(OSS::Net::IPAddress::Protocol proto, const OSS::Net::IPAddress& srcAddress, const OSS::Net::IPAddress& dstAddress, const char* data, std::size_t len);
+    /// Queues a packet for capture.  Returns false if the packet was dropped.
+
+  std::size_t flush();
+    /// Encodes and sends up to MAX_BATCH queued packets.  Returns the number
+    /// of packets dequeued.  This is called by the capture thread and must
+    /// not be called concurrently with it.
+
+  Stats getStats() const;
+
+  std::size_t capacity() const;
+
+private:
+  struct Packet
+  {
+    OSS::UInt8 family;
+    OSS::UInt8 proto;
+    OSS::UInt8 srcAddr[16];
+    OSS::UInt8 dstAddr[16];
+    OSS::UInt16 srcPort;
+    OSS::UInt16 dstPort;
+    OSS::UInt32 timeSec;
+    OSS::UInt32 timeUsec;
+    std::string data;
+  };
+
+  struct Slot
+  {
+    boost::atomic<std::size_t> sequence;
+    Packet packet;
+  };
+
+  void run();
+  bool compress(const std::string& data, std::size_t& zippedLen);
+  void encodeV3(const Packet& packet, const char* payload, std::size_t len, bool zipped, std::string& out) const;
+  void encodeV2(const Packet& packet, std::string& out) const;
+  void send(std::size_t count);
+
+  Slot* _slots;
+  std::size_t _mask;
+  char _pad0[64];
+  boost::atomic<std::size_t> _enqueuePos;
+  char _pad1[64];
+  boost::atomic<std::size_t> _dequeuePos;
+  char _pad2[64];
+
+  boost::atomic<OSS::UInt64> _dropped;
+  boost::atomic<OSS::UInt64> _sent;
+  boost::atomic<OSS::UInt64> _sendErrors;
+  boost::atomic<OSS::UInt64> _batches;
+
+  int _version;
+  int _captureId;
+  std::string _password;
+  boost::atomic<bool> _compress;
+  Sender _sender;
+
+  //
+  // Capture thread state
+  //
+  std::vector<std::string> _encoded;
+  std::vector<OSS::UInt8> _zipped;
+  void* _zstream;
+  boost::asio::io_service _ioService;
+  boost::asio::ip::udp::socket _socket;
+  boost::asio::ip::udp::endpoint _destination;
+
+  OSS::semaphore _wake;
+  boost::atomic<bool> _stopping;
+  boost::thread* _pThread;
+};
+
+
+//
+// Inlines
+//
+
+inline bool SIPHepCapture::isRunning() const
+{
+  return _pThread != 0;
+}
+
+inline std::size_t SIPHepCapture::capacity() const
+{
+  return _mask + 1;
+}
+
+
+} } // OSS::SIP
+
+
+#endif // OSS_SIPHEPCAPTURE_H_INCLUDED
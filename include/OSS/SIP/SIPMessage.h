@@ -681,6 +681,13 @@ public:
   OSS_HANDLE& userData();
     /// Returns a reference to the user data
 
+  void setReceiveTime(OSS::UInt64 receiveTime);
+    /// Sets when the message arrived on the transport in monotonic
+    /// microseconds, see SIPOverloadControl::now()
+
+  OSS::UInt64 getReceiveTime() const;
+    /// Returns when the message arrived or zero if it was not received
+
   std::string createContextId(bool formatTabAndSpaces = false) const;
     /// Creates a 32 bit context id.  This is normally used for
     /// tagging transactions belonging to the same call-id.
@@ -767,6 +774,7 @@ protected:
   mutable boost::tribool _isRequest;
   CustomProperties _properties;
   OSS_HANDLE _userData;
+  OSS::UInt64 _receiveTime;
   std::string _idleBuffer;
   mutable std::string _logContext;
 };
@@ -811,6 +819,16 @@ inline OSS_HANDLE& SIPMessage::userData()
   return _userData;
 }
 
+inline void SIPMessage::setReceiveTime(OSS::UInt64 receiveTime)
+{
+  _receiveTime = receiveTime;
+}
+
+inline OSS::UInt64 SIPMessage::getReceiveTime() const
+{
+  return _receiveTime;
+}
+
 inline std::string SIPMessage::createLoggerData() const
 {
   return createLoggerData(const_cast<SIPMessage*>(this));
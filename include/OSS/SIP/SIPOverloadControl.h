@@ -0,0 +1,245 @@
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "GNU Lesser General Public License (LGPL)".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+
+#ifndef SIP_SIPOverloadControl_INCLUDED
+#define SIP_SIPOverloadControl_INCLUDED
+
+
+#include <string>
+#include <boost/noncopyable.hpp>
+#include "OSS/OSS.h"
+#include "OSS/UTL/Thread.h"
+#include "OSS/SIP/SIPMessage.h"
+
+
+namespace OSS {
+namespace SIP {
+
+
+class OSS_API SIPOverloadControl : boost::noncopyable
+  /// Admission control for requests that create dialogs.
+  ///
+  /// The application reports how long each request waited between its
+  /// arrival on the socket and the start of its processing.  At the end
+  /// of every interval the smallest delay seen is compared to the target.
+  /// A standing queue raises the minimum while a burst only raises the
+  /// tail.  While the minimum is above the target the percentage of new
+  /// dialogs that are shed grows by a step.  Otherwise it shrinks by a
+  /// smaller step.
+  ///
+  /// A worker pool without a queue starts every request it accepts at
+  /// once, so the minimum stays low while the pool is depleted.  The
+  /// interval then also counts as overloaded if the pool refused work and
+  /// the largest delay is above the target.  A pool that is merely busy
+  /// does not trigger shedding by itself.
+  ///
+  /// The same percentage is advertised to peers that announce support
+  /// for the RFC 7339 loss algorithm in their top Via.
+  ///
+  /// Times are monotonic microseconds.  Every method that depends on the
+  /// clock has an overload that takes the current time so simulations can
+  /// drive it.
+{
+public:
+  typedef OSS::UInt64 Time;
+
+  enum Action
+  {
+    REJECT,
+      /// Answer shed requests with a 503 and a Retry-After
+    DROP
+      /// Drop shed requests silently
+  };
+
+  enum
+  {
+    DEFAULT_TARGET_DELAY = 20000, // microseconds
+    DEFAULT_INTERVAL = 100, // milliseconds
+    DEFAULT_RETRY_AFTER = 5, // seconds
+    DEFAULT_MAX_REDUCTION = 95, // percent
+    REDUCTION_INCREASE = 10, // percent per interval
+    REDUCTION_DECREASE = 5, // percent per interval
+    MIN_FEEDBACK_VALIDITY = 500 // milliseconds
+  };
+
+  SIPOverloadControl();
+
+  void setEnabled(bool enabled);
+  bool isEnabled() const;
+
+  void setTargetDelay(Time delay);
+    /// Queueing delay in microseconds above which dialogs are shed
+  Time getTargetDelay() const;
+
+  void setInterval(unsigned long interval);
+    /// Milliseconds between two adjustments of the reduction
+  unsigned long getInterval() const;
+
+  void setAction(Action action);
+  Action getAction() const;
+
+  void setRetryAfter(unsigned int seconds);
+    /// Value of the Retry-After header of the 503
+  unsigned int getRetryAfter() const;
+
+  void setMaxReduction(unsigned int percent);
+    /// Upper bound of the reduction.  Keeping it below 100 lets a few
+    /// dialogs through to sample the delay.
+  unsigned int getMaxReduction() const;
+
+  void setFeedbackEnabled(bool enabled);
+    /// Add RFC 7339 parameters to the top Via of requests that ask for it
+  bool isFeedbackEnabled() const;
+
+  void reportQueueDelay(Time delay);
+  void reportQueueDelay(Time delay, Time now);
+    /// Called when a request starts to be processed with the time it
+    /// spent waiting for it
+
+  void reportSaturation();
+  void reportSaturation(Time now);
+    /// Called when a request could not be queued because no worker was
+    /// available.  The interval counts as overloaded if a request in it
+    /// also waited longer than the target.
+
+  bool admit();
+  bool admit(Time now);
+    /// Returns false if the next dialog creating request must be shed.
+    /// Shed requests are spread evenly through the admitted ones.
+
+  unsigned int getReduction() const;
+    /// Percentage of dialog creating requests currently shed
+
+  bool isShedding() const;
+
+  bool addFeedback(SIPMessage* pRequest) const;
+    /// Set the RFC 7339 parameters on the top Via of the request if the
+    /// sender announced support for the loss algorithm.  Responses copy
+    /// the Via so they carry the feedback back.  Returns true if the Via
+    /// was changed.
+
+  bool addFeedback(std::string& via) const;
+    /// Same as above for a single Via element
+
+  SIPMessage::Ptr createRejectResponse(const SIPMessage::Ptr& pRequest, const std::string& tag) const;
+    /// Build the 503 for a shed request.  The status line and the trailing
+    /// headers are formatted once when the settings change.  Only the
+    /// headers that identify the transaction are copied from the request.
+    /// The tag should be derived from the transaction so retransmissions
+    /// get the same response.
+
+  static bool supportsFeedback(const std::string& via);
+    /// Returns true if the Via has an oc parameter and its oc-algo lists the
+    /// loss algorithm, or lists no algorithm at all
+
+  static Time now();
+
+private:
+  void update(Time now);
+  void adjust(bool overloaded);
+  void formatTrailer();
+
+  mutable OSS::mutex_critic_sec _mutex;
+  bool _enabled;
+  Time _targetDelay;
+  Time _interval;
+  Action _action;
+  unsigned int _retryAfter;
+  unsigned int _maxReduction;
+  bool _feedbackEnabled;
+  unsigned int _reduction;
+  unsigned int _credit;
+    /// Accumulates the reduction for every request.  A request is shed
+    /// each time it crosses 100.
+  Time _intervalEnd;
+  Time _minDelay;
+  Time _maxDelay;
+  bool _hasDelay;
+  bool _saturated;
+  OSS::UInt64 _sequence;
+    /// oc-seq of the feedback.  Wall clock milliseconds of the last change.
+  std::string _trailer;
+};
+
+
+//
+// Inlines
+//
+
+inline bool SIPOverloadControl::isEnabled() const
+{
+  OSS::mutex_critic_sec_lock lock(_mutex);
+  return _enabled;
+}
+
+inline SIPOverloadControl::Time SIPOverloadControl::getTargetDelay() const
+{
+  OSS::mutex_critic_sec_lock lock(_mutex);
+  return _targetDelay;
+}
+
+inline unsigned long SIPOverloadControl::getInterval() const
+{
+  OSS::mutex_critic_sec_lock lock(_mutex);
+  return (unsigned long)(_interval / 1000);
+}
+
+inline SIPOverloadControl::Action SIPOverloadControl::getAction() const
+{
+  OSS::mutex_critic_sec_lock lock(_mutex);
+  return _action;
+}
+
+inline unsigned int SIPOverloadControl::getRetryAfter() const
+{
+  OSS::mutex_critic_sec_lock lock(_mutex);
+  return _retryAfter;
+}
+
+inline unsigned int SIPOverloadControl::getMaxReduction() const
+{
+  OSS::mutex_critic_sec_lock lock(_mutex);
+  return _maxReduction;
+}
+
+inline bool SIPOverloadControl::isFeedbackEnabled() const
+{
+  OSS::mutex_critic_sec_lock lock(_mutex);
+  return _feedbackEnabled;
+}
+
+inline void SIPOverloadControl::reportQueueDelay(Time delay)
+{
+  reportQueueDelay(delay, now());
+}
+
+inline void SIPOverloadControl::reportSaturation()
+{
+  reportSaturation(now());
+}
+
+inline bool SIPOverloadControl::admit()
+{
+  return admit(now());
+}
+
+} } // OSS::SIP
+
+#endif // SIP_SIPOverloadControl_INCLUDED
@@ -47,6 +47,7 @@
 #include "OSS/SIP/SIPTransaction.h"
 #include "OSS/SIP/SIPTransportService.h"
 #include "OSS/JSON/Json.h"
+#include "OSS/Metrics/InfluxExporter.h"
 
 
 namespace OSS {
@@ -193,6 +194,10 @@ public:
   
   std::string getTlsCertPassword() const;
     /// Returns the tlsCertPassword.  This is used internally by initializeTlsContext
+
+  OSS::Metrics::InfluxExporter& metricsExporter();
+    /// Returns the InfluxDB exporter started by the influxdb settings
+    /// in the transport configuration
 #if ENABLE_FEATURE_CONFIG
   bool initVirtualTransportFromConfig(const boost::filesystem::path& cfgFile);
     /// Initialize CARP virtual interface(s)
@@ -291,6 +296,9 @@ public:
 
   SIPTransportService& transport();
     /// Return a reference to the transport service
+
+  SIPOverloadControl& overloadControl();
+    /// Return the admission control applied to new dialogs
   
   void setTransportThreshold(
     unsigned long packetsPerSecondThreshold, // The total packets per second threshold
@@ -336,6 +344,8 @@ private:
   SubNets _tlsSubnets;
   
   std::string _tlsCertPassword;
+
+  OSS::Metrics::InfluxExporter _metricsExporter;
 };
 
 typedef SIPStack SIPStack;
@@ -400,6 +410,11 @@ inline void SIPStack::setAckOr2xxTransactionHandler(const SIPFSMDispatch::Unknow
   _fsmDispatch.ackOr2xxTransactionHandler() = handler;
 }
 
+inline SIPOverloadControl& SIPStack::overloadControl()
+{
+  return _fsmDispatch.overloadControl();
+}
+
 inline SIPTransportService& SIPStack::transport()
 {
   return _fsmDispatch.transport();
@@ -410,6 +425,11 @@ inline std::string SIPStack::getTlsCertPassword() const
   return _tlsCertPassword;
 }
 
+inline OSS::Metrics::InfluxExporter& SIPStack::metricsExporter()
+{
+  return _metricsExporter;
+}
+
 inline SIPTransaction::Ptr SIPStack::createClientTransaction(const SIPMessage::Ptr& pRequest)
 {
   return _fsmDispatch.createClientTransaction(pRequest);
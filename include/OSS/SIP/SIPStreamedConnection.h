@@ -31,6 +31,7 @@
 #include "OSS/SIP/SIP.h"
 #include "OSS/SIP/SIPMessage.h"
 #include "OSS/SIP/SIPTransportSession.h"
+#include "OSS/Net/TlsSessionCache.h"
 #include "OSS/UTL/Thread.h"
 
 
@@ -75,8 +76,11 @@ public:
       boost::asio::io_service& ioService,
       boost::asio::ssl::context* pTlsContext,
       SIPStreamedConnectionManager& manager,
-      SIPListener* pListener);
-    /// Creates a TLS connection using the given I/O service and TLS context
+      SIPListener* pListener,
+      OSS::Net::TlsSessionCache* pSessionCache = 0);
+    /// Creates a TLS connection using the given I/O service and TLS context.
+    /// If pSessionCache is set, client connections offer the session last
+    /// negotiated with the same peer and every handshake is counted.
   
   virtual ~SIPStreamedConnection();
     /// Destroys the TCP connection
@@ -155,6 +159,9 @@ protected:
   ssl_socket* _pTlsStream;
     /// SSL Socket for the connection.
 
+  OSS::Net::TlsSessionCache* _pSessionCache;
+    /// TLS session resumption cache.  May be null.
+
   boost::asio::ip::tcp::resolver _resolver;
     /// the TCP query resolver
 
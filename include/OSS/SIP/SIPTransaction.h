@@ -29,6 +29,7 @@
 #include "OSS/UTL/CoreUtils.h"
 #include "OSS/UTL/Thread.h"
 #include "OSS/UTL/PropertyMapObject.h"
+#include "OSS/UTL/MemoryArena.h"
 #include "OSS/Net/Net.h"
 #include "OSS/SIP/SIPTransportSession.h"
 #include "OSS/SIP/SIPMessage.h"
@@ -331,6 +332,14 @@ public:
   
   void markHasSent2xx();
   bool hasSent2xx() const;
+
+  OSS::UTL::MemoryArena& arena();
+    /// Returns the memory arena scoped to the lifetime of this transaction.
+    ///
+    /// Transaction properties are allocated from this arena.  Objects
+    /// that die together with the transaction may allocate from it as well
+    /// using OSS::UTL::ArenaAllocator.  The arena is released in one shot
+    /// when the last reference to the transaction goes away.
 protected:
   SIPTransaction::Callback _responseTU;
   SIPTransaction::TerminateCallback _terminateCallback;
@@ -364,6 +373,7 @@ private:
   SIPMessage::Ptr _pInitialRequest;
   bool _hasTerminated;
   bool _hasSent2xx;
+  OSS::UTL::MemoryArena _arena;
   friend class SIPTransactionPool;
   friend class SIPIstPool;
   friend class SIPNistPool;
@@ -486,6 +496,11 @@ inline bool SIPTransaction::hasSent2xx() const
   return _hasSent2xx;
 }
 
+inline OSS::UTL::MemoryArena& SIPTransaction::arena()
+{
+  return _arena;
+}
+
 } } // namespace OSS::SIP
 
 
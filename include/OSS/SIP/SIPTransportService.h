@@ -38,8 +38,10 @@
 #include "OSS/SIP/SIPWebSocketListener.h"
 #include "OSS/SIP/SIPWebSocketTlsListener.h"
 #include "OSS/SIP/SIPTLSListener.h"
+#include "OSS/SIP/SIPHepCapture.h"
 #include "OSS/EP/EndpointListener.h"
 #include "OSS/Net/TlsContext.h"
+#include "OSS/Net/TlsHandshakePool.h"
 
 
 namespace OSS {
@@ -288,6 +290,26 @@ public:
   
   TlsContext::Context tlsServerContextPtr();
   TlsContext::Context tlsClientContextPtr();
+
+  OSS::Net::TlsSessionCache& tlsSessionCache();
+    /// Session resumption cache and handshake counters of the TLS and WSS transports
+
+  boost::asio::io_service& tlsIoService();
+    /// Returns the io_service a new TLS connection should be created on.
+    /// This is a handshake pool thread if the pool is running.  Otherwise
+    /// it is the transport io_service.
+
+  void setTlsHandshakeThreads(std::size_t threadCount);
+    /// Number of threads TLS connections are served from.  Must be called
+    /// before run().  0 serves them from the transport io_service.
+
+#if ENABLE_FEATURE_WEBSOCKETS
+  void setWebSocketThreads(std::size_t threadCount);
+    /// Number of io_service threads each WS and WSS listener runs on.
+    /// Must be called before run().
+
+  std::size_t getWebSocketThreads() const;
+#endif
   
   SIPTransportSession::Dispatch& dispatch();
   
@@ -315,12 +337,17 @@ public:
   static const std::string& getHepPassword();
   static int getHepId();
   static void dumpHepPacket(OSS::Net::IPAddress::Protocol proto, const OSS::Net::IPAddress& srcAddress, const OSS::Net::IPAddress& dstAddress, const std::string& data);
-  static void hepSend(void* packet, int len);
+  static SIPHepCapture& hepCapture();
+    /// Returns the capture pipeline used by dumpHepPacket().  Packets are
+    /// encoded and sent by its own thread so capture does not add latency
+    /// to the SIP threads.
 
 private:
   boost::asio::io_service _ioService;
   boost::thread* _pIoServiceThread;
   boost::asio::ip::tcp::resolver _resolver;
+  OSS::Net::TlsHandshakePool _tlsHandshakePool;
+  std::size_t _tlsHandshakeThreads;
   
   TlsContext::Context _pTlsServerContext;
   TlsContext::Context _pTlsClientContext;
@@ -343,6 +370,7 @@ private:
   bool _wssEnabled;
   unsigned short _wsPortBase;
   unsigned short _wsPortMax;
+  std::size_t _wsThreads;
 #endif
   bool _udpEnabled;
   bool _tcpEnabled;
@@ -354,7 +382,6 @@ private:
 public:
   static bool _hepEnabled;
   static bool _hepCompressionEnabled;
-  static SIPUDPConnection::Ptr _hepConnection;
   static std::string _hepHost;
   static std::string _hepPort;
   static int _hepId;
@@ -474,6 +501,33 @@ inline SIPTransportService::TlsContext::Context SIPTransportService::tlsClientCo
   return _pTlsClientContext;
 }
 
+inline OSS::Net::TlsSessionCache& SIPTransportService::tlsSessionCache()
+{
+  return _tlsContext.sessionCache();
+}
+
+inline boost::asio::io_service& SIPTransportService::tlsIoService()
+{
+  return _tlsHandshakePool.next(_ioService);
+}
+
+inline void SIPTransportService::setTlsHandshakeThreads(std::size_t threadCount)
+{
+  _tlsHandshakeThreads = threadCount;
+}
+
+#if ENABLE_FEATURE_WEBSOCKETS
+inline void SIPTransportService::setWebSocketThreads(std::size_t threadCount)
+{
+  _wsThreads = threadCount;
+}
+
+inline std::size_t SIPTransportService::getWebSocketThreads() const
+{
+  return _wsThreads;
+}
+#endif
+
 inline SIPTransportSession::Dispatch& SIPTransportService::dispatch()
 {
   return _dispatch;
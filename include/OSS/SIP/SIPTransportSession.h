@@ -95,6 +95,15 @@ public:
     /// reliability of the transport for stream based connections.
     /// The default packet is CRLF/CRLF
 
+  virtual void absorbRetransmissions();
+    /// Called by a server transaction that must no longer answer
+    /// retransmissions of its request.  Only significant to UDP.
+
+  virtual void releaseRetransmissions();
+    /// Called by a server transaction when it terminates so that
+    /// retransmissions of its request reach the transaction layer again.
+    /// Only significant to UDP.
+
   virtual void start(const SIPTransportSession::Dispatch& dispatch) = 0;
     /// Start the first asynchronous operation for the connection.
 
@@ -266,6 +275,14 @@ inline bool SIPTransportSession::writeKeepAlive(const std::string& ip, const std
   return false;
 }
 
+inline void SIPTransportSession::absorbRetransmissions()
+{
+}
+
+inline void SIPTransportSession::releaseRetransmissions()
+{
+}
+
 inline void SIPTransportSession::setIdentifier(OSS::UInt64 identifier)
 {
   _identifier = identifier;
@@ -29,6 +29,7 @@
 #include "OSS/SIP/SIP.h"
 #include "OSS/SIP/SIPMessage.h"
 #include "OSS/SIP/SIPTransportSession.h"
+#include "OSS/SIP/SIPUDPRetransmissionCache.h"
 
 
 namespace OSS {
@@ -103,6 +104,14 @@ private:
 
   void handleServerHandshake(const boost::system::error_code& error);
 
+  bool replayRetransmission();
+    /// Answer the datagram in the buffer from the retransmission cache.
+    /// Returns true if it was a retransmission and needs no parsing.
+
+  void storeRetransmissionResponse(const SIPUDPRetransmissionCache::Digest& digest, const void* pOwner,
+    const SIPMessage::Ptr& pResponse, const std::string& ip, const std::string& port);
+    /// Remember the response sent for the request with the given digest
+
 protected:
 
   boost::asio::ip::udp::socket& _socket;
@@ -119,6 +128,12 @@ protected:
   SIPMessage::Ptr _pRequest;
     /// Incoming SIP Message parser
 
+  SIPUDPRetransmissionCache::Digest _digest;
+    /// Digest of the request in the buffer
+
+  SIPUDPRetransmissionCache _retransmissions;
+    /// Last responses sent for requests received on this socket
+
   friend class SIPUDPConnectionClone;
 };
 
@@ -67,6 +67,12 @@ public:
   OSS::Net::IPAddress getRemoteAddress() const;
     /// Returns the last read source address
 
+  void absorbRetransmissions();
+    /// Drop retransmissions of the request without replaying the last response
+
+  void releaseRetransmissions();
+    /// Let retransmissions of the request reach the transaction layer again
+
 private:
   void writeMessage(SIPMessage::Ptr msg);
     /// Send a SIP message using this transport.
@@ -97,6 +103,17 @@ protected:
     /// Incoming SIP Message parser
 
   SIPUDPConnection::Ptr _orginalConnection;
+
+  SIPUDPConnection* _pConnection;
+    /// The original connection as a UDP connection
+
+  SIPUDPRetransmissionCache::Digest _digest;
+    /// Digest of the request this clone was created for
+
+  bool _hasRetransmissionResponse;
+    /// True once a response to the request was stored in the cache
+
+  bool _hasReleasedRetransmissions;
 };
 
 
@@ -0,0 +1,120 @@
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare 
+// derivative works of the Software, all subject to the 
+// "GNU Lesser General Public License (LGPL)".
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+
+#ifndef SIP_SIPUDPRetransmissionCache_INCLUDED
+#define SIP_SIPUDPRetransmissionCache_INCLUDED
+
+
+#include <string>
+#include <boost/asio.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/unordered_map.hpp>
+#include "OSS/OSS.h"
+#include "OSS/UTL/Thread.h"
+
+
+namespace OSS {
+namespace SIP {
+
+
+class OSS_API SIPUDPRetransmissionCache : boost::noncopyable
+  /// Remembers the last response sent for a request received over UDP
+  /// so a byte identical retransmission of the request can be answered
+  /// before it is parsed.
+  ///
+  /// Requests are identified by a digest of the raw datagram and of the
+  /// address that sent it.  The server transaction stores the response
+  /// when it sends one and releases the entry when it terminates.  An
+  /// entry may also be marked absorbed, in which case retransmissions are
+  /// dropped without a reply.  Entries that were never released expire
+  /// after the longest lifetime of a server transaction.
+{
+public:
+  typedef boost::asio::ip::udp::endpoint EndPoint;
+  typedef boost::shared_ptr<std::string> Bytes;
+
+  struct Digest
+  {
+    Digest() : key(0), check(0), length(0) {}
+    OSS::UInt64 key;
+    OSS::UInt64 check;
+    std::size_t length;
+      /// Zero if the datagram was not a request
+    bool isValid() const { return length != 0; }
+  };
+
+  enum
+  {
+    DEFAULT_LIFETIME = 300000, // milliseconds
+    PURGE_INTERVAL = 1000
+  };
+
+  SIPUDPRetransmissionCache(unsigned long lifetime = DEFAULT_LIFETIME);
+    /// Creates an empty cache whose entries expire after lifetime milliseconds
+
+  ~SIPUDPRetransmissionCache();
+
+  static Digest computeDigest(const char* data, std::size_t length, const EndPoint& sender);
+    /// Returns the digest of a datagram.  Responses and datagrams too short
+    /// to be a request return an invalid digest.
+
+  bool lookup(const Digest& digest, Bytes& response, EndPoint& target);
+    /// Returns true if the datagram is a retransmission of a request that
+    /// has a live server transaction.  response is set to the bytes to
+    /// replay, or reset if the retransmission must only be absorbed.
+
+  void store(const Digest& digest, const void* pOwner, const std::string& response, const EndPoint& target);
+    /// Set the response replayed to retransmissions of the request
+
+  void absorb(const Digest& digest, const void* pOwner);
+    /// Keep dropping retransmissions of the request but stop replying
+
+  void release(const Digest& digest, const void* pOwner);
+    /// Forget the request.  Only the owner that stored it may release it.
+
+  std::size_t size() const;
+    /// Returns the number of requests remembered
+
+  void clear();
+
+private:
+  struct Entry
+  {
+    OSS::UInt64 check;
+    std::size_t length;
+    const void* pOwner;
+    Bytes response;
+    EndPoint target;
+    OSS::UInt64 expires;
+  };
+  typedef boost::unordered_map<OSS::UInt64, Entry> Entries;
+
+  void purge(OSS::UInt64 now);
+
+  mutable OSS::mutex_critic_sec _mutex;
+  Entries _entries;
+  unsigned long _lifetime;
+  OSS::UInt64 _nextPurge;
+};
+
+
+} } // OSS::SIP
+#endif // SIP_SIPUDPRetransmissionCache_INCLUDED
@@ -76,6 +76,12 @@ public:
 
 	typedef boost::shared_ptr<SIPWebSocketListener> Ptr;
 
+	enum
+	{
+	  DEFAULT_THREAD_COUNT = 2
+	    /// Number of io_service threads of a WS or WSS listener
+	};
+
 	// Handler for new websocket connections. This will just accept the connection
 	// and pass it to the connection manager
 	class ServerAcceptHandler : public websocketpp::server::handler
@@ -27,6 +27,7 @@
 
 #include <vector>
 #include "boost/array.hpp"
+#include "boost/asio/buffer.hpp"
 #include "OSS/OSS.h"
 #include "OSS/SIP/SIP.h"
 #include "OSS/RTP/RTPPacket.h"
@@ -40,7 +41,17 @@ class OSS_API SIPXOR
 {
 public:
 
+  struct MutableSpan
+    /// Packet handed to the in-place external handlers.  The handler may
+    /// change size as long as it does not exceed capacity.
+  {
+    char* data;
+    std::size_t size;
+    std::size_t capacity;
+  };
+
   typedef boost::function<void (std::vector<char>&)> EncryptFunc;
+  typedef boost::function<void (MutableSpan&)> SpanFunc;
 
   static void setKey(const char* key);
     /// Set the two byte XOR key
@@ -60,16 +71,37 @@ public:
   static void sipDecrypt(boost::array<char, OSS_SIP_MAX_PACKET_SIZE>& packet, size_t& len);
     /// Decrypt a byte array
 
+  static void sipEncrypt(const boost::asio::mutable_buffer& buffer, size_t& len);
+    /// Encrypt the first len bytes of an asio buffer in place
+
+  static void sipDecrypt(const boost::asio::mutable_buffer& buffer, size_t& len);
+    /// Decrypt the first len bytes of an asio buffer in place
+
   static void rtpEncrypt(boost::array<char, RTP_PACKET_BUFFER_SIZE>& packet, size_t& len);
     /// Encrypt a byte array
 
   static void rtpDecrypt(boost::array<char, RTP_PACKET_BUFFER_SIZE>& packet, size_t& len);
     /// Decrypt a byte array
 
+  static void xorInPlace(char* data, std::size_t len, const char* key);
+    /// XOR len bytes with the two byte key.  Even bytes use key[0] and odd
+    /// bytes key[1] except for the last byte of an odd sized packet of 3
+    /// bytes or more which uses key[1].  This matches what deployed clients
+    /// expect.  Uses AVX2 or SSE2 when available.
+
+  static SpanFunc rtpEncryptInPlace;
+  static SpanFunc rtpDecryptInPlace;
+  static SpanFunc sipEncryptInPlace;
+  static SpanFunc sipDecryptInPlace;
+    /// External handlers working on the packet buffer.  They take
+    /// precedence over the EncryptFunc handlers.
+
   static EncryptFunc rtpEncryptExternal;
   static EncryptFunc rtpDecryptExternal;
   static EncryptFunc sipEncryptExternal;
   static EncryptFunc sipDecryptExternal;
+    /// External handlers working on a copy of the packet.  Prefer the
+    /// SpanFunc handlers which avoid the copy.
 };
 
 } } // OSS::SIP
@@ -1,98 +1,386 @@
-/*
- * To change this license header, choose License Headers in Project Properties.
- * To change this template file, choose Tools | Templates
- * and open the template in the editor.
- */
-
-/* 
- * File:   AutoExpireMap.h
- * Author: joegen
- *
- * Created on February 26, 2018, 8:27 PM
- */
-
-#ifndef OSS_AUTOEXPIREMAP_H_INCLUDED
-#define OSS_AUTOEXPIREMAP_H_INCLUDED
-
-#include <multimap>
-#include <set>
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "GNU Lesser General Public License (LGPL)".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+#ifndef OSS_AUTOEXPIRESET_H_INCLUDED
+#define OSS_AUTOEXPIRESET_H_INCLUDED
+
+#include <vector>
+#include <time.h>
+#include <boost/cstdint.hpp>
+#include <boost/functional/hash.hpp>
+#include <boost/noncopyable.hpp>
 #include "OSS/UTL/Thread.h"
-#include "OSS/UTL/CoreUtils.h"
 
 
 namespace OSS {
 namespace UTL {
-  
-  
-template<typename Value>
-class AutoExpireSet : boost::non_copyable
+
+
+template <typename Value, typename Hash = boost::hash<Value> >
+class AutoExpireSet : boost::noncopyable
+  /// A set whose values disappear a fixed number of milliseconds after
+  /// they were inserted.
+  ///
+  /// Values are spread over shards that each have their own lock.  The
+  /// shard count is rounded up to a power of two.  A shard is an open
+  /// addressing table with linear probing and the expiry of each value is
+  /// stored next to it, so a lookup is a hash and a short probe with no
+  /// allocation.  Expired values are purged a time bucket at a time
+  /// from a ring of slot indexes, piggybacked on insert and has.  A value
+  /// that expired but was not purged yet is already reported as absent.
 {
-private:
-  typedef std::multimap<OSS::UInt64, Value> Map;
-  typedef std::set<Value> Set;
-  
 public:
-  AutoExpireSet(unsigned long expire) :
-    _expire(expire)
+  typedef boost::uint64_t Time;
+
+  enum
+  {
+    DEFAULT_SHARDS = 16,
+    RING_SIZE = 64,
+    INITIAL_CAPACITY = 64
+  };
+
+  AutoExpireSet(unsigned long expire, std::size_t shards = DEFAULT_SHARDS) :
+    _expire(expire ? expire : 1),
+    _shardCount(1)
+  {
+    while (_shardCount < shards)
+    {
+      _shardCount <<= 1;
+    }
+    //
+    // A value lands in the bucket of its expiry.  The ring must cover the
+    // buckets from the last one purged up to now + expire.
+    //
+    _granularity = (_expire + RING_SIZE - 3) / (RING_SIZE - 2);
+    Time tick = now() / _granularity;
+    _shards = new Shard[_shardCount];
+    for (std::size_t i = 0; i < _shardCount; i++)
+    {
+      _shards[i].slots.resize(INITIAL_CAPACITY);
+      _shards[i].ring.resize(RING_SIZE);
+      _shards[i].purged = tick ? tick - 1 : 0;
+    }
+  }
+
+  ~AutoExpireSet()
   {
+    delete [] _shards;
   }
-  
-  std::size_t insert(const Value& value)
+
+  bool insert(const Value& value)
+    /// Insert a value or restart the expiry of a value already in the set.
+    /// Returns true if the value was not in the set.
   {
-    OSS::mutex_critic_sec_lock lock(_mutex);
-    purge();
-    if (_set.find(value == _set.end()))
+    std::size_t hash = hashOf(value);
+    Shard& shard = shardOf(hash);
+    OSS::mutex_critic_sec_lock lock(shard.mutex);
+    Time current = now();
+    purge(shard, current);
+
+    std::size_t index = find(shard, value, hash);
+    if (index != NPOS)
+    {
+      Slot& slot = shard.slots[index];
+      bool expired = slot.expires <= current;
+      slot.expires = current + _expire;
+      track(shard, index);
+      return expired;
+    }
+
+    if ((shard.count + shard.tombstones + 1) * 4 > shard.slots.size() * 3)
+    {
+      std::size_t capacity = shard.slots.size();
+      while ((shard.count + 1) * 2 > capacity)
+      {
+        capacity <<= 1;
+      }
+      rehash(shard, capacity, current);
+    }
+
+    std::size_t mask = shard.slots.size() - 1;
+    index = hash & mask;
+    while (shard.slots[index].state == SLOT_FULL)
+    {
+      index = (index + 1) & mask;
+    }
+    Slot& slot = shard.slots[index];
+    if (slot.state == SLOT_DELETED)
     {
-      _set.insert(value);
-      _map.insert(std::pair<OSS::UInt64, Value>(OSS::getTime() + _expire, value));
+      shard.tombstones--;
     }
-    return _set.size();
+    slot.value = value;
+    slot.hash = hash;
+    slot.expires = current + _expire;
+    slot.state = SLOT_FULL;
+    shard.count++;
+    track(shard, index);
+    return true;
   }
-  
+
   bool has(const Value& value) const
+    /// Returns true if the value is in the set and did not expire
   {
-    OSS::mutex_critic_sec_lock lock(_mutex);
-    purge();
-    return _set.find(value != _set.end());
+    std::size_t hash = hashOf(value);
+    Shard& shard = shardOf(hash);
+    OSS::mutex_critic_sec_lock lock(shard.mutex);
+    Time current = now();
+    purge(shard, current);
+    std::size_t index = find(shard, value, hash);
+    return index != NPOS && shard.slots[index].expires > current;
+  }
+
+  bool erase(const Value& value)
+    /// Remove a value before it expires.  Returns true if it was found.
+  {
+    std::size_t hash = hashOf(value);
+    Shard& shard = shardOf(hash);
+    OSS::mutex_critic_sec_lock lock(shard.mutex);
+    std::size_t index = find(shard, value, hash);
+    if (index == NPOS)
+    {
+      return false;
+    }
+    remove(shard, index);
+    return true;
   }
-  
+
   std::size_t size() const
+    /// Returns the number of values in the set.  Values that expired
+    /// within the last purge interval may still be counted.
   {
-    OSS::mutex_critic_sec_lock lock(_mutex);
-    purge();
-    return _set.size();
+    std::size_t total = 0;
+    Time current = now();
+    for (std::size_t i = 0; i < _shardCount; i++)
+    {
+      OSS::mutex_critic_sec_lock lock(_shards[i].mutex);
+      purge(_shards[i], current);
+      total += _shards[i].count;
+    }
+    return total;
   }
-  
+
   void clear()
   {
-    OSS::mutex_critic_sec_lock lock(_mutex);
-    _map.clear();
-    _set.clear();
+    for (std::size_t i = 0; i < _shardCount; i++)
+    {
+      Shard& shard = _shards[i];
+      OSS::mutex_critic_sec_lock lock(shard.mutex);
+      std::vector<Slot>(INITIAL_CAPACITY).swap(shard.slots);
+      for (typename Ring::iterator iter = shard.ring.begin(); iter != shard.ring.end(); iter++)
+      {
+        iter->clear();
+      }
+      shard.count = 0;
+      shard.tombstones = 0;
+    }
+  }
+
+  unsigned long getExpire() const
+  {
+    return _expire;
   }
-  
+
 private:
-  void purge()
+  enum SlotState
+  {
+    SLOT_EMPTY,
+    SLOT_FULL,
+    SLOT_DELETED
+  };
+
+  static const std::size_t NPOS = ~(std::size_t)0;
+
+  struct Slot
+  {
+    Slot() : expires(0), hash(0), state(SLOT_EMPTY) {}
+    Value value;
+    Time expires;
+    std::size_t hash;
+    unsigned char state;
+  };
+
+  typedef std::vector<boost::uint32_t> Bucket;
+  typedef std::vector<Bucket> Ring;
+
+  struct Shard
+  {
+    Shard() : count(0), tombstones(0), purged(0) {}
+    OSS::mutex_critic_sec mutex;
+    std::vector<Slot> slots;
+    Ring ring;
+      /// Slot indexes keyed by expiry bucket.  An index may be stale if the
+      /// value was refreshed or erased.  Purge checks the slot itself.
+    std::size_t count;
+    std::size_t tombstones;
+    Time purged;
+      /// Last bucket whose values were purged
+  };
+
+  static Time now()
+  {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (Time)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+  }
+
+  static std::size_t hashOf(const Value& value)
+  {
+    //
+    // Finalize the hash so both the shard and the probe start are well
+    // mixed even if Hash is weak in its low bits
+    //
+    boost::uint64_t hash = Hash()(value);
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    hash *= 0xc4ceb9fe1a85ec53ULL;
+    hash ^= hash >> 33;
+    return (std::size_t)hash;
+  }
+
+  Shard& shardOf(std::size_t hash) const
+  {
+    //
+    // The low bits pick the probe start so the shard uses the high bits
+    //
+    return _shards[(hash >> (sizeof(std::size_t) * 8 - 16)) & (_shardCount - 1)];
+  }
+
+  std::size_t find(const Shard& shard, const Value& value, std::size_t hash) const
+  {
+    std::size_t mask = shard.slots.size() - 1;
+    for (std::size_t index = hash & mask;; index = (index + 1) & mask)
+    {
+      const Slot& slot = shard.slots[index];
+      if (slot.state == SLOT_EMPTY)
+      {
+        return NPOS;
+      }
+      if (slot.state == SLOT_FULL && slot.hash == hash && slot.value == value)
+      {
+        return index;
+      }
+    }
+  }
+
+  void track(Shard& shard, std::size_t index) const
+  {
+    shard.ring[(shard.slots[index].expires / _granularity) % RING_SIZE].push_back((boost::uint32_t)index);
+  }
+
+  void remove(Shard& shard, std::size_t index) const
+  {
+    //
+    // A slot followed by an empty one ends every probe through it so it
+    // can be emptied instead of leaving a tombstone
+    //
+    std::size_t mask = shard.slots.size() - 1;
+    if (shard.slots[(index + 1) & mask].state == SLOT_EMPTY)
+    {
+      shard.slots[index].state = SLOT_EMPTY;
+    }
+    else
+    {
+      shard.slots[index].state = SLOT_DELETED;
+      shard.tombstones++;
+    }
+    shard.count--;
+  }
+
+  void purge(Shard& shard, Time current) const
+  {
+    Time tick = current / _granularity;
+    if (tick <= shard.purged + 1)
+    {
+      return;
+    }
+    //
+    // Buckets before the current one have fully expired.  If the shard
+    // was idle longer than a revolution, one pass over the ring suffices.
+    //
+    Time first = shard.purged + 1;
+    if (tick - first > RING_SIZE)
+    {
+      first = tick - RING_SIZE;
+    }
+    for (Time t = first; t < tick; t++)
+    {
+      Bucket& bucket = shard.ring[t % RING_SIZE];
+      for (Bucket::iterator iter = bucket.begin(); iter != bucket.end(); iter++)
+      {
+        Slot& slot = shard.slots[*iter];
+        if (slot.state == SLOT_FULL && slot.expires <= current)
+        {
+          remove(shard, *iter);
+        }
+      }
+      bucket.clear();
+    }
+    shard.purged = tick - 1;
+  }
+
+  void rehash(Shard& shard, std::size_t capacity, Time current) const
   {
-    OSS::UInt64 now = OSS::getTime() - 1;
-    while (!_map.empty())
+    std::vector<Slot> slots(capacity);
+    std::size_t mask = capacity - 1;
+    for (typename Ring::iterator iter = shard.ring.begin(); iter != shard.ring.end(); iter++)
+    {
+      iter->clear();
+    }
+    shard.count = 0;
+    shard.tombstones = 0;
+    for (typename std::vector<Slot>::iterator iter = shard.slots.begin(); iter != shard.slots.end(); iter++)
     {
-      Map::iterator iter = _map.upper_bound(now);
-      if (iter == _map.end())
+      if (iter->state != SLOT_FULL || iter->expires <= current)
       {
-        break;
+        continue;
+      }
+      std::size_t index = iter->hash & mask;
+      while (slots[index].state == SLOT_FULL)
+      {
+        index = (index + 1) & mask;
+      }
+      Slot& slot = slots[index];
+      std::swap(slot.value, iter->value);
+      slot.hash = iter->hash;
+      slot.expires = iter->expires;
+      slot.state = SLOT_FULL;
+      shard.count++;
+    }
+    shard.slots.swap(slots);
+    for (std::size_t index = 0; index < capacity; index++)
+    {
+      if (shard.slots[index].state == SLOT_FULL)
+      {
+        track(shard, index);
       }
-      _set.erase(iter->second);
-      _map.erase(iter);
     }
   }
-  
-  unsigned long _expire;
-  mutable OSS::mutex_critic_sec _mutex;
-  Map _map;
-  Set _set;
+
+  Time _expire;
+  Time _granularity;
+    /// Milliseconds covered by one ring bucket
+  std::size_t _shardCount;
+  Shard* _shards;
 };
-  
-} } // OSS::UTL
 
-#endif // OSS_AUTOEXPIREMAP_H_INCLUDED
 
+} } // OSS::UTL
+
+#endif // OSS_AUTOEXPIRESET_H_INCLUDED
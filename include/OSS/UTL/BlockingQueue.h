@@ -22,134 +22,212 @@
 #define OSS_BLOCKINGQUEUE_H_INCLUDED
 
 #include <queue>
+#include <deque>
+#include <vector>
+#include <limits>
+#include <cassert>
 #include <boost/noncopyable.hpp>
 #include <boost/function.hpp>
 #include <boost/bind.hpp>
+#include <boost/atomic.hpp>
+#include <boost/thread/condition_variable.hpp>
 #include "OSS/UTL/Thread.h"
 #include <unistd.h>
+#include <semaphore.h>
+#include <sys/eventfd.h>
 
 namespace OSS {
 
 template <class T>
 class BlockingQueue : boost::noncopyable
+  /// Multi producer, multi consumer FIFO.
+  ///
+  /// Consumers block on a condition variable that is only signalled when
+  /// a consumer is actually waiting.  When usePipe is set the queue also
+  /// owns an eventfd that can be polled.  It is readable while the queue
+  /// holds elements and is only written when the queue goes from empty to
+  /// non-empty, so producers do not pay a system call per element.
+  ///
+  /// The default backend is a deque guarded by a mutex.  The ring backend
+  /// is a bounded lock-free array whose capacity is maxSize rounded up to
+  /// a power of two.  Producers and consumers of the ring only touch the
+  /// mutex when a consumer is asleep.  The ring does not support copy(),
+  /// its capacity can not be changed with setMaxSize() and the observers
+  /// are called outside of any lock.
 {
 public:
   typedef boost::function<bool(BlockingQueue<T>&, const T&)> QueueObserver;
   
-  BlockingQueue(bool usePipe = false, std::size_t maxSize = SEM_VALUE_MAX - 1) :
-    _sem(0, SEM_VALUE_MAX),
+  enum Backend
+  {
+    BACKEND_DEQUE,
+    BACKEND_RING
+  };
+  
+  enum
+  {
+    MAX_RING_SIZE = 1 << 20
+  };
+  
+  BlockingQueue(bool usePipe = false, std::size_t maxSize = SEM_VALUE_MAX - 1, Backend backend = BACKEND_DEQUE) :
+    _fd(-1),
     _usePipe(usePipe),
-    _maxSize(maxSize)
+    _maxSize(maxSize),
+    _waiters(0),
+    _cells(0),
+    _mask(0),
+    _size(0),
+    _signalled(false)
   {
     if (_usePipe)
     {
-      assert(pipe(_pipe) == 0);
+      _fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+      assert(_fd != -1);
+    }
+    
+    if (backend == BACKEND_RING)
+    {
+      std::size_t capacity = 2;
+      while (capacity < maxSize && capacity < MAX_RING_SIZE)
+      {
+        capacity <<= 1;
+      }
+      _cells = new Cell[capacity];
+      for (std::size_t i = 0; i < capacity; i++)
+      {
+        _cells[i].sequence.store(i, boost::memory_order_relaxed);
+      }
+      _mask = capacity - 1;
+      _maxSize = capacity;
+      _enqueuePos.store(0, boost::memory_order_relaxed);
+      _dequeuePos.store(0, boost::memory_order_relaxed);
     }
   }
   
   ~BlockingQueue()
   {
-    if (_usePipe)
+    if (_fd != -1)
     {
-      close(_pipe[0]);
-      close(_pipe[1]);
+      close(_fd);
     }
+    delete [] _cells;
   }
 
   bool enqueue(T data)
   {
-    _cs.lock();
-    
-    if (_maxSize && _queue.size() >= _maxSize)
+    if (_cells)
     {
-      _cs.unlock();
-      return false;
+      return enqueueRing(data);
     }
     
-    if (_enqueueObserver && !_enqueueObserver(*this, data))
+    bool wake = false;
     {
-      _cs.unlock();
-      return false;
+      mutex_critic_sec_lock lock(_cs);
+      if (_maxSize && _queue.size() >= _maxSize)
+      {
+        return false;
+      }
+
+      if (_enqueueObserver && !_enqueueObserver(*this, data))
+      {
+        return false;
+      }
+      
+      bool wasEmpty = _queue.empty();
+      _queue.push_back(data);
+      if (wasEmpty)
+      {
+        signalFd();
+        wake = _waiters.load(boost::memory_order_relaxed) > 0;
+      }
     }
-    _queue.push_back(data);
-    if (_usePipe)
+    
+    if (wake)
     {
-      std::size_t w = 0;
-      w = write(_pipe[1], " ", 1);
-      (void)w;
+      _cond.notify_one();
     }
-    _cs.unlock();
-    _sem.set();
     return true;
   }
 
   void dequeue(T& data)
   {
-    _sem.wait();
-    _cs.lock();
-    if (_usePipe)
+    pop(data, -1);
+  }
+
+  bool try_dequeue(T& data, long milliseconds)
+  {
+    return pop(data, milliseconds);
+  }
+  
+  std::size_t dequeueAll(std::vector<T>& items)
+    /// Blocks until the queue is not empty then moves every queued element
+    /// to the end of items.  Returns the number of elements moved.
+  {
+    return dequeueBatch(items, std::numeric_limits<std::size_t>::max(), -1);
+  }
+  
+  std::size_t dequeueBatch(std::vector<T>& items, std::size_t maxCount, long milliseconds = -1)
+    /// Waits up to milliseconds for an element, forever if negative, then
+    /// moves up to maxCount elements to the end of items without waiting
+    /// for more.  Returns the number of elements moved.
+  {
+    if (!maxCount)
     {
-      std::size_t r = 0;
-      char buf[1];
-      r = read(_pipe[0], buf, 1);
-      (void)r;
+      return 0;
     }
-    if (!_queue.empty())
+    
+    if (_cells)
     {
-      data = _queue.front();
-      _queue.pop_front();
-      if (_dequeueObserver)
+      T data;
+      if (!pop(data, milliseconds))
+      {
+        return 0;
+      }
+      items.push_back(data);
+      std::size_t count = 1;
+      while (count < maxCount && popRing(data))
       {
-        _dequeueObserver(*this, data);
+        items.push_back(data);
+        count++;
       }
+      return count;
     }
-    _cs.unlock();
-  }
-
-  bool try_dequeue(T& data, long milliseconds)
-  {
-    if (!_sem.tryWait(milliseconds))
-      return false;
-
-    _cs.lock();
-    if (_usePipe)
+    
+    boost::unique_lock<mutex_critic_sec> lock(_cs);
+    if (!waitLocked(lock, milliseconds))
     {
-      std::size_t r = 0;
-      char buf[1];
-      r = read(_pipe[0], buf, 1);
-      (void)r;
+      return 0;
     }
-    if (!_queue.empty())
+    
+    std::size_t count = 0;
+    while (count < maxCount && !_queue.empty())
     {
-      data = _queue.front();
+      items.push_back(_queue.front());
       _queue.pop_front();
       if (_dequeueObserver)
       {
-        _dequeueObserver(*this, data);
+        _dequeueObserver(*this, items.back());
       }
+      count++;
     }
-    else
-    {
-      _cs.unlock();
-      return false;
-    }
-    _cs.unlock();
-
-    return true;
+    afterPopLocked();
+    return count;
   }
   
   std::size_t size() const
   {
-    std::size_t ret = 0;
-    _cs.lock();
-    ret = _queue.size();
-    _cs.unlock();
-    return ret;
+    if (_cells)
+    {
+      long size = _size.load(boost::memory_order_relaxed);
+      return size > 0 ? size : 0;
+    }
+    mutex_critic_sec_lock lock(_cs);
+    return _queue.size();
   }
   
   int getFd() const
   {
-    return _usePipe ? _pipe[0] : 0;
+    return _usePipe ? _fd : 0;
   }
   
   void setEnqueueObserver(const QueueObserver& observer)
@@ -164,44 +242,324 @@ public:
   
   void copy(std::deque<T>& content)
   {
-    _cs.lock();
+    if (_cells)
+    {
+      return;
+    }
+    mutex_critic_sec_lock lock(_cs);
     std::copy(_queue.begin(), _queue.end(),  std::back_inserter(content));
-    _cs.unlock();
   }
   
   void clear()
   {
-    while(size() != 0)
+    T data;
+    while (pop(data, 0))
     {
-      T data;
-      dequeue(data);
     }
   }
   
   void setMaxSize(std::size_t maxSize)
   {
-    _cs.lock();
+    if (_cells)
+    {
+      return;
+    }
+    mutex_critic_sec_lock lock(_cs);
     _maxSize = maxSize;
-    _cs.unlock();
   }
   
   std::size_t getMaxSize() const
   {
     return _maxSize;
   }
+  
 private:
-  OSS::semaphore _sem;
-  mutable OSS::mutex_critic_sec _cs;
+  struct Cell
+  {
+    boost::atomic<std::size_t> sequence;
+    T data;
+  };
+  
+  struct Position
+  {
+    boost::atomic<std::size_t> value;
+    char pad[64 - sizeof(boost::atomic<std::size_t>)];
+    
+    std::size_t load(boost::memory_order order) const
+    {
+      return value.load(order);
+    }
+    
+    void store(std::size_t pos, boost::memory_order order)
+    {
+      value.store(pos, order);
+    }
+    
+    bool compare_exchange_weak(std::size_t& expected, std::size_t desired)
+    {
+      return value.compare_exchange_weak(expected, desired, boost::memory_order_relaxed);
+    }
+  };
+  
+  void signalFd()
+  {
+    if (_fd != -1)
+    {
+      OSS::UInt64 one = 1;
+      ssize_t w = write(_fd, &one, sizeof(one));
+      (void)w;
+    }
+  }
+  
+  void clearFd()
+  {
+    if (_fd != -1)
+    {
+      OSS::UInt64 count = 0;
+      ssize_t r = read(_fd, &count, sizeof(count));
+      (void)r;
+    }
+  }
+  
+  bool waitLocked(boost::unique_lock<mutex_critic_sec>& lock, long milliseconds)
+  {
+    if (!_queue.empty() || !milliseconds)
+    {
+      return !_queue.empty();
+    }
+    
+    _waiters.fetch_add(1);
+    if (milliseconds < 0)
+    {
+      while (_queue.empty())
+      {
+        _cond.wait(lock);
+      }
+    }
+    else
+    {
+      boost::system_time deadline = boost::get_system_time() + boost::posix_time::milliseconds(milliseconds);
+      while (_queue.empty() && _cond.timed_wait(lock, deadline))
+      {
+      }
+    }
+    _waiters.fetch_sub(1);
+    return !_queue.empty();
+  }
+  
+  void afterPopLocked()
+  {
+    if (_queue.empty())
+    {
+      clearFd();
+    }
+    else if (_waiters.load(boost::memory_order_relaxed) > 0)
+    {
+      //
+      // Producers only wake one consumer on the empty to non-empty
+      // transition.  Pass the wakeup along while elements remain.
+      //
+      _cond.notify_one();
+    }
+  }
+  
+  bool pop(T& data, long milliseconds)
+  {
+    if (_cells)
+    {
+      if (popRing(data))
+      {
+        return true;
+      }
+      return milliseconds ? waitRing(data, milliseconds) : false;
+    }
+    
+    boost::unique_lock<mutex_critic_sec> lock(_cs);
+    if (!waitLocked(lock, milliseconds))
+    {
+      return false;
+    }
+    data = _queue.front();
+    _queue.pop_front();
+    if (_dequeueObserver)
+    {
+      _dequeueObserver(*this, data);
+    }
+    afterPopLocked();
+    return true;
+  }
+  
+  bool enqueueRing(T& data)
+  {
+    if (_enqueueObserver && !_enqueueObserver(*this, data))
+    {
+      return false;
+    }
+    
+    Cell* pCell;
+    std::size_t pos = _enqueuePos.load(boost::memory_order_relaxed);
+    for (;;)
+    {
+      pCell = &_cells[pos & _mask];
+      std::size_t sequence = pCell->sequence.load(boost::memory_order_acquire);
+      long diff = (long)sequence - (long)pos;
+      if (diff == 0)
+      {
+        if (_enqueuePos.compare_exchange_weak(pos, pos + 1))
+        {
+          break;
+        }
+      }
+      else if (diff < 0)
+      {
+        return false;
+      }
+      else
+      {
+        pos = _enqueuePos.load(boost::memory_order_relaxed);
+      }
+    }
+    pCell->data = data;
+    pCell->sequence.store(pos + 1, boost::memory_order_release);
+    _size.fetch_add(1, boost::memory_order_relaxed);
+    
+    //
+    // Pairs with the increment of _waiters in waitRing().  Either the
+    // consumer sees the element or we see the consumer.
+    //
+    boost::atomic_thread_fence(boost::memory_order_seq_cst);
+    if (_usePipe && !_signalled.exchange(true))
+    {
+      signalFd();
+    }
+    if (_waiters.load(boost::memory_order_relaxed) > 0)
+    {
+      mutex_critic_sec_lock lock(_cs);
+      _cond.notify_one();
+    }
+    return true;
+  }
+  
+  bool ringEmpty() const
+  {
+    for (;;)
+    {
+      std::size_t pos = _dequeuePos.load(boost::memory_order_relaxed);
+      std::size_t sequence = _cells[pos & _mask].sequence.load(boost::memory_order_acquire);
+      long diff = (long)sequence - (long)(pos + 1);
+      if (diff == 0)
+      {
+        return false;
+      }
+      if (diff < 0)
+      {
+        return true;
+      }
+    }
+  }
+  
+  bool popRing(T& data)
+  {
+    Cell* pCell;
+    std::size_t pos = _dequeuePos.load(boost::memory_order_relaxed);
+    for (;;)
+    {
+      pCell = &_cells[pos & _mask];
+      std::size_t sequence = pCell->sequence.load(boost::memory_order_acquire);
+      long diff = (long)sequence - (long)(pos + 1);
+      if (diff == 0)
+      {
+        if (_dequeuePos.compare_exchange_weak(pos, pos + 1))
+        {
+          break;
+        }
+      }
+      else if (diff < 0)
+      {
+        return false;
+      }
+      else
+      {
+        pos = _dequeuePos.load(boost::memory_order_relaxed);
+      }
+    }
+    data = pCell->data;
+    pCell->data = T();
+    pCell->sequence.store(pos + _mask + 1, boost::memory_order_release);
+    _size.fetch_sub(1, boost::memory_order_relaxed);
+    
+    if (_dequeueObserver)
+    {
+      _dequeueObserver(*this, data);
+    }
+    
+    if (_usePipe && ringEmpty())
+    {
+      //
+      // Drain the eventfd before clearing the flag so a producer that
+      // found the flag set is covered by the check that follows
+      //
+      clearFd();
+      _signalled.store(false);
+      boost::atomic_thread_fence(boost::memory_order_seq_cst);
+      if (!ringEmpty() && !_signalled.exchange(true))
+      {
+        signalFd();
+      }
+    }
+    return true;
+  }
+  
+  bool waitRing(T& data, long milliseconds)
+  {
+    boost::unique_lock<mutex_critic_sec> lock(_cs);
+    _waiters.fetch_add(1);
+    bool ok = true;
+    if (milliseconds < 0)
+    {
+      while (!popRing(data))
+      {
+        _cond.wait(lock);
+      }
+    }
+    else
+    {
+      boost::system_time deadline = boost::get_system_time() + boost::posix_time::milliseconds(milliseconds);
+      while (!popRing(data))
+      {
+        if (!_cond.timed_wait(lock, deadline))
+        {
+          ok = popRing(data);
+          break;
+        }
+      }
+    }
+    _waiters.fetch_sub(1);
+    return ok;
+  }
+  
+  mutable mutex_critic_sec _cs;
+  boost::condition_variable _cond;
   std::deque<T> _queue;
-  int _pipe[2];
+  int _fd;
   bool _usePipe;
   QueueObserver _enqueueObserver;
   QueueObserver _dequeueObserver;
   std::size_t _maxSize;
+  boost::atomic<int> _waiters;
+  
+  //
+  // Ring backend
+  //
+  Cell* _cells;
+  std::size_t _mask;
+  Position _enqueuePos;
+  Position _dequeuePos;
+  boost::atomic<long> _size;
+  boost::atomic<bool> _signalled;
 };
 
 } // OSS
 
 #endif //OSS_BLOCKINGQUEUE_H_INCLUDED
 
-
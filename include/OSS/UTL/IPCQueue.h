@@ -32,9 +32,7 @@
 #include <boost/thread.hpp>
 #include <boost/noncopyable.hpp>
 
-#include "OSS/JSON/reader.h"
-#include "OSS/JSON/writer.h"
-#include "OSS/JSON/elements.h"
+#include "OSS/JSON/Json.h"
 
 namespace OSS {
 
@@ -372,34 +370,17 @@ public:
     std::string buff;
     if (IPCQueue::read(buff, blocking))
     {
-       try
-      {
-        std::stringstream strm;
-        strm << buff;
-        json::Reader::Read(params, strm);
-        return true;
-      }
-      catch(std::exception& error)
-      {
-        return false;
-      }
+      OSS::JSON::Exception error;
+      return OSS::JSON::json_parse(buff.data(), buff.size(), params, error);
     }
     return false;
   }
 
   bool write(const json::Object& params, bool blocking  = true)
   {
-    try
-    {
-      std::ostringstream strm;
-      json::Writer::Write(params, strm);
-      std::string buff = strm.str();
-      return IPCQueue::write(buff, blocking);
-    }
-    catch(std::exception& error)
-    {
-      return false;
-    }
+    std::string buff;
+    OSS::JSON::json_object_to_string(params, buff);
+    return IPCQueue::write(buff, blocking);
   }
 
   //
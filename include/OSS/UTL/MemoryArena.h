@@ -0,0 +1,217 @@
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "GNU Lesser General Public License (LGPL)".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+
+#ifndef OSS_MEMORYARENA_H_INCLUDED
+#define OSS_MEMORYARENA_H_INCLUDED
+
+
+#include <string>
+#include <map>
+#include <memory>
+#include <new>
+#include <boost/noncopyable.hpp>
+#include <boost/type_traits/alignment_of.hpp>
+#include "OSS/OSS.h"
+#include "OSS/UTL/Thread.h"
+
+
+namespace OSS {
+namespace UTL {
+
+
+class OSS_API MemoryArena : boost::noncopyable
+  /// A monotonic memory resource.
+  ///
+  /// Memory is carved out of heap chunks by bumping a pointer.  Individual
+  /// deallocation is a no-op.  All memory handed out by the arena is returned
+  /// to the heap in one shot by release() or by the destructor.  This is meant
+  /// for objects that die together, like the strings and map nodes owned
+  /// by a single SIP transaction.
+  ///
+  /// The arena keeps allocation counters both per instance and process wide
+  /// so that the number of heap allocations per call can be measured.
+{
+public:
+  struct Stats
+  {
+    Stats();
+    OSS::UInt64 allocations;
+      /// Number of allocate() calls served by the arena
+    OSS::UInt64 bytesAllocated;
+      /// Total bytes requested through allocate()
+    OSS::UInt64 heapAllocations;
+      /// Number of chunks requested from the heap
+    OSS::UInt64 heapBytes;
+      /// Total bytes of chunks requested from the heap
+    OSS::UInt64 releases;
+      /// Number of calls to release() that returned memory to the heap
+  };
+
+  enum
+  {
+    DEFAULT_CHUNK_SIZE = 1024,
+    MAX_CHUNK_SIZE = 64 * 1024
+  };
+
+  explicit MemoryArena(std::size_t initialChunkSize = DEFAULT_CHUNK_SIZE);
+    /// Creates a new arena.  No memory is reserved until the first allocation.
+
+  ~MemoryArena();
+    /// Returns all chunks to the heap
+
+  void* allocate(std::size_t size, std::size_t alignment = sizeof(void*));
+    /// Returns a block of at least size bytes aligned to alignment.
+    /// Throws std::bad_alloc if the heap is exhausted.
+
+  void deallocate(void* ptr, std::size_t size);
+    /// Does nothing.  Memory is reclaimed by release()
+
+  void release();
+    /// Returns all chunks to the heap.  All pointers previously returned
+    /// by allocate() are invalidated.  The arena remains usable.
+
+  Stats getStats() const;
+    /// Returns the counters of this arena
+
+  static Stats getGlobalStats();
+    /// Returns the counters aggregated across all arenas in the process
+
+private:
+  struct Chunk
+  {
+    Chunk* next;
+    std::size_t size;
+  };
+
+  void* allocateChunk(std::size_t size, std::size_t alignment);
+
+  mutable OSS::mutex_critic_sec _mutex;
+  Chunk* _chunks;
+  char* _current;
+  char* _end;
+  std::size_t _nextChunkSize;
+  std::size_t _initialChunkSize;
+  Stats _stats;
+};
+
+
+template <typename T>
+class ArenaAllocator
+  /// Standard allocator adapter for MemoryArena.
+  ///
+  /// A default constructed allocator (or one created with a null arena)
+  /// falls back to the global heap so containers using it remain usable
+  /// outside the scope of an arena.
+{
+public:
+  typedef T value_type;
+  typedef T* pointer;
+  typedef const T* const_pointer;
+  typedef T& reference;
+  typedef const T& const_reference;
+  typedef std::size_t size_type;
+  typedef std::ptrdiff_t difference_type;
+
+  template <typename U>
+  struct rebind
+  {
+    typedef ArenaAllocator<U> other;
+  };
+
+  ArenaAllocator() : _pArena(0)
+  {
+  }
+
+  ArenaAllocator(MemoryArena* pArena) : _pArena(pArena)
+  {
+  }
+
+  template <typename U>
+  ArenaAllocator(const ArenaAllocator<U>& other) : _pArena(other.arena())
+  {
+  }
+
+  pointer allocate(size_type n, const void* = 0)
+  {
+    if (_pArena)
+      return static_cast<pointer>(_pArena->allocate(n * sizeof(T), boost::alignment_of<T>::value));
+    return static_cast<pointer>(::operator new(n * sizeof(T)));
+  }
+
+  void deallocate(pointer p, size_type n)
+  {
+    if (_pArena)
+      _pArena->deallocate(p, n * sizeof(T));
+    else
+      ::operator delete(p);
+  }
+
+  size_type max_size() const
+  {
+    return static_cast<size_type>(-1) / sizeof(T);
+  }
+
+  pointer address(reference x) const
+  {
+    return &x;
+  }
+
+  const_pointer address(const_reference x) const
+  {
+    return &x;
+  }
+
+  void construct(pointer p, const T& value)
+  {
+    new (static_cast<void*>(p)) T(value);
+  }
+
+  void destroy(pointer p)
+  {
+    p->~T();
+  }
+
+  MemoryArena* arena() const
+  {
+    return _pArena;
+  }
+
+private:
+  MemoryArena* _pArena;
+};
+
+template <typename T, typename U>
+inline bool operator == (const ArenaAllocator<T>& a, const ArenaAllocator<U>& b)
+{
+  return a.arena() == b.arena();
+}
+
+template <typename T, typename U>
+inline bool operator != (const ArenaAllocator<T>& a, const ArenaAllocator<U>& b)
+{
+  return a.arena() != b.arena();
+}
+
+typedef std::basic_string<char, std::char_traits<char>, ArenaAllocator<char> > ArenaString;
+
+
+} } // OSS::UTL
+
+#endif // OSS_MEMORYARENA_H_INCLUDED
@@ -22,16 +22,49 @@
 
 #include "OSS/UTL/PropertyMap.h"
 #include "OSS/UTL/Thread.h"
+#include "OSS/UTL/MemoryArena.h"
 #include <map>
 #include <string>
+#include <cstring>
 
 namespace OSS {
 
 class PropertyMapObject
 {
 public:
-  typedef std::map<std::string, std::string> InternalProperties;
+  typedef OSS::UTL::ArenaString ArenaString;
+
+  class PropertyKey
+    /// Name of a property.  A key built for a lookup borrows the bytes of
+    /// the caller so nothing is allocated.  The copy stored in the map is
+    /// made to own its bytes, allocated like the rest of the map.
+  {
+  public:
+    PropertyKey(const char* data, std::size_t size,
+      const OSS::UTL::ArenaAllocator<char>& allocator = OSS::UTL::ArenaAllocator<char>());
+
+    void own() const;
+      /// Copies the borrowed bytes into the key
+
+    const char* data() const;
+    std::size_t size() const;
+    bool operator < (const PropertyKey& key) const;
+
+  private:
+    mutable ArenaString _name;
+    mutable const char* _data;
+      /// Borrowed bytes.  Zero once the key owns them in _name.
+    std::size_t _size;
+  };
+
+  typedef OSS::UTL::ArenaAllocator<std::pair<const PropertyKey, ArenaString> > InternalAllocator;
+  typedef std::map<PropertyKey, ArenaString, std::less<PropertyKey>, InternalAllocator> InternalProperties;
   PropertyMapObject();
+  explicit PropertyMapObject(OSS::UTL::MemoryArena* pArena);
+    /// Creates a property map that allocates its storage from pArena.
+    /// The arena must outlive the properties or clearProperties()
+    /// must be called before the arena is released.
+
   PropertyMapObject(const PropertyMapObject& copy);
   PropertyMapObject& operator = (const PropertyMapObject& copy);
   void swap(PropertyMapObject& copy);
@@ -67,6 +100,15 @@ public:
     /// Remove all custom properties
   
 protected:
+  static void assignProperties(InternalProperties& target, const InternalProperties& source);
+    /// Replace the content of target with a copy of source using the allocator of target
+
+  static void setProperty(InternalProperties& properties, const char* property, std::size_t propertySize,
+    const char* value, std::size_t valueSize);
+    /// Inserts or overwrites a property.  Only a new entry allocates its
+    /// key.  A value that outgrows its buffer at least doubles it so an
+    /// arena does not keep growing with every update.
+
   InternalProperties _internalProperties;
   mutable OSS::mutex_read_write _internalPropertiesMutex;
 };
@@ -74,6 +116,40 @@ protected:
 //
 // Inlines
 //
+inline PropertyMapObject::PropertyKey::PropertyKey(const char* data, std::size_t size,
+  const OSS::UTL::ArenaAllocator<char>& allocator) :
+  _name(allocator),
+  _data(data),
+  _size(size)
+{
+}
+
+inline void PropertyMapObject::PropertyKey::own() const
+{
+  if (_data)
+  {
+    _name.assign(_data, _size);
+    _data = 0;
+  }
+}
+
+inline const char* PropertyMapObject::PropertyKey::data() const
+{
+  return _data ? _data : _name.data();
+}
+
+inline std::size_t PropertyMapObject::PropertyKey::size() const
+{
+  return _size;
+}
+
+inline bool PropertyMapObject::PropertyKey::operator < (const PropertyKey& key) const
+{
+  std::size_t size = _size < key._size ? _size : key._size;
+  int result = size ? memcmp(data(), key.data(), size) : 0;
+  return result < 0 || (result == 0 && _size < key._size);
+}
+
 inline bool PropertyMapObject::getProperty(PropertyMap::Enum   property, std::string& value) const
 {
   return getProperty(PropertyMap::propertyString(property), value);
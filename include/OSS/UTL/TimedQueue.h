@@ -1,151 +1,412 @@
 #ifndef TIMEDQUEUE_H
 #define	TIMEDQUEUE_H
 
-#include <map>
 #include <string>
+#include <vector>
+#include <time.h>
 #include <boost/any.hpp>
-#include <boost/asio.hpp>
+#include <boost/cstdint.hpp>
 #include <boost/bind.hpp>
 #include <boost/function.hpp>
 #include <boost/thread.hpp>
+#include <boost/noncopyable.hpp>
 
 namespace OSS {
 
 
 
-class TimedQueue
+class TimedQueue : boost::noncopyable
+  /// Keyed records that expire after a number of seconds.
+  ///
+  /// Deadlines are kept in a hashed timing wheel driven by one thread.
+  /// Enqueue, erase and expiry are constant time.  Records live in
+  /// intrusive nodes that are recycled through a free list, so a steady
+  /// stream of short lived records does not allocate.  Each tick detaches
+  /// every record that is due and calls their handlers after the lock is
+  /// released, so a handler may enqueue or erase records.
 {
 public:
   typedef boost::recursive_mutex mutex;
   typedef boost::lock_guard<mutex> mutex_lock;
   typedef boost::function<void(const std::string&, const boost::any&)>  TimedQueueHandler;
-  struct TimedQueueRecord
-  {
-    TimedQueueRecord() :
-      deadline(0)
-    {
-    }
+  typedef boost::uint64_t Time;
 
-    ~TimedQueueRecord()
-    {
-      if (deadline)
-      {
-        deadline->cancel();
-        delete deadline;
-      }
-    }
-    std::string id;
-    boost::any data;
-    boost::asio::deadline_timer* deadline;
-    TimedQueueHandler deadlineFunc;
+  enum
+  {
+    DEFAULT_TICK = 100, // milliseconds
+    DEFAULT_WHEEL_SIZE = 512,
+    NODE_CHUNK_SIZE = 256
   };
 
-  TimedQueue() :
-     _ioService()
+  TimedQueue(unsigned int tick = DEFAULT_TICK, std::size_t wheelSize = DEFAULT_WHEEL_SIZE) :
+    _tickInterval(tick ? tick : 1),
+    _tick(0),
+    _count(0),
+    _pFree(0)
   {
-    housekeeper = new boost::asio::deadline_timer(_ioService, boost::posix_time::milliseconds(3600 * 1000));
-    housekeeper->expires_from_now(boost::posix_time::milliseconds(3600 * 1000));
-    housekeeper->async_wait(boost::bind(&TimedQueue::onHousekeeping, this, boost::asio::placeholders::error));
-
-    _thread = new boost::thread(boost::bind(&boost::asio::io_service::run, &_ioService));
+    std::size_t size = 1;
+    while (size < wheelSize)
+    {
+      size <<= 1;
+    }
+    _wheel.resize(size, 0);
+    _buckets.resize(64, 0);
+    _start = now();
+    _thread = new boost::thread(boost::bind(&TimedQueue::run, this));
   }
 
   ~TimedQueue()
   {
-    _ioService.stop();
+    _thread->interrupt();
     _thread->join();
     delete _thread;
-    delete housekeeper;
+    for (std::vector<Node*>::iterator iter = _chunks.begin(); iter != _chunks.end(); iter++)
+    {
+      delete [] *iter;
+    }
   }
 
   void enqueue(const std::string& id, const boost::any& data, const TimedQueueHandler& deadlineFunc, int expires)
   {
     mutex_lock lock(_mutex);
-    _map.erase(id);
-    TimedQueueRecord record;
-    _map[id] = record;
-    _map[id].id = id;
-    _map[id].data = data;
-    _map[id].deadlineFunc = deadlineFunc;
-    boost::asio::deadline_timer* timer = new boost::asio::deadline_timer(_ioService, boost::posix_time::milliseconds(expires * 1000));
-    _map[id].deadline = timer;
-    timer->expires_from_now(boost::posix_time::milliseconds(expires * 1000));
-    timer->async_wait(boost::bind(&TimedQueue::onRecordExpire, this, boost::asio::placeholders::error, id));
+    Node* pNode = insert(id);
+    pNode->data = data;
+    pNode->deadlineFunc = deadlineFunc;
+    schedule(pNode, (Time)expires * 1000);
   }
 
   void enqueue(const std::string& id, const boost::any& data)
   {
     mutex_lock lock(_mutex);
-    _map.erase(id);
-    TimedQueueRecord record;
-    record.id = id;
-    record.data = data;
-    _map[id] = record;
+    Node* pNode = insert(id);
+    pNode->data = data;
   }
-  
+
   void erase(const std::string& id)
   {
     mutex_lock lock(_mutex);
-    _map.erase(id);
+    Node* pNode = remove(id);
+    if (pNode)
+    {
+      release(pNode);
+    }
   }
 
   bool dequeue(const std::string& id, boost::any& data)
   {
     mutex_lock lock(_mutex);
-    if (_map.find(id) == _map.end())
+    Node* pNode = remove(id);
+    if (!pNode)
       return false;
-    data = _map[id].data;
-    _map.erase(id);
+    data = pNode->data;
+    release(pNode);
     return true;
   }
 
   bool get(const std::string& id, boost::any& data)
   {
     mutex_lock lock(_mutex);
-    if (_map.find(id) == _map.end())
+    Node* pNode = find(id);
+    if (!pNode)
       return false;
-    data = _map[id].data;
+    data = pNode->data;
     return true;
   }
-  
+
+  std::size_t size()
+  {
+    mutex_lock lock(_mutex);
+    return _count;
+  }
+
+  unsigned int getTickInterval() const
+  {
+    return _tickInterval;
+  }
+
 protected:
-  void onRecordExpire(const boost::system::error_code& e, const std::string& id)
+  struct Node
+  {
+    std::string id;
+    boost::any data;
+    TimedQueueHandler deadlineFunc;
+    std::size_t hash;
+    Node* hashNext;
+    Node* prev;
+      /// Previous node of the wheel slot.  Zero for the head of the slot.
+    Node* next;
+      /// Next node of the wheel slot, or of the free list
+    std::size_t slot;
+    std::size_t rounds;
+      /// Wheel revolutions left before the node is due
+    bool scheduled;
+  };
+
+  static Time now()
+  {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (Time)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+  }
+
+  static std::size_t hashOf(const std::string& id)
   {
-    if (!e)
+    std::size_t hash = 2166136261u;
+    for (std::string::const_iterator iter = id.begin(); iter != id.end(); iter++)
     {
-    
-      _mutex.lock();
-      if (_map.find(id) == _map.end())
+      hash = (hash ^ (unsigned char)*iter) * 16777619u;
+    }
+    return hash;
+  }
+
+  Node* allocate()
+  {
+    if (!_pFree)
+    {
+      Node* pChunk = new Node[NODE_CHUNK_SIZE];
+      _chunks.push_back(pChunk);
+      for (std::size_t i = 0; i < NODE_CHUNK_SIZE; i++)
       {
-        _mutex.unlock();
-        return;
+        pChunk[i].next = _pFree;
+        _pFree = &pChunk[i];
       }
+    }
+    Node* pNode = _pFree;
+    _pFree = pNode->next;
+    pNode->hashNext = 0;
+    pNode->prev = 0;
+    pNode->next = 0;
+    pNode->rounds = 0;
+    pNode->slot = 0;
+    pNode->scheduled = false;
+    return pNode;
+  }
+
+  void release(Node* pNode)
+  {
+    //
+    // The id keeps its capacity for the next record.  The data and the
+    // handler may hold references so they are cleared now.
+    //
+    pNode->data = boost::any();
+    pNode->deadlineFunc.clear();
+    pNode->next = _pFree;
+    _pFree = pNode;
+  }
 
-      TimedQueueHandler deadlineFunc = _map[id].deadlineFunc;
-      boost::any data = _map[id].data;
-      _map.erase(id);
-      _mutex.unlock();
+  Node* find(const std::string& id)
+  {
+    std::size_t hash = hashOf(id);
+    for (Node* pNode = _buckets[hash & (_buckets.size() - 1)]; pNode; pNode = pNode->hashNext)
+    {
+      if (pNode->hash == hash && pNode->id == id)
+        return pNode;
+    }
+    return 0;
+  }
 
+  Node* insert(const std::string& id)
+  {
+    Node* pNode = find(id);
+    if (pNode)
+    {
       //
-      // mutex is no longer locked.  This callback may reinsert the item to the queue without deadlock
+      // Replacing a record also replaces its deadline
       //
-      deadlineFunc(id, data);
+      unschedule(pNode);
+      pNode->deadlineFunc.clear();
+      return pNode;
     }
+
+    if (_count >= _buckets.size())
+    {
+      rehash(_buckets.size() * 2);
+    }
+
+    pNode = allocate();
+    pNode->id = id;
+    pNode->hash = hashOf(id);
+    Node*& bucket = _buckets[pNode->hash & (_buckets.size() - 1)];
+    pNode->hashNext = bucket;
+    bucket = pNode;
+    _count++;
+    return pNode;
   }
 
-  void onHousekeeping(const boost::system::error_code&)
+  Node* remove(const std::string& id)
   {
-    housekeeper->expires_from_now(boost::posix_time::milliseconds(3600 * 1000));
-    housekeeper->async_wait(boost::bind(&TimedQueue::onHousekeeping, this, boost::asio::placeholders::error));
+    std::size_t hash = hashOf(id);
+    for (Node** ppNode = &_buckets[hash & (_buckets.size() - 1)]; *ppNode; ppNode = &(*ppNode)->hashNext)
+    {
+      Node* pNode = *ppNode;
+      if (pNode->hash == hash && pNode->id == id)
+      {
+        *ppNode = pNode->hashNext;
+        unschedule(pNode);
+        _count--;
+        return pNode;
+      }
+    }
+    return 0;
+  }
+
+  void rehash(std::size_t size)
+  {
+    std::vector<Node*> buckets(size, 0);
+    for (std::size_t i = 0; i < _buckets.size(); i++)
+    {
+      Node* pNode = _buckets[i];
+      while (pNode)
+      {
+        Node* pNext = pNode->hashNext;
+        Node*& bucket = buckets[pNode->hash & (size - 1)];
+        pNode->hashNext = bucket;
+        bucket = pNode;
+        pNode = pNext;
+      }
+    }
+    _buckets.swap(buckets);
+  }
+
+  void schedule(Node* pNode, Time milliseconds)
+  {
+    //
+    // Round the deadline up to the tick that follows it.  A deadline that
+    // already passed fires on the next tick.
+    //
+    Time target = (now() - _start + milliseconds + _tickInterval - 1) / _tickInterval;
+    if (target <= _tick)
+    {
+      target = _tick + 1;
+    }
+    pNode->slot = target & (_wheel.size() - 1);
+    pNode->rounds = (target - _tick - 1) / _wheel.size();
+    pNode->prev = 0;
+    pNode->next = _wheel[pNode->slot];
+    if (pNode->next)
+    {
+      pNode->next->prev = pNode;
+    }
+    _wheel[pNode->slot] = pNode;
+    pNode->scheduled = true;
   }
-  boost::asio::io_service _ioService;
+
+  void unschedule(Node* pNode)
+  {
+    if (!pNode->scheduled)
+    {
+      return;
+    }
+    if (pNode->prev)
+    {
+      pNode->prev->next = pNode->next;
+    }
+    else
+    {
+      _wheel[pNode->slot] = pNode->next;
+    }
+    if (pNode->next)
+    {
+      pNode->next->prev = pNode->prev;
+    }
+    pNode->prev = 0;
+    pNode->next = 0;
+    pNode->scheduled = false;
+  }
+
+  void expire(Time tick, std::vector<Node*>& expired)
+  {
+    Node* pNode = _wheel[tick & (_wheel.size() - 1)];
+    while (pNode)
+    {
+      Node* pNext = pNode->next;
+      if (pNode->rounds)
+      {
+        pNode->rounds--;
+      }
+      else
+      {
+        remove(pNode->id);
+        expired.push_back(pNode);
+      }
+      pNode = pNext;
+    }
+  }
+
+  void run()
+  {
+    std::vector<Node*> expired;
+    try
+    {
+      for (;;)
+      {
+        Time elapsed = now() - _start;
+        Time due = (_tick + 1) * _tickInterval;
+        if (elapsed < due)
+        {
+          boost::this_thread::sleep(boost::posix_time::milliseconds(due - elapsed));
+          continue;
+        }
+
+        {
+          mutex_lock lock(_mutex);
+          //
+          // Catch up on the ticks missed while the thread was not scheduled
+          //
+          while ((_tick + 1) * _tickInterval <= elapsed)
+          {
+            _tick++;
+            expire(_tick, expired);
+          }
+        }
+
+        if (expired.empty())
+        {
+          continue;
+        }
+
+        //
+        // mutex is no longer locked.  These callbacks may reinsert the items to the queue without deadlock
+        //
+        for (std::vector<Node*>::iterator iter = expired.begin(); iter != expired.end(); iter++)
+        {
+          if ((*iter)->deadlineFunc)
+          {
+            (*iter)->deadlineFunc((*iter)->id, (*iter)->data);
+          }
+        }
+
+        mutex_lock lock(_mutex);
+        for (std::vector<Node*>::iterator iter = expired.begin(); iter != expired.end(); iter++)
+        {
+          release(*iter);
+        }
+        expired.clear();
+      }
+    }
+    catch (const boost::thread_interrupted&)
+    {
+      mutex_lock lock(_mutex);
+      for (std::vector<Node*>::iterator iter = expired.begin(); iter != expired.end(); iter++)
+      {
+        release(*iter);
+      }
+    }
+  }
+
+  unsigned int _tickInterval;
+  Time _start;
+  Time _tick;
+    /// Last tick processed by the wheel thread
+  std::vector<Node*> _wheel;
+  std::vector<Node*> _buckets;
+  std::size_t _count;
+  Node* _pFree;
+  std::vector<Node*> _chunks;
   boost::thread* _thread;
-  boost::asio::deadline_timer* housekeeper;
-  boost::recursive_mutex _mutex;
-  std::map<std::string, TimedQueueRecord> _map;
+  mutex _mutex;
 };
 
 }
 
 #endif	/* TIMEDQUEUE_H */
-
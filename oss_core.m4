@@ -234,6 +234,14 @@ AC_ARG_ENABLE([sip-test],
     [ENABLE_FEATURE(COMPILE_SIPTEST)],
     [DISABLE_FEATURE(COMPILE_SIPTEST)])
 
+#
+# Enable Benchmark compilation
+#
+AC_ARG_ENABLE([benchmarks],
+    AC_HELP_STRING([--enable-benchmarks], [Enable Compilation of Benchmarks]),
+    [ENABLE_FEATURE(BENCHMARK)],
+    [DISABLE_FEATURE(BENCHMARK)])
+
 #
 # Search for mandatory packages
 #
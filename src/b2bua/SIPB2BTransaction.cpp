@@ -26,6 +26,7 @@
 #include "OSS/ABNF/ABNFSIPIPV6Address.h"
 #include "OSS/SIP/SIPVia.h"
 #include "OSS/UTL/PropertyMap.h"
+#include "OSS/Metrics/MetricsRegistry.h"
 
 #define THREADED_RESPONSE 0 /// Disable threadpool for response handling.  This is the desired default to avoid race conditions!
 
@@ -39,7 +40,8 @@ SIPB2BTransaction::SIPB2BTransaction(SIPB2BTransactionManager* pManager) :
   _pInternalPtr(0),
   _hasSentLocalResponse(false),
   _isMidDialog(false),
-  _isChallenged(false)
+  _isChallenged(false),
+  _dispatchTime(0)
 {
 }
 
@@ -108,6 +110,10 @@ void SIPB2BTransaction::releaseInternalRef()
 void SIPB2BTransaction::runTask()
 {
   static OSS::Net::IPAddress LOCALHOST("127.0.0.1");
+  if (_dispatchTime)
+  {
+    _pManager->stack().overloadControl().reportQueueDelay(OSS::SIP::SIPOverloadControl::now() - _dispatchTime);
+  }
   _pInternalPtr = new Ptr(this);
   try
   {
@@ -198,6 +204,8 @@ void SIPB2BTransaction::runTask()
 
     try
     {
+      static OSS::Metrics::Histogram& routeTime = OSS::Metrics::MetricsRegistry::instance().histogram("b2b.route.us");
+      OSS::Metrics::ScopedTimer routeTimer(routeTime);
       pRouteResponse = _pManager->onRouteTransaction(_pClientRequest, shared_from_this(), _localInterface, outboundTarget);
     }
     catch(const OSS::Exception& e)
@@ -99,6 +99,12 @@ void SIPB2BTransactionManager::handleRequest(
   SIPB2BTransaction* b2bTransaction = onCreateB2BTransaction(pMsg, pTransport, pTransaction);
   if (!b2bTransaction)
     return;
+
+  //
+  // The delay is measured from the arrival of the request so time spent
+  // in the socket buffer and on the transport thread is included
+  //
+  b2bTransaction->_dispatchTime = pMsg->getReceiveTime() ? pMsg->getReceiveTime() : OSS::SIP::SIPOverloadControl::now();
   
   if (_externalDispatch)
   {
@@ -109,6 +115,7 @@ void SIPB2BTransactionManager::handleRequest(
 #if SEND_ERROR_ON_B2BUA_THREAD_DEPLETION
     if (_threadPool.schedule(boost::bind(&SIPB2BTransaction::runTask, b2bTransaction)) == -1)
     {
+      stack().overloadControl().reportSaturation();
       OSS::log_error(pMsg->createContextId(true) + "No available thread to handle SIPB2BTransactionManager::handleRequest");
       SIPMessage::Ptr serverError = pMsg->createResponse(500, "Thread Resource Depleted");
       pTransaction->sendResponse(serverError, pTransport->getRemoteAddress());
@@ -119,10 +126,14 @@ void SIPB2BTransactionManager::handleRequest(
     // The idea here is that if the threadpool runs out of threads, then we will directly
     // call runTask using the current thread which would effectively block the transport.
     // This is a good thing because blocking the transport yields our threadpool
-    // allowing it to recover.
+    // allowing it to recover.  Overload control is told so it sheds
+    // new dialogs once requests wait behind the blocked transport.
     //
     if (_threadPool.schedule(boost::bind(&SIPB2BTransaction::runTask, b2bTransaction)) == -1)
+    {
+      stack().overloadControl().reportSaturation();
       b2bTransaction->runTask();
+    }
 #endif
   }
 }
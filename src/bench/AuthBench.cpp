@@ -0,0 +1,189 @@
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "GNU Lesser General Public License (LGPL)".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+
+//
+// Measures the cost of verifying a digest challenge response the way
+// SBCAuthenticator::isAuthorized does during a registration storm.  The
+// legacy numbers assemble every MD5 input in an ostringstream and hash it
+// with string_md5_hash, recomputing HA1 from the password each time.  The
+// current numbers use a cached HA1, verify the timed nonce and run the
+// nonce-count window.
+//
+//   oss_bench_auth [count] [users]
+//
+
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <cstdlib>
+#include <vector>
+#include "OSS/UTL/CoreUtils.h"
+#include "OSS/SIP/SIPDigestAuth.h"
+
+
+using OSS::SIP::SIPDigestAuth;
+using OSS::SIP::SIPDigestNonceCounter;
+
+
+static void report(const std::string& name, std::size_t count, OSS::UInt64 elapsed)
+{
+  double seconds = elapsed ? elapsed / 1000.0 : 0.001;
+  std::cout << std::left << std::setw(32) << name
+    << std::right << std::setw(10) << count << " ops "
+    << std::setw(8) << elapsed << " ms "
+    << std::setw(12) << (std::size_t)(count / seconds) << " ops/s" << std::endl;
+}
+
+static std::string legacy_md5(const std::string& a, const std::string& b, const std::string& c)
+{
+  std::ostringstream strm;
+  strm << a << ":" << b << ":" << c;
+  return OSS::string_md5_hash(strm.str().c_str());
+}
+
+struct Credential
+{
+  std::string user;
+  std::string password;
+  std::string ha1;
+  std::string nonce;
+  std::string response;
+};
+
+static const char* REALM = "bench.example.com";
+static const char* METHOD = "REGISTER";
+static const char* URI = "sip:bench.example.com";
+static const char* CNONCE = "0a4f113b";
+static const char* QOP = "auth";
+
+static std::string nc_string(OSS::UInt32 nc)
+{
+  std::ostringstream strm;
+  strm << std::hex << std::setw(8) << std::setfill('0') << nc;
+  return strm.str();
+}
+
+static std::size_t run_legacy(std::vector<Credential>& credentials, std::size_t count)
+{
+  std::size_t accepted = 0;
+  OSS::UInt64 start = OSS::getTime();
+  for (std::size_t i = 0; i < count; i++)
+  {
+    Credential& credential = credentials[i % credentials.size()];
+    std::string a1 = legacy_md5(credential.user, REALM, credential.password);
+    std::ostringstream a2;
+    a2 << METHOD << ":" << URI;
+    std::string ha2 = OSS::string_md5_hash(a2.str().c_str());
+    std::ostringstream response;
+    response << a1 << ":" << credential.nonce << ":" << nc_string(1) << ":" << CNONCE << ":" << QOP << ":" << ha2;
+    if (OSS::string_md5_hash(response.str().c_str()) == credential.response)
+      accepted++;
+  }
+  report("legacy verify", count, OSS::getTime() - start);
+  return accepted;
+}
+
+static std::size_t run_current(std::vector<Credential>& credentials, std::size_t count)
+{
+  SIPDigestNonceCounter counter;
+  std::vector<OSS::UInt32> nc(credentials.size(), 0);
+  std::size_t accepted = 0;
+  OSS::UInt64 start = OSS::getTime();
+  for (std::size_t i = 0; i < count; i++)
+  {
+    std::size_t index = i % credentials.size();
+    Credential& credential = credentials[index];
+    if (!SIPDigestAuth::digestVerifyTimedNonce(credential.nonce, REALM))
+      continue;
+    std::string ha2 = SIPDigestAuth::digestCreateA2Hash(URI, METHOD);
+    //
+    // Every pass presents the same response so only the nonce-count
+    // bookkeeping sees a new nc.  The hash input length is unchanged.
+    //
+    std::string response = SIPDigestAuth::digestCreateAuthorizationQop(
+      credential.ha1, credential.nonce, nc_string(1), CNONCE, QOP, ha2);
+    if (response == credential.response && counter.accept(credential.nonce, credential.user, ++nc[index]))
+      accepted++;
+  }
+  report("cached HA1 verify", count, OSS::getTime() - start);
+  return accepted;
+}
+
+int main(int argc, char** argv)
+{
+  std::size_t count = argc > 1 ? std::atoi(argv[1]) : 200000;
+  std::size_t users = argc > 2 ? std::atoi(argv[2]) : 1000;
+  if (!users)
+    users = 1;
+
+  SIPDigestAuth::setSecretKey("oss_bench_auth");
+
+  std::vector<Credential> credentials(users);
+  for (std::size_t i = 0; i < users; i++)
+  {
+    Credential& credential = credentials[i];
+    credential.user = "user" + OSS::string_from_number<std::size_t>(i);
+    credential.password = "secret" + OSS::string_from_number<std::size_t>(i);
+    credential.ha1 = SIPDigestAuth::digestCreateA1Hash(credential.user, credential.password, REALM);
+    credential.nonce = SIPDigestAuth::digestCreateTimedNonce(REALM);
+    credential.response = SIPDigestAuth::digestCreateAuthorizationQop(credential.ha1, credential.nonce,
+      nc_string(1), CNONCE, QOP, SIPDigestAuth::digestCreateA2Hash(URI, METHOD));
+  }
+
+  OSS::UInt64 start = OSS::getTime();
+  for (std::size_t i = 0; i < count; i++)
+    legacy_md5(credentials[i % users].user, REALM, credentials[i % users].password);
+  report("legacy A1", count, OSS::getTime() - start);
+
+  start = OSS::getTime();
+  for (std::size_t i = 0; i < count; i++)
+    SIPDigestAuth::digestCreateA1Hash(credentials[i % users].user, credentials[i % users].password, REALM);
+  report("digestCreateA1Hash", count, OSS::getTime() - start);
+
+  start = OSS::getTime();
+  for (std::size_t i = 0; i < count; i++)
+    SIPDigestAuth::digestCreateNonce(REALM);
+  report("digestCreateNonce", count, OSS::getTime() - start);
+
+  start = OSS::getTime();
+  for (std::size_t i = 0; i < count; i++)
+    SIPDigestAuth::digestCreateTimedNonce(REALM);
+  report("digestCreateTimedNonce", count, OSS::getTime() - start);
+
+  start = OSS::getTime();
+  for (std::size_t i = 0; i < count; i++)
+    SIPDigestAuth::digestVerifyTimedNonce(credentials[i % users].nonce, REALM);
+  report("digestVerifyTimedNonce", count, OSS::getTime() - start);
+
+  SIPDigestNonceCounter counter;
+  start = OSS::getTime();
+  for (std::size_t i = 0; i < count; i++)
+    counter.accept(credentials[i % users].nonce, credentials[i % users].user, (OSS::UInt32)(i / users + 1));
+  report("SIPDigestNonceCounter::accept", count, OSS::getTime() - start);
+
+  std::size_t legacy = run_legacy(credentials, count);
+  std::size_t current = run_current(credentials, count);
+  if (legacy != count || current != count)
+  {
+    std::cerr << "verification mismatch: legacy " << legacy << " current " << current << std::endl;
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,190 @@
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "GNU Lesser General Public License (LGPL)".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+
+
+//
+// Measures OSS::UTL::AutoExpireSet, which backs the IST retransmission
+// blocker, against the StringPairCache the blocker used before and against
+// a tree based set that keeps a multimap of deadlines next to a std::set.
+// Every simulated INVITE checks the blocker for its transaction id, then
+// blocks it the way a terminated IST does.  The retransmission pass checks
+// ids that are all blocked.  The threaded pass runs the flood from several
+// threads at once.
+//
+//   oss_bench_expire_set [count] [threads]
+//
+
+#include <iostream>
+#include <iomanip>
+#include <cstdlib>
+#include <vector>
+#include <map>
+#include <set>
+#include <boost/thread.hpp>
+#include "OSS/UTL/CoreUtils.h"
+#include "OSS/UTL/Cache.h"
+#include "OSS/UTL/AutoExpireSet.h"
+
+
+class TreeExpireSet
+{
+public:
+  TreeExpireSet(unsigned long expire) :
+    _expire(expire)
+  {
+  }
+
+  void insert(const std::string& value)
+  {
+    OSS::mutex_critic_sec_lock lock(_mutex);
+    purge();
+    if (_set.insert(value).second)
+    {
+      _map.insert(std::make_pair(OSS::getTime() + _expire, value));
+    }
+  }
+
+  bool has(const std::string& value)
+  {
+    OSS::mutex_critic_sec_lock lock(_mutex);
+    purge();
+    return _set.find(value) != _set.end();
+  }
+
+private:
+  void purge()
+  {
+    OSS::UInt64 now = OSS::getTime();
+    while (!_map.empty() && _map.begin()->first <= now)
+    {
+      _set.erase(_map.begin()->second);
+      _map.erase(_map.begin());
+    }
+  }
+
+  unsigned long _expire;
+  OSS::mutex_critic_sec _mutex;
+  std::multimap<OSS::UInt64, std::string> _map;
+  std::set<std::string> _set;
+};
+
+class CacheExpireSet
+{
+public:
+  CacheExpireSet(unsigned long expire) :
+    _cache(expire / 1000)
+  {
+  }
+
+  void insert(const std::string& value)
+  {
+    _cache.add(value, value);
+  }
+
+  bool has(const std::string& value)
+  {
+    return _cache.has(value);
+  }
+
+private:
+  OSS::StringPairCache _cache;
+};
+
+typedef OSS::UTL::AutoExpireSet<std::string> HashExpireSet;
+
+static void report(const std::string& name, std::size_t count, OSS::UInt64 elapsed)
+{
+  double seconds = elapsed ? elapsed / 1000.0 : 0.001;
+  std::cout << std::left << std::setw(32) << name
+    << std::right << std::setw(10) << count << " ops "
+    << std::setw(8) << elapsed << " ms "
+    << std::setw(12) << (std::size_t)(count / seconds) << " ops/s" << std::endl;
+}
+
+template <typename S>
+static std::size_t flood(S* pSet, const std::vector<std::string>* pIds, std::size_t offset, std::size_t step)
+{
+  std::size_t blocked = 0;
+  for (std::size_t i = offset; i < pIds->size(); i += step)
+  {
+    if (pSet->has((*pIds)[i]))
+    {
+      blocked++;
+    }
+    pSet->insert((*pIds)[i]);
+  }
+  return blocked;
+}
+
+template <typename S>
+static void run(const std::string& name, const std::vector<std::string>& ids, std::size_t threads)
+{
+  {
+    S set(60000);
+    OSS::UInt64 start = OSS::getTime();
+    flood(&set, &ids, 0, 1);
+    report(name + " invite flood", ids.size(), OSS::getTime() - start);
+
+    start = OSS::getTime();
+    std::size_t blocked = flood(&set, &ids, 0, 1);
+    report(name + " retransmissions", ids.size(), OSS::getTime() - start);
+    if (blocked != ids.size())
+    {
+      std::cout << name << " blocked " << blocked << " of " << ids.size() << " retransmissions" << std::endl;
+    }
+  }
+  {
+    S set(60000);
+    boost::thread_group group;
+    OSS::UInt64 start = OSS::getTime();
+    for (std::size_t i = 0; i < threads; i++)
+    {
+      group.create_thread(boost::bind(flood<S>, &set, &ids, i, threads));
+    }
+    group.join_all();
+    report(name + " threaded flood", ids.size(), OSS::getTime() - start);
+  }
+}
+
+int main(int argc, char** argv)
+{
+  std::size_t count = argc > 1 ? std::atoi(argv[1]) : 200000;
+  std::size_t threads = argc > 2 ? std::atoi(argv[2]) : 4;
+  std::vector<std::string> ids;
+  ids.reserve(count);
+  for (std::size_t i = 0; i < count; i++)
+  {
+    ids.push_back("z9hG4bK-" + OSS::string_from_number<std::size_t>(i) + "-INVITE");
+  }
+  //
+  // Transaction ids arrive in no particular order
+  //
+  unsigned int seed = 1;
+  for (std::size_t i = count; i > 1; i--)
+  {
+    seed = seed * 1103515245 + 12345;
+    std::swap(ids[i - 1], ids[seed % i]);
+  }
+
+  run<CacheExpireSet>("cache", ids, threads);
+  run<TreeExpireSet>("tree", ids, threads);
+  run<HashExpireSet>("hash", ids, threads);
+  return 0;
+}
@@ -0,0 +1,209 @@
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "GNU Lesser General Public License (LGPL)".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+
+//
+// Measures JSON throughput on the payloads that cross the JSON library on
+// every call: a B2BUA dialog snapshot and an SBC CDR record.  The legacy
+// numbers go through json::Reader and json::Writer over string streams.
+// The current numbers use JsonParser and JsonWriter, both through the DOM
+// helpers and directly.
+//
+//   oss_bench_json [count]
+//
+
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <cstdlib>
+#include "OSS/UTL/CoreUtils.h"
+#include "OSS/JSON/Json.h"
+#include "OSS/SIP/B2BUA/SIPB2BDialogData.h"
+
+
+using OSS::JSON::JsonParser;
+using OSS::JSON::JsonWriter;
+using OSS::SIP::B2BUA::SIPB2BDialogData;
+
+
+static void report(const std::string& name, std::size_t count, std::size_t bytes, OSS::UInt64 elapsed)
+{
+  double seconds = elapsed ? elapsed / 1000.0 : 0.001;
+  std::cout << std::left << std::setw(36) << name
+    << std::right << std::setw(10) << count << " ops "
+    << std::setw(8) << elapsed << " ms "
+    << std::setw(12) << (std::size_t)(count / seconds) << " ops/s "
+    << std::setw(8) << std::fixed << std::setprecision(1) << (bytes * count / seconds / (1024 * 1024)) << " MB/s" << std::endl;
+}
+
+struct CountingHandler
+{
+  CountingHandler() : values(0) {}
+  bool onNull() { values++; return true; }
+  bool onBoolean(bool) { values++; return true; }
+  bool onNumber(double) { values++; return true; }
+  bool onString(const char*, std::size_t) { values++; return true; }
+  bool onKey(const char*, std::size_t) { return true; }
+  bool onObjectBegin() { return true; }
+  bool onObjectEnd() { values++; return true; }
+  bool onArrayBegin() { return true; }
+  bool onArrayEnd() { values++; return true; }
+  std::size_t values;
+};
+
+static void make_leg(SIPB2BDialogData::LegInfo& leg, const std::string& tag, bool caller)
+{
+  leg.callId = "OTU2YWMzOGZiMDJkM2Q2NmRiZmNhNTk0OTQ1MDk3ZTA.";
+  leg.from = "<sip:32017@example.com;transport=UDP>;tag=" + tag;
+  leg.to = "<sip:2017@example.com;transport=UDP>;tag=2ed94c23";
+  leg.remoteContact = "<sip:2017@192.168.1.10:58959;transport=UDP>";
+  leg.localContact = "2017 <sip:4147414987334546318926127303-1@192.168.1.10:5060;transport=udp>";
+  leg.remoteIp = caller ? "192.168.1.10:58959" : "203.0.113.40:5060";
+  leg.transportId = "0";
+  leg.targetTransport = "udp";
+  leg.localSdp = "v=0\r\no=Z 0 0 IN IP4 192.168.1.10\r\ns=Z\r\nc=IN IP4 192.168.1.10\r\nt=0 0\r\n"
+    "m=audio 8000 RTP/AVP 3 110 8 0 98 101\r\na=rtpmap:110 speex/8000\r\na=rtpmap:98 iLBC/8000\r\n"
+    "a=fmtp:98 mode=20\r\na=rtpmap:101 telephone-event/8000\r\na=fmtp:101 0-15\r\na=sendrecv\r\n";
+  leg.remoteSdp = "v=0\r\no=FreeSWITCH 1410664034 1410664035 IN IP4 172.31.1.9\r\ns=FreeSWITCH\r\n"
+    "c=IN IP4 203.0.113.40\r\nt=0 0\r\nm=audio 30466 RTP/AVP 0 101\r\na=rtpmap:0 PCMU/8000\r\n"
+    "a=rtpmap:101 telephone-event/8000\r\na=fmtp:101 0-16\r\na=ptime:20\r\n";
+  leg.localCSeq = caller ? 0 : 2;
+  if (!caller)
+    leg.routeSet.push_back("<sip:203.0.113.40:5060;lr;x-route=AL%2CAL>");
+}
+
+static void make_cdr(json::Object& cdr)
+{
+  //
+  // Same members SBCCDRRecord::toJson writes
+  //
+  cdr["date"] = json::String("2014-09-14 06:15:20");
+  cdr["from-uri"] = json::String("sip:32017@example.com");
+  cdr["to-uri"] = json::String("sip:2017@example.com");
+  cdr["caller-contact"] = json::String("<sip:32017@192.168.1.10:58959;transport=UDP>");
+  cdr["called-contact"] = json::String("<sip:2017@203.0.113.40:5060;transport=udp>");
+  cdr["src-address"] = json::String("192.168.1.10:58959");
+  cdr["dst-address"] = json::String("203.0.113.40:5060");
+  cdr["request-uri"] = json::String("sip:2017@example.com;user=phone");
+  cdr["call-id"] = json::String("OTU2YWMzOGZiMDJkM2Q2NmRiZmNhNTk0OTQ1MDk3ZTA.");
+  cdr["session-id"] = json::String("4147414987334546318926127303");
+  cdr["setup-time"] = json::Number(1410675320642.0);
+  cdr["alerting-time"] = json::Number(1410675321642.0);
+  cdr["connect-time"] = json::Number(1410675325642.0);
+  cdr["disconnect-time"] = json::Number(1410675385642.0);
+}
+
+static void run(const std::string& name, const json::Object& object, std::size_t count)
+{
+  std::string current;
+  OSS::JSON::json_object_to_string(object, current);
+  std::ostringstream legacyStrm;
+  json::Writer::Write(object, legacyStrm);
+  std::string legacy = legacyStrm.str();
+
+  OSS::UInt64 start = OSS::getTime();
+  for (std::size_t i = 0; i < count; i++)
+  {
+    std::ostringstream strm;
+    json::Writer::Write(object, strm);
+    legacy = strm.str();
+  }
+  report(name + " legacy write", count, legacy.size(), OSS::getTime() - start);
+
+  std::string buffer;
+  start = OSS::getTime();
+  for (std::size_t i = 0; i < count; i++)
+  {
+    buffer.clear();
+    JsonWriter writer(buffer);
+    writer.write(object);
+  }
+  report(name + " JsonWriter", count, buffer.size(), OSS::getTime() - start);
+
+  start = OSS::getTime();
+  for (std::size_t i = 0; i < count; i++)
+  {
+    json::Object parsed;
+    std::stringstream strm;
+    strm << legacy;
+    json::Reader::Read(parsed, strm);
+  }
+  report(name + " legacy read", count, legacy.size(), OSS::getTime() - start);
+
+  start = OSS::getTime();
+  for (std::size_t i = 0; i < count; i++)
+  {
+    json::Object parsed;
+    OSS::JSON::json_parse_string(current, parsed);
+  }
+  report(name + " json_parse_string", count, current.size(), OSS::getTime() - start);
+
+  JsonParser parser;
+  CountingHandler handler;
+  start = OSS::getTime();
+  for (std::size_t i = 0; i < count; i++)
+  {
+    parser.parse(current, handler);
+  }
+  report(name + " JsonParser", count, current.size(), OSS::getTime() - start);
+
+  std::string copy;
+  start = OSS::getTime();
+  for (std::size_t i = 0; i < count; i++)
+  {
+    copy = current;
+    parser.parseInSitu(&copy[0], copy.size(), handler);
+  }
+  report(name + " JsonParser in situ", count, current.size(), OSS::getTime() - start);
+}
+
+int main(int argc, char** argv)
+{
+  std::size_t count = argc > 1 ? std::atoi(argv[1]) : 100000;
+
+  SIPB2BDialogData dialog;
+  dialog.sessionId = "4147414987334546318926127303";
+  make_leg(dialog.leg1, "Xg67jHjDemXjF", true);
+  make_leg(dialog.leg2, "2ed94c23", false);
+
+  json::Object dialogObject;
+  dialog.toJsonObject(dialogObject);
+  run("dialog", dialogObject, count);
+
+  std::string dialogJson;
+  OSS::UInt64 start = OSS::getTime();
+  for (std::size_t i = 0; i < count; i++)
+  {
+    dialog.toJsonString(dialogJson);
+  }
+  report("dialog toJsonString", count, dialogJson.size(), OSS::getTime() - start);
+
+  start = OSS::getTime();
+  for (std::size_t i = 0; i < count; i++)
+  {
+    SIPB2BDialogData parsed;
+    parsed.fromJsonString(dialogJson);
+  }
+  report("dialog fromJsonString", count, dialogJson.size(), OSS::getTime() - start);
+
+  json::Object cdr;
+  make_cdr(cdr);
+  run("cdr", cdr, count);
+  return 0;
+}
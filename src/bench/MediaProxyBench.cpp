@@ -0,0 +1,144 @@
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "GNU Lesser General Public License (LGPL)".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+//
+// Measures SDP operations per second through SBCMediaProxy against
+// stand-in media nodes running in the same process.  Each stand-in is a
+// ROUTER socket that echoes the offer back after an optional delay that
+// simulates the work of a real node.
+//
+//   oss_bench_media_proxy [nodes] [threads] [count] [delay-us]
+//
+
+#include <iostream>
+#include <iomanip>
+#include <cstdlib>
+#include <boost/bind.hpp>
+#include <boost/atomic.hpp>
+#include "OSS/UTL/CoreUtils.h"
+#include "OSS/SIP/SBC/SBCMediaProxy.h"
+
+
+using OSS::SIP::SBC::SBCMediaProxy;
+
+#define STAND_IN_BASE_PORT 41590
+
+static boost::atomic<bool> gTerminate(false);
+
+static void stand_in_node(zmq::context_t* pContext, int port, unsigned int delay)
+{
+  zmq::socket_t socket(*pContext, ZMQ_ROUTER);
+  int linger = 0;
+  socket.setsockopt(ZMQ_LINGER, &linger, sizeof(linger));
+  std::string address = "tcp://127.0.0.1:" + OSS::string_from_number<int>(port);
+  socket.bind(address.c_str());
+
+  std::size_t sessionCount = 0;
+  while (!gTerminate)
+  {
+    zmq::pollitem_t items[] = { { socket, 0, ZMQ_POLLIN, 0 } };
+    zmq::poll(&items[0], 1, 100);
+    if (!(items[0].revents & ZMQ_POLLIN))
+      continue;
+
+    //
+    // [identity][request-id][empty][command][payload]
+    //
+    std::vector<zmq::message_t*> frames;
+    int more = 1;
+    while (more)
+    {
+      zmq::message_t* frame = new zmq::message_t();
+      socket.recv(frame);
+      frames.push_back(frame);
+      size_t size = sizeof(more);
+      socket.getsockopt(ZMQ_RCVMORE, &more, &size);
+    }
+
+    if (frames.size() == 5)
+    {
+      if (delay)
+        usleep(delay);
+      std::string reply = "{\"sdp\":\"v=0\\r\\n\",\"sessionCount\":" + OSS::string_from_number<std::size_t>(++sessionCount) + "}";
+      zmq::message_t payload(reply.size());
+      memcpy(payload.data(), reply.data(), reply.size());
+      socket.send(*frames[0], ZMQ_SNDMORE);
+      socket.send(*frames[1], ZMQ_SNDMORE);
+      socket.send(*frames[2], ZMQ_SNDMORE);
+      socket.send(payload);
+    }
+
+    for (std::vector<zmq::message_t*>::iterator iter = frames.begin(); iter != frames.end(); iter++)
+      delete *iter;
+  }
+}
+
+static void caller(SBCMediaProxy* pProxy, int threadIndex, std::size_t count, boost::atomic<std::size_t>* pErrors)
+{
+  OSS::Net::IPAddress address("127.0.0.1", 5060);
+  for (std::size_t i = 0; i < count; i++)
+  {
+    std::string sessionId = OSS::string_from_number<int>(threadIndex) + "-" + OSS::string_from_number<std::size_t>(i);
+    std::string sdp = "v=0\r\n";
+    OSS::RTP::RTPProxy::Attributes attributes;
+    if (!pProxy->handleSDP("", sessionId, address, address, address, address, address,
+      OSS::RTP::RTPProxySession::INVITE, sdp, attributes))
+    {
+      (*pErrors)++;
+    }
+  }
+}
+
+int main(int argc, char** argv)
+{
+  int nodeCount = argc > 1 ? std::atoi(argv[1]) : 5;
+  int threadCount = argc > 2 ? std::atoi(argv[2]) : 32;
+  std::size_t count = argc > 3 ? std::atoi(argv[3]) : 2000;
+  unsigned int delay = argc > 4 ? std::atoi(argv[4]) : 0;
+
+  zmq::context_t context(1);
+  boost::thread_group nodes;
+  SBCMediaProxy proxy(0);
+  for (int i = 0; i < nodeCount; i++)
+  {
+    nodes.create_thread(boost::bind(stand_in_node, &context, STAND_IN_BASE_PORT + i, delay));
+    proxy.addNode("tcp://127.0.0.1:" + OSS::string_from_number<int>(STAND_IN_BASE_PORT + i));
+  }
+  proxy.setMaxSession(1000000);
+  proxy.initialize(true);
+
+  boost::atomic<std::size_t> errors(0);
+  OSS::UInt64 start = OSS::getTime();
+  boost::thread_group callers;
+  for (int i = 0; i < threadCount; i++)
+    callers.create_thread(boost::bind(caller, &proxy, i, count, &errors));
+  callers.join_all();
+  OSS::UInt64 elapsed = OSS::getTime() - start;
+
+  std::size_t total = threadCount * count;
+  std::cout << "nodes " << nodeCount << " threads " << threadCount << " delay " << delay << "us" << std::endl;
+  std::cout << std::setw(10) << total << " SDP ops "
+    << std::setw(8) << elapsed << " ms "
+    << std::setw(10) << (std::size_t)(total / (elapsed ? elapsed / 1000.0 : 0.001)) << " ops/s "
+    << errors << " errors" << std::endl;
+
+  gTerminate = true;
+  nodes.join_all();
+  return 0;
+}
@@ -0,0 +1,410 @@
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "GNU Lesser General Public License (LGPL)".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+
+
+//
+// Load test for OSS::SIP::SIPOverloadControl.
+//
+// The cost of parsing an INVITE and of building the 503 for a shed one
+// are measured first.  They then drive a simulated server in virtual time
+// with a fixed number of cores, modelled on SIPB2BTransactionManager.
+//
+// Datagrams wait in a socket buffer of bounded size and are lost when it
+// is full.  The transport thread parses them and sheds new dialogs.  An
+// admitted INVITE is handed to the thread pool, which has no queue.  It
+// starts on a free worker right away or, when every worker is busy, is
+// reported as saturation and runs on the transport thread, which stops
+// reading the socket until it is done.  Running workers share the cores
+// evenly.  An INVITE is goodput if it finished before the caller gave up.
+//
+// The queueing delay reported for an INVITE is the time since it landed
+// in the socket buffer, as read from the kernel timestamp of the datagram.
+//
+// Shed and lost INVITEs are retransmitted on the RFC 3261 schedule.  The
+// retransmissions go through the socket buffer and cost a parse each but
+// are not admitted again.  Admitted INVITEs are assumed to get a 100
+// Trying from the transaction layer and are not retransmitted.
+//
+// Each load factor is a multiple of what the server can finish per second.
+// Rates are averaged after a warm up.
+//
+//   oss_bench_overload [work_us] [cores] [workers] [seconds] [deadline_ms] [socket_buffer]
+//
+
+#include <iostream>
+#include <iomanip>
+#include <cstdlib>
+#include <deque>
+#include <vector>
+#include <map>
+#include "OSS/UTL/CoreUtils.h"
+#include "OSS/SIP/SIPOverloadControl.h"
+#include "OSS/Metrics/MetricsRegistry.h"
+
+
+using OSS::SIP::SIPOverloadControl;
+using OSS::SIP::SIPMessage;
+typedef SIPOverloadControl::Time Time;
+
+static const std::string invite =
+  "INVITE sip:bob@example.com SIP/2.0\r\n"
+  "Via: SIP/2.0/UDP 192.0.2.10:5060;branch=z9hG4bK-524287-1;rport\r\n"
+  "Max-Forwards: 70\r\n"
+  "From: \"Alice\" <sip:alice@example.com>;tag=9fxced76sl\r\n"
+  "To: <sip:bob@example.com>\r\n"
+  "Call-ID: 3848276298220188511@192.0.2.10\r\n"
+  "CSeq: 1 INVITE\r\n"
+  "Contact: <sip:alice@192.0.2.10:5060;transport=udp>\r\n"
+  "Allow: INVITE, ACK, CANCEL, OPTIONS, BYE, REFER, NOTIFY\r\n"
+  "User-Agent: oss_bench_overload\r\n"
+  "Content-Type: application/sdp\r\n"
+  "Content-Length: 131\r\n\r\n"
+  "v=0\r\n"
+  "o=alice 2890844526 2890844526 IN IP4 192.0.2.10\r\n"
+  "s=-\r\n"
+  "c=IN IP4 192.0.2.10\r\n"
+  "t=0 0\r\n"
+  "m=audio 49170 RTP/AVP 0 8\r\n"
+  "a=rtpmap:0 PCMU/8000\r\n";
+
+struct Settings
+{
+  Time work;
+  Time parse;
+  Time reject;
+  unsigned int cores;
+  unsigned int workers;
+  unsigned int seconds;
+  Time deadline;
+  std::size_t socketBuffer;
+};
+
+struct Result
+{
+  Result() : offered(0), admitted(0), goodput(0), shed(0), lost(0), saturated(0), latency(0) {}
+  double offered;
+  double admitted;
+  double goodput;
+  double shed;
+  double lost;
+  double saturated;
+  double latency;
+};
+
+struct Datagram
+{
+  Datagram(Time sent_, Time received_, bool retransmission_) : sent(sent_), received(received_), retransmission(retransmission_) {}
+  Time sent;
+  Time received;
+  bool retransmission;
+};
+
+struct Task
+{
+  Task(Time arrival_, Time remaining_) : arrival(arrival_), remaining(remaining_) {}
+  Time arrival;
+  Time remaining;
+};
+
+enum Mode
+{
+  MODE_OFF,
+  MODE_REJECT,
+  MODE_DROP
+};
+
+static Time measure_parse(std::size_t count)
+{
+  Time start = SIPOverloadControl::now();
+  std::string id;
+  for (std::size_t i = 0; i < count; i++)
+  {
+    SIPMessage msg(invite);
+    msg.getTransactionId(id);
+  }
+  return (SIPOverloadControl::now() - start) / count;
+}
+
+static Time measure_reject(std::size_t count)
+{
+  SIPOverloadControl overload;
+  SIPMessage::Ptr pRequest(new SIPMessage(invite));
+  Time start = SIPOverloadControl::now();
+  for (std::size_t i = 0; i < count; i++)
+  {
+    SIPMessage::Ptr pResponse = overload.createRejectResponse(pRequest, "5f3a");
+  }
+  return (SIPOverloadControl::now() - start) / count;
+}
+
+static void retransmit(std::multimap<Time, Time>& retransmissions, Time now, Time sent)
+{
+  //
+  // Timer A doubles until Timer B fires at 64*T1
+  //
+  Time next = now + (now - sent) + 500000;
+  if (next - sent < 32000000)
+  {
+    retransmissions.insert(std::make_pair(next, sent));
+  }
+}
+
+static Result simulate(const Settings& settings, double load, Mode mode)
+{
+  SIPOverloadControl overload;
+  overload.setEnabled(mode != MODE_OFF);
+  overload.setAction(mode == MODE_DROP ? SIPOverloadControl::DROP : SIPOverloadControl::REJECT);
+
+  double capacity = settings.cores * 1000000.0 / (settings.work + settings.parse);
+  double perTick = capacity * load / 1000;
+  Time warmup = settings.seconds * 1000 / 4;
+  Time end = settings.seconds * 1000;
+
+  std::deque<Datagram> socket;
+    /// Datagrams the transport thread has not read yet
+  std::multimap<Time, Time> retransmissions;
+    /// When a shed or lost INVITE is sent again and when it was first sent
+  std::vector<Task> running;
+    /// INVITEs on a pool worker
+  Task transportTask(0, 0);
+    /// INVITE running on the transport thread because the pool was full
+  double arrivals = 0;
+
+  Result result;
+  double latencySum = 0;
+  double latencyCount = 0;
+
+  for (Time tick = 1; tick <= end; tick++)
+  {
+    Time now = tick * 1000;
+    bool measured = tick > warmup;
+    long budget = settings.cores * 1000;
+
+    //
+    // New INVITEs and retransmissions land in the socket buffer
+    //
+    arrivals += perTick;
+    for (; arrivals >= 1; arrivals -= 1)
+    {
+      if (measured)
+      {
+        result.offered++;
+      }
+      if (socket.size() < settings.socketBuffer)
+      {
+        socket.push_back(Datagram(now, now, false));
+        continue;
+      }
+      if (measured)
+      {
+        result.lost++;
+      }
+      retransmit(retransmissions, now, now);
+    }
+    while (!retransmissions.empty() && retransmissions.begin()->first <= now)
+    {
+      Time sent = retransmissions.begin()->second;
+      retransmissions.erase(retransmissions.begin());
+      if (socket.size() < settings.socketBuffer)
+      {
+        socket.push_back(Datagram(sent, now, true));
+      }
+      retransmit(retransmissions, now, sent);
+    }
+
+    //
+    // The transport thread gets at most one core
+    //
+    long transport = budget < 1000 ? budget : 1000;
+    long transportStart = transport;
+    while (transport > 0)
+    {
+      if (transportTask.remaining)
+      {
+        Time used = transportTask.remaining < (Time)transport ? transportTask.remaining : transport;
+        transportTask.remaining -= used;
+        transport -= used;
+        if (!transportTask.remaining && measured)
+        {
+          latencySum += now - transportTask.arrival;
+          latencyCount++;
+          if (now - transportTask.arrival <= settings.deadline)
+          {
+            result.goodput++;
+          }
+        }
+        continue;
+      }
+      if (socket.empty())
+      {
+        break;
+      }
+
+      Datagram datagram = socket.front();
+      socket.pop_front();
+      transport -= settings.parse;
+      if (datagram.retransmission)
+      {
+        continue;
+      }
+      if (!overload.admit(now))
+      {
+        if (measured)
+        {
+          result.shed++;
+        }
+        if (mode == MODE_REJECT)
+        {
+          transport -= settings.reject;
+        }
+        else
+        {
+          retransmit(retransmissions, now, datagram.sent);
+        }
+        continue;
+      }
+      if (measured)
+      {
+        result.admitted++;
+      }
+
+      //
+      // The task starts now.  It waited for as long as it sat in the
+      // socket buffer.
+      //
+      overload.reportQueueDelay(now - datagram.received, now);
+      if (running.size() < settings.workers)
+      {
+        running.push_back(Task(datagram.sent, settings.work));
+        continue;
+      }
+      overload.reportSaturation(now);
+      if (measured)
+      {
+        result.saturated++;
+      }
+      transportTask = Task(datagram.sent, settings.work);
+    }
+    budget -= transportStart - transport;
+
+    //
+    // Workers share what is left of the tick
+    //
+    if (budget > 0 && !running.empty())
+    {
+      Time share = budget / running.size();
+      if (share > 1000)
+      {
+        share = 1000;
+      }
+      if (!share)
+      {
+        share = 1;
+      }
+      for (std::vector<Task>::iterator iter = running.begin(); iter != running.end() && budget > 0;)
+      {
+        Time used = iter->remaining < share ? iter->remaining : share;
+        iter->remaining -= used;
+        budget -= used;
+        if (iter->remaining)
+        {
+          iter++;
+          continue;
+        }
+        if (measured)
+        {
+          latencySum += now - iter->arrival;
+          latencyCount++;
+          if (now - iter->arrival <= settings.deadline)
+          {
+            result.goodput++;
+          }
+        }
+        iter = running.erase(iter);
+      }
+    }
+  }
+
+  double seconds = (end - warmup) / 1000.0;
+  result.offered /= seconds;
+  result.admitted /= seconds;
+  result.goodput /= seconds;
+  result.shed /= seconds;
+  result.lost /= seconds;
+  result.saturated /= seconds;
+  result.latency = latencyCount ? latencySum / latencyCount / 1000 : 0;
+  return result;
+}
+
+static void report(const std::string& name, double load, const Result& result)
+{
+  std::cout << std::left << std::setw(8) << name
+    << std::right << std::setw(6) << std::fixed << std::setprecision(1) << load << "x"
+    << std::setw(12) << (std::size_t)result.offered
+    << std::setw(12) << (std::size_t)result.admitted
+    << std::setw(12) << (std::size_t)result.shed
+    << std::setw(12) << (std::size_t)result.lost
+    << std::setw(12) << (std::size_t)result.saturated
+    << std::setw(12) << (std::size_t)result.goodput
+    << std::setw(14) << std::setprecision(1) << result.latency << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+  Settings settings;
+  settings.work = argc > 1 ? std::atoi(argv[1]) : 2000;
+  settings.cores = argc > 2 ? std::atoi(argv[2]) : 4;
+  settings.workers = argc > 3 ? std::atoi(argv[3]) : 1024;
+  settings.seconds = argc > 4 ? std::atoi(argv[4]) : 120;
+  settings.deadline = (Time)(argc > 5 ? std::atoi(argv[5]) : 2000) * 1000;
+  settings.socketBuffer = argc > 6 ? std::atoi(argv[6]) : 256;
+  settings.parse = measure_parse(20000);
+  settings.reject = measure_reject(20000);
+  if (!settings.parse)
+  {
+    settings.parse = 1;
+  }
+  if (!settings.workers)
+  {
+    settings.workers = 1;
+  }
+
+  std::cout << "parse " << settings.parse << " us, 503 " << settings.reject << " us, work "
+    << settings.work << " us, " << settings.cores << " cores, " << settings.workers << " workers, deadline "
+    << settings.deadline / 1000 << " ms, socket buffer " << settings.socketBuffer << std::endl;
+  std::cout << std::left << std::setw(8) << "mode"
+    << std::right << std::setw(7) << "load"
+    << std::setw(12) << "offered/s"
+    << std::setw(12) << "admitted/s"
+    << std::setw(12) << "shed/s"
+    << std::setw(12) << "lost/s"
+    << std::setw(12) << "inline/s"
+    << std::setw(12) << "goodput/s"
+    << std::setw(14) << "latency ms" << std::endl;
+
+  const double loads[] = { 0.8, 1.0, 1.5, 2.0 };
+  for (std::size_t i = 0; i < sizeof(loads) / sizeof(loads[0]); i++)
+  {
+    report("off", loads[i], simulate(settings, loads[i], MODE_OFF));
+    report("reject", loads[i], simulate(settings, loads[i], MODE_REJECT));
+    report("drop", loads[i], simulate(settings, loads[i], MODE_DROP));
+  }
+  return 0;
+}
@@ -0,0 +1,187 @@
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "GNU Lesser General Public License (LGPL)".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+
+//
+// Measures BlockingQueue throughput with 1, 4 and 16 producers feeding a
+// single consumer.  The legacy numbers use the previous design, a deque
+// and a semaphore plus one pipe write and read per element.  The current
+// numbers use the deque and ring backends with their eventfd, consuming
+// one element at a time and in batches.
+//
+//   oss_bench_queue [count]
+//
+
+#include <iostream>
+#include <iomanip>
+#include <cstdlib>
+#include <deque>
+#include <fcntl.h>
+#include <boost/thread.hpp>
+#include "OSS/UTL/CoreUtils.h"
+#include "OSS/UTL/BlockingQueue.h"
+
+
+typedef OSS::BlockingQueue<int> Queue;
+
+
+class LegacyQueue : boost::noncopyable
+{
+public:
+  LegacyQueue() :
+    _sem(0, SEM_VALUE_MAX)
+  {
+    //
+    // Non-blocking so producers that run ahead of the consumer do not
+    // fill the pipe and block while holding the lock
+    //
+    int ok = pipe2(_pipe, O_NONBLOCK);
+    (void)ok;
+  }
+  
+  ~LegacyQueue()
+  {
+    close(_pipe[0]);
+    close(_pipe[1]);
+  }
+  
+  bool enqueue(int data)
+  {
+    _cs.lock();
+    _queue.push_back(data);
+    std::size_t w = write(_pipe[1], " ", 1);
+    (void)w;
+    _cs.unlock();
+    _sem.set();
+    return true;
+  }
+  
+  void dequeue(int& data)
+  {
+    _sem.wait();
+    _cs.lock();
+    char buf[1];
+    std::size_t r = read(_pipe[0], buf, 1);
+    (void)r;
+    data = _queue.front();
+    _queue.pop_front();
+    _cs.unlock();
+  }
+  
+private:
+  OSS::semaphore _sem;
+  OSS::mutex_critic_sec _cs;
+  std::deque<int> _queue;
+  int _pipe[2];
+};
+
+static void report(const std::string& name, int producers, std::size_t count, OSS::UInt64 elapsed)
+{
+  double seconds = elapsed ? elapsed / 1000.0 : 0.001;
+  std::cout << std::left << std::setw(16) << name
+    << std::right << std::setw(4) << producers << " producers "
+    << std::setw(10) << count << " ops "
+    << std::setw(8) << elapsed << " ms "
+    << std::setw(12) << (std::size_t)(count / seconds) << " ops/s" << std::endl;
+}
+
+template <typename Q>
+static void produce(Q* pQueue, std::size_t count)
+{
+  for (std::size_t i = 0; i < count; i++)
+  {
+    while (!pQueue->enqueue((int)i))
+    {
+      boost::this_thread::yield();
+    }
+  }
+}
+
+template <typename Q>
+static void run_single(const std::string& name, Q& queue, int producers, std::size_t count)
+{
+  std::size_t perProducer = count / producers;
+  std::size_t total = perProducer * producers;
+  OSS::UInt64 start = OSS::getTime();
+  boost::thread_group threads;
+  for (int i = 0; i < producers; i++)
+  {
+    threads.create_thread(boost::bind(produce<Q>, &queue, perProducer));
+  }
+  int data;
+  for (std::size_t i = 0; i < total; i++)
+  {
+    queue.dequeue(data);
+  }
+  threads.join_all();
+  report(name, producers, total, OSS::getTime() - start);
+}
+
+static void run_batch(const std::string& name, Queue& queue, int producers, std::size_t count)
+{
+  std::size_t perProducer = count / producers;
+  std::size_t total = perProducer * producers;
+  OSS::UInt64 start = OSS::getTime();
+  boost::thread_group threads;
+  for (int i = 0; i < producers; i++)
+  {
+    threads.create_thread(boost::bind(produce<Queue>, &queue, perProducer));
+  }
+  std::vector<int> items;
+  items.reserve(256);
+  std::size_t received = 0;
+  while (received < total)
+  {
+    items.clear();
+    received += queue.dequeueBatch(items, 256);
+  }
+  threads.join_all();
+  report(name, producers, total, OSS::getTime() - start);
+}
+
+int main(int argc, char** argv)
+{
+  std::size_t count = argc > 1 ? std::atoi(argv[1]) : 1000000;
+  int producers[] = { 1, 4, 16 };
+  for (std::size_t i = 0; i < sizeof(producers) / sizeof(producers[0]); i++)
+  {
+    {
+      LegacyQueue queue;
+      run_single("legacy", queue, producers[i], count);
+    }
+    {
+      Queue queue(true);
+      run_single("deque", queue, producers[i], count);
+    }
+    {
+      Queue queue(true);
+      run_batch("deque batch", queue, producers[i], count);
+    }
+    {
+      Queue queue(true, 65536, Queue::BACKEND_RING);
+      run_single("ring", queue, producers[i], count);
+    }
+    {
+      Queue queue(true, 65536, Queue::BACKEND_RING);
+      run_batch("ring batch", queue, producers[i], count);
+    }
+    std::cout << std::endl;
+  }
+  return 0;
+}
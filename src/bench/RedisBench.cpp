@@ -0,0 +1,206 @@
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "GNU Lesser General Public License (LGPL)".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+//
+// Measures write throughput of the synchronous RedisClient against the
+// pipelined RedisAsyncClient.  Run it against a local redis-server:
+//
+//   oss_bench_redis [host] [port] [count] [pool-size]
+//
+
+#include "OSS/build.h"
+
+#if ENABLE_FEATURE_REDIS && OSS_HAVE_HIREDIS
+
+#include <iostream>
+#include <iomanip>
+#include <cstdlib>
+#include <boost/bind.hpp>
+#include "OSS/UTL/CoreUtils.h"
+#include "OSS/Persistent/RedisAsyncClient.h"
+
+
+using OSS::Persistent::RedisClient;
+using OSS::Persistent::RedisAsyncClient;
+using OSS::Persistent::RedisReply;
+
+
+static void report(const std::string& name, std::size_t count, OSS::UInt64 elapsed)
+{
+  double seconds = elapsed ? elapsed / 1000.0 : 0.001;
+  std::cout << std::left << std::setw(32) << name
+    << std::right << std::setw(10) << count << " ops "
+    << std::setw(8) << elapsed << " ms "
+    << std::setw(12) << (std::size_t)(count / seconds) << " ops/s" << std::endl;
+}
+
+static std::string make_key(const std::string& prefix, std::size_t index)
+{
+  return prefix + OSS::string_from_number<std::size_t>(index);
+}
+
+class Completion
+  /// Counts replies and wakes up the waiting thread when all arrived
+{
+public:
+  Completion(std::size_t expected) : _expected(expected), _count(0), _errors(0)
+  {
+  }
+
+  void onReply(const RedisReply& reply)
+  {
+    boost::unique_lock<boost::mutex> lock(_mutex);
+    if (reply.isError())
+      _errors++;
+    if (++_count == _expected)
+      _done.notify_one();
+  }
+
+  void wait()
+  {
+    boost::unique_lock<boost::mutex> lock(_mutex);
+    while (_count < _expected)
+      _done.wait(lock);
+  }
+
+  std::size_t errors() const
+  {
+    return _errors;
+  }
+
+private:
+  boost::mutex _mutex;
+  boost::condition_variable _done;
+  std::size_t _expected;
+  std::size_t _count;
+  std::size_t _errors;
+};
+
+static void bench_sync_set(RedisClient& client, std::size_t count)
+{
+  OSS::UInt64 start = OSS::getTime();
+  for (std::size_t i = 0; i < count; i++)
+    client.set(make_key("bench-sync-", i), "value");
+  report("sync SET", count, OSS::getTime() - start);
+}
+
+static void bench_sync_mset(RedisClient& client, std::size_t count, std::size_t batchSize)
+{
+  OSS::UInt64 start = OSS::getTime();
+  std::map<std::string, std::string> values;
+  for (std::size_t i = 0; i < count; i++)
+  {
+    values[make_key("bench-mset-", i)] = "value";
+    if (values.size() == batchSize)
+    {
+      client.mset(values);
+      values.clear();
+    }
+  }
+  client.mset(values);
+  report("sync MSET x" + OSS::string_from_number<std::size_t>(batchSize), count, OSS::getTime() - start);
+}
+
+static void bench_sync_scan(RedisClient& client)
+{
+  OSS::UInt64 start = OSS::getTime();
+  std::vector<std::string> keys;
+  client.getKeys("bench-*", keys);
+  report("sync SCAN bench-*", keys.size(), OSS::getTime() - start);
+}
+
+static void bench_async_set(RedisAsyncClient& client, std::size_t count)
+{
+  Completion completion(count);
+  OSS::UInt64 start = OSS::getTime();
+  for (std::size_t i = 0; i < count; i++)
+    client.set(make_key("bench-async-", i), "value", -1, boost::bind(&Completion::onReply, &completion, _1));
+  completion.wait();
+  report("async SET", count, OSS::getTime() - start);
+  if (completion.errors())
+    std::cout << "  errors: " << completion.errors() << std::endl;
+}
+
+static void bench_async_get(RedisAsyncClient& client, std::size_t count)
+{
+  Completion completion(count);
+  OSS::UInt64 start = OSS::getTime();
+  for (std::size_t i = 0; i < count; i++)
+    client.get(make_key("bench-async-", i), boost::bind(&Completion::onReply, &completion, _1));
+  completion.wait();
+  report("async GET", count, OSS::getTime() - start);
+}
+
+static void cleanup(RedisClient& client)
+{
+  std::vector<std::string> keys;
+  client.getKeys("bench-*", keys);
+  for (std::vector<std::string>::const_iterator iter = keys.begin(); iter != keys.end(); iter++)
+    client.del(*iter);
+}
+
+int main(int argc, char** argv)
+{
+  std::string host = argc > 1 ? argv[1] : "127.0.0.1";
+  int port = argc > 2 ? std::atoi(argv[2]) : 6379;
+  std::size_t count = argc > 3 ? std::atoi(argv[3]) : 100000;
+  std::size_t poolSize = argc > 4 ? std::atoi(argv[4]) : RedisAsyncClient::DEFAULT_POOL_SIZE;
+
+  RedisClient client(host, port);
+  if (!client.connect())
+  {
+    std::cerr << "Unable to connect to redis at " << host << ":" << port << std::endl;
+    return 1;
+  }
+
+  RedisAsyncClient asyncClient(host, port, poolSize);
+  if (!asyncClient.connect())
+  {
+    std::cerr << "Unable to connect the async pool to redis at " << host << ":" << port << std::endl;
+    return 1;
+  }
+
+  std::cout << "redis " << host << ":" << port << " pool-size " << poolSize << std::endl;
+
+  bench_sync_set(client, count);
+  bench_sync_mset(client, count, 100);
+  bench_async_set(asyncClient, count);
+  bench_async_get(asyncClient, count);
+  bench_sync_scan(client);
+
+  RedisAsyncClient::Stats stats = asyncClient.getStats();
+  std::cout << "async pipeline: " << stats.commands << " commands in "
+    << stats.batches << " round-trips" << std::endl;
+
+  asyncClient.disconnect();
+  cleanup(client);
+  return 0;
+}
+
+#else
+
+#include <iostream>
+
+int main(int argc, char** argv)
+{
+  std::cerr << "Redis support is not enabled" << std::endl;
+  return 1;
+}
+
+#endif
@@ -0,0 +1,191 @@
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "GNU Lesser General Public License (LGPL)".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+
+//
+// Compares SDPSession with the span based SDPParser and SDPRewriter on
+// WebRTC sized offers.  Each media description carries a full codec list,
+// DTLS and ICE attributes and the requested number of ICE candidates.
+// The rewrite benchmarks patch the connection address and ports the way
+// RTPProxySession does for an initial offer.
+//
+//   oss_bench_sdp [count] [candidates-per-media]
+//
+
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <cstdlib>
+#include "OSS/UTL/CoreUtils.h"
+#include "OSS/SDP/SDPSession.h"
+#include "OSS/SDP/SDPParser.h"
+#include "OSS/SDP/SDPRewriter.h"
+
+
+using OSS::SDP::SDPMedia;
+using OSS::SDP::SDPSession;
+using OSS::SDP::SDPParser;
+using OSS::SDP::SDPRewriter;
+
+
+static void report(const std::string& name, std::size_t count, OSS::UInt64 elapsed)
+{
+  double seconds = elapsed ? elapsed / 1000.0 : 0.001;
+  std::cout << std::left << std::setw(32) << name
+    << std::right << std::setw(10) << count << " ops "
+    << std::setw(8) << elapsed << " ms "
+    << std::setw(12) << (std::size_t)(count / seconds) << " ops/s" << std::endl;
+}
+
+static void add_media(std::ostream& sdp, const char* type, unsigned short port, const char* payloads, std::size_t candidates)
+{
+  sdp << "m=" << type << " " << port << " UDP/TLS/RTP/SAVPF " << payloads << "\r\n";
+  sdp << "c=IN IP4 203.0.113.10\r\n";
+  sdp << "a=rtcp:9 IN IP4 0.0.0.0\r\n";
+  for (std::size_t i = 0; i < candidates; i++)
+  {
+    sdp << "a=candidate:" << 842163049 + i << " " << (i % 2) + 1 << " udp " << 2122260223 - i
+      << " 192.168." << i / 250 << "." << i % 250 + 1 << " " << 50000 + i << " typ host generation 0 network-id " << i << "\r\n";
+  }
+  sdp << "a=ice-ufrag:Fe3u\r\n";
+  sdp << "a=ice-pwd:Tw4qbzLtf6T9pu1sTk2mOkNc\r\n";
+  sdp << "a=ice-options:trickle\r\n";
+  sdp << "a=fingerprint:sha-256 7B:8B:F0:65:5F:78:E2:51:3B:AC:6F:F3:3F:46:1B:35:DC:B8:5F:64:1A:24:C2:43:F0:A1:58:D0:A1:2C:19:08\r\n";
+  sdp << "a=setup:actpass\r\n";
+  sdp << "a=mid:" << type << "\r\n";
+  sdp << "a=extmap:1 urn:ietf:params:rtp-hdrext:ssrc-audio-level\r\n";
+  sdp << "a=extmap:2 http://www.webrtc.org/experiments/rtp-hdrext/abs-send-time\r\n";
+  sdp << "a=sendrecv\r\n";
+  sdp << "a=rtcp-mux\r\n";
+  std::vector<std::string> tokens = OSS::string_tokenize(payloads, " ");
+  for (std::size_t i = 0; i < tokens.size(); i++)
+  {
+    sdp << "a=rtpmap:" << tokens[i] << " codec" << tokens[i] << "/90000\r\n";
+    sdp << "a=rtcp-fb:" << tokens[i] << " nack\r\n";
+    sdp << "a=fmtp:" << tokens[i] << " level-asymmetry-allowed=1;packetization-mode=1\r\n";
+  }
+  sdp << "a=ssrc:3570614608 cname:4TOk42mSjXCkVIa6\r\n";
+  sdp << "a=ssrc:3570614608 msid:lgsCFqt9kN2fVKw5wXF3nNiUh3O3SRYqrvQw 35429d94-5637-4686-9ecd-7d0622261ce8\r\n";
+}
+
+static std::string make_offer(std::size_t candidates)
+{
+  std::ostringstream sdp;
+  sdp << "v=0\r\n";
+  sdp << "o=- 4611731400430051336 2 IN IP4 127.0.0.1\r\n";
+  sdp << "s=-\r\n";
+  sdp << "t=0 0\r\n";
+  sdp << "a=group:BUNDLE audio video\r\n";
+  sdp << "a=msid-semantic: WMS lgsCFqt9kN2fVKw5wXF3nNiUh3O3SRYqrvQw\r\n";
+  add_media(sdp, "audio", 50000, "111 103 104 9 0 8 106 105 13 110 112 113 126", candidates);
+  add_media(sdp, "video", 50002, "96 97 98 99 100 101 102 121 127 120 125 107 108 109 124 119 123 118 114 115 116", candidates);
+  return sdp.str();
+}
+
+static void bench_session_parse(const std::string& offer, std::size_t count)
+{
+  OSS::UInt64 start = OSS::getTime();
+  std::size_t media = 0;
+  for (std::size_t i = 0; i < count; i++)
+  {
+    SDPSession session(offer.c_str());
+    media += session.getMediaCount(SDPMedia::TYPE_NONE);
+  }
+  if (media != count * 2)
+    std::cerr << "SDPSession found " << media << " media descriptions" << std::endl;
+  report("SDPSession parse", count, OSS::getTime() - start);
+}
+
+static void bench_parser_parse(const std::string& offer, std::size_t count)
+{
+  OSS::UInt64 start = OSS::getTime();
+  std::size_t media = 0;
+  for (std::size_t i = 0; i < count; i++)
+  {
+    SDPParser parser(offer);
+    media += parser.getMediaCount();
+  }
+  if (media != count * 2)
+    std::cerr << "SDPParser found " << media << " media descriptions" << std::endl;
+  report("SDPParser parse", count, OSS::getTime() - start);
+}
+
+static void bench_session_rewrite(const std::string& offer, std::size_t count)
+{
+  OSS::UInt64 start = OSS::getTime();
+  std::size_t bytes = 0;
+  for (std::size_t i = 0; i < count; i++)
+  {
+    SDPSession session(offer.c_str());
+    SDPMedia::Ptr audio = session.getMedia(SDPMedia::TYPE_AUDIO);
+    SDPMedia::Ptr video = session.getMedia(SDPMedia::TYPE_VIDEO);
+    audio->setAddressV4("198.51.100.1");
+    audio->setDataPort(30000);
+    audio->setControlPort(30001);
+    video->setAddressV4("198.51.100.1");
+    video->setDataPort(30002);
+    video->setControlPort(30003);
+    bytes += session.toString().size();
+  }
+  report("SDPSession rewrite", count, OSS::getTime() - start);
+  std::cout << "  " << bytes / count << " bytes per rewritten offer" << std::endl;
+}
+
+static void bench_rewriter_rewrite(const std::string& offer, std::size_t count)
+{
+  OSS::UInt64 start = OSS::getTime();
+  std::size_t bytes = 0;
+  for (std::size_t i = 0; i < count; i++)
+  {
+    SDPParser parser(offer);
+    SDPRewriter rewriter(parser);
+    const SDPParser::Media* audio = parser.getMedia(SDPMedia::TYPE_AUDIO);
+    const SDPParser::Media* video = parser.getMedia(SDPMedia::TYPE_VIDEO);
+    rewriter.setAddressV4(*audio, "198.51.100.1");
+    rewriter.setDataPort(*audio, 30000);
+    rewriter.setControlPort(*audio, 30001);
+    rewriter.setAddressV4(*video, "198.51.100.1");
+    rewriter.setDataPort(*video, 30002);
+    rewriter.setControlPort(*video, 30003);
+    bytes += rewriter.apply().size();
+  }
+  report("SDPRewriter rewrite", count, OSS::getTime() - start);
+  std::cout << "  " << bytes / count << " bytes per rewritten offer" << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+  std::size_t count = argc > 1 ? std::atoi(argv[1]) : 10000;
+  std::size_t candidates = argc > 2 ? std::atoi(argv[2]) : 32;
+
+  if (!count)
+  {
+    std::cerr << "Invalid iteration count" << std::endl;
+    return 1;
+  }
+
+  std::string offer = make_offer(candidates);
+  std::cout << "offer " << offer.size() << " bytes " << candidates << " candidates per media" << std::endl;
+
+  bench_session_parse(offer, count);
+  bench_parser_parse(offer, count);
+  bench_session_rewrite(offer, count);
+  bench_rewriter_rewrite(offer, count);
+  return 0;
+}
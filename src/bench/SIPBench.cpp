@@ -0,0 +1,539 @@
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "GNU Lesser General Public License (LGPL)".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+//
+// SIP call load generator.  A UAC endpoint starts calls at a fixed rate
+// towards a target over UDP loopback.  A UAS endpoint running in the same
+// process answers every request with a 200 Ok on 127.0.0.1:35062.
+//
+// Without a target the UAC talks to the UAS directly which measures the
+// stack alone.  To measure an SBC, run it on loopback with a route to the
+// UAS and pass its address as the target.  Passing the pid of the SBC also
+// reports the CPU it consumed per call.
+//
+//   oss_bench_sip [invite|register|options] [cps] [calls] [target] [results] [sbc-pid]
+//
+// A summary is printed and one JSON object per run is appended to the
+// results file (stdout if it is - or not set) so runs can be compared
+// across commits.
+//
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <cstdlib>
+#include <map>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <boost/bind.hpp>
+#include <boost/atomic.hpp>
+#include "OSS/SIP/EP/SIPEndpoint.h"
+#include "OSS/SIP/SIPContact.h"
+#include "OSS/SIP/SIPRoute.h"
+#include "OSS/SIP/SIPVia.h"
+#include "OSS/Metrics/MetricsRegistry.h"
+#include "OSS/UTL/Logger.h"
+
+
+using OSS::SIP::EP::SIPEndpoint;
+using OSS::SIP::SIPMessage;
+using OSS::Net::IPAddress;
+using OSS::Metrics::Histogram;
+
+#define UAC_PORT 35060
+#define UAS_PORT 35062
+#define DRAIN_TIMEOUT_US 40000000 // Timer B plus slack
+
+enum Scenario
+{
+  SCENARIO_INVITE,
+  SCENARIO_REGISTER,
+  SCENARIO_OPTIONS
+};
+
+enum Stage
+{
+  STAGE_INVITE,
+  STAGE_BYE,
+  STAGE_NON_INVITE
+};
+
+struct Call
+{
+  Stage stage;
+  std::string callId;
+  std::string fromTag;
+  OSS::UInt64 started;
+    /// Time the first request was sent
+  OSS::UInt64 sent;
+    /// Time the pending request was sent
+  SIPMessage::Ptr ack;
+    /// Kept to answer 2xx retransmissions
+};
+
+typedef std::map<std::string, Call> Calls;
+
+struct Bench
+{
+  Bench() :
+    uacAddress("127.0.0.1", UAC_PORT),
+    uasAddress("127.0.0.1", UAS_PORT),
+    completed(0),
+    failed(0),
+    retransmitted2xx(0),
+    inviteTime("invite"),
+    byeTime("bye"),
+    callTime("call"),
+    requestTime("request")
+  {
+  }
+
+  Scenario scenario;
+  IPAddress uacAddress;
+  IPAddress uasAddress;
+  IPAddress target;
+  SIPEndpoint uac;
+  SIPEndpoint uas;
+  OSS::mutex_critic_sec callsMutex;
+  Calls calls;
+  boost::atomic<std::size_t> completed;
+  boost::atomic<std::size_t> failed;
+  boost::atomic<std::size_t> retransmitted2xx;
+  Histogram inviteTime;
+  Histogram byeTime;
+  Histogram callTime;
+  Histogram requestTime;
+};
+
+static std::string create_request(Bench& bench, const char* method, const std::string& requestUri,
+  const std::string& callId, unsigned int cseq, const std::string& fromTag, const std::string& toTag,
+  const std::list<std::string>& routes)
+{
+  std::string local = bench.uacAddress.toIpPortString();
+  std::ostringstream strm;
+  strm << method << " " << requestUri << " SIP/2.0\r\n";
+  strm << "Via: SIP/2.0/UDP " << local << ";branch=" << OSS::SIP::SIPVia::createBranchString() << "\r\n";
+  for (std::list<std::string>::const_iterator iter = routes.begin(); iter != routes.end(); iter++)
+    strm << "Route: " << *iter << "\r\n";
+  strm << "Max-Forwards: 70\r\n";
+  strm << "From: <sip:uac@" << local << ">;tag=" << fromTag << "\r\n";
+  if (toTag.empty())
+    strm << "To: <sip:uas@" << bench.target.toIpPortString() << ">\r\n";
+  else
+    strm << "To: <sip:uas@" << bench.target.toIpPortString() << ">;tag=" << toTag << "\r\n";
+  strm << "Call-ID: " << callId << "\r\n";
+  strm << "CSeq: " << cseq << " " << method << "\r\n";
+  strm << "Contact: <sip:uac@" << local << ">\r\n";
+  if (!strcmp(method, OSS::SIP::REQ_REGISTER))
+    strm << "Expires: 3600\r\n";
+  strm << "Content-Length: 0\r\n\r\n";
+  return strm.str();
+}
+
+static void send_request(Bench& bench, const std::string& request)
+{
+  SIPMessage::Ptr pRequest(new SIPMessage(request));
+  bench.uac.sendEndpointRequest(pRequest, bench.uacAddress, bench.target);
+}
+
+static void start_call(Bench& bench, std::size_t index)
+{
+  Call call;
+  call.callId = OSS::string_from_number<std::size_t>(index) + "-" + SIPMessage::createTagString();
+  call.fromTag = SIPMessage::createTagString();
+  call.started = call.sent = Histogram::now();
+
+  const char* method = OSS::SIP::REQ_INVITE;
+  call.stage = STAGE_INVITE;
+  if (bench.scenario == SCENARIO_REGISTER)
+  {
+    method = OSS::SIP::REQ_REGISTER;
+    call.stage = STAGE_NON_INVITE;
+  }
+  else if (bench.scenario == SCENARIO_OPTIONS)
+  {
+    method = OSS::SIP::REQ_OPTIONS;
+    call.stage = STAGE_NON_INVITE;
+  }
+
+  std::string request = create_request(bench, method, "sip:uas@" + bench.target.toIpPortString(),
+    call.callId, 1, call.fromTag, "", std::list<std::string>());
+  {
+    OSS::mutex_critic_sec_lock lock(bench.callsMutex);
+    bench.calls[call.callId] = call;
+  }
+  send_request(bench, request);
+}
+
+static void handle_invite_ok(Bench& bench, Call& call, const SIPMessage::Ptr& pResponse)
+{
+  OSS::UInt64 now = Histogram::now();
+  bench.inviteTime.record(now - call.sent);
+
+  //
+  // The ACK and the BYE follow the remote target and the route set
+  // learned from the 200 Ok
+  //
+  std::string requestUri = "sip:uas@" + bench.target.toIpPortString();
+  OSS::SIP::ContactList contacts;
+  OSS::SIP::SIPContact::msgGetContacts(pResponse.get(), contacts);
+  if (!contacts.empty())
+    requestUri = contacts.front().getURI();
+
+  std::list<std::string> recordRoutes;
+  std::list<std::string> routes;
+  OSS::SIP::SIPRecordRoute::msgGetRecordRoutes(pResponse.get(), recordRoutes);
+  for (std::list<std::string>::iterator iter = recordRoutes.begin(); iter != recordRoutes.end(); iter++)
+    routes.push_front(*iter);
+
+  std::string toTag = pResponse->getToTag();
+  call.ack = SIPMessage::Ptr(new SIPMessage(create_request(bench, OSS::SIP::REQ_ACK, requestUri,
+    call.callId, 1, call.fromTag, toTag, routes)));
+  bench.uac.sendEndpointRequest(call.ack, bench.uacAddress, bench.target);
+
+  call.stage = STAGE_BYE;
+  call.sent = Histogram::now();
+  send_request(bench, create_request(bench, OSS::SIP::REQ_BYE, requestUri,
+    call.callId, 2, call.fromTag, toTag, routes));
+}
+
+static void uac_thread(Bench* pBench)
+{
+  Bench& bench = *pBench;
+  bool terminated = false;
+  while (!terminated)
+  {
+    SIPEndpoint::EndpointEventPtr pEvent;
+    bench.uac.receiveEndpointEvent(pEvent);
+    if (!pEvent)
+      continue;
+
+    switch(pEvent->eventType)
+    {
+      case SIPEndpoint::IncomingResponse:
+      {
+        SIPMessage::Ptr pResponse = pEvent->sipRequest;
+        if (!pResponse || pResponse->is1xx())
+          break;
+
+        OSS::mutex_critic_sec_lock lock(bench.callsMutex);
+        Calls::iterator iter = bench.calls.find(pResponse->hdrGet(OSS::SIP::HDR_CALL_ID));
+        if (iter == bench.calls.end())
+          break;
+
+        Call& call = iter->second;
+        if (!pResponse->is2xx())
+        {
+          bench.failed++;
+          bench.calls.erase(iter);
+        }
+        else if (call.stage == STAGE_INVITE)
+        {
+          handle_invite_ok(bench, call, pResponse);
+        }
+        else
+        {
+          OSS::UInt64 now = Histogram::now();
+          if (call.stage == STAGE_BYE)
+          {
+            bench.byeTime.record(now - call.sent);
+            bench.callTime.record(now - call.started);
+          }
+          else
+          {
+            bench.requestTime.record(now - call.sent);
+          }
+          bench.completed++;
+          bench.calls.erase(iter);
+        }
+        break;
+      }
+      case SIPEndpoint::Incoming2xxRetran:
+      {
+        //
+        // The UAS did not see our ACK in time
+        //
+        bench.retransmitted2xx++;
+        OSS::mutex_critic_sec_lock lock(bench.callsMutex);
+        Calls::iterator iter = bench.calls.find(pEvent->sipRequest->hdrGet(OSS::SIP::HDR_CALL_ID));
+        if (iter != bench.calls.end() && iter->second.ack)
+          bench.uac.sendEndpointRequest(iter->second.ack, bench.uacAddress, bench.target);
+        break;
+      }
+      case SIPEndpoint::TransactionError:
+      {
+        if (!pEvent->transaction)
+          break;
+        SIPMessage::Ptr pRequest = pEvent->transaction->getInitialRequest();
+        if (!pRequest)
+          break;
+        OSS::mutex_critic_sec_lock lock(bench.callsMutex);
+        Calls::iterator iter = bench.calls.find(pRequest->hdrGet(OSS::SIP::HDR_CALL_ID));
+        if (iter != bench.calls.end())
+        {
+          bench.failed++;
+          bench.calls.erase(iter);
+        }
+        break;
+      }
+      case SIPEndpoint::EndpointTerminated:
+        terminated = true;
+        break;
+      default:
+        break;
+    }
+  }
+}
+
+static void uas_thread(Bench* pBench)
+{
+  Bench& bench = *pBench;
+  std::string contact = "<sip:uas@" + bench.uasAddress.toIpPortString() + ">";
+  bool terminated = false;
+  while (!terminated)
+  {
+    SIPEndpoint::EndpointEventPtr pEvent;
+    bench.uas.receiveEndpointEvent(pEvent);
+    if (!pEvent)
+      continue;
+
+    if (pEvent->eventType == SIPEndpoint::IncomingRequest && pEvent->transaction)
+    {
+      SIPMessage::Ptr pResponse = pEvent->sipRequest->createResponse(200, "OK", SIPMessage::createTagString(), contact);
+      bench.uas.sendEndpointResponse(pResponse, pEvent->transaction, pEvent->transaction->remoteAddress());
+    }
+    else if (pEvent->eventType == SIPEndpoint::EndpointTerminated)
+    {
+      terminated = true;
+    }
+  }
+}
+
+static OSS::UInt64 process_cpu_us()
+{
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return (OSS::UInt64)usage.ru_utime.tv_sec * 1000000 + usage.ru_utime.tv_usec +
+    (OSS::UInt64)usage.ru_stime.tv_sec * 1000000 + usage.ru_stime.tv_usec;
+}
+
+static OSS::UInt64 pid_cpu_us(int pid)
+  /// Returns utime + stime of another process from /proc/<pid>/stat
+{
+  if (!pid)
+    return 0;
+  std::ifstream stat(("/proc/" + OSS::string_from_number<int>(pid) + "/stat").c_str());
+  std::string line;
+  if (!std::getline(stat, line))
+    return 0;
+  //
+  // The command name may contain spaces.  Fields are counted from the
+  // closing parenthesis which is followed by field 3.
+  //
+  std::size_t pos = line.rfind(')');
+  if (pos == std::string::npos)
+    return 0;
+  std::istringstream fields(line.substr(pos + 2));
+  std::string field;
+  OSS::UInt64 utime = 0;
+  OSS::UInt64 stime = 0;
+  for (int i = 3; i <= 15 && fields >> field; i++)
+  {
+    if (i == 14)
+      utime = OSS::string_to_number<OSS::UInt64>(field);
+    else if (i == 15)
+      stime = OSS::string_to_number<OSS::UInt64>(field);
+  }
+  return (utime + stime) * 1000000 / sysconf(_SC_CLK_TCK);
+}
+
+static void print_json(std::ostream& strm, const char* name, const Histogram::Snapshot& snapshot)
+{
+  strm << "\"" << name << "\":{\"count\":" << snapshot.count
+    << ",\"mean\":" << (OSS::UInt64)snapshot.mean()
+    << ",\"p50\":" << snapshot.p50
+    << ",\"p90\":" << snapshot.p90
+    << ",\"p99\":" << snapshot.p99
+    << ",\"p999\":" << snapshot.p999
+    << ",\"max\":" << snapshot.max << "}";
+}
+
+static void print_latency(const char* name, const Histogram::Snapshot& snapshot)
+{
+  if (!snapshot.count)
+    return;
+  std::cout << std::setw(8) << name << " us "
+    << " p50 " << std::setw(8) << snapshot.p50
+    << " p90 " << std::setw(8) << snapshot.p90
+    << " p99 " << std::setw(8) << snapshot.p99
+    << " p99.9 " << std::setw(8) << snapshot.p999
+    << " max " << std::setw(8) << snapshot.max << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+  std::string scenarioName = argc > 1 ? argv[1] : "invite";
+  std::size_t cps = argc > 2 ? std::atoi(argv[2]) : 100;
+  std::size_t count = argc > 3 ? std::atoi(argv[3]) : 1000;
+  std::string targetName = argc > 4 ? argv[4] : "";
+  std::string results = argc > 5 ? argv[5] : "-";
+  int sbcPid = argc > 6 ? std::atoi(argv[6]) : 0;
+
+  OSS::OSS_init();
+  OSS::log_reset_level(OSS::PRIO_ERROR);
+
+  Bench bench;
+  if (scenarioName == "invite")
+    bench.scenario = SCENARIO_INVITE;
+  else if (scenarioName == "register")
+    bench.scenario = SCENARIO_REGISTER;
+  else if (scenarioName == "options")
+    bench.scenario = SCENARIO_OPTIONS;
+  else
+  {
+    std::cerr << "Unknown scenario " << scenarioName << std::endl;
+    return 1;
+  }
+
+  if (!cps)
+    cps = 1;
+  bench.target = targetName.empty() ? bench.uasAddress : IPAddress::fromV4IPPort(targetName.c_str());
+  if (!bench.target.isValid())
+  {
+    std::cerr << "Invalid target " << targetName << std::endl;
+    return 1;
+  }
+
+  bench.uac.addTransport(bench.uacAddress);
+  bench.uas.addTransport(bench.uasAddress);
+  if (!bench.uac.runEndpoint() || !bench.uas.runEndpoint())
+  {
+    std::cerr << "Unable to start the endpoints" << std::endl;
+    return 1;
+  }
+
+  boost::thread uacThread(boost::bind(uac_thread, &bench));
+  boost::thread uasThread(boost::bind(uas_thread, &bench));
+
+  OSS::Metrics::Counter& retransmissions = OSS::Metrics::MetricsRegistry::instance().counter("sip.retransmissions");
+  OSS::UInt64 retransmissionsStart = retransmissions.value();
+  OSS::UInt64 cpuStart = process_cpu_us();
+  OSS::UInt64 sbcCpuStart = pid_cpu_us(sbcPid);
+  OSS::UInt64 start = Histogram::now();
+
+  //
+  // Pace calls on an absolute schedule so a late call does not push back
+  // every call that follows it
+  //
+  for (std::size_t i = 0; i < count; i++)
+  {
+    OSS::UInt64 due = start + (OSS::UInt64)i * 1000000 / cps;
+    OSS::UInt64 now = Histogram::now();
+    if (due > now)
+      usleep(due - now);
+    start_call(bench, i);
+  }
+  OSS::UInt64 offered = Histogram::now() - start;
+
+  OSS::UInt64 deadline = Histogram::now() + DRAIN_TIMEOUT_US;
+  while (bench.completed + bench.failed < count && Histogram::now() < deadline)
+    usleep(1000);
+  OSS::UInt64 elapsed = Histogram::now() - start;
+
+  OSS::UInt64 cpu = process_cpu_us() - cpuStart;
+  OSS::UInt64 sbcCpu = pid_cpu_us(sbcPid) - sbcCpuStart;
+  OSS::UInt64 retransmitted = retransmissions.value() - retransmissionsStart;
+  std::size_t completed = bench.completed;
+  std::size_t failed = bench.failed;
+  std::size_t timedOut = count - completed - failed;
+  double achieved = completed / (elapsed / 1000000.0);
+
+  bench.uac.stopEndpoint();
+  bench.uas.stopEndpoint();
+  uacThread.join();
+  uasThread.join();
+
+  Histogram::Snapshot invite = bench.inviteTime.snapshot();
+  Histogram::Snapshot bye = bench.byeTime.snapshot();
+  Histogram::Snapshot call = bench.callTime.snapshot();
+  Histogram::Snapshot request = bench.requestTime.snapshot();
+
+  std::cout << scenarioName << " target " << bench.target.toIpPortString()
+    << " offered " << cps << " cps in " << offered / 1000 << " ms" << std::endl;
+  std::cout << std::setw(10) << completed << " completed "
+    << std::setw(6) << failed << " failed "
+    << std::setw(6) << timedOut << " timed out "
+    << std::setw(10) << std::fixed << std::setprecision(1) << achieved << " cps" << std::endl;
+  std::cout << std::setw(10) << retransmitted << " retransmissions "
+    << std::setw(6) << bench.retransmitted2xx << " 2xx retransmissions" << std::endl;
+  print_latency("invite", invite);
+  print_latency("bye", bye);
+  print_latency("call", call);
+  print_latency(scenarioName.c_str(), request);
+  if (completed)
+  {
+    std::cout << std::setw(10) << cpu / completed << " us cpu per call (bench)";
+    if (sbcPid)
+      std::cout << " " << sbcCpu / completed << " us cpu per call (sbc)";
+    std::cout << std::endl;
+  }
+
+  std::ostringstream json;
+  json << "{\"scenario\":\"" << scenarioName << "\""
+    << ",\"target\":\"" << bench.target.toIpPortString() << "\""
+    << ",\"time\":" << time(0)
+    << ",\"cps_offered\":" << cps
+    << ",\"cps_achieved\":" << std::fixed << std::setprecision(1) << achieved
+    << ",\"calls\":" << count
+    << ",\"completed\":" << completed
+    << ",\"failed\":" << failed
+    << ",\"timed_out\":" << timedOut
+    << ",\"retransmissions\":" << retransmitted
+    << ",\"retransmissions_2xx\":" << bench.retransmitted2xx
+    << ",\"elapsed_us\":" << elapsed
+    << ",\"cpu_us_per_call\":" << (completed ? cpu / completed : 0)
+    << ",\"sbc_cpu_us_per_call\":" << (completed && sbcPid ? sbcCpu / completed : 0)
+    << ",";
+  if (bench.scenario == SCENARIO_INVITE)
+  {
+    print_json(json, "invite_us", invite);
+    json << ",";
+    print_json(json, "bye_us", bye);
+    json << ",";
+    print_json(json, "call_us", call);
+  }
+  else
+  {
+    print_json(json, "request_us", request);
+  }
+  json << "}";
+
+  if (results == "-")
+  {
+    std::cout << json.str() << std::endl;
+  }
+  else
+  {
+    std::ofstream out(results.c_str(), std::ios::app);
+    out << json.str() << std::endl;
+  }
+
+  return failed || timedOut ? 2 : 0;
+}
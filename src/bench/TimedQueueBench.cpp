@@ -0,0 +1,256 @@
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "GNU Lesser General Public License (LGPL)".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+
+//
+// Measures OSS::TimedQueue against the previous design, which allocated
+// one asio deadline_timer per record and armed it on its io_service.  The
+// churn numbers enqueue records with a deadline and erase them before
+// they fire, the way short lived transaction and dialog records behave.
+// The expiry numbers time how long the queue takes to run the handlers of
+// records that all expire in the same second.
+//
+//   oss_bench_timed_queue [count]
+//
+
+#include <iostream>
+#include <iomanip>
+#include <cstdlib>
+#include <vector>
+#include <map>
+#include <boost/asio.hpp>
+#include <boost/atomic.hpp>
+#include "OSS/UTL/CoreUtils.h"
+#include "OSS/UTL/TimedQueue.h"
+
+
+typedef OSS::TimedQueue::TimedQueueHandler TimedQueueHandler;
+
+
+class LegacyTimedQueue
+{
+public:
+  typedef boost::recursive_mutex mutex;
+  typedef boost::lock_guard<mutex> mutex_lock;
+  typedef boost::function<void(const std::string&, const boost::any&)>  TimedQueueHandler;
+  struct TimedQueueRecord
+  {
+    TimedQueueRecord() :
+      deadline(0)
+    {
+    }
+
+    ~TimedQueueRecord()
+    {
+      if (deadline)
+      {
+        deadline->cancel();
+        delete deadline;
+      }
+    }
+    std::string id;
+    boost::any data;
+    boost::asio::deadline_timer* deadline;
+    TimedQueueHandler deadlineFunc;
+  };
+
+  LegacyTimedQueue() :
+     _ioService()
+  {
+    housekeeper = new boost::asio::deadline_timer(_ioService, boost::posix_time::milliseconds(3600 * 1000));
+    housekeeper->expires_from_now(boost::posix_time::milliseconds(3600 * 1000));
+    housekeeper->async_wait(boost::bind(&LegacyTimedQueue::onHousekeeping, this, boost::asio::placeholders::error));
+
+    _thread = new boost::thread(boost::bind(&boost::asio::io_service::run, &_ioService));
+  }
+
+  ~LegacyTimedQueue()
+  {
+    _ioService.stop();
+    _thread->join();
+    delete _thread;
+    delete housekeeper;
+  }
+
+  void enqueue(const std::string& id, const boost::any& data, const TimedQueueHandler& deadlineFunc, int expires)
+  {
+    mutex_lock lock(_mutex);
+    _map.erase(id);
+    TimedQueueRecord record;
+    _map[id] = record;
+    _map[id].id = id;
+    _map[id].data = data;
+    _map[id].deadlineFunc = deadlineFunc;
+    boost::asio::deadline_timer* timer = new boost::asio::deadline_timer(_ioService, boost::posix_time::milliseconds(expires * 1000));
+    _map[id].deadline = timer;
+    timer->expires_from_now(boost::posix_time::milliseconds(expires * 1000));
+    timer->async_wait(boost::bind(&LegacyTimedQueue::onRecordExpire, this, boost::asio::placeholders::error, id));
+  }
+
+  void enqueue(const std::string& id, const boost::any& data)
+  {
+    mutex_lock lock(_mutex);
+    _map.erase(id);
+    TimedQueueRecord record;
+    record.id = id;
+    record.data = data;
+    _map[id] = record;
+  }
+  
+  void erase(const std::string& id)
+  {
+    mutex_lock lock(_mutex);
+    _map.erase(id);
+  }
+
+  bool dequeue(const std::string& id, boost::any& data)
+  {
+    mutex_lock lock(_mutex);
+    if (_map.find(id) == _map.end())
+      return false;
+    data = _map[id].data;
+    _map.erase(id);
+    return true;
+  }
+
+  bool get(const std::string& id, boost::any& data)
+  {
+    mutex_lock lock(_mutex);
+    if (_map.find(id) == _map.end())
+      return false;
+    data = _map[id].data;
+    return true;
+  }
+  
+protected:
+  void onRecordExpire(const boost::system::error_code& e, const std::string& id)
+  {
+    if (!e)
+    {
+    
+      _mutex.lock();
+      if (_map.find(id) == _map.end())
+      {
+        _mutex.unlock();
+        return;
+      }
+
+      TimedQueueHandler deadlineFunc = _map[id].deadlineFunc;
+      boost::any data = _map[id].data;
+      _map.erase(id);
+      _mutex.unlock();
+
+      //
+      // mutex is no longer locked.  This callback may reinsert the item to the queue without deadlock
+      //
+      deadlineFunc(id, data);
+    }
+  }
+
+  void onHousekeeping(const boost::system::error_code&)
+  {
+    housekeeper->expires_from_now(boost::posix_time::milliseconds(3600 * 1000));
+    housekeeper->async_wait(boost::bind(&LegacyTimedQueue::onHousekeeping, this, boost::asio::placeholders::error));
+  }
+  boost::asio::io_service _ioService;
+  boost::thread* _thread;
+  boost::asio::deadline_timer* housekeeper;
+  boost::recursive_mutex _mutex;
+  std::map<std::string, TimedQueueRecord> _map;
+};
+
+
+static boost::atomic<std::size_t> expiredCount(0);
+static boost::atomic<OSS::UInt64> lastExpire(0);
+
+static void on_expire(const std::string& id, const boost::any& data)
+{
+  expiredCount++;
+  lastExpire = OSS::getTime();
+}
+
+static void report(const std::string& name, std::size_t count, OSS::UInt64 elapsed)
+{
+  double seconds = elapsed ? elapsed / 1000.0 : 0.001;
+  std::cout << std::left << std::setw(32) << name
+    << std::right << std::setw(10) << count << " ops "
+    << std::setw(8) << elapsed << " ms "
+    << std::setw(12) << (std::size_t)(count / seconds) << " ops/s" << std::endl;
+}
+
+template <typename Q>
+static void run_churn(const std::string& name, Q& queue, const std::vector<std::string>& ids)
+{
+  OSS::UInt64 start = OSS::getTime();
+  for (std::size_t i = 0; i < ids.size(); i++)
+  {
+    queue.enqueue(ids[i], (int)i, on_expire, 60);
+  }
+  for (std::size_t i = 0; i < ids.size(); i++)
+  {
+    queue.erase(ids[i]);
+  }
+  report(name + " enqueue+erase", ids.size(), OSS::getTime() - start);
+}
+
+template <typename Q>
+static void run_expire(const std::string& name, Q& queue, const std::vector<std::string>& ids)
+{
+  expiredCount = 0;
+  OSS::UInt64 start = OSS::getTime();
+  for (std::size_t i = 0; i < ids.size(); i++)
+  {
+    queue.enqueue(ids[i], (int)i, on_expire, 1);
+  }
+  OSS::UInt64 enqueued = OSS::getTime();
+  while (expiredCount < ids.size())
+  {
+    boost::this_thread::sleep(boost::posix_time::milliseconds(10));
+  }
+  //
+  // Time past the one second deadline of the last record enqueued
+  //
+  OSS::UInt64 late = lastExpire > enqueued + 1000 ? lastExpire - enqueued - 1000 : 0;
+  report(name + " enqueue", ids.size(), enqueued - start);
+  std::cout << std::left << std::setw(32) << (name + " expiry") << std::right << std::setw(10) << ids.size()
+    << " records, last handler ran " << late << " ms after its deadline" << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+  std::size_t count = argc > 1 ? std::atoi(argv[1]) : 100000;
+  std::vector<std::string> ids;
+  ids.reserve(count);
+  for (std::size_t i = 0; i < count; i++)
+  {
+    ids.push_back("z9hG4bK-" + OSS::string_from_number<std::size_t>(i));
+  }
+
+  {
+    LegacyTimedQueue queue;
+    run_churn("legacy", queue, ids);
+    run_expire("legacy", queue, ids);
+  }
+  {
+    OSS::TimedQueue queue;
+    run_churn("wheel", queue, ids);
+    run_expire("wheel", queue, ids);
+  }
+  return 0;
+}
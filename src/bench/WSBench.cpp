@@ -0,0 +1,139 @@
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "GNU Lesser General Public License (LGPL)".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+
+//
+// Drives SIP over WebSocket load against a loopback WS listener using the
+// wsperf sip_test case.  Every request is answered with a 200 OK straight
+// from the transport dispatch so the numbers reflect the WS transport and
+// the SIP parser rather than any upper layer.  Each connection keeps up to
+// [window] requests outstanding.
+//
+//   oss_bench_ws [connections] [count-per-connection] [window] [threads]
+//
+
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <cstdlib>
+#include <boost/bind.hpp>
+#include <boost/thread.hpp>
+#include "OSS/UTL/CoreUtils.h"
+#include "OSS/UTL/Thread.h"
+#include "OSS/SIP/SIPTransportService.h"
+#include "net/ws/examples/wsperf/sip.hpp"
+
+
+using OSS::SIP::SIPMessage;
+using OSS::SIP::SIPTransportSession;
+using OSS::SIP::SIPTransportService;
+using OSS::SIP::SIPListener;
+
+
+static void report(const std::string& name, std::size_t count, OSS::UInt64 elapsed)
+{
+  double seconds = elapsed ? elapsed / 1000.0 : 0.001;
+  std::cout << std::left << std::setw(32) << name
+    << std::right << std::setw(10) << count << " ops "
+    << std::setw(8) << elapsed << " ms "
+    << std::setw(12) << (std::size_t)(count / seconds) << " ops/s" << std::endl;
+}
+
+static void on_request(SIPMessage::Ptr pMsg, SIPTransportSession::Ptr pTransport)
+{
+  if (!pMsg->isRequest())
+    return;
+  SIPMessage::Ptr pResponse = pMsg->createResponse(200);
+  pTransport->writeMessage(pResponse);
+}
+
+static void run_client(wsperf::sip_test_ptr test, const std::string& uri)
+{
+  try
+  {
+    websocketpp::client e(test);
+    e.alog().unset_level(websocketpp::log::alevel::ALL);
+    e.elog().unset_level(websocketpp::log::elevel::ALL);
+
+    websocketpp::client::connection_ptr con = e.get_connection(uri);
+    con->add_subprotocol("sip");
+    e.connect(con);
+    e.run();
+  }
+  catch (const std::exception& e)
+  {
+    std::cerr << "client error: " << e.what() << std::endl;
+  }
+}
+
+static void bench_method(const char* method, const std::string& uri, std::size_t connections, std::size_t count, std::size_t window)
+{
+  std::ostringstream cmd;
+  cmd << "sip_test:uri=" << uri << ";token=bench;quantile_count=1;rtts=false;"
+    << "method=" << method << ";count=" << count << ";timeout=60000;window=" << window << ";";
+
+  std::vector<wsperf::sip_test_ptr> tests;
+  for (std::size_t i = 0; i < connections; i++)
+  {
+    wscmd::cmd command = wscmd::parse(cmd.str());
+    tests.push_back(wsperf::sip_test_ptr(new wsperf::sip_test(command)));
+  }
+
+  OSS::UInt64 start = OSS::getTime();
+  boost::thread_group clients;
+  for (std::size_t i = 0; i < connections; i++)
+    clients.create_thread(boost::bind(run_client, tests[i], uri));
+  clients.join_all();
+  OSS::UInt64 elapsed = OSS::getTime() - start;
+
+  std::size_t responses = 0;
+  for (std::size_t i = 0; i < connections; i++)
+    responses += tests[i]->get_responses();
+
+  std::ostringstream name;
+  name << "ws " << method << " x" << connections << " w" << window;
+  report(name.str(), responses, elapsed);
+  if (responses != connections * count)
+    std::cerr << "  " << connections * count - responses << " requests were not answered" << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+  std::size_t connections = argc > 1 ? std::atoi(argv[1]) : 8;
+  std::size_t count = argc > 2 ? std::atoi(argv[2]) : 10000;
+  std::size_t window = argc > 3 ? std::atoi(argv[3]) : 16;
+  std::size_t threads = argc > 4 ? std::atoi(argv[4]) : 2;
+  const std::string port = "15062";
+
+  SIPTransportService svc(boost::bind(on_request, _1, _2));
+  svc.setWebSocketThreads(threads);
+  SIPListener::SubNets subnets;
+  subnets.push_back("0.0.0.0/0");
+  svc.addWSTransport("127.0.0.1", port, "127.0.0.1", subnets);
+  svc.run();
+  OSS::thread_sleep(100);
+
+  std::cout << "SIP over WebSocket - " << threads << " listener threads" << std::endl;
+  std::string uri = "ws://127.0.0.1:" + port;
+  bench_method("register", uri, connections, count, window);
+  bench_method("message", uri, connections, count, window);
+
+  svc.stop();
+  return 0;
+}
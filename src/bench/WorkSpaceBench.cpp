@@ -0,0 +1,190 @@
+// OSS Software Solutions Application Programmer Interface
+//
+// Author: Joegen E. Baclor - mailto:joegen@ossapp.com
+//
+// Package: SBC
+//
+// Copyright (c) OSS Software Solutions
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "OSS Software Solutions OSS API General License Agreement".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+//
+// Compares the glob-pattern key scan of SBCWorkSpace with the prefix and
+// cursor API on a BerkeleyDB workspace.  The default populates 1M keys
+// shaped like local registrar records.
+//
+//   oss_bench_workspace [count] [db-file]
+//
+
+#include <iostream>
+#include <iomanip>
+#include <cstdlib>
+#include <boost/filesystem.hpp>
+#include "OSS/UTL/CoreUtils.h"
+#include "OSS/SIP/SBC/SBCWorkSpace.h"
+
+
+using OSS::SIP::SBC::SBCWorkSpace;
+
+#define DOMAIN_COUNT 100
+
+
+static void report(const std::string& name, std::size_t count, OSS::UInt64 elapsed)
+{
+  double seconds = elapsed ? elapsed / 1000.0 : 0.001;
+  std::cout << std::left << std::setw(32) << name
+    << std::right << std::setw(10) << count << " ops "
+    << std::setw(8) << elapsed << " ms "
+    << std::setw(12) << (std::size_t)(count / seconds) << " ops/s" << std::endl;
+}
+
+static std::string make_aor(std::size_t index)
+{
+  return "user" + OSS::string_from_number<std::size_t>(index) + "@domain" + 
+    OSS::string_from_number<std::size_t>(index % DOMAIN_COUNT) + ".com";
+}
+
+static void populate(SBCWorkSpace& workspace, std::size_t count)
+{
+  OSS::UInt64 start = OSS::getTime();
+  for (std::size_t i = 0; i < count; i++)
+  {
+    std::string aor = make_aor(i);
+    std::string key = aor + "-" + OSS::string_from_number<std::size_t>(i * 7919) + "-10.0.0.1:5060";
+    std::string value = "{ \"aor\" : \"" + aor + "\", \"contact\" : \"sip:" + aor + "\", \"expires\" : 3600 }";
+    workspace.set(key, value);
+  }
+  report("populate", count, OSS::getTime() - start);
+}
+
+static void bench_legacy_lookup(SBCWorkSpace& workspace, std::size_t count, std::size_t lookups)
+{
+  //
+  // What getKeys("<aor>-*") cost before it learned to seek: every key is
+  // visited and compared against the pattern.
+  //
+  std::size_t found = 0;
+  OSS::UInt64 start = OSS::getTime();
+  for (std::size_t i = 0; i < lookups; i++)
+  {
+    std::string pattern = make_aor((i * 104729) % count) + "-*";
+    SBCWorkSpace::Keys keys;
+    workspace.getKeysWithPrefix("", keys);
+    for (SBCWorkSpace::Keys::const_iterator iter = keys.begin(); iter != keys.end(); iter++)
+    {
+      if (OSS::string_wildcard_compare(pattern.c_str(), *iter))
+        found++;
+    }
+  }
+  report("full scan lookup", lookups, OSS::getTime() - start);
+  if (found != lookups)
+    std::cerr << "full scan lookup found " << found << " keys" << std::endl;
+}
+
+static void bench_pattern_lookup(SBCWorkSpace& workspace, std::size_t count, std::size_t lookups)
+{
+  std::size_t found = 0;
+  OSS::UInt64 start = OSS::getTime();
+  for (std::size_t i = 0; i < lookups; i++)
+  {
+    SBCWorkSpace::Keys keys;
+    workspace.getKeys(make_aor((i * 104729) % count) + "-*", keys);
+    found += keys.size();
+  }
+  report("getKeys(pattern) lookup", lookups, OSS::getTime() - start);
+  if (found != lookups)
+    std::cerr << "getKeys(pattern) lookup found " << found << " keys" << std::endl;
+}
+
+static void bench_prefix_lookup(SBCWorkSpace& workspace, std::size_t count, std::size_t lookups)
+{
+  std::size_t found = 0;
+  OSS::UInt64 start = OSS::getTime();
+  for (std::size_t i = 0; i < lookups; i++)
+  {
+    SBCWorkSpace::Records records;
+    workspace.getRecordsWithPrefix(make_aor((i * 104729) % count) + "-", records);
+    found += records.size();
+  }
+  report("getRecordsWithPrefix lookup", lookups, OSS::getTime() - start);
+  if (found != lookups)
+    std::cerr << "getRecordsWithPrefix lookup found " << found << " keys" << std::endl;
+}
+
+static void bench_keys_then_get(SBCWorkSpace& workspace)
+{
+  OSS::UInt64 start = OSS::getTime();
+  SBCWorkSpace::Keys keys;
+  workspace.getKeys("*", keys);
+  std::size_t bytes = 0;
+  for (SBCWorkSpace::Keys::const_iterator iter = keys.begin(); iter != keys.end(); iter++)
+  {
+    std::string value;
+    if (workspace.get(*iter, value))
+      bytes += value.size();
+  }
+  report("getKeys(*) + get", keys.size(), OSS::getTime() - start);
+}
+
+static void bench_cursor(SBCWorkSpace& workspace)
+{
+  OSS::UInt64 start = OSS::getTime();
+  SBCWorkSpace::Cursor cursor(workspace, "");
+  SBCWorkSpace::Records records;
+  std::size_t count = 0;
+  std::size_t bytes = 0;
+  while (cursor.next(records))
+  {
+    for (SBCWorkSpace::Records::const_iterator iter = records.begin(); iter != records.end(); iter++)
+      bytes += iter->second.size();
+    count += records.size();
+    records.clear();
+  }
+  report("Cursor batches", count, OSS::getTime() - start);
+}
+
+int main(int argc, char** argv)
+{
+  std::size_t count = argc > 1 ? std::atoi(argv[1]) : 1000000;
+  std::string path = argc > 2 ? argv[2] : "oss_bench_workspace.db";
+
+  if (!count)
+  {
+    std::cerr << "Invalid key count" << std::endl;
+    return 1;
+  }
+
+  boost::filesystem::remove(path);
+  SBCWorkSpace workspace("bench");
+  if (!workspace.open(path))
+  {
+    std::cerr << "Unable to open " << path << std::endl;
+    return 1;
+  }
+
+  std::cout << "workspace " << path << " keys " << count << std::endl;
+
+  populate(workspace, count);
+  bench_legacy_lookup(workspace, count, 10);
+  bench_pattern_lookup(workspace, count, 10000);
+  bench_prefix_lookup(workspace, count, 10000);
+  bench_keys_then_get(workspace);
+  bench_cursor(workspace);
+
+  workspace.close();
+  boost::filesystem::remove(path);
+  return 0;
+}
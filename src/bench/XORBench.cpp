@@ -0,0 +1,120 @@
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "GNU Lesser General Public License (LGPL)".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+//
+// Measures bytes per cycle of the SIPXOR kernel against the byte loop it
+// replaced on RTP and SIP sized packets.  Cycles are read from the TSC
+// on x86.  Elsewhere nanoseconds are reported instead.
+//
+//   oss_bench_xor [iterations]
+//
+
+#include <iostream>
+#include <iomanip>
+#include <cstdlib>
+#include <vector>
+#include <time.h>
+#include "OSS/SIP/SIPXOR.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define XOR_BENCH_TSC 1
+#else
+#define XOR_BENCH_TSC 0
+#endif
+
+
+using OSS::SIP::SIPXOR;
+
+static OSS::UInt64 ticks()
+{
+#if XOR_BENCH_TSC
+  return __rdtsc();
+#else
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (OSS::UInt64)ts.tv_sec * 1000000000 + ts.tv_nsec;
+#endif
+}
+
+static void xor_bytes(char* packet, int size, const char* key)
+{
+  for (int i = 0; i < size; i += 2)
+  {
+    packet[i] = packet[i] ^ key[0];
+    packet[i + 1] = packet[i + 1] ^ key[1];
+    if (i + 2 == size - 1)
+    {
+      packet[i + 2] = packet[i + 2] ^ key[1];
+      break;
+    }
+  }
+}
+
+static void xor_kernel(char* packet, int size, const char* key)
+{
+  SIPXOR::xorInPlace(packet, size, key);
+}
+
+static double run(void (*func)(char*, int, const char*), std::vector<char>& buffer, int size, std::size_t iterations)
+{
+  const char* key = "GS";
+  OSS::UInt64 start = ticks();
+  for (std::size_t i = 0; i < iterations; i++)
+  {
+    func(&buffer[0], size, key);
+    //
+    // Keep the compiler from folding consecutive calls
+    //
+    __asm__ __volatile__("" : : "r"(&buffer[0]) : "memory");
+  }
+  OSS::UInt64 elapsed = ticks() - start;
+  return (double)size * iterations / (elapsed ? elapsed : 1);
+}
+
+int main(int argc, char** argv)
+{
+  std::size_t iterations = argc > 1 ? std::atoi(argv[1]) : 1000000;
+
+  //
+  // G.711 20ms, G.711 40ms, video, a typical INVITE and a large INVITE
+  //
+  int sizes[] = { 172, 332, 1200, 1024, 4096 };
+  const char* kinds[] = { "rtp", "rtp", "rtp", "sip", "sip" };
+  std::vector<char> buffer(OSS_SIP_MAX_PACKET_SIZE + 1);
+  for (std::size_t i = 0; i < buffer.size(); i++)
+    buffer[i] = (char)i;
+
+  std::cout << std::setw(6) << "kind" << std::setw(8) << "bytes"
+    << std::setw(14) << (XOR_BENCH_TSC ? "loop b/cycle" : "loop b/ns")
+    << std::setw(16) << (XOR_BENCH_TSC ? "kernel b/cycle" : "kernel b/ns")
+    << std::setw(10) << "speedup" << std::endl;
+
+  for (std::size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+  {
+    double loop = run(xor_bytes, buffer, sizes[i], iterations);
+    double kernel = run(xor_kernel, buffer, sizes[i], iterations);
+    std::cout << std::setw(6) << kinds[i] << std::setw(8) << sizes[i]
+      << std::fixed << std::setprecision(2)
+      << std::setw(14) << loop
+      << std::setw(16) << kernel
+      << std::setw(9) << kernel / loop << "x" << std::endl;
+  }
+  return 0;
+}
@@ -0,0 +1,379 @@
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "GNU Lesser General Public License (LGPL)".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+
+#include "OSS/JS/JSCodeCache.h"
+#include "OSS/JS/JS.h"
+#include "OSS/UTL/Logger.h"
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <cstdlib>
+#include <cstdio>
+#include <unistd.h>
+#include <boost/filesystem.hpp>
+
+
+namespace OSS {
+namespace JS {
+
+
+static const OSS::UInt64 FNV_OFFSET_BASIS = 14695981039346656037ULL;
+static const OSS::UInt64 FNV_PRIME = 1099511628211ULL;
+
+static OSS::UInt64 fnv1a(OSS::UInt64 hash, const char* data, std::size_t size)
+{
+  for (std::size_t i = 0; i < size; i++)
+  {
+    hash ^= (uint8_t)data[i];
+    hash *= FNV_PRIME;
+  }
+  return hash;
+}
+
+JSCodeCache& JSCodeCache::instance()
+{
+  static JSCodeCache cache;
+  return cache;
+}
+
+JSCodeCache::JSCodeCache() :
+  _size(0),
+  _maxSize(DEFAULT_MAX_SIZE),
+  _enabled(true)
+{
+  const char* enabled = getenv("OSS_JS_CODE_CACHE");
+  if (enabled && std::string(enabled) == "0")
+  {
+    _enabled = false;
+  }
+
+  const char* maxSize = getenv("OSS_JS_CODE_CACHE_SIZE");
+  if (maxSize)
+  {
+    _maxSize = strtoul(maxSize, 0, 10);
+  }
+
+  const char* directory = getenv("OSS_JS_CODE_CACHE_DIR");
+  if (directory)
+  {
+    _directory = directory;
+  }
+  else
+  {
+    _directory = OSS::system_localstatedir() + "/cache/oss_core/js";
+  }
+}
+
+JSCodeCache::~JSCodeCache()
+{
+}
+
+void JSCodeCache::setEnabled(bool enabled)
+{
+  OSS::mutex_critic_sec_lock lock(_mutex);
+  _enabled = enabled;
+}
+
+bool JSCodeCache::isEnabled() const
+{
+  OSS::mutex_critic_sec_lock lock(_mutex);
+  return _enabled;
+}
+
+void JSCodeCache::setDirectory(const std::string& directory)
+{
+  OSS::mutex_critic_sec_lock lock(_mutex);
+  _directory = directory;
+}
+
+std::string JSCodeCache::getDirectory() const
+{
+  OSS::mutex_critic_sec_lock lock(_mutex);
+  return _directory;
+}
+
+void JSCodeCache::setMaxSize(std::size_t size)
+{
+  OSS::mutex_critic_sec_lock lock(_mutex);
+  _maxSize = size;
+  evict();
+}
+
+std::size_t JSCodeCache::getMaxSize() const
+{
+  OSS::mutex_critic_sec_lock lock(_mutex);
+  return _maxSize;
+}
+
+void JSCodeCache::clear()
+{
+  OSS::mutex_critic_sec_lock lock(_mutex);
+  _entries.clear();
+  _lru.clear();
+  _size = 0;
+}
+
+JSCodeCache::Stats JSCodeCache::getStats() const
+{
+  OSS::mutex_critic_sec_lock lock(_mutex);
+  Stats stats = _stats;
+  stats.entries = _entries.size();
+  stats.size = _size;
+  return stats;
+}
+
+void JSCodeCache::insert(OSS::UInt64 key, const DataPtr& data)
+{
+  Entries::iterator iter = _entries.find(key);
+  if (iter != _entries.end())
+  {
+    remove(iter);
+  }
+  Entry& entry = _entries[key];
+  entry.data = data;
+  entry.lru = _lru.insert(_lru.begin(), key);
+  _size += data->size();
+  evict();
+}
+
+void JSCodeCache::remove(Entries::iterator iter)
+{
+  _size -= iter->second.data->size();
+  _lru.erase(iter->second.lru);
+  _entries.erase(iter);
+}
+
+void JSCodeCache::evict()
+{
+  while (_size > _maxSize && !_lru.empty())
+  {
+    remove(_entries.find(_lru.back()));
+    _stats.evictions++;
+  }
+}
+
+OSS::UInt64 JSCodeCache::getKey(const std::string& source, const std::string& name) const
+{
+  //
+  // The version tag covers the engine version and the flags that affect
+  // code generation so different builds never share a file
+  //
+  uint32_t tag = v8::ScriptCompiler::CachedDataVersionTag();
+  OSS::UInt64 hash = fnv1a(FNV_OFFSET_BASIS, (const char*)&tag, sizeof(tag));
+  hash = fnv1a(hash, name.data(), name.size() + 1);
+  return fnv1a(hash, source.data(), source.size());
+}
+
+bool JSCodeCache::isPersistent(const std::string& name) const
+{
+  if (_directory.empty() || name.empty())
+  {
+    return false;
+  }
+  boost::system::error_code ec;
+  return boost::filesystem::is_regular_file(boost::filesystem::path(name.c_str()), ec);
+}
+
+std::string JSCodeCache::getFileName(const std::string& name) const
+{
+  uint32_t tag = v8::ScriptCompiler::CachedDataVersionTag();
+  OSS::UInt64 hash = fnv1a(FNV_OFFSET_BASIS, (const char*)&tag, sizeof(tag));
+  hash = fnv1a(hash, name.data(), name.size());
+  std::ostringstream strm;
+  strm << _directory << "/" << std::hex << std::setw(16) << std::setfill('0') << hash << ".jsc";
+  return strm.str();
+}
+
+JSCodeCache::DataPtr JSCodeCache::find(OSS::UInt64 key, const std::string& name)
+{
+  OSS::mutex_critic_sec_lock lock(_mutex);
+  Entries::iterator iter = _entries.find(key);
+  if (iter != _entries.end())
+  {
+    _lru.splice(_lru.begin(), _lru, iter->second.lru);
+    return iter->second.data;
+  }
+
+  if (!isPersistent(name))
+  {
+    return DataPtr();
+  }
+
+  std::ifstream file(getFileName(name).c_str(), std::ios::in | std::ios::binary);
+  if (!file.is_open())
+  {
+    return DataPtr();
+  }
+  file.seekg(0, std::ios::end);
+  std::streamoff size = file.tellg() - (std::streamoff)sizeof(key);
+  if (size <= 0)
+  {
+    return DataPtr();
+  }
+
+  //
+  // A file created from an older version of the script is left for store()
+  // to overwrite
+  //
+  OSS::UInt64 fileKey = 0;
+  file.seekg(0, std::ios::beg);
+  if (!file.read((char*)&fileKey, sizeof(fileKey)) || fileKey != key)
+  {
+    return DataPtr();
+  }
+  DataPtr data(new Data((std::size_t)size));
+  if (!file.read((char*)&(*data)[0], size))
+  {
+    return DataPtr();
+  }
+  insert(key, data);
+  return data;
+}
+
+void JSCodeCache::store(OSS::UInt64 key, const std::string& name, const DataPtr& data)
+{
+  OSS::mutex_critic_sec_lock lock(_mutex);
+  insert(key, data);
+
+  if (!isPersistent(name))
+  {
+    return;
+  }
+
+  try
+  {
+    boost::filesystem::create_directories(boost::filesystem::path(_directory.c_str()));
+  }
+  catch(...)
+  {
+    OSS_LOG_WARNING("JSCodeCache::store - Unable to create " << _directory << ".  Code cache is kept in memory only.");
+    _directory = std::string();
+    return;
+  }
+
+  //
+  // Write to a temporary file first so that a process starting at the same
+  // time never reads a partial cache
+  //
+  std::string fileName = getFileName(name);
+  std::ostringstream tempName;
+  tempName << fileName << "." << getpid();
+  std::ofstream file(tempName.str().c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+  if (!file.is_open())
+  {
+    return;
+  }
+  file.write((const char*)&key, sizeof(key));
+  file.write((const char*)&(*data)[0], data->size());
+  file.close();
+  if (!file || rename(tempName.str().c_str(), fileName.c_str()) != 0)
+  {
+    unlink(tempName.str().c_str());
+  }
+}
+
+void JSCodeCache::erase(OSS::UInt64 key, const std::string& name)
+{
+  OSS::mutex_critic_sec_lock lock(_mutex);
+  Entries::iterator iter = _entries.find(key);
+  if (iter != _entries.end())
+  {
+    remove(iter);
+  }
+  _stats.rejects++;
+  if (isPersistent(name))
+  {
+    unlink(getFileName(name).c_str());
+  }
+}
+
+v8::MaybeLocal<v8::Script> JSCodeCache::compile(v8::Local<v8::Context> context, const std::string& source, const std::string& name)
+{
+  v8::Isolate* isolate = context->GetIsolate();
+  JSStringHandle script = JSString(isolate, source.data(), source.size());
+  JSValueHandle resourceName;
+  if (name.empty())
+  {
+    resourceName = v8::Undefined(isolate);
+  }
+  else
+  {
+    resourceName = JSString(isolate, name.data(), name.size());
+  }
+  v8::ScriptOrigin origin(resourceName);
+
+  if (!isEnabled())
+  {
+    return v8::Script::Compile(context, script, &origin);
+  }
+
+  OSS::UInt64 key = getKey(source, name);
+  DataPtr data = find(key, name);
+  if (data)
+  {
+    //
+    // The source does not own the buffer.  data keeps it alive until the
+    // compiler is done with it.
+    //
+    v8::ScriptCompiler::CachedData* cached = new v8::ScriptCompiler::CachedData(
+      &(*data)[0], data->size(), v8::ScriptCompiler::CachedData::BufferNotOwned);
+    v8::ScriptCompiler::Source compilerSource(script, origin, cached);
+    v8::MaybeLocal<v8::Script> compiled = v8::ScriptCompiler::Compile(context, &compilerSource, v8::ScriptCompiler::kConsumeCodeCache);
+    if (!compilerSource.GetCachedData()->rejected)
+    {
+      OSS::mutex_critic_sec_lock lock(_mutex);
+      _stats.hits++;
+      return compiled;
+    }
+    OSS_LOG_DEBUG("JSCodeCache::compile - Code cache for " << (name.empty() ? "<source>" : name) << " rejected");
+    erase(key, name);
+  }
+
+  {
+    OSS::mutex_critic_sec_lock lock(_mutex);
+    _stats.misses++;
+  }
+
+  //
+  // Compile every function now so the cache covers the whole script and not
+  // only its top level
+  //
+  v8::ScriptCompiler::Source compilerSource(script, origin);
+  v8::MaybeLocal<v8::Script> compiled = v8::ScriptCompiler::Compile(context, &compilerSource, v8::ScriptCompiler::kEagerCompile);
+  v8::Local<v8::Script> compiledScript;
+  if (!compiled.ToLocal(&compiledScript))
+  {
+    return compiled;
+  }
+
+  v8::ScriptCompiler::CachedData* cached = v8::ScriptCompiler::CreateCodeCache(compiledScript->GetUnboundScript());
+  if (cached)
+  {
+    if (cached->length > 0)
+    {
+      store(key, name, DataPtr(new Data(cached->data, cached->data + cached->length)));
+    }
+    delete cached;
+  }
+  return compiled;
+}
+
+
+} } // OSS::JS
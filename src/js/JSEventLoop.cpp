@@ -19,11 +19,54 @@
 
 #include "OSS/JS/JSEventLoop.h"
 #include "OSS/JS/JSIsolate.h"
+#include "OSS/UTL/Logger.h"
+#include <sys/epoll.h>
+#include <poll.h>
+#include <errno.h>
 
 namespace OSS {
 namespace JS {
 
 
+//
+// epoll_event data layout.  The watch type, the poll events that were
+// requested and the descriptor.
+//
+static const int WATCH_TYPE_SHIFT = 48;
+static const int WATCH_EVENTS_SHIFT = 32;
+
+static OSS::UInt32 to_epoll_events(int events)
+{
+  OSS::UInt32 result = 0;
+  if (events & POLLIN)
+    result |= EPOLLIN;
+  if (events & POLLPRI)
+    result |= EPOLLPRI;
+  if (events & POLLOUT)
+    result |= EPOLLOUT;
+  if (events & POLLRDHUP)
+    result |= EPOLLRDHUP;
+  return result;
+}
+
+static short to_poll_events(OSS::UInt32 events)
+{
+  short result = 0;
+  if (events & EPOLLIN)
+    result |= POLLIN;
+  if (events & EPOLLPRI)
+    result |= POLLPRI;
+  if (events & EPOLLOUT)
+    result |= POLLOUT;
+  if (events & EPOLLRDHUP)
+    result |= POLLRDHUP;
+  if (events & EPOLLERR)
+    result |= POLLERR;
+  if (events & EPOLLHUP)
+    result |= POLLHUP;
+  return result;
+}
+
 JSEventLoop::JSEventLoop(JSIsolate* pIsolate) :
   _isTerminated(false),
   _pIsolate(pIsolate),
@@ -34,12 +77,25 @@ JSEventLoop::JSEventLoop(JSIsolate* pIsolate) :
   _functionCallback(this),
   _timerManager(this),
   _interIsolate(this),
-  _garbageCollectionFrequency(30)
+  _garbageCollectionFrequency(30),
+  _epollFd(epoll_create1(EPOLL_CLOEXEC)),
+  _turnBudget(DEFAULT_TURN_BUDGET)
 {
+  if (_epollFd == -1)
+  {
+    OSS_LOG_ERROR("JSEventLoop - epoll_create1 failed errno=" << errno);
+    return;
+  }
+  watch(getFd(), POLLIN, WATCH_WAKEUP);
+  watch(_functionCallback.getFd(), POLLIN, WATCH_CALLBACK);
 }
 
 JSEventLoop::~JSEventLoop()
 {
+  if (_epollFd != -1)
+  {
+    close(_epollFd);
+  }
 }
 
 JSIsolate* JSEventLoop::getIsolate()
@@ -47,65 +103,80 @@ JSIsolate* JSEventLoop::getIsolate()
   return _pIsolate;
 }
 
+bool JSEventLoop::watch(int fd, int events, WatchType type)
+{
+  if (_epollFd == -1)
+  {
+    return false;
+  }
+  
+  //
+  // ERR and HUP are always reported by epoll and need not be requested
+  //
+  epoll_event event;
+  event.events = to_epoll_events(events);
+  event.data.u64 = ((OSS::UInt64)type << WATCH_TYPE_SHIFT) |
+    ((OSS::UInt64)(unsigned short)events << WATCH_EVENTS_SHIFT) |
+    (OSS::UInt32)fd;
+  if (epoll_ctl(_epollFd, EPOLL_CTL_ADD, fd, &event) == 0)
+  {
+    return true;
+  }
+  if (errno == EEXIST && epoll_ctl(_epollFd, EPOLL_CTL_MOD, fd, &event) == 0)
+  {
+    return true;
+  }
+  OSS_LOG_ERROR("JSEventLoop::watch - Unable to monitor fd " << fd << " errno=" << errno);
+  return false;
+}
+
+void JSEventLoop::unwatch(int fd)
+{
+  //
+  // Fails with EBADF if the descriptor was closed before it was unmonitored.
+  // The kernel already dropped the registration in that case.
+  //
+  if (_epollFd == -1)
+  {
+    return;
+  }
+  epoll_event event;
+  epoll_ctl(_epollFd, EPOLL_CTL_DEL, fd, &event);
+}
+
 void JSEventLoop::processEvents()
 {
   OSS::UInt64 lastGarbageCollectionTime = 0;
   
   OSS::JS::JSIsolate::Ptr pIsolate = OSS::JS::JSIsolate::getIsolate();
 
-  std::vector<pollfd> descriptors;
-  bool reconstructFdSet = true;
+  if (_epollFd == -1)
+  {
+    OSS_LOG_ERROR("JSEventLoop::processEvents - No epoll descriptor.  Event loop will not run.");
+    return;
+  }
+
+  std::vector<epoll_event> events(MAX_EVENTS_PER_WAIT);
+  bool hasPending = false;
   
-  //
-  // Static Descriptors
-  //
-  pollfd pfds[3];
-  pfds[0].fd = this->getFd();
-  pfds[0].events = POLLIN;
-  pfds[0].revents = 0;
-  pfds[1].fd = _functionCallback.getFd();
-  pfds[1].events = POLLIN;
-  pfds[1].revents = 0;
-  pfds[2].fd = _timerManager.getFd();
-  pfds[2].events = POLLIN;
-  pfds[2].revents = 0;
   while (!_isTerminated)
   {
-    if (reconstructFdSet)
+    //
+    // Do not sleep if the previous turn ran out of budget.  Descriptors
+    // are level triggered and would be reported again anyway but queued
+    // tasks and timers have no descriptor of their own.
+    //
+    int timeout = hasPending ? 0 : _timerManager.getTimeout(IDLE_TIMEOUT_MS);
+    int ret = ::epoll_wait(_epollFd, events.data(), events.size(), timeout);
+    if (ret == -1 && errno == EINTR)
     {
-      descriptors.clear();
-      descriptors.reserve(_queueManager.getSize() + 3);
-      descriptors.push_back(pfds[0]);
-      descriptors.push_back(pfds[1]);
-      descriptors.push_back(pfds[2]);
-      
-      _queueManager.appendDescriptors(descriptors);
-      _fdManager.appendDescriptors(descriptors);
+      continue;
     }
-    int ret = ::poll(descriptors.data(), descriptors.size(), 100);
     v8::HandleScope scope( pIsolate->getV8Isolate() );
     if (ret == -1 || _isTerminated)
     {
       break;
     }
-    else if (ret == 0)
-    {
-      //
-      // Use the timeout to let V8 perform internal garbage collection tasks
-      //
-      if (_pIsolate->isRoot())
-      {
-        OSS::UInt64 now = OSS::getTime();
-        if (now - lastGarbageCollectionTime > _garbageCollectionFrequency * 1000)
-        {
-           pIsolate->getV8Isolate()->LowMemoryNotification();
-          lastGarbageCollectionTime = now;
-        }
-        // while(!pIsolate->getV8Isolate()->IdleNotification()); 
-        // V8 6.5 API Changes: Do not use idle notification at all. This function  has been a no-op for almost all calls for a while now.
-        continue;
-      }
-    }
     
     //
     // Perform garbage collection every 30 seconds
@@ -121,67 +192,65 @@ void JSEventLoop::processEvents()
     }
     
     //
-    // Check if C++ just wants to execute a task in the event loop
+    // Clear the wakeup pipe before draining the queues.  A task queued
+    // after this point writes a new byte and is picked up next turn.
     //
-    if (_taskManager.doOneWork() || _interIsolate.doOneWork())
+    for (int i = 0; i < ret; i++)
     {
-      //
-      // Do not reconstruct fdset if we did some tasks
-      //
-      reconstructFdSet = false;
-      continue;
-    }
-    
-    //
-    // From this point onwards, we only reconstruct the FD set if we are waken up via the wakeup pipe
-    //
-    reconstructFdSet = false;
-    if (descriptors[0].revents & POLLIN)
-    {
-      this->clearOne();
-      if (_isTerminated)
+      if ((events[i].data.u64 >> WATCH_TYPE_SHIFT) == WATCH_WAKEUP)
       {
+        this->clearAll();
         break;
       }
-      else
-      {
-        reconstructFdSet = true;
-        continue;
-      }
     }
-    else if (descriptors[1].revents & POLLIN)
+    if (_isTerminated)
+    {
+      break;
+    }
+    
+    hasPending = false;
+    
+    //
+    // Tasks C++ wants to execute in the event loop
+    //
+    if (_taskManager.doWork(_turnBudget) == _turnBudget)
     {
-      _functionCallback.doOneWork();
+      hasPending = true;
     }
-    else if (descriptors[2].revents & POLLIN)
+    if (_interIsolate.doWork(_turnBudget) == _turnBudget)
     {
-      _timerManager.doOneWork();
+      hasPending = true;
     }
-    else
+    
+    for (int i = 0; i < ret && !_isTerminated; i++)
     {
-      bool found = false;
-      std::size_t fdsize = descriptors.size();
-
-      for (std::size_t i = 3; i < fdsize; i++)
+      int fd = (int)(events[i].data.u64 & 0xFFFFFFFF);
+      switch (events[i].data.u64 >> WATCH_TYPE_SHIFT)
       {
-        pollfd& pfd = descriptors[i];
-        int revents = pfd.revents;
-        if (revents & POLLIN)
-        {
-
-          found = _queueManager.dequeue(pfd.fd);
-          if (!found)
-          {
-            found = _fdManager.signalIO(_pIsolate->getV8Isolate(), pfd);
-          }
-        }
-        
-        if (found)
+      case WATCH_CALLBACK:
+        _functionCallback.doWork(_turnBudget);
+        break;
+      case WATCH_QUEUE:
+        _queueManager.dequeue(fd, _turnBudget);
+        break;
+      case WATCH_DESCRIPTOR:
         {
-          break;
+          pollfd pfd;
+          pfd.fd = fd;
+          pfd.events = (short)((events[i].data.u64 >> WATCH_EVENTS_SHIFT) & 0xFFFF);
+          pfd.revents = to_poll_events(events[i].events);
+          _fdManager.signalIO(_pIsolate->getV8Isolate(), pfd);
         }
+        break;
+      default:
+        break;
       }
     }
+    
+    if (_timerManager.doWork(_turnBudget) == _turnBudget)
+    {
+      hasPending = true;
+    }
   }
 }
 
@@ -39,12 +39,14 @@ void JSEventQueueManager::addQueue(QueueObject* pQueue)
 {
   OSS::mutex_lock lock(_queuesMutex);
   _queues[pQueue->_queue.getFd()] = pQueue;
+  _pEventLoop->watch(pQueue->_queue.getFd(), POLLIN, JSEventLoop::WATCH_QUEUE);
 }
 
 void JSEventQueueManager::removeQueue(QueueObject* pQueue)
 {
   OSS::mutex_lock lock(_queuesMutex);
   _queues.erase(pQueue->_queue.getFd());
+  _pEventLoop->unwatch(pQueue->_queue.getFd());
 }
 
 QueueObject* JSEventQueueManager::findQueue(int fd)
@@ -92,17 +94,22 @@ bool JSEventQueueManager::dequeue(int fd)
   return false;
 }
 
-void JSEventQueueManager::appendDescriptors(Descriptors& descriptors)
+std::size_t JSEventQueueManager::dequeue(int fd, std::size_t budget)
 {
-  OSS::mutex_lock lock(_queuesMutex);
-  for(QueueObjectMap::iterator iter = _queues.begin(); iter != _queues.end(); iter++)
+  std::size_t count = 0;
+  while (count < budget)
   {
-    pollfd fd;
-    fd.fd = iter->first;
-    fd.events = POLLIN;
-    fd.revents = 0;
-    descriptors.push_back(fd);
+    //
+    // Looked up on every pass since the callback may destroy the queue
+    //
+    QueueObject* pQueue = findQueue(fd);
+    if (!pQueue || !pQueue->_queue.size() || !dequeue(fd))
+    {
+      break;
+    }
+    count++;
   }
+  return count;
 }
 
 
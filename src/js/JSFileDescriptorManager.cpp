@@ -42,6 +42,7 @@ void JSFileDescriptorManager::addFileDescriptor(v8::Isolate* isolate, int fd, v8
 {
   OSS::mutex_critic_sec_lock lock(_descriptorsMutex);
   _descriptors[fd] = JSFileDescriptor::Ptr(new JSFileDescriptor(isolate, ioHandler, fd, events));
+  _pEventLoop->watch(fd, events, JSEventLoop::WATCH_DESCRIPTOR);
 }
 
 bool JSFileDescriptorManager::removeFileDescriptor(int fd)
@@ -50,6 +51,7 @@ bool JSFileDescriptorManager::removeFileDescriptor(int fd)
   if (_descriptors.find(fd) != _descriptors.end())
   {
     _descriptors.erase(fd);
+    _pEventLoop->unwatch(fd);
     return true;
   }
   return false;
@@ -66,15 +68,6 @@ JSFileDescriptor::Ptr JSFileDescriptorManager::findDescriptor(int fd)
   return JSFileDescriptor::Ptr();
 }
 
-void JSFileDescriptorManager::appendDescriptors(Descriptors& descriptors)
-{
-  OSS::mutex_critic_sec_lock lock(_descriptorsMutex);
-  for (DescriptorMap::const_iterator iter = _descriptors.begin(); iter != _descriptors.end(); iter++)
-  {
-    descriptors.push_back(iter->second->pollFd());
-  }
-}
-
 bool JSFileDescriptorManager::signalIO(v8::Isolate* isolate, pollfd pfd)
 {
   _descriptorsMutex.lock();
@@ -68,6 +68,20 @@ bool JSFunctionCallbackQueue::doOneWork()
   return true;
 }
 
+std::size_t JSFunctionCallbackQueue::doWork(std::size_t budget)
+{
+  //
+  // Take the whole turn's worth of callbacks with one lock
+  //
+  std::vector<JSFunctionCallback::Ptr> callbacks;
+  std::size_t count = dequeueBatch(callbacks, budget, 0);
+  for (std::size_t i = 0; i < count; i++)
+  {
+    callbacks[i]->execute();
+  }
+  return count;
+}
+
 int JSFunctionCallbackQueue::getFd() const
 {
   return BlockingQueue<JSFunctionCallback::Ptr>::getFd();
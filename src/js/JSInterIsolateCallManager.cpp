@@ -63,6 +63,11 @@ bool JSInterIsolateCallManager::doOneWork()
   {
     return false;
   }
+  if (pCall->isStructured())
+  {
+    executeStructured(pCall);
+    return true;
+  }
   v8::HandleScope _scope_(getIsolate()->getV8Isolate());
   JSLocalObjectHandle pUserData = getIsolate()->wrapExternalPointer(pCall->getUserData());
   JSValueHandle request = getIsolate()->parseJSON(pCall->json());
@@ -117,6 +122,126 @@ bool JSInterIsolateCallManager::doOneWork()
   return true;
 }
 
+std::size_t JSInterIsolateCallManager::doWork(std::size_t budget)
+{
+  //
+  // doOneWork() returns false when the handler throws.  Count the call as
+  // handled anyway so one failing request does not stall the rest.
+  //
+  std::size_t count = doNotifications(budget);
+  for (; count < budget; count++)
+  {
+    {
+      OSS::mutex_critic_sec_lock lock(_queueMutex);
+      if (_queue.empty())
+      {
+        break;
+      }
+    }
+    doOneWork();
+  }
+  return count;
+}
+
+std::size_t JSInterIsolateCallManager::doNotifications(std::size_t budget)
+{
+  NotificationQueue batch;
+  {
+    OSS::mutex_critic_sec_lock lock(_notificationMutex);
+    while (!_notifications.empty() && batch.size() < budget)
+    {
+      batch.push_back(_notifications.front());
+      _notifications.pop_front();
+    }
+  }
+  for (NotificationQueue::iterator iter = batch.begin(); iter != batch.end(); iter++)
+  {
+    v8::HandleScope _scope_(getIsolate()->getV8Isolate());
+    v8::TryCatch tryCatch(getIsolate()->getV8Isolate());
+    tryCatch.SetVerbose(true);
+    callStructuredHandler(iter->message, iter->userData);
+  }
+  return batch.size();
+}
+
+v8::MaybeLocal<v8::Value> JSInterIsolateCallManager::callStructuredHandler(const JSStructuredMessage::Ptr& message, void* userData)
+{
+  v8::Isolate* isolate = getIsolate()->getV8Isolate();
+  if (_structuredHandler.IsEmpty() || !message)
+  {
+    return v8::MaybeLocal<v8::Value>();
+  }
+  v8::Local<v8::Value> request;
+  if (!message->deserialize(isolate).ToLocal(&request))
+  {
+    return v8::MaybeLocal<v8::Value>();
+  }
+  JSArgumentVector args;
+  args.push_back(request);
+  args.push_back(getIsolate()->wrapExternalPointer(userData));
+  JSFunctionHandle handler = JSFunctionHandle::New(isolate, _structuredHandler);
+  return handler->Call(isolate->GetCurrentContext(), getIsolate()->getGlobal(), args.size(), args.data());
+}
+
+void JSInterIsolateCallManager::executeStructured(const JSInterIsolateCall::Ptr& pCall)
+{
+  v8::Isolate* isolate = getIsolate()->getV8Isolate();
+  v8::HandleScope _scope_(isolate);
+  v8::TryCatch tryCatch(isolate);
+  tryCatch.SetVerbose(true);
+  //
+  // Always fulfill the promise.  An empty result tells the caller the
+  // handler failed instead of leaving it blocked.
+  //
+  JSStructuredMessage::Ptr result(new JSStructuredMessage());
+  v8::Local<v8::Value> value;
+  if (callStructuredHandler(pCall->getStructuredRequest(), pCall->getUserData()).ToLocal(&value))
+  {
+    result->serialize(isolate, value);
+  }
+  pCall->setStructuredResult(result);
+}
+
+bool JSInterIsolateCallManager::execute(const JSStructuredMessage::Ptr& request, JSStructuredMessage::Ptr& result, uint32_t timeout, void* userData)
+{
+  bool delegateToSelf = getIsolate()->isThreadSelf();
+  JSInterIsolateCall::Ptr pCall(new JSInterIsolateCall(request, timeout, userData));
+  enqueue(pCall);
+
+  if (delegateToSelf)
+  {
+    doOneWork();
+  }
+  else
+  {
+    getEventLoop()->wakeup();
+  }
+
+  if (!pCall->waitForResult())
+  {
+    return false;
+  }
+  result = pCall->getStructuredResult();
+  return true;
+}
+
+void JSInterIsolateCallManager::notify(const JSStructuredMessage::Ptr& request, void* userData)
+{
+  Notification notification;
+  notification.message = request;
+  notification.userData = userData;
+  bool wasEmpty = false;
+  {
+    OSS::mutex_critic_sec_lock lock(_notificationMutex);
+    wasEmpty = _notifications.empty();
+    _notifications.push_back(notification);
+  }
+  if (wasEmpty)
+  {
+    getEventLoop()->wakeup();
+  }
+}
+
 bool JSInterIsolateCallManager::execute(const Request& request, Result& result, uint32_t timeout, void* userData)
 {
   bool delegateToSelf = getIsolate()->isThreadSelf();
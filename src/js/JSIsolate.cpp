@@ -30,6 +30,7 @@
 #include "OSS/UTL/Logger.h"
 #include "OSS/JS/JSPluginManager.h"
 #include "OSS/JS/JSTask.h"
+#include "OSS/JS/JSCodeCache.h"
 
 
 namespace OSS {
@@ -143,16 +144,13 @@ void JSIsolate::internal_run()
   if (_source.empty())
   {
     std::string strScriptSource = read_file_skip_shebang(OSS::boost_path(_script), true);
-    v8::Handle<v8::String> scriptSource = JSString( _pIsolate, strScriptSource );
-    v8::ScriptOrigin scriptOrigin(JSString(_pIsolate, OSS::boost_path(_script) ) );
-    maybeCompiledScript = v8::Script::Compile(context, scriptSource, &scriptOrigin );
+    maybeCompiledScript = JSCodeCache::instance().compile(context, strScriptSource, OSS::boost_path(_script));
   }
   else
   {
     std::ostringstream strm;
     strm << "try { " << _source << " } catch(e) {console.printStackTrace(e); _exit(-1); } ;async.processEvents();";
-    v8::Handle<v8::String> scriptSource = JSString( _pIsolate, strm.str());
-    maybeCompiledScript = v8::Script::Compile(context, scriptSource);
+    maybeCompiledScript = JSCodeCache::instance().compile(context, strm.str(), std::string());
   }
   
   if (maybeCompiledScript.IsEmpty())
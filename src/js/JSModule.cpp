@@ -28,6 +28,7 @@
 #include "OSS/UTL/Logger.h"
 #include "OSS/JS/JSIsolate.h"
 #include "OSS/JS/JSIsolateManager.h"
+#include "OSS/JS/JSCodeCache.h"
 
 
 namespace OSS {
@@ -52,8 +53,7 @@ static JS_METHOD_IMPL(js_include)
     std::string fileName = string_from_js_value(js_method_isolate(), _args_[i]);
     if (boost::filesystem::exists(fileName))
     {
-      v8::Handle<v8::String> script = js_method_string( read_file(fileName) );
-      v8::MaybeLocal<v8::Script> maybeCompiled = v8::Script::Compile(js_method_context(),script);
+      v8::MaybeLocal<v8::Script> maybeCompiled = JSCodeCache::instance().compile(js_method_context(), read_file(fileName), fileName);
       if( maybeCompiled.IsEmpty() )
       {
         // The TryCatch above is still in effect and will have caught the error.
@@ -372,9 +372,9 @@ static JS_METHOD_IMPL(js_compile)
   js_method_try_catch();
   _try_catch_.SetVerbose(true);
   
-  v8::Handle<v8::String> script = v8::Handle<v8::String>::Cast(_args_[0]);
-  v8::ScriptOrigin name(JSStringHandle::Cast(_args_[1]));
-  v8::MaybeLocal<v8::Script> maybeCompiled = v8::Script::Compile(js_method_context(),script, &name);
+  std::string script = string_from_js_value(js_method_isolate(), _args_[0]);
+  std::string name = string_from_js_value(js_method_isolate(), _args_[1]);
+  v8::MaybeLocal<v8::Script> maybeCompiled = JSCodeCache::instance().compile(js_method_context(), script, name);
   if( maybeCompiled.IsEmpty() )
   {
     // The TryCatch above is still in effect and will have caught the error.
@@ -414,10 +414,8 @@ static JS_METHOD_IMPL(js_compile_module)
   strm << "} catch(e) { e.printStackTrace(); }";
   strm << "});";
 
-  JSStringHandle script = js_method_string(strm.str()); 
-  //v8::Handle<v8::Script> compiled = v8::Script::New(script, name); // changed in V8 3.25
-  v8::ScriptOrigin name(JSStringHandle::Cast(_args_[1]));
-  v8::MaybeLocal<v8::Script> maybeCompiled = v8::Script::Compile(js_method_context(),script, &name);
+  std::string fileName = string_from_js_value(js_method_isolate(), _args_[1]);
+  v8::MaybeLocal<v8::Script> maybeCompiled = JSCodeCache::instance().compile(js_method_context(), strm.str(), fileName);
   if( maybeCompiled.IsEmpty() )
   {
     // The TryCatch above is still in effect and will have caught the error.
@@ -427,7 +425,6 @@ static JS_METHOD_IMPL(js_compile_module)
   }
   v8::Handle<v8::Script> compiled = maybeCompiled.ToLocalChecked();
 
-  std::string fileName = *v8::String::Utf8Value(js_method_isolate(),_args_[1]);
   boost::filesystem::path path(fileName.c_str());
   boost::filesystem::path parent_path = path.parent_path();
   boost::filesystem::path current_path = boost::filesystem::current_path();
@@ -540,9 +537,7 @@ bool JSModule::compileModuleHelpers(v8::Isolate* isolate, v8::TryCatch& try_catc
 
   for (ModuleHelpers::iterator iter = _moduleHelpers.begin(); iter != _moduleHelpers.end(); iter++)
   {
-    v8::Handle<v8::String> script(JSString(isolate,iter->script));
-    v8::ScriptOrigin name(JSString(isolate,iter->name));
-    v8::MaybeLocal<v8::Script> maybeCompiled = v8::Script::Compile(context,script, &name);
+    v8::MaybeLocal<v8::Script> maybeCompiled = JSCodeCache::instance().compile(context, iter->script, iter->name);
     if( maybeCompiled.IsEmpty() )
     {
       OSS_LOG_ERROR("JSModule::compileModuleHelpers is unable to compile " << iter->name);
@@ -0,0 +1,145 @@
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "GNU Lesser General Public License (LGPL)".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+
+#include "OSS/JS/JSStructuredMessage.h"
+#include <cstdlib>
+
+
+namespace OSS {
+namespace JS {
+
+
+JSStructuredMessage::JSStructuredMessage() :
+  _data(0),
+  _size(0)
+{
+}
+
+JSStructuredMessage::~JSStructuredMessage()
+{
+  clear();
+}
+
+void JSStructuredMessage::clear()
+{
+  //
+  // The serializer grows its buffer with realloc when no delegate is set
+  //
+  free(_data);
+  _data = 0;
+  _size = 0;
+#if OSS_JS_HAVE_BACKING_STORE
+  _transfers.clear();
+#endif
+}
+
+bool JSStructuredMessage::serialize(v8::Isolate* isolate, v8::Local<v8::Value> value)
+{
+  return serialize(isolate, value, v8::Local<v8::Value>());
+}
+
+bool JSStructuredMessage::serialize(v8::Isolate* isolate, v8::Local<v8::Value> value, v8::Local<v8::Value> transferList)
+{
+  clear();
+  v8::Local<v8::Context> context = isolate->GetCurrentContext();
+  v8::ValueSerializer serializer(isolate);
+
+#if OSS_JS_HAVE_BACKING_STORE
+  std::vector< v8::Local<v8::ArrayBuffer> > buffers;
+  if (!transferList.IsEmpty() && transferList->IsArray())
+  {
+    v8::Local<v8::Array> list = transferList.As<v8::Array>();
+    for (uint32_t i = 0; i < list->Length(); i++)
+    {
+      v8::Local<v8::Value> item;
+      if (!list->Get(context, i).ToLocal(&item) || !item->IsArrayBuffer())
+      {
+        continue;
+      }
+      v8::Local<v8::ArrayBuffer> buffer = item.As<v8::ArrayBuffer>();
+      if (!buffer->IsDetachable())
+      {
+        continue;
+      }
+      serializer.TransferArrayBuffer(buffers.size(), buffer);
+      buffers.push_back(buffer);
+    }
+  }
+#endif
+
+  serializer.WriteHeader();
+  bool ok = false;
+  if (!serializer.WriteValue(context, value).To(&ok) || !ok)
+  {
+    return false;
+  }
+
+  std::pair<uint8_t*, size_t> buffer = serializer.Release();
+  _data = buffer.first;
+  _size = buffer.second;
+
+#if OSS_JS_HAVE_BACKING_STORE
+  //
+  // Only detach once the value was written.  A failed clone must leave
+  // the sender's buffers usable.
+  //
+  for (std::size_t i = 0; i < buffers.size(); i++)
+  {
+    _transfers.push_back(buffers[i]->GetBackingStore());
+    buffers[i]->Detach();
+  }
+#endif
+  return true;
+}
+
+v8::MaybeLocal<v8::Value> JSStructuredMessage::deserialize(v8::Isolate* isolate)
+{
+  v8::EscapableHandleScope scope(isolate);
+  v8::Local<v8::Context> context = isolate->GetCurrentContext();
+  if (!_data)
+  {
+    return v8::MaybeLocal<v8::Value>();
+  }
+
+  v8::ValueDeserializer deserializer(isolate, _data, _size);
+  bool ok = false;
+  if (!deserializer.ReadHeader(context).To(&ok) || !ok)
+  {
+    return v8::MaybeLocal<v8::Value>();
+  }
+
+#if OSS_JS_HAVE_BACKING_STORE
+  for (std::size_t i = 0; i < _transfers.size(); i++)
+  {
+    deserializer.TransferArrayBuffer(i, v8::ArrayBuffer::New(isolate, _transfers[i]));
+  }
+  _transfers.clear();
+#endif
+
+  v8::Local<v8::Value> value;
+  if (!deserializer.ReadValue(context).ToLocal(&value))
+  {
+    return v8::MaybeLocal<v8::Value>();
+  }
+  return scope.Escape(value);
+}
+
+
+} } // OSS::JS
@@ -69,6 +69,23 @@ bool JSTaskManager::doOneWork()
   _mutex.unlock();
   return false;
 }
+
+std::size_t JSTaskManager::doWork(std::size_t budget)
+{
+  std::vector<JSTask::Ptr> tasks;
+  _mutex.lock();
+  while (!empty() && tasks.size() < budget)
+  {
+    tasks.push_back(front());
+    pop();
+  }
+  _mutex.unlock();
+  for (std::vector<JSTask::Ptr>::iterator iter = tasks.begin(); iter != tasks.end(); iter++)
+  {
+    (*iter)->execute();
+  }
+  return tasks.size();
+}
   
 
 } } // OSS::JS
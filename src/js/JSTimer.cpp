@@ -27,38 +27,26 @@ namespace JS {
 
 JSTimer::JSTimer(JSTimerManager* pManager, int id, int expire, const v8::Handle<v8::Value>& callback) :
   JSFunctionCallback(callback),
+  _expire(expire),
+  _id(id),
   _pManager(pManager)
 {
-  _timer = OSS::net_io_timer_create(expire, boost::bind(&JSTimer::onTimerExpire, this));
-  _id = id;
+  autoDisposeOnExecute() = true;
 }
 
 JSTimer::JSTimer(JSTimerManager* pManager, int id, int expire, const v8::Handle<v8::Value>& callback, const v8::Handle<v8::Value>& args) :
   JSFunctionCallback(callback, args),
+  _expire(expire),
+  _id(id),
   _pManager(pManager)
 {
-  _timer = OSS::net_io_timer_create(expire, boost::bind(&JSTimer::onTimerExpire, this));
-  _id = id;
+  autoDisposeOnExecute() = true;
 }
 
 JSTimer::~JSTimer()
 {
 }
 
-void JSTimer::onTimerExpire()
-{
-  JSTimer::Ptr pTimer = _pManager->removeTimer(_id);
-  if(pTimer)
-  {
-    //
-    // We must set autoDispose so that were are sure
-    // that it happens within the isolate thread and not here
-    //
-    pTimer->autoDisposeOnExecute() = true;
-    _pManager->execute(pTimer);
-  }
-}
-
 int JSTimer::getIdentifier() const
 {
   return _id;
@@ -69,10 +57,5 @@ int JSTimer::getExpireTime() const
   return _expire;
 }
 
-void JSTimer::cancel()
-{
-   OSS::net_io_timer_cancel(_timer);
-}
-
 
 } } // OSS::JS
@@ -21,6 +21,8 @@
 #include "OSS/JS/JS.h"
 #include "OSS/JS/JSTimerManager.h"
 #include "OSS/JS/JSEventLoop.h"
+#include "OSS/JS/JSIsolate.h"
+#include <algorithm>
 
 
 namespace OSS {
@@ -28,7 +30,7 @@ namespace JS {
 
 
 JSTimerManager::JSTimerManager(JSEventLoop* pEventLoop) :
-  JSFunctionCallbackQueue(pEventLoop),
+  JSEventLoopComponent(pEventLoop),
   _timerIdCounter(0)
 {
 }
@@ -39,31 +41,57 @@ JSTimerManager::~JSTimerManager()
 
 int JSTimerManager::scheduleTimer(int expire, const v8::Handle<v8::Value>& callback)
 {
-  OSS::mutex_critic_sec_lock lock(_timersMutex);
-  int id = ++_timerIdCounter;
-  JSTimer::Ptr pTimer = JSTimer::Ptr(new JSTimer(this, id, expire,  callback));
-  _timers[id] = pTimer;
+  int id = 0;
+  {
+    OSS::mutex_critic_sec_lock lock(_timersMutex);
+    id = ++_timerIdCounter;
+  }
+  addTimer(id, expire, JSTimer::Ptr(new JSTimer(this, id, expire,  callback)));
   return id;
 }
 
 int JSTimerManager::scheduleTimer(int expire, const v8::Handle<v8::Value>& callback, const v8::Handle<v8::Value>& args)
 {
-  OSS::mutex_critic_sec_lock lock(_timersMutex);
-  int id = ++_timerIdCounter;
-  JSTimer::Ptr pTimer = JSTimer::Ptr(new JSTimer(this, id, expire,  callback,  args));
-  _timers[id] = pTimer;
+  int id = 0;
+  {
+    OSS::mutex_critic_sec_lock lock(_timersMutex);
+    id = ++_timerIdCounter;
+  }
+  addTimer(id, expire, JSTimer::Ptr(new JSTimer(this, id, expire,  callback,  args)));
   return id;
 }
 
-void JSTimerManager::cancelTimer(int timerId)
+void JSTimerManager::addTimer(int id, int expire, const JSTimer::Ptr& pTimer)
 {
-  JSTimer::Ptr pTimer = removeTimer(timerId);
-  if (pTimer)
+  Deadline deadline;
+  deadline.expire = OSS::getTime() + (expire > 0 ? expire : 0);
+  deadline.id = id;
+
+  bool isEarliest = false;
+  {
+    OSS::mutex_critic_sec_lock lock(_timersMutex);
+    _timers[deadline.id] = pTimer;
+    _deadlines.push_back(deadline);
+    std::push_heap(_deadlines.begin(), _deadlines.end());
+    isEarliest = _deadlines.front().id == deadline.id;
+  }
+
+  //
+  // The event loop computes its poll timeout from the earliest deadline.
+  // Only a timer scheduled from another thread that moves it forward
+  // needs to interrupt the current wait.
+  //
+  if (isEarliest && !getIsolate()->isThreadSelf())
   {
-    dynamic_cast<JSTimer*>(pTimer.get())->cancel();
+    _pEventLoop->wakeup();
   }
 }
 
+void JSTimerManager::cancelTimer(int timerId)
+{
+  removeTimer(timerId);
+}
+
 JSTimer::Ptr JSTimerManager::removeTimer(int timerId)
 {
   OSS::mutex_critic_sec_lock lock(_timersMutex);
@@ -72,11 +100,99 @@ JSTimer::Ptr JSTimerManager::removeTimer(int timerId)
   if (iter != _timers.end())
   {
     pTimer = iter->second;
-    _timers.erase(timerId);
+    _timers.erase(iter);
+    compact();
   }
   return pTimer;
 }
 
+void JSTimerManager::compact()
+{
+  //
+  // Long timers that are set and cleared at a high rate would otherwise
+  // pile up in the heap until their deadline is reached
+  //
+  if (_deadlines.size() < 64 || _deadlines.size() < _timers.size() * 2)
+  {
+    return;
+  }
+  Deadlines deadlines;
+  deadlines.reserve(_timers.size());
+  for (Deadlines::const_iterator iter = _deadlines.begin(); iter != _deadlines.end(); iter++)
+  {
+    if (_timers.find(iter->id) != _timers.end())
+    {
+      deadlines.push_back(*iter);
+    }
+  }
+  std::make_heap(deadlines.begin(), deadlines.end());
+  _deadlines.swap(deadlines);
+}
+
+int JSTimerManager::getTimeout(int maxTimeout)
+{
+  OSS::mutex_critic_sec_lock lock(_timersMutex);
+  while (!_deadlines.empty() && _timers.find(_deadlines.front().id) == _timers.end())
+  {
+    std::pop_heap(_deadlines.begin(), _deadlines.end());
+    _deadlines.pop_back();
+  }
+  if (_deadlines.empty())
+  {
+    return maxTimeout;
+  }
+  OSS::UInt64 now = OSS::getTime();
+  OSS::UInt64 expire = _deadlines.front().expire;
+  if (expire <= now)
+  {
+    return 0;
+  }
+  return expire - now < (OSS::UInt64)maxTimeout ? (int)(expire - now) : maxTimeout;
+}
+
+std::size_t JSTimerManager::doWork(std::size_t budget)
+{
+  std::size_t fired = 0;
+  OSS::UInt64 now = OSS::getTime();
+  int lastId = 0;
+  {
+    OSS::mutex_critic_sec_lock lock(_timersMutex);
+    lastId = _timerIdCounter;
+  }
+  while (fired < budget)
+  {
+    JSTimer::Ptr pTimer;
+    {
+      OSS::mutex_critic_sec_lock lock(_timersMutex);
+      //
+      // Timers scheduled by the callbacks fired here wait for the next
+      // turn so a setTimeout(fn, 0) chain can not starve descriptors
+      //
+      if (_deadlines.empty() || _deadlines.front().expire > now || _deadlines.front().id > lastId)
+      {
+        break;
+      }
+      int id = _deadlines.front().id;
+      std::pop_heap(_deadlines.begin(), _deadlines.end());
+      _deadlines.pop_back();
+      TimerMap::iterator iter = _timers.find(id);
+      if (iter == _timers.end())
+      {
+        continue;
+      }
+      pTimer = iter->second;
+      _timers.erase(iter);
+    }
+    //
+    // Executed without the lock since the callback will usually schedule
+    // or cancel other timers
+    //
+    pTimer->execute();
+    fired++;
+  }
+  return fired;
+}
+
 } } // OSSJS
 
 
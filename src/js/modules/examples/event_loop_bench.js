@@ -0,0 +1,106 @@
+"use-strict";
+
+//
+// Measures how many events per second the isolate event loop dispatches.
+// Each phase keeps a number of event sources busy for the given duration:
+//
+//   timer - concurrent setTimeout(fn, 0) chains
+//   queue - async.Queue objects whose handler re-enqueues the event
+//   fd    - monitored pipes whose handler reads a byte and writes it back
+//
+//   oss_core event_loop_bench.js [duration-ms] [concurrency]
+//
+
+const async = require("async");
+const system = require("system");
+const opt = require("getopt");
+
+var duration = opt.argc > 2 ? parseInt(opt.argv[2]) : 3000;
+var concurrency = opt.argc > 3 ? parseInt(opt.argv[3]) : 100;
+
+var report = function(name, count, elapsed) {
+  var rate = Math.round(count * 1000 / (elapsed ? elapsed : 1));
+  console.log(name + "\tsources " + concurrency + "\tevents " + count + "\t" + elapsed + " ms\t" + rate + " events/s");
+}
+
+var run_timers = function(done) {
+  var count = 0;
+  var running = true;
+  var start = Date.now();
+  var tick = function() {
+    count++;
+    if (running) {
+      async.setTimeout(tick, 0);
+    }
+  }
+  for (var i = 0; i < concurrency; i++) {
+    async.setTimeout(tick, 0);
+  }
+  async.setTimeout(function() {
+    running = false;
+    report("timer", count, Date.now() - start);
+    done();
+  }, duration);
+}
+
+var run_queues = function(done) {
+  var count = 0;
+  var running = true;
+  var queues = [];
+  var start = Date.now();
+  var on_event = function(index) {
+    count++;
+    if (running) {
+      queues[index].enqueue([index]);
+    }
+  }
+  for (var i = 0; i < concurrency; i++) {
+    queues.push(new async.Queue(on_event));
+  }
+  for (var i = 0; i < concurrency; i++) {
+    queues[i].enqueue([i]);
+  }
+  async.setTimeout(function() {
+    running = false;
+    report("queue", count, Date.now() - start);
+    done();
+  }, duration);
+}
+
+var run_descriptors = function(done) {
+  var count = 0;
+  var running = true;
+  var pipes = [];
+  var start = Date.now();
+  var on_readable = function(fd, revents) {
+    system.read(fd, 1);
+    count++;
+    if (running) {
+      system.write(pipes[fd], "x");
+    }
+  }
+  for (var i = 0; i < concurrency; i++) {
+    var pipefd = system.pipe();
+    pipes[pipefd[0]] = pipefd[1];
+    async.monitorFd(pipefd[0], on_readable);
+    system.write(pipefd[1], "x");
+  }
+  async.setTimeout(function() {
+    running = false;
+    report("fd", count, Date.now() - start);
+    for (var fd in pipes) {
+      async.unmonitorFd(parseInt(fd));
+      system.close(parseInt(fd));
+      system.close(pipes[fd]);
+    }
+    done();
+  }, duration);
+}
+
+run_timers(function() {
+  run_queues(function() {
+    run_descriptors(function() {
+      system.exit(0);
+    });
+  });
+});
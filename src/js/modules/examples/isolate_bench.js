@@ -0,0 +1,127 @@
+"use-strict";
+
+//
+// Compares JSON and structured clone messaging between two isolates.
+// Calls are synchronous so the average latency is the elapsed time divided
+// by the number of calls.  Notifications are fire and forget and are timed
+// until the child isolate confirms it received all of them.
+//
+//   oss_core isolate_bench.js [calls] [headers] [buffer-size]
+//
+
+const isolate = require("isolate");
+const system = require("system");
+const opt = require("getopt");
+
+var calls = opt.argc > 2 ? parseInt(opt.argv[2]) : 20000;
+var headerCount = opt.argc > 3 ? parseInt(opt.argv[3]) : 20;
+var bufferSize = opt.argc > 4 ? parseInt(opt.argv[4]) : 65536;
+
+var script = utils.multiline(function() {
+  /*
+  "use-strict";
+  var isolate = require("isolate");
+  var async = require("async");
+  var count = 0;
+
+  isolate.on("ping", function(args) {
+    return "pong";
+  });
+
+  isolate.on("echo", function(args) {
+    return args;
+  });
+
+  isolate.on("bufferSize", function(args) {
+    return args.buffer.byteLength;
+  });
+
+  isolate.on("count", function(args) {
+    count++;
+  });
+
+  isolate.on("total", function(args) {
+    var total = count;
+    count = 0;
+    return total;
+  });
+
+  isolate.on("terminate", function(args) {
+    async.__stop_event_loop();
+  });
+*/
+});
+
+//
+// Roughly what a worker receives for a SIP message snapshot
+//
+var payload = {
+  method: "INVITE",
+  uri: "sip:bob@example.com",
+  transport: { protocol: "udp", address: "192.0.2.10", port: 5060 },
+  headers: []
+};
+for (var i = 0; i < headerCount; i++) {
+  payload.headers.push({ name: "X-Header-" + i, value: "value-" + i + "-0123456789abcdef" });
+}
+
+var report = function(name, count, elapsed) {
+  var rate = Math.round(count * 1000 / (elapsed ? elapsed : 1));
+  var latency = Math.round(elapsed * 1000 / (count ? count : 1));
+  console.log(name + "\tcalls " + count + "\t" + elapsed + " ms\t" + rate + " calls/s\t" + latency + " us/call");
+}
+
+var bench = function(name, count, func) {
+  var start = Date.now();
+  for (var i = 0; i < count; i++) {
+    func(i);
+  }
+  report(name, count, Date.now() - start);
+}
+
+var child = isolate.create();
+child.runSource(script);
+
+//
+// The child registers its handlers once its script starts running
+//
+var ready = undefined;
+while (ready !== "pong") {
+  ready = child.call("ping", null);
+}
+
+bench("json execute", calls, function() {
+  child.execute("echo", payload);
+});
+
+bench("structured call", calls, function() {
+  child.call("echo", payload);
+});
+
+bench("buffer copy", calls, function() {
+  var buffer = new ArrayBuffer(bufferSize);
+  child.call("bufferSize", { buffer: buffer });
+});
+
+bench("buffer transfer", calls, function() {
+  var buffer = new ArrayBuffer(bufferSize);
+  child.call("bufferSize", { buffer: buffer }, 0, [buffer]);
+});
+
+bench("json notify", calls, function(i) {
+  child.notify("count", payload);
+  if (i == calls - 1 && child.execute("total") != calls) {
+    console.log("json notify lost messages");
+  }
+});
+
+bench("structured post", calls, function(i) {
+  child.post("count", payload);
+  if (i == calls - 1 && child.call("total") != calls) {
+    console.log("structured post lost messages");
+  }
+});
+
+child.post("terminate");
+child.join();
+system.exit(0);
@@ -0,0 +1,77 @@
+"use-strict";
+
+//
+// Measures how long it takes for a child isolate to be created, load the
+// built-in modules and answer its first call.  The first isolate starts
+// with an empty in-memory code cache.  The rest reuse the code compiled by
+// the first one.  Compare against a run with the code cache disabled and
+// a run that can only use the files of a previous run:
+//
+//   oss_core isolate_startup_bench.js [isolates]
+//   OSS_JS_CODE_CACHE=0 oss_core isolate_startup_bench.js [isolates]
+//
+// OSS_JS_CODE_CACHE_DIR selects where compiled code persists.
+//
+
+const isolate = require("isolate");
+const system = require("system");
+const opt = require("getopt");
+
+var count = opt.argc > 2 ? parseInt(opt.argv[2]) : 20;
+
+var script = utils.multiline(function() {
+  /*
+  "use-strict";
+  var isolate = require("isolate");
+  var async = require("async");
+  var modules = ["sip-parser", "url-parser", "json_rpc", "http"];
+  for (var i = 0; i < modules.length; i++) {
+    try {
+      require(modules[i]);
+    } catch(e) {
+    }
+  }
+
+  isolate.on("ping", function(args) {
+    return "pong";
+  });
+
+  isolate.on("terminate", function(args) {
+    async.__stop_event_loop();
+  });
+*/
+});
+
+var start_isolate = function() {
+  var start = Date.now();
+  var child = isolate.create();
+  child.runSource(script);
+  var ready = undefined;
+  while (ready !== "pong") {
+    ready = child.call("ping", null);
+  }
+  var elapsed = Date.now() - start;
+  child.post("terminate");
+  child.join();
+  return elapsed;
+}
+
+isolate.clearCodeCache();
+
+var first = start_isolate();
+var total = 0;
+var slowest = 0;
+for (var i = 1; i < count; i++) {
+  var elapsed = start_isolate();
+  total += elapsed;
+  slowest = elapsed > slowest ? elapsed : slowest;
+}
+
+var stats = isolate.getCodeCacheStats();
+console.log("code cache\tenabled " + stats.enabled + "\tdirectory '" + stats.directory + "'");
+console.log("first isolate\t" + first + " ms");
+if (count > 1) {
+  console.log("next isolates\t" + (count - 1) + "\tavg " + (total / (count - 1)).toFixed(2) + " ms\tmax " + slowest + " ms");
+}
+console.log("code cache\thits " + stats.hits + "\tmisses " + stats.misses + "\trejects " + stats.rejects + "\tentries " + stats.entries);
+system.exit(0);
@@ -20,9 +20,13 @@
 #include "OSS/JS/modules/IsolateObject.h"
 #include "OSS/JS/JSIsolateManager.h"
 #include "OSS/JS/JSEventLoop.h"
+#include "OSS/JS/JSStructuredMessage.h"
+#include "OSS/JS/JSCodeCache.h"
 #include "OSS/UTL/Logger.h"
 
 using OSS::JS::JSIsolateManager;
+using OSS::JS::JSStructuredMessage;
+using OSS::JS::JSCodeCache;
 
 JS_CLASS_INTERFACE(IsolateObject, "Isolate") 
 {
@@ -32,6 +36,8 @@ JS_CLASS_INTERFACE(IsolateObject, "Isolate")
   JS_CLASS_METHOD_DEFINE(IsolateObject, "join", join);
   JS_CLASS_METHOD_DEFINE(IsolateObject, "execute", execute);
   JS_CLASS_METHOD_DEFINE(IsolateObject, "notify", notify);
+  JS_CLASS_METHOD_DEFINE(IsolateObject, "executeStructured", executeStructured);
+  JS_CLASS_METHOD_DEFINE(IsolateObject, "notifyStructured", notifyStructured);
   JS_CLASS_INTERFACE_END(IsolateObject); 
 }
 
@@ -55,7 +61,7 @@ IsolateObject::~IsolateObject()
 
 JS_CONSTRUCTOR_IMPL(IsolateObject) 
 {
-  IsolateObject* pObject = new IsolateObject(pthread_self());
+  IsolateObject* pObject = new IsolateObject();
   pObject->Wrap(js_method_self());
   js_method_set_return_self();
 }
@@ -99,6 +105,10 @@ JS_METHOD_IMPL(setChildInterIsolateHandler)
   js_method_declare_uint32(eventEmitterFd, 1);
   OSS::JS::JSIsolateManager::instance().getIsolate()->setEventEmitterFd(eventEmitterFd);
   OSS::JS::JSIsolateManager::instance().getIsolate()->eventLoop()->interIsolate().setHandler(func);
+  if (js_method_args_length() > 2 && js_method_arg_is_function(2))
+  {
+    OSS::JS::JSIsolateManager::instance().getIsolate()->eventLoop()->interIsolate().setStructuredHandler(js_method_arg_as_persistent_function(2));
+  }
   js_method_set_return_undefined();
 }
 
@@ -108,6 +118,10 @@ JS_METHOD_IMPL(setRootInterIsolateHandler)
   js_method_declare_uint32(eventEmitterFd, 1);
   OSS::JS::JSIsolateManager::instance().rootIsolate()->setEventEmitterFd(eventEmitterFd);
   OSS::JS::JSIsolateManager::instance().rootIsolate()->eventLoop()->interIsolate().setHandler(func);
+  if (js_method_args_length() > 2 && js_method_arg_is_function(2))
+  {
+    OSS::JS::JSIsolateManager::instance().rootIsolate()->eventLoop()->interIsolate().setStructuredHandler(js_method_arg_as_persistent_function(2));
+  }
   js_method_set_return_undefined();
 }
 
@@ -135,6 +149,68 @@ JS_METHOD_IMPL(IsolateObject::notify)
   js_method_set_return_undefined();
 }
 
+static bool serialize_args(JSCallbackInfo _args_, int valueIndex, int transferIndex, JSStructuredMessage::Ptr& message)
+{
+  //
+  // A failed clone leaves the DataCloneError pending in the caller
+  //
+  message = JSStructuredMessage::Ptr(new JSStructuredMessage());
+  v8::Local<v8::Value> transferList;
+  if (js_method_args_length() > transferIndex && js_method_arg_is_array(transferIndex))
+  {
+    transferList = js_method_arg(transferIndex);
+  }
+  return message->serialize(js_method_isolate(), js_method_arg(valueIndex), transferList);
+}
+
+JS_METHOD_IMPL(IsolateObject::executeStructured)
+{
+  js_method_enter_scope();
+  js_method_declare_self(IsolateObject, pSelf);
+  js_method_args_assert_size_gteq(2);
+  js_method_declare_uint32(timeout, 1);
+  JSStructuredMessage::Ptr request;
+  if (!serialize_args(_args_, 0, 2, request))
+  {
+    return;
+  }
+  JSStructuredMessage::Ptr result;
+  v8::Local<v8::Value> value;
+  if (!pSelf->_pIsolate->eventLoop()->interIsolate().execute(request, result, timeout, 0) ||
+    !result->deserialize(js_method_isolate()).ToLocal(&value))
+  {
+    js_method_set_return_undefined();
+    return;
+  }
+  js_method_set_return_arg(value);
+}
+
+JS_METHOD_IMPL(IsolateObject::notifyStructured)
+{
+  js_method_enter_scope();
+  js_method_declare_self(IsolateObject, pSelf);
+  js_method_args_assert_size_gteq(1);
+  JSStructuredMessage::Ptr request;
+  if (serialize_args(_args_, 0, 1, request))
+  {
+    pSelf->_pIsolate->eventLoop()->interIsolate().notify(request, 0);
+  }
+  js_method_set_return_undefined();
+}
+
+JS_METHOD_IMPL(notifyParentIsolateStructured)
+{
+  js_method_enter_scope();
+  js_method_args_assert_size_gteq(1);
+  OSS::JS::JSIsolate::Ptr pIsolate = OSS::JS::JSIsolateManager::instance().getIsolate(); 
+  JSStructuredMessage::Ptr request;
+  if (pIsolate && !pIsolate->isRoot() && serialize_args(_args_, 0, 1, request))
+  {
+    pIsolate->getParentIsolate()->eventLoop()->interIsolate().notify(request, 0);
+  }
+  js_method_set_return_undefined();
+}
+
 JS_METHOD_IMPL(notifyParentIsolate)
 {
   js_method_enter_scope();
@@ -152,12 +228,35 @@ JS_METHOD_IMPL(isRootIsolate)
   js_method_set_return_boolean(OSS::JS::JSIsolateManager::instance().rootIsolate()->isThreadSelf());
 }
 
+JS_METHOD_IMPL(getCodeCacheStats)
+{
+  js_method_enter_scope();
+  JSCodeCache::Stats stats = JSCodeCache::instance().getStats();
+  JSObjectHandle result = js_method_object();
+  result->Set(js_method_context(), js_method_string("enabled"), js_method_boolean(JSCodeCache::instance().isEnabled()));
+  result->Set(js_method_context(), js_method_string("directory"), js_method_string(JSCodeCache::instance().getDirectory()));
+  result->Set(js_method_context(), js_method_string("hits"), js_method_uint32(stats.hits));
+  result->Set(js_method_context(), js_method_string("misses"), js_method_uint32(stats.misses));
+  result->Set(js_method_context(), js_method_string("rejects"), js_method_uint32(stats.rejects));
+  result->Set(js_method_context(), js_method_string("entries"), js_method_uint32(stats.entries));
+  js_method_set_return_handle(result);
+}
+
+JS_METHOD_IMPL(clearCodeCache)
+{
+  JSCodeCache::instance().clear();
+  js_method_set_return_undefined();
+}
+
 JS_EXPORTS_INIT()
 {
   js_export_method("isRootIsolate", isRootIsolate);
   js_export_method("setRootInterIsolateHandler", setRootInterIsolateHandler);
   js_export_method("setChildInterIsolateHandler", setChildInterIsolateHandler);
   js_export_method("notifyParentIsolate", notifyParentIsolate);
+  js_export_method("notifyParentIsolateStructured", notifyParentIsolateStructured);
+  js_export_method("getCodeCacheStats", getCodeCacheStats);
+  js_export_method("clearCodeCache", clearCodeCache);
   js_export_class(IsolateObject);
   js_export_finalize();
 }
@@ -4,7 +4,12 @@ var _isolate = require("./_isolate.jso");
 const _Isolate = _isolate.Isolate;
 const EventEmitter = async.EventEmitter;
 
-var inter_isolate_handler = function(request, userData, handler, defaultHandler) {
+//
+// Structured requests arrive as objects and their result is cloned back
+// by the engine.  JSON requests expect the result as a string.
+//
+var inter_isolate_handler = function(request, userData, handler, defaultHandler, structured) {
+  var encode = structured ? function(value) { return value; } : JSON.stringify;
   var method = request.method;
   var arguments = request.arguments;
   if (!handler.hasOwnProperty(method)) {
@@ -13,9 +18,9 @@ var inter_isolate_handler = function(request, userData, handler, defaultHandler)
       response.error = new Object();
       response.error.code = -32601;
       response.error.message = "Method not found";
-      return JSON.stringify(response);
+      return encode(response);
     } else {
-      result = defaultHandler(request, userData);
+      return encode(defaultHandler(request, userData));
     }
   }
   var result;
@@ -26,14 +31,18 @@ var inter_isolate_handler = function(request, userData, handler, defaultHandler)
     var response = new Object();
     response.error = new Object();
     response.error.code = -32603;
-    response.error.message = e;
-    return JSON.stringify(response);
+    response.error.message = structured ? String(e) : e;
+    return encode(response);
   }
-  return JSON.stringify(result);
+  return encode(result);
 }
 
 exports.interIsolateHandler = function(request, userData) {
-  return inter_isolate_handler(request, userData, exports._handler, exports._global_handler);
+  return inter_isolate_handler(request, userData, exports._handler, exports._global_handler, false);
+}
+
+exports.structuredIsolateHandler = function(request, userData) {
+  return inter_isolate_handler(request, userData, exports._handler, exports._global_handler, true);
 }
 
 exports._handler = {}
@@ -64,9 +73,9 @@ IsolateEventEmitter.prototype = Object.create(EventEmitter.prototype);
 exports._eventEmitter = new IsolateEventEmitter();
 
 if (_isolate.isRootIsolate()) {
-  _isolate.setRootInterIsolateHandler(exports.interIsolateHandler, exports._eventEmitter._fd);
+  _isolate.setRootInterIsolateHandler(exports.interIsolateHandler, exports._eventEmitter._fd, exports.structuredIsolateHandler);
 } else {
-  _isolate.setChildInterIsolateHandler(exports.interIsolateHandler, exports._eventEmitter._fd);
+  _isolate.setChildInterIsolateHandler(exports.interIsolateHandler, exports._eventEmitter._fd, exports.structuredIsolateHandler);
 }
 
 var Isolate = function(threadId) {
@@ -108,6 +117,25 @@ var Isolate = function(threadId) {
     var json = JSON.stringify(request);
     isolate.notify(json);
   }
+
+  //
+  // Same as execute and notify but the request and result are cloned
+  // instead of going through JSON.  ArrayBuffers listed in transfer are
+  // moved to the other isolate and become detached here.
+  //
+  _this.call = function(method, args, timeout, transfer) {
+    var request = new Object();
+    request.method = method;
+    request.arguments = args;
+    return isolate.executeStructured(request, timeout ? timeout : 0, transfer ? transfer : []);
+  }
+
+  _this.post = function(method, args, transfer) {
+    var request = new Object();
+    request.method = method;
+    request.arguments = args;
+    isolate.notifyStructured(request, transfer ? transfer : []);
+  }
 }
 
 exports.notifyParentIsolate = function(method, args, id) {
@@ -121,4 +149,21 @@ exports.notifyParentIsolate = function(method, args, id) {
   _isolate.notifyParentIsolate(json);
 }
 
+exports.postParentIsolate = function(method, args, transfer) {
+  var request = new Object();
+  request.method = method;
+  request.arguments = args;
+  _isolate.notifyParentIsolateStructured(request, transfer ? transfer : []);
+}
+
+//
+// Code cache shared by all isolates of this process
+//
+exports.getCodeCacheStats = _isolate.getCodeCacheStats;
+exports.clearCodeCache = _isolate.clearCodeCache;
+
 exports.Isolate = Isolate;
+
+exports.create = function() {
+  return new Isolate();
+}
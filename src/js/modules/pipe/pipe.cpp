@@ -48,6 +48,7 @@ JS_METHOD_IMPL(__pipe)
     result->Set(js_method_context(), 0, js_method_int32(pipefd[0]));
     result->Set(js_method_context(), 1, js_method_int32(pipefd[1]));
     js_method_set_return_handle(result);
+    return;
   }
   
   js_method_set_return_undefined();
@@ -342,6 +342,77 @@ JS_METHOD_IMPL(sbc_set_transport_threshold)
   js_method_set_return_true();
 }
 
+JS_METHOD_IMPL(sbc_set_overload_control)
+{
+  //
+  // enabled, target delay in milliseconds, Retry-After in seconds, drop instead of 503
+  //
+  if (!_pSBCManager || _args_.Length() < 1)
+  {
+    js_method_set_return_false();
+    return;
+  }
+
+  OSS::SIP::SIPOverloadControl& overload = _pSBCManager->transactionManager().stack().overloadControl();
+  if (_args_.Length() > 1)
+  {
+    overload.setTargetDelay((OSS::UInt64)jsvalToInt(_args_,1) * 1000);
+  }
+  if (_args_.Length() > 2)
+  {
+    overload.setRetryAfter(jsvalToInt(_args_,2));
+  }
+  if (_args_.Length() > 3)
+  {
+    overload.setAction(jsvalToBoolean(_args_,3) ? OSS::SIP::SIPOverloadControl::DROP : OSS::SIP::SIPOverloadControl::REJECT);
+  }
+  overload.setEnabled(jsvalToBoolean(_args_,0));
+
+  js_method_set_return_true();
+}
+
+JS_METHOD_IMPL(sbc_add_media_node)
+{
+  //
+  // address (ie tcp://host:port), weight
+  //
+  if (!_pSBCManager || _args_.Length() < 1)
+  {
+    js_method_set_return_false();
+    return;
+  }
+
+  std::string address = jsvalToString(_args_,0);
+  unsigned int weight = _args_.Length() > 1 ? jsvalToInt(_args_,1) : 1;
+  if (_pSBCManager->rtpProxy().addNode(address, weight))
+  {
+    js_method_set_return_true();
+  }
+  else
+  {
+    js_method_set_return_false();
+  }
+}
+
+JS_METHOD_IMPL(sbc_remove_media_node)
+{
+  if (!_pSBCManager || _args_.Length() < 1)
+  {
+    js_method_set_return_false();
+    return;
+  }
+
+  std::string address = jsvalToString(_args_,0);
+  if (_pSBCManager->rtpProxy().removeNode(address))
+  {
+    js_method_set_return_true();
+  }
+  else
+  {
+    js_method_set_return_false();
+  }
+}
+
 JS_METHOD_IMPL(sbc_add_channel_limit)
 {
   if (!_pSBCManager || _args_.Length() < 2)
@@ -539,6 +610,9 @@ JS_EXPORTS_INIT()
   js_export_method("sbc_white_list_network", sbc_white_list_network);
   js_export_method("sbc_deny_all_incoming", sbc_deny_all_incoming);
   js_export_method("sbc_set_transport_threshold", sbc_set_transport_threshold);
+  js_export_method("sbc_set_overload_control", sbc_set_overload_control);
+  js_export_method("sbc_add_media_node", sbc_add_media_node);
+  js_export_method("sbc_remove_media_node", sbc_remove_media_node);
   js_export_method("sbc_add_channel_limit", sbc_add_channel_limit);
   js_export_method("sbc_get_channel_count", sbc_get_channel_count);
   js_export_method("sbc_add_domain_channel_limit", sbc_add_domain_channel_limit);
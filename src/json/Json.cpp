@@ -1,9 +1,213 @@
 #include "OSS/JSON/Json.h"
+#include <sstream>
 
 namespace OSS {
 namespace JSON {
   
-  
+
+class JsonDomBuilder
+  /// JsonParser handler that builds json elements in place.  Values are
+  /// created directly in their parent so no subtree is ever copied.
+{
+public:
+  JsonDomBuilder(UnknownElement* pRoot, Object* pRootObject, Array* pRootArray) :
+    _pRoot(pRoot),
+    _pRootObject(pRootObject),
+    _pRootArray(pRootArray),
+    _pMember(0)
+  {
+  }
+
+  bool onNull()
+  {
+    UnknownElement* pElement = next();
+    if (!pElement)
+      return false;
+    json::Null& value = *pElement;
+    (void)value;
+    return true;
+  }
+
+  bool onBoolean(bool value)
+  {
+    UnknownElement* pElement = next();
+    if (!pElement)
+      return false;
+    Boolean& element = *pElement;
+    element.Value() = value;
+    return true;
+  }
+
+  bool onNumber(double value)
+  {
+    UnknownElement* pElement = next();
+    if (!pElement)
+      return false;
+    Number& element = *pElement;
+    element.Value() = value;
+    return true;
+  }
+
+  bool onString(const char* value, std::size_t size)
+  {
+    UnknownElement* pElement = next();
+    if (!pElement)
+      return false;
+    String& element = *pElement;
+    element.Value().assign(value, size);
+    return true;
+  }
+
+  bool onKey(const char* value, std::size_t size)
+  {
+    Object* pObject = _stack.back().pObject;
+    std::string name(value, size);
+    try
+    {
+      Object::iterator iter = pObject->Insert(Object::Member(name));
+      _pMember = &iter->element;
+    }
+    catch(Exception&)
+    {
+      _error = "Duplicate object member " + name;
+      return false;
+    }
+    return true;
+  }
+
+  bool onObjectBegin()
+  {
+    Frame frame;
+    if (_stack.empty() && _pRootObject)
+    {
+      frame.pObject = _pRootObject;
+    }
+    else
+    {
+      UnknownElement* pElement = next();
+      if (!pElement)
+        return false;
+      Object& object = *pElement;
+      frame.pObject = &object;
+    }
+    _stack.push_back(frame);
+    return true;
+  }
+
+  bool onObjectEnd()
+  {
+    _stack.pop_back();
+    return true;
+  }
+
+  bool onArrayBegin()
+  {
+    Frame frame;
+    if (_stack.empty() && _pRootArray)
+    {
+      frame.pArray = _pRootArray;
+    }
+    else
+    {
+      UnknownElement* pElement = next();
+      if (!pElement)
+        return false;
+      Array& array = *pElement;
+      frame.pArray = &array;
+    }
+    _stack.push_back(frame);
+    return true;
+  }
+
+  bool onArrayEnd()
+  {
+    _stack.pop_back();
+    return true;
+  }
+
+  const std::string& getError() const
+  {
+    return _error;
+  }
+
+private:
+  struct Frame
+  {
+    Frame() : pObject(0), pArray(0) {}
+    Object* pObject;
+    Array* pArray;
+  };
+
+  UnknownElement* next()
+  {
+    if (_stack.empty())
+    {
+      if (!_pRoot)
+      {
+        _error = _pRootObject ? "Expected an object" : "Expected an array";
+        return 0;
+      }
+      return _pRoot;
+    }
+    Frame& frame = _stack.back();
+    if (frame.pArray)
+    {
+      //
+      // Array elements live in a deque so the reference stays valid as
+      // more elements are appended
+      //
+      return &*frame.pArray->Insert(UnknownElement());
+    }
+    return _pMember;
+  }
+
+  UnknownElement* _pRoot;
+  Object* _pRootObject;
+  Array* _pRootArray;
+  UnknownElement* _pMember;
+  std::vector<Frame> _stack;
+  std::string _error;
+};
+
+static bool json_parse_dom(const char* data, std::size_t size, JsonDomBuilder& builder, OSS::JSON::Exception& e)
+{
+  JsonParser parser;
+  if (parser.parse(data, size, builder))
+  {
+    return true;
+  }
+
+  std::ostringstream strm;
+  if (parser.getError() == JsonParser::ERROR_HANDLER && !builder.getError().empty())
+    strm << builder.getError();
+  else
+    strm << parser.getErrorMessage();
+  strm << " at offset " << parser.getErrorOffset();
+  e = OSS::JSON::Exception(strm.str());
+  return false;
+}
+
+bool json_parse(const char* data, std::size_t size, OSS::JSON::UnknownElement& element, OSS::JSON::Exception& e)
+{
+  element = UnknownElement();
+  JsonDomBuilder builder(&element, 0, 0);
+  return json_parse_dom(data, size, builder, e);
+}
+
+bool json_parse(const char* data, std::size_t size, OSS::JSON::Object& object, OSS::JSON::Exception& e)
+{
+  object.Clear();
+  JsonDomBuilder builder(0, &object, 0);
+  return json_parse_dom(data, size, builder, e);
+}
+
+bool json_parse(const char* data, std::size_t size, OSS::JSON::Array& array, OSS::JSON::Exception& e)
+{
+  array.Clear();
+  JsonDomBuilder builder(0, 0, &array);
+  return json_parse_dom(data, size, builder, e);
+}
+
 bool json_parse_string(const std::string& jsonString, OSS::JSON::Object& object)
 {
   OSS::JSON::Exception e;
@@ -12,18 +216,7 @@ bool json_parse_string(const std::string& jsonString, OSS::JSON::Object& object)
 
 bool json_parse_string(const std::string& jsonString, OSS::JSON::Object& object, OSS::JSON::Exception& e)
 {
-  try
-  {
-    std::stringstream ostr;
-    ostr << jsonString;
-    OSS::JSON::Reader::Read(object, ostr);
-  }
-  catch(OSS::JSON::Exception& e_)
-  {
-    e = e_;
-    return false;
-  }
-  return true;
+  return json_parse(jsonString.data(), jsonString.size(), object, e);
 }
 
 bool json_object_to_string(const OSS::JSON::Object& object, std::string& jsonString)
@@ -34,19 +227,11 @@ bool json_object_to_string(const OSS::JSON::Object& object, std::string& jsonStr
 
 bool json_object_to_string(const OSS::JSON::Object& object, std::string& jsonString, OSS::JSON::Exception& e)
 {
-  try
-  {
-    std::stringstream ostr;
-    OSS::JSON::Writer::Write(object, ostr);
-    jsonString = ostr.str();
-  }
-  catch(OSS::JSON::Exception& e_)
-  {
-    e = e_;
-    return false;
-  }
+  jsonString.clear();
+  JsonWriter writer(jsonString);
+  writer.write(object);
   return true;
 }
 
 
-} } // OSS::JSON
\ No newline at end of file
+} } // OSS::JSON
@@ -0,0 +1,245 @@
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "GNU Lesser General Public License (LGPL)".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+
+#include "OSS/JSON/JsonWriter.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cfloat>
+
+
+namespace OSS {
+namespace JSON {
+
+
+static const char HEX_DIGITS[] = "0123456789abcdef";
+
+JsonWriter::JsonWriter(std::string& buffer) :
+  _buffer(buffer),
+  _afterKey(false)
+{
+}
+
+void JsonWriter::beginObject()
+{
+  separate();
+  _buffer.push_back('{');
+  _first.push_back(1);
+}
+
+void JsonWriter::endObject()
+{
+  _buffer.push_back('}');
+  _first.pop_back();
+}
+
+void JsonWriter::beginArray()
+{
+  separate();
+  _buffer.push_back('[');
+  _first.push_back(1);
+}
+
+void JsonWriter::endArray()
+{
+  _buffer.push_back(']');
+  _first.pop_back();
+}
+
+void JsonWriter::key(const char* value, std::size_t size)
+{
+  separate();
+  escape(value, size, _buffer);
+  _buffer.push_back(':');
+  _afterKey = true;
+}
+
+void JsonWriter::key(const char* value)
+{
+  key(value, strlen(value));
+}
+
+void JsonWriter::string(const char* value, std::size_t size)
+{
+  separate();
+  escape(value, size, _buffer);
+}
+
+void JsonWriter::string(const char* value)
+{
+  string(value, strlen(value));
+}
+
+void JsonWriter::number(double value)
+{
+  if (value != value || value > DBL_MAX || value < -DBL_MAX)
+  {
+    null();
+    return;
+  }
+
+  //
+  // Doubles hold integers exactly up to 2^53
+  //
+  if (value >= -9007199254740992.0 && value <= 9007199254740992.0 && value == (double)(OSS::Int64)value)
+  {
+    integer((OSS::Int64)value);
+    return;
+  }
+
+  separate();
+  char text[32];
+  int size = snprintf(text, sizeof(text), "%.15g", value);
+  if (strtod(text, 0) != value)
+  {
+    size = snprintf(text, sizeof(text), "%.17g", value);
+  }
+  _buffer.append(text, size);
+}
+
+void JsonWriter::integer(OSS::Int64 value)
+{
+  separate();
+  char text[24];
+  char* p = text + sizeof(text);
+  OSS::UInt64 magnitude = value < 0 ? 0 - (OSS::UInt64)value : (OSS::UInt64)value;
+  do
+  {
+    *--p = (char)('0' + magnitude % 10);
+    magnitude /= 10;
+  } while (magnitude);
+  if (value < 0)
+  {
+    *--p = '-';
+  }
+  _buffer.append(p, text + sizeof(text) - p);
+}
+
+void JsonWriter::boolean(bool value)
+{
+  separate();
+  if (value)
+    _buffer.append("true", 4);
+  else
+    _buffer.append("false", 5);
+}
+
+void JsonWriter::null()
+{
+  separate();
+  _buffer.append("null", 4);
+}
+
+void JsonWriter::escape(const char* value, std::size_t size, std::string& buffer)
+{
+  buffer.push_back('"');
+  const char* end = value + size;
+  while (value < end)
+  {
+    const char* run = value;
+    while (value < end && *value != '"' && *value != '\\' && (unsigned char)*value >= 0x20)
+    {
+      ++value;
+    }
+    buffer.append(run, value - run);
+    if (value == end)
+    {
+      break;
+    }
+
+    char c = *value++;
+    switch (c)
+    {
+      case '"': buffer.append("\\\"", 2); break;
+      case '\\': buffer.append("\\\\", 2); break;
+      case '\b': buffer.append("\\b", 2); break;
+      case '\f': buffer.append("\\f", 2); break;
+      case '\n': buffer.append("\\n", 2); break;
+      case '\r': buffer.append("\\r", 2); break;
+      case '\t': buffer.append("\\t", 2); break;
+      default:
+      {
+        char text[6] = { '\\', 'u', '0', '0', HEX_DIGITS[(c >> 4) & 0xF], HEX_DIGITS[c & 0xF] };
+        buffer.append(text, 6);
+        break;
+      }
+    }
+  }
+  buffer.push_back('"');
+}
+
+void JsonWriter::write(const json::UnknownElement& element)
+{
+  element.Accept(*this);
+}
+
+void JsonWriter::write(const json::Object& object)
+{
+  Visit(object);
+}
+
+void JsonWriter::write(const json::Array& array)
+{
+  Visit(array);
+}
+
+void JsonWriter::Visit(const json::Array& array)
+{
+  beginArray();
+  for (json::Array::const_iterator iter = array.Begin(); iter != array.End(); iter++)
+  {
+    iter->Accept(*this);
+  }
+  endArray();
+}
+
+void JsonWriter::Visit(const json::Object& object)
+{
+  beginObject();
+  for (json::Object::const_iterator iter = object.Begin(); iter != object.End(); iter++)
+  {
+    key(iter->name);
+    iter->element.Accept(*this);
+  }
+  endObject();
+}
+
+void JsonWriter::Visit(const json::Number& number)
+{
+  this->number(number.Value());
+}
+
+void JsonWriter::Visit(const json::String& string)
+{
+  this->string(string.Value());
+}
+
+void JsonWriter::Visit(const json::Boolean& boolean)
+{
+  this->boolean(boolean.Value());
+}
+
+void JsonWriter::Visit(const json::Null&)
+{
+  null();
+}
+
+
+} } // OSS::JSON
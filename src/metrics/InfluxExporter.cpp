@@ -0,0 +1,258 @@
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare 
+// derivative works of the Software, all subject to the 
+// "GNU Lesser General Public License (LGPL)".
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+
+#include <unistd.h>
+#include <sys/time.h>
+#include <sstream>
+#include <iomanip>
+#include <boost/lexical_cast.hpp>
+#include "OSS/Metrics/InfluxExporter.h"
+#include "OSS/Metrics/influxdb_cpp/influxdb.hpp"
+#include "OSS/UTL/Logger.h"
+
+
+namespace OSS {
+namespace Metrics {
+
+
+InfluxExporter::InfluxExporter(MetricsRegistry& registry) :
+  _registry(registry),
+  _port(0),
+  _transport(UDP),
+  _interval(DEFAULT_INTERVAL_MS),
+  _ioService(),
+  _socket(_ioService),
+  _wake(0, 1),
+  _stopping(false),
+  _pThread(0)
+{
+}
+
+InfluxExporter::~InfluxExporter()
+{
+  stop();
+}
+
+void InfluxExporter::setTag(const std::string& key, const std::string& value)
+{
+  _tags[key] = value;
+  updateTagString();
+}
+
+void InfluxExporter::updateTagString()
+{
+  _tagString.clear();
+  for (Tags::const_iterator iter = _tags.begin(); iter != _tags.end(); iter++)
+  {
+    _tagString.push_back(',');
+    escape(iter->first, ",= ", _tagString);
+    _tagString.push_back('=');
+    escape(iter->second, ",= ", _tagString);
+  }
+}
+
+void InfluxExporter::escape(const std::string& value, const char* special, std::string& out)
+{
+  for (std::string::const_iterator iter = value.begin(); iter != value.end(); iter++)
+  {
+    for (const char* s = special; *s; s++)
+    {
+      if (*iter == *s)
+      {
+        out.push_back('\\');
+        break;
+      }
+    }
+    out.push_back(*iter);
+  }
+}
+
+bool InfluxExporter::start(const std::string& host, int port, Transport transport, const std::string& database, unsigned int interval)
+{
+  if (_pThread)
+    return true;
+
+  _host = host;
+  _port = port;
+  _transport = transport;
+  _database = database;
+  _interval = interval ? interval : DEFAULT_INTERVAL_MS;
+
+  if (_tags.find("host") == _tags.end())
+  {
+    char hostName[256];
+    if (gethostname(hostName, sizeof(hostName)) == 0)
+    {
+      hostName[sizeof(hostName) - 1] = 0;
+      _tags["host"] = hostName;
+    }
+  }
+
+  updateTagString();
+
+  if (_transport == UDP)
+  {
+    try
+    {
+      boost::asio::ip::udp::resolver resolver(_ioService);
+      boost::asio::ip::udp::resolver::query query(host, boost::lexical_cast<std::string>(port));
+      _destination = *resolver.resolve(query);
+      if (!_socket.is_open())
+        _socket.open(_destination.protocol());
+    }
+    catch (const std::exception& e)
+    {
+      OSS_LOG_ERROR("InfluxExporter::start - Unable to open socket to " << host << ":" << port << " - " << e.what());
+      return false;
+    }
+  }
+
+  _stopping = false;
+  _pThread = new boost::thread(boost::bind(&InfluxExporter::run, this));
+  OSS_LOG_INFO("InfluxExporter::start - Pushing metrics to " << (_transport == UDP ? "udp://" : "http://")
+    << host << ":" << port << " every " << _interval << " ms");
+  return true;
+}
+
+void InfluxExporter::stop()
+{
+  if (!_pThread)
+    return;
+  _stopping = true;
+  _wake.set();
+  _pThread->join();
+  delete _pThread;
+  _pThread = 0;
+
+  boost::system::error_code ec;
+  _socket.close(ec);
+}
+
+void InfluxExporter::run()
+{
+  while (!_stopping)
+  {
+    if (_wake.tryWait(_interval))
+      continue;
+    push();
+  }
+}
+
+bool InfluxExporter::push()
+{
+  MetricsRegistry::Samples samples;
+  _registry.snapshot(samples);
+  if (samples.empty())
+    return true;
+
+  timeval now;
+  gettimeofday(&now, 0);
+  std::string lines;
+  formatLines(samples, (OSS::UInt64)now.tv_sec * 1000000000 + (OSS::UInt64)now.tv_usec * 1000, lines);
+
+  bool ok = _transport == UDP ? sendUdp(lines) : sendHttp(lines);
+  if (!ok)
+  {
+    OSS_LOG_WARNING("InfluxExporter::push - Unable to write " << samples.size() << " metrics to " << _host << ":" << _port);
+  }
+  return ok;
+}
+
+void InfluxExporter::formatLines(const MetricsRegistry::Samples& samples, OSS::UInt64 timestamp, std::string& lines)
+{
+  std::ostringstream strm;
+  strm.imbue(std::locale::classic());
+  std::string name;
+  for (MetricsRegistry::Samples::const_iterator iter = samples.begin(); iter != samples.end(); iter++)
+  {
+    name.clear();
+    escape(iter->name, ", ", name);
+    strm << name << _tagString << ' ';
+
+    if (iter->type == MetricsRegistry::COUNTER)
+    {
+      OSS::UInt64 value = iter->value;
+      double rate = 0;
+      CounterHistory::iterator history = _history.find(iter->name);
+      if (history != _history.end() && timestamp > history->second.second && value >= history->second.first)
+        rate = (value - history->second.first) * 1000000000.0 / (timestamp - history->second.second);
+      _history[iter->name] = std::make_pair(value, timestamp);
+      strm << "value=" << value << "i,rate=" << std::fixed << std::setprecision(2) << rate;
+    }
+    else if (iter->type == MetricsRegistry::GAUGE)
+    {
+      strm << "value=" << iter->value << 'i';
+    }
+    else
+    {
+      const Histogram::Snapshot& h = iter->histogram;
+      strm << "count=" << h.count << "i"
+        << ",mean=" << std::fixed << std::setprecision(2) << h.mean()
+        << ",p50=" << h.p50 << "i"
+        << ",p90=" << h.p90 << "i"
+        << ",p99=" << h.p99 << "i"
+        << ",p999=" << h.p999 << "i"
+        << ",max=" << h.max << "i";
+    }
+    strm << ' ' << timestamp << '\n';
+  }
+  lines = strm.str();
+}
+
+bool InfluxExporter::sendUdp(const std::string& lines)
+{
+  if (!_socket.is_open())
+    return false;
+
+  //
+  // Split on line boundaries so that every datagram is a valid batch
+  //
+  bool ok = true;
+  std::size_t start = 0;
+  while (start < lines.size())
+  {
+    std::size_t end = start;
+    while (end < lines.size())
+    {
+      std::size_t next = lines.find('\n', end);
+      next = (next == std::string::npos) ? lines.size() : next + 1;
+      if (next - start > MAX_DATAGRAM_SIZE && end > start)
+        break;
+      end = next;
+    }
+    boost::system::error_code ec;
+    _socket.send_to(boost::asio::buffer(lines.data() + start, end - start), _destination, 0, ec);
+    if (ec)
+      ok = false;
+    start = end;
+  }
+  return ok;
+}
+
+bool InfluxExporter::sendHttp(const std::string& lines)
+{
+  influxdb_cpp::server_info si(_host, _port, _database);
+  std::string response;
+  int status = influxdb_cpp::detail::inner::http_request("POST", "write", "", lines, si, &response);
+  return status >= 200 && status < 300;
+}
+
+
+} } // OSS::Metrics
@@ -0,0 +1,294 @@
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare 
+// derivative works of the Software, all subject to the 
+// "GNU Lesser General Public License (LGPL)".
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+
+#include <time.h>
+#include <sstream>
+#include <iomanip>
+#include "OSS/Metrics/MetricsRegistry.h"
+
+
+namespace OSS {
+namespace Metrics {
+
+
+static boost::atomic<unsigned int> gNextShard(0);
+
+unsigned int nextThreadShard()
+{
+  return gNextShard.fetch_add(1, boost::memory_order_relaxed) % METRIC_SHARDS;
+}
+
+//
+// Counter
+//
+
+Counter::Counter(const std::string& name) :
+  _name(name)
+{
+  for (std::size_t i = 0; i < METRIC_SHARDS; i++)
+    _shards[i].value.store(0, boost::memory_order_relaxed);
+}
+
+OSS::UInt64 Counter::value() const
+{
+  OSS::UInt64 total = 0;
+  for (std::size_t i = 0; i < METRIC_SHARDS; i++)
+    total += _shards[i].value.load(boost::memory_order_relaxed);
+  return total;
+}
+
+//
+// Gauge
+//
+
+Gauge::Gauge(const std::string& name) :
+  _name(name),
+  _value(0)
+{
+}
+
+//
+// Histogram
+//
+
+Histogram::Snapshot::Snapshot() :
+  count(0),
+  sum(0),
+  max(0),
+  p50(0),
+  p90(0),
+  p99(0),
+  p999(0)
+{
+}
+
+double Histogram::Snapshot::mean() const
+{
+  return count ? (double)sum / count : 0;
+}
+
+Histogram::Histogram(const std::string& name) :
+  _name(name),
+  _shards(new Shard[METRIC_SHARDS])
+{
+  reset();
+}
+
+Histogram::~Histogram()
+{
+  delete [] _shards;
+}
+
+void Histogram::reset()
+{
+  for (std::size_t i = 0; i < METRIC_SHARDS; i++)
+  {
+    Shard& shard = _shards[i];
+    for (std::size_t b = 0; b < BUCKET_COUNT; b++)
+      shard.buckets[b].store(0, boost::memory_order_relaxed);
+    shard.count.store(0, boost::memory_order_relaxed);
+    shard.sum.store(0, boost::memory_order_relaxed);
+    shard.max.store(0, boost::memory_order_relaxed);
+  }
+}
+
+OSS::UInt64 Histogram::bucketValue(std::size_t index)
+{
+  if (index < SUB_BUCKET_COUNT)
+    return index;
+  std::size_t offset = index - SUB_BUCKET_COUNT;
+  std::size_t shift = offset / SUB_BUCKET_HALF + 1;
+  OSS::UInt64 sub = offset % SUB_BUCKET_HALF + SUB_BUCKET_HALF;
+  return ((sub + 1) << shift) - 1;
+}
+
+OSS::UInt64 Histogram::now()
+{
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (OSS::UInt64)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+Histogram::Snapshot Histogram::snapshot() const
+{
+  Snapshot snapshot;
+  std::vector<OSS::UInt64> buckets(BUCKET_COUNT, 0);
+  for (std::size_t i = 0; i < METRIC_SHARDS; i++)
+  {
+    const Shard& shard = _shards[i];
+    for (std::size_t b = 0; b < BUCKET_COUNT; b++)
+      buckets[b] += shard.buckets[b].load(boost::memory_order_relaxed);
+    snapshot.sum += shard.sum.load(boost::memory_order_relaxed);
+    OSS::UInt64 max = shard.max.load(boost::memory_order_relaxed);
+    if (max > snapshot.max)
+      snapshot.max = max;
+  }
+
+  //
+  // Count from the buckets rather than the shard counters so the
+  // percentiles are consistent with the totals even while samples are
+  // being recorded.
+  //
+  for (std::size_t b = 0; b < BUCKET_COUNT; b++)
+    snapshot.count += buckets[b];
+  if (!snapshot.count)
+    return snapshot;
+
+  const double quantiles[] = { 0.5, 0.9, 0.99, 0.999 };
+  OSS::UInt64* results[] = { &snapshot.p50, &snapshot.p90, &snapshot.p99, &snapshot.p999 };
+  std::size_t q = 0;
+  OSS::UInt64 seen = 0;
+  for (std::size_t b = 0; b < BUCKET_COUNT && q < 4; b++)
+  {
+    seen += buckets[b];
+    while (q < 4 && seen >= (OSS::UInt64)(quantiles[q] * snapshot.count + 0.999999))
+    {
+      OSS::UInt64 value = bucketValue(b);
+      *results[q++] = value < snapshot.max ? value : snapshot.max;
+    }
+  }
+  return snapshot;
+}
+
+//
+// MetricsRegistry
+//
+
+MetricsRegistry::Sample::Sample() :
+  type(COUNTER),
+  value(0)
+{
+}
+
+MetricsRegistry& MetricsRegistry::instance()
+{
+  static MetricsRegistry registry;
+  return registry;
+}
+
+MetricsRegistry::MetricsRegistry()
+{
+}
+
+MetricsRegistry::~MetricsRegistry()
+{
+  for (Counters::iterator iter = _counters.begin(); iter != _counters.end(); iter++)
+    delete iter->second;
+  for (Gauges::iterator iter = _gauges.begin(); iter != _gauges.end(); iter++)
+    delete iter->second;
+  for (Histograms::iterator iter = _histograms.begin(); iter != _histograms.end(); iter++)
+    delete iter->second;
+}
+
+Counter& MetricsRegistry::counter(const std::string& name)
+{
+  OSS::mutex_lock lock(_mutex);
+  Counters::iterator iter = _counters.find(name);
+  if (iter != _counters.end())
+    return *iter->second;
+  Counter* pCounter = new Counter(name);
+  _counters[name] = pCounter;
+  return *pCounter;
+}
+
+Gauge& MetricsRegistry::gauge(const std::string& name)
+{
+  OSS::mutex_lock lock(_mutex);
+  Gauges::iterator iter = _gauges.find(name);
+  if (iter != _gauges.end())
+    return *iter->second;
+  Gauge* pGauge = new Gauge(name);
+  _gauges[name] = pGauge;
+  return *pGauge;
+}
+
+Histogram& MetricsRegistry::histogram(const std::string& name)
+{
+  OSS::mutex_lock lock(_mutex);
+  Histograms::iterator iter = _histograms.find(name);
+  if (iter != _histograms.end())
+    return *iter->second;
+  Histogram* pHistogram = new Histogram(name);
+  _histograms[name] = pHistogram;
+  return *pHistogram;
+}
+
+void MetricsRegistry::snapshot(Samples& samples) const
+{
+  OSS::mutex_lock lock(_mutex);
+  samples.reserve(samples.size() + _counters.size() + _gauges.size() + _histograms.size());
+  for (Counters::const_iterator iter = _counters.begin(); iter != _counters.end(); iter++)
+  {
+    Sample sample;
+    sample.name = iter->first;
+    sample.type = COUNTER;
+    sample.value = iter->second->value();
+    samples.push_back(sample);
+  }
+  for (Gauges::const_iterator iter = _gauges.begin(); iter != _gauges.end(); iter++)
+  {
+    Sample sample;
+    sample.name = iter->first;
+    sample.type = GAUGE;
+    sample.value = iter->second->value();
+    samples.push_back(sample);
+  }
+  for (Histograms::const_iterator iter = _histograms.begin(); iter != _histograms.end(); iter++)
+  {
+    Sample sample;
+    sample.name = iter->first;
+    sample.type = HISTOGRAM;
+    sample.histogram = iter->second->snapshot();
+    sample.value = sample.histogram.count;
+    samples.push_back(sample);
+  }
+}
+
+std::string MetricsRegistry::toString() const
+{
+  Samples samples;
+  snapshot(samples);
+
+  std::ostringstream strm;
+  for (Samples::const_iterator iter = samples.begin(); iter != samples.end(); iter++)
+  {
+    strm << std::left << std::setw(28) << iter->name << std::right;
+    if (iter->type == HISTOGRAM)
+    {
+      const Histogram::Snapshot& h = iter->histogram;
+      strm << " count=" << h.count
+        << " mean=" << std::fixed << std::setprecision(1) << h.mean()
+        << " p50=" << h.p50
+        << " p90=" << h.p90
+        << " p99=" << h.p99
+        << " p999=" << h.p999
+        << " max=" << h.max;
+    }
+    else
+    {
+      strm << " " << iter->value;
+    }
+    strm << std::endl;
+  }
+  return strm.str();
+}
+
+
+} } // OSS::Metrics
@@ -0,0 +1,120 @@
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare 
+// derivative works of the Software, all subject to the 
+// "GNU Lesser General Public License (LGPL)".
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+
+
+#include "OSS/Net/TlsHandshakePool.h"
+#include "OSS/UTL/Logger.h"
+
+
+namespace OSS  {
+namespace Net {
+
+
+TlsHandshakePool::TlsHandshakePool() :
+  _roundRobin(0),
+  _isRunning(false)
+{
+}
+
+TlsHandshakePool::~TlsHandshakePool()
+{
+  stop();
+}
+
+bool TlsHandshakePool::start(std::size_t threadCount)
+{
+  OSS::mutex_critic_sec_lock lock(_mutex);
+  if (_isRunning || !threadCount)
+    return false;
+
+  for (std::size_t i = 0; i < threadCount; i++)
+  {
+    IoServicePtr pIoService(new boost::asio::io_service());
+    _work.push_back(WorkPtr(new boost::asio::io_service::work(*pIoService)));
+    _ioServices.push_back(pIoService);
+    _threads.push_back(ThreadPtr(new boost::thread(boost::bind(&TlsHandshakePool::run, this, pIoService))));
+  }
+
+  _isRunning = true;
+  OSS_LOG_INFO("TlsHandshakePool::start - Started " << threadCount << " TLS threads");
+  return true;
+}
+
+void TlsHandshakePool::run(IoServicePtr pIoService)
+{
+  //
+  // A handler throwing must not take the thread down with it.  The
+  // connections bound to this io_service would stall forever.
+  //
+  while (true)
+  {
+    try
+    {
+      pIoService->run();
+      break;
+    }
+    catch(const std::exception& e)
+    {
+      OSS_LOG_ERROR("TlsHandshakePool::run - Exception: " << e.what());
+    }
+  }
+}
+
+void TlsHandshakePool::stop()
+{
+  std::vector<IoServicePtr> ioServices;
+  std::vector<ThreadPtr> threads;
+  {
+    OSS::mutex_critic_sec_lock lock(_mutex);
+    if (!_isRunning)
+      return;
+
+    _isRunning = false;
+    _work.clear();
+    ioServices.swap(_ioServices);
+    threads.swap(_threads);
+    //
+    // Connections still referencing the io_services may be destroyed
+    // after the pool is stopped.  Keep them alive until then.
+    //
+    _retired.insert(_retired.end(), ioServices.begin(), ioServices.end());
+  }
+
+  //
+  // The threads are joined outside the lock.  A handler running on them
+  // may call next().
+  //
+  for (std::vector<IoServicePtr>::iterator iter = ioServices.begin(); iter != ioServices.end(); iter++)
+    (*iter)->stop();
+  for (std::vector<ThreadPtr>::iterator iter = threads.begin(); iter != threads.end(); iter++)
+    (*iter)->join();
+}
+
+boost::asio::io_service& TlsHandshakePool::next(boost::asio::io_service& fallback)
+{
+  OSS::mutex_critic_sec_lock lock(_mutex);
+  if (_ioServices.empty())
+    return fallback;
+  return *_ioServices[_roundRobin++ % _ioServices.size()];
+}
+
+
+} } // OSS::Net
+
@@ -0,0 +1,499 @@
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare 
+// derivative works of the Software, all subject to the 
+// "GNU Lesser General Public License (LGPL)".
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+
+
+#include <cstring>
+#include <ctime>
+#include <boost/thread/once.hpp>
+#include <openssl/rand.h>
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+#include <openssl/core_names.h>
+#include <openssl/params.h>
+#endif
+
+#include "OSS/Net/TlsSessionCache.h"
+#include "OSS/UTL/CoreUtils.h"
+#include "OSS/UTL/Logger.h"
+
+
+namespace OSS  {
+namespace Net {
+
+
+static boost::once_flag ex_data_once = BOOST_ONCE_INIT;
+static int ctx_ex_index = -1;
+static int ssl_peer_ex_index = -1;
+
+static void free_peer_ex_data(void* parent, void* ptr, CRYPTO_EX_DATA* ad, int idx, long argl, void* argp)
+{
+  delete static_cast<std::string*>(ptr);
+}
+
+static void init_ex_data_indexes()
+{
+  ctx_ex_index = SSL_CTX_get_ex_new_index(0, 0, 0, 0, 0);
+  ssl_peer_ex_index = SSL_get_ex_new_index(0, 0, 0, 0, free_peer_ex_data);
+}
+
+TlsSessionCache::Stats::Stats() :
+  serverHandshakes(0),
+  serverResumed(0),
+  clientHandshakes(0),
+  clientResumed(0),
+  failedHandshakes(0),
+  ticketKeyRotations(0),
+  handshakesPerSecond(0),
+  serverCacheSize(0),
+  clientCacheSize(0)
+{
+}
+
+TlsSessionCache::TlsSessionCache() :
+  _hasTicketKeys(false),
+  _hasPreviousKey(false),
+  _keyLifetime(DEFAULT_TICKET_KEY_LIFETIME),
+  _maxPeers(DEFAULT_CLIENT_CACHE_SIZE),
+  _pServerContext(0),
+  _pClientContext(0),
+  _serverHandshakes(0),
+  _serverResumed(0),
+  _clientHandshakes(0),
+  _clientResumed(0),
+  _failedHandshakes(0),
+  _ticketKeyRotations(0),
+  _rateWindowStart(0),
+  _rateWindowCount(0),
+  _lastRate(0)
+{
+  boost::call_once(init_ex_data_indexes, ex_data_once);
+}
+
+TlsSessionCache::~TlsSessionCache()
+{
+  //
+  // The contexts may outlive this object.  Detach so their callbacks
+  // do not reach a deleted cache.
+  //
+  if (_pServerContext)
+    SSL_CTX_set_ex_data(_pServerContext, ctx_ex_index, 0);
+  if (_pClientContext)
+    SSL_CTX_set_ex_data(_pClientContext, ctx_ex_index, 0);
+
+  OSS::mutex_critic_sec_lock lock(_clientMutex);
+  for (ClientSessions::iterator iter = _clientSessions.begin(); iter != _clientSessions.end(); iter++)
+    SSL_SESSION_free(iter->second.session);
+  _clientSessions.clear();
+
+  OPENSSL_cleanse(&_currentKey, sizeof(_currentKey));
+  OPENSSL_cleanse(&_previousKey, sizeof(_previousKey));
+}
+
+TlsSessionCache* TlsSessionCache::fromContext(SSL_CTX* ctx)
+{
+  if (!ctx)
+    return 0;
+  return static_cast<TlsSessionCache*>(SSL_CTX_get_ex_data(ctx, ctx_ex_index));
+}
+
+bool TlsSessionCache::enableServerCache(boost::asio::ssl::context& context, const std::string& sessionIdContext, long cacheSize, long timeout)
+{
+  SSL_CTX* ctx = context.native_handle();
+  if (!SSL_CTX_set_session_id_context(ctx,
+    reinterpret_cast<const unsigned char*>(sessionIdContext.data()),
+    sessionIdContext.size() > SSL_MAX_SID_CTX_LENGTH ? SSL_MAX_SID_CTX_LENGTH : sessionIdContext.size()))
+  {
+    OSS_LOG_ERROR("TlsSessionCache::enableServerCache - Unable to set session id context");
+    return false;
+  }
+
+  SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_SERVER);
+  SSL_CTX_sess_set_cache_size(ctx, cacheSize);
+  SSL_CTX_set_timeout(ctx, timeout);
+  SSL_CTX_set_ex_data(ctx, ctx_ex_index, this);
+  _pServerContext = ctx;
+
+  OSS_LOG_INFO("TlsSessionCache::enableServerCache - size: " << cacheSize << " timeout: " << timeout << "s");
+  return true;
+}
+
+bool TlsSessionCache::createTicketKey(TicketKey& key)
+{
+  if (RAND_bytes(key.name, sizeof(key.name)) != 1 ||
+    RAND_bytes(key.aesKey, sizeof(key.aesKey)) != 1 ||
+    RAND_bytes(key.hmacKey, sizeof(key.hmacKey)) != 1)
+  {
+    return false;
+  }
+  key.created = OSS::getTime();
+  return true;
+}
+
+bool TlsSessionCache::enableSessionTickets(boost::asio::ssl::context& context, unsigned int keyLifetime)
+{
+  {
+    OSS::mutex_write_lock lock(_ticketMutex);
+    _keyLifetime = keyLifetime ? keyLifetime : DEFAULT_TICKET_KEY_LIFETIME;
+    if (!_hasTicketKeys)
+    {
+      if (!createTicketKey(_currentKey))
+      {
+        OSS_LOG_ERROR("TlsSessionCache::enableSessionTickets - Unable to create ticket key");
+        return false;
+      }
+      _hasTicketKeys = true;
+    }
+  }
+
+  SSL_CTX* ctx = context.native_handle();
+  SSL_CTX_clear_options(ctx, SSL_OP_NO_TICKET);
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+  SSL_CTX_set_tlsext_ticket_key_evp_cb(ctx, &TlsSessionCache::onTicketKey);
+#else
+  SSL_CTX_set_tlsext_ticket_key_cb(ctx, &TlsSessionCache::onTicketKey);
+#endif
+  SSL_CTX_set_ex_data(ctx, ctx_ex_index, this);
+  _pServerContext = ctx;
+
+  OSS_LOG_INFO("TlsSessionCache::enableSessionTickets - key lifetime: " << _keyLifetime << "s");
+  return true;
+}
+
+bool TlsSessionCache::enableClientCache(boost::asio::ssl::context& context, std::size_t maxPeers)
+{
+  SSL_CTX* ctx = context.native_handle();
+  //
+  // Sessions are handed to us through the new session callback.  This is
+  // also how TLS 1.3 tickets that arrive after the handshake are caught.
+  //
+  SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+  SSL_CTX_sess_set_new_cb(ctx, &TlsSessionCache::onNewClientSession);
+  SSL_CTX_set_ex_data(ctx, ctx_ex_index, this);
+  _pClientContext = ctx;
+
+  OSS::mutex_critic_sec_lock lock(_clientMutex);
+  _maxPeers = maxPeers ? maxPeers : 1;
+  return true;
+}
+
+void TlsSessionCache::rotateTicketKeys()
+{
+  TicketKey key;
+  if (!createTicketKey(key))
+  {
+    OSS_LOG_ERROR("TlsSessionCache::rotateTicketKeys - Unable to create ticket key");
+    return;
+  }
+
+  OSS::mutex_write_lock lock(_ticketMutex);
+  if (_hasTicketKeys)
+  {
+    _previousKey = _currentKey;
+    _hasPreviousKey = true;
+  }
+  _currentKey = key;
+  _hasTicketKeys = true;
+  _ticketKeyRotations++;
+  OPENSSL_cleanse(&key, sizeof(key));
+}
+
+bool TlsSessionCache::getCurrentTicketKey(TicketKey& key)
+{
+  {
+    OSS::mutex_read_lock lock(_ticketMutex);
+    if (!_hasTicketKeys)
+      return false;
+    if (OSS::getTime() - _currentKey.created < (OSS::UInt64)_keyLifetime * 1000)
+    {
+      key = _currentKey;
+      return true;
+    }
+  }
+
+  //
+  // The current key expired.  The first ticket issued after expiry
+  // rotates the keys unless another thread got there first.
+  //
+  TicketKey fresh;
+  if (!createTicketKey(fresh))
+    return false;
+
+  OSS::mutex_write_lock lock(_ticketMutex);
+  if (OSS::getTime() - _currentKey.created >= (OSS::UInt64)_keyLifetime * 1000)
+  {
+    _previousKey = _currentKey;
+    _hasPreviousKey = true;
+    _currentKey = fresh;
+    _ticketKeyRotations++;
+  }
+  OPENSSL_cleanse(&fresh, sizeof(fresh));
+  key = _currentKey;
+  return true;
+}
+
+bool TlsSessionCache::getTicketKey(const unsigned char* name, TicketKey& key, bool& isCurrent)
+{
+  OSS::mutex_read_lock lock(_ticketMutex);
+  if (!_hasTicketKeys)
+    return false;
+
+  if (::memcmp(name, _currentKey.name, sizeof(_currentKey.name)) == 0)
+  {
+    key = _currentKey;
+    isCurrent = true;
+    return true;
+  }
+
+  //
+  // Tickets encrypted with the previous key are accepted until the key
+  // expires.  They are renewed with the current key.
+  //
+  if (_hasPreviousKey && ::memcmp(name, _previousKey.name, sizeof(_previousKey.name)) == 0 &&
+    OSS::getTime() - _previousKey.created < (OSS::UInt64)_keyLifetime * 2000)
+  {
+    key = _previousKey;
+    isCurrent = false;
+    return true;
+  }
+
+  return false;
+}
+
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+int TlsSessionCache::onTicketKey(SSL* ssl, unsigned char* name, unsigned char* iv, EVP_CIPHER_CTX* cipherCtx, EVP_MAC_CTX* macCtx, int enc)
+#else
+int TlsSessionCache::onTicketKey(SSL* ssl, unsigned char* name, unsigned char* iv, EVP_CIPHER_CTX* cipherCtx, HMAC_CTX* hmacCtx, int enc)
+#endif
+{
+  TlsSessionCache* pCache = fromContext(SSL_get_SSL_CTX(ssl));
+  if (!pCache)
+    return 0;
+
+  TicketKey key;
+  bool isCurrent = true;
+  if (enc)
+  {
+    if (!pCache->getCurrentTicketKey(key))
+      return 0;
+    if (RAND_bytes(iv, EVP_CIPHER_iv_length(EVP_aes_256_cbc())) != 1)
+      return -1;
+    ::memcpy(name, key.name, sizeof(key.name));
+    if (!EVP_EncryptInit_ex(cipherCtx, EVP_aes_256_cbc(), 0, key.aesKey, iv))
+      return -1;
+  }
+  else
+  {
+    //
+    // An unknown key name is not an error.  The client falls back to
+    // a full handshake and receives a fresh ticket.
+    //
+    if (!pCache->getTicketKey(name, key, isCurrent))
+      return 0;
+    if (!EVP_DecryptInit_ex(cipherCtx, EVP_aes_256_cbc(), 0, key.aesKey, iv))
+      return -1;
+  }
+
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+  OSSL_PARAM params[3];
+  params[0] = OSSL_PARAM_construct_octet_string(OSSL_MAC_PARAM_KEY, key.hmacKey, sizeof(key.hmacKey));
+  params[1] = OSSL_PARAM_construct_utf8_string(OSSL_MAC_PARAM_DIGEST, const_cast<char*>("SHA256"), 0);
+  params[2] = OSSL_PARAM_construct_end();
+  if (!EVP_MAC_CTX_set_params(macCtx, params))
+    return -1;
+#else
+  if (!HMAC_Init_ex(hmacCtx, key.hmacKey, sizeof(key.hmacKey), EVP_sha256(), 0))
+    return -1;
+#endif
+
+  OPENSSL_cleanse(&key, sizeof(key));
+
+  //
+  // TLS 1.3 clients use a ticket only once and the server only sends a
+  // new one if asked to renew.  Always renew or the next connection from
+  // the same client does a full handshake.
+  //
+#ifdef TLS1_3_VERSION
+  if (!enc && SSL_version(ssl) == TLS1_3_VERSION)
+    return 2;
+#endif
+  return isCurrent ? 1 : 2;
+}
+
+int TlsSessionCache::onNewClientSession(SSL* ssl, SSL_SESSION* session)
+{
+  TlsSessionCache* pCache = fromContext(SSL_get_SSL_CTX(ssl));
+  std::string* pPeer = static_cast<std::string*>(SSL_get_ex_data(ssl, ssl_peer_ex_index));
+  if (!pCache || !pPeer)
+    return 0;
+  //
+  // Returning 1 keeps the reference OpenSSL passed to us
+  //
+  pCache->storeClientSession(*pPeer, session);
+  return 1;
+}
+
+void TlsSessionCache::storeClientSession(const std::string& peer, SSL_SESSION* session)
+{
+  OSS::mutex_critic_sec_lock lock(_clientMutex);
+  ClientSessions::iterator iter = _clientSessions.find(peer);
+  if (iter != _clientSessions.end())
+  {
+    SSL_SESSION_free(iter->second.session);
+    iter->second.session = session;
+    iter->second.lastUsed = OSS::getTime();
+    return;
+  }
+
+  if (_clientSessions.size() >= _maxPeers)
+  {
+    //
+    // Evict the peer we have not connected to for the longest time
+    //
+    ClientSessions::iterator oldest = _clientSessions.begin();
+    for (iter = _clientSessions.begin(); iter != _clientSessions.end(); iter++)
+    {
+      if (iter->second.lastUsed < oldest->second.lastUsed)
+        oldest = iter;
+    }
+    SSL_SESSION_free(oldest->second.session);
+    _clientSessions.erase(oldest);
+  }
+
+  ClientSession entry;
+  entry.session = session;
+  entry.lastUsed = OSS::getTime();
+  _clientSessions[peer] = entry;
+}
+
+void TlsSessionCache::prepareClientSession(SSL* ssl, const std::string& peer)
+{
+  std::string* pPeer = static_cast<std::string*>(SSL_get_ex_data(ssl, ssl_peer_ex_index));
+  delete pPeer;
+  SSL_set_ex_data(ssl, ssl_peer_ex_index, new std::string(peer));
+
+  OSS::mutex_critic_sec_lock lock(_clientMutex);
+  ClientSessions::iterator iter = _clientSessions.find(peer);
+  if (iter == _clientSessions.end())
+    return;
+
+  SSL_SESSION* session = iter->second.session;
+#if OPENSSL_VERSION_NUMBER >= 0x10101000L
+  if (!SSL_SESSION_is_resumable(session) ||
+    (long)std::time(0) >= SSL_SESSION_get_time(session) + SSL_SESSION_get_timeout(session))
+#else
+  if ((long)std::time(0) >= SSL_SESSION_get_time(session) + SSL_SESSION_get_timeout(session))
+#endif
+  {
+    SSL_SESSION_free(session);
+    _clientSessions.erase(iter);
+    return;
+  }
+
+  iter->second.lastUsed = OSS::getTime();
+  SSL_set_session(ssl, session);
+}
+
+void TlsSessionCache::removeClientSession(const std::string& peer)
+{
+  OSS::mutex_critic_sec_lock lock(_clientMutex);
+  ClientSessions::iterator iter = _clientSessions.find(peer);
+  if (iter != _clientSessions.end())
+  {
+    SSL_SESSION_free(iter->second.session);
+    _clientSessions.erase(iter);
+  }
+}
+
+void TlsSessionCache::countHandshake()
+{
+  OSS::UInt64 now = OSS::getTime();
+  OSS::mutex_critic_sec_lock lock(_rateMutex);
+  if (now - _rateWindowStart >= 1000)
+  {
+    //
+    // A window older than two seconds means no handshake happened
+    // during the last full second
+    //
+    _lastRate = now - _rateWindowStart < 2000 ? _rateWindowCount : 0;
+    _rateWindowStart = now;
+    _rateWindowCount = 0;
+  }
+  _rateWindowCount++;
+}
+
+void TlsSessionCache::onHandshake(SSL* ssl, bool isServer, bool success)
+{
+  if (!success || !ssl)
+  {
+    _failedHandshakes++;
+    return;
+  }
+
+  bool resumed = SSL_session_reused(ssl) != 0;
+  if (isServer)
+  {
+    _serverHandshakes++;
+    if (resumed)
+      _serverResumed++;
+  }
+  else
+  {
+    _clientHandshakes++;
+    if (resumed)
+      _clientResumed++;
+  }
+  countHandshake();
+}
+
+void TlsSessionCache::onDisconnect(SSL* ssl)
+{
+  if (ssl && SSL_is_init_finished(ssl))
+    SSL_set_shutdown(ssl, SSL_get_shutdown(ssl) | SSL_SENT_SHUTDOWN);
+}
+
+TlsSessionCache::Stats TlsSessionCache::getStats() const
+{
+  Stats stats;
+  stats.serverHandshakes = _serverHandshakes;
+  stats.serverResumed = _serverResumed;
+  stats.clientHandshakes = _clientHandshakes;
+  stats.clientResumed = _clientResumed;
+  stats.failedHandshakes = _failedHandshakes;
+  stats.ticketKeyRotations = _ticketKeyRotations;
+
+  {
+    OSS::UInt64 now = OSS::getTime();
+    OSS::mutex_critic_sec_lock lock(_rateMutex);
+    if (now - _rateWindowStart < 1000)
+      stats.handshakesPerSecond = _lastRate;
+    else if (now - _rateWindowStart < 2000)
+      stats.handshakesPerSecond = _rateWindowCount;
+  }
+
+  if (_pServerContext)
+    stats.serverCacheSize = SSL_CTX_sess_number(_pServerContext);
+
+  OSS::mutex_critic_sec_lock lock(_clientMutex);
+  stats.clientCacheSize = _clientSessions.size();
+  return stats;
+}
+
+
+} } // OSS::Net
+
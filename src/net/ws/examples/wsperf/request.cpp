@@ -47,6 +47,10 @@ void request::process(unsigned int id) {
             test = case_handler_ptr(new message_test(command));
             token = test->get_token();
             uri = test->get_uri();
+        } else if (command.command == "sip_test") {
+            test = case_handler_ptr(new sip_test(command));
+            token = test->get_token();
+            uri = test->get_uri();
         } else if (command.command == "stress_test") {
             shandler = stress_handler_ptr(new stress_aggregate(command));
             
@@ -91,6 +95,18 @@ void request::process(unsigned int id) {
             e.connect(uri);
             e.run();
             
+            writer->write(prepare_response_object("test_data",test->get_data()));
+        } else if (command.command == "sip_test") {
+            client e(test);
+            
+            e.alog().unset_level(websocketpp::log::alevel::ALL);
+            e.elog().unset_level(websocketpp::log::elevel::ALL);
+            
+            client::connection_ptr con = e.get_connection(uri);
+            con->add_subprotocol("sip");
+            e.connect(con);
+            e.run();
+            
             writer->write(prepare_response_object("test_data",test->get_data()));
         } else if (command.command == "stress_test") {
             client e(shandler);
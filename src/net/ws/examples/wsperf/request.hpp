@@ -30,6 +30,7 @@
 
 #include "case.hpp"
 #include "generic.hpp"
+#include "sip.hpp"
 #include "wscmd.hpp"
 
 #include "../../src/roles/client.hpp"
@@ -0,0 +1,179 @@
+/*
+ * Copyright (c) OSS Software Solutions. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the WebSocket++ Project nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * 
+ */
+
+
+#include "sip.hpp"
+
+#include <cstdlib>
+ 
+using wsperf::sip_test;
+
+// Construct a sip_test from a wscmd command
+/* Reads values from the wscmd object into member variables. The cmd object is
+ * passed to the parent constructor for extracting values common to all test
+ * cases.
+ *
+ * Values that sip_test checks for:
+ *
+ * method=[string];
+ * Example: method=register;
+ * Example: method=message;
+ * REGISTER loads a registrar. MESSAGE loads the proxy path.
+ *
+ * count=[integer];
+ * Example: count=10000;
+ * Number of requests to send.
+ *
+ * timeout=[integer];
+ * Example: timeout=10000;
+ * How long to wait (in ms) for all final responses before failing the test.
+ *
+ * window=[integer];
+ * Example: window=32;
+ * Optional. Number of requests kept outstanding. Defaults to 1 which waits
+ * for each response before sending the next request.
+ *
+ * size=[integer];
+ * Example: size=160;
+ * Optional. Size of the MESSAGE body in bytes. Defaults to 0.
+ *
+ * Any final response counts toward the request count. A response other than
+ * 2xx fails the test.
+ */
+sip_test::sip_test(wscmd::cmd& cmd) 
+ : case_handler(cmd), 
+   m_request_count(extract_number<uint64_t>(cmd,"count")),
+   m_window(1),
+   m_timeout(extract_number<uint64_t>(cmd,"timeout")),
+   m_sent(0),
+   m_responses(0)
+{
+    if (cmd.args["method"] == "register") {
+        m_method = SIP_REGISTER;
+    } else if (cmd.args["method"] == "message") {
+        m_method = SIP_MESSAGE;
+    } else {
+        throw case_exception("Invalid method parameter.");
+    }
+    
+    if (!wscmd::extract_number<uint64_t>(cmd,"window",m_window) || m_window == 0) {
+        m_window = 1;
+    }
+    
+    size_t size = 0;
+    if (wscmd::extract_number<size_t>(cmd,"size",size)) {
+        fill_utf8(m_body,size,true);
+    }
+    
+    // host[:port] part of the uri is used as the SIP domain
+    std::string::size_type start = m_uri.find("://");
+    start = (start == std::string::npos ? 0 : start + 3);
+    std::string::size_type end = m_uri.find('/',start);
+    m_host = m_uri.substr(start,end == std::string::npos ? std::string::npos : end - start);
+    
+    std::stringstream id;
+    id << rand() << rand() << "@wsperf";
+    m_call_id = id.str();
+}
+
+void sip_test::on_open(connection_ptr con) {
+    con->alog()->at(websocketpp::log::alevel::DEVEL) 
+        << "sip_test::on_open" << websocketpp::log::endl;
+    
+    start(con,m_timeout);
+    
+    while (m_sent < m_request_count && m_sent < m_window) {
+        send_request(con);
+    }
+}
+
+void sip_test::send_request(connection_ptr con) {
+    uint64_t seq = ++m_sent;
+    std::stringstream req;
+    
+    // One user per request so a registrar stores a binding for each of them
+    if (m_method == SIP_REGISTER) {
+        req << "REGISTER sip:" << m_host << " SIP/2.0\r\n"
+            << "Via: SIP/2.0/WS wsperf.invalid;branch=z9hG4bK" << seq << "\r\n"
+            << "Max-Forwards: 70\r\n"
+            << "From: <sip:u" << seq << "@" << m_host << ">;tag=" << seq << "\r\n"
+            << "To: <sip:u" << seq << "@" << m_host << ">\r\n"
+            << "Call-ID: " << seq << "-" << m_call_id << "\r\n"
+            << "CSeq: 1 REGISTER\r\n"
+            << "Contact: <sip:u" << seq << "@wsperf.invalid;transport=ws>;expires=600\r\n"
+            << "Expires: 600\r\n"
+            << "Content-Length: 0\r\n\r\n";
+    } else {
+        req << "MESSAGE sip:u" << seq << "@" << m_host << " SIP/2.0\r\n"
+            << "Via: SIP/2.0/WS wsperf.invalid;branch=z9hG4bK" << seq << "\r\n"
+            << "Max-Forwards: 70\r\n"
+            << "From: <sip:wsperf@" << m_host << ">;tag=" << seq << "\r\n"
+            << "To: <sip:u" << seq << "@" << m_host << ">\r\n"
+            << "Call-ID: " << m_call_id << "\r\n"
+            << "CSeq: " << seq << " MESSAGE\r\n"
+            << "Content-Type: text/plain\r\n"
+            << "Content-Length: " << m_body.size() << "\r\n\r\n"
+            << m_body;
+    }
+    
+    con->send(req.str(),websocketpp::frame::opcode::TEXT);
+}
+
+void sip_test::on_message(connection_ptr con,websocketpp::message::data_ptr msg) {
+    if (m_pass != RUNNING) {
+        return;
+    }
+    
+    const std::string& payload = msg->get_payload();
+    if (payload.compare(0,8,"SIP/2.0 ") != 0 || payload.size() < 11) {
+        // not a response
+        return;
+    }
+    
+    int code = atoi(payload.c_str() + 8);
+    if (code < 200) {
+        return;
+    }
+    
+    m_responses++;
+    m_bytes += payload.size();
+    mark();
+    
+    if (code >= 300) {
+        m_pass = FAIL;
+        this->end(con);
+    } else if (m_responses == m_request_count) {
+        m_pass = PASS;
+        this->end(con);
+    } else if (m_sent < m_request_count) {
+        send_request(con);
+    }
+}
+
+uint64_t sip_test::get_responses() const {
+    return m_responses;
+}
@@ -0,0 +1,79 @@
+/*
+ * Copyright (c) OSS Software Solutions. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the WebSocket++ Project nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * 
+ */
+
+
+#ifndef WSPERF_CASE_SIP_HPP
+#define WSPERF_CASE_SIP_HPP
+
+#include "case.hpp"
+#include "wscmd.hpp"
+
+namespace wsperf {
+
+enum sip_method {
+    SIP_REGISTER = 0,
+    SIP_MESSAGE = 1
+};
+
+/// SIP over WebSocket (RFC 7118) load case
+/**
+ * Sends SIP requests on a connection negotiated with the `sip` subprotocol
+ * and measures the time until each final response arrives. Up to `window`
+ * requests are kept outstanding.
+ */
+class sip_test : public case_handler {
+public:
+    /// Construct a SIP test from a wscmd command
+    explicit sip_test(wscmd::cmd& cmd);
+    
+    void on_open(connection_ptr con);
+    void on_message(connection_ptr con,websocketpp::message::data_ptr msg);
+    
+    /// Number of final responses received
+    uint64_t get_responses() const;
+private:
+    void send_request(connection_ptr con);
+    
+    // Simulation Parameters
+    sip_method          m_method;
+    uint64_t            m_request_count;
+    uint64_t            m_window;
+    uint64_t            m_timeout;
+    std::string         m_host;
+    std::string         m_body;
+    
+    // Simulation temporaries
+    std::string         m_call_id;
+    uint64_t            m_sent;
+    uint64_t            m_responses;
+};
+
+typedef boost::shared_ptr<sip_test> sip_test_ptr;
+
+} // namespace wsperf
+
+#endif // WSPERF_CASE_SIP_HPP
@@ -73,6 +73,9 @@ namespace websocketpp {
     
     const size_t MAX_THREAD_POOL_SIZE = 64;
     
+    // Maximum number of queued frames sent in a single gathered write
+    const size_t MAX_WRITE_BATCH = 64;
+    
     const uint16_t DEFAULT_PORT = 80;
     const uint16_t DEFAULT_SECURE_PORT = 443;
     
@@ -46,6 +46,7 @@
 #include <iostream> // temporary?
 #include <vector>
 #include <string>
+#include <deque>
 #include <queue>
 #include <set>
 
@@ -116,6 +117,7 @@ public:
      , m_timer(e.endpoint_base::m_io_service,boost::posix_time::seconds(0))
      , m_state(session::state::CONNECTING)
      , m_protocol_error(false)
+     , m_write_batch(0)
      , m_write_buffer(0)
      , m_write_state(IDLE)
      , m_fail_code(fail::status::GOOD)
@@ -1172,7 +1174,7 @@ public:
         if (m_write_state == INTURRUPT) {return;}
         
         m_write_buffer += msg->get_payload().size();
-        m_write_queue.push(msg);
+        m_write_queue.push_back(msg);
         
         write();
     }
@@ -1195,7 +1197,7 @@ public:
                 // clear the queue except for the last message
                 while (m_write_queue.size() > 1) {
                     m_write_buffer -= m_write_queue.front()->get_payload().size();
-                    m_write_queue.pop();
+                    m_write_queue.pop_front();
                 }
                 break;
             default:
@@ -1207,9 +1209,22 @@ public:
             if (m_write_state == IDLE) {
                 m_write_state = WRITING;
             }
-                        
-            m_write_buf.push_back(boost::asio::buffer(m_write_queue.front()->get_header()));
-            m_write_buf.push_back(boost::asio::buffer(m_write_queue.front()->get_payload()));
+            
+            // Every frame queued while the previous write was in flight goes
+            // out in a single gathered write. A close frame ends the batch so
+            // that handle_write sees it last.
+            m_write_batch = 0;
+            for (std::deque<message::data_ptr>::const_iterator it = m_write_queue.begin();
+                 it != m_write_queue.end() && m_write_batch < MAX_WRITE_BATCH; ++it)
+            {
+                m_write_buf.push_back(boost::asio::buffer((*it)->get_header()));
+                m_write_buf.push_back(boost::asio::buffer((*it)->get_payload()));
+                ++m_write_batch;
+                
+                if ((*it)->get_opcode() == frame::opcode::CLOSE) {
+                    break;
+                }
+            }
             
             //m_endpoint.alog().at(log::alevel::DEVEL) << "write header: " << zsutil::to_hex(m_write_queue.front()->get_header()) << log::endl;
             
@@ -1274,12 +1289,16 @@ public:
             return;
         }
         
-        m_write_buffer -= m_write_queue.front()->get_payload().size();
         m_write_buf.clear();
         
-        frame::opcode::value code = m_write_queue.front()->get_opcode();
+        frame::opcode::value code = frame::opcode::BINARY;
         
-        m_write_queue.pop();
+        for (size_t i = 0; i < m_write_batch && !m_write_queue.empty(); ++i) {
+            m_write_buffer -= m_write_queue.front()->get_payload().size();
+            code = m_write_queue.front()->get_opcode();
+            m_write_queue.pop_front();
+        }
+        m_write_batch = 0;
         
         if (m_write_state == WRITING) {
             m_write_state = IDLE;
@@ -1509,7 +1528,8 @@ public:
     
     // Write queue
     std::vector<boost::asio::const_buffer> m_write_buf;
-    std::queue<message::data_ptr>   m_write_queue;
+    std::deque<message::data_ptr>   m_write_queue;
+    size_t                          m_write_batch;
     uint64_t                        m_write_buffer;
     write_state                     m_write_state;
     
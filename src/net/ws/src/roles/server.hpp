@@ -215,6 +215,11 @@ public:
     }
 
     void stop_listen(bool join);
+    
+    // Closes the acceptor then waits for the threads started by start_listen
+    // to run out of work. stop_listen(true) joins first and would block on
+    // the pending accept.
+    void close_and_join();
 
     // legacy interface
     void listen(uint16_t port, size_t num_threads = 1) {
@@ -347,6 +352,23 @@ void server<endpoint>::stop_listen(bool join) {
 	m_state = IDLE;
 }
 
+template <class endpoint>
+void server<endpoint>::close_and_join() {
+    {
+        boost::unique_lock<boost::recursive_mutex> lock(m_endpoint.m_lock);
+        
+        if (m_state == LISTENING) {
+            m_acceptor.close();
+            m_state = IDLE;
+        }
+    }
+    
+    for (std::size_t i = 0; i < m_listening_threads.size(); ++i) {
+        m_listening_threads[i]->join();
+    }
+    m_listening_threads.clear();
+}
+
 template <class endpoint>
 void server<endpoint>::start_listen(uint16_t port, size_t num_threads) {
     start_listen(boost::asio::ip::tcp::v6(), port, num_threads);
@@ -0,0 +1,639 @@
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "GNU Lesser General Public License (LGPL)".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+#include "OSS/Persistent/RedisAsyncClient.h"
+
+#if OSS_HAVE_HIREDIS
+
+#include <deque>
+#include <set>
+#include <boost/bind.hpp>
+#include <boost/functional/hash.hpp>
+#include <boost/enable_shared_from_this.hpp>
+
+
+namespace OSS {
+namespace Persistent {
+
+
+RedisReply::RedisReply() :
+  type(REDIS_REPLY_NIL),
+  integer(0)
+{
+}
+
+bool RedisReply::isError() const
+{
+  return type == REDIS_REPLY_ERROR;
+}
+
+bool RedisReply::isNil() const
+{
+  return type == REDIS_REPLY_NIL;
+}
+
+bool RedisReply::isOk() const
+{
+  switch (type)
+  {
+  case REDIS_REPLY_STATUS:
+    return strcasecmp(str.c_str(), "ok") == 0;
+  case REDIS_REPLY_STRING:
+  case REDIS_REPLY_INTEGER:
+  case REDIS_REPLY_ARRAY:
+    return true;
+  default:
+    return false;
+  }
+}
+
+static void copy_reply_elements(const redisReply* reply, std::vector<std::string>& elements)
+{
+  for (size_t i = 0; i < reply->elements; i++)
+  {
+    const redisReply* item = reply->element[i];
+    if (!item)
+      continue;
+    if (item->type == REDIS_REPLY_ARRAY)
+      copy_reply_elements(item, elements);
+    else if (item->type == REDIS_REPLY_INTEGER)
+      elements.push_back(boost::lexical_cast<std::string>(item->integer));
+    else if (item->type == REDIS_REPLY_NIL)
+      elements.push_back(std::string());
+    else
+      elements.push_back(std::string(item->str, item->len));
+  }
+}
+
+static void copy_reply(const redisReply* reply, RedisReply& result)
+{
+  result.type = reply->type;
+  switch (reply->type)
+  {
+  case REDIS_REPLY_INTEGER:
+    result.integer = reply->integer;
+    break;
+  case REDIS_REPLY_STRING:
+  case REDIS_REPLY_STATUS:
+  case REDIS_REPLY_ERROR:
+    result.str = std::string(reply->str, reply->len);
+    break;
+  case REDIS_REPLY_ARRAY:
+    copy_reply_elements(reply, result.elements);
+    break;
+  default:
+    break;
+  }
+}
+
+static RedisReply make_error_reply(const std::string& error)
+{
+  RedisReply reply;
+  reply.type = REDIS_REPLY_ERROR;
+  reply.str = error;
+  return reply;
+}
+
+
+class RedisAsyncClient::Connection : public RedisClient
+  /// A single connection of the pool and the thread that drains its queue
+{
+public:
+  struct Request
+  {
+    Commands commands;
+    ReplyHandler handler;
+  };
+
+  Connection(const std::string& tcpHost, int tcpPort) :
+    RedisClient(tcpHost, tcpPort),
+    _maxPipeline(DEFAULT_MAX_PIPELINE),
+    _terminate(false),
+    _pThread(0),
+    _up(false),
+    _db(0),
+    _commands(0),
+    _batches(0),
+    _errors(0)
+  {
+  }
+
+  ~Connection()
+  {
+    stop();
+  }
+
+  bool start(const std::string& password, int db)
+  {
+    //
+    // The thread is started even if the connection failed.  It retries
+    // every RECONNECT_INTERVAL while commands fail fast.
+    //
+    _password = password;
+    _db = db;
+    bool connected = connect(password, db);
+    _up = connected;
+    _terminate = false;
+    _pThread = new boost::thread(boost::bind(&Connection::run, this));
+    return connected;
+  }
+
+  void stop()
+  {
+    if (!_pThread)
+      return;
+    {
+      boost::unique_lock<boost::mutex> lock(_queueMutex);
+      _terminate = true;
+    }
+    _queueReady.notify_one();
+    _pThread->join();
+    delete _pThread;
+    _pThread = 0;
+    disconnect();
+  }
+
+  void enqueue(Request& request)
+  {
+    {
+      boost::unique_lock<boost::mutex> lock(_queueMutex);
+      if (_terminate || !_pThread)
+      {
+        lock.unlock();
+        if (request.handler)
+          request.handler(make_error_reply("Redis client is not connected"));
+        return;
+      }
+      if (!_up)
+      {
+        //
+        // Do not let commands pile up behind a connection that is down
+        //
+        lock.unlock();
+        _errors += request.commands.size();
+        if (request.handler)
+          request.handler(make_error_reply("Redis connection is down"));
+        return;
+      }
+      _queue.push_back(Request());
+      _queue.back().commands.swap(request.commands);
+      _queue.back().handler.swap(request.handler);
+    }
+    _queueReady.notify_one();
+  }
+
+  void setMaxPipeline(std::size_t maxPipeline)
+  {
+    _maxPipeline = maxPipeline ? maxPipeline : 1;
+  }
+
+  bool isUp() const
+  {
+    return _up;
+  }
+
+  void collectStats(Stats& stats) const
+  {
+    stats.commands += _commands;
+    stats.batches += _batches;
+    stats.errors += _errors;
+  }
+
+private:
+  void run()
+  {
+    std::deque<Request> batch;
+    bool terminate = false;
+    while (!terminate)
+    {
+      {
+        boost::unique_lock<boost::mutex> lock(_queueMutex);
+        while (_queue.empty() && !_terminate)
+        {
+          if (_up)
+          {
+            _queueReady.wait(lock);
+            continue;
+          }
+          _queueReady.timed_wait(lock, boost::posix_time::milliseconds((long)RECONNECT_INTERVAL));
+          if (!_up && !_terminate)
+          {
+            lock.unlock();
+            reconnect();
+            lock.lock();
+          }
+        }
+
+        terminate = _terminate;
+        if (terminate)
+        {
+          //
+          // Fail everything that is still queued.  The handlers are called
+          // outside the lock below.
+          //
+          batch.swap(_queue);
+        }
+        else
+        {
+          std::size_t commandCount = 0;
+          while (!_queue.empty() && commandCount < _maxPipeline)
+          {
+            commandCount += _queue.front().commands.size();
+            batch.push_back(Request());
+            batch.back().commands.swap(_queue.front().commands);
+            batch.back().handler.swap(_queue.front().handler);
+            _queue.pop_front();
+          }
+        }
+      }
+
+      if (terminate)
+      {
+        fail(batch, "Redis client disconnected");
+        return;
+      }
+
+      process(batch);
+      batch.clear();
+    }
+  }
+
+  void process(std::deque<Request>& batch)
+  {
+    Commands commands;
+    for (std::deque<Request>::iterator iter = batch.begin(); iter != batch.end(); iter++)
+      commands.insert(commands.end(), iter->commands.begin(), iter->commands.end());
+
+    std::vector<redisReply*> replies;
+    if (!pipeline(commands, replies))
+    {
+      _up = false;
+      fail(batch, _lastError.empty() ? std::string("Redis pipeline failed") : _lastError);
+      return;
+    }
+    _up = true;
+
+    _commands += commands.size();
+    _batches++;
+
+    std::size_t index = 0;
+    for (std::deque<Request>::iterator iter = batch.begin(); iter != batch.end(); iter++)
+    {
+      RedisReply result;
+      bool hasError = false;
+      for (std::size_t i = 0; i < iter->commands.size(); i++, index++)
+      {
+        redisReply* reply = replies[index];
+        if (!hasError && iter->handler)
+        {
+          //
+          // Only the first error or the last reply is reported for groups
+          //
+          if (reply->type == REDIS_REPLY_ERROR || i + 1 == iter->commands.size())
+          {
+            result = RedisReply();
+            copy_reply(reply, result);
+            hasError = reply->type == REDIS_REPLY_ERROR;
+          }
+        }
+        freeReply(reply);
+      }
+
+      if (iter->handler)
+        iter->handler(result);
+    }
+  }
+
+  void reconnect()
+  {
+    if (connect(_password, _db))
+    {
+      OSS_LOG_INFO("[REDIS] RedisAsyncClient - Reconnected to tcp:" << _tcpHost << ":" << _tcpPort);
+      _up = true;
+    }
+  }
+
+  void fail(std::deque<Request>& batch, const std::string& error)
+  {
+    RedisReply reply = make_error_reply(error);
+    for (std::deque<Request>::iterator iter = batch.begin(); iter != batch.end(); iter++)
+    {
+      _errors += iter->commands.size();
+      if (iter->handler)
+        iter->handler(reply);
+    }
+  }
+
+  boost::mutex _queueMutex;
+  boost::condition_variable _queueReady;
+  std::deque<Request> _queue;
+  std::size_t _maxPipeline;
+  bool _terminate;
+  boost::thread* _pThread;
+  boost::atomic<bool> _up;
+    /// False from a failed connect or batch until the thread reconnects
+  std::string _password;
+  int _db;
+  boost::atomic<OSS::UInt64> _commands;
+  boost::atomic<OSS::UInt64> _batches;
+  boost::atomic<OSS::UInt64> _errors;
+};
+
+
+RedisAsyncClient::Stats::Stats() :
+  commands(0),
+  batches(0),
+  errors(0)
+{
+}
+
+RedisAsyncClient::RedisAsyncClient(const std::string& tcpHost, int tcpPort, std::size_t poolSize) :
+  _tcpHost(tcpHost),
+  _tcpPort(tcpPort),
+  _poolSize(poolSize ? poolSize : 1),
+  _roundRobin(0),
+  _started(false)
+{
+  for (std::size_t i = 0; i < _poolSize; i++)
+    _pool.push_back(new Connection(_tcpHost, _tcpPort));
+}
+
+RedisAsyncClient::~RedisAsyncClient()
+{
+  disconnect();
+  for (Pool::iterator iter = _pool.begin(); iter != _pool.end(); iter++)
+    delete *iter;
+  _pool.clear();
+}
+
+bool RedisAsyncClient::connect(const std::string& password, int db)
+{
+  disconnect();
+  bool ok = true;
+  for (Pool::iterator iter = _pool.begin(); iter != _pool.end(); iter++)
+  {
+    if (!(*iter)->start(password, db))
+      ok = false;
+  }
+
+  if (!ok)
+  {
+    OSS_LOG_ERROR("[REDIS] RedisAsyncClient - Unable to connect all " << _poolSize << " connections to tcp:" << _tcpHost << ":" << _tcpPort);
+  }
+
+  _started = true;
+  return ok;
+}
+
+void RedisAsyncClient::disconnect()
+{
+  if (!_started)
+    return;
+  for (Pool::iterator iter = _pool.begin(); iter != _pool.end(); iter++)
+    (*iter)->stop();
+  _started = false;
+}
+
+bool RedisAsyncClient::isConnected() const
+{
+  if (!_started)
+    return false;
+  for (Pool::const_iterator iter = _pool.begin(); iter != _pool.end(); iter++)
+  {
+    if (!(*iter)->isUp())
+      return false;
+  }
+  return true;
+}
+
+void RedisAsyncClient::setMaxPipeline(std::size_t maxPipeline)
+{
+  for (Pool::iterator iter = _pool.begin(); iter != _pool.end(); iter++)
+    (*iter)->setMaxPipeline(maxPipeline);
+}
+
+RedisAsyncClient::Connection* RedisAsyncClient::selectConnection(const Command& command)
+{
+  if (_pool.size() == 1)
+    return _pool.front();
+
+  //
+  // Commands that carry a key are pinned to a connection so that
+  // writes and reads for the same key are never reordered.
+  //
+  if (command.size() > 1)
+    return _pool[boost::hash<std::string>()(command[1]) % _pool.size()];
+
+  return _pool[_roundRobin++ % _pool.size()];
+}
+
+void RedisAsyncClient::execute(const Command& command, const ReplyHandler& handler)
+{
+  Connection::Request request;
+  request.commands.push_back(command);
+  request.handler = handler;
+  selectConnection(command)->enqueue(request);
+}
+
+static void set_promise_value(boost::shared_ptr< boost::promise<RedisReply> > promise, const RedisReply& reply)
+{
+  promise->set_value(reply);
+}
+
+RedisAsyncClient::ReplyFuture RedisAsyncClient::execute(const Command& command, bool)
+{
+  boost::shared_ptr< boost::promise<RedisReply> > promise(new boost::promise<RedisReply>());
+  ReplyFuture future = promise->get_future().share();
+  execute(command, boost::bind(set_promise_value, promise, _1));
+  return future;
+}
+
+void RedisAsyncClient::execute(const Commands& commands, const ReplyHandler& handler)
+{
+  if (commands.empty())
+    return;
+  Connection::Request request;
+  request.commands = commands;
+  request.handler = handler;
+  selectConnection(commands.front())->enqueue(request);
+}
+
+void RedisAsyncClient::set(const std::string& key, const std::string& value, int seconds, const ReplyHandler& handler)
+{
+  Command command;
+  if (seconds == -1)
+  {
+    command.push_back("SET");
+    command.push_back(key);
+    command.push_back(value);
+  }
+  else
+  {
+    command.push_back("SETEX");
+    command.push_back(key);
+    command.push_back(boost::lexical_cast<std::string>(seconds));
+    command.push_back(value);
+  }
+  execute(command, handler);
+}
+
+void RedisAsyncClient::get(const std::string& key, const ReplyHandler& handler)
+{
+  Command command;
+  command.push_back("GET");
+  command.push_back(key);
+  execute(command, handler);
+}
+
+void RedisAsyncClient::del(const std::string& key, const ReplyHandler& handler)
+{
+  Command command;
+  command.push_back("DEL");
+  command.push_back(key);
+  execute(command, handler);
+}
+
+void RedisAsyncClient::mset(const std::map<std::string, std::string>& values, int seconds, const ReplyHandler& handler)
+{
+  if (values.empty())
+    return;
+
+  Commands commands;
+  if (seconds == -1)
+  {
+    Command command;
+    command.reserve(values.size() * 2 + 1);
+    command.push_back("MSET");
+    for (std::map<std::string, std::string>::const_iterator iter = values.begin(); iter != values.end(); iter++)
+    {
+      command.push_back(iter->first);
+      command.push_back(iter->second);
+    }
+    commands.push_back(command);
+  }
+  else
+  {
+    std::string expires = boost::lexical_cast<std::string>(seconds);
+    commands.reserve(values.size());
+    for (std::map<std::string, std::string>::const_iterator iter = values.begin(); iter != values.end(); iter++)
+    {
+      Command command;
+      command.push_back("SETEX");
+      command.push_back(iter->first);
+      command.push_back(expires);
+      command.push_back(iter->second);
+      commands.push_back(command);
+    }
+  }
+  execute(commands, handler);
+}
+
+void RedisAsyncClient::hmset(const std::string& key, const std::map<std::string, std::string>& hmap, const ReplyHandler& handler)
+{
+  Command command;
+  command.reserve(hmap.size() * 2 + 2);
+  command.push_back("HMSET");
+  command.push_back(key);
+  for (std::map<std::string, std::string>::const_iterator iter = hmap.begin(); iter != hmap.end(); iter++)
+  {
+    command.push_back(iter->first);
+    command.push_back(iter->second);
+  }
+  execute(command, handler);
+}
+
+
+struct RedisScanState : boost::enable_shared_from_this<RedisScanState>
+  /// Drives a SCAN iteration by issuing the next step from the reply
+  /// handler of the previous one.
+{
+  typedef boost::function<void(const RedisAsyncClient::Command&, const RedisAsyncClient::ReplyHandler&)> Executor;
+
+  Executor executor;
+  RedisAsyncClient::KeysHandler handler;
+  std::string pattern;
+  std::string count;
+  std::set<std::string> keys;
+
+  void next(const std::string& cursor)
+  {
+    RedisAsyncClient::Command command;
+    command.push_back("SCAN");
+    command.push_back(cursor);
+    command.push_back("MATCH");
+    command.push_back(pattern);
+    command.push_back("COUNT");
+    command.push_back(count);
+    executor(command, boost::bind(&RedisScanState::onReply, shared_from_this(), _1));
+  }
+
+  void onReply(const RedisReply& reply)
+  {
+    if (reply.type != REDIS_REPLY_ARRAY || reply.elements.empty())
+    {
+      handler(false, std::vector<std::string>(keys.begin(), keys.end()));
+      return;
+    }
+
+    //
+    // Duplicates are possible if the keyspace is rehashed mid-iteration
+    //
+    keys.insert(reply.elements.begin() + 1, reply.elements.end());
+    if (reply.elements.front() == "0")
+      handler(true, std::vector<std::string>(keys.begin(), keys.end()));
+    else
+      next(reply.elements.front());
+  }
+};
+
+void RedisAsyncClient::scan(const std::string& pattern, const KeysHandler& handler, std::size_t count)
+{
+  boost::shared_ptr<RedisScanState> state(new RedisScanState());
+  //
+  // All steps of an iteration go to the same connection since SCAN has no
+  // key argument and the cursor is only meaningful in sequence.
+  //
+  Connection* pConnection = _pool[_roundRobin++ % _pool.size()];
+  state->executor = boost::bind(&RedisAsyncClient::executeOn, pConnection, _1, _2);
+  state->handler = handler;
+  state->pattern = pattern;
+  state->count = boost::lexical_cast<std::string>(count);
+  state->next("0");
+}
+
+void RedisAsyncClient::executeOn(Connection* pConnection, const Command& command, const ReplyHandler& handler)
+{
+  Connection::Request request;
+  request.commands.push_back(command);
+  request.handler = handler;
+  pConnection->enqueue(request);
+}
+
+RedisAsyncClient::Stats RedisAsyncClient::getStats() const
+{
+  Stats stats;
+  for (Pool::const_iterator iter = _pool.begin(); iter != _pool.end(); iter++)
+    (*iter)->collectStats(stats);
+  return stats;
+}
+
+
+} } // OSS::Persistent
+
+#endif // OSS_HAVE_HIREDIS
@@ -18,6 +18,8 @@
 //
 
 #include "OSS/Persistent/RedisClient.h"
+#include <set>
+#include <algorithm>
 
 #if OSS_HAVE_HIREDIS
 
@@ -25,6 +27,38 @@ namespace OSS {
 namespace Persistent {
   
 
+static RedisClient::Command scan_command(unsigned long long cursor, const std::string& pattern, std::size_t count)
+{
+  RedisClient::Command args;
+  args.push_back("SCAN");
+  args.push_back(boost::lexical_cast<std::string>(cursor));
+  args.push_back("MATCH");
+  args.push_back(pattern);
+  args.push_back("COUNT");
+  args.push_back(boost::lexical_cast<std::string>(count));
+  return args;
+}
+
+static bool parse_scan_reply(redisReply* reply, unsigned long long& cursor, std::vector<std::string>& keys)
+{
+  if (!reply || reply->type != REDIS_REPLY_ARRAY || reply->elements != 2 ||
+    reply->element[0]->type != REDIS_REPLY_STRING || reply->element[1]->type != REDIS_REPLY_ARRAY)
+  {
+    cursor = 0;
+    return false;
+  }
+
+  cursor = strtoull(reply->element[0]->str, 0, 10);
+  redisReply* items = reply->element[1];
+  for (size_t i = 0; i < items->elements; i++)
+  {
+    redisReply* item = items->element[i];
+    if (item && item->type == REDIS_REPLY_STRING)
+      keys.push_back(std::string(item->str, item->len));
+  }
+  return true;
+}
+
 
 RedisClient::RedisClient() :
     _context(0),
@@ -355,6 +389,73 @@ redisReply* RedisClient::execute(int argc, char** argv)
 }
 
 
+bool RedisClient::pipeline(const Commands& commands, std::vector<redisReply*>& replies)
+{
+  mutex_lock lock(_mutex);
+
+  if (commands.empty())
+    return true;
+
+  if (!_context && !connect())
+  {
+    OSS_LOG_ERROR("[REDIS] Connect FAILED.  Unable to create a new context for pipeline.");
+    return false;
+  }
+
+  std::vector<const char*> argv;
+  std::vector<size_t> argvlen;
+  for (Commands::const_iterator iter = commands.begin(); iter != commands.end(); iter++)
+  {
+    argv.clear();
+    argvlen.clear();
+    for (Command::const_iterator arg = iter->begin(); arg != iter->end(); arg++)
+    {
+      argv.push_back(arg->data());
+      argvlen.push_back(arg->size());
+    }
+    if (argv.empty() || redisAppendCommandArgv(_context, argv.size(), &argv[0], &argvlen[0]) != REDIS_OK)
+    {
+      _lastError = _context->errstr;
+      OSS_LOG_ERROR("[REDIS] Pipeline append FAILED.  - " << _lastError);
+      disconnect();
+      return false;
+    }
+  }
+
+  //
+  // The first call to redisGetReply flushes the output buffer.  Replies
+  // are then read back in the order the commands were written.
+  //
+  replies.reserve(replies.size() + commands.size());
+  std::size_t first = replies.size();
+  for (std::size_t i = 0; i < commands.size(); i++)
+  {
+    redisReply* reply = 0;
+    if (redisGetReply(_context, (void**)&reply) != REDIS_OK || !reply)
+    {
+      if (strlen(_context->errstr))
+        _lastError = _context->errstr;
+      OSS_LOG_ERROR("[REDIS] Pipeline read FAILED.  - " << _lastError);
+      for (std::size_t j = first; j < replies.size(); j++)
+        freeReply(replies[j]);
+      replies.resize(first);
+      freeReply(reply);
+      //
+      // The stream is out of sync.  Drop the context and let the next
+      // call reconnect.
+      //
+      redisFree(_context);
+      _context = 0;
+      _connected = false;
+      return false;
+    }
+    replies.push_back(reply);
+  }
+
+  return true;
+}
+
+
 std::string RedisClient::getReplyString(const std::vector<std::string>& args) const
 {
   redisReply* reply = const_cast<RedisClient*>(this)->execute(args);
@@ -800,6 +901,89 @@ bool RedisClient::hmset(const std::string& key, const std::map<std::string, std:
   return status == "0" || status == "1";
 }
 
+bool RedisClient::mset(const std::map<std::string, std::string>& values, int seconds)
+{
+  if (values.empty())
+    return true;
+
+  Commands commands;
+  if (seconds == -1)
+  {
+    Command args;
+    args.reserve(values.size() * 2 + 1);
+    args.push_back("MSET");
+    for (std::map<std::string, std::string>::const_iterator iter = values.begin(); iter != values.end(); iter++)
+    {
+      args.push_back(iter->first);
+      args.push_back(iter->second);
+    }
+    commands.push_back(args);
+  }
+  else
+  {
+    std::string expires = boost::lexical_cast<std::string>(seconds);
+    commands.reserve(values.size());
+    for (std::map<std::string, std::string>::const_iterator iter = values.begin(); iter != values.end(); iter++)
+    {
+      Command args;
+      args.push_back("SETEX");
+      args.push_back(iter->first);
+      args.push_back(expires);
+      args.push_back(iter->second);
+      commands.push_back(args);
+    }
+  }
+
+  std::vector<redisReply*> replies;
+  if (!pipeline(commands, replies))
+    return false;
+
+  bool ok = true;
+  for (std::vector<redisReply*>::iterator iter = replies.begin(); iter != replies.end(); iter++)
+  {
+    if ((*iter)->type != REDIS_REPLY_STATUS || strcasecmp((*iter)->str, "ok") != 0)
+    {
+      if ((*iter)->type == REDIS_REPLY_ERROR)
+      {
+        OSS_LOG_ERROR("[REDIS]  RedisClient::mset ERROR: " << std::string((*iter)->str, (*iter)->len));
+      }
+      ok = false;
+    }
+    freeReply(*iter);
+  }
+  return ok;
+}
+
+bool RedisClient::mget(const std::vector<std::string>& keys, std::vector<std::string>& values) const
+{
+  if (keys.empty())
+    return false;
+
+  std::vector<std::string> args;
+  args.reserve(keys.size() + 1);
+  args.push_back("MGET");
+  args.insert(args.end(), keys.begin(), keys.end());
+
+  redisReply* reply = const_cast<RedisClient*>(this)->execute(args);
+  if (!reply || reply->type != REDIS_REPLY_ARRAY)
+  {
+    const_cast<RedisClient*>(this)->freeReply(reply);
+    return false;
+  }
+
+  values.reserve(values.size() + reply->elements);
+  for (size_t i = 0; i < reply->elements; i++)
+  {
+    redisReply* item = reply->element[i];
+    if (item && item->type == REDIS_REPLY_STRING)
+      values.push_back(std::string(item->str, item->len));
+    else
+      values.push_back(std::string());
+  }
+  const_cast<RedisClient*>(this)->freeReply(reply);
+  return true;
+}
+
 bool RedisClient::get(const std::string& key, json::Object& value) const
 {
   std::string buff;
@@ -832,11 +1016,19 @@ bool RedisClient::getAll(std::vector<std::string>& values, const std::string& pa
 {
   std::vector<std::string> keys;
   getKeys(pattern, keys);
-  for (std::vector<std::string>::const_iterator iter = keys.begin(); iter != keys.end(); iter++)
+
+  std::vector<std::string> batch;
+  for (std::size_t i = 0; i < keys.size(); i += MGET_BATCH_SIZE)
   {
-    std::string value;
-    if (get(*iter, value))
-      values.push_back(value);
+    std::vector<std::string> chunk(keys.begin() + i, keys.begin() + std::min<std::size_t>(keys.size(), i + MGET_BATCH_SIZE));
+    batch.clear();
+    if (!mget(chunk, batch))
+      continue;
+    for (std::vector<std::string>::const_iterator iter = batch.begin(); iter != batch.end(); iter++)
+    {
+      if (!iter->empty())
+        values.push_back(*iter);
+    }
   }
 
   return !values.empty();
@@ -903,13 +1095,151 @@ bool RedisClient::hmget(const std::string& key, const std::vector<std::string>&
 
 bool RedisClient::getKeys(const std::string& pattern, std::vector<std::string>& keys)
 {
-  std::vector<std::string> args;
-  args.push_back("KEYS");
-  args.push_back(pattern);
-  keys = getReplyStringArray(args);
+  //
+  // SCAN may return the same key more than once if the keyspace is
+  // rehashed during the iteration.
+  //
+  keys.clear();
+  std::set<std::string> unique;
+  std::vector<std::string> batch;
+  unsigned long long cursor = 0;
+  do
+  {
+    batch.clear();
+    if (!scan(cursor, pattern, batch))
+      return false;
+    unique.insert(batch.begin(), batch.end());
+  } while (cursor != 0);
+
+  keys.assign(unique.begin(), unique.end());
   return !keys.empty();
 }
 
+bool RedisClient::scan(unsigned long long& cursor, const std::string& pattern, std::vector<std::string>& keys, std::size_t count)
+{
+  redisReply* reply = execute(scan_command(cursor, pattern, count));
+  bool ok = parse_scan_reply(reply, cursor, keys);
+  freeReply(reply);
+  return ok;
+}
+
+std::string RedisClient::escapePattern(const std::string& literal)
+{
+  std::string pattern;
+  pattern.reserve(literal.size() + 4);
+  for (std::string::const_iterator iter = literal.begin(); iter != literal.end(); iter++)
+  {
+    switch (*iter)
+    {
+    case '*':
+    case '?':
+    case '[':
+    case ']':
+    case '\\':
+      pattern.push_back('\\');
+      break;
+    }
+    pattern.push_back(*iter);
+  }
+  return pattern;
+}
+
+bool RedisClient::getKeysWithPrefix(const std::string& prefix, std::vector<std::string>& keys)
+{
+  return getKeys(escapePattern(prefix) + "*", keys);
+}
+
+bool RedisClient::getRecordsWithPrefix(const std::string& prefix, Records& records)
+{
+  return getRecords(escapePattern(prefix) + "*", records);
+}
+
+bool RedisClient::getRecords(const std::string& pattern, Records& records)
+{
+  //
+  // Each round-trip carries the MGETs for the keys found by the previous
+  // SCAN step together with the next SCAN step.
+  //
+  records.clear();
+  std::set<std::string> seen;
+  std::vector<Command> pendingKeys;
+  Commands commands;
+  commands.push_back(scan_command(0, pattern, DEFAULT_SCAN_COUNT));
+  bool scanning = true;
+
+  while (!commands.empty())
+  {
+    std::vector<redisReply*> replies;
+    if (!pipeline(commands, replies))
+    {
+      records.clear();
+      return false;
+    }
+
+    for (std::size_t i = 0; i < pendingKeys.size(); i++)
+    {
+      redisReply* reply = replies[i];
+      if (!reply || reply->type != REDIS_REPLY_ARRAY)
+        continue;
+      for (std::size_t j = 0; j < reply->elements && j < pendingKeys[i].size(); j++)
+      {
+        redisReply* item = reply->element[j];
+        if (item && item->type == REDIS_REPLY_STRING)
+          records.push_back(Record(pendingKeys[i][j], std::string(item->str, item->len)));
+      }
+    }
+
+    std::vector<std::string> keys;
+    if (scanning)
+    {
+      unsigned long long cursor = 0;
+      if (!parse_scan_reply(replies.back(), cursor, keys))
+      {
+        for (std::size_t i = 0; i < replies.size(); i++)
+          freeReply(replies[i]);
+        records.clear();
+        return false;
+      }
+      if (cursor)
+        commands.back() = scan_command(cursor, pattern, DEFAULT_SCAN_COUNT);
+      scanning = cursor != 0;
+    }
+
+    for (std::size_t i = 0; i < replies.size(); i++)
+      freeReply(replies[i]);
+
+    //
+    // SCAN may return the same key more than once if the keyspace is
+    // rehashed during the iteration.
+    //
+    pendingKeys.clear();
+    for (std::vector<std::string>::const_iterator iter = keys.begin(); iter != keys.end(); iter++)
+    {
+      if (!seen.insert(*iter).second)
+        continue;
+      if (pendingKeys.empty() || pendingKeys.back().size() == MGET_BATCH_SIZE)
+        pendingKeys.push_back(Command());
+      pendingKeys.back().push_back(*iter);
+    }
+
+    Command nextScan;
+    if (scanning)
+      nextScan = commands.back();
+    commands.clear();
+    for (std::vector<Command>::const_iterator iter = pendingKeys.begin(); iter != pendingKeys.end(); iter++)
+    {
+      commands.push_back(Command());
+      commands.back().reserve(iter->size() + 1);
+      commands.back().push_back("MGET");
+      commands.back().insert(commands.back().end(), iter->begin(), iter->end());
+    }
+    if (scanning)
+      commands.push_back(nextScan);
+  }
+
+  return !records.empty();
+}
+
 bool RedisClient::del(const std::string& key)
 {
   std::vector<std::string> args;
@@ -26,11 +26,19 @@
 #include "OSS/RTP/RTPProxySession.h"
 #include "OSS/SIP/SIPXOR.h"
 #include "OSS/Net/Net.h"
+#include "OSS/Metrics/MetricsRegistry.h"
 
 
 namespace OSS {
 namespace RTP {
 
+
+static OSS::Metrics::Counter& rtp_packets()
+{
+  static OSS::Metrics::Counter& counter = OSS::Metrics::MetricsRegistry::instance().counter("rtp.packets");
+  return counter;
+}
+
 RTPProxy::RTPProxy(Type type, RTPProxyManager* pManager, RTPProxySession* pSession, const std::string& identifier, bool isXORDisabled) :
   _identifier(identifier),
   _pManager(pManager),
@@ -229,6 +237,8 @@ void RTPProxy::handleLeg1FrameRead(
     _isInactive = true;
     return;
   }
+
+  rtp_packets().increment();
   
   _timeStamp = OSS::getTime();
     
@@ -486,6 +496,8 @@ void RTPProxy::handleLeg2FrameRead(
     _isInactive = true;
     return;
   }
+
+  rtp_packets().increment();
   
   _timeStamp = OSS::getTime();
   
@@ -19,12 +19,19 @@
 
 #include "OSS/RTP/RTPProxyManager.h"
 #include "OSS/UTL/Logger.h"
+#include "OSS/Metrics/MetricsRegistry.h"
 
 
 namespace OSS {
 namespace RTP {
 
 
+static OSS::Metrics::Gauge& rtp_sessions()
+{
+  static OSS::Metrics::Gauge& gauge = OSS::Metrics::MetricsRegistry::instance().gauge("rtp.sessions");
+  return gauge;
+}
+
 RTPProxyManager::RTPProxyManager(int houseKeepingInterval) :
   _ioService(),
   _houseKeepingInterval(houseKeepingInterval),
@@ -129,6 +136,7 @@ void RTPProxyManager::recycleState()
             if (session)
             {
               _sessionList.insert(std::pair<std::string, RTPProxySession::Ptr>(session->getIdentifier(), session));
+              rtp_sessions().set(_sessionList.size());
             }
             
             _sessionListMutex.unlock();
@@ -157,6 +165,7 @@ void RTPProxyManager::recycleState()
       if (session)
       {
         _sessionList.insert(std::pair<std::string, RTPProxySession::Ptr>(session->getIdentifier(), session));
+        rtp_sessions().set(_sessionList.size());
       }
       _sessionListMutex.unlock();
     }
@@ -268,6 +277,7 @@ void RTPProxyManager::handleSDP(
         proxy->setResizerSamples(rtpAttribute.resizerSamplesLeg1, rtpAttribute.resizerSamplesLeg2);
       }
       _sessionList.insert(std::pair<std::string, RTPProxySession::Ptr>(sessionId, proxy));
+      rtp_sessions().set(_sessionList.size());
     }
     _sessionListMutex.unlock();
   }
@@ -465,6 +475,7 @@ void RTPProxyManager::removeSession(const std::string& sessionId)
       if (!proxy->getMonitoredRoute().empty())
         decrementSessionCount(proxy->getMonitoredRoute());
       _sessionList.erase(proxyIter);
+      rtp_sessions().set(_sessionList.size());
     }
   }
   _sessionListMutex.unlock();
@@ -508,6 +519,7 @@ void RTPProxyManager::collectInactiveSessions()
       ++iter;
     }
   }
+  rtp_sessions().set(_sessionList.size());
   _sessionListMutex.unlock();
 }
 
@@ -19,6 +19,8 @@
 
 #include "OSS/RTP/RTPProxySession.h"
 #include "OSS/SDP/SDPSession.h"
+#include "OSS/SDP/SDPParser.h"
+#include "OSS/SDP/SDPRewriter.h"
 #include "OSS/Net/IPAddress.h"
 #include "OSS/UTL/Logger.h"
 #include "OSS/Persistent/ClassType.h"
@@ -157,15 +159,21 @@ void RTPProxySession::handleSDP(
     // Force RTP proxy if this session is configured with resizing
     //
     rtpAttribute.forceCreate = true;
-    OSS::SDP::SDPSession sdpSession(sdp.c_str());
+    OSS::SDP::SDPParser parser(sdp);
+    if (!parser.isValid())
+    {
+      throw SDPException("Unable to parse SDP offer.");
+    }
+    OSS::SDP::SDPRewriter rewriter(parser);
     //
     // Remove the ptime attribute for audio
     //
-    SDPMedia::Ptr audio = sdpSession.getMedia(SDPMedia::TYPE_AUDIO);
+    const SDPParser::Media* audio = parser.getMedia(SDPMedia::TYPE_AUDIO);
     if (audio)
     {
-      audio->removePtime();
-      sdp = sdpSession.toString();
+      rewriter.removePtime(*audio);
+      if (rewriter.hasPatches())
+        sdp = rewriter.apply();
     }
   }
   
@@ -488,7 +496,16 @@ void RTPProxySession::handleInitialSDPOffer(
   bool forceCreateProxy = rtpAttribute.forceCreate || rtpAttribute.forcePEAEncryption;
 
   _isExpectingInitialAnswer = true;
-  SDPSession offer(sdp.c_str());
+  //
+  // Index the offer in place and patch the addresses and ports over the
+  // original body instead of re-serializing every line through SDPSession
+  //
+  SDPParser offer(sdp);
+  if (!offer.isValid())
+  {
+    throw SDPException("Unable to parse SDP offer.");
+  }
+  SDPRewriter rewriter(offer);
   std::string sessionAddress = offer.getAddress();
   bool isBlackhole = (sessionAddress == "0.0.0.0");
   bool hasSessionAddress = (!sessionAddress.empty());
@@ -514,10 +531,10 @@ void RTPProxySession::handleInitialSDPOffer(
   //
   // Process audio session
   //
-  SDPMedia::Ptr audio = offer.getMedia(SDPMedia::TYPE_AUDIO);
+  const SDPParser::Media* audio = offer.getMedia(SDPMedia::TYPE_AUDIO);
   if (audio)
   {
-    std::string address = audio->getAddress();
+    std::string address = offer.getAddress(*audio);
     OSS::Net::IPAddress mediaAddress;
     bool hasMediaLevelAddress = !address.empty();
     if (hasMediaLevelAddress)
@@ -553,8 +570,8 @@ void RTPProxySession::handleInitialSDPOffer(
       OSS::Net::IPAddress leg2ControlListener = routeLocalInterface;
       if (_audio.open(leg1DataListener, leg2DataListener, leg1ControlListener, leg2ControlListener))
       {
-        unsigned short dataPort = audio->getDataPort();
-        unsigned short controlPort = audio->getControlPort();
+        unsigned short dataPort = offer.getDataPort(*audio);
+        unsigned short controlPort = offer.getControlPort(*audio);
 
         _audio.data().isLeg1XOREncrypted() = rtpAttribute.forcePEAEncryption;
         _audio.control().isLeg1XOREncrypted() = rtpAttribute.forcePEAEncryption;
@@ -580,9 +597,9 @@ void RTPProxySession::handleInitialSDPOffer(
           if (!hasChangedSessionAddress && !isBlackhole)
           {
             if (dataAddress.externalAddress().empty())
-              offer.changeAddress(dataAddress.toString(), "IP4");
+              rewriter.changeAddress(dataAddress.toString(), "IP4");
             else
-              offer.changeAddress(dataAddress.externalAddress(), "IP4");
+              rewriter.changeAddress(dataAddress.externalAddress(), "IP4");
 
             hasChangedSessionAddress = true;
           }
@@ -590,26 +607,26 @@ void RTPProxySession::handleInitialSDPOffer(
           if (hasMediaLevelAddress)
           {
             if (dataAddress.externalAddress().empty())
-              audio->setAddressV4(dataAddress.toString());
+              rewriter.setAddressV4(*audio, dataAddress.toString());
             else
-              audio->setAddressV4(dataAddress.externalAddress());
+              rewriter.setAddressV4(*audio, dataAddress.externalAddress());
           }
         }
         else
         {
           if (dataAddress.externalAddress().empty())
-            audio->setAddressV4(dataAddress.toString());
+            rewriter.setAddressV4(*audio, dataAddress.toString());
           else
-            audio->setAddressV4(dataAddress.externalAddress());
+            rewriter.setAddressV4(*audio, dataAddress.externalAddress());
         }
 
         if (!isBlackhole)
         {
-          audio->setDataPort(dataAddress.getPort());
+          rewriter.setDataPort(*audio, dataAddress.getPort());
           
           if (controlAddress.getPort() != dataAddress.getPort() + 1)
           {
-            audio->setControlPort(controlAddress.getPort());
+            rewriter.setControlPort(*audio, controlAddress.getPort());
           }
         }
         _hasOfferedAudioProxy = true;
@@ -619,10 +636,10 @@ void RTPProxySession::handleInitialSDPOffer(
   //
   // Process video session
   //
-  SDPMedia::Ptr video = offer.getMedia(SDPMedia::TYPE_VIDEO);
+  const SDPParser::Media* video = offer.getMedia(SDPMedia::TYPE_VIDEO);
   if (video)
   {
-    std::string address = video->getAddress();
+    std::string address = offer.getAddress(*video);
     OSS::Net::IPAddress mediaAddress;
     bool hasMediaLevelAddress = !address.empty();
     if (hasMediaLevelAddress)
@@ -658,8 +675,8 @@ void RTPProxySession::handleInitialSDPOffer(
       OSS::Net::IPAddress leg2ControlListener = routeLocalInterface;
       if (_video.open(leg1DataListener, leg2DataListener, leg1ControlListener, leg2ControlListener))
       {
-        unsigned short dataPort = video->getDataPort();
-        unsigned short controlPort = video->getControlPort();
+        unsigned short dataPort = offer.getDataPort(*video);
+        unsigned short controlPort = offer.getControlPort(*video);
 
         _video.data().isLeg1XOREncrypted() = rtpAttribute.forcePEAEncryption;
         _video.control().isLeg1XOREncrypted() = rtpAttribute.forcePEAEncryption;
@@ -686,9 +703,9 @@ void RTPProxySession::handleInitialSDPOffer(
           if (!hasChangedSessionAddress && !isBlackhole)
           {
             if (dataAddress.externalAddress().empty())
-              offer.changeAddress(dataAddress.toString(), "IP4");
+              rewriter.changeAddress(dataAddress.toString(), "IP4");
             else
-              offer.changeAddress(dataAddress.externalAddress(), "IP4");
+              rewriter.changeAddress(dataAddress.externalAddress(), "IP4");
 
             hasChangedSessionAddress = true;
           }
@@ -696,25 +713,25 @@ void RTPProxySession::handleInitialSDPOffer(
           if (hasMediaLevelAddress)
           {
             if (dataAddress.externalAddress().empty())
-              video->setAddressV4(dataAddress.toString());
+              rewriter.setAddressV4(*video, dataAddress.toString());
             else
-              video->setAddressV4(dataAddress.externalAddress());
+              rewriter.setAddressV4(*video, dataAddress.externalAddress());
           }
         }
         else
         {
           if (dataAddress.externalAddress().empty())
-            video->setAddressV4(dataAddress.toString());
+            rewriter.setAddressV4(*video, dataAddress.toString());
           else
-            video->setAddressV4(dataAddress.externalAddress());
+            rewriter.setAddressV4(*video, dataAddress.externalAddress());
         }
 
         if (!isBlackhole)
         {
-          video->setDataPort(dataAddress.getPort());
+          rewriter.setDataPort(*video, dataAddress.getPort());
           if (controlAddress.getPort() != dataAddress.getPort() + 1)
           {
-            video->setControlPort(controlAddress.getPort());
+            rewriter.setControlPort(*video, controlAddress.getPort());
           }
         }
 
@@ -725,10 +742,10 @@ void RTPProxySession::handleInitialSDPOffer(
   //
   // Process video session
   //
-  SDPMedia::Ptr fax = offer.getMedia(SDPMedia::TYPE_FAX);
+  const SDPParser::Media* fax = offer.getMedia(SDPMedia::TYPE_FAX);
   if (fax)
   {
-    std::string address = fax->getAddress();
+    std::string address = offer.getAddress(*fax);
     OSS::Net::IPAddress mediaAddress;
     bool hasMediaLevelAddress = !address.empty();
     if (hasMediaLevelAddress)
@@ -764,8 +781,8 @@ void RTPProxySession::handleInitialSDPOffer(
       OSS::Net::IPAddress leg2ControlListener = routeLocalInterface;
       if (_fax.open(leg1DataListener, leg2DataListener, leg1ControlListener, leg2ControlListener))
       {
-        unsigned short dataPort = fax->getDataPort();
-        unsigned short controlPort = fax->getControlPort();
+        unsigned short dataPort = offer.getDataPort(*fax);
+        unsigned short controlPort = offer.getControlPort(*fax);
 
         _fax.data().isLeg1XOREncrypted() = rtpAttribute.forcePEAEncryption;
         _fax.control().isLeg1XOREncrypted() = rtpAttribute.forcePEAEncryption;
@@ -792,9 +809,9 @@ void RTPProxySession::handleInitialSDPOffer(
           if (!hasChangedSessionAddress && !isBlackhole)
           {
             if (dataAddress.externalAddress().empty())
-              offer.changeAddress(dataAddress.toString(), "IP4");
+              rewriter.changeAddress(dataAddress.toString(), "IP4");
             else
-              offer.changeAddress(dataAddress.externalAddress(), "IP4");
+              rewriter.changeAddress(dataAddress.externalAddress(), "IP4");
 
             hasChangedSessionAddress = true;
           }
@@ -802,26 +819,26 @@ void RTPProxySession::handleInitialSDPOffer(
           if (hasMediaLevelAddress)
           {
             if (dataAddress.externalAddress().empty())
-              fax->setAddressV4(dataAddress.toString());
+              rewriter.setAddressV4(*fax, dataAddress.toString());
             else
-              fax->setAddressV4(dataAddress.externalAddress());
+              rewriter.setAddressV4(*fax, dataAddress.externalAddress());
           }
         }
         else
         {
           if (dataAddress.externalAddress().empty())
-            fax->setAddressV4(dataAddress.toString());
+            rewriter.setAddressV4(*fax, dataAddress.toString());
           else
-            fax->setAddressV4(dataAddress.externalAddress());
+            rewriter.setAddressV4(*fax, dataAddress.externalAddress());
         }
 
         if (!isBlackhole)
         {
-          fax->setDataPort(dataAddress.getPort());
+          rewriter.setDataPort(*fax, dataAddress.getPort());
           
           if (controlAddress.getPort() != dataAddress.getPort() + 1)
           {
-            fax->setControlPort(controlAddress.getPort());
+            rewriter.setControlPort(*fax, controlAddress.getPort());
           }
         }
 
@@ -833,7 +850,7 @@ void RTPProxySession::handleInitialSDPOffer(
 
   if (_hasOfferedAudioProxy || _hasOfferedVideoProxy || _hasOfferedFaxProxy)
   {
-    sdp = offer.toString();
+    sdp = rewriter.apply();
   }
 
 }
@@ -33,7 +33,8 @@ namespace SBC {
   
   
 SBCAccounts::SBCAccounts() :
-  _hasDeterminedRealms(false)
+  _hasDeterminedRealms(false),
+  _cacheTtl(DEFAULT_CACHE_TTL_MS)
 {
 }
   
@@ -44,6 +45,7 @@ SBCAccounts::~SBCAccounts()
 void SBCAccounts::initialize(const SBCWorkSpaceManager::WorkSpace& workspace)
 {
   _workspace = workspace;
+  invalidateAll();
   determineRealms();
 }
 
@@ -58,7 +60,7 @@ void SBCAccounts::determineRealms()
   }
    
   std::vector<std::string> identities;
-  if(_workspace->getKeys("*", identities))
+  if(_workspace->getKeysWithPrefix("", identities))
   {
     _hasDeterminedRealms = true;
   }
@@ -99,12 +101,41 @@ bool SBCAccounts::findAccount(const std::string& identity, SBCAccountRecord& acc
     }
   }
   
+  OSS::UInt64 now = _cacheTtl ? OSS::getTime() : 0;
+  if (_cacheTtl)
+  {
+    OSS::mutex_read_lock lock(_cacheMutex);
+    AccountCache::const_iterator iter = _cache.find(identity);
+    if (iter != _cache.end() && iter->second.expires > now)
+    {
+      account = iter->second.record;
+      return true;
+    }
+  }
+  
   if (!_workspace || !account.readFromWorkSpace(_workspace, identity))
   {
     return false;
   }
   
-  return account.isValid();
+  if (!account.isValid())
+  {
+    return false;
+  }
+  
+  if (_cacheTtl)
+  {
+    OSS::mutex_write_lock lock(_cacheMutex);
+    if (_cache.size() >= MAX_CACHED_ACCOUNTS)
+    {
+      _cache.clear();
+    }
+    CachedAccount& cached = _cache[identity];
+    cached.record = account;
+    cached.expires = now + _cacheTtl;
+  }
+  
+  return true;
 }
 
 bool SBCAccounts::addAccount(SBCAccountRecord& account)
@@ -126,6 +157,7 @@ bool SBCAccounts::addAccount(SBCAccountRecord& account)
     OSS_LOG_ERROR("SBCAccounts::addAccount - Unable to store account to workspace");
     return false;
   }
+  invalidate(account.getIdentity());
   OSS::mutex_critic_sec_lock lock(_volatileAccountsMutex);
   _realms.insert(account.getRealm());
   return true;
@@ -148,6 +180,33 @@ void SBCAccounts::addRealm(const std::string& realm)
   OSS::mutex_critic_sec_lock lock(_volatileAccountsMutex);
   _realms.insert(realm);
 }
+
+void SBCAccounts::invalidate(const std::string& identity)
+{
+  OSS::mutex_write_lock lock(_cacheMutex);
+  _cache.erase(identity);
+}
+
+void SBCAccounts::invalidateAll()
+{
+  OSS::mutex_write_lock lock(_cacheMutex);
+  _cache.clear();
+}
+
+void SBCAccounts::setCacheTtl(unsigned int cacheTtl)
+{
+  _cacheTtl = cacheTtl;
+  if (!cacheTtl)
+  {
+    invalidateAll();
+  }
+}
+
+std::size_t SBCAccounts::getCacheSize() const
+{
+  OSS::mutex_read_lock lock(_cacheMutex);
+  return _cache.size();
+}
   
 
 } } }  // OSS::SIP::SBC
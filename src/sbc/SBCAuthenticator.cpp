@@ -24,6 +24,7 @@
 
 #include "OSS/SIP/SBC/SBCAuthenticator.h"
 #include "OSS/SIP/SIPFrom.h"
+#include "OSS/SIP/SIPParser.h"
 #include "OSS/UTL/PropertyMap.h"
 
 
@@ -34,7 +35,9 @@ namespace SBC {
 static const std::string WEB_RTC_DEMO_DOMAIN = "demo.webrtc.local";
   
   
-SBCAuthenticator::SBCAuthenticator()
+SBCAuthenticator::SBCAuthenticator() :
+  _nonceLifetime(SIPDigestAuth::DEFAULT_NONCE_LIFETIME),
+  _nonceCounts(SIPDigestAuth::DEFAULT_NONCE_LIFETIME)
 {
   _accounts.addRealm(WEB_RTC_DEMO_DOMAIN);
 }
@@ -83,7 +86,8 @@ SIPMessage::Ptr SBCAuthenticator::onAuthenticateTransaction(
   //
   // There is a local account configured.  Check if it is authenticated.
   //
-  if (!isAuthorized(pRequest, account))
+  bool stale = false;
+  if (!isAuthorized(pRequest, account, &stale))
   {
     SIPMessage::Ptr pChallengeResponse = pRequest->createResponse(pRequest->isRequest("REGISTER") ?
       SIPMessage::CODE_401_Unauthorized :
@@ -94,12 +98,23 @@ SIPMessage::Ptr SBCAuthenticator::onAuthenticateTransaction(
     //
     std::string forceNonce;
     pRequest->getProperty("force-nonce", forceNonce);
+    if (forceNonce.empty())
+    {
+      //
+      // Timed nonces are verified without keeping track of the ones issued
+      //
+      forceNonce = SIPDigestAuth::digestCreateTimedNonce(account.getRealm());
+    }
 
     //
     // Compute the response
     //
     SIPAuthorization challenge;
     account.computeAuthenticateChallengeHeader(pRequest->hdrGet(OSS::SIP::HDR_CALL_ID), forceNonce, challenge);
+    if (stale)
+    {
+      challenge.setAuthParam("stale", "true");
+    }
        
     if (pRequest->isRequest("REGISTER"))
     {
@@ -128,8 +143,13 @@ SIPMessage::Ptr SBCAuthenticator::onAuthenticateTransaction(
   return SIPMessage::Ptr();
 }
 
-bool SBCAuthenticator::isAuthorized(const SIPMessage::Ptr& pRequest, const SBCAccountRecord& record)
+bool SBCAuthenticator::isAuthorized(const SIPMessage::Ptr& pRequest, const SBCAccountRecord& record, bool* pStale)
 {
+  if (pStale)
+  {
+    *pStale = false;
+  }
+  
   std::string authorizationHeader;
   
   //
@@ -188,6 +208,26 @@ bool SBCAuthenticator::isAuthorized(const SIPMessage::Ptr& pRequest, const SBCAc
     return false;
   }
   
+  //
+  // Reject nonces we did not issue before spending any hashing on them
+  //
+  std::string nonce = authorizationResponse.getNonce();
+  SIPParser::unquoteString(nonce);
+  std::string forceNonce;
+  pRequest->getProperty("force-nonce", forceNonce);
+  bool expired = false;
+  if (!forceNonce.empty())
+  {
+    if (nonce != forceNonce)
+    {
+      return false;
+    }
+  }
+  else if (!SIPDigestAuth::digestVerifyTimedNonce(nonce, record.getRealm(), _nonceLifetime, &expired) && !expired)
+  {
+    return false;
+  }
+  
   //
   // Create the A2 hash
   //
@@ -197,15 +237,15 @@ bool SBCAuthenticator::isAuthorized(const SIPMessage::Ptr& pRequest, const SBCAc
   //
   // Compute the response
   //
-  std::string nonce = authorizationResponse.getNonce();
   std::string digestResponse;
+  std::string nonceCount;
   if (qop.empty())
   {
     digestResponse = SIPDigestAuth::digestCreateAuthorization(record.getA1Hash(), nonce, a2Hash);
   }
   else
   {
-    std::string nonceCount(authorizationResponse.getNonceCount());
+    nonceCount = authorizationResponse.getNonceCount();
     std::string cnonce(authorizationResponse.getCNonce());
     digestResponse = SIPDigestAuth::digestCreateAuthorizationQop(
       record.getA1Hash(),
@@ -216,7 +256,39 @@ bool SBCAuthenticator::isAuthorized(const SIPMessage::Ptr& pRequest, const SBCAc
       a2Hash);
   }
   
-  return  digestResponse == authorizationResponse.getDigestResponse();
+  if (digestResponse != authorizationResponse.getDigestResponse())
+  {
+    return false;
+  }
+  
+  //
+  // Only a client that knows the password is told its nonce went stale.
+  // Anyone else is challenged again as if the nonce was never valid.
+  //
+  if (expired)
+  {
+    if (pStale)
+    {
+      *pStale = true;
+    }
+    return false;
+  }
+  
+  //
+  // A valid response can still be a replay.  With qop=auth the client
+  // increments nc for every request using the same nonce.
+  //
+  if (!nonceCount.empty())
+  {
+    OSS::UInt32 nc = strtoul(nonceCount.c_str(), 0, 16);
+    if (!_nonceCounts.accept(nonce, record.getUser(), nc))
+    {
+      OSS_LOG_WARNING(pRequest->createContextId(true) << "SBCAuthenticator::isAuthorized - Rejecting replayed nonce-count " << nonceCount << " for " << record.getIdentity());
+      return false;
+    }
+  }
+  
+  return true;
 }
 
 
@@ -32,6 +32,7 @@
 #include "OSS/UTL/Logger.h"
 #include "OSS/SIP/SBC/SBCManager.h"
 #include "OSS/SIP/SBC/SBCDirectories.h"
+#include "OSS/Metrics/MetricsRegistry.h"
 
 
 namespace OSS {
@@ -55,18 +56,22 @@ static void flush_stale_records(SBCCDRManager* pManager, bool force = false)
   if (force || now - lastFlushTime > 600000)
   {
     lastFlushTime = now;
-    std::vector<std::string> keys;
-    pManager->cdr()->getKeys("*", keys);
-    for (std::vector<std::string>::iterator iter = keys.begin(); iter != keys.end(); iter++)
+    SBCWorkSpace::Cursor cursor(*(pManager->cdr()), "");
+    SBCWorkSpace::Records records;
+    while (cursor.next(records))
     {
-      SBCCDRRecord cdr;
-      if (cdr.readFromWorkSpace(*(pManager->cdr()), *iter))
+      for (SBCWorkSpace::Records::iterator iter = records.begin(); iter != records.end(); iter++)
       {
-        if (!cdr.connectTime() && cdr.setupTime() + 300000 < now)
+        SBCCDRRecord cdr;
+        if (cdr.readFromJson(iter->second))
         {
-          pManager->cdr()->del(*iter);
+          if (!cdr.connectTime() && cdr.setupTime() + 300000 < now)
+          {
+            pManager->cdr()->del(iter->first);
+          }
         }
       }
+      records.clear();
     }
   }
 }
@@ -76,20 +81,14 @@ static void flush_record(SBCCDRManager* pManager, const std::string& sessionId,
   //
   // Delete the old record and save it as a new key with the date
   //
-  pManager->cdr()->del(sessionId);
-  cdr.writeToLogFile(pManager->logger());
- 
-  
-  //
-  // Flush stale records
-  //
-  flush_stale_records(pManager);
+  pManager->deleteRecord(sessionId);
+  pManager->logRecord(cdr);
 }
 
 static void on_handle_final(SBCCDRManager* pManager, SBCCDREvent* pEvent)
 {
   SBCCDRRecord cdr;
-  if (!cdr.readFromWorkSpace(*(pManager->cdr()), pEvent->getSessionId()))
+  if (!pManager->readRecord(pEvent->getSessionId(), cdr))
   {
     return;
   }
@@ -102,7 +101,7 @@ static void on_handle_final(SBCCDRManager* pManager, SBCCDREvent* pEvent)
     // Check if this is a challenge response.
     // Delete it if it is
     //
-    pManager->cdr()->del(pEvent->getSessionId());
+    pManager->deleteRecord(pEvent->getSessionId());
 
     //
     // Remove it from the active channels
@@ -128,7 +127,7 @@ static void on_handle_final(SBCCDRManager* pManager, SBCCDREvent* pEvent)
     SIP::ContactURI calledUri;
     hContact.getAt(calledUri, 0);
     cdr.calledContact() = calledUri.data();
-    cdr.writeToWorkSpace(*(pManager->cdr()), pEvent->getSessionId(), pManager->getCDRLifeTime());
+    pManager->writeRecord(pEvent->getSessionId(), cdr);
     
     OSS_LOG_INFO(pEvent->getRequest()->createContextId(true) << "SBCCDRManager::onHandleEvent::on_handle_final CONNECTED" 
       << " connectTime: " <<  cdr.connectTime());
@@ -172,7 +171,7 @@ static void on_handle_transferred(SBCCDRManager* pManager, SBCCDREvent* pEvent)
 static void on_handle_terminated(SBCCDRManager* pManager, SBCCDREvent* pEvent)
 {
   SBCCDRRecord cdr;
-  if (!cdr.readFromWorkSpace(*(pManager->cdr()), pEvent->getSessionId()))
+  if (!pManager->readRecord(pEvent->getSessionId(), cdr))
   {
     OSS_LOG_INFO(pEvent->getRequest()->createContextId(true) << "SBCCDRManager::onHandleEvent::on_handle_terminated " 
       << "Session-ID: " << pEvent->getSessionId() << " not found"); 
@@ -215,6 +214,8 @@ static void on_handle_terminated(SBCCDRManager* pManager, SBCCDREvent* pEvent)
 
    
 SBCCDRManager::SBCCDRManager() :
+  _batchSize(DEFAULT_BATCH_SIZE),
+  _batchInterval(DEFAULT_BATCH_INTERVAL),
   _pEventQueueThread(0),
   _pWorkSpaceManager(0),
   _cdrLifeTime(DEFAULT_CDR_LIFETIME),
@@ -226,12 +227,17 @@ SBCCDRManager::~SBCCDRManager()
 {
   if (_pEventQueueThread)
   {
-    SBCCDREvent* pExit = new SBCCDREvent();
+    SBCCDREvent* pExit = acquireEvent();
     pExit->setType(SBCCDREvent::EVENT_EXIT_QUEUE);
     _eventQueue.enqueue(pExit);
     _pEventQueueThread->join();
     delete _pEventQueueThread;
   }
+  
+  for (std::vector<SBCCDREvent*>::iterator iter = _eventPool.begin(); iter != _eventPool.end(); iter++)
+  {
+    delete *iter;
+  }
 }
   
 void SBCCDRManager::initialize(SBCManager* pSBCManager)
@@ -367,47 +373,195 @@ std::size_t SBCCDRManager::onCallSetup(
   return callCount;
 }
 
+SBCCDREvent* SBCCDRManager::acquireEvent()
+{
+  {
+    OSS::mutex_critic_sec_lock lock(_eventPoolMutex);
+    if (!_eventPool.empty())
+    {
+      SBCCDREvent* pEvent = _eventPool.back();
+      _eventPool.pop_back();
+      return pEvent;
+    }
+  }
+  return new SBCCDREvent();
+}
+
+void SBCCDRManager::releaseEvent(SBCCDREvent* pEvent)
+{
+  pEvent->clear();
+  {
+    OSS::mutex_critic_sec_lock lock(_eventPoolMutex);
+    if (_eventPool.size() < MAX_POOLED_EVENTS)
+    {
+      _eventPool.push_back(pEvent);
+      return;
+    }
+  }
+  delete pEvent;
+}
+
+void SBCCDRManager::enqueueEvent(
+  const SIPMessage::Ptr& pRequest,
+  const SIPTransaction::Ptr& pTransaction,
+  SBCCDREvent::Type type
+)
+{
+  static OSS::Metrics::Gauge& queued = OSS::Metrics::MetricsRegistry::instance().gauge("sbc.cdr.queue");
+  SBCCDREvent* pEvent = acquireEvent();
+  pEvent->reset(pRequest, pTransaction, type);
+  pEvent->setEnqueueTime(OSS::Metrics::Histogram::now());
+  if (!_eventQueue.enqueue(pEvent))
+  {
+    OSS_LOG_ERROR("SBCCDRManager::enqueueEvent - CDR queue is full.  Dropping event for Session-ID: " << pEvent->getSessionId());
+    releaseEvent(pEvent);
+    return;
+  }
+  queued.increment();
+}
+
+bool SBCCDRManager::readRecord(const std::string& sessionId, SBCCDRRecord& cdr)
+{
+  PendingRecords::iterator iter = _pending.find(sessionId);
+  if (iter != _pending.end())
+  {
+    if (iter->second.deleted)
+    {
+      return false;
+    }
+    cdr = iter->second.record;
+    return true;
+  }
+  return cdr.readFromWorkSpace(*_pCDRDb, sessionId);
+}
+
+void SBCCDRManager::writeRecord(const std::string& sessionId, SBCCDRRecord& cdr)
+{
+  PendingRecord& pending = _pending[sessionId];
+  pending.record = cdr;
+  pending.deleted = false;
+  cdr.writeToBatch(_batch, sessionId);
+}
+
+void SBCCDRManager::deleteRecord(const std::string& sessionId)
+{
+  PendingRecord& pending = _pending[sessionId];
+  pending.record = SBCCDRRecord();
+  pending.deleted = true;
+  _batch.del(sessionId);
+}
+
+void SBCCDRManager::logRecord(SBCCDRRecord& cdr)
+{
+  if (!_logBuffer.empty())
+  {
+    _logBuffer.push_back('\n');
+  }
+  cdr.toLogLine(_logBuffer);
+}
+
+void SBCCDRManager::commitBatch()
+{
+  static OSS::Metrics::Histogram& commitTime = OSS::Metrics::MetricsRegistry::instance().histogram("sbc.cdr.commit.us");
+  OSS::Metrics::ScopedTimer timer(commitTime);
+  
+  if (!_batch.empty())
+  {
+    if (!_pCDRDb->write(_batch))
+    {
+      OSS_LOG_ERROR("SBCCDRManager::commitBatch - Unable to write " << _batch.size() << " CDR workspace updates");
+    }
+    _batch.clear();
+  }
+  _pending.clear();
+  
+  //
+  // The log file pattern is the bare message so the lines of the batch
+  // land in cdr.csv as a single append
+  //
+  if (!_logBuffer.empty())
+  {
+    _logger.notice(_logBuffer);
+    _logBuffer.clear();
+  }
+  
+  flush_stale_records(this);
+}
+
 void SBCCDRManager::onHandleEvent()
 {
+  static OSS::Metrics::Gauge& queued = OSS::Metrics::MetricsRegistry::instance().gauge("sbc.cdr.queue");
+  static OSS::Metrics::Histogram& lag = OSS::Metrics::MetricsRegistry::instance().histogram("sbc.cdr.lag.us");
+  static OSS::Metrics::Histogram& batchSize = OSS::Metrics::MetricsRegistry::instance().histogram("sbc.cdr.batch");
+  
+  std::vector<SBCCDREvent*> events;
+  events.reserve(_batchSize);
   bool terminated = false;
   while (!terminated)
   {
-    SBCCDREvent* pEvent;
-    _eventQueue.dequeue(pEvent);
-    OSS_ASSERT(pEvent);
-    
-    if (pEvent->getSessionId().empty())
+    //
+    // Block for the first event then collect whatever arrives until the
+    // batch is full or the batch interval elapses
+    //
+    _eventQueue.dequeueBatch(events, _batchSize);
+    OSS::UInt64 deadline = OSS::getTime() + _batchInterval;
+    while (events.size() < _batchSize && events.back()->getType() != SBCCDREvent::EVENT_EXIT_QUEUE)
     {
-      return;
+      OSS::UInt64 now = OSS::getTime();
+      if (now >= deadline || !_eventQueue.dequeueBatch(events, _batchSize - events.size(), deadline - now))
+      {
+        break;
+      }
     }
     
-    std::string eventName = "CallUnknown";
-    switch (pEvent->getType())
+    SBCCDREvent* pEvent = 0;
+    for (std::vector<SBCCDREvent*>::iterator iter = events.begin(); iter != events.end(); iter++)
     {
-      case SBCCDREvent::EVENT_PROGRESS:
-        eventName = "CallProgress";
-        on_handle_progress(this, pEvent);
-        break;
-      case SBCCDREvent::EVENT_FINAL:
-        eventName = "CallFinal";
-        on_handle_final(this, pEvent);
-        break;
-      case SBCCDREvent::EVENT_TRANSFERRED:
-        eventName = "CallTransferred";
-        on_handle_transferred(this, pEvent);
-        break;
-      case SBCCDREvent::EVENT_TERMINATED:
-        on_handle_terminated(this, pEvent);
-        eventName = "CallTerminated";
-        break;
-      case SBCCDREvent::EVENT_EXIT_QUEUE:
+      pEvent = *iter;
+      if (pEvent->getType() == SBCCDREvent::EVENT_EXIT_QUEUE)
+      {
         terminated = true;
-        break;
-      case SBCCDREvent::EVENT_UNKNOWN:
-        break;
+        continue;
+      }
+      
+      if (pEvent->getSessionId().empty())
+      {
+        continue;
+      }
+      
+      switch (pEvent->getType())
+      {
+        case SBCCDREvent::EVENT_PROGRESS:
+          on_handle_progress(this, pEvent);
+          break;
+        case SBCCDREvent::EVENT_FINAL:
+          on_handle_final(this, pEvent);
+          break;
+        case SBCCDREvent::EVENT_TRANSFERRED:
+          on_handle_transferred(this, pEvent);
+          break;
+        case SBCCDREvent::EVENT_TERMINATED:
+          on_handle_terminated(this, pEvent);
+          break;
+        default:
+          break;
+      }
     }
-
-    delete pEvent;
+    
+    commitBatch();
+    
+    OSS::UInt64 now = OSS::Metrics::Histogram::now();
+    batchSize.record(events.size());
+    for (std::vector<SBCCDREvent*>::iterator iter = events.begin(); iter != events.end(); iter++)
+    {
+      if ((*iter)->getEnqueueTime())
+      {
+        lag.record(now - (*iter)->getEnqueueTime());
+        queued.decrement();
+      }
+      releaseEvent(*iter);
+    }
+    events.clear();
   }
 }
 
@@ -189,8 +189,15 @@ bool SBCCDRRecord::writeToWorkSpace(SBCWorkSpace& ws, const std::string& key, un
   return ws.set(key, params, expire);
 }
 
-bool SBCCDRRecord::writeToLogFile(OSS::UTL::LogFile& logFile)
-{  
+void SBCCDRRecord::writeToBatch(SBCWorkSpace::Batch& batch, const std::string& key)
+{
+  json::Object params;
+  toJson(params);
+  batch.set(key, params);
+}
+
+void SBCCDRRecord::toLogLine(std::string& line)
+{
   std::ostringstream strm;
   strm << _date << ", ";
   strm << _srcAddress << ", ";
@@ -204,8 +211,14 @@ bool SBCCDRRecord::writeToLogFile(OSS::UTL::LogFile& logFile)
   strm << _setupTime << ", ";
   strm << _connectTime << ", ";
   strm << _disconnectTime;
-  
-  logFile.notice(strm.str());
+  line.append(strm.str());
+}
+
+bool SBCCDRRecord::writeToLogFile(OSS::UTL::LogFile& logFile)
+{  
+  std::string line;
+  toLogLine(line);
+  logFile.notice(line);
   
   return true;
 }
@@ -215,7 +228,19 @@ bool SBCCDRRecord::readFromWorkSpace(SBCWorkSpace& workspace, const std::string&
   json::Object response;
   if (!workspace.get(key, response))
     return false;
-  
+  return readFromJson(response);
+}
+
+bool SBCCDRRecord::readFromJson(const std::string& value)
+{
+  json::Object response;
+  if (!OSS::JSON::json_parse_string(value, response))
+    return false;
+  return readFromJson(response);
+}
+
+bool SBCCDRRecord::readFromJson(json::Object& response)
+{
   json::Object::iterator date = response.Find("date");
   if (date != response.End())
   {
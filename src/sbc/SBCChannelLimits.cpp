@@ -30,6 +30,7 @@
 #include "OSS/JSON/reader.h"
 #include "OSS/JSON/writer.h"
 #include "OSS/SIP/SBC/SBCConfiguration.h"
+#include <boost/functional/hash.hpp>
 
 
 namespace OSS {
@@ -38,17 +39,23 @@ namespace SBC {
   
   
   
-static const Poco::Timestamp::TimeDiff DEFAULT_CACHE_EXPIRE = 60*60*1000;  /// 1 hour lifetime
+static const OSS::UInt64 DEFAULT_CACHE_EXPIRE = 60*60*1000;  /// 1 hour lifetime
+static const OSS::UInt64 EXPIRE_CHECK_INTERVAL = 60*1000;
 static const char* CHANNEL_COUNT_PREFIX = "sbc.channel-count-";
-static const char* CHANNEL_COUNT_PREFIX_WILD_CARD = "sbc.channel-count-*";
 
 
 using OSS::Persistent::ClassType;
 using OSS::Persistent::DataType;
 
+
+SBCChannelLimits::SessionShard::SessionShard() :
+  nextExpireCheck(0)
+{
+}
+
   
 SBCChannelLimits::SBCChannelLimits() :
-  _shortestPrefix(0),
+  _trie(new SBCDialPrefixTrie()),
   _cacheExpire(DEFAULT_CACHE_EXPIRE),
   _pManager(0)
 {
@@ -72,13 +79,9 @@ void SBCChannelLimits::initialize(SBCManager* pSBCManager)
     //
     // Clear out the previous channel count
     //
-    std::vector<std::string> keys;
-    _systemDb->getKeys(CHANNEL_COUNT_PREFIX_WILD_CARD, keys);
-    for (std::vector<std::string>::iterator iter = keys.begin(); iter != keys.end(); iter++)
-    {
-      _systemDb->del(*iter);
-    }
+    _systemDb->delKeysWithPrefix(CHANNEL_COUNT_PREFIX);
     
+    Limits prefixes;
     try
     {
         OSS::JSON::Array limits = userAgent["channel_limits"];
@@ -94,7 +97,7 @@ void SBCChannelLimits::initialize(SBCManager* pSBCManager)
             {
               OSS::JSON::String prefix = dbInfo["prefix"];
               OSS::JSON::Number maxChannels = dbInfo["max_channels"];
-              registerDialPrefix(prefix.Value(), maxChannels.Value());
+              prefixes[prefix.Value()] = maxChannels.Value();
             }
           }
         }
@@ -102,150 +105,208 @@ void SBCChannelLimits::initialize(SBCManager* pSBCManager)
     catch(...)
     {
     }
+    
+    loadDialPrefixes(prefixes);
   }
 }
- 
-void SBCChannelLimits::registerDialPrefix(const std::string& prefix_, std::size_t channelLimit)
+
+SBCChannelLimits::CounterPtr SBCChannelLimits::registerDialPrefix(
+  SBCDialPrefixTrie& trie, 
+  const SBCDialPrefixTrie& previous, 
+  const std::string& prefix_, 
+  std::size_t channelLimit)
 {
-  OSS::mutex_critic_sec_lock lock(_prefixesMutex);
-  
-  std::string prefix = prefix_;
   std::vector<std::string> tokens;
-  tokens = OSS::string_tokenize(prefix, ",");
+  tokens = OSS::string_tokenize(prefix_, ",");
+  if (tokens.empty())
+  {
+    return CounterPtr();
+  }
   
-  if (tokens.size() > 1)
+  std::string prefix = tokens[0];
+  OSS::string_trim(prefix);
+  
+  //
+  // Reuse the counter of a prefix that is already registered so that
+  // calls in progress are still accounted for
+  //
+  CounterPtr counter = previous.find(prefix);
+  if (counter && counter->prefix == prefix)
   {
-    prefix = tokens[0];
-    
-    for (std::size_t i = 1; i < tokens.size(); i++)
+    counter->limit = channelLimit;
+    if (&previous != &trie && !trie.insert(prefix, counter))
     {
-      std::string aliasPrefix = tokens[i];
-      OSS::string_trim(aliasPrefix);
-      
-      _aliases[aliasPrefix] = prefix;
-           
-      if (!_shortestPrefix || _shortestPrefix > aliasPrefix.length())
-      {
-        _shortestPrefix = aliasPrefix.length();
-      }
+      return CounterPtr();
     }
   }
-  
-  if (!_shortestPrefix || _shortestPrefix > prefix.length())
+  else
   {
-    _shortestPrefix = prefix.length();
+    counter = CounterPtr(new Counter(prefix, channelLimit));
+    if (!trie.insert(prefix, counter))
+    {
+      OSS_LOG_WARNING("SBCChannelLimits::registerDialPrefix - Invalid prefix " << prefix);
+      return CounterPtr();
+    }
+  }
+    
+  for (std::size_t i = 1; i < tokens.size(); i++)
+  {
+    std::string aliasPrefix = tokens[i];
+    OSS::string_trim(aliasPrefix);
+    if (!trie.insert(aliasPrefix, counter))
+    {
+      OSS_LOG_WARNING("SBCChannelLimits::registerDialPrefix - Invalid alias " << aliasPrefix << " for prefix " << prefix);
+    }
   }
   
-  _prefixes[prefix] =  ExpireCachePtr(new ExpireCache(_cacheExpire));
-  _limits[prefix] = channelLimit;
+  return counter;
+}
+ 
+void SBCChannelLimits::registerDialPrefix(const std::string& prefix, std::size_t channelLimit)
+{
+  OSS::mutex_critic_sec_lock lock(_prefixesMutex);
   
   //
-  // Zero out the workspace counter
+  // Insertion into the live trie is safe.  Readers see either the old
+  // or the new mapping.
   //
-  std::ostringstream counterKey;
-  counterKey << CHANNEL_COUNT_PREFIX << prefix;
-  json::Object params;
-  params["prefix"] = json::String(prefix);
-  params["max-call-count"] = json::Number(channelLimit);
-  params["active-call-count"] = json::Number(0);
-  
-  if (_systemDb)
+  TriePtr trie = boost::atomic_load(&_trie);
+  CounterPtr counter = registerDialPrefix(*trie, *trie, prefix, channelLimit);
+  if (counter)
   {
-    _systemDb->set(counterKey.str(), params);
+    updateWorkspaceCounter(*counter, counter->count);
+    OSS_LOG_NOTICE("SBCChannelLimits::registerDialPrefix - Enforcing channel limit " << channelLimit << " for prefix " << counter->prefix);
   }
-  
-  OSS_LOG_NOTICE("SBCChannelLimits::registerDialPrefix - Enforcing channel limit " << channelLimit << " for prefix " << prefix);
 }
 
-void SBCChannelLimits::resolveAliasPrefix(const std::string& dialString, std::string& prefix)
+void SBCChannelLimits::loadDialPrefixes(const Limits& limits)
 {
   OSS::mutex_critic_sec_lock lock(_prefixesMutex);
-  std::string lowerBoundKey = OSS::string_left(dialString, _shortestPrefix);
-  std::string lastMatch;
-   
-  for (PrefixAliases::iterator iter = _aliases.lower_bound(lowerBoundKey); iter != _aliases.end(); iter++)
+  
+  TriePtr previous = boost::atomic_load(&_trie);
+  TriePtr trie(new SBCDialPrefixTrie());
+  std::vector<CounterPtr> counters;
+  counters.reserve(limits.size());
+  
+  for (Limits::const_iterator iter = limits.begin(); iter != limits.end(); iter++)
   {
-    if (OSS::string_starts_with(dialString, iter->first.c_str()))
+    CounterPtr counter = registerDialPrefix(*trie, *previous, iter->first, iter->second);
+    if (counter)
     {
-      lastMatch = iter->second;
-      break;
+      counters.push_back(counter);
     }
   }
   
-  if (!lastMatch.empty())
+  boost::atomic_store(&_trie, trie);
+  
+  for (std::vector<CounterPtr>::iterator iter = counters.begin(); iter != counters.end(); iter++)
   {
-    prefix = lastMatch;
+    updateWorkspaceCounter(**iter, (*iter)->count);
   }
+  
+  OSS_LOG_NOTICE("SBCChannelLimits::loadDialPrefixes - Enforcing channel limits for " << counters.size() << " prefixes (" << trie->nodeCount() << " trie nodes)");
 }
 
-std::size_t SBCChannelLimits::addCall(const std::string& sessionId, const std::string& dialString, std::size_t& channelLimit)
+void SBCChannelLimits::updateWorkspaceCounter(const Counter& counter, std::size_t count)
 {
-  std::string alias;
-  resolveAliasPrefix(dialString, alias);
+  if (!_systemDb)
+  {
+    return;
+  }
   
+  std::ostringstream counterKey;
+  counterKey << CHANNEL_COUNT_PREFIX << counter.prefix;
+  json::Object params;
+  params["prefix"] = json::String(counter.prefix);
+  params["max-call-count"] = json::Number(counter.limit);
+  params["active-call-count"] = json::Number(count);
+  _systemDb->set(counterKey.str(), params);
+}
+
+SBCChannelLimits::SessionShard& SBCChannelLimits::getShard(const std::string& sessionId)
+{
+  return _shards[boost::hash_value(sessionId) % SESSION_SHARDS];
+}
+
+void SBCChannelLimits::expireSessions(SessionShard& shard, OSS::UInt64 now)
+{
   //
-  // Note:  do not lock the mutex before resolveAliasPrefix() or you will deadlock)
+  // Called with the shard mutex held
   //
-  OSS::mutex_critic_sec_lock lock(_prefixesMutex);
-  std::string lowerBoundKey = OSS::string_left(dialString, _shortestPrefix);
-  std::size_t count = 0;
-  
-  std::string lastMatch;
-  
-  if (alias.empty())
+  Sessions::iterator iter = shard.sessions.begin();
+  while (iter != shard.sessions.end())
   {
-    for (ChannelMap::iterator iter = _prefixes.lower_bound(lowerBoundKey); iter != _prefixes.end(); iter++)
+    if (iter->second.expires <= now)
     {
-      if (OSS::string_starts_with(dialString, iter->first.c_str()))
-      {
-        lastMatch = iter->first;
-        break;
-      }
+      OSS_LOG_WARNING("SBCChannelLimits::expireSessions - Expiring stale session " << iter->first);
+      iter->second.counter->count.fetch_sub(1);
+      shard.sessions.erase(iter++);
+    }
+    else
+    {
+      ++iter;
     }
   }
-  else
+}
+
+std::size_t SBCChannelLimits::addCall(const std::string& sessionId, const std::string& dialString, std::size_t& channelLimit)
+{
+  CounterPtr counter = matchPrefix(dialString);
+  if (!counter)
   {
-    lastMatch = alias;
+    OSS_LOG_INFO("SBCChannelLimits::addCall - " << dialString << " did not match any registrered channel prefix");
+    return 0;
   }
   
-  if (!lastMatch.empty())
+  std::size_t count = 0;
+  CounterPtr previous;
+  OSS::UInt64 now = OSS::getTime();
+  SessionShard& shard = getShard(sessionId);
   {
-    ChannelMap::iterator iter = _prefixes.find(lastMatch);
-    if (iter != _prefixes.end())
+    OSS::mutex_critic_sec_lock lock(shard.mutex);
+    if (now >= shard.nextExpireCheck)
+    {
+      expireSessions(shard, now);
+      shard.nextExpireCheck = now + EXPIRE_CHECK_INTERVAL;
+    }
+    
+    Session& session = shard.sessions[sessionId];
+    if (session.counter != counter)
     {
-      iter->second->add(sessionId, dialString);
-      count = iter->second->size();
-      channelLimit = _limits[lastMatch];
-      
       //
-      // Update the workspace counter
+      // The session moves if its dial string now matches another counter,
+      // ie it was added before a reload that replaced its prefix
       //
-      std::ostringstream counterKey;
-      counterKey << CHANNEL_COUNT_PREFIX << lastMatch;
-      json::Object params;
-      params["prefix"] = json::String(lastMatch);
-      params["max-call-count"] = json::Number(channelLimit);
-      params["active-call-count"] = json::Number(count);
-      
-      OSS_LOG_INFO("SBCChannelLimits::addCall - " << dialString << " matches channel prefix " << lastMatch << " Current count is " << count);
-      
-      if (_systemDb)
+      if (session.counter)
       {
-        _systemDb->set(counterKey.str(), params);
+        session.counter->count.fetch_sub(1);
+        previous = session.counter;
       }
+      session.counter = counter;
+      count = counter->count.fetch_add(1) + 1;
     }
-    
-    if (count > channelLimit)
+    else
     {
-      OSS_LOG_WARNING("SBCChannelLimits::addCall - Channel limit violation for call " << dialString << " Current channel count is already " << count);
+      count = counter->count;
     }
+    session.expires = now + _cacheExpire;
   }
-  else
+  
+  if (previous)
   {
-    OSS_LOG_INFO("SBCChannelLimits::addCall - " << dialString << " did not match any registrered channel prefix");
+    updateWorkspaceCounter(*previous, previous->count);
   }
   
+  channelLimit = counter->limit;
+  
+  OSS_LOG_INFO("SBCChannelLimits::addCall - " << dialString << " matches channel prefix " << counter->prefix << " Current count is " << count);
+  
+  updateWorkspaceCounter(*counter, count);
   
+  if (count > channelLimit)
+  {
+    OSS_LOG_WARNING("SBCChannelLimits::addCall - Channel limit violation for call " << dialString << " Current channel count is already " << count);
+  }
   
   return count;
 }
@@ -256,11 +317,10 @@ std::size_t SBCChannelLimits::getCallCount(const std::string& prefix)
   
   if (!prefix.empty())
   {
-    OSS::mutex_critic_sec_lock lock(_prefixesMutex);
-    ChannelMap::iterator iter = _prefixes.find(prefix);
-    if (iter != _prefixes.end())
+    CounterPtr counter = boost::atomic_load(&_trie)->find(prefix);
+    if (counter)
     {
-      callCount = iter->second->size();
+      callCount = counter->count;
       OSS_LOG_INFO("SBCChannelLimits::getCallCount(" << prefix << ") returned " << callCount);
     }
     else
@@ -274,60 +334,32 @@ std::size_t SBCChannelLimits::getCallCount(const std::string& prefix)
   
 std::size_t SBCChannelLimits::removeCall(const std::string& sessionId, const std::string& dialString)
 { 
-  std::string alias;
-  resolveAliasPrefix(dialString, alias);
-  
-  //
-  // Note:  do not lock the mutex before resolveAliasPrefix() or you will deadlock)
-  //
-  OSS::mutex_critic_sec_lock lock(_prefixesMutex);
-  std::string lowerBoundKey = OSS::string_left(dialString, _shortestPrefix);
+  CounterPtr counter;
   std::size_t count = 0;
-  
-  std::string lastMatch;
-  if (alias.empty())
+  SessionShard& shard = getShard(sessionId);
   {
-    for (ChannelMap::iterator iter = _prefixes.lower_bound(lowerBoundKey); iter != _prefixes.end(); iter++)
+    OSS::mutex_critic_sec_lock lock(shard.mutex);
+    Sessions::iterator iter = shard.sessions.find(sessionId);
+    if (iter != shard.sessions.end())
     {
-      if (OSS::string_starts_with(dialString, iter->first.c_str()))
-      {
-        lastMatch = iter->first;
-        break;
-      }
+      //
+      // Decrement the counter the session was added to.  It is the same as
+      // the matched one unless the prefix was reloaded in between.
+      //
+      counter = iter->second.counter;
+      count = counter->count.fetch_sub(1) - 1;
+      shard.sessions.erase(iter);
     }
   }
-  else
-  {
-    lastMatch = alias;
-  }
   
-  if (!lastMatch.empty())
+  if (counter)
   {
-    ChannelMap::iterator iter = _prefixes.find(lastMatch);
-    if (iter != _prefixes.end())
-    {
-      iter->second->remove(sessionId);
-      count = iter->second->size();
-      
-      //
-      // Update the workspace counter
-      //
-      int channelLimit = _limits[lastMatch];
-      std::ostringstream counterKey;
-      counterKey << CHANNEL_COUNT_PREFIX << lastMatch;
-      json::Object params;
-      params["prefix"] = json::String(lastMatch);
-      params["max-call-count"] = json::Number(channelLimit);
-      params["active-call-count"] = json::Number(count);
-      
-      if (_systemDb)
-      {
-        _systemDb->set(counterKey.str(), params);
-      }
-    }
+    updateWorkspaceCounter(*counter, count);
+    return count;
   }
   
-  return count;
+  counter = matchPrefix(dialString);
+  return counter ? counter->count.load() : 0;
 }
 
 
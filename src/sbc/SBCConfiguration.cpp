@@ -91,6 +91,48 @@ bool SBCConfiguration::initUserAgent()
     OSS::JSON::Boolean val = _userAgent["dialog_state_in_contact_params"];
     SBCContact::_dialogStateInParams = val.Value();
   }
+
+  if (_userAgent.Exists("media_proxy_nodes"))
+  {
+    //
+    // [ { "address": "tcp://10.0.0.1:40590", "weight": 1, "enabled": true } ]
+    //
+    SBCMediaProxy::NodeWeights nodes;
+    try
+    {
+      OSS::JSON::Array entries = _userAgent["media_proxy_nodes"];
+      int count = entries.Size();
+      for (int i = 0; i < count; i++)
+      {
+        OSS::JSON::Object node = entries[i];
+        if (!node.Exists("address"))
+        {
+          continue;
+        }
+        if (node.Exists("enabled"))
+        {
+          OSS::JSON::Boolean enabled = node["enabled"];
+          if (!enabled.Value())
+          {
+            continue;
+          }
+        }
+        OSS::JSON::String address = node["address"];
+        unsigned int weight = 1;
+        if (node.Exists("weight"))
+        {
+          OSS::JSON::Number val = node["weight"];
+          weight = (unsigned int)val.Value();
+        }
+        nodes[address.Value()] = weight;
+      }
+      SBCManager::instance()->rtpProxy().configureNodes(nodes);
+    }
+    catch(...)
+    {
+      OSS_LOG_ERROR("SBCConfiguration::initUserAgent - Invalid media_proxy_nodes.  Media nodes are left unchanged.");
+    }
+  }
   return true;
 }
 
@@ -27,6 +27,7 @@
 #include "OSS/UTL/Logger.h"
 #include "OSS/UTL/Console.h"
 #include "OSS/UTL/termcolor.h"
+#include "OSS/Metrics/MetricsRegistry.h"
 #include "OSS/JSON/reader.h"
 #include "OSS/JSON/writer.h"
 #include "OSS/JSON/elements.h"
@@ -324,6 +325,8 @@ SBCConsole::SBCConsole()
   addCommandHandler(boost::bind(&SBCConsole::handleSyntaxRequest, this, _1, _2));
   addCommandHandler(boost::bind(&SBCConsole::handleHelpRequest, this, _1, _2));
   addCommandHandler(boost::bind(&SBCConsole::handlePublishRequest, this, _1, _2));
+  addCommandHandler(boost::bind(&SBCConsole::handleMetricsRequest, this, _1, _2));
+  addCommand("metrics", "metrics snapshot", "Display the current value of all runtime metrics");
 }
   
 SBCConsole::~SBCConsole()
@@ -522,6 +525,20 @@ bool SBCConsole::handlePublishRequest(const SBCConsole::CommandTokens& data, std
   return true;
 }
 
+bool SBCConsole::handleMetricsRequest(const SBCConsole::CommandTokens& data, std::string& result)
+{
+  if (!SBCConsole::isCommand("metrics snapshot", data))
+  {
+    return false;
+  }
+  result = OSS::Metrics::MetricsRegistry::instance().toString();
+  if (result.empty())
+  {
+    result = "No metrics recorded";
+  }
+  return true;
+}
+
 bool SBCConsole::verifyCommandSyntax(const std::string& command)
 {
   return verifyConsoleCommand(command.c_str());
@@ -0,0 +1,153 @@
+// OSS Software Solutions Application Programmer Interface
+//
+// Author: Joegen E. Baclor - mailto:joegen@ossapp.com
+//
+// Package: SBC
+//
+// Copyright (c) OSS Software Solutions
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "OSS Software Solutions OSS API General License Agreement".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+
+#include "OSS/SIP/SBC/SBCDialPrefixTrie.h"
+
+
+namespace OSS {
+namespace SIP {
+namespace SBC {
+
+
+SBCDialPrefixTrie::Counter::Counter(const std::string& prefix_, std::size_t limit_) :
+  prefix(prefix_),
+  limit(limit_),
+  count(0)
+{
+}
+
+SBCDialPrefixTrie::Node::Node() :
+  counter(0)
+{
+  for (int i = 0; i < ALPHABET_SIZE; i++)
+    children[i].store(0, boost::memory_order_relaxed);
+}
+
+SBCDialPrefixTrie::SBCDialPrefixTrie() :
+  _root(new Node()),
+  _size(0),
+  _nodeCount(1)
+{
+}
+
+SBCDialPrefixTrie::~SBCDialPrefixTrie()
+{
+  destroy(_root);
+}
+
+void SBCDialPrefixTrie::destroy(Node* pNode)
+{
+  //
+  // Iterative so a long garbage prefix can't blow the stack
+  //
+  std::vector<Node*> pending;
+  pending.push_back(pNode);
+  while (!pending.empty())
+  {
+    Node* pCurrent = pending.back();
+    pending.pop_back();
+    for (int i = 0; i < ALPHABET_SIZE; i++)
+    {
+      Node* pChild = pCurrent->children[i].load(boost::memory_order_relaxed);
+      if (pChild)
+        pending.push_back(pChild);
+    }
+    delete pCurrent;
+  }
+}
+
+bool SBCDialPrefixTrie::insert(const std::string& prefix, const CounterPtr& counter)
+{
+  if (prefix.empty() || !counter)
+    return false;
+
+  for (std::string::const_iterator iter = prefix.begin(); iter != prefix.end(); iter++)
+  {
+    if (charIndex(*iter) < 0)
+      return false;
+  }
+
+  Node* pNode = _root;
+  for (std::string::const_iterator iter = prefix.begin(); iter != prefix.end(); iter++)
+  {
+    int index = charIndex(*iter);
+    Node* pChild = pNode->children[index].load(boost::memory_order_relaxed);
+    if (!pChild)
+    {
+      pChild = new Node();
+      //
+      // The node is fully constructed before it becomes reachable
+      //
+      pNode->children[index].store(pChild, boost::memory_order_release);
+      _nodeCount.fetch_add(1, boost::memory_order_relaxed);
+    }
+    pNode = pChild;
+  }
+
+  _counters.insert(counter);
+  if (!pNode->counter.exchange(counter.get(), boost::memory_order_release))
+    _size.fetch_add(1, boost::memory_order_relaxed);
+  return true;
+}
+
+SBCDialPrefixTrie::CounterPtr SBCDialPrefixTrie::match(const std::string& dialString) const
+{
+  Counter* pMatch = 0;
+  const Node* pNode = _root;
+  for (std::string::const_iterator iter = dialString.begin(); iter != dialString.end(); iter++)
+  {
+    int index = charIndex(*iter);
+    if (index < 0)
+      break;
+    pNode = pNode->children[index].load(boost::memory_order_acquire);
+    if (!pNode)
+      break;
+    Counter* pCounter = pNode->counter.load(boost::memory_order_acquire);
+    if (pCounter)
+      pMatch = pCounter;
+  }
+  return pMatch ? pMatch->shared_from_this() : CounterPtr();
+}
+
+SBCDialPrefixTrie::CounterPtr SBCDialPrefixTrie::find(const std::string& prefix) const
+{
+  if (prefix.empty())
+    return CounterPtr();
+
+  const Node* pNode = _root;
+  for (std::string::const_iterator iter = prefix.begin(); iter != prefix.end(); iter++)
+  {
+    int index = charIndex(*iter);
+    if (index < 0)
+      return CounterPtr();
+    pNode = pNode->children[index].load(boost::memory_order_acquire);
+    if (!pNode)
+      return CounterPtr();
+  }
+  Counter* pCounter = pNode->counter.load(boost::memory_order_acquire);
+  return pCounter ? pCounter->shared_from_this() : CounterPtr();
+}
+
+
+} } } // OSS::SIP::SBC
@@ -40,7 +40,6 @@ namespace SBC {
   
 static const Poco::Timestamp::TimeDiff DEFAULT_CACHE_EXPIRE = 60*60*1000;  /// 1 hour lifetime
 static const char* DOMAIN_COUNT_PREFIX = "sbc.domain-channel-count-";
-static const char* DOMAIN_COUNT_PREFIX_WILD_CARD = "sbc.domain-channel-count-*";
 
 
 using OSS::Persistent::ClassType;
@@ -70,12 +69,7 @@ void SBCDomainLimits::initialize(SBCManager* pSBCManager)
     //
     // Clear out the previous domain count
     //
-    std::vector<std::string> keys;
-    _systemDb->getKeys(DOMAIN_COUNT_PREFIX_WILD_CARD, keys);
-    for (std::vector<std::string>::iterator iter = keys.begin(); iter != keys.end(); iter++)
-    {
-      _systemDb->del(*iter);
-    }
+    _systemDb->delKeysWithPrefix(DOMAIN_COUNT_PREFIX);
     
     try
     {
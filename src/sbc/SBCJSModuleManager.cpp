@@ -25,6 +25,7 @@
 #include "OSS/SIP/SBC/SBCManager.h"
 #include "OSS/SIP/SBC/SBCJSModuleManager.h"
 #include "OSS/UTL/CoreUtils.h"
+#include "OSS/Metrics/MetricsRegistry.h"
 
 
 namespace OSS {
@@ -37,6 +38,12 @@ using OSS::JS::JSIsolateManager;
 
 SBCJSModuleManager* SBCJSModuleManager::_pInstance = 0;
 
+static OSS::Metrics::Histogram& js_script_time()
+{
+  static OSS::Metrics::Histogram& histogram = OSS::Metrics::MetricsRegistry::instance().histogram("js.script.us");
+  return histogram;
+}
+
 SBCJSModuleManager* SBCJSModuleManager::createInstance(SBCManager* pManager)
 {
   if (pManager && !SBCJSModuleManager::_pInstance)
@@ -113,6 +120,7 @@ bool SBCJSModuleManager::processTransactionEvent(const std::string& eventName, c
   arguments["dataSource"] = OSS::JSON::String("transaction");
   arguments["eventName"] = OSS::JSON::String(eventName);
   event["arguments"] = arguments;
+  OSS::Metrics::ScopedTimer scriptTimer(js_script_time());
   return JS::JSIsolateManager::instance().rootIsolate()->execute(event, result, 0, pTransaction.get());
 }
 
@@ -128,6 +136,7 @@ bool SBCJSModuleManager::processRequestEvent(const std::string& eventName, const
   arguments["dataSource"] = OSS::JSON::String("request");
   arguments["eventName"] = OSS::JSON::String(eventName);
   event["arguments"] = arguments;
+  OSS::Metrics::ScopedTimer scriptTimer(js_script_time());
   return JS::JSIsolateManager::instance().rootIsolate()->execute(event, result, 0, pMessage.get());
 }
 
@@ -148,6 +157,7 @@ bool SBCJSModuleManager::processCustomEvent(const std::string& eventName, const
     arguments[iter->first.c_str()] = OSS::JSON::String(iter->second);
   }
   event["arguments"] = arguments;
+  OSS::Metrics::ScopedTimer scriptTimer(js_script_time());
   if (!JS::JSIsolateManager::instance().rootIsolate()->execute(event, ret, 0, pMsg.get()))
   {
     return false;
@@ -0,0 +1,153 @@
+// OSS Software Solutions Application Programmer Interface
+//
+// Author: Joegen E. Baclor - mailto:joegen@ossapp.com
+//
+// Package: SBC
+//
+// Copyright (c) OSS Software Solutions
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "OSS Software Solutions OSS API General License Agreement".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+
+#include "OSS/SIP/SBC/SBCLocationService.h"
+
+
+namespace OSS {
+namespace SIP {
+namespace SBC {
+
+
+SBCLocationService::SBCLocationService()
+{
+}
+
+SBCLocationService::~SBCLocationService()
+{
+}
+
+void SBCLocationService::removeKey(KeyIndex::iterator iter)
+{
+  AorIndex::iterator aor = _aors.find(iter->second.aor);
+  if (aor != _aors.end())
+  {
+    Bindings& bindings = aor->second;
+    for (Bindings::iterator binding = bindings.begin(); binding != bindings.end(); binding++)
+    {
+      if (binding->key == iter->first)
+      {
+        bindings.erase(binding);
+        break;
+      }
+    }
+    if (bindings.empty())
+      _aors.erase(aor);
+  }
+
+  if (iter->second.deadline != _deadlines.end())
+    _deadlines.erase(iter->second.deadline);
+
+  _keys.erase(iter);
+}
+
+void SBCLocationService::update(const std::string& key, const SBCRegistrationRecord& record)
+{
+  OSS::mutex_write_lock lock(_rwMutex);
+
+  KeyIndex::iterator iter = _keys.find(key);
+  if (iter != _keys.end())
+    removeKey(iter);
+
+  Binding binding;
+  binding.key = key;
+  binding.record = record;
+  binding.deadline = deadline(record);
+  _aors[record.aor()].push_back(binding);
+
+  KeyInfo& info = _keys[key];
+  info.aor = record.aor();
+  info.deadline = binding.deadline ? _deadlines.insert(DeadlineIndex::value_type(binding.deadline, key)) : _deadlines.end();
+}
+
+bool SBCLocationService::remove(const std::string& key)
+{
+  OSS::mutex_write_lock lock(_rwMutex);
+  KeyIndex::iterator iter = _keys.find(key);
+  if (iter == _keys.end())
+    return false;
+  removeKey(iter);
+  return true;
+}
+
+bool SBCLocationService::getBindings(const std::string& aor, Bindings& bindings, OSS::UInt64 now) const
+{
+  OSS::mutex_read_lock lock(_rwMutex);
+  AorIndex::const_iterator iter = _aors.find(aor);
+  if (iter == _aors.end())
+    return false;
+
+  for (Bindings::const_iterator binding = iter->second.begin(); binding != iter->second.end(); binding++)
+  {
+    if (!binding->deadline || binding->deadline > now)
+      bindings.push_back(*binding);
+  }
+  return !bindings.empty();
+}
+
+bool SBCLocationService::getKeys(const std::string& aor, Keys& keys) const
+{
+  OSS::mutex_read_lock lock(_rwMutex);
+  AorIndex::const_iterator iter = _aors.find(aor);
+  if (iter == _aors.end())
+    return false;
+
+  for (Bindings::const_iterator binding = iter->second.begin(); binding != iter->second.end(); binding++)
+    keys.push_back(binding->key);
+  return !keys.empty();
+}
+
+std::size_t SBCLocationService::expire(OSS::UInt64 now, Keys& expired)
+{
+  OSS::mutex_write_lock lock(_rwMutex);
+  std::size_t count = 0;
+  while (!_deadlines.empty() && _deadlines.begin()->first <= now)
+  {
+    std::string key = _deadlines.begin()->second;
+    KeyIndex::iterator iter = _keys.find(key);
+    if (iter == _keys.end())
+    {
+      //
+      // Should not happen.  Drop the orphan so the loop makes progress.
+      //
+      _deadlines.erase(_deadlines.begin());
+      continue;
+    }
+    removeKey(iter);
+    expired.push_back(key);
+    count++;
+  }
+  return count;
+}
+
+void SBCLocationService::clear()
+{
+  OSS::mutex_write_lock lock(_rwMutex);
+  _aors.clear();
+  _keys.clear();
+  _deadlines.clear();
+}
+
+
+} } } // OSS::SIP::SBC
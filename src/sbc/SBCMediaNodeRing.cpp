@@ -0,0 +1,255 @@
+// OSS Software Solutions Application Programmer Interface
+//
+// Author: Joegen E. Baclor - mailto:joegen@ossapp.com
+//
+// Package: SBC
+//
+// Copyright (c) OSS Software Solutions
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "OSS Software Solutions OSS API General License Agreement".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+
+#include "OSS/SIP/SBC/SBCMediaNodeRing.h"
+#include "OSS/UTL/CoreUtils.h"
+#include "OSS/UTL/Logger.h"
+
+
+namespace OSS {
+namespace SIP {
+namespace SBC {
+
+
+SBCMediaNodeRing::NodeInfo::NodeInfo() :
+  weight(0),
+  failures(0),
+  ejectedUntil(0)
+{
+}
+
+SBCMediaNodeRing::SBCMediaNodeRing(unsigned int maxFailures, unsigned int ejectTime) :
+  _maxFailures(maxFailures ? maxFailures : 1),
+  _ejectTime(ejectTime)
+{
+}
+
+SBCMediaNodeRing::~SBCMediaNodeRing()
+{
+}
+
+OSS::UInt32 SBCMediaNodeRing::hash(const std::string& key)
+{
+  OSS::UInt32 h = 2166136261u;
+  for (std::string::const_iterator iter = key.begin(); iter != key.end(); iter++)
+  {
+    h ^= static_cast<unsigned char>(*iter);
+    h *= 16777619u;
+  }
+  //
+  // FNV-1a has poor avalanche on the high bits for short keys that only
+  // differ in the last character.  Finalize with the murmur3 mixer so
+  // the points of a node spread evenly around the ring.
+  //
+  h ^= h >> 16;
+  h *= 0x85ebca6bu;
+  h ^= h >> 13;
+  h *= 0xc2b2ae35u;
+  h ^= h >> 16;
+  return h;
+}
+
+void SBCMediaNodeRing::insertPoints(const NodeInfo& node)
+{
+  unsigned int points = node.weight * POINTS_PER_WEIGHT;
+  for (unsigned int i = 0; i < points; i++)
+  {
+    std::string point = node.id + "#" + OSS::string_from_number<unsigned int>(i);
+    //
+    // On the rare collision the first owner keeps the point
+    //
+    _ring.insert(Ring::value_type(hash(point), node.id));
+  }
+}
+
+void SBCMediaNodeRing::erasePoints(const NodeInfo& node)
+{
+  unsigned int points = node.weight * POINTS_PER_WEIGHT;
+  for (unsigned int i = 0; i < points; i++)
+  {
+    std::string point = node.id + "#" + OSS::string_from_number<unsigned int>(i);
+    Ring::iterator iter = _ring.find(hash(point));
+    if (iter != _ring.end() && iter->second == node.id)
+      _ring.erase(iter);
+  }
+}
+
+bool SBCMediaNodeRing::addNode(const std::string& id, unsigned int weight)
+{
+  if (!weight)
+    return false;
+
+  OSS::mutex_write_lock lock(_rwMutex);
+  NodeMap::iterator iter = _nodes.find(id);
+  if (iter != _nodes.end())
+  {
+    if (iter->second.weight == weight)
+      return true;
+    erasePoints(iter->second);
+    iter->second.weight = weight;
+    insertPoints(iter->second);
+    return true;
+  }
+
+  NodeInfo node;
+  node.id = id;
+  node.weight = weight;
+  _nodes[id] = node;
+  insertPoints(node);
+  OSS_LOG_INFO("SBCMediaNodeRing::addNode - " << id << " weight " << weight);
+  return true;
+}
+
+bool SBCMediaNodeRing::removeNode(const std::string& id)
+{
+  OSS::mutex_write_lock lock(_rwMutex);
+  NodeMap::iterator iter = _nodes.find(id);
+  if (iter == _nodes.end())
+    return false;
+  erasePoints(iter->second);
+  _nodes.erase(iter);
+  OSS_LOG_INFO("SBCMediaNodeRing::removeNode - " << id);
+  return true;
+}
+
+bool SBCMediaNodeRing::hasNode(const std::string& id) const
+{
+  OSS::mutex_read_lock lock(_rwMutex);
+  return _nodes.find(id) != _nodes.end();
+}
+
+bool SBCMediaNodeRing::isHealthy(const NodeInfo& node, OSS::UInt64 now) const
+{
+  return !node.ejectedUntil || node.ejectedUntil <= now;
+}
+
+bool SBCMediaNodeRing::isHealthy(const std::string& id) const
+{
+  OSS::mutex_read_lock lock(_rwMutex);
+  NodeMap::const_iterator iter = _nodes.find(id);
+  return iter != _nodes.end() && isHealthy(iter->second, OSS::getTime());
+}
+
+bool SBCMediaNodeRing::getNode(const std::string& key, std::string& id) const
+{
+  OSS::mutex_read_lock lock(_rwMutex);
+  if (_ring.empty())
+    return false;
+
+  OSS::UInt64 now = OSS::getTime();
+  Ring::const_iterator start = _ring.lower_bound(hash(key));
+  if (start == _ring.end())
+    start = _ring.begin();
+
+  //
+  // Walk clockwise until a healthy node is found.  Nodes already found
+  // to be ejected are remembered so each is only looked up once.
+  //
+  std::vector<const std::string*> ejected;
+  Ring::const_iterator iter = start;
+  do
+  {
+    bool skip = false;
+    for (std::vector<const std::string*>::const_iterator e = ejected.begin(); e != ejected.end(); e++)
+    {
+      if (**e == iter->second)
+      {
+        skip = true;
+        break;
+      }
+    }
+
+    if (!skip)
+    {
+      NodeMap::const_iterator node = _nodes.find(iter->second);
+      if (node != _nodes.end() && isHealthy(node->second, now))
+      {
+        id = iter->second;
+        return true;
+      }
+      ejected.push_back(&iter->second);
+      if (ejected.size() == _nodes.size())
+        return false;
+    }
+
+    if (++iter == _ring.end())
+      iter = _ring.begin();
+  } while (iter != start);
+
+  return false;
+}
+
+void SBCMediaNodeRing::markFailure(const std::string& id)
+{
+  OSS::mutex_write_lock lock(_rwMutex);
+  NodeMap::iterator iter = _nodes.find(id);
+  if (iter == _nodes.end())
+    return;
+
+  if (++iter->second.failures >= _maxFailures)
+  {
+    if (!iter->second.ejectedUntil)
+    {
+      OSS_LOG_WARNING("SBCMediaNodeRing::markFailure - Ejecting " << id << " after " << iter->second.failures << " consecutive failures");
+    }
+    iter->second.ejectedUntil = OSS::getTime() + _ejectTime;
+  }
+}
+
+void SBCMediaNodeRing::markSuccess(const std::string& id)
+{
+  {
+    //
+    // This is called for every request.  Avoid the write lock in the
+    // common case where the node is already healthy.
+    //
+    OSS::mutex_read_lock lock(_rwMutex);
+    NodeMap::const_iterator iter = _nodes.find(id);
+    if (iter == _nodes.end() || (!iter->second.failures && !iter->second.ejectedUntil))
+      return;
+  }
+
+  OSS::mutex_write_lock lock(_rwMutex);
+  NodeMap::iterator iter = _nodes.find(id);
+  if (iter == _nodes.end())
+    return;
+  if (iter->second.ejectedUntil)
+  {
+    OSS_LOG_INFO("SBCMediaNodeRing::markSuccess - Readmitting " << id);
+  }
+  iter->second.failures = 0;
+  iter->second.ejectedUntil = 0;
+}
+
+SBCMediaNodeRing::Nodes SBCMediaNodeRing::getNodes() const
+{
+  OSS::mutex_read_lock lock(_rwMutex);
+  Nodes nodes;
+  for (NodeMap::const_iterator iter = _nodes.begin(); iter != _nodes.end(); iter++)
+    nodes.push_back(iter->second);
+  return nodes;
+}
+
+
+} } } // OSS::SIP::SBC
@@ -24,6 +24,8 @@
 
 #include "OSS/SIP/SBC/SBCMediaProxy.h"
 #include "OSS/SIP/SBC/SBCManager.h"
+#include "OSS/UTL/CoreUtils.h"
+#include <boost/bind.hpp>
 
 
 namespace OSS {
@@ -31,53 +33,26 @@ namespace SIP {
 namespace SBC {
   
 #define RTP_PROXY_THREAD_COUNT 30
-  
-static int get_node(const std::string& sessionId, bool& spillOver)
+#define LEGACY_NODE_COUNT 5
+#define DEFAULT_MAX_SESSION 30
+
+static std::size_t legacy_node_index(const std::string& sessionId)
 {
+  //
+  // Digits 5 to 9 spill over to nodes 0 to 4
+  //
   if (sessionId.size() < 5)
     return 0;
-  
-  spillOver = false;
   char c = sessionId.at(4);
-  
-  switch(c)
-  {
-    case '0':
-      return 0;
-    case '1':
-      return 1;
-    case '2':
-      return 2;
-    case '3':
-      return 3;
-    case '4':
-      return 4;
-    case '5':
-      spillOver = true;
-      return 0;
-    case '6':
-      spillOver = true;
-      return 1;
-    case '7':
-      spillOver = true;
-      return 2;
-    case '8':
-      spillOver = true;
-      return 3;
-    case '9':
-      spillOver = true;
-      return 4;
-  }
-  
-  return 0;
+  if (c < '0' || c > '9')
+    return 0;
+  return (c - '0') % LEGACY_NODE_COUNT;
 }
   
 SBCMediaProxy::SBCMediaProxy(SBCManager* pManager) :
-  _node0(0),
-  _node1(1),
-  _node2(2),
-  _node3(3),
-  _node4(4),
+  _sessionPinLifetime(DEFAULT_SESSION_PIN_LIFETIME),
+  _nextPinSweep(0),
+  _maxSession(DEFAULT_MAX_SESSION),
   _pManager(pManager),
   _remoteRtpEnabled(false)
 {
@@ -93,16 +68,32 @@ bool SBCMediaProxy::initialize(bool remoteRtpEnabled)
 
   if (_remoteRtpEnabled)
   {
-    if (!_node0.initialize())
-      return false;
-    if (!_node1.initialize())
-      return false;
-    if (!_node2.initialize())
-      return false;
-    if (!_node3.initialize())
-      return false;
-    if (!_node4.initialize())
-      return false;
+    std::vector<Node> nodes;
+    {
+      OSS::mutex_write_lock lock(_rwNodesMutex);
+      if (_nodes.empty())
+      {
+        //
+        // No node was configured.  Fall back to the legacy local nodes.
+        //
+        for (int i = 0; i < LEGACY_NODE_COUNT; i++)
+        {
+          Node node(new SBCMediaProxyClient(i));
+          attachNode(node);
+          _nodes[node->getAddress()] = node;
+          _legacyNodes.push_back(node);
+          _ring.addNode(node->getAddress());
+        }
+      }
+      for (Nodes::iterator iter = _nodes.begin(); iter != _nodes.end(); iter++)
+        nodes.push_back(iter->second);
+    }
+
+    for (std::vector<Node>::iterator iter = nodes.begin(); iter != nodes.end(); iter++)
+    {
+      if (!(*iter)->initialize())
+        return false;
+    }
   }
   else
   {
@@ -111,23 +102,223 @@ bool SBCMediaProxy::initialize(bool remoteRtpEnabled)
   return true;
 }
 
-SBCMediaProxyClient* SBCMediaProxy::getNode(const std::string& sessionId, bool& spillOver)
+void SBCMediaProxy::attachNode(const Node& node)
 {
-  if (_remoteRtpEnabled)
+  node->setHealthHandler(boost::bind(&SBCMediaProxy::updateHealth, this, _1, _2));
+  node->setMaxSession(_maxSession);
+}
+
+bool SBCMediaProxy::addNode(const std::string& address, unsigned int weight)
+{
+  if (address.empty() || !weight)
+    return false;
+
+  Node node;
+  {
+    OSS::mutex_write_lock lock(_rwNodesMutex);
+    Nodes::iterator iter = _nodes.find(address);
+    if (iter == _nodes.end())
+    {
+      node = Node(new SBCMediaProxyClient(address));
+      _nodes[address] = node;
+    }
+    _legacyNodes.clear();
+  }
+
+  if (node)
+  {
+    attachNode(node);
+    if (_remoteRtpEnabled)
+      node->initialize();
+  }
+
+  return _ring.addNode(address, weight);
+}
+
+bool SBCMediaProxy::removeNode(const std::string& address)
+{
+  Node node;
+  {
+    OSS::mutex_write_lock lock(_rwNodesMutex);
+    Nodes::iterator iter = _nodes.find(address);
+    if (iter == _nodes.end())
+      return false;
+    node = iter->second;
+    _nodes.erase(iter);
+    _legacyNodes.clear();
+
+    for (Sessions::iterator session = _sessions.begin(); session != _sessions.end();)
+    {
+      if (session->second.address == address)
+        _sessions.erase(session++);
+      else
+        ++session;
+    }
+  }
+  _ring.removeNode(address);
+
+  //
+  // Requests already holding a reference to the node complete before
+  // the node is destroyed by the last reference going away
+  //
+  return true;
+}
+
+bool SBCMediaProxy::configureNodes(const NodeWeights& nodes)
+{
+  std::vector<std::string> stale;
+  {
+    OSS::mutex_read_lock lock(_rwNodesMutex);
+    for (Nodes::const_iterator iter = _nodes.begin(); iter != _nodes.end(); iter++)
+    {
+      if (nodes.find(iter->first) == nodes.end())
+        stale.push_back(iter->first);
+    }
+  }
+
+  //
+  // New nodes are added first so there is always a node to move to
+  //
+  bool ok = true;
+  for (NodeWeights::const_iterator iter = nodes.begin(); iter != nodes.end(); iter++)
+  {
+    if (!addNode(iter->first, iter->second))
+    {
+      OSS_LOG_ERROR("SBCMediaProxy::configureNodes - Invalid media node " << iter->first << " weight " << iter->second);
+      ok = false;
+    }
+  }
+
+  for (std::vector<std::string>::const_iterator iter = stale.begin(); iter != stale.end(); iter++)
+    removeNode(*iter);
+
+  return ok;
+}
+
+SBCMediaProxy::Node SBCMediaProxy::getNode(const std::string& sessionId, std::string& address)
+{
+  if (!_remoteRtpEnabled)
+    return Node();
+
+  address.clear();
+  {
+    OSS::mutex_read_lock lock(_rwNodesMutex);
+    Sessions::const_iterator session = _sessions.find(sessionId);
+    if (session != _sessions.end())
+    {
+      Nodes::const_iterator node = _nodes.find(session->second.address);
+      if (node != _nodes.end())
+      {
+        address = session->second.address;
+        return node->second;
+      }
+    }
+
+    if (!_legacyNodes.empty())
+      address = _legacyNodes[legacy_node_index(sessionId)]->getAddress();
+  }
+
+  //
+  // Sessions that are not pinned, ie those created before a restart,
+  // are looked up in the ring.  The ring hash is stable so they resolve
+  // to the same node as long as the node set did not change.
+  //
+  if (address.empty() && !_ring.getNode(sessionId, address))
   {
-    int node = get_node(sessionId, spillOver);
-    if (node == 0)
-      return &_node0;
-    else if (node == 1)
-      return &_node1;
-    else if (node == 2)
-      return &_node2;
-    else if (node == 3)
-      return &_node3;
-    else if (node == 4)
-      return &_node4;
+    OSS_LOG_ERROR("SBCMediaProxy::getNode - No healthy media node available for session " << sessionId);
+    return Node();
   }
-  return 0;
+
+  OSS::mutex_read_lock lock(_rwNodesMutex);
+  Nodes::const_iterator node = _nodes.find(address);
+  return node != _nodes.end() ? node->second : Node();
+}
+
+void SBCMediaProxy::pinSession(const std::string& sessionId, const std::string& address)
+{
+  OSS::UInt64 now = OSS::getTime();
+  OSS::UInt64 lifetime = (OSS::UInt64)_sessionPinLifetime * 1000;
+
+  {
+    //
+    // Re-offers within the first half of the lifetime leave the pin as is
+    // so they do not contend for the write lock
+    //
+    OSS::mutex_read_lock lock(_rwNodesMutex);
+    Sessions::const_iterator session = _sessions.find(sessionId);
+    if (session != _sessions.end() && session->second.address == address && session->second.expires > now + lifetime / 2)
+      return;
+  }
+
+  OSS::mutex_write_lock lock(_rwNodesMutex);
+
+  //
+  // The node may have been removed while the request was in flight
+  //
+  if (_nodes.find(address) == _nodes.end())
+  {
+    _sessions.erase(sessionId);
+    return;
+  }
+
+  Pin& pin = _sessions[sessionId];
+  pin.address = address;
+  pin.expires = now + lifetime;
+}
+
+void SBCMediaProxy::releaseSession(const std::string& sessionId)
+{
+  OSS::mutex_write_lock lock(_rwNodesMutex);
+  _sessions.erase(sessionId);
+}
+
+void SBCMediaProxy::expireSessions(OSS::UInt64 now)
+{
+  OSS::mutex_write_lock lock(_rwNodesMutex);
+  for (Sessions::iterator session = _sessions.begin(); session != _sessions.end();)
+  {
+    if (session->second.expires <= now)
+      _sessions.erase(session++);
+    else
+      ++session;
+  }
+}
+
+void SBCMediaProxy::updateHealth(const std::string& address, bool reachable)
+{
+  if (reachable)
+    _ring.markSuccess(address);
+  else
+    _ring.markFailure(address);
+
+  //
+  // Every node reply lands here.  Piggyback the sweep of stale pins on it
+  // at most once per sweep interval.
+  //
+  OSS::UInt64 now = OSS::getTime();
+  {
+    OSS::mutex_critic_sec_lock lock(_pinSweepMutex);
+    if (now < _nextPinSweep)
+      return;
+    _nextPinSweep = now + SESSION_PIN_SWEEP_INTERVAL * 1000;
+  }
+  expireSessions(now);
+}
+
+void SBCMediaProxy::setSessionPinLifetime(unsigned int seconds)
+{
+  _sessionPinLifetime = seconds;
+}
+
+unsigned int SBCMediaProxy::getSessionPinLifetime() const
+{
+  return _sessionPinLifetime;
+}
+
+std::size_t SBCMediaProxy::getPinnedSessionCount() const
+{
+  OSS::mutex_read_lock lock(_rwNodesMutex);
+  return _sessions.size();
 }
    
 bool SBCMediaProxy::handleSDP(
@@ -143,11 +334,19 @@ bool SBCMediaProxy::handleSDP(
   OSS::RTP::RTPProxy::Attributes& rtpAttribute)
 {
   OSS_LOG_DEBUG("SBCMediaProxy handling SDP");
-  bool spillOver = false;
-  SBCMediaProxyClient* pNode = getNode(sessionId, spillOver);
-  if (pNode)
+  if (_remoteRtpEnabled)
   {
-    return pNode->handleSDP(logId, sessionId, sentBy, packetSourceIP, packetLocalInterface, route, routeLocalInterface, requestType, sdp, rtpAttribute);
+    std::string address;
+    Node pNode = getNode(sessionId, address);
+    if (!pNode)
+      return false;
+    if (!pNode->handleSDP(logId, sessionId, sentBy, packetSourceIP, packetLocalInterface, route, routeLocalInterface, requestType, sdp, rtpAttribute))
+    {
+      releaseSession(sessionId);
+      return false;
+    }
+    pinSession(sessionId, address);
+    return true;
   }
   else
   {
@@ -166,10 +365,12 @@ bool SBCMediaProxy::handleSDP(
 
 bool SBCMediaProxy::getSDP(const std::string& sessionId, std::string& lastOffer, std::string& lastAnswer)
 {
-  bool spillOver = false;
-  SBCMediaProxyClient* pNode = getNode(sessionId, spillOver);
-  if (pNode)
+  if (_remoteRtpEnabled)
   {
+    std::string address;
+    Node pNode = getNode(sessionId, address);
+    if (!pNode)
+      return false;
     return pNode->getSDP( sessionId, lastOffer, lastAnswer);
   }
   else
@@ -183,10 +384,13 @@ bool SBCMediaProxy::getSDP(const std::string& sessionId, std::string& lastOffer,
 
 bool SBCMediaProxy::removeSession(const std::string& sessionId)
 {
-  bool spillOver = false;
-  SBCMediaProxyClient* pNode = getNode(sessionId, spillOver);
-  if (pNode)
+  if (_remoteRtpEnabled)
   {
+    std::string address;
+    Node pNode = getNode(sessionId, address);
+    releaseSession(sessionId);
+    if (!pNode)
+      return false;
     return pNode->removeSession(sessionId);
   }
   else
@@ -199,28 +403,38 @@ bool SBCMediaProxy::removeSession(const std::string& sessionId)
 
 bool SBCMediaProxy::setMaxSession(unsigned int maxSession)
 {
-  _node0.setMaxSession(maxSession);
-  _node1.setMaxSession(maxSession);
-  _node2.setMaxSession(maxSession);
-  _node3.setMaxSession(maxSession);
-  _node4.setMaxSession(maxSession);
+  _maxSession = maxSession;
+
+  //
+  // Each node is updated with a synchronous request.  They are made
+  // outside the lock so session lookups are not held up.
+  //
+  std::vector<Node> nodes;
+  {
+    OSS::mutex_read_lock lock(_rwNodesMutex);
+    nodes.reserve(_nodes.size());
+    for (Nodes::iterator iter = _nodes.begin(); iter != _nodes.end(); iter++)
+      nodes.push_back(iter->second);
+  }
+  for (std::vector<Node>::iterator iter = nodes.begin(); iter != nodes.end(); iter++)
+    (*iter)->setMaxSession(maxSession);
   return true;
 }
 
 unsigned int SBCMediaProxy::getMaxSession() const
 {
-  return _node0.getMaxSession();
+  return _maxSession;
 }
   
 unsigned int SBCMediaProxy::getSessionCount() const
 {
   if (_remoteRtpEnabled)
   {
-    return _node0.getSessionCount() +
-      _node1.getSessionCount() +
-      _node2.getSessionCount() +
-      _node3.getSessionCount() +
-      _node4.getSessionCount();
+    unsigned int count = 0;
+    OSS::mutex_read_lock lock(_rwNodesMutex);
+    for (Nodes::const_iterator iter = _nodes.begin(); iter != _nodes.end(); iter++)
+      count += iter->second->getSessionCount();
+    return count;
   }
   else
   {
@@ -25,7 +25,10 @@
 
 #include "OSS/SIP/SBC/SBCMediaProxyClient.h"
 #include "OSS/UTL/Logger.h"
+#include "OSS/JSON/Json.h"
 #include "OSS/Net/Net.h"
+#include <boost/bind.hpp>
+#include <boost/thread/thread_time.hpp>
 
 
 namespace OSS {
@@ -36,8 +39,18 @@ namespace SBC {
 // ZeroMQ poll timeout is in microseconds in Version 2
 // and is changed to milliseconds in version 3!!!
 //
-#define RES_USE_POLL 1
-#define ZMQ_READ_TIMEOUT 1000 * 1000 * 2
+#if ZMQ_VERSION_MAJOR < 3
+#define ZMQ_POLL_MSEC 1000
+typedef int64_t zmq_more_t;
+#else
+#define ZMQ_POLL_MSEC 1
+typedef int zmq_more_t;
+#endif
+
+//
+// Interval at which the I/O thread checks for timed out requests
+//
+#define IO_POLL_INTERVAL_MS 100
 
 
 static const char * RESPONDER_BIND_ADDRESS_NODE_0 = "tcp://127.0.0.1:40590"; 
@@ -57,74 +70,64 @@ void s_free (void *data, void *hint)
 {
   free (data);
 }
-//  Convert string to 0MQ string and send to socket
-static bool s_send (zmq::socket_t & socket, const std::string & data)
-{
-  char * buff = (char*)malloc(data.size());
-  memcpy(buff, data.c_str(), data.size());
-  zmq::message_t message((void*)buff, data.size(), s_free, 0);
-  bool rc = socket.send(message);
-  return (rc);
-}
 
-//  Sends string as 0MQ string, as multipart non-terminal
-static bool s_sendmore (zmq::socket_t & socket, const std::string & data)
+//  Sends string as 0MQ string, as multipart non-terminal if more is set
+static bool s_send (zmq::socket_t & socket, const std::string & data, bool more = false)
 {
   char * buff = (char*)malloc(data.size());
-  memcpy(buff, data.c_str(), data.size());
+  memcpy(buff, data.data(), data.size());
   zmq::message_t message((void*)buff, data.size(), s_free, 0);
-  bool rc = socket.send(message, ZMQ_SNDMORE);
+  bool rc = socket.send(message, more ? ZMQ_SNDMORE : 0);
   return (rc);
 }
 
-static void s_receive (zmq::socket_t& socket, std::string& value)
+//  Receives one frame without blocking.  Returns false if there is none.
+static bool s_receive (zmq::socket_t& socket, std::string& value, bool& more)
 {
   zmq::message_t message;
-  socket.recv(&message);
-  if (!message.size())
-    return;
+  if (!socket.recv(&message, ZMQ_NOBLOCK))
+    return false;
   value = std::string(static_cast<char*>(message.data()), message.size());
+  zmq_more_t rcvmore = 0;
+  size_t size = sizeof(rcvmore);
+  socket.getsockopt(ZMQ_RCVMORE, &rcvmore, &size);
+  more = rcvmore != 0;
+  return true;
 }
 
-static zmq::socket_t* create_socket(zmq::context_t& context, int nodeIndex)
+static std::string get_node_address(int nodeIndex)
 {
-  zmq::socket_t* pSocket = new zmq::socket_t(context, ZMQ_REQ);
+  switch (nodeIndex)
+  {
+  case -1:
+    return RESPONDER_BIND_ADDRESS;
+  case 0:
+    return RESPONDER_BIND_ADDRESS_NODE_0;
+  case 1:
+    return RESPONDER_BIND_ADDRESS_NODE_1;
+  case 2:
+    return RESPONDER_BIND_ADDRESS_NODE_2;
+  case 3:
+    return RESPONDER_BIND_ADDRESS_NODE_3;
+  case 4:
+    return RESPONDER_BIND_ADDRESS_NODE_4;
+  }
+  OSS_LOG_ERROR("SBCMediaProxyClient - Invalid node index " << nodeIndex);
+  return std::string();
+}
+
+static zmq::socket_t* create_socket(zmq::context_t& context, const std::string& address)
+{
+  if (address.empty())
+    return 0;
+
+  zmq::socket_t* pSocket = new zmq::socket_t(context, ZMQ_DEALER);
   int linger = 0;
   pSocket->setsockopt (ZMQ_LINGER, &linger, sizeof (linger));
   
   try
   {
-    if (nodeIndex == -1)
-    {
-      pSocket->connect(RESPONDER_BIND_ADDRESS);
-    }
-    else if (nodeIndex == 0)
-    {
-      pSocket->connect(RESPONDER_BIND_ADDRESS_NODE_0);
-    }
-    else if (nodeIndex == 1)
-    {
-      pSocket->connect(RESPONDER_BIND_ADDRESS_NODE_1);
-    }
-    else if (nodeIndex == 2)
-    {
-      pSocket->connect(RESPONDER_BIND_ADDRESS_NODE_2);
-    }
-    else if (nodeIndex == 3)
-    {
-      pSocket->connect(RESPONDER_BIND_ADDRESS_NODE_3);
-    }
-    else if (nodeIndex == 4)
-    {
-      pSocket->connect(RESPONDER_BIND_ADDRESS_NODE_4);
-    }
-    else
-    {
-      OSS_LOG_ERROR("SBCMediaProxyClient::connect() - Invalid node index " << nodeIndex);
-      delete pSocket;
-      pSocket = 0;
-    }
- 
+    pSocket->connect(address.c_str());
   }
   catch(const std::exception& e)
   {
@@ -145,94 +148,328 @@ static zmq::socket_t* create_socket(zmq::context_t& context, int nodeIndex)
 SBCMediaProxyClient::SBCMediaProxyClient(int nodeIndex) :
   _context(1),
   _pSocket(0),
+  _address(get_node_address(nodeIndex)),
+  _pThread(0),
+  _terminate(false),
+  _outbound(true),
+  _pendingCount(0),
+  _requestId(0),
+  _timeout(DEFAULT_TIMEOUT_MS),
   _maxSession(MAX_SESSION),
   _sessionCount(0),
   _nodeIndex(nodeIndex)
 {
 }
 
+SBCMediaProxyClient::SBCMediaProxyClient(const std::string& address) :
+  _context(1),
+  _pSocket(0),
+  _address(address),
+  _pThread(0),
+  _terminate(false),
+  _outbound(true),
+  _pendingCount(0),
+  _requestId(0),
+  _timeout(DEFAULT_TIMEOUT_MS),
+  _maxSession(MAX_SESSION),
+  _sessionCount(0),
+  _nodeIndex(-1)
+{
+}
+
 SBCMediaProxyClient::~SBCMediaProxyClient()
 {
-  delete _pSocket;
+  stop();
 }
 
 
 bool SBCMediaProxyClient::initialize()
 {
-  //
-  // Put initialization code here.  right there isn't any.
-  //
+  OSS::mutex_critic_sec_lock lock(_mutex);
+  if (_pThread)
+    return true;
+  _terminate = false;
+  _pThread = new boost::thread(boost::bind(&SBCMediaProxyClient::run, this));
   return true;
 }
 
-bool SBCMediaProxyClient::sendRequest(const std::string& logId, const std::string& cmd, const json::Object& params, json::Object& result)
+void SBCMediaProxyClient::stop()
 {
   OSS::mutex_critic_sec_lock lock(_mutex);
+  if (!_pThread)
+    return;
+  _terminate = true;
+  //
+  // Wake up the I/O thread with an empty request
+  //
+  _outbound.enqueue(OutboundRequest());
+  _pThread->join();
+  delete _pThread;
+  _pThread = 0;
+}
 
-  if  (!_pSocket)
-    _pSocket = create_socket(_context, _nodeIndex);
-  
-  if (!_pSocket)
-    return false;
-  
+void SBCMediaProxyClient::run()
+{
+  while (!_terminate)
+  {
+    if (!_pSocket)
+    {
+      _pSocket = create_socket(_context, _address);
+      if (!_pSocket)
+      {
+        failPending();
+        OSS::thread_sleep(IO_POLL_INTERVAL_MS);
+        continue;
+      }
+    }
+
+    zmq::pollitem_t items[] =
+    {
+      { *_pSocket, 0, ZMQ_POLLIN, 0 },
+      { 0, _outbound.getFd(), ZMQ_POLLIN, 0 }
+    };
+
+    try
+    {
+      zmq::poll(&items[0], 2, IO_POLL_INTERVAL_MS * ZMQ_POLL_MSEC);
+    }
+    catch(const std::exception& e)
+    {
+      OSS_LOG_ERROR("SBCMediaProxyClient::run() - ZMQ poll exception: " << e.what());
+    }
+
+    if (items[1].revents & ZMQ_POLLIN)
+    {
+      OutboundRequest request;
+      while (!_terminate && _outbound.try_dequeue(request, 0))
+      {
+        if (!request.handler)
+          continue;
+        if (!sendOutbound(request))
+        {
+          json::Object empty;
+          request.handler(false, empty);
+          //
+          // Recreate the socket on the next iteration
+          //
+          delete _pSocket;
+          _pSocket = 0;
+          break;
+        }
+      }
+    }
+
+    if (_pSocket && (items[0].revents & ZMQ_POLLIN))
+      receiveReplies();
+
+    expirePending(OSS::getTime());
+  }
+
+  //
+  // Fail requests that are queued or in flight
+  //
+  OutboundRequest request;
+  while (_outbound.try_dequeue(request, 0))
+  {
+    if (request.handler)
+    {
+      json::Object empty;
+      request.handler(false, empty);
+    }
+  }
+  failPending();
+  delete _pSocket;
+  _pSocket = 0;
+}
+
+bool SBCMediaProxyClient::sendOutbound(OutboundRequest& request)
+{
   try
   {
-    if (!s_sendmore(*_pSocket, cmd))
+    OSS_LOG_DEBUG(request.logId << "SBCMediaProxyClient::sendRequest() >>> Command: " << request.cmd << request.payload);
+    //
+    // Envelope is [request-id][empty delimiter] followed by the same
+    // [command][payload] frames a REQ socket would send
+    //
+    if (!s_send(*_pSocket, request.id, true) ||
+      !s_send(*_pSocket, std::string(), true) ||
+      !s_send(*_pSocket, request.cmd, true) ||
+      !s_send(*_pSocket, request.payload))
     {
-      OSS_LOG_ERROR(logId << "SBCMediaProxyClient::sendRequest() - Exception: SENDMORE failed");
-      delete _pSocket;
-      _pSocket = 0;
+      OSS_LOG_ERROR(request.logId << "SBCMediaProxyClient::sendRequest() - Exception: SEND failed");
       return false;
     }
-    
-    std::stringstream wstrm;
-    json::Writer::Write(params, wstrm);
-    std::string packet = wstrm.str();
-    OSS_LOG_DEBUG(logId << "SBCMediaProxyClient::sendRequest() >>> Command: " << cmd << packet);
-    if (!s_send(*_pSocket, packet))
+  }
+  catch(const std::exception& e)
+  {
+    OSS_LOG_ERROR(request.logId << "SBCMediaProxyClient::sendRequest() - Exception: " << e.what());
+    return false;
+  }
+
+  PendingRequest& pending = _pending[request.id];
+  pending.logId.swap(request.logId);
+  pending.cmd.swap(request.cmd);
+  pending.handler.swap(request.handler);
+  pending.deadline = OSS::getTime() + _timeout;
+  _pendingCount = _pending.size();
+  return true;
+}
+
+void SBCMediaProxyClient::receiveReplies()
+{
+  while (true)
+  {
+    std::vector<std::string> frames;
+    std::string frame;
+    bool more = true;
+    try
     {
-      OSS_LOG_ERROR(logId << "SBCMediaProxyClient::sendRequest() - Exception: SEND failed");
-      delete _pSocket;
-      _pSocket = 0;
-      return false;
+      while (more && s_receive(*_pSocket, frame, more))
+        frames.push_back(frame);
     }
-    
-#if RES_USE_POLL
+    catch(const std::exception& e)
+    {
+      OSS_LOG_ERROR("SBCMediaProxyClient::receiveReplies() - Exception: " << e.what());
+      return;
+    }
+
+    if (frames.empty())
+      return;
+
     //
-    // pool the socket for a response
-    // delete it if no response is received
+    // Expecting [request-id][empty delimiter][payload]
     //
-    zmq::pollitem_t items[] = { { *_pSocket, 0, ZMQ_POLLIN, 0 } };
-    zmq::poll (&items[0], 1, ZMQ_READ_TIMEOUT);
-            
-    if (items[0].revents & ZMQ_POLLIN) 
+    if (frames.size() < 3)
     {
-#endif     
-      std::string raw;
-      s_receive(*_pSocket, raw);
-      std::stringstream rstrm;
-      rstrm << raw;
-      OSS_LOG_DEBUG(logId << "SBCMediaProxyClient::sendRequest() <<< Command: " << cmd << raw);
-      json::Reader::Read(result, rstrm);
- #if RES_USE_POLL
+      OSS_LOG_WARNING("SBCMediaProxyClient::receiveReplies() - Ignoring malformed reply with " << frames.size() << " frames");
+      continue;
     }
-    else
+
+    PendingRequests::iterator iter = _pending.find(frames.front());
+    if (iter == _pending.end())
     {
-      OSS_LOG_ERROR(logId << "SBCMediaProxyClient::sendRequest() - Exception: READ timeout!");
-      delete _pSocket;
-      _pSocket = 0;
-      return false;
+      //
+      // Late reply for a request that has already timed out
+      //
+      continue;
     }
-#endif
+
+    PendingRequest request;
+    request.logId.swap(iter->second.logId);
+    request.cmd.swap(iter->second.cmd);
+    request.handler.swap(iter->second.handler);
+    _pending.erase(iter);
+    _pendingCount = _pending.size();
+    complete(request, frames.back());
   }
-  catch(const std::exception& e)
+}
+
+void SBCMediaProxyClient::complete(PendingRequest& request, const std::string& raw)
+{
+  OSS_LOG_DEBUG(request.logId << "SBCMediaProxyClient::sendRequest() <<< Command: " << request.cmd << raw);
+  json::Object result;
+  OSS::JSON::Exception e;
+  bool ok = OSS::JSON::json_parse(raw.data(), raw.size(), result, e);
+  if (!ok)
   {
-    OSS_LOG_ERROR(logId << "SBCMediaProxyClient::sendRequest() - Exception: " << e.what());
+    OSS_LOG_ERROR(request.logId << "SBCMediaProxyClient::sendRequest() - Exception: " << e.what());
   }
-  catch(...)
+  request.handler(ok, result);
+}
+
+void SBCMediaProxyClient::expirePending(OSS::UInt64 now)
+{
+  for (PendingRequests::iterator iter = _pending.begin(); iter != _pending.end();)
   {
-    OSS_LOG_ERROR(logId << "SBCMediaProxyClient::sendRequest() - Exception: unknown");
+    if (iter->second.deadline > now)
+    {
+      ++iter;
+      continue;
+    }
+    OSS_LOG_ERROR(iter->second.logId << "SBCMediaProxyClient::sendRequest() - Exception: READ timeout!");
+    ResponseHandler handler;
+    handler.swap(iter->second.handler);
+    _pending.erase(iter++);
+    json::Object empty;
+    handler(false, empty);
   }
+  _pendingCount = _pending.size();
+}
+
+void SBCMediaProxyClient::failPending()
+{
+  PendingRequests pending;
+  pending.swap(_pending);
+  _pendingCount = 0;
+  for (PendingRequests::iterator iter = pending.begin(); iter != pending.end(); iter++)
+  {
+    json::Object empty;
+    iter->second.handler(false, empty);
+  }
+}
+
+void SBCMediaProxyClient::sendRequestAsync(const std::string& logId, const std::string& cmd, const json::Object& params, const ResponseHandler& handler)
+{
+  if (!_pThread)
+    initialize();
+
+  OutboundRequest request;
+  request.id = OSS::string_from_number<OSS::UInt64>(++_requestId);
+  request.logId = logId;
+  request.cmd = cmd;
+  request.handler = handler;
+  OSS::JSON::json_object_to_string(params, request.payload);
+
+  if (!_outbound.enqueue(request))
+  {
+    json::Object empty;
+    handler(false, empty);
+  }
+}
+
+struct SBCMediaProxySyncResult
+{
+  SBCMediaProxySyncResult() : done(false), ok(false) {}
+  boost::mutex mutex;
+  boost::condition_variable cond;
+  bool done;
+  bool ok;
+  json::Object result;
+
+  void onResponse(bool ok_, const json::Object& result_)
+  {
+    boost::unique_lock<boost::mutex> lock(mutex);
+    ok = ok_;
+    result = result_;
+    done = true;
+    cond.notify_one();
+  }
+};
+
+bool SBCMediaProxyClient::sendRequest(const std::string& logId, const std::string& cmd, const json::Object& params, json::Object& result)
+{
+  boost::shared_ptr<SBCMediaProxySyncResult> response(new SBCMediaProxySyncResult());
+  sendRequestAsync(logId, cmd, params, boost::bind(&SBCMediaProxySyncResult::onResponse, response, _1, _2));
+
+  //
+  // The I/O thread always completes the request once the timeout elapses.
+  // The wait below is bounded anyway in case the I/O thread is stopped.
+  //
+  boost::unique_lock<boost::mutex> lock(response->mutex);
+  boost::system_time deadline = boost::get_system_time() + boost::posix_time::milliseconds(_timeout + 2 * IO_POLL_INTERVAL_MS);
+  while (!response->done)
+  {
+    if (!response->cond.timed_wait(lock, deadline))
+      break;
+  }
+
+  bool replied = response->done && response->ok;
+  lock.unlock();
+  if (_healthHandler)
+    _healthHandler(_address, replied);
+  if (!replied)
+    return false;
+  result = response->result;
   return true;
 }
 
@@ -352,7 +589,7 @@ bool SBCMediaProxyClient::setMaxSession(unsigned int maxSession)
 {
   _maxSession = maxSession;
   
-  if (_isConnected)
+  if (_pThread)
   {
     try
     {
@@ -45,6 +45,8 @@ using OSS::Persistent::DataType;
 using OSS::Net::IPAddress;
 
 #define DEFAULT_KEEP_ALIVE_FREQUENCY_IN_SECONDS 5
+#define DEFAULT_OPTIONS_KEEP_ALIVE_FREQUENCY_IN_SECONDS 60
+#define KEEP_ALIVE_TICK_IN_MILLISECONDS 1000
 
 SBCRegisterBehavior::SBCRegisterBehavior(SBCManager* pManager) :
   SBCDefaultBehavior(pManager, OSS::SIP::B2BUA::SIPB2BHandler::TYPE_REGISTER, "SBC REGISTER Request Handler"),
@@ -52,6 +54,8 @@ SBCRegisterBehavior::SBCRegisterBehavior(SBCManager* pManager) :
   _optionsThreadExit(0, 0xFFFF),
   _pOptionsResponseThread(0),
   _optionsResponseThreadExit(0, 0xFFFF),
+  _keepAliveList(DEFAULT_KEEP_ALIVE_FREQUENCY_IN_SECONDS * 1000 / KEEP_ALIVE_TICK_IN_MILLISECONDS),
+  _optionsKeepAliveList(DEFAULT_OPTIONS_KEEP_ALIVE_FREQUENCY_IN_SECONDS * 1000 / KEEP_ALIVE_TICK_IN_MILLISECONDS),
   _threadPool(1, 10),
   _enableOptionsKeepAlive(true)
 {
@@ -102,83 +106,112 @@ void SBCRegisterBehavior::deinitialize()
 
 void SBCRegisterBehavior::runOptionsThread()
 {
-  int currentIteration = 0;
-  unsigned int segmentSize = 0;
-  unsigned int nextSegment = 0;
-  std::vector<std::string> keys;
+  unsigned int ticksPerGatewayKeepAlive = DEFAULT_KEEP_ALIVE_FREQUENCY_IN_SECONDS * 1000 / KEEP_ALIVE_TICK_IN_MILLISECONDS;
+  unsigned int currentTick = 0;
+  KeepAliveList::Bindings crlfBindings;
+  OptionsKeepAliveList::Bindings optionsBindings;
   
   OSS_LOG_INFO("SBCRegisterBehavior::runOptionsThread - Keep-alive thread STARTED");
   
-  while(!_optionsThreadExit.tryWait(DEFAULT_KEEP_ALIVE_FREQUENCY_IN_SECONDS * 1000))
+  if (_enableOptionsKeepAlive)
+  {
+    loadOptionsKeepAlive();
+  }
+  
+  //
+  // Both keep-alive lists are timing wheels with one slot per tick.
+  // Every tick only sends to the bindings that fall in the current slot
+  // so the packets are spread evenly across the keep-alive interval.
+  //
+  while(!_optionsThreadExit.tryWait(KEEP_ALIVE_TICK_IN_MILLISECONDS))
   {
     if (_pauseKeepAlive)
     {
       //
       // Keep-alive is paused
       //
-      OSS_LOG_INFO("SBCRegisterBehavior::runOptionsThread - Keep-alive thread is PAUSED");
+      if (++currentTick % ticksPerGatewayKeepAlive == 0)
+      {
+        OSS_LOG_INFO("SBCRegisterBehavior::runOptionsThread - Keep-alive thread is PAUSED");
+      }
       continue;
     }
     
     //
-    // Send CRLF keep alive for every iteration
+    // Send CRLF keep alive to the bindings in the current slot
     //
-    {
-      OSS::mutex_read_lock readLock(_rwKeepAliveListMutex);
-      //_keepAliveList[packetSource] = localInterface;
-      for (KeepAliveList::iterator iter = _keepAliveList.begin(); iter != _keepAliveList.end(); iter++)
-        sendUDPKeepAlive(iter->second, iter->first);
-    }
+    crlfBindings.clear();
+    _keepAliveList.advance(crlfBindings);
+    for (KeepAliveList::Bindings::iterator iter = crlfBindings.begin(); iter != crlfBindings.end(); iter++)
+      sendUDPKeepAlive(iter->second, iter->first);
     
     //
     // Send keep=alive to gateways
     //
-    sendKeepAliveToGateways();
+    if (++currentTick % ticksPerGatewayKeepAlive == 0)
+    {
+      sendKeepAliveToGateways();
+    }
     
     if (_enableOptionsKeepAlive)
     {
-      currentIteration++;
+      optionsBindings.clear();
+      _optionsKeepAliveList.advance(optionsBindings);
+      for (OptionsKeepAliveList::Bindings::iterator iter = optionsBindings.begin(); iter != optionsBindings.end(); iter++)
+        sendOptionsKeepAlive(iter->first, iter->second);
+    }
+  }
+}
 
-      if (currentIteration == 1)
-      {
-        std::vector<std::string> upperReg;
-        _workspace->getKeys("sbc-reg*", upperReg);
-
-        std::vector<std::string> localReg;
-        _pManager->workspace().getLocalRegDb()->getKeys("*", localReg);
-
-        keys.clear();
-        keys.reserve(upperReg.size() + localReg.size());
-        keys.insert( keys.end(), upperReg.begin(), upperReg.end() );
-        keys.insert( keys.end(), localReg.begin(), localReg.end() );
-
-        segmentSize = keys.size() / 12;
-        if (segmentSize == 0)
-          segmentSize = 12;
-        nextSegment = 0;
-        size_t maxIter = keys.size();
-        for (size_t i = nextSegment; i < nextSegment + segmentSize && i < maxIter; i++)
-        {
-          sendOptionsKeepAlive(keys[i]);
-        }
-        nextSegment += segmentSize;
-      }
-      else
-      {
-        size_t maxIter = keys.size();
-        for (size_t i = nextSegment; i < nextSegment + segmentSize && i < maxIter; i++)
-        {
-          sendOptionsKeepAlive(keys[i]);
-        }
-        nextSegment += segmentSize;
-        if (currentIteration == 12)
-          currentIteration = 0;
-      }
+void SBCRegisterBehavior::loadOptionsKeepAlive()
+{
+  SBCWorkSpace::Records records;
+  SBCWorkSpace::Cursor upperReg(*_workspace, "sbc-reg");
+  while (upperReg.next(records))
+  {
+    for (SBCWorkSpace::Records::iterator iter = records.begin(); iter != records.end(); iter++)
+    {
+      SBCRegistrationRecord registration;
+      if (registration.readFromJson(iter->first, iter->second))
+        scheduleOptionsKeepAlive(iter->first, registration);
+    }
+    records.clear();
+  }
+
+  SBCWorkSpace::Cursor localReg(*(_pManager->workspace().getLocalRegDb()), "");
+  while (localReg.next(records))
+  {
+    for (SBCWorkSpace::Records::iterator iter = records.begin(); iter != records.end(); iter++)
+    {
+      SBCRegistrationRecord registration;
+      if (registration.readFromJson(iter->first, iter->second))
+        scheduleOptionsKeepAlive(iter->first, registration);
     }
+    records.clear();
+  }
+
+  OSS_LOG_INFO("SBCRegisterBehavior::loadOptionsKeepAlive - Loaded " << _optionsKeepAliveList.size() << " registrations");
+}
+
+void SBCRegisterBehavior::scheduleOptionsKeepAlive(const std::string& regKey, const SBCRegistrationRecord& registration)
+{
+  //
+  // Local-reg contacts are never sent OPTIONS.  No need to index them.
+  //
+  if (registration.contact().find(PropertyMap::propertyString(PropertyMap::PROP_LocalReg)) != std::string::npos)
+  {
+    return;
   }
+  OSS::UInt64 expireTime = registration.expires() > 0 ? OSS::getTime() + (OSS::UInt64)registration.expires() * 1000 : 0;
+  _optionsKeepAliveList.schedule(regKey, registration, expireTime);
+}
+
+void SBCRegisterBehavior::cancelOptionsKeepAlive(const std::string& regKey)
+{
+  _optionsKeepAliveList.cancel(regKey);
 }
 
-void SBCRegisterBehavior::sendOptionsKeepAlive(const std::string& regRecord)
+void SBCRegisterBehavior::sendOptionsKeepAlive(const std::string& regRecord, const SBCRegistrationRecord& registration)
 { 
   if (_pauseKeepAlive)
   {
@@ -195,38 +228,21 @@ void SBCRegisterBehavior::sendOptionsKeepAlive(const std::string& regRecord)
     // Upper-reg and local-reg  keys different.
     // Local-reg is the full identity of the account + the call-id + the binding
     //
-    SBCRegistrationRecord registration;
     std::string localUser;
     std::size_t atIndex = regRecord.find("@");
     std::ostringstream aor;
     if (atIndex != std::string::npos)
     {
       localUser = OSS::string_left(regRecord, atIndex);
-      
-      if (!registration.readFromWorkSpace(*(_pManager->workspace().getLocalRegDb()), regRecord))
-        return;
       aor << "sip:" << registration.aor();
     }
     else
     {
       localUser = regRecord;
-      if (!registration.readFromWorkSpace(*_workspace, regRecord))
-        return;
       aor << registration.aor();
     }
     
-    
-
-    
-    
     std::string contact = registration.contact();
-    //
-    // Skip local reg OPTIONS
-    //
-    if (contact.find(PropertyMap::propertyString(PropertyMap::PROP_LocalReg)) != std::string::npos)
-    {
-      return;
-    }
 
     std::string callId = OSS::string_create_uuid();
     size_t hash = OSS::string_hash(callId.c_str());
@@ -301,12 +317,15 @@ void SBCRegisterBehavior::runOptionsResponseThread()
     {
       try
       {
+        //
+        // The registration is taken from the in-memory keep-alive index.
+        // The workspace is only touched to delete the record.
+        //
         SBCRegistrationRecord registration;
+        if (!_optionsKeepAliveList.get(response, registration))
+          continue;
         
         std::size_t atIndex = response.find("@");
-        
-        if (!registration.readFromWorkSpace(atIndex == std::string::npos ? *_workspace : *(_pManager->workspace().getLocalRegDb()), response))
-          continue;
 
         std::ostringstream logMsg;
         logMsg << "Registration Expires: " << response;
@@ -314,10 +333,10 @@ void SBCRegisterBehavior::runOptionsResponseThread()
         //
         // Remove from the keep-alive list
         //
-        OSS::mutex_write_lock writeLock(_rwKeepAliveListMutex);
-        _keepAliveList.erase(OSS::Net::IPAddress::fromV4IPPort(registration.packetSource().c_str()));
+        _optionsKeepAliveList.cancel(response);
+        _keepAliveList.cancel(OSS::Net::IPAddress::fromV4IPPort(registration.packetSource().c_str()));
 
-        registration.eraseWorkSpaceRecord(atIndex == std::string::npos ? *_workspace : *(_pManager->workspace().getLocalRegDb()));
+        SBCRegistrationRecord::eraseWorkSpaceRecord(atIndex == std::string::npos ? *_workspace : *(_pManager->workspace().getLocalRegDb()), response);
       }
       catch(const OSS::Exception& e)
       {
@@ -491,8 +510,8 @@ void SBCRegisterBehavior::onProcessResponseInbound(
           //
           // Remove from the keep-alive list
           //
-          OSS::mutex_write_lock writeLock(_rwKeepAliveListMutex);
-          _keepAliveList.erase(pTransaction->serverTransport()->getRemoteAddress());
+          _optionsKeepAliveList.cancel(regId);
+          _keepAliveList.cancel(pTransaction->serverTransport()->getRemoteAddress());
         }catch(...){}
       }
     }
@@ -562,10 +581,9 @@ void SBCRegisterBehavior::onProcessResponseOutbound(
   {
     OSS::Net::IPAddress packetSource = pTransaction->serverTransport()->getRemoteAddress();
     OSS::Net::IPAddress localInterface = pTransaction->serverTransport()->getLocalAddress();
-    OSS::mutex_write_lock writeLock(_rwKeepAliveListMutex);
     if (!pTransaction->serverTransport()->isReliableTransport())
     {
-      _keepAliveList[packetSource] = localInterface;
+      _keepAliveList.schedule(packetSource, localInterface);
     }
     return;
   }
@@ -697,10 +715,9 @@ void SBCRegisterBehavior::onProcessResponseOutbound(
       else
         registration.expires() = 3600;
 
-      OSS::mutex_write_lock writeLock(_rwKeepAliveListMutex);
       if (!pTransaction->serverTransport()->isReliableTransport())
       {
-        _keepAliveList[packetSource] = localInterface;
+        _keepAliveList.schedule(packetSource, localInterface);
       }
       
       //
@@ -740,6 +757,11 @@ void SBCRegisterBehavior::onProcessResponseOutbound(
       OSS_LOG_INFO(logId << "Saving persistent REGISTER state - " << curi.data() << " to REG-ID: " << regId << " Call-ID: " << pResponse->hdrGet(OSS::SIP::HDR_CALL_ID));
       if (registration.writeToWorkSpace(*_workspace, regId))
       {
+        if (OSS::string_starts_with(regId, "sbc-reg"))
+        {
+          scheduleOptionsKeepAlive(regId, registration);
+        }
+
         //
         // WE preserve the registration towards this user so that we can use it
         // to route by AOR.  This however will break if AOR is shared by multiple bindings
@@ -779,6 +801,7 @@ void SBCRegisterBehavior::onProcessResponseOutbound(
 
 void SBCRegisterBehavior::deleteUpperRegistration(const std::string& regId)
 {
+  cancelOptionsKeepAlive(regId);
   if (_workspace->del(regId))
   {
     OSS_LOG_INFO("Registration " << regId << " DELETED");
@@ -33,10 +33,12 @@
 #include "OSS/UTL/PropertyMap.h"
 #include "OSS/SIP/SIPRequestLine.h"
 #include "OSS/SIP/SBC/SBCManager.h"
+#include "OSS/SIP/SBC/SBCRegisterBehavior.h"
 
 
 
 static const char* REG_EP = "reg-ep";
+static const OSS::UInt64 EXPIRE_CHECK_INTERVAL = 1000;
 
 
 namespace OSS {
@@ -49,7 +51,8 @@ typedef std::vector<std::string> Keys;
 
 SBCRegistrar::SBCRegistrar() :
   EndpointListener(REG_EP),
-  _pManager(0)
+  _pManager(0),
+  _nextExpireCheck(0)
 {
 }
 
@@ -62,6 +65,66 @@ void SBCRegistrar::attachSBCManager(SBCManager* pManager)
   _pManager = pManager;
 }
 
+void SBCRegistrar::setDatabase(const SBCWorkSpaceManager::WorkSpace& regDb)
+{
+  _regDb = regDb;
+  loadBindings();
+}
+
+void SBCRegistrar::loadBindings()
+{
+  _locations.clear();
+  if (!_regDb)
+  {
+    return;
+  }
+  
+  //
+  // This is the only place where the registrar walks the whole workspace
+  //
+  SBCWorkSpace::Cursor cursor(*_regDb, "");
+  SBCWorkSpace::Records records;
+  while (cursor.next(records))
+  {
+    for (SBCWorkSpace::Records::iterator iter = records.begin(); iter != records.end(); iter++)
+    {
+      SBCRegistrationRecord binding;
+      if (binding.readFromJson(iter->first, iter->second) && !binding.aor().empty())
+      {
+        _locations.update(iter->first, binding);
+      }
+    }
+    records.clear();
+  }
+  
+  OSS_LOG_NOTICE("SBCRegistrar::loadBindings - Loaded " << _locations.size() << " bindings for " << _locations.aorCount() << " AORs");
+}
+
+void SBCRegistrar::expireBindings()
+{
+  OSS::UInt64 now = OSS::getTime();
+  OSS::UInt64 nextCheck = _nextExpireCheck.load(boost::memory_order_relaxed);
+  if (now < nextCheck || !_nextExpireCheck.compare_exchange_strong(nextCheck, now + EXPIRE_CHECK_INTERVAL))
+  {
+    //
+    // Not yet due or another thread is already on it
+    //
+    return;
+  }
+  
+  Keys expired;
+  if (!_locations.expire(now, expired))
+  {
+    return;
+  }
+  
+  for (Keys::iterator iter = expired.begin(); iter != expired.end(); iter++)
+  {
+    OSS_LOG_INFO("SBCRegistrar::expireBindings - Binding " << *iter << " has expired");
+    deleteBinding(*iter);
+  }
+}
+
 void SBCRegistrar::handleStart()
 { 
   OSS_LOG_NOTICE("SBC Local Registrar event loop has STARTED");
@@ -83,6 +146,8 @@ void SBCRegistrar::onHandleEvent(const SIPMessage::Ptr& pRequest)
     dispatchMessage(pResponse);
     return;
   }
+  
+  expireBindings();
   //
   // Get the contact list
   //
@@ -221,7 +286,26 @@ bool SBCRegistrar::storeBinding(const std::string& key, const SBCRegistrationRec
   {
     return false;
   }
-  return binding.writeToWorkSpace(*_regDb, key);
+  if (!binding.writeToWorkSpace(*_regDb, key))
+  {
+    return false;
+  }
+  _locations.update(key, binding);
+  if (_pManager && _pManager->registerHandler())
+  {
+    _pManager->registerHandler()->scheduleOptionsKeepAlive(key, binding);
+  }
+  return true;
+}
+
+void SBCRegistrar::deleteBinding(const std::string& key)
+{
+  if (_pManager && _pManager->registerHandler())
+  {
+    _pManager->registerHandler()->cancelOptionsKeepAlive(key);
+  }
+  _locations.remove(key);
+  _regDb->del(key);
 }
 
 void SBCRegistrar::dispatchContacts(const SIPMessage::Ptr& pRequest, const SIPURI& aor)
@@ -237,23 +321,18 @@ void SBCRegistrar::dispatchContacts(const SIPMessage::Ptr& pRequest, const SIPUR
   SIPMessage::Ptr pResponse;
   pResponse = pRequest->createResponse(OSS::SIP::SIPMessage::CODE_200_Ok);
   
-  std::ostringstream key;
-  key << aor.getIdentity(false) << "-*";
-  
-  std::vector<std::string> keys;
-  _regDb->getKeys(key.str(), keys);
+  OSS::UInt64 now = OSS::getTime();
+  SBCLocationService::Bindings bindings;
+  _locations.getBindings(aor.getIdentity(false), bindings, now);
   
-  for (std::vector<std::string>::iterator iter = keys.begin(); iter != keys.end(); iter++)
+  for (SBCLocationService::Bindings::iterator iter = bindings.begin(); iter != bindings.end(); iter++)
   {
-    SBCRegistrationRecord binding;
-    if (binding.readFromWorkSpace(*_regDb, *iter))
-    {
-      int elapsedTime = (OSS::getTime() - binding.timeStamp()) / 1000;
-      int actualExpires = binding.expires() - elapsedTime;
-      ContactURI curi(binding.contact());
-      curi.setHeaderParam("expires", OSS::string_from_number<int>(actualExpires).c_str());
-      pResponse->hdrListAppend(OSS::SIP::HDR_CONTACT, curi.data());
-    }
+    const SBCRegistrationRecord& binding = iter->record;
+    int elapsedTime = (now - binding.timeStamp()) / 1000;
+    int actualExpires = binding.expires() - elapsedTime;
+    ContactURI curi(binding.contact());
+    curi.setHeaderParam("expires", OSS::string_from_number<int>(actualExpires).c_str());
+    pResponse->hdrListAppend(OSS::SIP::HDR_CONTACT, curi.data());
   }
   
   pResponse->commitData(); 
@@ -283,9 +362,6 @@ void SBCRegistrar::updateBinding(const SIPMessage::Ptr& pRequest, const SIPTo& t
   std::ostringstream key;
   key << record.aor() << "-" << record.callId() << "-" << binding;
   
-  std::ostringstream allKeys;
-  allKeys << record.aor() << "-*";
-  
   if (!_regDb)
   {
     SIPMessage::Ptr pResponse;
@@ -295,7 +371,7 @@ void SBCRegistrar::updateBinding(const SIPMessage::Ptr& pRequest, const SIPTo& t
   }
   
   Keys keys;
-  _regDb->getKeys(allKeys.str(), keys);
+  _locations.getKeys(record.aor(), keys);
   
   if (keys.empty() || (keys.size() == 1 && keys.front() == key.str()))
   {
@@ -321,13 +397,13 @@ void SBCRegistrar::updateBinding(const SIPMessage::Ptr& pRequest, const SIPTo& t
   // If we reach this point, it means we have a bunch of existing registrations.
   // Make sure we get rid of duplicates
   //
-  std::ostringstream duplicateKeys;
-  duplicateKeys << record.aor() << "-*-" << binding;
-  keys.clear();
-  _regDb->getKeys(duplicateKeys.str(), keys);
+  std::string duplicateSuffix = "-" + binding;
   for (Keys::iterator iter = keys.begin(); iter != keys.end(); iter++)
   {
-    _regDb->del(*iter);
+    if (OSS::string_ends_with(*iter, duplicateSuffix.c_str()))
+    {
+      deleteBinding(*iter);
+    }
   }
   
   if (!storeBinding(key.str(), record))
@@ -363,13 +439,11 @@ void SBCRegistrar::removeBinding(const SIPMessage::Ptr& pRequest, const SIPTo& t
   
   if (contact == "*")
   {
-    std::ostringstream key;
-    key << aor << "-*";
     Keys keys;
-    _regDb->getKeys(key.str(), keys);
+    _locations.getKeys(aor, keys);
     for (Keys::iterator iter = keys.begin(); iter != keys.end(); iter++)
     {
-      _regDb->del(*iter);
+      deleteBinding(*iter);
     }
   }
   else
@@ -378,7 +452,7 @@ void SBCRegistrar::removeBinding(const SIPMessage::Ptr& pRequest, const SIPTo& t
     std::string binding = curi.getHostPort();
     std::ostringstream key;
     key << aor << "-" << callId << "-" << binding;
-    _regDb->del(key.str());
+    deleteBinding(key.str());
   }
   
   dispatchContacts(pRequest, toUri);
@@ -391,23 +465,16 @@ bool SBCRegistrar::getBindings(const SIPURI& aor, ContactList& bindings)
     return false;
   }
   
-  std::ostringstream key;
-  key << aor.getIdentity(false) << "-*";
+  expireBindings();
   
-  std::vector<std::string> keys;
-  _regDb->getKeys(key.str(), keys);
+  SBCLocationService::Bindings locations;
+  _locations.getBindings(aor.getIdentity(false), locations, OSS::getTime());
   
-  for (std::vector<std::string>::iterator iter = keys.begin(); iter != keys.end(); iter++)
+  for (SBCLocationService::Bindings::iterator iter = locations.begin(); iter != locations.end(); iter++)
   {
-    
-    json::Object regRecord;
-    _regDb->get(*iter, regRecord);
-
-    json::Object::iterator contact = regRecord.Find("contact");
-    if (contact != regRecord.End())
+    if (!iter->record.contact().empty())
     {
-      json::String element = contact->element;
-      ContactURI curi(element.Value());
+      ContactURI curi(iter->record.contact());
       bindings.push_back(curi);
     }
   }
@@ -422,19 +489,12 @@ bool SBCRegistrar::getRegistrations(const std::string& identity, Registrations&
     return false;
   }
   
-  std::ostringstream key;
-  key << identity << "-*";
+  SBCLocationService::Bindings bindings;
+  _locations.getBindings(identity, bindings, OSS::getTime());
   
-  std::vector<std::string> keys;
-  _regDb->getKeys(key.str(), keys);
-  
-  for (std::vector<std::string>::iterator iter = keys.begin(); iter != keys.end(); iter++)
+  for (SBCLocationService::Bindings::iterator iter = bindings.begin(); iter != bindings.end(); iter++)
   {
-    SBCRegistrationRecord registration;
-    if (registration.readFromWorkSpace(*_regDb, *iter))
-    {
-      registrations.insert(registration);
-    }
+    registrations.insert(iter->record);
   }
   
   return !registrations.empty();
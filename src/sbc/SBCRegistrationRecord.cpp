@@ -64,10 +64,23 @@ SBCRegistrationRecord& SBCRegistrationRecord::operator=(const SBCRegistrationRec
 
 bool SBCRegistrationRecord::readFromWorkSpace(SBCWorkSpace& client, const std::string& key)
 {
-  _key = key;
   json::Object response;
   if (!client.get(key, response))
     return false;
+  return readFromJson(key, response);
+}
+
+bool SBCRegistrationRecord::readFromJson(const std::string& key, const std::string& value)
+{
+  json::Object response;
+  if (!OSS::JSON::json_parse_string(value, response))
+    return false;
+  return readFromJson(key, response);
+}
+
+bool SBCRegistrationRecord::readFromJson(const std::string& key, json::Object& response)
+{
+  _key = key;
 
   json::String contact = response["contact"];
   _contact = contact.Value();
@@ -29,7 +29,8 @@
 #include "OSS/SIP/SIPVia.h"
 #include "OSS/UTL/Logger.h"
 #include "OSS/SDP/SDPMedia.h"
-#include "OSS/SDP/SDPSession.h"
+#include "OSS/SDP/SDPParser.h"
+#include "OSS/SDP/SDPRewriter.h"
 
 namespace OSS {
 namespace SIP {
@@ -39,144 +40,148 @@ using OSS::SIP::SIPMessage;
 using namespace OSS::RTP;
 using namespace OSS::SDP;
 
-static bool patch_sdp_media_address(SDPSession& sdpSession, SDPMedia::Type type, const std::string& address, unsigned short port = 0, std::size_t index = -1)
+static void patch_sdp_media_address(const SDPParser& parser, SDPRewriter& rewriter, SDPMedia::Type type, const std::string& address, unsigned short port = 0, std::size_t index = -1)
 {
-  size_t count = sdpSession.getMediaCount(type);
-  for (size_t i = 0; i < count; i++)
+  bool isV4 = OSS::Net::IPAddress::isV4Address(address);
+  const SDPParser::MediaList& mediaList = parser.getMediaList();
+  std::size_t count = 0;
+  for (SDPParser::MediaList::const_iterator media = mediaList.begin(); media != mediaList.end(); media++)
   {
-    if (i < index)
+    if (media->type != type || count++ < index)
     {
       continue;
     }
-    SDPMedia::Ptr media = sdpSession.getMedia(type, i);
-    if (media)
+
+    if (isV4)
     {
-      std::string addr = media->getAddress();
-      if (OSS::Net::IPAddress::isV4Address(address))
-      {
-        media->setAddressV4(address);
-      }
-      else
-      {
-        media->setAddressV6(address);
-      }
+      rewriter.setAddressV4(*media, address);
+    }
+    else
+    {
+      rewriter.setAddressV6(*media, address);
+    }
 
-      if (port != 0)
-      {
-        media->setDataPort(port);
-      }
+    if (port != 0)
+    {
+      rewriter.setDataPort(*media, port);
+    }
+  }
+}
+
+static void patch_sdp_media_attributes(const SDPParser& parser, SDPRewriter& rewriter, SDPMedia::Type type, const std::string& attributes, bool remove)
+{
+  const SDPParser::Media* media = parser.getMedia(type, 0);
+  if (!media)
+  {
+    return;
+  }
+
+  std::vector<std::string> tokens = OSS::string_tokenize(attributes, "~");
+  for (std::vector<std::string>::iterator iter = tokens.begin(); iter != tokens.end(); iter++)
+  {
+    if (remove)
+    {
+      rewriter.removeCommonAttribute(*media, iter->c_str());
+    }
+    else
+    {
+      rewriter.setFlagAttribute(*media, iter->c_str());
     }
   }
-  return false;
 }
 
 static void finalize_session_description(SIPB2BTransaction::Ptr pTransaction, std::string& sdp)
 {
-  SDPSession sdpSession(sdp.c_str());
   std::string force_sdp_global_ip;
   std::string force_sdp_audio_ip;
   std::string force_sdp_audio_port;
-  bool patched = false;
-  
-  if (pTransaction->getProperty("force-sdp-global-ip", force_sdp_global_ip) && !force_sdp_global_ip.empty())
+  std::string force_sdp_video_ip;
+  std::string force_sdp_video_port;
+  std::string sbc_sdp_audio_attributes;
+  std::string sbc_sdp_video_attributes;
+  std::string sbc_sdp_remove_audio_attributes;
+  std::string sbc_sdp_remove_video_attributes;
+
+  pTransaction->getProperty("force-sdp-global-ip", force_sdp_global_ip);
+  pTransaction->getProperty("force-sdp-audio-ip", force_sdp_audio_ip);
+  pTransaction->getProperty("force-sdp-video-ip", force_sdp_video_ip);
+  pTransaction->getProperty("sdp-audio-attributes", sbc_sdp_audio_attributes);
+  pTransaction->getProperty("sdp-video-attributes", sbc_sdp_video_attributes);
+  pTransaction->getProperty("sdp-remove-audio-attributes", sbc_sdp_remove_audio_attributes);
+  pTransaction->getProperty("sdp-remove-video-attributes", sbc_sdp_remove_video_attributes);
+
+  //
+  // Most transactions set none of these.  Do not even index the SDP then.
+  //
+  if (force_sdp_global_ip.empty() && force_sdp_audio_ip.empty() && force_sdp_video_ip.empty() &&
+    sbc_sdp_audio_attributes.empty() && sbc_sdp_video_attributes.empty() &&
+    sbc_sdp_remove_audio_attributes.empty() && sbc_sdp_remove_video_attributes.empty())
+  {
+    return;
+  }
+
+  SDPParser parser(sdp);
+  if (!parser.isValid())
+  {
+    return;
+  }
+  SDPRewriter rewriter(parser);
+
+  if (!force_sdp_global_ip.empty())
   {
     if (OSS::Net::IPAddress::isV4Address(force_sdp_global_ip))
     {
-      sdpSession.setAddressV4(force_sdp_global_ip);
+      rewriter.setAddressV4(force_sdp_global_ip);
     }
     else
     {
-      sdpSession.setAddressV6(force_sdp_global_ip);
+      rewriter.setAddressV6(force_sdp_global_ip);
     }
-    patched = true;
   }
   
-  if (pTransaction->getProperty("force-sdp-audio-ip", force_sdp_audio_ip) && !force_sdp_audio_ip.empty())
+  if (!force_sdp_audio_ip.empty())
   {
     int port = 0;
     if (pTransaction->getProperty("force-sdp-audio-port", force_sdp_audio_port) && !force_sdp_audio_port.empty())
     {
       port = OSS::string_to_number<int>(force_sdp_audio_port);
     }
-    patch_sdp_media_address(sdpSession, SDPMedia::TYPE_AUDIO, force_sdp_audio_ip, port, 0);
-    patched = true;
+    patch_sdp_media_address(parser, rewriter, SDPMedia::TYPE_AUDIO, force_sdp_audio_ip, port, 0);
   }
-  std::string force_sdp_video_ip;
-  std::string force_sdp_video_port;
-  if (pTransaction->getProperty("force-sdp-video-ip", force_sdp_video_ip) && !force_sdp_video_ip.empty())
+
+  if (!force_sdp_video_ip.empty())
   {
     int port = 0;
     if (pTransaction->getProperty("force-sdp-video-port", force_sdp_video_port) && !force_sdp_video_port.empty())
     {
       port = OSS::string_to_number<int>(force_sdp_video_port);
     }
-    patch_sdp_media_address(sdpSession, SDPMedia::TYPE_VIDEO, force_sdp_video_ip, port, 0);
-    patched = true;
+    patch_sdp_media_address(parser, rewriter, SDPMedia::TYPE_VIDEO, force_sdp_video_ip, port, 0);
   }
   
-  std::string sbc_sdp_audio_attributes;
-  if (pTransaction->getProperty("sdp-audio-attributes", sbc_sdp_audio_attributes) && !sbc_sdp_audio_attributes.empty())
+  if (!sbc_sdp_audio_attributes.empty())
   {
-    std::vector<std::string> tokens = OSS::string_tokenize(sbc_sdp_audio_attributes, "~");
-    SDPMedia::Ptr media = sdpSession.getMedia(SDPMedia::TYPE_AUDIO, 0);
-    if (media)
-    {
-      for (std::vector<std::string>::iterator iter = tokens.begin(); iter != tokens.end(); iter++)
-      {
-        media->setFlagAttribute(iter->c_str());
-        patched = true;
-      }
-    }
+    patch_sdp_media_attributes(parser, rewriter, SDPMedia::TYPE_AUDIO, sbc_sdp_audio_attributes, false);
   }
   
-  std::string sbc_sdp_video_attributes;
-  if (pTransaction->getProperty("sdp-video-attributes", sbc_sdp_video_attributes) && !sbc_sdp_video_attributes.empty())
+  if (!sbc_sdp_video_attributes.empty())
   {
-    std::vector<std::string> tokens = OSS::string_tokenize(sbc_sdp_video_attributes, "~");
-    SDPMedia::Ptr media = sdpSession.getMedia(SDPMedia::TYPE_VIDEO, 0);
-    if (media)
-    {
-      for (std::vector<std::string>::iterator iter = tokens.begin(); iter != tokens.end(); iter++)
-      {
-        media->setFlagAttribute(iter->c_str());
-        patched = true;
-      }
-    }
+    patch_sdp_media_attributes(parser, rewriter, SDPMedia::TYPE_VIDEO, sbc_sdp_video_attributes, false);
   }
   
-  std::string sbc_sdp_remove_audio_attributes;
-  if (pTransaction->getProperty("sdp-remove-audio-attributes", sbc_sdp_remove_audio_attributes) && !sbc_sdp_remove_audio_attributes.empty())
+  if (!sbc_sdp_remove_audio_attributes.empty())
   {
-    std::vector<std::string> tokens = OSS::string_tokenize(sbc_sdp_remove_audio_attributes, "~");
-    SDPMedia::Ptr media = sdpSession.getMedia(SDPMedia::TYPE_AUDIO, 0);
-    if (media)
-    {
-      for (std::vector<std::string>::iterator iter = tokens.begin(); iter != tokens.end(); iter++)
-      {
-        media->removeCommonAttribute(iter->c_str());
-        patched = true;
-      }
-    }
+    patch_sdp_media_attributes(parser, rewriter, SDPMedia::TYPE_AUDIO, sbc_sdp_remove_audio_attributes, true);
   }
   
-  std::string sbc_sdp_remove_video_attributes;
-  if (pTransaction->getProperty("sdp-remove-video-attributes", sbc_sdp_remove_video_attributes) && !sbc_sdp_remove_video_attributes.empty())
+  if (!sbc_sdp_remove_video_attributes.empty())
   {
-    std::vector<std::string> tokens = OSS::string_tokenize(sbc_sdp_remove_video_attributes, "~");
-    SDPMedia::Ptr media = sdpSession.getMedia(SDPMedia::TYPE_VIDEO, 0);
-    if (media)
-    {
-      for (std::vector<std::string>::iterator iter = tokens.begin(); iter != tokens.end(); iter++)
-      {
-        media->removeCommonAttribute(iter->c_str());
-        patched = true;
-      }
-    }
+    patch_sdp_media_attributes(parser, rewriter, SDPMedia::TYPE_VIDEO, sbc_sdp_remove_video_attributes, true);
   }
   
-  if (patched)
+  if (rewriter.hasPatches())
   {
-    sdp = sdpSession.toString();
+    sdp = rewriter.apply();
   }
 }
 
@@ -194,70 +199,52 @@ static void patch_ipv6_as_rfc1918_address(SIPB2BTransaction::Ptr pTransaction, s
   {
     return;
   }
-  bool patched = false;
-  SDPSession sdpSession(sdp.c_str());
-  
-  std::string globalAddress = sdpSession.getAddress();
-  if (!OSS::Net::IPAddress::isV4Address(globalAddress))
+
+  SDPParser parser(sdp);
+  if (!parser.isValid())
   {
-    OSS_LOG_DEBUG(pTransaction->getLogId() << "Forced global media address to masquerade as from " << globalAddress << " to " << replacementAddress);
-    sdpSession.setAddressV4(replacementAddress);
-    patched = true;
+    return;
   }
+  SDPRewriter rewriter(parser);
   
-  size_t audioCount = sdpSession.getMediaCount(SDPMedia::TYPE_AUDIO);
-  for (size_t i = 0; i < audioCount; i++)
+  std::string globalAddress = parser.getAddress();
+  if (!OSS::Net::IPAddress::isV4Address(globalAddress))
   {
-    SDPMedia::Ptr media = sdpSession.getMedia(SDPMedia::TYPE_AUDIO, i);
-    if (media)
-    {
-      std::string addr = media->getAddress();
-      if (!OSS::Net::IPAddress::isV4Address(addr))
-      {
-        OSS_LOG_DEBUG(pTransaction->getLogId() << "Forced audio media address to masquerade as from " << addr << " to " << replacementAddress);
-        media->setAddressV4(replacementAddress);
-        patched = true;
-      }
-    }
+    OSS_LOG_DEBUG(pTransaction->getLogId() << "Forced global media address to masquerade as from " << globalAddress << " to " << replacementAddress);
+    rewriter.setAddressV4(replacementAddress);
   }
   
-  size_t videoCount = sdpSession.getMediaCount(SDPMedia::TYPE_VIDEO);
-  for (size_t i = 0; i < videoCount; i++)
+  const SDPParser::MediaList& mediaList = parser.getMediaList();
+  for (SDPParser::MediaList::const_iterator media = mediaList.begin(); media != mediaList.end(); media++)
   {
-    SDPMedia::Ptr media = sdpSession.getMedia(SDPMedia::TYPE_VIDEO, i);
-    if (media)
+    const char* label;
+    switch (media->type)
     {
-      std::string addr = media->getAddress();
-      if (!OSS::Net::IPAddress::isV4Address(addr))
-      {
-        OSS_LOG_DEBUG(pTransaction->getLogId() << "Forced video media address to masquerade as from " << addr << " to " << replacementAddress);
-        media->setAddressV4(replacementAddress);
-        patched = true;
-      }
+    case SDPMedia::TYPE_AUDIO:
+      label = "audio";
+      break;
+    case SDPMedia::TYPE_VIDEO:
+      label = "video";
+      break;
+    case SDPMedia::TYPE_FAX:
+      label = "fax";
+      break;
+    default:
+      continue;
     }
-  }
-  
-  size_t faxCount = sdpSession.getMediaCount(SDPMedia::TYPE_FAX);
-  for (size_t i = 0; i < faxCount; i++)
-  {
-    SDPMedia::Ptr media = sdpSession.getMedia(SDPMedia::TYPE_FAX, i);
-    if (media)
+
+    std::string addr = parser.getAddress(*media);
+    if (!OSS::Net::IPAddress::isV4Address(addr))
     {
-      std::string addr = media->getAddress();
-      if (!OSS::Net::IPAddress::isV4Address(addr))
-      {
-        OSS_LOG_DEBUG(pTransaction->getLogId() << "Forced fax media address to masquerade as from " << addr << " to " << replacementAddress);
-        media->setAddressV4(replacementAddress);
-        patched = true;
-      }
+      OSS_LOG_DEBUG(pTransaction->getLogId() << "Forced " << label << " media address to masquerade as from " << addr << " to " << replacementAddress);
+      rewriter.setAddressV4(*media, replacementAddress);
     }
   }
   
-  if (patched)
+  if (rewriter.hasPatches())
   {
-    sdp = sdpSession.toString();
+    sdp = rewriter.apply();
   }
-  
 }
 
 SBCSDPBehavior::SBCSDPBehavior(SBCManager* pManager) :
@@ -10,6 +10,127 @@ namespace SIP {
 namespace SBC {
 
 
+SBCWorkSpace::Cursor::Cursor(SBCWorkSpace& workspace, const std::string& prefix, std::size_t batchSize) :
+  _workspace(workspace),
+  _start(prefix),
+  _end(LocalDb::prefixUpperBound(prefix)),
+  _includeStart(true),
+  _done(false),
+  _batchSize(batchSize ? batchSize : DEFAULT_BATCH_SIZE)
+{
+}
+
+SBCWorkSpace::Cursor::Cursor(SBCWorkSpace& workspace, const std::string& first, const std::string& last, std::size_t batchSize) :
+  _workspace(workspace),
+  _start(first),
+  _end(last),
+  _includeStart(true),
+  _done(false),
+  _batchSize(batchSize ? batchSize : DEFAULT_BATCH_SIZE)
+{
+}
+
+bool SBCWorkSpace::Cursor::read(Records& records, bool keysOnly)
+{
+  if (_done)
+  {
+    return false;
+  }
+  
+  std::size_t offset = records.size();
+  _workspace.getRange(_start, _includeStart, _end, _batchSize, records, keysOnly);
+  std::size_t count = records.size() - offset;
+  if (count < _batchSize)
+  {
+    _done = true;
+  }
+  
+  if (!count)
+  {
+    return false;
+  }
+  
+  //
+  // Resume after the last key of this batch
+  //
+  _start = records.back().first;
+  _includeStart = false;
+  return true;
+}
+
+bool SBCWorkSpace::Cursor::next(Records& records)
+{
+  return read(records, false);
+}
+
+bool SBCWorkSpace::Cursor::next(Keys& keys)
+{
+  Records records;
+  if (!read(records, true))
+  {
+    return false;
+  }
+  keys.reserve(keys.size() + records.size());
+  for (Records::const_iterator iter = records.begin(); iter != records.end(); iter++)
+  {
+    keys.push_back(iter->first);
+  }
+  return true;
+}
+
+SBCWorkSpace::Batch::Batch() :
+  _count(0)
+{
+}
+
+SBCWorkSpace::Batch::Operation& SBCWorkSpace::Batch::next()
+{
+  if (_count == _operations.size())
+  {
+    _operations.push_back(Operation());
+  }
+  return _operations[_count++];
+}
+
+void SBCWorkSpace::Batch::set(const std::string& key, const std::string& value)
+{
+  Operation& operation = next();
+  operation.key = key;
+  operation.value = value;
+  operation.erase = false;
+}
+
+void SBCWorkSpace::Batch::set(const std::string& key, const json::Object& value)
+{
+  Operation& operation = next();
+  operation.key = key;
+  OSS::JSON::json_object_to_string(value, operation.value);
+  operation.erase = false;
+}
+
+void SBCWorkSpace::Batch::del(const std::string& key)
+{
+  Operation& operation = next();
+  operation.key = key;
+  operation.value.clear();
+  operation.erase = true;
+}
+
+void SBCWorkSpace::Batch::clear()
+{
+  _count = 0;
+}
+
+std::size_t SBCWorkSpace::Batch::size() const
+{
+  return _count;
+}
+
+bool SBCWorkSpace::Batch::empty() const
+{
+  return !_count;
+}
+
 SBCWorkSpace::SBCWorkSpace(const std::string& name) :
   _name(name)
 {
@@ -56,6 +177,60 @@ bool SBCWorkSpace::getKeys(const std::string& pattern, std::vector<std::string>&
     return _db.getKeys(pattern, keys);
 }
 
+bool SBCWorkSpace::getRange(const std::string& start, bool includeStart, const std::string& end, std::size_t limit, Records& records, bool keysOnly) const
+{
+    OSS::mutex_critic_sec_lock lock(_dbMutex);
+    return _db.getRange(start, includeStart, end, limit, records, keysOnly);
+}
+
+bool SBCWorkSpace::getKeysWithPrefix(const std::string& prefix, Keys& keys) const
+{
+    OSS::mutex_critic_sec_lock lock(_dbMutex);
+    return _db.getKeysWithPrefix(prefix, keys);
+}
+
+bool SBCWorkSpace::getRecordsWithPrefix(const std::string& prefix, Records& records) const
+{
+    OSS::mutex_critic_sec_lock lock(_dbMutex);
+    return _db.getRecordsWithPrefix(prefix, records);
+}
+
+bool SBCWorkSpace::getRecordsInRange(const std::string& first, const std::string& last, Records& records, std::size_t limit) const
+{
+    return getRange(first, true, last, limit, records, false);
+}
+
+std::size_t SBCWorkSpace::delKeysWithPrefix(const std::string& prefix)
+{
+    OSS::mutex_critic_sec_lock lock(_dbMutex);
+    Keys keys;
+    _db.getKeysWithPrefix(prefix, keys);
+    for (Keys::const_iterator iter = keys.begin(); iter != keys.end(); iter++)
+    {
+      _db.erase(*iter);
+    }
+    return keys.size();
+}
+
+bool SBCWorkSpace::write(const Batch& batch)
+{
+    OSS::mutex_critic_sec_lock lock(_dbMutex);
+    bool ok = true;
+    for (std::size_t i = 0; i < batch._count; i++)
+    {
+      const Batch::Operation& operation = batch._operations[i];
+      if (operation.erase)
+      {
+        _db.erase(operation.key, false);
+      }
+      else if (!_db.set(operation.key, operation.value, false))
+      {
+        ok = false;
+      }
+    }
+    return _db.sync() && ok;
+}
+
 bool SBCWorkSpace::open(const std::string& localDbFile)
 {
   OSS::mutex_critic_sec_lock lock(_dbMutex);
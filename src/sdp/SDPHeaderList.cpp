@@ -47,6 +47,15 @@ SDPHeaderList::SDPHeaderList(const char* rawHeader, char exitName) :
   parse(rawHeader);
 }
 
+SDPHeaderList::SDPHeaderList(const char* rawHeader, char exitName, std::size_t& tailOffset) :
+   std::list<SDPHeader>(),
+   _parserState(STATE_EXPECTING_NAME),
+   _isValid(false),
+   _exitName(exitName)
+{
+  tailOffset = parse(rawHeader, false);
+}
+
 SDPHeaderList::SDPHeaderList(const SDPHeaderList& header) :
    std::list<SDPHeader>(header),
    _parserState(header._parserState),
@@ -85,7 +94,11 @@ SDPHeaderList& SDPHeaderList::operator = (const char* rawHeader)
 
 void SDPHeaderList::parse(const char* rawHeader)
 {
+  parse(rawHeader, true);
+}
 
+std::size_t SDPHeaderList::parse(const char* rawHeader, bool storeTail)
+{
   _parserState = STATE_EXPECTING_NAME;
   _isValid = false;
 
@@ -103,14 +116,14 @@ void SDPHeaderList::parse(const char* rawHeader)
       if (is_char(c))
         name = c;
       else
-        return;
+        return 0;
       _parserState = STATE_EXPECTING_EQUAL;
       break;
     case STATE_EXPECTING_EQUAL:
       if (c == '=')
         _parserState = STATE_EXPECTING_BODY;
       else
-        return;
+        return 0;
       break;
     case STATE_EXPECTING_BODY:
       if (c == '\r' || c == '\n')
@@ -134,8 +147,9 @@ void SDPHeaderList::parse(const char* rawHeader)
           if (c == _exitName)
           {
             _isValid = true;
-            _tail = std::string(parserData);
-            return;
+            if (storeTail)
+              _tail = std::string(parserData);
+            return parserData - rawHeader;
           }
         }
       }
@@ -151,6 +165,7 @@ void SDPHeaderList::parse(const char* rawHeader)
     push_back(SDPHeader(name, value.c_str()));
 
   _isValid = true;
+  return 0;
 }
 
 
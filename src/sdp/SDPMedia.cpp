@@ -65,6 +65,20 @@ SDPMedia::SDPMedia(const char* rawHeader) :
   _exitName = 'm';
 }
 
+SDPMedia::SDPMedia(const char* rawHeader, std::size_t& tailOffset) :
+  SDPHeaderList(rawHeader, 'm', tailOffset),
+  _dataPort(0),
+  _controlPort(0),
+  _address(),
+  _payloads(),
+  _type(TYPE_NONE),
+  _ptime(0),
+  _direction(MEDIA_UNSET),
+  _profile(PROFILE_NONE)
+{
+  _exitName = 'm';
+}
+
 SDPMedia::SDPMedia(const SDPMedia& header) :
   SDPHeaderList(header)
 {
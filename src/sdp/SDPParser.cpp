@@ -0,0 +1,371 @@
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "GNU Lesser General Public License (LGPL)".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+
+
+#include <cstring>
+#include <strings.h>
+
+#include "OSS/SDP/SDPParser.h"
+
+
+namespace OSS {
+namespace SDP {
+
+
+const std::size_t SDPParser::npos = std::size_t(-1);
+
+static unsigned short span_to_port(const char* data, const SDPParser::Span& span)
+{
+  unsigned int port = 0;
+  for (std::size_t i = span.offset; i < span.end(); i++)
+  {
+    if (data[i] < '0' || data[i] > '9')
+      return 0;
+    port = port * 10 + (data[i] - '0');
+    if (port > 65535)
+      return 0;
+  }
+  return static_cast<unsigned short>(port);
+}
+
+SDPParser::Media::Media() :
+  type(SDPMedia::TYPE_NONE),
+  firstLine(0),
+  lastLine(0),
+  connectionLine(SDPParser::npos)
+{
+}
+
+SDPParser::SDPParser() :
+  _data(0),
+  _size(0),
+  _isValid(false),
+  _sessionLineCount(0),
+  _connectionLine(npos)
+{
+}
+
+SDPParser::SDPParser(const char* body, std::size_t size) :
+  _data(0),
+  _size(0),
+  _isValid(false),
+  _sessionLineCount(0),
+  _connectionLine(npos)
+{
+  parse(body, size);
+}
+
+SDPParser::SDPParser(const std::string& body) :
+  _body(body),
+  _data(0),
+  _size(0),
+  _isValid(false),
+  _sessionLineCount(0),
+  _connectionLine(npos)
+{
+  parse(_body.data(), _body.size());
+}
+
+void SDPParser::reset(const char* body, std::size_t size)
+{
+  _data = body;
+  _size = size;
+  _isValid = false;
+  _lines.clear();
+  _media.clear();
+  _sessionLineCount = 0;
+  _connectionLine = npos;
+  _address = Span();
+}
+
+bool SDPParser::parseAddress(const char* data, const Span& value, Span& address)
+{
+  //
+  // c=<nettype> <addrtype> <connection-address>.  Like SDPSession::getAddress
+  // the line is only accepted if it has exactly three tokens.
+  //
+  std::size_t tokens = 0;
+  std::size_t start = 0;
+  bool inToken = false;
+  for (std::size_t i = value.offset; i < value.end(); i++)
+  {
+    if (data[i] == ' ')
+    {
+      inToken = false;
+    }
+    else if (!inToken)
+    {
+      inToken = true;
+      start = i;
+      if (++tokens > 3)
+        return false;
+    }
+  }
+
+  if (tokens != 3)
+    return false;
+
+  address = Span(start, value.end() - start);
+  return true;
+}
+
+void SDPParser::parseMediaLine(const char* data, const Span& value, Media& media)
+{
+  //
+  // m=<media> <port>[/<number of ports>] <proto> <fmt> ...
+  //
+  const char* text = data + value.offset;
+  if (value.length >= 5 && ::strncasecmp(text, "audio", 5) == 0)
+    media.type = SDPMedia::TYPE_AUDIO;
+  else if (value.length >= 5 && ::strncasecmp(text, "video", 5) == 0)
+    media.type = SDPMedia::TYPE_VIDEO;
+  else if (value.length >= 5 && ::strncasecmp(text, "image", 5) == 0)
+    media.type = SDPMedia::TYPE_FAX;
+  else if (value.length >= 4 && ::strncasecmp(text, "data", 4) == 0)
+    media.type = SDPMedia::TYPE_DATA;
+
+  const char* space = static_cast<const char*>(::memchr(text, ' ', value.length));
+  if (!space)
+    return;
+
+  std::size_t start = space - data + 1;
+  std::size_t end = start;
+  while (end < value.end() && data[end] != ' ' && data[end] != '/')
+    end++;
+  media.port = Span(start, end - start);
+}
+
+bool SDPParser::parse(const char* body, std::size_t size)
+{
+  reset(body, size);
+
+  if (!body)
+    return false;
+
+  //
+  // A WebRTC offer carries one a=candidate line per ICE candidate so there
+  // are usually a few dozen lines per media description.  Guess the line
+  // count from the size to avoid repeated reallocation.
+  //
+  _lines.reserve(size / 32 + 1);
+
+  std::size_t offset = 0;
+  while (offset < size)
+  {
+    const char* newLine = static_cast<const char*>(::memchr(body + offset, '\n', size - offset));
+    std::size_t lineEnd = newLine ? newLine - body : size;
+    std::size_t next = newLine ? lineEnd + 1 : size;
+    std::size_t valueEnd = lineEnd;
+    if (valueEnd > offset && body[valueEnd - 1] == '\r')
+      valueEnd--;
+
+    if (valueEnd == offset)
+    {
+      //
+      // Skip blank lines
+      //
+      offset = next;
+      continue;
+    }
+
+    if (valueEnd - offset < 2 || body[offset + 1] != '=')
+    {
+      //
+      // Do not leave a partial index behind.  The last media description
+      // would not have its end set.
+      //
+      reset(body, size);
+      return false;
+    }
+
+    Line line;
+    line.name = body[offset];
+    line.line = Span(offset, next - offset);
+    line.value = Span(offset + 2, valueEnd - offset - 2);
+
+    std::size_t index = _lines.size();
+    _lines.push_back(line);
+
+    if (line.name == 'm')
+    {
+      if (!_media.empty())
+        _media.back().lastLine = index;
+      else
+        _sessionLineCount = index;
+
+      Media media;
+      media.firstLine = index;
+      parseMediaLine(body, line.value, media);
+      _media.push_back(media);
+    }
+    else if (line.name == 'c')
+    {
+      if (!_media.empty())
+      {
+        Media& media = _media.back();
+        if (media.connectionLine == npos)
+        {
+          media.connectionLine = index;
+          parseAddress(body, line.value, media.address);
+        }
+      }
+      else if (_connectionLine == npos)
+      {
+        _connectionLine = index;
+        parseAddress(body, line.value, _address);
+      }
+    }
+
+    offset = next;
+  }
+
+  if (_media.empty())
+    _sessionLineCount = _lines.size();
+  else
+    _media.back().lastLine = _lines.size();
+
+  _isValid = true;
+  return true;
+}
+
+std::string SDPParser::findHeader(char name) const
+{
+  for (std::size_t i = 0; i < _sessionLineCount; i++)
+  {
+    if (_lines[i].name == name)
+      return getString(_lines[i].value);
+  }
+  return "";
+}
+
+std::size_t SDPParser::getMediaCount(SDPMedia::Type type) const
+{
+  if (type == SDPMedia::TYPE_NONE)
+    return _media.size();
+
+  std::size_t count = 0;
+  for (MediaList::const_iterator iter = _media.begin(); iter != _media.end(); iter++)
+  {
+    if (iter->type == type)
+      count++;
+  }
+  return count;
+}
+
+const SDPParser::Media* SDPParser::getMedia(SDPMedia::Type type, std::size_t index) const
+{
+  for (MediaList::const_iterator iter = _media.begin(); iter != _media.end(); iter++)
+  {
+    if (iter->type == type && index-- == 0)
+      return &(*iter);
+  }
+  return 0;
+}
+
+unsigned short SDPParser::getDataPort(const Media& media) const
+{
+  return span_to_port(_data, media.port);
+}
+
+unsigned short SDPParser::getControlPort(const Media& media) const
+{
+  std::size_t line = findAttribute(media, "rtcp");
+  if (line != npos)
+  {
+    //
+    // a=rtcp:<port> [<nettype> <addrtype> <connection-address>]
+    //
+    const Span& value = _lines[line].value;
+    std::size_t start = value.offset + 5;
+    std::size_t end = start;
+    while (end < value.end() && _data[end] != ' ')
+      end++;
+    unsigned short port = span_to_port(_data, Span(start, end - start));
+    if (port)
+      return port;
+  }
+
+  unsigned short port = getDataPort(media);
+  return port ? port + 1 : 0;
+}
+
+std::size_t SDPParser::matchAttribute(const Line& line, const char* attribute, std::size_t len) const
+{
+  //
+  // Returns the length of the "attribute:" prefix if the line matches
+  //
+  if (line.name != 'a' || line.value.length <= len)
+    return 0;
+  const char* value = _data + line.value.offset;
+  if (value[len] != ':' || ::strncasecmp(value, attribute, len) != 0)
+    return 0;
+  return len + 1;
+}
+
+std::size_t SDPParser::findAttribute(const Media& media, const char* attribute) const
+{
+  std::size_t len = ::strlen(attribute);
+  for (std::size_t i = media.firstLine + 1; i < media.lastLine; i++)
+  {
+    if (matchAttribute(_lines[i], attribute, len))
+      return i;
+  }
+  return npos;
+}
+
+std::size_t SDPParser::findFlagAttribute(const Media& media, const char* flag) const
+{
+  std::size_t len = ::strlen(flag);
+  for (std::size_t i = media.firstLine + 1; i < media.lastLine; i++)
+  {
+    const Line& line = _lines[i];
+    if (line.name == 'a' && line.value.length == len && ::memcmp(_data + line.value.offset, flag, len) == 0)
+      return i;
+  }
+  return npos;
+}
+
+std::string SDPParser::getAttribute(const Media& media, const char* attribute) const
+{
+  std::size_t line = findAttribute(media, attribute);
+  if (line == npos)
+    return "";
+  std::size_t prefix = ::strlen(attribute) + 1;
+  const Span& value = _lines[line].value;
+  return getString(Span(value.offset + prefix, value.length - prefix));
+}
+
+std::size_t SDPParser::getAttributes(const Media& media, const char* attribute, Spans& values) const
+{
+  values.clear();
+  std::size_t len = ::strlen(attribute);
+  for (std::size_t i = media.firstLine + 1; i < media.lastLine; i++)
+  {
+    const Line& line = _lines[i];
+    std::size_t prefix = matchAttribute(line, attribute, len);
+    if (prefix)
+      values.push_back(Span(line.value.offset + prefix, line.value.length - prefix));
+  }
+  return values.size();
+}
+
+
+} } // OSS::SDP
+
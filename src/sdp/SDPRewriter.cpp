@@ -0,0 +1,214 @@
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "GNU Lesser General Public License (LGPL)".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+
+
+#include <algorithm>
+#include <sstream>
+
+#include "OSS/SDP/SDPRewriter.h"
+#include "OSS/UTL/CoreUtils.h"
+
+
+namespace OSS {
+namespace SDP {
+
+
+SDPRewriter::SDPRewriter(const SDPParser& parser) :
+  _parser(parser),
+  _lineEnd("\r\n")
+{
+  //
+  // Inserted lines follow the terminator already used by the body
+  //
+  const SDPParser::Lines& lines = _parser.getLines();
+  for (SDPParser::Lines::const_iterator iter = lines.begin(); iter != lines.end(); iter++)
+  {
+    if (iter->line.end() > iter->value.end())
+    {
+      _lineEnd.assign(_parser.data() + iter->value.end(), iter->line.end() - iter->value.end());
+      break;
+    }
+  }
+}
+
+void SDPRewriter::replace(const Span& span, const std::string& text)
+{
+  Patch patch;
+  patch.offset = span.offset;
+  patch.length = span.length;
+  patch.text = text;
+  patch.isLine = false;
+  _patches.push_back(patch);
+}
+
+void SDPRewriter::insert(std::size_t offset, const std::string& text)
+{
+  replace(Span(offset, 0), text);
+}
+
+void SDPRewriter::insertLine(std::size_t offset, char name, const std::string& value)
+{
+  Patch patch;
+  patch.offset = offset;
+  patch.length = 0;
+  patch.text.reserve(value.size() + 2 + _lineEnd.size());
+  patch.text.push_back(name);
+  patch.text.push_back('=');
+  patch.text += value;
+  patch.text += _lineEnd;
+  patch.isLine = true;
+  _patches.push_back(patch);
+}
+
+void SDPRewriter::replaceValue(std::size_t line, const std::string& value)
+{
+  replace(_parser.getLines()[line].value, value);
+}
+
+void SDPRewriter::removeLine(std::size_t line)
+{
+  replace(_parser.getLines()[line].line, "");
+}
+
+void SDPRewriter::changeAddress(const std::string& address, const char* version)
+{
+  std::ostringstream value;
+  value << "IN " << version << " " << address;
+
+  const SDPParser::Lines& lines = _parser.getLines();
+  for (std::size_t i = 0; i < _parser.getSessionLineCount(); i++)
+  {
+    if (lines[i].name == 'c')
+      replaceValue(i, value.str());
+  }
+}
+
+void SDPRewriter::internalSetAddress(const Media& media, const std::string& address, bool isV4)
+{
+  std::string value(isV4 ? "IN IP4 " : "IN IP6 ");
+  value += address;
+
+  if (media.connectionLine != SDPParser::npos)
+  {
+    replaceValue(media.connectionLine, value);
+    return;
+  }
+
+  //
+  // RFC 4566 orders the media level lines as m=, i=, c=
+  //
+  const SDPParser::Lines& lines = _parser.getLines();
+  std::size_t after = media.firstLine;
+  if (after + 1 < media.lastLine && lines[after + 1].name == 'i')
+    after++;
+  insertLine(lines[after].line.end(), 'c', value);
+}
+
+void SDPRewriter::setDataPort(const Media& media, unsigned short port)
+{
+  if (media.port.empty())
+    return;
+  replace(media.port, OSS::string_from_number<unsigned short>(port));
+}
+
+std::size_t SDPRewriter::endOfMedia(const Media& media) const
+{
+  return _parser.getLines()[media.lastLine - 1].line.end();
+}
+
+void SDPRewriter::setControlPort(const Media& media, unsigned short port)
+{
+  std::string value("rtcp:");
+  value += OSS::string_from_number<unsigned short>(port);
+
+  std::size_t line = _parser.findAttribute(media, "rtcp");
+  if (line != SDPParser::npos)
+    replaceValue(line, value);
+  else
+    insertLine(endOfMedia(media), 'a', value);
+}
+
+void SDPRewriter::setFlagAttribute(const Media& media, const char* flag)
+{
+  if (_parser.findFlagAttribute(media, flag) == SDPParser::npos)
+    insertLine(endOfMedia(media), 'a', flag);
+}
+
+void SDPRewriter::removeCommonAttribute(const Media& media, const char* attribute)
+{
+  std::size_t line = _parser.findAttribute(media, attribute);
+  if (line != SDPParser::npos)
+    removeLine(line);
+}
+
+bool SDPRewriter::comparePatch(const Patch& a, const Patch& b)
+{
+  //
+  // Insertions go before a replacement at the same offset.  Otherwise
+  // they would overlap a removed line and be dropped.
+  //
+  if (a.offset != b.offset)
+    return a.offset < b.offset;
+  return a.length == 0 && b.length != 0;
+}
+
+std::string SDPRewriter::apply() const
+{
+  const char* data = _parser.data();
+  std::size_t size = _parser.size();
+
+  if (_patches.empty())
+    return std::string(data, size);
+
+  //
+  // Patches are usually recorded in order.  stable_sort keeps the order
+  // of insertions made at the same offset.
+  //
+  Patches patches(_patches);
+  std::stable_sort(patches.begin(), patches.end(), SDPRewriter::comparePatch);
+
+  std::size_t reserve = size + _lineEnd.size();
+  for (Patches::const_iterator iter = patches.begin(); iter != patches.end(); iter++)
+    reserve += iter->text.size();
+
+  std::string result;
+  result.reserve(reserve);
+
+  std::size_t cursor = 0;
+  for (Patches::const_iterator iter = patches.begin(); iter != patches.end(); iter++)
+  {
+    if (iter->offset < cursor || iter->offset + iter->length > size)
+      continue;
+    result.append(data + cursor, iter->offset - cursor);
+    //
+    // The last line of the body may not have a terminator
+    //
+    if (iter->isLine && !result.empty() && result[result.size() - 1] != '\n')
+      result.append(_lineEnd);
+    result.append(iter->text);
+    cursor = iter->offset + iter->length;
+  }
+  result.append(data + cursor, size - cursor);
+  return result;
+}
+
+
+} } // OSS::SDP
+
@@ -46,19 +46,21 @@ SDPSession::SDPSession()
   _exitName = 'm';
 }
 
-SDPSession::SDPSession(const char* session) :
-  SDPHeaderList(session, 'm')
+SDPSession::SDPSession(const char* session)
 {
   _exitName = 'm';
 
-  if (!_tail.empty())
+  //
+  // Media descriptions are parsed in place.  Copying the tail for every
+  // media description is quadratic in the number of m= lines.
+  //
+  std::size_t offset = parse(session, false);
+  while (offset)
   {
-    while (!_tail.empty())
-    {
-      SDPMedia::Ptr media(new SDPMedia(_tail.c_str()));
-      _mediaDescriptions.push_back(media);
-      _tail = media->getTail();
-    }
+    std::size_t tailOffset = 0;
+    SDPMedia::Ptr media(new SDPMedia(session + offset, tailOffset));
+    _mediaDescriptions.push_back(media);
+    offset = tailOffset ? offset + tailOffset : 0;
   }
 }
 
@@ -23,6 +23,7 @@
 #include "OSS/SIP/SIPTransportService.h"
 #include "OSS/SIP/SIPException.h"
 #include "OSS/UTL/Logger.h"
+#include "OSS/Metrics/MetricsRegistry.h"
 
 namespace OSS {
 namespace SIP {
@@ -36,7 +37,8 @@ SIPFSMDispatch::SIPFSMDispatch() :
   _nict(this),
   _ist(this),
   _nist(this),
-  _istBlocker(60),
+  _istBlocker(60000),
+  _shedRequests(32000),
   _enableIctForking(false)
 {
 }
@@ -59,8 +61,15 @@ void SIPFSMDispatch::onReceivedMessage(SIPMessage::Ptr pMsg, SIPTransportSession
     return;
   }
 
+  static OSS::Metrics::Counter& received = OSS::Metrics::MetricsRegistry::instance().counter("sip.received");
+  static OSS::Metrics::Histogram& parseTime = OSS::Metrics::MetricsRegistry::instance().histogram("sip.parse.us");
+  static OSS::Metrics::Histogram& dispatchTime = OSS::Metrics::MetricsRegistry::instance().histogram("sip.dispatch.us");
+  received.increment();
+  OSS::Metrics::ScopedTimer dispatchTimer(dispatchTime);
+
   try
   {
+    OSS::Metrics::ScopedTimer parseTimer(parseTime);
     pMsg->parse();
   }
   catch(const OSS::Exception& e)
@@ -82,6 +91,15 @@ void SIPFSMDispatch::onReceivedMessage(SIPMessage::Ptr pMsg, SIPTransportSession
   SIPTransaction::Type transactionType = SIPTransaction::TYPE_UNKNOWN;
   if (pMsg->isRequest())
   {
+    if (_overload.isEnabled())
+    {
+      _overload.addFeedback(pMsg.get());
+      if (!admitRequest(pMsg, pTransport, id))
+      {
+        return;
+      }
+    }
+
     if (OSS::string_caseless_starts_with(pMsg->startLine(), "invite"))
     {
       transactionType = SIPTransaction::TYPE_IST;
@@ -199,6 +217,107 @@ void SIPFSMDispatch::onReceivedMessage(SIPMessage::Ptr pMsg, SIPTransportSession
   }
 }
 
+bool SIPFSMDispatch::admitRequest(const SIPMessage::Ptr& pMsg, const SIPTransportSession::Ptr& pTransport, const std::string& id)
+{
+  static OSS::Metrics::Counter& shed = OSS::Metrics::MetricsRegistry::instance().counter("sip.overload.shed");
+
+  const std::string& startLine = pMsg->startLine();
+  if (OSS::string_caseless_starts_with(startLine, "ack"))
+  {
+    //
+    // ACK for the 503 of a shed INVITE.  It shares the transaction id.
+    //
+    return !_shedRequests.has(id);
+  }
+
+  bool isInvite = OSS::string_caseless_starts_with(startLine, "invite");
+  if (!isInvite &&
+    !OSS::string_caseless_starts_with(startLine, "subscribe") &&
+    !OSS::string_caseless_starts_with(startLine, "refer"))
+  {
+    return true;
+  }
+
+  if (pMsg->isMidDialog())
+  {
+    return true;
+  }
+
+  if (_shedRequests.has(id))
+  {
+    //
+    // Retransmission of a request that was already shed
+    //
+    rejectRequest(pMsg, pTransport, id);
+    return false;
+  }
+
+  if (!_overload.isShedding())
+  {
+    return true;
+  }
+
+  //
+  // Retransmissions of admitted requests must still reach their transaction
+  //
+  SIPTransaction::Ptr trn = isInvite ? _ist.findTransaction(pMsg, pTransport, false) : _nist.findTransaction(pMsg, pTransport, false);
+  if (trn || _istBlocker.has(id) || _overload.admit())
+  {
+    return true;
+  }
+
+  shed.increment();
+  _shedRequests.insert(id);
+  OSS_LOG_DEBUG(pMsg->createContextId(true) << "Overload control shed request - " << startLine
+    << " Reduction: " << _overload.getReduction() << "%");
+  rejectRequest(pMsg, pTransport, id);
+  return false;
+}
+
+void SIPFSMDispatch::rejectRequest(const SIPMessage::Ptr& pMsg, const SIPTransportSession::Ptr& pTransport, const std::string& id)
+{
+  static OSS::Metrics::Counter& rejected = OSS::Metrics::MetricsRegistry::instance().counter("sip.overload.rejected");
+
+  if (_overload.getAction() == SIPOverloadControl::DROP)
+  {
+    return;
+  }
+
+  try
+  {
+    //
+    // The tag is derived from the transaction so a retransmission gets
+    // the same response
+    //
+    std::ostringstream tag;
+    tag << std::hex << boost::hash<std::string>()(id);
+    SIPMessage::Ptr pResponse = _overload.createRejectResponse(pMsg, tag.str());
+
+#if ENABLE_FEATURE_XOR
+    std::string isXOR;
+    if (pMsg->getProperty(OSS::PropertyMap::PROP_XOR, isXOR) && isXOR == "1")
+    {
+      pResponse->setProperty(OSS::PropertyMap::PROP_XOR, "1");
+    }
+#endif
+
+    if (pTransport->isReliableTransport())
+    {
+      pTransport->writeMessage(pResponse);
+    }
+    else
+    {
+      OSS::Net::IPAddress target = pTransport->getRemoteAddress();
+      pTransport->writeMessage(pResponse, target.toString(), OSS::string_from_number<unsigned short>(target.getPort()));
+    }
+    rejected.increment();
+  }
+  catch(const OSS::Exception& e)
+  {
+    OSS_LOG_WARNING(pMsg->createContextId(true) << "Unable to send overload response - " << e.message());
+  }
+}
+
 SIPTransaction::Ptr SIPFSMDispatch::createClientTransaction(const SIPMessage::Ptr& pRequest)
 {
   if (!pRequest->isRequest())
@@ -23,6 +23,7 @@
 #include "OSS/SIP/SIPTransaction.h"
 #include "OSS/SIP/SIPTransactionPool.h"
 #include "OSS/UTL/Logger.h"
+#include "OSS/Metrics/MetricsRegistry.h"
 
 
 namespace OSS {
@@ -288,5 +289,11 @@ void SIPFsm::handleDelayedTerminate()
   }
 }
 
+OSS::Metrics::Counter& SIPFsm::retransmissions()
+{
+  static OSS::Metrics::Counter& counter = OSS::Metrics::MetricsRegistry::instance().counter("sip.retransmissions");
+  return counter;
+}
+
 } } // OSS::SIP
 
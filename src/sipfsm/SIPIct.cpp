@@ -24,6 +24,7 @@
 #include "OSS/SIP/SIPRequestLine.h"
 #include "OSS/SIP/SIPFSMDispatch.h"
 #include "OSS/UTL/Logger.h"
+#include "OSS/Metrics/MetricsRegistry.h"
 
 namespace OSS {
 namespace SIP {
@@ -219,6 +220,7 @@ void SIPIct::handleRetransmitInvite()
       pTransaction->transport()->writeMessage(_pRequest,
       pTransaction->remoteAddress().toString(),
         OSS::string_from_number<unsigned short>(pTransaction->remoteAddress().getPort()));
+    retransmissions().increment();
     //
     // Restart Timer A with a compounded value
     //
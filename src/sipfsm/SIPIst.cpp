@@ -142,6 +142,10 @@ void SIPIst::onReceivedMessage(SIPMessage::Ptr pMsg, SIPTransportSession::Ptr pT
       pTransaction->setState(CONFIRMED);
       cancelTimerG();
       startTimerI();
+      //
+      // Retransmissions are absorbed in the CONFIRMED state
+      //
+      pTransaction->transport()->absorbRetransmissions();
     }
     else
     {
@@ -22,6 +22,7 @@
 #include "OSS/SIP/SIPTransaction.h"
 #include "OSS/SIP/SIPCSeq.h"
 #include "OSS/SIP/SIPFSMDispatch.h"
+#include "OSS/Metrics/MetricsRegistry.h"
 
 
 namespace OSS {
@@ -285,6 +286,7 @@ void SIPNict::handleRetransmitRequest()
       pTransaction->transport()->writeMessage(_pRequest,
         pTransaction->remoteAddress().toString(),
         OSS::string_from_number<unsigned short>(pTransaction->remoteAddress().getPort()));
+    retransmissions().increment();
     //
     // Restart Timer E with a compounded value
     //
@@ -0,0 +1,447 @@
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "GNU Lesser General Public License (LGPL)".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+
+#include <sstream>
+#include <iomanip>
+#include <boost/algorithm/string.hpp>
+#include "OSS/SIP/SIPOverloadControl.h"
+#include "OSS/UTL/CoreUtils.h"
+#include "OSS/Metrics/MetricsRegistry.h"
+
+
+namespace OSS {
+namespace SIP {
+
+
+static const char* REJECT_STATUS_LINE = "SIP/2.0 503 Service Unavailable\r\n";
+
+static std::size_t find_element_end(const std::string& via)
+{
+  //
+  // Via elements are separated by commas but oc-algo may hold a quoted
+  // list
+  //
+  bool quoted = false;
+  for (std::size_t i = 0; i < via.size(); i++)
+  {
+    if (via[i] == '"')
+    {
+      quoted = !quoted;
+    }
+    else if (via[i] == ',' && !quoted)
+    {
+      return i;
+    }
+  }
+  return via.size();
+}
+
+static void split_params(const std::string& via, std::string& head, std::vector<std::string>& params)
+{
+  std::size_t offset = via.find(';');
+  head = via.substr(0, offset);
+  while (offset != std::string::npos)
+  {
+    std::size_t next = via.find(';', offset + 1);
+    std::string param = via.substr(offset + 1, next == std::string::npos ? std::string::npos : next - offset - 1);
+    OSS::string_trim(param);
+    if (!param.empty())
+    {
+      params.push_back(param);
+    }
+    offset = next;
+  }
+}
+
+static std::string param_name(const std::string& param)
+{
+  std::string name = param.substr(0, param.find('='));
+  OSS::string_trim(name);
+  boost::to_lower(name);
+  return name;
+}
+
+SIPOverloadControl::SIPOverloadControl() :
+  _enabled(false),
+  _targetDelay(DEFAULT_TARGET_DELAY),
+  _interval((Time)DEFAULT_INTERVAL * 1000),
+  _action(REJECT),
+  _retryAfter(DEFAULT_RETRY_AFTER),
+  _maxReduction(DEFAULT_MAX_REDUCTION),
+  _feedbackEnabled(true),
+  _reduction(0),
+  _credit(0),
+  _intervalEnd(0),
+  _minDelay(0),
+  _maxDelay(0),
+  _hasDelay(false),
+  _saturated(false),
+  _sequence(OSS::getTime())
+{
+  formatTrailer();
+}
+
+SIPOverloadControl::Time SIPOverloadControl::now()
+{
+  return OSS::Metrics::Histogram::now();
+}
+
+void SIPOverloadControl::setEnabled(bool enabled)
+{
+  OSS::mutex_critic_sec_lock lock(_mutex);
+  _enabled = enabled;
+  _reduction = 0;
+  _credit = 0;
+  _intervalEnd = 0;
+}
+
+void SIPOverloadControl::setTargetDelay(Time delay)
+{
+  OSS::mutex_critic_sec_lock lock(_mutex);
+  _targetDelay = delay;
+}
+
+void SIPOverloadControl::setInterval(unsigned long interval)
+{
+  OSS::mutex_critic_sec_lock lock(_mutex);
+  _interval = (Time)(interval ? interval : 1) * 1000;
+}
+
+void SIPOverloadControl::setAction(Action action)
+{
+  OSS::mutex_critic_sec_lock lock(_mutex);
+  _action = action;
+}
+
+void SIPOverloadControl::setRetryAfter(unsigned int seconds)
+{
+  OSS::mutex_critic_sec_lock lock(_mutex);
+  _retryAfter = seconds;
+  formatTrailer();
+}
+
+void SIPOverloadControl::setMaxReduction(unsigned int percent)
+{
+  OSS::mutex_critic_sec_lock lock(_mutex);
+  _maxReduction = percent > 100 ? 100 : percent;
+  if (_reduction > _maxReduction)
+  {
+    _reduction = _maxReduction;
+  }
+}
+
+void SIPOverloadControl::setFeedbackEnabled(bool enabled)
+{
+  OSS::mutex_critic_sec_lock lock(_mutex);
+  _feedbackEnabled = enabled;
+}
+
+void SIPOverloadControl::formatTrailer()
+{
+  std::ostringstream trailer;
+  if (_retryAfter)
+  {
+    trailer << "Retry-After: " << _retryAfter << "\r\n";
+  }
+  trailer << "Content-Length: 0\r\n\r\n";
+  _trailer = trailer.str();
+}
+
+void SIPOverloadControl::reportQueueDelay(Time delay, Time now)
+{
+  OSS::mutex_critic_sec_lock lock(_mutex);
+  if (!_enabled)
+  {
+    return;
+  }
+  update(now);
+  if (!_hasDelay || delay < _minDelay)
+  {
+    _minDelay = delay;
+  }
+  if (!_hasDelay || delay > _maxDelay)
+  {
+    _maxDelay = delay;
+  }
+  _hasDelay = true;
+}
+
+void SIPOverloadControl::reportSaturation(Time now)
+{
+  OSS::mutex_critic_sec_lock lock(_mutex);
+  if (!_enabled)
+  {
+    return;
+  }
+  update(now);
+  _saturated = true;
+}
+
+bool SIPOverloadControl::admit(Time now)
+{
+  OSS::mutex_critic_sec_lock lock(_mutex);
+  if (!_enabled)
+  {
+    return true;
+  }
+  update(now);
+  _credit += _reduction;
+  if (_credit < 100)
+  {
+    return true;
+  }
+  _credit -= 100;
+  return false;
+}
+
+unsigned int SIPOverloadControl::getReduction() const
+{
+  OSS::mutex_critic_sec_lock lock(_mutex);
+  return _reduction;
+}
+
+bool SIPOverloadControl::isShedding() const
+{
+  OSS::mutex_critic_sec_lock lock(_mutex);
+  return _enabled && _reduction > 0;
+}
+
+void SIPOverloadControl::update(Time now)
+{
+  if (!_intervalEnd)
+  {
+    _intervalEnd = now + _interval;
+    return;
+  }
+
+  if (now < _intervalEnd)
+  {
+    return;
+  }
+
+  adjust(_hasDelay && (_minDelay > _targetDelay || (_saturated && _maxDelay > _targetDelay)));
+
+  //
+  // Intervals that went by without a single report had no queue
+  //
+  Time idle = (now - _intervalEnd) / _interval;
+  for (Time i = 0; i < idle && _reduction; i++)
+  {
+    adjust(false);
+  }
+
+  _intervalEnd = now + _interval;
+  _hasDelay = false;
+  _saturated = false;
+}
+
+void SIPOverloadControl::adjust(bool overloaded)
+{
+  static OSS::Metrics::Counter& overloadedIntervals = OSS::Metrics::MetricsRegistry::instance().counter("sip.overload.intervals");
+
+  unsigned int reduction = _reduction;
+  if (overloaded)
+  {
+    overloadedIntervals.increment();
+    reduction += REDUCTION_INCREASE;
+    if (reduction > _maxReduction)
+    {
+      reduction = _maxReduction;
+    }
+  }
+  else
+  {
+    reduction = reduction > REDUCTION_DECREASE ? reduction - REDUCTION_DECREASE : 0;
+  }
+
+  if (reduction != _reduction)
+  {
+    _reduction = reduction;
+    //
+    // oc-seq must grow with every change even if the wall clock did not
+    //
+    OSS::UInt64 sequence = OSS::getTime();
+    _sequence = sequence > _sequence ? sequence : _sequence + 1;
+  }
+}
+
+bool SIPOverloadControl::supportsFeedback(const std::string& via)
+{
+  std::string head;
+  std::vector<std::string> params;
+  split_params(via, head, params);
+
+  bool hasOc = false;
+  bool hasAlgo = false;
+  bool hasLoss = false;
+  for (std::vector<std::string>::const_iterator iter = params.begin(); iter != params.end(); iter++)
+  {
+    std::string name = param_name(*iter);
+    if (name == "oc")
+    {
+      hasOc = true;
+    }
+    else if (name == "oc-algo")
+    {
+      hasAlgo = true;
+      std::size_t offset = iter->find('=');
+      std::string algo = offset == std::string::npos ? std::string() : iter->substr(offset + 1);
+      boost::erase_all(algo, "\"");
+      std::vector<std::string> tokens;
+      boost::split(tokens, algo, boost::is_any_of(","));
+      for (std::vector<std::string>::iterator token = tokens.begin(); token != tokens.end(); token++)
+      {
+        OSS::string_trim(*token);
+        if (boost::iequals(*token, "loss"))
+        {
+          hasLoss = true;
+        }
+      }
+    }
+  }
+  return hasOc && (!hasAlgo || hasLoss);
+}
+
+bool SIPOverloadControl::addFeedback(std::string& via) const
+{
+  if (!supportsFeedback(via))
+  {
+    return false;
+  }
+
+  unsigned int reduction;
+  OSS::UInt64 sequence;
+  Time validity;
+  {
+    OSS::mutex_critic_sec_lock lock(_mutex);
+    if (!_enabled || !_feedbackEnabled)
+    {
+      return false;
+    }
+    reduction = _reduction;
+    sequence = _sequence;
+    validity = _interval / 1000 * 5;
+  }
+  if (validity < MIN_FEEDBACK_VALIDITY)
+  {
+    validity = MIN_FEEDBACK_VALIDITY;
+  }
+
+  std::string head;
+  std::vector<std::string> params;
+  split_params(via, head, params);
+
+  std::ostringstream strm;
+  strm << head;
+  for (std::vector<std::string>::const_iterator iter = params.begin(); iter != params.end(); iter++)
+  {
+    std::string name = param_name(*iter);
+    if (name != "oc" && name != "oc-algo" && name != "oc-validity" && name != "oc-seq")
+    {
+      strm << ";" << *iter;
+    }
+  }
+  strm << ";oc=" << reduction
+    << ";oc-algo=\"loss\""
+    << ";oc-validity=" << validity
+    << ";oc-seq=" << sequence / 1000 << "." << std::setw(3) << std::setfill('0') << sequence % 1000;
+  via = strm.str();
+  return true;
+}
+
+bool SIPOverloadControl::addFeedback(SIPMessage* pRequest) const
+{
+  {
+    OSS::mutex_critic_sec_lock lock(_mutex);
+    if (!_enabled || !_feedbackEnabled)
+    {
+      return false;
+    }
+  }
+  if (!pRequest->hdrPresent(OSS::SIP::HDR_VIA))
+  {
+    return false;
+  }
+
+  const std::string& hVia = pRequest->hdrGet(OSS::SIP::HDR_VIA, 0);
+  std::size_t end = find_element_end(hVia);
+  std::string via = hVia.substr(0, end);
+  if (boost::ifind_first(via, "oc").empty())
+  {
+    return false;
+  }
+
+  OSS::string_trim(via);
+  if (!addFeedback(via))
+  {
+    return false;
+  }
+  pRequest->hdrSet(OSS::SIP::HDR_VIA, via + hVia.substr(end), 0);
+  return true;
+}
+
+SIPMessage::Ptr SIPOverloadControl::createRejectResponse(const SIPMessage::Ptr& pRequest, const std::string& tag) const
+{
+  std::string response = REJECT_STATUS_LINE;
+
+  std::size_t vias = pRequest->hdrGetSize(OSS::SIP::HDR_VIA);
+  for (std::size_t i = 0; i < vias; i++)
+  {
+    response += OSS::SIP::HDR_VIA;
+    response += ": ";
+    response += pRequest->hdrGet(OSS::SIP::HDR_VIA, i);
+    response += "\r\n";
+  }
+
+  response += OSS::SIP::HDR_FROM;
+  response += ": ";
+  response += pRequest->hdrGet(OSS::SIP::HDR_FROM);
+  response += "\r\n";
+
+  response += OSS::SIP::HDR_TO;
+  response += ": ";
+  response += pRequest->hdrGet(OSS::SIP::HDR_TO);
+  if (!tag.empty())
+  {
+    response += ";tag=";
+    response += tag;
+  }
+  response += "\r\n";
+
+  response += OSS::SIP::HDR_CALL_ID;
+  response += ": ";
+  response += pRequest->hdrGet(OSS::SIP::HDR_CALL_ID);
+  response += "\r\n";
+
+  response += OSS::SIP::HDR_CSEQ;
+  response += ": ";
+  response += pRequest->hdrGet(OSS::SIP::HDR_CSEQ);
+  response += "\r\n";
+
+  {
+    OSS::mutex_critic_sec_lock lock(_mutex);
+    response += _trailer;
+  }
+
+  return SIPMessage::Ptr(new SIPMessage(response));
+}
+
+
+} } // OSS::SIP
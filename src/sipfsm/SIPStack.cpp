@@ -946,6 +946,24 @@ void SIPStack::initTransportFromConfig(const boost::filesystem::path& cfgFile)
     }
   }
 
+  //
+  // Set the number of threads TLS connections run on.  0 keeps them on
+  // the transport thread.
+  //
+  if (listeners.exists("tls-handshake-threads"))
+  {
+    int tlsHandshakeThreads = listeners["tls-handshake-threads"];
+    if (tlsHandshakeThreads >= 0)
+    {
+      OSS_LOG_INFO("Setting TLS handshake threads to " << tlsHandshakeThreads);
+      transport().setTlsHandshakeThreads((std::size_t)tlsHandshakeThreads);
+    }
+    else
+    {
+      OSS_LOG_ERROR("Invalid TLS handshake thread count " << tlsHandshakeThreads << " Using default value.");
+    }
+  }
+
   //
   // Set the WS port range
   //
@@ -1072,6 +1090,34 @@ void SIPStack::initTransportFromConfig(const boost::filesystem::path& cfgFile)
     }
   }
 
+  if (listeners.exists("influxdb-host"))
+  {
+    std::string influx_host = (const char*)listeners["influxdb-host"];
+    int influx_port = 8089;
+    if (listeners.exists("influxdb-port"))
+    {
+      influx_port = (int)listeners["influxdb-port"];
+    }
+    bool influx_http = false;
+    if (listeners.exists("influxdb-http"))
+    {
+      influx_http = (bool)listeners["influxdb-http"];
+    }
+    std::string influx_database = "oss_core";
+    if (listeners.exists("influxdb-database"))
+    {
+      influx_database = (const char*)listeners["influxdb-database"];
+    }
+    int influx_interval = OSS::Metrics::InfluxExporter::DEFAULT_INTERVAL_MS;
+    if (listeners.exists("influxdb-interval"))
+    {
+      influx_interval = (int)listeners["influxdb-interval"];
+    }
+    _metricsExporter.start(influx_host, influx_port,
+      influx_http ? OSS::Metrics::InfluxExporter::HTTP : OSS::Metrics::InfluxExporter::UDP,
+      influx_database, influx_interval);
+  }
+
   transportInit();
 }
 
@@ -1395,6 +1441,24 @@ void SIPStack::initTransportFromJSON(const OSS::JSON::Object& json)
       OSS_LOG_ERROR("Unable to set TCP port base " << tcpPortBase.Value() << "-" << tcpPortMax.Value() << " Using default values.");
     }
   }
+
+  //
+  // Set the number of threads TLS connections run on.  0 keeps them on
+  // the transport thread.
+  //
+  if (json.Exists("tls_handshake_threads"))
+  {
+    JNum tlsHandshakeThreads = json["tls_handshake_threads"];
+    if (tlsHandshakeThreads.Value() >= 0)
+    {
+      OSS_LOG_INFO("Setting TLS handshake threads to " << tlsHandshakeThreads.Value());
+      transport().setTlsHandshakeThreads((std::size_t)tlsHandshakeThreads.Value());
+    }
+    else
+    {
+      OSS_LOG_ERROR("Invalid TLS handshake thread count " << tlsHandshakeThreads.Value() << " Using default value.");
+    }
+  }
   
   //
   // Set the WS port range
@@ -1524,6 +1588,38 @@ void SIPStack::initTransportFromJSON(const OSS::JSON::Object& json)
       SIPTransportService::enableHepCompression(homer_compression);
     }
   }
+
+  if (json.Exists("influxdb_host"))
+  {
+    JString host = json["influxdb_host"];
+    int influx_port = 8089;
+    if (json.Exists("influxdb_port"))
+    {
+      JNum port = json["influxdb_port"];
+      influx_port = port.Value();
+    }
+    bool influx_http = false;
+    if (json.Exists("influxdb_http"))
+    {
+      JBool http = json["influxdb_http"];
+      influx_http = http.Value();
+    }
+    std::string influx_database = "oss_core";
+    if (json.Exists("influxdb_database"))
+    {
+      JString database = json["influxdb_database"];
+      influx_database = database.Value();
+    }
+    int influx_interval = OSS::Metrics::InfluxExporter::DEFAULT_INTERVAL_MS;
+    if (json.Exists("influxdb_interval"))
+    {
+      JNum interval = json["influxdb_interval"];
+      influx_interval = interval.Value();
+    }
+    _metricsExporter.start(host.Value(), influx_port,
+      influx_http ? OSS::Metrics::InfluxExporter::HTTP : OSS::Metrics::InfluxExporter::UDP,
+      influx_database, influx_interval);
+  }
   
   transportInit();
 }
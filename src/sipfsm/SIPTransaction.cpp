@@ -36,6 +36,7 @@ namespace SIP {
 
 
 SIPTransaction::SIPTransaction():
+  OSS::PropertyMapObject(&_arena),
   _type(TYPE_UNKNOWN),
   _owner(0),
   _transportService(0),
@@ -53,6 +54,7 @@ SIPTransaction::SIPTransaction():
 }
 
 SIPTransaction::SIPTransaction(SIPTransaction::Ptr pParent) :
+  OSS::PropertyMapObject(&_arena),
   _type(pParent->getType()),
   _owner(0),
   _transportService(0),
@@ -78,12 +80,20 @@ SIPTransaction::SIPTransaction(SIPTransaction::Ptr pParent) :
 	
 SIPTransaction::~SIPTransaction()
 {
+  //
+  // Properties live in the arena which is destroyed before the
+  // PropertyMapObject base.  Clear them while the arena is still valid.
+  //
+  clearProperties();
+  OSS::UTL::MemoryArena::Stats stats = _arena.getStats();
   std::ostringstream logMsg;
-  logMsg << _logId << getTypeString() << " " << _id << " isParent=" << (isParent() ? "Yes" : "No") << " DESTROYED";
+  logMsg << _logId << getTypeString() << " " << _id << " isParent=" << (isParent() ? "Yes" : "No") << " DESTROYED"
+    << " arena-allocations: " << stats.allocations << " arena-bytes: " << stats.bytesAllocated << " heap-chunks: " << stats.heapAllocations;
   OSS::log_debug(logMsg.str());
 }
 
 SIPTransaction::SIPTransaction(const SIPTransaction&) :
+  OSS::PropertyMapObject(&_arena),
   _type(TYPE_UNKNOWN),
   _owner(0),
   _transportService(0),
@@ -622,6 +632,14 @@ void SIPTransaction::terminate()
 
   _hasTerminated = true;
 
+  //
+  // The transport stops answering retransmissions of the request
+  //
+  if (_transport && (_type == TYPE_IST || _type == TYPE_NIST))
+  {
+    _transport->releaseRetransmissions();
+  }
+
   if (isParent())
   {
     OSS_LOG_INFO(_logId << getTypeString() << " " << getId() << " (parent) TERMINATED - child(ren) " << getActiveBranchCount());
@@ -21,12 +21,19 @@
 #include "OSS/SIP/SIPTransactionPool.h"
 #include "OSS/SIP/SIPFSMDispatch.h"
 #include "OSS/SIP/SIPTransportService.h"
+#include "OSS/Metrics/MetricsRegistry.h"
 
 
 namespace OSS {
 namespace SIP {
 
 
+static OSS::Metrics::Gauge& live_transactions()
+{
+  static OSS::Metrics::Gauge& gauge = OSS::Metrics::MetricsRegistry::instance().gauge("sip.transactions");
+  return gauge;
+}
+
 SIPTransactionPool::SIPTransactionPool(SIPFSMDispatch* dispatch):
   _ioService(dispatch->transport().ioService()),
   _houseKeepingTimer(_ioService, boost::posix_time::seconds(0)),
@@ -85,6 +92,7 @@ SIPTransaction::Ptr SIPTransactionPool::findTransaction(const std::string& id, b
   onAttachFSM(trn);
   trn->setId(id);
   _transactionPool.insert(std::pair<std::string, SIPTransaction::Ptr>(id, trn));
+  live_transactions().increment();
   return trn;
 }
 
@@ -96,6 +104,7 @@ bool SIPTransactionPool::removeTransaction(const std::string &id)
   if (iter == _transactionPool.end())
     return false;
   _transactionPool.erase(id);
+  live_transactions().decrement();
   return true;
 }
 
@@ -117,6 +126,7 @@ void SIPTransactionPool::stop()
     pTrn->setState(SIPTransaction::TRN_STATE_TERMINATED);
     pTrn->fsm()->cancelAllTimers();
   }
+  live_transactions().add(-(OSS::Int64)_transactionPool.size());
   _transactionPool.clear();
   //_ioService.stop();
 }
@@ -19,6 +19,11 @@
 
 
 #include <vector>
+#include <cstring>
+#include <time.h>
+#include <openssl/rand.h>
+#include <openssl/sha.h>
+#include "Poco/MD5Engine.h"
 
 #include "OSS/SIP/SIPDigestAuth.h"
 #include "OSS/SIP/SIPParser.h"
@@ -29,6 +34,182 @@ namespace OSS {
 namespace SIP {
 
 
+enum
+{
+  DIGEST_INPUT_STACK_SIZE = 512,
+  TIMED_NONCE_BUCKET_DIGITS = 8,
+  TIMED_NONCE_HMAC_BYTES = 16,
+  TIMED_NONCE_SIZE = TIMED_NONCE_BUCKET_DIGITS + TIMED_NONCE_HMAC_BYTES * 2
+};
+
+static const char HEX_DIGITS[] = "0123456789abcdef";
+
+static void hex_encode(const unsigned char* data, std::size_t len, char* out)
+{
+  for (std::size_t i = 0; i < len; i++)
+  {
+    out[i * 2] = HEX_DIGITS[data[i] >> 4];
+    out[i * 2 + 1] = HEX_DIGITS[data[i] & 0x0f];
+  }
+}
+
+class timed_nonce_mac
+  /// HMAC-SHA256 keyed with the secret key.  The inner and outer pad
+  /// states are hashed once when the key is set so a nonce costs two
+  /// SHA-256 blocks instead of a full HMAC setup.
+{
+public:
+  timed_nonce_mac()
+  {
+    //
+    // Random until setSecretKey() is called.  A restart invalidates the
+    // nonces in flight which only costs clients a stale challenge.
+    //
+    unsigned char bytes[32];
+    if (RAND_bytes(bytes, sizeof(bytes)) == 1)
+      setKey(std::string((const char*)bytes, sizeof(bytes)));
+    else
+      setKey(MD5_NONCE_KEY);
+  }
+
+  void setKey(const std::string& key)
+  {
+    unsigned char block[SHA256_CBLOCK];
+    memset(block, 0, sizeof(block));
+    if (key.size() > sizeof(block))
+      SHA256((const unsigned char*)key.data(), key.size(), block);
+    else
+      memcpy(block, key.data(), key.size());
+
+    unsigned char pad[SHA256_CBLOCK];
+    for (std::size_t i = 0; i < sizeof(block); i++)
+      pad[i] = block[i] ^ 0x36;
+    SHA256_Init(&_inner);
+    SHA256_Update(&_inner, pad, sizeof(pad));
+    for (std::size_t i = 0; i < sizeof(block); i++)
+      pad[i] = block[i] ^ 0x5c;
+    SHA256_Init(&_outer);
+    SHA256_Update(&_outer, pad, sizeof(pad));
+  }
+
+  void sign(const char* data, std::size_t len, unsigned char* mac) const
+  {
+    SHA256_CTX ctx = _inner;
+    SHA256_Update(&ctx, data, len);
+    SHA256_Final(mac, &ctx);
+    ctx = _outer;
+    SHA256_Update(&ctx, mac, SHA256_DIGEST_LENGTH);
+    SHA256_Final(mac, &ctx);
+  }
+
+private:
+  SHA256_CTX _inner;
+  SHA256_CTX _outer;
+};
+
+static timed_nonce_mac& timed_nonce_key()
+{
+  static timed_nonce_mac mac;
+  return mac;
+}
+
+class digest_input
+  /// Assembles the colon separated input of a digest hash on the stack.
+  /// Falls back to the heap for unusually long inputs.
+{
+public:
+  digest_input() : _size(0), _onHeap(false)
+  {
+  }
+
+  digest_input& operator << (const std::string& value)
+  {
+    append(value.data(), value.size());
+    return *this;
+  }
+
+  digest_input& operator << (const char* value)
+  {
+    append(value, strlen(value));
+    return *this;
+  }
+
+  digest_input& quoted(const std::string& value)
+    /// Appends the value without surrounding white space and quotes
+    /// the same way SIPParser::unquoteString() does
+  {
+    const char* begin = value.data();
+    const char* end = begin + value.size();
+    while (begin < end && isspace((unsigned char)*begin))
+      begin++;
+    while (end > begin && isspace((unsigned char)*(end - 1)))
+      end--;
+    if (end - begin >= 2 && *begin == '"' && *(end - 1) == '"')
+    {
+      begin++;
+      end--;
+    }
+    append(begin, end - begin);
+    return *this;
+  }
+
+  const char* data() const
+  {
+    return _onHeap ? _heap.data() : _stack;
+  }
+
+  std::size_t size() const
+  {
+    return _size;
+  }
+
+  std::string md5() const
+  {
+    OSS_VERIFY(_size != 0);
+    Poco::MD5Engine engine;
+    engine.update(data(), _size);
+    const Poco::DigestEngine::Digest& digest = engine.digest();
+    char hex[32];
+    hex_encode(&digest[0], digest.size() < 16 ? digest.size() : 16, hex);
+    return std::string(hex, sizeof(hex));
+  }
+
+private:
+  void append(const char* data, std::size_t len)
+  {
+    if (!_onHeap && _size + len > sizeof(_stack))
+    {
+      _heap.assign(_stack, _size);
+      _onHeap = true;
+    }
+    if (_onHeap)
+      _heap.append(data, len);
+    else
+      memcpy(_stack + _size, data, len);
+    _size += len;
+  }
+
+  char _stack[DIGEST_INPUT_STACK_SIZE];
+  std::size_t _size;
+  bool _onHeap;
+  std::string _heap;
+};
+
+static void timed_nonce_hmac(OSS::UInt32 bucket, const std::string& key, char* out)
+{
+  char bucketHex[TIMED_NONCE_BUCKET_DIGITS + 1];
+  snprintf(bucketHex, sizeof(bucketHex), "%08x", bucket);
+
+  digest_input input;
+  input << bucketHex << ":" << key;
+
+  unsigned char mac[SHA256_DIGEST_LENGTH];
+  timed_nonce_key().sign(input.data(), input.size(), mac);
+
+  memcpy(out, bucketHex, TIMED_NONCE_BUCKET_DIGITS);
+  hex_encode(mac, TIMED_NONCE_HMAC_BYTES, out + TIMED_NONCE_BUCKET_DIGITS);
+}
+
 SIPDigestAuth::SIPDigestAuth()
 {
 }
@@ -40,6 +221,7 @@ SIPDigestAuth::~SIPDigestAuth()
 void SIPDigestAuth::setSecretKey(const std::string& key)
 {
   MD5_NONCE_KEY = key;
+  timed_nonce_key().setKey(key);
 }
 
 std::string SIPDigestAuth::digestCreateA1Hash(
@@ -47,38 +229,34 @@ std::string SIPDigestAuth::digestCreateA1Hash(
   const std::string& password,
   const std::string& realm)
 {
-  std::string userName_ = userName;
-  std::string realm_ = realm;
-  SIPParser::unquoteString(userName_);
-  SIPParser::unquoteString(realm_);
-  std::ostringstream input;
-  input << userName_ << ":" << realm_ << ":" << password;
-  return OSS::string_md5_hash(input.str().c_str());
+  digest_input input;
+  input.quoted(userName) << ":";
+  input.quoted(realm) << ":" << password;
+  return input.md5();
 }
     /// Create an A1 MD5 Hash
 
 std::string SIPDigestAuth::digestCreateA2Hash(const std::string& uri, const char* method)
 {
-  std::ostringstream input;
+  digest_input input;
   input << method << ":" << uri;
-  return OSS::string_md5_hash(input.str().c_str());
+  return input.md5();
 }
 
 std::string SIPDigestAuth::digestCreateNonce(const std::string& key)
 {
-  std::ostringstream input;
+  digest_input input;
   input << MD5_NONCE_KEY << ":" << key;
-  return OSS::string_md5_hash(input.str().c_str());
+  return input.md5();
 }
 
 std::string SIPDigestAuth::digestCreateAuthorization(const std::string& a1,
     const std::string& nonce, const std::string& a2)
 {
-  std::string nonce_ = nonce;
-  SIPParser::unquoteString(nonce_);
-  std::ostringstream input;
-  input << a1 << ":" << nonce_ << ":" << a2;
-  return OSS::string_md5_hash(input.str().c_str());
+  digest_input input;
+  input << a1 << ":";
+  input.quoted(nonce) << ":" << a2;
+  return input.md5();
 }
 
 std::string SIPDigestAuth::digestCreateAuthorizationQop(
@@ -89,22 +267,137 @@ std::string SIPDigestAuth::digestCreateAuthorizationQop(
   const std::string& qop,
   const std::string& a2)
 {
-  std::string nonce_ = nonce;
-  std::string cnonce_ = cnonce;
-  std::string qop_ = qop;
-  SIPParser::unquoteString(nonce_);
-  SIPParser::unquoteString(cnonce_);
-  SIPParser::unquoteString(qop_);
+  digest_input input;
+  input << a1 << ":";
+  input.quoted(nonce) << ":" << nonceCount << ":";
+  input.quoted(cnonce) << ":";
+  input.quoted(qop) << ":" << a2;
+  return input.md5();
+}
+
+std::string SIPDigestAuth::digestCreateTimedNonce(const std::string& key)
+{
+  char nonce[TIMED_NONCE_SIZE];
+  timed_nonce_hmac((OSS::UInt32)(time(0) / NONCE_BUCKET_SECONDS), key, nonce);
+  return std::string(nonce, sizeof(nonce));
+}
+
+bool SIPDigestAuth::digestVerifyTimedNonce(const std::string& nonce, const std::string& key,
+  unsigned int lifetime, bool* stale)
+{
+  if (stale)
+    *stale = false;
+
+  std::string value = nonce;
+  SIPParser::unquoteString(value);
+  if (value.size() != TIMED_NONCE_SIZE)
+    return false;
+
+  OSS::UInt32 bucket = 0;
+  for (std::size_t i = 0; i < TIMED_NONCE_BUCKET_DIGITS; i++)
+  {
+    const char* digit = strchr(HEX_DIGITS, value[i]);
+    if (!digit || !*digit)
+      return false;
+    bucket = (bucket << 4) | (OSS::UInt32)(digit - HEX_DIGITS);
+  }
+
+  char expected[TIMED_NONCE_SIZE];
+  timed_nonce_hmac(bucket, key, expected);
+
+  //
+  // Constant time compare so the HMAC can not be guessed byte by byte
+  //
+  unsigned char diff = 0;
+  for (std::size_t i = 0; i < TIMED_NONCE_SIZE; i++)
+    diff |= (unsigned char)(expected[i] ^ value[i]);
+  if (diff)
+    return false;
+
+  OSS::UInt32 now = (OSS::UInt32)(time(0) / NONCE_BUCKET_SECONDS);
+  if (bucket > now + 1)
+    return false;
+  if (bucket < now && (OSS::UInt64)(now - bucket) * NONCE_BUCKET_SECONDS > lifetime)
+  {
+    if (stale)
+      *stale = true;
+    return false;
+  }
+  return true;
+}
+
+SIPDigestNonceCounter::SIPDigestNonceCounter(unsigned int lifetime) :
+  _lifetime((OSS::UInt64)lifetime * 1000),
+  _rotated(OSS::getTime())
+{
+}
+
+bool SIPDigestNonceCounter::accept(const std::string& nonce, const std::string& user, OSS::UInt32 nonceCount)
+{
+  if (!nonceCount)
+    return false;
+
+  std::string id = nonce + ":" + user;
+  OSS::UInt64 now = OSS::getTime();
+
+  OSS::mutex_critic_sec_lock lock(_mutex);
+  if (now - _rotated >= _lifetime)
+  {
+    _previous.swap(_current);
+    _current.clear();
+    _rotated = now;
+  }
 
-  std::ostringstream input;
-  input << a1 << ":"
-          << nonce_ << ":"
-          << nonceCount << ":"
-          << cnonce_ << ":"
-          << qop_ << ":"
-          << a2;
+  Windows::iterator iter = _current.find(id);
+  if (iter == _current.end())
+  {
+    Window window;
+    window.highest = nonceCount;
+    window.mask = 1;
+    Windows::iterator previous = _previous.find(id);
+    if (previous != _previous.end())
+    {
+      window = previous->second;
+      _previous.erase(previous);
+    }
+    else
+    {
+      _current[id] = window;
+      return true;
+    }
+    iter = _current.insert(Windows::value_type(id, window)).first;
+  }
 
-  return OSS::string_md5_hash(input.str().c_str());
+  Window& window = iter->second;
+  if (nonceCount > window.highest)
+  {
+    OSS::UInt32 shift = nonceCount - window.highest;
+    window.mask = shift >= WINDOW_SIZE ? 0 : window.mask << shift;
+    window.mask |= 1;
+    window.highest = nonceCount;
+    return true;
+  }
+
+  OSS::UInt32 age = window.highest - nonceCount;
+  if (age >= WINDOW_SIZE)
+    return false;
+  OSS::UInt64 bit = (OSS::UInt64)1 << age;
+  if (window.mask & bit)
+    return false;
+  window.mask |= bit;
+  return true;
+}
+
+void SIPDigestNonceCounter::setLifetime(unsigned int lifetime)
+{
+  OSS::mutex_critic_sec_lock lock(_mutex);
+  _lifetime = (OSS::UInt64)lifetime * 1000;
+}
+
+std::size_t SIPDigestNonceCounter::size() const
+{
+  OSS::mutex_critic_sec_lock lock(_mutex);
+  return _current.size() + _previous.size();
 }
 
-} } // OSS::SIP
\ No newline at end of file
+} } // OSS::SIP
@@ -53,7 +53,8 @@ SIPMessage::SIPMessage() :
   _expectedBodyLen(0),
   _isResponse(boost::indeterminate),
   _isRequest(boost::indeterminate),
-  _userData(0)
+  _userData(0),
+  _receiveTime(0)
 {
   _idleBuffer.reserve(4);
 }
@@ -68,7 +69,8 @@ SIPMessage::SIPMessage(const std::string& packet) :
   _expectedBodyLen(0),
   _isResponse(boost::indeterminate),
   _isRequest(boost::indeterminate),
-  _userData(0)
+  _userData(0),
+  _receiveTime(0)
 {
   _data = packet;
   parse();
@@ -80,7 +82,8 @@ SIPMessage::SIPMessage(const unsigned char* packet, std::size_t len)  :
   _expectedBodyLen(0),
   _isResponse(boost::indeterminate),
   _isRequest(boost::indeterminate),
-  _userData(0)
+  _userData(0),
+  _receiveTime(0)
 {
   if (len)
   {
@@ -95,7 +98,8 @@ SIPMessage::SIPMessage(const char* packet, std::size_t len)  :
   _expectedBodyLen(0),
   _isResponse(boost::indeterminate),
   _isRequest(boost::indeterminate),
-  _userData(0)
+  _userData(0),
+  _receiveTime(0)
 {
   if (len)
   {
@@ -119,6 +123,7 @@ SIPMessage::SIPMessage(const SIPMessage& packet)
   _isResponse = packet._isResponse;
   _isRequest = packet._isRequest;
   _userData = packet._userData;
+  _receiveTime = packet._receiveTime;
   _logContext = packet._logContext;
   _consumeState = IDLE;
 }
@@ -137,6 +142,7 @@ void SIPMessage::swap(SIPMessage& packet)
   std::swap(_expectedBodyLen, packet._expectedBodyLen);
   std::swap(_isResponse, packet._isResponse);
   std::swap(_isRequest, packet._isRequest);
+  std::swap(_receiveTime, packet._receiveTime);
   std::swap(_logContext, packet._logContext);
 }
 
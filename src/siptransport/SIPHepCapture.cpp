@@ -0,0 +1,520 @@
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare 
+// derivative works of the Software, all subject to the 
+// "GNU Lesser General Public License (LGPL)".
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+
+#include <cstring>
+#include <cerrno>
+#include <climits>
+#include <sys/time.h>
+#include <sys/socket.h>
+#include <arpa/inet.h>
+#include <zlib.h>
+#include "OSS/SIP/SIPHepCapture.h"
+#include "OSS/UTL/Logger.h"
+
+extern "C"
+{
+  #include "OSS/SIP/core_hep.h"
+}
+
+
+namespace OSS {
+namespace SIP {
+
+
+static void copy_address(const boost::asio::ip::address& address, bool v4, OSS::UInt8* out)
+{
+  if (v4)
+  {
+    if (address.is_v4())
+    {
+      boost::asio::ip::address_v4::bytes_type bytes = address.to_v4().to_bytes();
+      std::memcpy(out, bytes.data(), bytes.size());
+    }
+    else if (address.to_v6().is_v4_mapped())
+    {
+      boost::asio::ip::address_v4::bytes_type bytes = address.to_v6().to_v4().to_bytes();
+      std::memcpy(out, bytes.data(), bytes.size());
+    }
+    else
+    {
+      std::memset(out, 0, 4);
+    }
+  }
+  else
+  {
+    boost::asio::ip::address_v6::bytes_type bytes = address.is_v6() ?
+      address.to_v6().to_bytes() : boost::asio::ip::address_v6::v4_mapped(address.to_v4()).to_bytes();
+    std::memcpy(out, bytes.data(), bytes.size());
+  }
+}
+
+SIPHepCapture::Stats::Stats() :
+  captured(0),
+  dropped(0),
+  sent(0),
+  sendErrors(0),
+  batches(0)
+{
+}
+
+SIPHepCapture::SIPHepCapture(std::size_t capacity) :
+  _slots(0),
+  _mask(0),
+  _enqueuePos(0),
+  _dequeuePos(0),
+  _dropped(0),
+  _sent(0),
+  _sendErrors(0),
+  _batches(0),
+  _version(3),
+  _captureId(0),
+  _compress(false),
+  _encoded(MAX_BATCH),
+  _zstream(0),
+  _ioService(),
+  _socket(_ioService),
+  _wake(0, INT_MAX),
+  _stopping(false),
+  _pThread(0)
+{
+  std::size_t size = 2;
+  while (size < capacity)
+    size <<= 1;
+  _mask = size - 1;
+  _slots = new Slot[size];
+  for (std::size_t i = 0; i < size; i++)
+    _slots[i].sequence.store(i, boost::memory_order_relaxed);
+}
+
+SIPHepCapture::~SIPHepCapture()
+{
+  stop();
+  delete [] _slots;
+  if (_zstream)
+  {
+    deflateEnd(static_cast<z_stream*>(_zstream));
+    delete static_cast<z_stream*>(_zstream);
+  }
+}
+
+void SIPHepCapture::setVersion(int version)
+{
+  _version = version;
+}
+
+void SIPHepCapture::setCaptureId(int captureId)
+{
+  _captureId = captureId;
+}
+
+void SIPHepCapture::setPassword(const std::string& password)
+{
+  _password = password;
+}
+
+void SIPHepCapture::setCompression(bool compress)
+{
+  _compress = compress;
+}
+
+void SIPHepCapture::setSender(const Sender& sender)
+{
+  _sender = sender;
+}
+
+bool SIPHepCapture::start(const std::string& host, const std::string& port)
+{
+  if (_pThread)
+    return true;
+
+  try
+  {
+    boost::asio::ip::udp::resolver resolver(_ioService);
+    boost::asio::ip::udp::resolver::query query(host, port);
+    _destination = *resolver.resolve(query);
+    if (!_socket.is_open())
+      _socket.open(_destination.protocol());
+  }
+  catch (const boost::system::system_error& e)
+  {
+    OSS_LOG_ERROR("SIPHepCapture::start - Unable to open capture socket to " << host << ":" << port << " - " << e.what());
+    return false;
+  }
+
+  _stopping = false;
+  _pThread = new boost::thread(boost::bind(&SIPHepCapture::run, this));
+  OSS_LOG_INFO("SIPHepCapture::start - Capturing to " << _destination.address().to_string() << ":" << _destination.port());
+  return true;
+}
+
+void SIPHepCapture::stop()
+{
+  if (!_pThread)
+    return;
+
+  _stopping = true;
+  _wake.set();
+  _pThread->join();
+  delete _pThread;
+  _pThread = 0;
+
+  boost::system::error_code ec;
+  _socket.close(ec);
+}
+
+void SIPHepCapture::run()
+{
+  while (!_stopping)
+  {
+    //
+    // Producers only signal once per MAX_BATCH packets.  A partial batch
+    // is picked up when the flush interval elapses.
+    //
+    if (flush() < MAX_BATCH)
+      _wake.tryWait(FLUSH_INTERVAL_MS);
+  }
+
+  while (flush() > 0);
+}
+
+bool SIPHepCapture::capture(OSS::Net::IPAddress::Protocol proto, const OSS::Net::IPAddress& srcAddress, const OSS::Net::IPAddress& dstAddress, const char* data, std::size_t len)
+{
+  Slot* pSlot = 0;
+  std::size_t pos = _enqueuePos.load(boost::memory_order_relaxed);
+  for (;;)
+  {
+    pSlot = &_slots[pos & _mask];
+    std::size_t sequence = pSlot->sequence.load(boost::memory_order_acquire);
+    intptr_t diff = (intptr_t)sequence - (intptr_t)pos;
+    if (diff == 0)
+    {
+      if (_enqueuePos.compare_exchange_weak(pos, pos + 1, boost::memory_order_relaxed))
+        break;
+    }
+    else if (diff < 0)
+    {
+      _dropped.fetch_add(1, boost::memory_order_relaxed);
+      return false;
+    }
+    else
+    {
+      pos = _enqueuePos.load(boost::memory_order_relaxed);
+    }
+  }
+
+  Packet& packet = pSlot->packet;
+  bool v4 = dstAddress.address().is_v4();
+  packet.family = v4 ? AF_INET : AF_INET6;
+  packet.proto = (proto == OSS::Net::IPAddress::UDP ? IPPROTO_UDP : IPPROTO_TCP);
+  copy_address(srcAddress.address(), v4, packet.srcAddr);
+  copy_address(dstAddress.address(), v4, packet.dstAddr);
+  packet.srcPort = srcAddress.getPort();
+  packet.dstPort = dstAddress.getPort();
+
+  timeval now;
+  gettimeofday(&now, 0);
+  packet.timeSec = now.tv_sec;
+  packet.timeUsec = now.tv_usec;
+
+  //
+  // assign() reuses the capacity left by the previous packet in this slot
+  //
+  packet.data.assign(data, len);
+
+  pSlot->sequence.store(pos + 1, boost::memory_order_release);
+
+  if ((pos & (MAX_BATCH - 1)) == MAX_BATCH - 1)
+    _wake.set();
+
+  return true;
+}
+
+std::size_t SIPHepCapture::flush()
+{
+  std::size_t count = 0;
+  bool compress = _compress && _version == 3;
+
+  while (count < MAX_BATCH)
+  {
+    std::size_t pos = _dequeuePos.load(boost::memory_order_relaxed);
+    Slot* pSlot = &_slots[pos & _mask];
+    std::size_t sequence = pSlot->sequence.load(boost::memory_order_acquire);
+    intptr_t diff = (intptr_t)sequence - (intptr_t)(pos + 1);
+    if (diff < 0)
+      break;
+    if (diff > 0 || !_dequeuePos.compare_exchange_weak(pos, pos + 1, boost::memory_order_relaxed))
+      continue;
+
+    const Packet& packet = pSlot->packet;
+    std::string& out = _encoded[count++];
+    if (_version == 3)
+    {
+      std::size_t zippedLen = 0;
+      if (compress && this->compress(packet.data, zippedLen))
+        encodeV3(packet, (const char*)&_zipped[0], zippedLen, true, out);
+      else
+        encodeV3(packet, packet.data.data(), packet.data.size(), false, out);
+    }
+    else
+    {
+      encodeV2(packet, out);
+    }
+
+    pSlot->sequence.store(pos + _mask + 1, boost::memory_order_release);
+  }
+
+  if (count)
+  {
+    send(count);
+    _batches.fetch_add(1, boost::memory_order_relaxed);
+  }
+  return count;
+}
+
+bool SIPHepCapture::compress(const std::string& data, std::size_t& zippedLen)
+{
+  //
+  // A single deflate state is reset between packets instead of paying
+  // for deflateInit() and its allocations on every compress() call.
+  //
+  z_stream* zs = static_cast<z_stream*>(_zstream);
+  if (!zs)
+  {
+    zs = new z_stream;
+    std::memset(zs, 0, sizeof(z_stream));
+    if (deflateInit(zs, Z_DEFAULT_COMPRESSION) != Z_OK)
+    {
+      delete zs;
+      return false;
+    }
+    _zstream = zs;
+  }
+  else if (deflateReset(zs) != Z_OK)
+  {
+    return false;
+  }
+
+  _zipped.resize(deflateBound(zs, data.size()));
+  zs->next_in = (Bytef*)data.data();
+  zs->avail_in = data.size();
+  zs->next_out = &_zipped[0];
+  zs->avail_out = _zipped.size();
+  if (deflate(zs, Z_FINISH) != Z_STREAM_END)
+    return false;
+  zippedLen = zs->total_out;
+  return true;
+}
+
+void SIPHepCapture::encodeV3(const Packet& packet, const char* payload, std::size_t len, bool zipped, std::string& out) const
+{
+  hep_generic_t hg;
+  std::memset(&hg, 0, sizeof(hg));
+  std::memcpy(hg.header.id, "\x48\x45\x50\x33", 4);
+
+  hg.ip_family.chunk.type_id = htons(0x0001);
+  hg.ip_family.chunk.length = htons(sizeof(hg.ip_family));
+  hg.ip_family.data = packet.family;
+
+  hg.ip_proto.chunk.type_id = htons(0x0002);
+  hg.ip_proto.chunk.length = htons(sizeof(hg.ip_proto));
+  hg.ip_proto.data = packet.proto;
+
+  hg.src_port.chunk.type_id = htons(0x0007);
+  hg.src_port.chunk.length = htons(sizeof(hg.src_port));
+  hg.src_port.data = htons(packet.srcPort);
+
+  hg.dst_port.chunk.type_id = htons(0x0008);
+  hg.dst_port.chunk.length = htons(sizeof(hg.dst_port));
+  hg.dst_port.data = htons(packet.dstPort);
+
+  hg.time_sec.chunk.type_id = htons(0x0009);
+  hg.time_sec.chunk.length = htons(sizeof(hg.time_sec));
+  hg.time_sec.data = htonl(packet.timeSec);
+
+  hg.time_usec.chunk.type_id = htons(0x000a);
+  hg.time_usec.chunk.length = htons(sizeof(hg.time_usec));
+  hg.time_usec.data = htonl(packet.timeUsec);
+
+  hg.proto_t.chunk.type_id = htons(0x000b);
+  hg.proto_t.chunk.length = htons(sizeof(hg.proto_t));
+  hg.proto_t.data = 0x01; // SIP
+
+  hg.capt_id.chunk.type_id = htons(0x000c);
+  hg.capt_id.chunk.length = htons(sizeof(hg.capt_id));
+  hg.capt_id.data = htonl(_captureId);
+
+  std::size_t iplen = packet.family == AF_INET ? 2 * sizeof(hep_chunk_ip4_t) : 2 * sizeof(hep_chunk_ip6_t);
+  std::size_t tlen = sizeof(hg) + iplen + sizeof(hep_chunk_t) + len;
+  if (!_password.empty())
+    tlen += sizeof(hep_chunk_t) + _password.size();
+  hg.header.length = htons(tlen);
+
+  out.clear();
+  out.append((const char*)&hg, sizeof(hg));
+
+  if (packet.family == AF_INET)
+  {
+    hep_chunk_ip4_t ip;
+    ip.chunk.vendor_id = 0;
+    ip.chunk.length = htons(sizeof(ip));
+    ip.chunk.type_id = htons(0x0003);
+    std::memcpy(&ip.data, packet.srcAddr, sizeof(ip.data));
+    out.append((const char*)&ip, sizeof(ip));
+    ip.chunk.type_id = htons(0x0004);
+    std::memcpy(&ip.data, packet.dstAddr, sizeof(ip.data));
+    out.append((const char*)&ip, sizeof(ip));
+  }
+  else
+  {
+    hep_chunk_ip6_t ip;
+    ip.chunk.vendor_id = 0;
+    ip.chunk.length = htons(sizeof(ip));
+    ip.chunk.type_id = htons(0x0005);
+    std::memcpy(&ip.data, packet.srcAddr, sizeof(ip.data));
+    out.append((const char*)&ip, sizeof(ip));
+    ip.chunk.type_id = htons(0x0006);
+    std::memcpy(&ip.data, packet.dstAddr, sizeof(ip.data));
+    out.append((const char*)&ip, sizeof(ip));
+  }
+
+  if (!_password.empty())
+  {
+    hep_chunk_t auth;
+    auth.vendor_id = 0;
+    auth.type_id = htons(0x000e);
+    auth.length = htons(sizeof(auth) + _password.size());
+    out.append((const char*)&auth, sizeof(auth));
+    out.append(_password);
+  }
+
+  hep_chunk_t chunk;
+  chunk.vendor_id = 0;
+  chunk.type_id = zipped ? htons(0x0010) : htons(0x000f);
+  chunk.length = htons(sizeof(chunk) + len);
+  out.append((const char*)&chunk, sizeof(chunk));
+  out.append(payload, len);
+}
+
+void SIPHepCapture::encodeV2(const Packet& packet, std::string& out) const
+{
+  struct hep_hdr hdr;
+  hdr.hp_v = 2;
+  hdr.hp_f = packet.family;
+  hdr.hp_p = packet.proto;
+  hdr.hp_sport = htons(packet.srcPort);
+  hdr.hp_dport = htons(packet.dstPort);
+  hdr.hp_l = sizeof(hdr) + (packet.family == AF_INET ? sizeof(struct hep_iphdr) : sizeof(struct hep_ip6hdr));
+
+  struct hep_timehdr time;
+  std::memset(&time, 0, sizeof(time));
+  time.tv_sec = packet.timeSec;
+  time.tv_usec = packet.timeUsec;
+  time.captid = _captureId;
+
+  out.clear();
+  out.append((const char*)&hdr, sizeof(hdr));
+  if (packet.family == AF_INET)
+  {
+    struct hep_iphdr ip;
+    std::memcpy(&ip.hp_src, packet.srcAddr, sizeof(ip.hp_src));
+    std::memcpy(&ip.hp_dst, packet.dstAddr, sizeof(ip.hp_dst));
+    out.append((const char*)&ip, sizeof(ip));
+  }
+  else
+  {
+    struct hep_ip6hdr ip;
+    std::memcpy(&ip.hp6_src, packet.srcAddr, sizeof(ip.hp6_src));
+    std::memcpy(&ip.hp6_dst, packet.dstAddr, sizeof(ip.hp6_dst));
+    out.append((const char*)&ip, sizeof(ip));
+  }
+  out.append((const char*)&time, sizeof(time));
+  out.append(packet.data);
+}
+
+void SIPHepCapture::send(std::size_t count)
+{
+  if (_sender)
+  {
+    for (std::size_t i = 0; i < count; i++)
+      _sender((void*)_encoded[i].data(), _encoded[i].size());
+    _sent.fetch_add(count, boost::memory_order_relaxed);
+    return;
+  }
+
+  if (!_socket.is_open())
+  {
+    _sendErrors.fetch_add(count, boost::memory_order_relaxed);
+    return;
+  }
+
+  std::size_t sent = 0;
+#if OSS_OS == OSS_OS_LINUX
+  struct mmsghdr msgs[MAX_BATCH];
+  struct iovec iov[MAX_BATCH];
+  std::memset(msgs, 0, sizeof(struct mmsghdr) * count);
+  for (std::size_t i = 0; i < count; i++)
+  {
+    iov[i].iov_base = (void*)_encoded[i].data();
+    iov[i].iov_len = _encoded[i].size();
+    msgs[i].msg_hdr.msg_name = _destination.data();
+    msgs[i].msg_hdr.msg_namelen = _destination.size();
+    msgs[i].msg_hdr.msg_iov = &iov[i];
+    msgs[i].msg_hdr.msg_iovlen = 1;
+  }
+
+  while (sent < count)
+  {
+    int ret = sendmmsg(_socket.native_handle(), msgs + sent, count - sent, 0);
+    if (ret < 0)
+    {
+      if (errno == EINTR)
+        continue;
+      break;
+    }
+    sent += ret;
+  }
+#else
+  for (std::size_t i = 0; i < count; i++)
+  {
+    boost::system::error_code ec;
+    _socket.send_to(boost::asio::buffer(_encoded[i]), _destination, 0, ec);
+    if (!ec)
+      sent++;
+  }
+#endif
+
+  _sent.fetch_add(sent, boost::memory_order_relaxed);
+  if (sent < count)
+    _sendErrors.fetch_add(count - sent, boost::memory_order_relaxed);
+}
+
+SIPHepCapture::Stats SIPHepCapture::getStats() const
+{
+  Stats stats;
+  stats.captured = _enqueuePos.load(boost::memory_order_relaxed);
+  stats.dropped = _dropped.load(boost::memory_order_relaxed);
+  stats.sent = _sent.load(boost::memory_order_relaxed);
+  stats.sendErrors = _sendErrors.load(boost::memory_order_relaxed);
+  stats.batches = _batches.load(boost::memory_order_relaxed);
+  return stats;
+}
+
+
+} } // OSS::SIP
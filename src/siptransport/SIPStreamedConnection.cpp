@@ -77,6 +77,7 @@ SIPStreamedConnection::SIPStreamedConnection(
     _pTlsContext(0),
     _deadline(ioService),
     _pTlsStream(0),
+    _pSessionCache(0),
     _resolver(ioService),
     _connectionManager(manager),
     _pDispatch(0),
@@ -93,13 +94,15 @@ SIPStreamedConnection::SIPStreamedConnection(
   boost::asio::io_service& ioService,
   boost::asio::ssl::context* pTlsContext,
   SIPStreamedConnectionManager& manager,
-  SIPListener* pListener) :
+  SIPListener* pListener,
+  OSS::Net::TlsSessionCache* pSessionCache) :
     SIPTransportSession(pListener),
     _ioService(ioService),
     _pTcpSocket(0),
     _pTlsContext(pTlsContext),
     _deadline(ioService),
     _pTlsStream(0),
+    _pSessionCache(pSessionCache),
     _resolver(ioService),
     _connectionManager(manager),
     _pDispatch(0),
@@ -130,6 +133,8 @@ SIPStreamedConnection::~SIPStreamedConnection()
     // _pTcpSocket is owned by _pTlsStream.
     // There is no need to delete it here
     //
+    if (_pSessionCache)
+      _pSessionCache->onDisconnect(_pTlsStream->native_handle());
     delete _pTlsStream;
     _pTlsStream = 0;
   }
@@ -591,6 +596,8 @@ void SIPStreamedConnection::handleConnect(const boost::system::error_code& e, bo
     }
     else
     {
+      if (_pSessionCache)
+        _pSessionCache->prepareClientSession(_pTlsStream->native_handle(), getRemoteAddress().toIpPortString());
       _pTlsStream->async_handshake(boost::asio::ssl::stream_base::client,
           boost::bind(&SIPStreamedConnection::handleClientHandshake, shared_from_this(),
             boost::asio::placeholders::error));
@@ -617,6 +624,9 @@ void SIPStreamedConnection::handleConnect(const boost::system::error_code& e, bo
 
 void SIPStreamedConnection::handleServerHandshake(const boost::system::error_code& e)
 {
+  if (_pSessionCache)
+    _pSessionCache->onHandshake(_pTlsStream->native_handle(), true, !e);
+
   if (!e)
   {
     //
@@ -653,6 +663,13 @@ void SIPStreamedConnection::handleServerHandshake(const boost::system::error_cod
 void SIPStreamedConnection::handleClientHandshake(const boost::system::error_code& e)
 {
   // this is only significant for TLS
+  if (_pSessionCache)
+  {
+    _pSessionCache->onHandshake(_pTlsStream->native_handle(), false, !e);
+    if (e)
+      _pSessionCache->removeClientSession(getRemoteAddress().toIpPortString());
+  }
+
   if (!e && _isClient)
   {
     assert(_pTlsStream);
@@ -39,7 +39,6 @@ SIPTLSListener::SIPTLSListener(
   _resolver(pTransportService->ioService()),
   _tlsContext(pTransportService->tlsServerContext()),
   _connectionManager(connectionManager),
-  _pNewConnection(new SIPStreamedConnection(pTransportService->ioService(), &_tlsContext, _connectionManager, this)),
   _dispatch(dispatch)
 {
 }
@@ -63,6 +62,11 @@ void SIPTLSListener::run()
       _acceptor.set_option(boost::asio::ip::tcp::acceptor::reuse_address(true));
       _acceptor.bind(endpoint);
       _acceptor.listen();
+      //
+      // Created here rather than in the constructor so the connection
+      // lands on the handshake pool, which is started before the listeners
+      //
+      _pNewConnection.reset(new SIPStreamedConnection(_pTransportService->tlsIoService(), &_tlsContext, _connectionManager, this, &_pTransportService->tlsSessionCache()));
       _acceptor.async_accept(dynamic_cast<SIPStreamedConnection*>(_pNewConnection.get())->socket().lowest_layer(),
           boost::bind(&SIPTLSListener::handleAccept, this,
             boost::asio::placeholders::error, (void*)0));
@@ -121,7 +125,7 @@ void SIPTLSListener::handleAccept(const boost::system::error_code& e, OSS_HANDLE
     if (_acceptor.is_open())
     {
       OSS_LOG_DEBUG("SIPTLSListener::handleAccept RESTARTING async accept loop");
-      _pNewConnection.reset(new SIPStreamedConnection(*_pIoService, &_tlsContext, _connectionManager, this));
+      _pNewConnection.reset(new SIPStreamedConnection(_pTransportService->tlsIoService(), &_tlsContext, _connectionManager, this, &_pTransportService->tlsSessionCache()));
       _acceptor.async_accept(dynamic_cast<SIPStreamedConnection*>(_pNewConnection.get())->socket().lowest_layer(),
         boost::bind(&SIPTLSListener::handleAccept, this,
           boost::asio::placeholders::error, userData));
@@ -137,7 +141,7 @@ void SIPTLSListener::handleAccept(const boost::system::error_code& e, OSS_HANDLE
     if (_acceptor.is_open())
     {
       OSS_LOG_DEBUG("SIPTLSListener::handleAccept RESTARTING async accept loop");
-      _pNewConnection.reset(new SIPStreamedConnection(*_pIoService, &_tlsContext, _connectionManager, this));
+      _pNewConnection.reset(new SIPStreamedConnection(_pTransportService->tlsIoService(), &_tlsContext, _connectionManager, this, &_pTransportService->tlsSessionCache()));
       _acceptor.async_accept(dynamic_cast<SIPStreamedConnection*>(_pNewConnection.get())->socket().lowest_layer(),
         boost::bind(&SIPTLSListener::handleAccept, this,
           boost::asio::placeholders::error, userData));
@@ -25,11 +25,6 @@
 #include "OSS/SIP/SIPException.h"
 #include "OSS/UTL/Logger.h"
 
-extern "C"
-{
-  #include "OSS/SIP/core_hep.h"
-}
-
 
 namespace OSS {
 namespace SIP {
@@ -38,25 +33,17 @@ namespace SIP {
 SIPTransportService::HEPSenderCallback SIPTransportService::hepSenderCallback;
 bool SIPTransportService::_hepEnabled = false;
 bool SIPTransportService::_hepCompressionEnabled = false;
-SIPUDPConnection::Ptr SIPTransportService::_hepConnection;
 std::string SIPTransportService::_hepHost;
 std::string SIPTransportService::_hepPort;
 int SIPTransportService::_hepId = 0;
 int SIPTransportService::_hepVersion = 3;
 std::string SIPTransportService::_hepPassword;
-  
-static void hep_sender_callback(void* packet, int len)
-{
-  if (SIPTransportService::hepSenderCallback)
-  {
-    SIPTransportService::hepSenderCallback(packet, len);
-  }
-}
 
 SIPTransportService::SIPTransportService(const SIPTransportSession::Dispatch& dispatch):
   _ioService(),
   _pIoServiceThread(0),
   _resolver(_ioService),
+  _tlsHandshakeThreads(OSS::Net::TlsHandshakePool::DEFAULT_THREAD_COUNT),
   _dispatch(dispatch),
   _tcpConMgr(_dispatch),
   _tlsConMgr(_dispatch),
@@ -70,6 +57,7 @@ SIPTransportService::SIPTransportService(const SIPTransportSession::Dispatch& di
   _wssEnabled(true),
   _wsPortBase(10000),
   _wsPortMax(20000),
+  _wsThreads(SIPWebSocketListener::DEFAULT_THREAD_COUNT),
 #endif
   _udpEnabled(true),
   _tcpEnabled(true),
@@ -77,11 +65,6 @@ SIPTransportService::SIPTransportService(const SIPTransportSession::Dispatch& di
   _tcpPortBase(10000),
   _tcpPortMax(20000)
 {
-  if (!SIPTransportService::hepSenderCallback)
-  {
-    // send_hep_data = hep_sender_callback;
-    SIPTransportService::hepSenderCallback = boost::bind(SIPTransportService::hepSend, _1, _2);
-  }
 }
 
 SIPTransportService::~SIPTransportService()
@@ -111,11 +94,6 @@ void SIPTransportService::run()
     {
       iter->second->run();
       OSS_LOG_INFO("Started UDP Listener " << iter->first);
-      
-      if (!SIPTransportService::_hepConnection)
-      {
-        SIPTransportService::_hepConnection = iter->second->connection();
-      }
     }
   }
 
@@ -148,6 +126,13 @@ void SIPTransportService::run()
   }
 #endif
 
+  //
+  // Start the handshake pool before the TLS listeners so accepted
+  // connections are spread across it from the start
+  //
+  if (_tlsContext.isInitialized() && _tlsHandshakeThreads && !_tlsHandshakePool.isRunning())
+    _tlsHandshakePool.start(_tlsHandshakeThreads);
+
   for (TLSListeners::iterator iter = _tlsListeners.begin(); iter != _tlsListeners.end(); iter++)
   {
     if (!iter->second->isVirtual() && !iter->second->hasStarted())
@@ -380,6 +365,7 @@ void SIPTransportService::stop()
     delete _pIoServiceThread;
     _pIoServiceThread = 0;
   }
+  _tlsHandshakePool.stop();
 }
 
 void SIPTransportService::handleStop()
@@ -946,7 +932,7 @@ SIPTransportSession::Ptr SIPTransportService::createClientTlsTransport(
     const OSS::Net::IPAddress& localAddress,
     const OSS::Net::IPAddress& remoteAddress)
 {
-  SIPTransportSession::Ptr pTlsConnection(new SIPStreamedConnection(_ioService, _pTlsClientContext.get(), _tlsConMgr, 0));
+  SIPTransportSession::Ptr pTlsConnection(new SIPStreamedConnection(tlsIoService(), _pTlsClientContext.get(), _tlsConMgr, 0, &_tlsContext.sessionCache()));
   pTlsConnection->isClient() = true;
   pTlsConnection->clientBind(localAddress, _tcpPortBase, _tcpPortMax);
   pTlsConnection->clientConnect(remoteAddress);
@@ -1240,6 +1226,22 @@ void SIPTransportService::setHepInfo(int version, const std::string& host, const
   _hepPassword = password;
   _hepId = hepId;
   OSS_LOG_INFO("Enabling Homer SIP Capture: hep" << _hepVersion << "://" << _hepId << "@" << _hepHost << ":" << _hepPort);
+
+  SIPHepCapture& capture = hepCapture();
+  capture.stop();
+  capture.setVersion(_hepVersion);
+  capture.setCaptureId(_hepId);
+  capture.setPassword(_hepPassword);
+  capture.setCompression(_hepCompressionEnabled);
+  //
+  // A custom sender replaces the capture socket.  It is called from the
+  // capture thread.
+  //
+  capture.setSender(hepSenderCallback);
+  if (_hepEnabled && !_hepHost.empty() && !_hepPort.empty())
+  {
+    capture.start(_hepHost, _hepPort);
+  }
 }
 
 const std::string& SIPTransportService::getHepHost()
@@ -1265,6 +1267,14 @@ int SIPTransportService::getHepId()
 void SIPTransportService::enableHep(bool enabled)
 {
   SIPTransportService::_hepEnabled = enabled;
+  if (!enabled)
+  {
+    hepCapture().stop();
+  }
+  else if (!_hepHost.empty() && !_hepPort.empty())
+  {
+    hepCapture().start(_hepHost, _hepPort);
+  }
 }
 
 bool SIPTransportService::isHepEnabled()
@@ -1275,6 +1285,7 @@ bool SIPTransportService::isHepEnabled()
 void SIPTransportService::enableHepCompression(bool enabled)
 {
   _hepCompressionEnabled = enabled;
+  hepCapture().setCompression(enabled);
 }
 bool SIPTransportService::isHepCompressionEnabled()
 {
@@ -1288,38 +1299,13 @@ void SIPTransportService::dumpHepPacket(OSS::Net::IPAddress::Protocol proto, con
     return;
   }
   
-  std::string src = srcAddress.toString().data();
-  std::string dst = dstAddress.toString().data();
-  
-  con_info_t conInfo;
-  conInfo.capt_id = _hepId;
-  conInfo.capt_password = _hepPassword.empty() ? 0 : _hepPassword.data();
-  conInfo.send_hep_data = hep_sender_callback;
-  conInfo.compress = _hepCompressionEnabled;
-  conInfo.version = _hepVersion;
-  
-  rc_info rcInfo;
-  
-  rcInfo.src_ip = src.data();
-  rcInfo.src_port = srcAddress.getPort();
-  
-  rcInfo.dst_ip = dst.data();
-  rcInfo.dst_port = dstAddress.getPort();
-  rcInfo.ip_family = dstAddress.address().is_v4() ? AF_INET : AF_INET6;
-  rcInfo.ip_proto = (proto == OSS::Net::IPAddress::UDP ? IPPROTO_UDP : IPPROTO_TCP);
-  rcInfo.proto_type = 0x001;
-  
-  timeval now;
-  gettimeofday(&now, 0);
-  rcInfo.time_sec = now.tv_sec;
-  rcInfo.time_usec = now.tv_usec;
-
-  send_hep(&conInfo, &rcInfo, (unsigned char *)data.data(), data.length());
+  hepCapture().capture(proto, srcAddress, dstAddress, data.data(), data.size());
 }
 
-void SIPTransportService::hepSend(void* packet, int len)
+SIPHepCapture& SIPTransportService::hepCapture()
 {
-  dynamic_cast<SIPUDPConnection*>(_hepConnection.get())->writeBytes(packet, len, _hepHost, _hepPort);
+  static SIPHepCapture capture;
+  return capture;
 }
 
 void SIPTransportService::flagAllForPotentialPurge(bool purge)
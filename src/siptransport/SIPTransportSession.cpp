@@ -60,6 +60,13 @@ void SIPTransportSession::dispatchMessage(const SIPMessage::Ptr& pMsg, const SIP
     {
       pMsg->setProperty(OSS::PropertyMap::PROP_TransportAlias, _pListener->getTransportAlias());
     }
+    if (!pMsg->getReceiveTime())
+    {
+      //
+      // Stream transports dispatch as soon as a message is complete
+      //
+      pMsg->setReceiveTime(SIPOverloadControl::now());
+    }
     _messageDispatch(pMsg, pTransport);
   }
 }
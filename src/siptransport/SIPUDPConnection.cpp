@@ -20,6 +20,7 @@
 #include "OSS/OSS.h"
 #include <iostream>
 #include <vector>
+#include <cstring>
 #include <sstream>
 #include <boost/asio.hpp>
 #include <boost/bind.hpp>
@@ -33,12 +34,47 @@
 #include "OSS/UTL/Logger.h"
 #include "OSS/UTL/PropertyMap.h"
 #include "OSS/SIP/SIPListener.h"
+#include "OSS/Metrics/MetricsRegistry.h"
+#include "OSS/SIP/SIPOverloadControl.h"
+#if OSS_OS == OSS_OS_LINUX
+#include <sys/ioctl.h>
+#include <sys/time.h>
+#include <linux/sockios.h>
+#endif
 
 
 namespace OSS {
 namespace SIP {
 
 
+static OSS::Metrics::Counter& absorbedRetransmissions()
+{
+  static OSS::Metrics::Counter& counter = OSS::Metrics::MetricsRegistry::instance().counter("sip.retransmissions.absorbed");
+  return counter;
+}
+
+static OSS::UInt64 get_receive_time(boost::asio::ip::udp::socket& socket)
+{
+  OSS::UInt64 now = SIPOverloadControl::now();
+#ifdef SIOCGSTAMP
+  //
+  // The kernel stamps the last datagram read with the wall clock time it
+  // arrived.  Time spent in the socket buffer while the transport thread
+  // was busy, ie running a task the thread pool refused, counts as delay.
+  //
+  struct timeval stamp;
+  if (ioctl(socket.native_handle(), SIOCGSTAMP, &stamp) == 0)
+  {
+    struct timeval wallClock;
+    gettimeofday(&wallClock, 0);
+    OSS::Int64 waited = ((OSS::Int64)wallClock.tv_sec - stamp.tv_sec) * 1000000 + (wallClock.tv_usec - stamp.tv_usec);
+    if (waited > 0 && (OSS::UInt64)waited < now)
+      return now - waited;
+  }
+#endif
+  return now;
+}
+
 SIPUDPConnection::SIPUDPConnection(
   boost::asio::io_service& ioService,
   boost::asio::ip::udp::socket& socket,
@@ -121,6 +157,8 @@ void SIPUDPConnection::handleRead(const boost::system::error_code& e, std::size_
     _bytesRead =  bytes_transferred;
     if (_bytesRead > 20)
     {
+      OSS::UInt64 receiveTime = get_receive_time(_socket);
+
       try
       {
         if (rateLimit().isBannedAddress(getRemoteAddress().address()))
@@ -151,6 +189,30 @@ void SIPUDPConnection::handleRead(const boost::system::error_code& e, std::size_
         OSS_LOG_ERROR("Rate Limit Exception: Unknown exception.");
       }
 
+      //
+      // Retransmitted requests are answered from the cache without being
+      // parsed.  XOR encrypted datagrams always take the slow path.
+      //
+      _digest = SIPUDPRetransmissionCache::Digest();
+#if ENABLE_FEATURE_XOR
+      if (!SIPXOR::isEnabled())
+#endif
+      {
+        _digest = SIPUDPRetransmissionCache::computeDigest(_buffer.data(), bytes_transferred, _senderEndPoint);
+      }
+
+      if (_digest.isValid() && replayRetransmission())
+      {
+        if (_socket.is_open())
+        {
+          _socket.async_receive_from(boost::asio::buffer(_buffer), _senderEndPoint,
+            boost::bind(&SIPUDPConnection::handleRead, shared_from_this(),
+              boost::asio::placeholders::error,
+                boost::asio::placeholders::bytes_transferred, (void*)0));
+        }
+        return;
+      }
+
       std::string buffer(_buffer.data(), _buffer.data() + bytes_transferred);
       
 #if ENABLE_FEATURE_XOR
@@ -191,6 +253,7 @@ void SIPUDPConnection::handleRead(const boost::system::error_code& e, std::size_
       //
       SIPUDPConnectionClone* clone = new SIPUDPConnectionClone(shared_from_this());
       SIPTransportSession::Ptr pClone(clone);
+      _pRequest->setReceiveTime(receiveTime);
       dispatchMessage(_pRequest, pClone);
     }
     else if (_bytesRead == 4 &&
@@ -234,6 +297,41 @@ void SIPUDPConnection::handleRead(const boost::system::error_code& e, std::size_
   }
 }
 
+bool SIPUDPConnection::replayRetransmission()
+{
+  SIPUDPRetransmissionCache::Bytes response;
+  boost::asio::ip::udp::endpoint target;
+  if (!_retransmissions.lookup(_digest, response, target))
+  {
+    return false;
+  }
+
+  absorbedRetransmissions().increment();
+  if (response)
+  {
+    boost::system::error_code ec;
+    _socket.send_to(boost::asio::buffer(response->data(), response->size()), target, 0, ec);
+    if (ec)
+    {
+      OSS_LOG_DEBUG("SIPUDPConnection::replayRetransmission Exception " << ec.message());
+    }
+  }
+  return true;
+}
+
+void SIPUDPConnection::storeRetransmissionResponse(const SIPUDPRetransmissionCache::Digest& digest, const void* pOwner,
+  const SIPMessage::Ptr& pResponse, const std::string& ip, const std::string& port)
+{
+  boost::system::error_code ec;
+  boost::asio::ip::address addr = boost::asio::ip::address::from_string(ip, ec);
+  if (ec)
+  {
+    return;
+  }
+  unsigned short targetPort = port == "0" || port.empty() ? 5060 : OSS::string_to_number<unsigned short>(port);
+  _retransmissions.store(digest, pOwner, pResponse->data(), boost::asio::ip::udp::endpoint(addr, targetPort));
+}
+
 void SIPUDPConnection::writeMessage(SIPMessage::Ptr msg, const std::string& ip, const std::string& port)
 {
   if (_socket.is_open())
@@ -271,9 +369,13 @@ void SIPUDPConnection::writeMessage(SIPMessage::Ptr msg, const std::string& ip,
       else
       {
         boost::array<char, OSS_SIP_MAX_PACKET_SIZE> newBuff;
-        for (size_t i = 0; i < msg->data().size(); i++)
-          newBuff[i] = msg->data()[i];
         size_t len = msg->data().size();
+        if (len > newBuff.size())
+        {
+          OSS_LOG_ERROR("SIPUDPConnection::writeMessage - Message too large for XOR buffer " << len);
+          return;
+        }
+        memcpy(newBuff.data(), msg->data().data(), len);
         SIPXOR::sipEncrypt(newBuff, len);
 
 #if 0
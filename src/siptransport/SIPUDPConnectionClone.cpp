@@ -44,10 +44,15 @@ SIPUDPConnectionClone::SIPUDPConnectionClone(SIPUDPConnection::Ptr clonable):
   _isReliableTransport = false;
   _transportScheme = "udp";
   _externalAddress = clonable->getExternalAddress();
+  _pConnection = dynamic_cast<SIPUDPConnection*>(clonable.get());
+  _digest = _pConnection->_digest;
+  _hasRetransmissionResponse = false;
+  _hasReleasedRetransmissions = false;
 }
 
 SIPUDPConnectionClone::~SIPUDPConnectionClone()
 {
+  releaseRetransmissions();
 }
 
 void SIPUDPConnectionClone::start(const SIPTransportSession::Dispatch& dispatch)
@@ -64,6 +69,34 @@ void SIPUDPConnectionClone::handleRead(const boost::system::error_code& e, std::
 void SIPUDPConnectionClone::writeMessage(SIPMessage::Ptr msg, const std::string& ip, const std::string& port)
 {
   _orginalConnection->writeMessage(msg, ip, port);
+
+  //
+  // Responses written through the clone of a request belong to the
+  // server transaction of that request.  Remember the last one so the
+  // connection can replay it to retransmissions.
+  //
+  if (_digest.isValid() && !_hasReleasedRetransmissions && msg->isResponse())
+  {
+    _pConnection->storeRetransmissionResponse(_digest, this, msg, ip, port);
+    _hasRetransmissionResponse = true;
+  }
+}
+
+void SIPUDPConnectionClone::absorbRetransmissions()
+{
+  if (_hasRetransmissionResponse)
+  {
+    _pConnection->_retransmissions.absorb(_digest, this);
+  }
+}
+
+void SIPUDPConnectionClone::releaseRetransmissions()
+{
+  if (_hasRetransmissionResponse && !_hasReleasedRetransmissions)
+  {
+    _pConnection->_retransmissions.release(_digest, this);
+  }
+  _hasReleasedRetransmissions = true;
 }
 
 void SIPUDPConnectionClone::handleWrite(const boost::system::error_code& e, std::size_t bytes_transferred)
@@ -0,0 +1,199 @@
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare 
+// derivative works of the Software, all subject to the 
+// "GNU Lesser General Public License (LGPL)".
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+
+#include <cstring>
+#include "OSS/SIP/SIPUDPRetransmissionCache.h"
+#include "OSS/UTL/CoreUtils.h"
+
+
+namespace OSS {
+namespace SIP {
+
+
+static inline OSS::UInt64 rotate_left(OSS::UInt64 value, int bits)
+{
+  return (value << bits) | (value >> (64 - bits));
+}
+
+static inline OSS::UInt64 finalize(OSS::UInt64 hash)
+{
+  hash ^= hash >> 33;
+  hash *= 0xff51afd7ed558ccdULL;
+  hash ^= hash >> 33;
+  hash *= 0xc4ceb9fe1a85ec53ULL;
+  hash ^= hash >> 33;
+  return hash;
+}
+
+SIPUDPRetransmissionCache::SIPUDPRetransmissionCache(unsigned long lifetime) :
+  _lifetime(lifetime),
+  _nextPurge(0)
+{
+}
+
+SIPUDPRetransmissionCache::~SIPUDPRetransmissionCache()
+{
+}
+
+SIPUDPRetransmissionCache::Digest SIPUDPRetransmissionCache::computeDigest(const char* data, std::size_t length, const EndPoint& sender)
+{
+  Digest digest;
+  if (length < 8 || std::memcmp(data, "SIP/", 4) == 0)
+  {
+    return digest;
+  }
+
+  //
+  // Two independent lanes over the datagram eight bytes at a time.  The
+  // first one is the key and the second one guards against collisions.
+  //
+  OSS::UInt64 key = 0x9e3779b97f4a7c15ULL ^ length;
+  OSS::UInt64 check = 0x27d4eb2f165667c5ULL;
+  const char* end = data + (length & ~(std::size_t)7);
+  for (const char* p = data; p != end; p += 8)
+  {
+    OSS::UInt64 word;
+    std::memcpy(&word, p, 8);
+    key = rotate_left(key ^ (word * 0x87c37b91114253d5ULL), 31) * 0x4cf5ad432745937fULL;
+    check = rotate_left(check + word, 29) * 0x9e3779b97f4a7c15ULL;
+  }
+  OSS::UInt64 tail = 0;
+  std::memcpy(&tail, end, length & 7);
+  key = rotate_left(key ^ (tail * 0x87c37b91114253d5ULL), 31) * 0x4cf5ad432745937fULL;
+  check = rotate_left(check + tail, 29) * 0x9e3779b97f4a7c15ULL;
+
+  //
+  // The same request from another address is another transaction
+  //
+  OSS::UInt64 address = sender.port();
+  if (sender.address().is_v4())
+  {
+    address |= (OSS::UInt64)sender.address().to_v4().to_ulong() << 16;
+  }
+  else
+  {
+    boost::asio::ip::address_v6::bytes_type bytes = sender.address().to_v6().to_bytes();
+    for (std::size_t i = 0; i < bytes.size(); i++)
+    {
+      address = rotate_left(address, 8) ^ bytes[i];
+    }
+  }
+
+  digest.key = finalize(key ^ finalize(address));
+  digest.check = finalize(check ^ address);
+  digest.length = length;
+  return digest;
+}
+
+bool SIPUDPRetransmissionCache::lookup(const Digest& digest, Bytes& response, EndPoint& target)
+{
+  OSS::mutex_critic_sec_lock lock(_mutex);
+  if (_entries.empty())
+  {
+    return false;
+  }
+  Entries::iterator iter = _entries.find(digest.key);
+  if (iter == _entries.end() || iter->second.check != digest.check || iter->second.length != digest.length)
+  {
+    return false;
+  }
+  if (iter->second.expires <= OSS::getTime())
+  {
+    _entries.erase(iter);
+    return false;
+  }
+  response = iter->second.response;
+  target = iter->second.target;
+  return true;
+}
+
+void SIPUDPRetransmissionCache::store(const Digest& digest, const void* pOwner, const std::string& response, const EndPoint& target)
+{
+  OSS::UInt64 now = OSS::getTime();
+  Bytes bytes(new std::string(response));
+  OSS::mutex_critic_sec_lock lock(_mutex);
+  purge(now);
+  Entry& entry = _entries[digest.key];
+  entry.check = digest.check;
+  entry.length = digest.length;
+  entry.pOwner = pOwner;
+  entry.response = bytes;
+  entry.target = target;
+  entry.expires = now + _lifetime;
+}
+
+void SIPUDPRetransmissionCache::absorb(const Digest& digest, const void* pOwner)
+{
+  OSS::mutex_critic_sec_lock lock(_mutex);
+  Entries::iterator iter = _entries.find(digest.key);
+  if (iter != _entries.end() && iter->second.pOwner == pOwner)
+  {
+    iter->second.response.reset();
+  }
+}
+
+void SIPUDPRetransmissionCache::release(const Digest& digest, const void* pOwner)
+{
+  OSS::mutex_critic_sec_lock lock(_mutex);
+  Entries::iterator iter = _entries.find(digest.key);
+  if (iter != _entries.end() && iter->second.pOwner == pOwner)
+  {
+    _entries.erase(iter);
+  }
+}
+
+std::size_t SIPUDPRetransmissionCache::size() const
+{
+  OSS::mutex_critic_sec_lock lock(_mutex);
+  return _entries.size();
+}
+
+void SIPUDPRetransmissionCache::clear()
+{
+  OSS::mutex_critic_sec_lock lock(_mutex);
+  _entries.clear();
+}
+
+void SIPUDPRetransmissionCache::purge(OSS::UInt64 now)
+{
+  //
+  // Entries are released by their transaction.  This only catches the
+  // ones whose owner went away without doing so.
+  //
+  if (now < _nextPurge)
+  {
+    return;
+  }
+  _nextPurge = now + PURGE_INTERVAL;
+  for (Entries::iterator iter = _entries.begin(); iter != _entries.end();)
+  {
+    if (iter->second.expires <= now)
+    {
+      iter = _entries.erase(iter);
+    }
+    else
+    {
+      iter++;
+    }
+  }
+}
+
+
+} } // OSS::SIP
@@ -118,7 +118,21 @@ void SIPWebSocketListener::run_server()
     boost::asio::ip::tcp::resolver::query query(getAddress(), getPort());
     boost::asio::ip::tcp::endpoint endpoint = *_resolver.resolve(query);
     _hasStarted = true;
-    _pServerEndPoint->listen(endpoint);
+
+    std::size_t threadCount = getTransportService()->getWebSocketThreads();
+    if (threadCount > 1)
+    {
+      //
+      // The endpoint runs its io_service on a pool of threads and returns.
+      // Handlers of a connection are serialized by the connection strand.
+      //
+      OSS_LOG_INFO("SIPWebSocketListener::run_server " << _address << ":" << _port << " using " << threadCount << " threads");
+      _pServerEndPoint->start_listen(endpoint, threadCount);
+    }
+    else
+    {
+      _pServerEndPoint->listen(endpoint);
+    }
   }
   catch(const std::exception& e)
   {
@@ -170,7 +184,7 @@ void SIPWebSocketListener::handleStop()
   
   if (_pServerEndPoint)
   {
-    _pServerEndPoint->stop_listen(true);
+    _pServerEndPoint->close_and_join();
   }
 
   if (_pServerThread)
@@ -59,6 +59,10 @@ void SIPWebSocketTlsListener::ServerAcceptHandler::on_fail(websocketpp::server_t
        * Refer to common.hpp for the rest of the individual codes.
        */
   	OSS_LOG_DEBUG("SIPWebSocketTlsListener::ServerAcceptHandler::on_fail reason: " << pConnection->get_fail_reason());
+
+  	SSL* ssl = pConnection->get_socket().native_handle();
+  	if (ssl && !SSL_is_init_finished(ssl))
+  	  _rListener.getTransportService()->tlsSessionCache().onHandshake(ssl, true, false);
 }
 
 void SIPWebSocketTlsListener::ServerAcceptHandler::on_open(websocketpp::server_tls::connection_ptr pConnection)
@@ -66,6 +70,12 @@ void SIPWebSocketTlsListener::ServerAcceptHandler::on_open(websocketpp::server_t
   	OSS_LOG_DEBUG("SIPWebSocketTlsListener::ServerAcceptHandler::on_open");
   	boost::system::error_code ec;
 
+  	//
+  	// The TLS handshake completed before the WebSocket upgrade.  The
+  	// server context shares its session cache with the SIP TLS listeners.
+  	//
+  	_rListener.getTransportService()->tlsSessionCache().onHandshake(pConnection->get_socket().native_handle(), true, true);
+
   	//accept only sip websockets connections
 //  	if (pConnection->get_resource() == "/sip")
 //  	{
@@ -124,7 +134,21 @@ void SIPWebSocketTlsListener::run_server()
     boost::asio::ip::tcp::resolver::query query(getAddress(), getPort());
     boost::asio::ip::tcp::endpoint endpoint = *_resolver.resolve(query);
     _hasStarted = true;
-    _pServerEndPoint->listen(endpoint);
+
+    std::size_t threadCount = getTransportService()->getWebSocketThreads();
+    if (threadCount > 1)
+    {
+      //
+      // The endpoint runs its io_service on a pool of threads and returns.
+      // Handlers of a connection are serialized by the connection strand.
+      //
+      OSS_LOG_INFO("SIPWebSocketTlsListener::run_server " << _address << ":" << _port << " using " << threadCount << " threads");
+      _pServerEndPoint->start_listen(endpoint, threadCount);
+    }
+    else
+    {
+      _pServerEndPoint->listen(endpoint);
+    }
   }
   catch(const std::exception& e)
   {
@@ -176,7 +200,7 @@ void SIPWebSocketTlsListener::handleStop()
   
   if (_pServerEndPoint)
   {
-    _pServerEndPoint->stop_listen(true);
+    _pServerEndPoint->close_and_join();
   }
 
   if (_pServerThread)
@@ -18,8 +18,20 @@
 //
 
 
+#include <cstring>
 #include "OSS/SIP/SIPXOR.h"
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define OSS_XOR_HAVE_AVX2 1
+#else
+#define OSS_XOR_HAVE_AVX2 0
+#endif
+
 namespace OSS {
 namespace SIP {
 
@@ -32,11 +44,163 @@ struct xor_sip_config
 static struct xor_sip_config _xor_config = {false, false, "GS"};
 
 
+SIPXOR::SpanFunc SIPXOR::rtpEncryptInPlace;
+SIPXOR::SpanFunc SIPXOR::rtpDecryptInPlace;
+SIPXOR::SpanFunc SIPXOR::sipEncryptInPlace;
+SIPXOR::SpanFunc SIPXOR::sipDecryptInPlace;
 SIPXOR::EncryptFunc SIPXOR::rtpEncryptExternal;
 SIPXOR::EncryptFunc SIPXOR::rtpDecryptExternal;
 SIPXOR::EncryptFunc SIPXOR::sipEncryptExternal;
 SIPXOR::EncryptFunc SIPXOR::sipDecryptExternal;
 
+//
+// XOR kernels.  Every kernel applies key[i & 1] to byte i.  Vector
+// strides are even so the key phase never shifts between the vector
+// loop and the scalar tail.
+//
+typedef void (*xor_kernel)(char* data, std::size_t len, const char* key);
+
+static void xor_scalar(char* data, std::size_t len, const char* key)
+{
+  OSS::UInt64 pattern;
+  char bytes[sizeof(pattern)];
+  for (std::size_t i = 0; i < sizeof(bytes); i++)
+    bytes[i] = key[i & 1];
+  memcpy(&pattern, bytes, sizeof(pattern));
+
+  std::size_t i = 0;
+  for (; i + sizeof(pattern) <= len; i += sizeof(pattern))
+  {
+    OSS::UInt64 word;
+    memcpy(&word, data + i, sizeof(word));
+    word ^= pattern;
+    memcpy(data + i, &word, sizeof(word));
+  }
+  for (; i < len; i++)
+    data[i] ^= key[i & 1];
+}
+
+#if defined(__SSE2__)
+static void xor_sse2(char* data, std::size_t len, const char* key)
+{
+  const __m128i pattern = _mm_set1_epi16((short)((unsigned char)key[0] | ((unsigned char)key[1] << 8)));
+  std::size_t i = 0;
+  for (; i + 64 <= len; i += 64)
+  {
+    __m128i a = _mm_loadu_si128((const __m128i*)(data + i));
+    __m128i b = _mm_loadu_si128((const __m128i*)(data + i + 16));
+    __m128i c = _mm_loadu_si128((const __m128i*)(data + i + 32));
+    __m128i d = _mm_loadu_si128((const __m128i*)(data + i + 48));
+    _mm_storeu_si128((__m128i*)(data + i), _mm_xor_si128(a, pattern));
+    _mm_storeu_si128((__m128i*)(data + i + 16), _mm_xor_si128(b, pattern));
+    _mm_storeu_si128((__m128i*)(data + i + 32), _mm_xor_si128(c, pattern));
+    _mm_storeu_si128((__m128i*)(data + i + 48), _mm_xor_si128(d, pattern));
+  }
+  for (; i + 16 <= len; i += 16)
+  {
+    __m128i a = _mm_loadu_si128((const __m128i*)(data + i));
+    _mm_storeu_si128((__m128i*)(data + i), _mm_xor_si128(a, pattern));
+  }
+  xor_scalar(data + i, len - i, key);
+}
+#endif
+
+#if OSS_XOR_HAVE_AVX2
+__attribute__((target("avx2")))
+static void xor_avx2(char* data, std::size_t len, const char* key)
+{
+  const __m256i pattern = _mm256_set1_epi16((short)((unsigned char)key[0] | ((unsigned char)key[1] << 8)));
+  std::size_t i = 0;
+  for (; i + 128 <= len; i += 128)
+  {
+    __m256i a = _mm256_loadu_si256((const __m256i*)(data + i));
+    __m256i b = _mm256_loadu_si256((const __m256i*)(data + i + 32));
+    __m256i c = _mm256_loadu_si256((const __m256i*)(data + i + 64));
+    __m256i d = _mm256_loadu_si256((const __m256i*)(data + i + 96));
+    _mm256_storeu_si256((__m256i*)(data + i), _mm256_xor_si256(a, pattern));
+    _mm256_storeu_si256((__m256i*)(data + i + 32), _mm256_xor_si256(b, pattern));
+    _mm256_storeu_si256((__m256i*)(data + i + 64), _mm256_xor_si256(c, pattern));
+    _mm256_storeu_si256((__m256i*)(data + i + 96), _mm256_xor_si256(d, pattern));
+  }
+  for (; i + 32 <= len; i += 32)
+  {
+    __m256i a = _mm256_loadu_si256((const __m256i*)(data + i));
+    _mm256_storeu_si256((__m256i*)(data + i), _mm256_xor_si256(a, pattern));
+  }
+  xor_scalar(data + i, len - i, key);
+}
+#endif
+
+static xor_kernel select_xor_kernel()
+{
+#if OSS_XOR_HAVE_AVX2
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2"))
+    return xor_avx2;
+#endif
+#if defined(__SSE2__)
+  return xor_sse2;
+#else
+  return xor_scalar;
+#endif
+}
+
+static const xor_kernel _xor_kernel = select_xor_kernel();
+
+static void call_span_handler(const SIPXOR::SpanFunc& handler, char* data, std::size_t& len, std::size_t capacity)
+{
+  SIPXOR::MutableSpan span;
+  span.data = data;
+  span.size = len;
+  span.capacity = capacity;
+  handler(span);
+  len = span.size > capacity ? capacity : span.size;
+}
+
+static void call_external_handler(const SIPXOR::EncryptFunc& handler, char* data, std::size_t& len, std::size_t capacity)
+{
+  std::vector<char> input(data, data + len);
+  handler(input);
+  len = input.size() > capacity ? capacity : input.size();
+  if (len)
+    memcpy(data, &input[0], len);
+}
+
+static void xor_encrypt(const SIPXOR::SpanFunc& inPlace, const SIPXOR::EncryptFunc& external,
+  char* data, std::size_t& len, std::size_t capacity)
+{
+  if (inPlace)
+    call_span_handler(inPlace, data, len, capacity);
+  else if (external)
+    call_external_handler(external, data, len, capacity);
+  else
+    SIPXOR::xorInPlace(data, len, _xor_config.key);
+}
+
+static void sip_encrypt(char* data, std::size_t& len, std::size_t capacity)
+{
+  if (!_xor_config.enabled)
+    return;
+  xor_encrypt(SIPXOR::sipEncryptInPlace, SIPXOR::sipEncryptExternal, data, len, capacity);
+}
+
+static void sip_decrypt(char* data, std::size_t& len, std::size_t capacity)
+{
+  if (SIPXOR::sipDecryptInPlace)
+    call_span_handler(SIPXOR::sipDecryptInPlace, data, len, capacity);
+  else if (SIPXOR::sipDecryptExternal)
+    call_external_handler(SIPXOR::sipDecryptExternal, data, len, capacity);
+  else
+    sip_encrypt(data, len, capacity);
+}
+
+static void rtp_encrypt(char* data, std::size_t& len, std::size_t capacity)
+{
+  if (!_xor_config.enabled)
+    return;
+  xor_encrypt(SIPXOR::rtpEncryptInPlace, SIPXOR::rtpEncryptExternal, data, len, capacity);
+}
+
 void SIPXOR::setKey(const char* key)
 {
   _xor_config.key[0] = *key;
@@ -59,99 +223,38 @@ bool SIPXOR::isEnabled()
   return _xor_config.enabled;
 }
 
-void SIPXOR::sipEncrypt(boost::array<char, OSS_SIP_MAX_PACKET_SIZE>& packet, size_t& len)
+void SIPXOR::xorInPlace(char* data, std::size_t len, const char* key)
 {
-  int size = len;
-  int i = 0;
-  if (!_xor_config.enabled)
-    return;
-
-  if (SIPXOR::sipEncryptExternal)
-  {
-    //
-    // Call external handler
-    //
-    std::vector<char> input;
-    input.reserve(len);
-    for (std::size_t i = 0; i < len; i++)
-      input.push_back(packet[i]);
-    SIPXOR::sipEncryptExternal(input);
-
-    for (std::size_t i = 0; i < input.size(); i++)
-      packet[i] = input[i];
-    len = input.size();
+  if (!len)
     return;
-  }
+  _xor_kernel(data, len, key);
+  if ((len & 1) && len >= 3)
+    data[len - 1] ^= key[0] ^ key[1];
+}
 
-  for(i = 0; i < size; i+=2)
-  {
-    packet[i] = packet[i] ^ _xor_config.key[0];
-    packet[i+1] = packet[i+1] ^ _xor_config.key[1];
-    if( i + 2 == size - 1 )
-    {
-      packet[i+2] = packet[i+2] ^ _xor_config.key[1];
-      break;
-    }
-  }
+void SIPXOR::sipEncrypt(boost::array<char, OSS_SIP_MAX_PACKET_SIZE>& packet, size_t& len)
+{
+  sip_encrypt(packet.data(), len, packet.size());
 }
 
 void SIPXOR::sipDecrypt(boost::array<char, OSS_SIP_MAX_PACKET_SIZE>& packet, size_t& len)
 {
-  if (SIPXOR::sipDecryptExternal)
-  {
-    //
-    // Call external handler
-    //
-    std::vector<char> input;
-    input.reserve(len);
-    for (std::size_t i = 0; i < len; i++)
-      input.push_back(packet[i]);
-    SIPXOR::sipDecryptExternal(input);
-
-    for (std::size_t i = 0; i < input.size(); i++)
-      packet[i] = input[i];
-    len = input.size();
-    return;
-  }
-
-  return sipEncrypt(packet, len);
+  sip_decrypt(packet.data(), len, packet.size());
 }
 
-void SIPXOR::rtpEncrypt(boost::array<char, RTP_PACKET_BUFFER_SIZE>& packet, size_t& len)
+void SIPXOR::sipEncrypt(const boost::asio::mutable_buffer& buffer, size_t& len)
 {
-  int size = len;
-  int i = 0;
-  if (!_xor_config.enabled)
-    return;
-
-  if (SIPXOR::rtpEncryptExternal)
-  {
-    //
-    // Call external handler
-    //
-    std::vector<char> input;
-    input.reserve(len);
-    for (std::size_t i = 0; i < len; i++)
-      input.push_back(packet[i]);
-    SIPXOR::rtpEncryptExternal(input);
-
-    for (std::size_t i = 0; i < input.size(); i++)
-      packet[i] = input[i];
-    len = input.size();
-    return;
-  }
+  sip_encrypt(boost::asio::buffer_cast<char*>(buffer), len, boost::asio::buffer_size(buffer));
+}
 
-  for(i = 0; i < size; i+=2)
-  {
-    packet[i] = packet[i] ^ _xor_config.key[0];
-    packet[i+1] = packet[i+1] ^ _xor_config.key[1];
-    if( i + 2 == size - 1 )
-    {
-      packet[i+2] = packet[i+2] ^ _xor_config.key[1];
-      break;
-    }
-  }
+void SIPXOR::sipDecrypt(const boost::asio::mutable_buffer& buffer, size_t& len)
+{
+  sip_decrypt(boost::asio::buffer_cast<char*>(buffer), len, boost::asio::buffer_size(buffer));
+}
 
+void SIPXOR::rtpEncrypt(boost::array<char, RTP_PACKET_BUFFER_SIZE>& packet, size_t& len)
+{
+  rtp_encrypt(packet.data(), len, packet.size());
 }
 
 void SIPXOR::rtpDecrypt(boost::array<char, RTP_PACKET_BUFFER_SIZE>& packet, size_t& len)
@@ -161,50 +264,29 @@ void SIPXOR::rtpDecrypt(boost::array<char, RTP_PACKET_BUFFER_SIZE>& packet, size
 
   if (!_xor_config.pad_rtp)
   {
-    if (SIPXOR::rtpDecryptExternal)
-    {
-      //
-      // Call external handler
-      //
-      std::vector<char> input;
-      input.reserve(len);
-      for (std::size_t i = 0; i < len; i++)
-        input.push_back(packet[i]);
-      SIPXOR::rtpDecryptExternal(input);
-
-      for (std::size_t i = 0; i < input.size(); i++)
-        packet[i] = input[i];
-      len = input.size();
-      return;
-    }
-
-    return rtpEncrypt(packet, len);
+    if (SIPXOR::rtpDecryptInPlace)
+      call_span_handler(SIPXOR::rtpDecryptInPlace, packet.data(), len, packet.size());
+    else if (SIPXOR::rtpDecryptExternal)
+      call_external_handler(SIPXOR::rtpDecryptExternal, packet.data(), len, packet.size());
+    else
+      rtp_encrypt(packet.data(), len, packet.size());
+    return;
   }
 
+  //
+  // Strip the zero padding in front of the payload
+  //
+  std::size_t boundary = 0;
+  while (boundary < len && packet[boundary] == 0)
+    boundary++;
 
-  boost::array<char, RTP_PACKET_BUFFER_SIZE> oldPacket = packet;
-
-  int boundary = 0;
-  for (boundary = 0; ((int)packet[boundary]) == 0 && boundary < RTP_PACKET_BUFFER_SIZE; boundary++);
-
-  if (len - boundary <= 0)
+  if (boundary >= len)
     return;
 
- 
-  for(std::size_t i = 0; i < len - boundary; i+=2)
-  {
-    packet[i] = oldPacket[i + boundary] ^ _xor_config.key[0];
-    packet[i+1] = oldPacket[i+1 + boundary] ^ _xor_config.key[1];
-    if( i + 2 == len - 1 )
-    {
-      packet[i+2] = oldPacket[i+2+boundary] ^ _xor_config.key[1];
-      break;
-    }
-  }
-
-  len = len - boundary;
+  len -= boundary;
+  memmove(packet.data(), packet.data() + boundary, len);
+  xorInPlace(packet.data(), len, _xor_config.key);
 }
 
 
 } } // OSS::SIP
-
@@ -0,0 +1,115 @@
+#include "gtest/gtest.h"
+#include <boost/thread.hpp>
+#include <boost/lexical_cast.hpp>
+#include "OSS/UTL/AutoExpireSet.h"
+
+
+typedef OSS::UTL::AutoExpireSet<std::string> StringSet;
+
+TEST(AutoExpireSetTest, test_insert_has_erase)
+{
+  StringSet set(60000);
+  ASSERT_TRUE(set.insert("a"));
+  ASSERT_TRUE(set.insert("b"));
+  ASSERT_FALSE(set.insert("a"));
+  ASSERT_EQ(2u, set.size());
+  ASSERT_TRUE(set.has("a"));
+  ASSERT_TRUE(set.has("b"));
+  ASSERT_FALSE(set.has("c"));
+
+  ASSERT_TRUE(set.erase("a"));
+  ASSERT_FALSE(set.erase("a"));
+  ASSERT_FALSE(set.has("a"));
+  ASSERT_EQ(1u, set.size());
+
+  set.clear();
+  ASSERT_FALSE(set.has("b"));
+  ASSERT_EQ(0u, set.size());
+}
+
+TEST(AutoExpireSetTest, test_growth_and_tombstones)
+{
+  //
+  // One shard so every value goes through the same table
+  //
+  StringSet set(60000, 1);
+  for (int i = 0; i < 10000; i++)
+  {
+    ASSERT_TRUE(set.insert(boost::lexical_cast<std::string>(i)));
+  }
+  ASSERT_EQ(10000u, set.size());
+  for (int i = 0; i < 10000; i += 2)
+  {
+    ASSERT_TRUE(set.erase(boost::lexical_cast<std::string>(i)));
+  }
+  for (int i = 0; i < 10000; i++)
+  {
+    ASSERT_EQ(i % 2 == 1, set.has(boost::lexical_cast<std::string>(i)));
+  }
+
+  //
+  // Churn through the tombstones without growing the live count
+  //
+  for (int i = 0; i < 50000; i++)
+  {
+    std::string value = "churn" + boost::lexical_cast<std::string>(i);
+    ASSERT_TRUE(set.insert(value));
+    ASSERT_TRUE(set.erase(value));
+  }
+  ASSERT_EQ(5000u, set.size());
+  ASSERT_TRUE(set.has("9999"));
+}
+
+TEST(AutoExpireSetTest, test_expire)
+{
+  StringSet set(200);
+  set.insert("a");
+  set.insert("b");
+  boost::this_thread::sleep(boost::posix_time::milliseconds(120));
+  //
+  // Refreshing restarts the expiry
+  //
+  ASSERT_FALSE(set.insert("b"));
+  boost::this_thread::sleep(boost::posix_time::milliseconds(120));
+  ASSERT_FALSE(set.has("a"));
+  ASSERT_TRUE(set.has("b"));
+  boost::this_thread::sleep(boost::posix_time::milliseconds(120));
+  ASSERT_FALSE(set.has("b"));
+
+  //
+  // Expired values come back as new ones and are purged from the count
+  //
+  ASSERT_TRUE(set.insert("a"));
+  boost::this_thread::sleep(boost::posix_time::milliseconds(250));
+  ASSERT_EQ(0u, set.size());
+}
+
+static void insert_and_check(StringSet* pSet, int thread, bool* pOk)
+{
+  for (int i = 0; i < 20000; i++)
+  {
+    std::string value = boost::lexical_cast<std::string>(thread) + "-" + boost::lexical_cast<std::string>(i);
+    pSet->insert(value);
+    if (!pSet->has(value))
+    {
+      *pOk = false;
+    }
+  }
+}
+
+TEST(AutoExpireSetTest, test_concurrent)
+{
+  StringSet set(60000);
+  bool ok[4] = { true, true, true, true };
+  boost::thread_group threads;
+  for (int i = 0; i < 4; i++)
+  {
+    threads.create_thread(boost::bind(insert_and_check, &set, i, &ok[i]));
+  }
+  threads.join_all();
+  for (int i = 0; i < 4; i++)
+  {
+    ASSERT_TRUE(ok[i]);
+  }
+  ASSERT_EQ(80000u, set.size());
+}
@@ -0,0 +1,108 @@
+#include "gtest/gtest.h"
+
+#include "OSS/build.h"
+#if OSS_HAVE_BDB
+
+#include <boost/filesystem.hpp>
+#include "OSS/Persistent/BerkeleyDb.h"
+
+
+#define bdbfile "BerkeleyDb.test"
+
+
+static void populate(OSS::BerkeleyDb& db)
+{
+  for (int i = 0; i < 100; i++)
+  {
+    std::string user = "user" + OSS::string_from_number<int>(i);
+    db.set(user + "@a.com-callid-10.0.0.1", user);
+    db.set(user + "@b.com-callid-10.0.0.1", user);
+  }
+  db.set("sbc.channel-count-1800", "1");
+  db.set("sbc.channel-count-1900", "2");
+}
+
+TEST(BerkeleyDbTest, test_prefix_and_range)
+{
+  boost::filesystem::remove(bdbfile);
+  OSS::BerkeleyDb db;
+  ASSERT_TRUE(db.open(bdbfile));
+  populate(db);
+
+  std::vector<std::string> keys;
+  ASSERT_TRUE(db.getKeysWithPrefix("user1@", keys));
+  ASSERT_EQ(2u, keys.size());
+  ASSERT_EQ("user1@a.com-callid-10.0.0.1", keys[0]);
+
+  keys.clear();
+  ASSERT_TRUE(db.getKeysWithPrefix("user1", keys));
+  ASSERT_EQ(22u, keys.size());
+
+  keys.clear();
+  ASSERT_FALSE(db.getKeysWithPrefix("user1000", keys));
+
+  //
+  // Glob patterns still work and only visit the literal prefix range
+  //
+  keys.clear();
+  ASSERT_TRUE(db.getKeys("user2*@b.com-*", keys));
+  ASSERT_EQ(11u, keys.size());
+  keys.clear();
+  ASSERT_TRUE(db.getKeys("*-1900", keys));
+  ASSERT_EQ(1u, keys.size());
+
+  OSS::BerkeleyDb::Records records;
+  ASSERT_TRUE(db.getRecordsWithPrefix("sbc.channel-count-", records));
+  ASSERT_EQ(2u, records.size());
+  ASSERT_EQ("sbc.channel-count-1900", records[1].first);
+  ASSERT_EQ("2", records[1].second);
+
+  //
+  // Resume an iteration after the last key seen
+  //
+  records.clear();
+  ASSERT_TRUE(db.getRange("user1", true, "user2", 10, records));
+  ASSERT_EQ(10u, records.size());
+  std::string last = records.back().first;
+  records.clear();
+  ASSERT_TRUE(db.getRange(last, false, "user2", 0, records));
+  ASSERT_EQ(12u, records.size());
+  ASSERT_LT(last, records.front().first);
+
+  ASSERT_EQ("user2", OSS::BerkeleyDb::prefixUpperBound("user1"));
+  ASSERT_EQ("", OSS::BerkeleyDb::prefixUpperBound("\xFF"));
+
+  db.close();
+  boost::filesystem::remove(bdbfile);
+}
+
+TEST(BerkeleyDbTest, test_deferred_sync)
+{
+  boost::filesystem::remove(bdbfile);
+  OSS::BerkeleyDb db;
+  ASSERT_TRUE(db.open(bdbfile));
+
+  //
+  // Writes that skip the flush are visible before sync() and survive a reopen
+  //
+  db.set("cdr-1", "setup", false);
+  db.set("cdr-2", "setup", false);
+  db.set("cdr-1", "connected", false);
+  db.erase("cdr-2", false);
+  std::string value;
+  ASSERT_TRUE(db.get("cdr-1", value));
+  ASSERT_EQ("connected", value);
+  ASSERT_FALSE(db.get("cdr-2", value));
+  ASSERT_TRUE(db.sync());
+  db.close();
+
+  OSS::BerkeleyDb reopened;
+  ASSERT_TRUE(reopened.open(bdbfile));
+  ASSERT_TRUE(reopened.get("cdr-1", value));
+  ASSERT_EQ("connected", value);
+  ASSERT_FALSE(reopened.get("cdr-2", value));
+  reopened.close();
+  boost::filesystem::remove(bdbfile);
+}
+
+#endif // OSS_HAVE_BDB
@@ -0,0 +1,182 @@
+#include "gtest/gtest.h"
+#include <poll.h>
+#include <boost/thread.hpp>
+#include "OSS/UTL/BlockingQueue.h"
+
+
+typedef OSS::BlockingQueue<int> IntQueue;
+
+static bool is_readable(int fd)
+{
+  pollfd pfd;
+  pfd.fd = fd;
+  pfd.events = POLLIN;
+  pfd.revents = 0;
+  return poll(&pfd, 1, 0) == 1 && (pfd.revents & POLLIN);
+}
+
+static void test_fifo(IntQueue& q)
+{
+  for (int i = 0; i < 100; i++)
+  {
+    ASSERT_TRUE(q.enqueue(i));
+  }
+  ASSERT_EQ(100u, q.size());
+  for (int i = 0; i < 100; i++)
+  {
+    int x = -1;
+    q.dequeue(x);
+    ASSERT_EQ(i, x);
+  }
+  int x = 999;
+  ASSERT_FALSE(q.try_dequeue(x, 0));
+  ASSERT_FALSE(q.try_dequeue(x, 50));
+  ASSERT_EQ(999, x);
+  ASSERT_EQ(0u, q.size());
+}
+
+static void test_batch(IntQueue& q)
+{
+  for (int i = 0; i < 10; i++)
+  {
+    q.enqueue(i);
+  }
+  std::vector<int> items;
+  ASSERT_EQ(4u, q.dequeueBatch(items, 4));
+  ASSERT_EQ(4u, items.size());
+  ASSERT_EQ(3, items[3]);
+  ASSERT_EQ(6u, q.dequeueAll(items));
+  ASSERT_EQ(10u, items.size());
+  for (int i = 0; i < 10; i++)
+  {
+    ASSERT_EQ(i, items[i]);
+  }
+  ASSERT_EQ(0u, q.dequeueBatch(items, 4, 0));
+  ASSERT_EQ(0u, q.dequeueBatch(items, 4, 20));
+}
+
+static void test_fd(IntQueue& q)
+{
+  int fd = q.getFd();
+  ASSERT_GT(fd, 0);
+  ASSERT_FALSE(is_readable(fd));
+  q.enqueue(1);
+  q.enqueue(2);
+  ASSERT_TRUE(is_readable(fd));
+  int x;
+  q.dequeue(x);
+  ASSERT_TRUE(is_readable(fd));
+  q.dequeue(x);
+  ASSERT_FALSE(is_readable(fd));
+  q.enqueue(3);
+  ASSERT_TRUE(is_readable(fd));
+  std::vector<int> items;
+  q.dequeueAll(items);
+  ASSERT_FALSE(is_readable(fd));
+}
+
+static void produce(IntQueue* q, int first, int count)
+{
+  for (int i = first; i < first + count; i++)
+  {
+    while (!q->enqueue(i))
+    {
+      boost::this_thread::yield();
+    }
+  }
+}
+
+static void consume(IntQueue* q, boost::atomic<int>* received, int total, long long* sum)
+{
+  std::vector<int> items;
+  while (received->load() < total)
+  {
+    items.clear();
+    received->fetch_add(q->dequeueBatch(items, 64, 10));
+    for (std::size_t i = 0; i < items.size(); i++)
+    {
+      *sum += items[i];
+    }
+  }
+}
+
+static void test_contention(IntQueue& q)
+{
+  const int producers = 4;
+  const int perProducer = 50000;
+  const int total = producers * perProducer;
+  boost::atomic<int> received(0);
+  long long sums[2] = { 0, 0 };
+  boost::thread_group threads;
+  //
+  // Consumers start first so they block on an empty queue
+  //
+  threads.create_thread(boost::bind(consume, &q, &received, total, &sums[0]));
+  threads.create_thread(boost::bind(consume, &q, &received, total, &sums[1]));
+  for (int i = 0; i < producers; i++)
+  {
+    threads.create_thread(boost::bind(produce, &q, i * perProducer, perProducer));
+  }
+  threads.join_all();
+  ASSERT_EQ((long long)total * (total - 1) / 2, sums[0] + sums[1]);
+  ASSERT_EQ(0u, q.size());
+}
+
+TEST(BlockingQueueTest, test_deque_fifo)
+{
+  IntQueue q;
+  test_fifo(q);
+}
+
+TEST(BlockingQueueTest, test_ring_fifo)
+{
+  IntQueue q(false, 128, IntQueue::BACKEND_RING);
+  ASSERT_EQ(128u, q.getMaxSize());
+  test_fifo(q);
+}
+
+TEST(BlockingQueueTest, test_ring_full)
+{
+  IntQueue q(false, 5, IntQueue::BACKEND_RING);
+  ASSERT_EQ(8u, q.getMaxSize());
+  for (int i = 0; i < 8; i++)
+  {
+    ASSERT_TRUE(q.enqueue(i));
+  }
+  ASSERT_FALSE(q.enqueue(8));
+  int x;
+  q.dequeue(x);
+  ASSERT_TRUE(q.enqueue(8));
+}
+
+TEST(BlockingQueueTest, test_max_size)
+{
+  IntQueue q(false, 2);
+  ASSERT_TRUE(q.enqueue(1));
+  ASSERT_TRUE(q.enqueue(2));
+  ASSERT_FALSE(q.enqueue(3));
+}
+
+TEST(BlockingQueueTest, test_batch)
+{
+  IntQueue deque;
+  test_batch(deque);
+  IntQueue ring(false, 64, IntQueue::BACKEND_RING);
+  test_batch(ring);
+}
+
+TEST(BlockingQueueTest, test_fd)
+{
+  IntQueue deque(true);
+  test_fd(deque);
+  IntQueue ring(true, 64, IntQueue::BACKEND_RING);
+  test_fd(ring);
+}
+
+TEST(BlockingQueueTest, test_contention)
+{
+  IntQueue deque(true);
+  test_contention(deque);
+  IntQueue ring(true, 256, IntQueue::BACKEND_RING);
+  test_contention(ring);
+}
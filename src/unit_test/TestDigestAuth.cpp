@@ -167,3 +167,70 @@ TEST(TestDigestAuth, SIPProxyAuthenticate)
   std::cout << auth << std::endl;
 }
 
+
+TEST(TestDigestAuth, RFC2617Response)
+{
+  //
+  // Example from RFC 2617 section 3.5
+  //
+  std::string a1 = SIPDigestAuth::digestCreateA1Hash("\"Mufasa\"", "Circle Of Life", "\"testrealm@host.com\"");
+  std::string a2 = SIPDigestAuth::digestCreateA2Hash("/dir/index.html", "GET");
+  std::string response = SIPDigestAuth::digestCreateAuthorizationQop(a1,
+    "\"dcd98b7102dd2f0e8b11d0f600bfb0c093\"", "00000001", "\"0a4f113b\"", "auth", a2);
+  ASSERT_STREQ("6629fae49393a05397450978507c4ef1", response.c_str());
+
+  //
+  // Inputs longer than the stack buffer
+  //
+  std::string longUri = "sip:" + std::string(1000, 'x') + "@domain.com";
+  std::string longA2 = SIPDigestAuth::digestCreateA2Hash(longUri, "INVITE");
+  ASSERT_EQ(OSS::string_md5_hash(("INVITE:" + longUri).c_str()), longA2);
+}
+
+TEST(TestDigestAuth, TimedNonce)
+{
+  std::string nonce = SIPDigestAuth::digestCreateTimedNonce(realm);
+  ASSERT_EQ(40, nonce.size());
+  ASSERT_TRUE(SIPDigestAuth::digestVerifyTimedNonce(nonce, realm));
+  ASSERT_TRUE(SIPDigestAuth::digestVerifyTimedNonce("\"" + nonce + "\"", realm));
+  ASSERT_FALSE(SIPDigestAuth::digestVerifyTimedNonce(nonce, "other.com"));
+
+  std::string tampered = nonce;
+  tampered[39] = tampered[39] == '0' ? '1' : '0';
+  ASSERT_FALSE(SIPDigestAuth::digestVerifyTimedNonce(tampered, realm));
+  ASSERT_FALSE(SIPDigestAuth::digestVerifyTimedNonce(nonce.substr(0, 39), realm));
+  ASSERT_FALSE(SIPDigestAuth::digestVerifyTimedNonce(SIPDigestAuth::digestCreateNonce(realm), realm));
+
+  //
+  // Nonces from another SBC are accepted only if the secret is shared
+  //
+  SIPDigestAuth::setSecretKey("shared-secret");
+  ASSERT_FALSE(SIPDigestAuth::digestVerifyTimedNonce(nonce, realm));
+  nonce = SIPDigestAuth::digestCreateTimedNonce(realm);
+  ASSERT_TRUE(SIPDigestAuth::digestVerifyTimedNonce(nonce, realm));
+}
+
+TEST(TestDigestAuth, NonceCountReplay)
+{
+  SIPDigestNonceCounter counter;
+  ASSERT_FALSE(counter.accept(nonce, user, 0));
+  ASSERT_TRUE(counter.accept(nonce, user, 1));
+  ASSERT_FALSE(counter.accept(nonce, user, 1));
+  ASSERT_TRUE(counter.accept(nonce, "other-user", 1));
+
+  //
+  // Out of order within the window
+  //
+  ASSERT_TRUE(counter.accept(nonce, user, 3));
+  ASSERT_TRUE(counter.accept(nonce, user, 2));
+  ASSERT_FALSE(counter.accept(nonce, user, 2));
+  ASSERT_FALSE(counter.accept(nonce, user, 3));
+
+  //
+  // Counts that fell out of the window are rejected
+  //
+  ASSERT_TRUE(counter.accept(nonce, user, 3 + SIPDigestNonceCounter::WINDOW_SIZE));
+  ASSERT_FALSE(counter.accept(nonce, user, 3));
+  ASSERT_TRUE(counter.accept(nonce, user, 4));
+  ASSERT_EQ(2, counter.size());
+}
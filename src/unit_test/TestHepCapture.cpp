@@ -0,0 +1,127 @@
+#include "gtest/gtest.h"
+#include "OSS/SIP/SIPHepCapture.h"
+#include <arpa/inet.h>
+#include <zlib.h>
+
+
+using OSS::SIP::SIPHepCapture;
+using OSS::Net::IPAddress;
+
+
+static std::vector<std::string> hep_packets;
+
+static void hep_collect(void* packet, int len)
+{
+  hep_packets.push_back(std::string((const char*)packet, len));
+}
+
+static OSS::UInt16 hep_uint16(const std::string& packet, std::size_t offset)
+{
+  OSS::UInt16 value;
+  memcpy(&value, packet.data() + offset, sizeof(value));
+  return ntohs(value);
+}
+
+TEST(HepCaptureTest, test_encode_v3)
+{
+  hep_packets.clear();
+  SIPHepCapture capture;
+  capture.setSender(hep_collect);
+  capture.setCaptureId(2001);
+
+  IPAddress src("192.168.1.10", 5060);
+  IPAddress dst("192.168.1.20", 5080);
+  std::string msg = "OPTIONS sip:bob@example.com SIP/2.0\r\n\r\n";
+
+  ASSERT_TRUE(capture.capture(IPAddress::UDP, src, dst, msg.data(), msg.size()));
+  ASSERT_TRUE(capture.capture(IPAddress::UDP, dst, src, msg.data(), msg.size()));
+  ASSERT_EQ(capture.flush(), 2);
+  ASSERT_EQ(hep_packets.size(), 2);
+
+  const std::string& packet = hep_packets[0];
+  ASSERT_EQ(packet.substr(0, 4), "HEP3");
+  ASSERT_EQ(hep_uint16(packet, 4), packet.size());
+  ASSERT_EQ(packet.substr(packet.size() - msg.size()), msg);
+
+  //
+  // The payload chunk header precedes the payload
+  //
+  std::size_t chunk = packet.size() - msg.size() - 6;
+  ASSERT_EQ(hep_uint16(packet, chunk + 2), 0x000f);
+  ASSERT_EQ(hep_uint16(packet, chunk + 4), msg.size() + 6);
+
+  SIPHepCapture::Stats stats = capture.getStats();
+  ASSERT_EQ(stats.captured, 2);
+  ASSERT_EQ(stats.sent, 2);
+  ASSERT_EQ(stats.batches, 1);
+  ASSERT_EQ(stats.dropped, 0);
+}
+
+TEST(HepCaptureTest, test_compressed_payload)
+{
+  hep_packets.clear();
+  SIPHepCapture capture;
+  capture.setSender(hep_collect);
+  capture.setCompression(true);
+
+  IPAddress src("10.0.0.1", 5060);
+  IPAddress dst("10.0.0.2", 5060);
+  std::string msg;
+  for (int i = 0; i < 20; i++)
+    msg += "Via: SIP/2.0/UDP 10.0.0.1:5060;branch=z9hG4bK776asdhds\r\n";
+
+  ASSERT_TRUE(capture.capture(IPAddress::TCP, src, dst, msg.data(), msg.size()));
+  ASSERT_EQ(capture.flush(), 1);
+  ASSERT_EQ(hep_packets.size(), 1);
+  const std::string& packet = hep_packets[0];
+  ASSERT_LT(packet.size(), msg.size());
+
+  //
+  // Find the compressed payload chunk and inflate it
+  //
+  std::size_t offset = 6;
+  std::string zipped;
+  while (offset + 6 <= packet.size())
+  {
+    OSS::UInt16 type = hep_uint16(packet, offset + 2);
+    OSS::UInt16 length = hep_uint16(packet, offset + 4);
+    if (type == 0x0010)
+      zipped = packet.substr(offset + 6, length - 6);
+    offset += length;
+  }
+  ASSERT_FALSE(zipped.empty());
+
+  std::vector<Bytef> inflated(msg.size());
+  uLongf inflatedLen = inflated.size();
+  ASSERT_EQ(uncompress(&inflated[0], &inflatedLen, (const Bytef*)zipped.data(), zipped.size()), Z_OK);
+  ASSERT_EQ(std::string((const char*)&inflated[0], inflatedLen), msg);
+}
+
+TEST(HepCaptureTest, test_drop_when_full)
+{
+  hep_packets.clear();
+  SIPHepCapture capture(4);
+  capture.setSender(hep_collect);
+  ASSERT_EQ(capture.capacity(), 4);
+
+  IPAddress src("::1", 5060);
+  IPAddress dst("::1", 5062);
+  std::string msg = "SIP/2.0 200 OK\r\n\r\n";
+
+  for (int i = 0; i < 6; i++)
+    capture.capture(IPAddress::UDP, src, dst, msg.data(), msg.size());
+
+  SIPHepCapture::Stats stats = capture.getStats();
+  ASSERT_EQ(stats.captured, 4);
+  ASSERT_EQ(stats.dropped, 2);
+
+  ASSERT_EQ(capture.flush(), 4);
+  ASSERT_EQ(capture.flush(), 0);
+
+  //
+  // Slots are reusable once flushed
+  //
+  ASSERT_TRUE(capture.capture(IPAddress::UDP, src, dst, msg.data(), msg.size()));
+  ASSERT_EQ(capture.flush(), 1);
+  ASSERT_EQ(hep_packets.size(), 5);
+}
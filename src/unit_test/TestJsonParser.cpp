@@ -0,0 +1,181 @@
+#include "gtest/gtest.h"
+#include <cstring>
+#include <cstdlib>
+#include "OSS/JSON/Json.h"
+#include "OSS/SIP/B2BUA/SIPB2BDialogData.h"
+
+
+using OSS::JSON::JsonParser;
+using OSS::JSON::JsonWriter;
+using OSS::SIP::B2BUA::SIPB2BDialogData;
+
+
+struct CollectingHandler
+{
+  bool onNull() { values.push_back("null"); return true; }
+  bool onBoolean(bool value) { values.push_back(value ? "true" : "false"); return true; }
+  bool onNumber(double) { values.push_back("number"); return true; }
+  bool onString(const char* value, std::size_t size) { values.push_back(std::string(value, size)); return true; }
+  bool onKey(const char* value, std::size_t size) { values.push_back("key:" + std::string(value, size)); return true; }
+  bool onObjectBegin() { values.push_back("{"); return true; }
+  bool onObjectEnd() { values.push_back("}"); return true; }
+  bool onArrayBegin() { values.push_back("["); return true; }
+  bool onArrayEnd() { values.push_back("]"); return true; }
+  std::vector<std::string> values;
+};
+
+static bool parse_error(const char* document, JsonParser::Error expected)
+{
+  JsonParser parser;
+  CollectingHandler handler;
+  return !parser.parse(document, std::strlen(document), handler) && parser.getError() == expected;
+}
+
+TEST(JsonParserTest, test_dom_round_trip)
+{
+  std::string document = "{\"a\":1,\"b\":[true,false,null,\"x\\n\"],\"c\":{\"d\":-1500,\"e\":0.1}}";
+  json::Object object;
+  ASSERT_TRUE(OSS::JSON::json_parse_string(document, object));
+
+  json::Array array = object["b"];
+  ASSERT_EQ(array.Size(), 4);
+  ASSERT_EQ(((json::String)array[3]).Value(), "x\n");
+  json::Object child = object["c"];
+  ASSERT_EQ(((json::Number)child["d"]).Value(), -1500);
+
+  std::string output;
+  ASSERT_TRUE(OSS::JSON::json_object_to_string(object, output));
+  ASSERT_EQ(output, document);
+
+  //
+  // The legacy reader must accept what the writer produces
+  //
+  std::stringstream strm;
+  strm << output;
+  json::Object legacy;
+  json::Reader::Read(legacy, strm);
+  ASSERT_TRUE(legacy == object);
+}
+
+TEST(JsonParserTest, test_errors)
+{
+  ASSERT_TRUE(parse_error("", JsonParser::ERROR_UNEXPECTED_END));
+  ASSERT_TRUE(parse_error("\"abc", JsonParser::ERROR_UNEXPECTED_END));
+  ASSERT_TRUE(parse_error("{\"a\":1,}", JsonParser::ERROR_UNEXPECTED_CHARACTER));
+  ASSERT_TRUE(parse_error("[1 2]", JsonParser::ERROR_UNEXPECTED_CHARACTER));
+  ASSERT_TRUE(parse_error("{\"a\" 1}", JsonParser::ERROR_UNEXPECTED_CHARACTER));
+  ASSERT_TRUE(parse_error("01", JsonParser::ERROR_TRAILING_DATA));
+  ASSERT_TRUE(parse_error("1.", JsonParser::ERROR_INVALID_NUMBER));
+  ASSERT_TRUE(parse_error("[1]x", JsonParser::ERROR_TRAILING_DATA));
+  ASSERT_TRUE(parse_error("\"\\ud800\"", JsonParser::ERROR_INVALID_ESCAPE));
+
+  std::string deep(JsonParser::DEFAULT_MAX_DEPTH + 1, '[');
+  ASSERT_TRUE(parse_error(deep.c_str(), JsonParser::ERROR_TOO_DEEP));
+
+  json::Object object;
+  OSS::JSON::Exception e;
+  ASSERT_FALSE(OSS::JSON::json_parse("{\"a\":1,\"a\":2}", 13, object, e));
+  ASSERT_FALSE(OSS::JSON::json_parse("[1]", 3, object, e));
+}
+
+TEST(JsonParserTest, test_escapes)
+{
+  const char* document = "[\"\\/\\\\\\\"\\t\", \"\\u0041\\u00e9\\ud83d\\ude00\"]";
+  JsonParser parser;
+  CollectingHandler handler;
+  ASSERT_TRUE(parser.parse(document, std::strlen(document), handler));
+  ASSERT_EQ(handler.values.size(), 4);
+  ASSERT_EQ(handler.values[1], "/\\\"\t");
+  ASSERT_EQ(handler.values[2], "A\xc3\xa9\xf0\x9f\x98\x80");
+}
+
+TEST(JsonParserTest, test_control_characters)
+{
+  //
+  // Accepted like the legacy reader did unless strict
+  //
+  const char* document = "[\"a\tb\nc\", \"d\\te\x01\"]";
+  JsonParser parser;
+  CollectingHandler handler;
+  ASSERT_TRUE(parser.parse(document, std::strlen(document), handler));
+  ASSERT_EQ(handler.values[1], "a\tb\nc");
+  ASSERT_EQ(handler.values[2], "d\te\x01");
+
+  parser.setStrict(true);
+  ASSERT_FALSE(parser.parse(document, std::strlen(document), handler));
+  ASSERT_EQ(parser.getError(), JsonParser::ERROR_INVALID_STRING);
+  ASSERT_EQ(parser.getErrorOffset(), 3);
+
+  json::Object object;
+  ASSERT_TRUE(OSS::JSON::json_parse_string("{\"sdp\":\"v=0\r\n\"}", object));
+  ASSERT_EQ(((json::String)object["sdp"]).Value(), "v=0\r\n");
+}
+
+TEST(JsonParserTest, test_in_situ)
+{
+  char document[] = "{\"k\\n\":\"a\\tb\\u0041\",\"plain\":\"value\"}";
+  JsonParser parser;
+  CollectingHandler handler;
+  ASSERT_TRUE(parser.parseInSitu(document, std::strlen(document), handler));
+  ASSERT_EQ(handler.values.size(), 6);
+  ASSERT_EQ(handler.values[1], "key:k\n");
+  ASSERT_EQ(handler.values[2], "a\tbA");
+  ASSERT_EQ(handler.values[4], "value");
+}
+
+TEST(JsonParserTest, test_numbers)
+{
+  const char* numbers[] = { "0", "-0", "0.1", "1e22", "123456789012345", "12345678901234567890",
+    "1.7976931348623157e308", "5e-324", "-2.5E-3", "3.141592653589793" };
+  for (std::size_t i = 0; i < sizeof(numbers) / sizeof(numbers[0]); i++)
+  {
+    json::UnknownElement element;
+    OSS::JSON::Exception e;
+    ASSERT_TRUE(OSS::JSON::json_parse(numbers[i], std::strlen(numbers[i]), element, e));
+    ASSERT_EQ(((const json::Number&)element).Value(), std::strtod(numbers[i], 0));
+  }
+}
+
+TEST(JsonParserTest, test_writer)
+{
+  std::string buffer;
+  JsonWriter writer(buffer);
+  writer.beginObject();
+  writer.key("x"); writer.number(0.1);
+  writer.key("y"); writer.integer(-42);
+  writer.key("z");
+  writer.beginArray();
+  writer.null();
+  writer.string("q\x01\"");
+  writer.boolean(true);
+  writer.endArray();
+  writer.key("n"); writer.number(1.0 / 0.0);
+  writer.endObject();
+  ASSERT_EQ(buffer, "{\"x\":0.1,\"y\":-42,\"z\":[null,\"q\\u0001\\\"\",true],\"n\":null}");
+}
+
+TEST(JsonParserTest, test_dialog_data)
+{
+  SIPB2BDialogData dialog;
+  dialog.sessionId = "4147414987334546318926127303";
+  dialog.leg1.callId = "call-id@192.168.1.10";
+  dialog.leg1.from = "<sip:32017@example.com>;tag=\"1\"";
+  dialog.leg1.localSdp = "v=0\r\no=Z 0 0 IN IP4 192.168.1.10\r\n";
+  dialog.leg1.localCSeq = 2;
+  dialog.leg2.routeSet.push_back("<sip:203.0.113.40:5060;lr>");
+  dialog.leg2.routeSet.push_back("<sip:203.0.113.41:5060;lr>");
+  dialog.timeStamp = 1410675320642LL;
+
+  std::string json;
+  dialog.toJsonString(json);
+
+  SIPB2BDialogData parsed;
+  parsed.fromJsonString(json);
+  ASSERT_EQ(parsed.sessionId, dialog.sessionId);
+  ASSERT_EQ(parsed.leg1.callId, dialog.leg1.callId);
+  ASSERT_EQ(parsed.leg1.from, dialog.leg1.from);
+  ASSERT_EQ(parsed.leg1.localSdp, dialog.leg1.localSdp);
+  ASSERT_EQ(parsed.leg1.localCSeq, dialog.leg1.localCSeq);
+  ASSERT_EQ(parsed.leg2.routeSet, dialog.leg2.routeSet);
+  ASSERT_EQ(parsed.timeStamp, dialog.timeStamp);
+}
@@ -0,0 +1,120 @@
+#include "gtest/gtest.h"
+#include "OSS/UTL/MemoryArena.h"
+#include "OSS/UTL/PropertyMapObject.h"
+#include <vector>
+
+
+using OSS::UTL::MemoryArena;
+using OSS::UTL::ArenaAllocator;
+using OSS::UTL::ArenaString;
+
+
+TEST(MemoryArenaTest, test_allocate_and_release)
+{
+  MemoryArena arena(128);
+  void* first = arena.allocate(10);
+  void* second = arena.allocate(10);
+  ASSERT_TRUE(first != 0);
+  ASSERT_TRUE(second != 0);
+  ASSERT_EQ(0u, reinterpret_cast<std::size_t>(second) % sizeof(void*));
+
+  //
+  // Larger than a chunk gets a dedicated chunk
+  //
+  char* big = static_cast<char*>(arena.allocate(4096));
+  big[0] = 'x';
+  big[4095] = 'y';
+
+  MemoryArena::Stats stats = arena.getStats();
+  ASSERT_EQ(3u, stats.allocations);
+  ASSERT_EQ(2u, stats.heapAllocations);
+
+  arena.release();
+  stats = arena.getStats();
+  ASSERT_EQ(1u, stats.releases);
+
+  //
+  // The arena remains usable after release
+  //
+  ASSERT_TRUE(arena.allocate(10) != 0);
+}
+
+TEST(MemoryArenaTest, test_arena_containers)
+{
+  MemoryArena arena;
+  {
+    ArenaAllocator<int> allocator(&arena);
+    std::vector<int, ArenaAllocator<int> > numbers(allocator);
+    for (int i = 0; i < 1000; i++)
+      numbers.push_back(i);
+    ASSERT_EQ(999, numbers.back());
+
+    ArenaString str("This string is long enough to skip the small string buffer", ArenaAllocator<char>(&arena));
+    ASSERT_STREQ("This string is long enough to skip the small string buffer", str.c_str());
+  }
+  ASSERT_TRUE(arena.getStats().allocations > 1);
+
+  //
+  // Null arena falls back to the heap
+  //
+  std::vector<int, ArenaAllocator<int> > heapNumbers;
+  heapNumbers.push_back(1);
+  ASSERT_EQ(1, heapNumbers.front());
+}
+
+TEST(MemoryArenaTest, test_property_map_arena)
+{
+  MemoryArena arena;
+  OSS::PropertyMapObject properties(&arena);
+  properties.setProperty("property-0", "value-0");
+  properties.setProperty("property-1", "value-1");
+  properties.setProperty("property-1", "value-2");
+  ASSERT_EQ("value-0", properties.getProperty("property-0"));
+  ASSERT_EQ("value-2", properties.getProperty("property-1"));
+  ASSERT_TRUE(arena.getStats().allocations > 0);
+
+  //
+  // Copies and assignments do not share the arena
+  //
+  OSS::PropertyMapObject copy(properties);
+  OSS::PropertyMapObject assigned;
+  assigned = properties;
+  properties.clearProperties();
+  arena.release();
+  ASSERT_EQ("value-2", copy.getProperty("property-1"));
+  ASSERT_EQ("value-0", assigned.getProperty("property-0"));
+}
+
+TEST(MemoryArenaTest, test_property_map_updates)
+{
+  MemoryArena arena;
+  OSS::PropertyMapObject properties(&arena);
+  std::string key = "a-property-name-long-enough-to-skip-the-small-string-buffer";
+  std::string value = "a-value-long-enough-to-skip-the-small-string-buffer";
+  properties.setProperty(key, value);
+
+  //
+  // Lookups and overwrites that fit the value do not touch the arena
+  //
+  OSS::UInt64 bytes = arena.getStats().bytesAllocated;
+  for (int i = 0; i < 1000; i++)
+  {
+    properties.setProperty(key, value);
+    ASSERT_EQ(value, properties.getProperty(key));
+    ASSERT_EQ("", properties.getProperty(key + "-missing"));
+  }
+  ASSERT_EQ(bytes, arena.getStats().bytesAllocated);
+
+  //
+  // A growing value doubles its buffer so the arena grows with the
+  // logarithm of the updates
+  //
+  std::size_t allocations = arena.getStats().allocations;
+  for (int i = 0; i < 1000; i++)
+  {
+    value += "x";
+    properties.setProperty(key, value);
+  }
+  ASSERT_EQ(value, properties.getProperty(key));
+  ASSERT_LT(arena.getStats().allocations - allocations, 10u);
+}
@@ -0,0 +1,91 @@
+#include "gtest/gtest.h"
+#include "OSS/Metrics/MetricsRegistry.h"
+#include "OSS/Metrics/InfluxExporter.h"
+#include <boost/thread.hpp>
+
+
+using namespace OSS::Metrics;
+
+
+static void metrics_count(Counter* pCounter, int count)
+{
+  for (int i = 0; i < count; i++)
+    pCounter->increment();
+}
+
+TEST(MetricsTest, test_counter_threads)
+{
+  Counter counter("test.counter");
+  boost::thread_group threads;
+  for (int i = 0; i < 4; i++)
+    threads.create_thread(boost::bind(metrics_count, &counter, 10000));
+  threads.join_all();
+  ASSERT_EQ(counter.value(), 40000);
+}
+
+TEST(MetricsTest, test_histogram_buckets)
+{
+  ASSERT_EQ(Histogram::bucketIndex(0), 0);
+  ASSERT_EQ(Histogram::bucketIndex(31), 31);
+  ASSERT_EQ(Histogram::bucketIndex(32), 32);
+  ASSERT_EQ(Histogram::bucketIndex(64), 48);
+  ASSERT_EQ(Histogram::bucketIndex(~0ULL), Histogram::BUCKET_COUNT - 1);
+
+  //
+  // Every value maps to a bucket whose range contains it and the
+  // relative error stays within 1/16
+  //
+  for (OSS::UInt64 value = 1; value < (1ULL << 36); value = value * 3 / 2 + 1)
+  {
+    std::size_t index = Histogram::bucketIndex(value);
+    OSS::UInt64 high = Histogram::bucketValue(index);
+    ASSERT_GE(high, value);
+    if (index)
+      ASSERT_LT(Histogram::bucketValue(index - 1), value);
+    ASSERT_LE((double)(high - value) / value, 1.0 / 16);
+  }
+}
+
+TEST(MetricsTest, test_histogram_percentiles)
+{
+  Histogram histogram("test.latency");
+  for (OSS::UInt64 i = 1; i <= 1000; i++)
+    histogram.record(i);
+
+  Histogram::Snapshot snapshot = histogram.snapshot();
+  ASSERT_EQ(snapshot.count, 1000);
+  ASSERT_EQ(snapshot.sum, 500500);
+  ASSERT_EQ(snapshot.max, 1000);
+  ASSERT_NEAR(snapshot.p50, 500, 500 / 16);
+  ASSERT_NEAR(snapshot.p90, 900, 900 / 16);
+  ASSERT_NEAR(snapshot.p99, 990, 990 / 16);
+  ASSERT_LE(snapshot.p999, 1000);
+
+  histogram.reset();
+  ASSERT_EQ(histogram.snapshot().count, 0);
+}
+
+TEST(MetricsTest, test_line_protocol)
+{
+  MetricsRegistry registry;
+  registry.counter("sip.received").add(10);
+  registry.gauge("sip transactions").set(3);
+  registry.histogram("sip.dispatch.us").record(20);
+
+  InfluxExporter exporter(registry);
+  exporter.setTag("host", "sbc 1");
+
+  MetricsRegistry::Samples samples;
+  registry.snapshot(samples);
+  std::string lines;
+  exporter.formatLines(samples, 1000000000, lines);
+  ASSERT_NE(lines.find("sip.received,host=sbc\\ 1 value=10i,rate=0.00 1000000000\n"), std::string::npos);
+
+  registry.counter("sip.received").add(20);
+  samples.clear();
+  registry.snapshot(samples);
+  exporter.formatLines(samples, 3000000000ULL, lines);
+  ASSERT_NE(lines.find("sip.received,host=sbc\\ 1 value=30i,rate=10.00 3000000000\n"), std::string::npos);
+  ASSERT_NE(lines.find("sip\\ transactions,host=sbc\\ 1 value=3i"), std::string::npos);
+  ASSERT_NE(lines.find("sip.dispatch.us,host=sbc\\ 1 count=1i,mean=20.00,p50=20i"), std::string::npos);
+}
@@ -0,0 +1,93 @@
+#include "gtest/gtest.h"
+
+#include "OSS/build.h"
+#if ENABLE_FEATURE_REDIS
+#if OSS_HAVE_HIREDIS
+
+#include <boost/bind.hpp>
+#include "OSS/UTL/CoreUtils.h"
+#include "OSS/Persistent/RedisAsyncClient.h"
+
+
+using OSS::Persistent::RedisClient;
+using OSS::Persistent::RedisAsyncClient;
+using OSS::Persistent::RedisReply;
+
+static void set_reply(RedisReply* pResult, const RedisReply& reply)
+{
+  *pResult = reply;
+}
+
+TEST(TestRedisAsyncClient, FailFastWhenDown)
+{
+  //
+  // Nothing listens on port 1.  Commands must complete with an error on
+  // the calling thread instead of waiting for a reconnect.
+  //
+  RedisAsyncClient asyncClient("127.0.0.1", 1, 2);
+  ASSERT_FALSE(asyncClient.connect());
+  ASSERT_FALSE(asyncClient.isConnected());
+
+  RedisReply reply;
+  RedisAsyncClient::Command command;
+  command.push_back("GET");
+  command.push_back("test-redis-async-down");
+  asyncClient.execute(command, boost::bind(set_reply, &reply, _1));
+  ASSERT_TRUE(reply.isError());
+  ASSERT_EQ(asyncClient.getStats().errors, 1);
+  asyncClient.disconnect();
+}
+
+TEST(TestRedisAsyncClient, PipelineAndScan)
+{
+  RedisClient client("127.0.0.1", 6379);
+  if (!client.connect())
+  {
+#ifdef GTEST_SKIP
+    GTEST_SKIP() << "No redis server on 127.0.0.1:6379";
+#else
+    std::cout << "[  SKIPPED ] No redis server on 127.0.0.1:6379" << std::endl;
+    return;
+#endif
+  }
+
+  std::map<std::string, std::string> values;
+  for (int i = 0; i < 50; i++)
+    values["test-redis-async-" + OSS::string_from_number<int>(i)] = "value";
+  ASSERT_TRUE(client.mset(values, 30));
+
+  std::vector<std::string> keys;
+  ASSERT_TRUE(client.getKeys("test-redis-async-*", keys));
+  ASSERT_EQ(keys.size(), 50);
+
+  RedisAsyncClient asyncClient("127.0.0.1", 6379, 2);
+  ASSERT_TRUE(asyncClient.connect());
+
+  std::vector<RedisAsyncClient::ReplyFuture> replies;
+  for (std::map<std::string, std::string>::const_iterator iter = values.begin(); iter != values.end(); iter++)
+  {
+    RedisAsyncClient::Command command;
+    command.push_back("GET");
+    command.push_back(iter->first);
+    replies.push_back(asyncClient.execute(command, true));
+  }
+
+  for (std::vector<RedisAsyncClient::ReplyFuture>::iterator iter = replies.begin(); iter != replies.end(); iter++)
+  {
+    ASSERT_EQ(iter->get().str, "value");
+  }
+
+  asyncClient.disconnect();
+
+  for (std::vector<std::string>::const_iterator iter = keys.begin(); iter != keys.end(); iter++)
+  {
+    client.del(*iter);
+  }
+}
+
+#else
+
+TEST(NullTest, null_test_redis_async_client){}
+
+#endif
+#endif
@@ -0,0 +1,74 @@
+#include "gtest/gtest.h"
+#include "OSS/SIP/SBC/SBCChannelLimits.h"
+
+
+using OSS::SIP::SBC::SBCChannelLimits;
+
+
+TEST(SBCChannelLimitsTest, test_session_counted_once)
+{
+  SBCChannelLimits limits;
+  SBCChannelLimits::Limits prefixes;
+  prefixes["1800,1888"] = 2;
+  limits.loadDialPrefixes(prefixes);
+
+  std::size_t channelLimit = 0;
+  ASSERT_EQ(1u, limits.addCall("call-1", "18005551234", channelLimit));
+  ASSERT_EQ(2u, channelLimit);
+  ASSERT_EQ(1u, limits.addCall("call-1", "18005551234", channelLimit));
+  ASSERT_EQ(2u, limits.addCall("call-2", "18885551234", channelLimit));
+  ASSERT_EQ(0u, limits.addCall("call-3", "17005551234", channelLimit));
+
+  //
+  // Registering the same prefix again keeps its count
+  //
+  for (int i = 0; i < 100; i++)
+    limits.registerDialPrefix("1800,1888", 3);
+  ASSERT_EQ(2u, limits.getCallCount("1800"));
+  ASSERT_EQ(2u, limits.getPrefixCount());
+
+  ASSERT_EQ(1u, limits.removeCall("call-1", "18005551234"));
+  ASSERT_EQ(1u, limits.removeCall("call-1", "18005551234"));
+  ASSERT_EQ(0u, limits.removeCall("call-2", "18885551234"));
+}
+
+TEST(SBCChannelLimitsTest, test_remove_after_reload)
+{
+  SBCChannelLimits limits;
+  SBCChannelLimits::Limits prefixes;
+  prefixes["1800,1888"] = 2;
+  limits.loadDialPrefixes(prefixes);
+
+  std::size_t channelLimit = 0;
+  ASSERT_EQ(1u, limits.addCall("call-1", "18005551234", channelLimit));
+  ASSERT_EQ(2u, limits.addCall("call-2", "18885551234", channelLimit));
+  ASSERT_EQ(3u, limits.addCall("call-3", "18885551234", channelLimit));
+
+  //
+  // 1888 gets its own counter.  Calls added through the alias are still
+  // counted against 1800.
+  //
+  prefixes.clear();
+  prefixes["1800"] = 2;
+  prefixes["1888"] = 5;
+  limits.loadDialPrefixes(prefixes);
+  ASSERT_EQ(3u, limits.getCallCount("1800"));
+  ASSERT_EQ(0u, limits.getCallCount("1888"));
+
+  //
+  // Removing a call decrements the counter it was added to
+  //
+  ASSERT_EQ(2u, limits.removeCall("call-2", "18885551234"));
+  ASSERT_EQ(2u, limits.getCallCount("1800"));
+  ASSERT_EQ(0u, limits.getCallCount("1888"));
+
+  //
+  // A call seen again after the reload moves to the new counter
+  //
+  ASSERT_EQ(1u, limits.addCall("call-3", "18885551234", channelLimit));
+  ASSERT_EQ(5u, channelLimit);
+  ASSERT_EQ(1u, limits.getCallCount("1800"));
+  ASSERT_EQ(0u, limits.removeCall("call-3", "18885551234"));
+  ASSERT_EQ(0u, limits.removeCall("call-1", "18005551234"));
+  ASSERT_EQ(0u, limits.getCallCount("1800"));
+}
@@ -0,0 +1,86 @@
+#include "gtest/gtest.h"
+#include "OSS/SIP/SBC/SBCDialPrefixTrie.h"
+#include "OSS/UTL/CoreUtils.h"
+
+
+using OSS::SIP::SBC::SBCDialPrefixTrie;
+
+
+static SBCDialPrefixTrie::CounterPtr new_counter(const std::string& prefix, std::size_t limit = 10)
+{
+  return SBCDialPrefixTrie::CounterPtr(new SBCDialPrefixTrie::Counter(prefix, limit));
+}
+
+TEST(SBCDialPrefixTrieTest, test_longest_prefix_match)
+{
+  SBCDialPrefixTrie trie;
+  ASSERT_TRUE(trie.insert("1", new_counter("1")));
+  ASSERT_TRUE(trie.insert("1800", new_counter("1800")));
+  ASSERT_TRUE(trie.insert("180", new_counter("180")));
+  ASSERT_TRUE(trie.insert("+63", new_counter("+63")));
+  ASSERT_FALSE(trie.insert("", new_counter("")));
+  ASSERT_FALSE(trie.insert("18a", new_counter("18a")));
+  ASSERT_EQ(4u, trie.size());
+
+  //
+  // The map based lookup this replaces returned "180" for 18005551212
+  // because it stopped at the first match in key order
+  //
+  ASSERT_EQ("1800", trie.match("18005551212")->prefix);
+  ASSERT_EQ("180", trie.match("18015551212")->prefix);
+  ASSERT_EQ("1", trie.match("12125551212")->prefix);
+  ASSERT_EQ("1", trie.match("1")->prefix);
+  ASSERT_EQ("+63", trie.match("+639171234567")->prefix);
+  ASSERT_EQ("1", trie.match("1x800")->prefix);
+  ASSERT_FALSE(trie.match("2125551212"));
+  ASSERT_FALSE(trie.match(""));
+  ASSERT_FALSE(trie.match("alice"));
+
+  ASSERT_EQ("180", trie.find("180")->prefix);
+  ASSERT_FALSE(trie.find("18"));
+  ASSERT_FALSE(trie.find("18005551212"));
+}
+
+TEST(SBCDialPrefixTrieTest, test_aliases_share_counter)
+{
+  SBCDialPrefixTrie trie;
+  SBCDialPrefixTrie::CounterPtr tollFree = new_counter("1800");
+  ASSERT_TRUE(trie.insert("1800", tollFree));
+  ASSERT_TRUE(trie.insert("1888", tollFree));
+  ASSERT_TRUE(trie.insert("1877", tollFree));
+  ASSERT_TRUE(trie.insert("18885", new_counter("18885")));
+
+  ASSERT_EQ(tollFree, trie.match("18775551212"));
+  ASSERT_EQ(tollFree, trie.match("18880001212"));
+  ASSERT_EQ("18885", trie.match("18885551212")->prefix);
+
+  trie.match("18775551212")->count++;
+  trie.match("18005551212")->count++;
+  ASSERT_EQ(2u, tollFree->count);
+
+  //
+  // Replacing a mapping does not change the number of prefixes
+  //
+  ASSERT_TRUE(trie.insert("1877", new_counter("1877")));
+  ASSERT_EQ(4u, trie.size());
+  ASSERT_EQ("1877", trie.match("18775551212")->prefix);
+}
+
+TEST(SBCDialPrefixTrieTest, test_large_table)
+{
+  SBCDialPrefixTrie trie;
+  for (int i = 0; i < 40000; i++)
+  {
+    std::string prefix = "63" + OSS::string_from_number<int>(100000 + i);
+    ASSERT_TRUE(trie.insert(prefix, new_counter(prefix)));
+  }
+  ASSERT_TRUE(trie.insert("63", new_counter("63")));
+  ASSERT_EQ(40001u, trie.size());
+
+  for (int i = 0; i < 40000; i += 97)
+  {
+    std::string prefix = "63" + OSS::string_from_number<int>(100000 + i);
+    ASSERT_EQ(prefix, trie.match(prefix + "4567")->prefix);
+  }
+  ASSERT_EQ("63", trie.match("639999999")->prefix);
+}
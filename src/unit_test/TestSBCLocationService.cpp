@@ -0,0 +1,88 @@
+#include "gtest/gtest.h"
+#include "OSS/SIP/SBC/SBCLocationService.h"
+
+
+using OSS::SIP::SBC::SBCLocationService;
+using OSS::SIP::SBC::SBCRegistrationRecord;
+
+
+static SBCRegistrationRecord create_record(const std::string& aor, const std::string& contact, int expires, OSS::UInt64 timeStamp)
+{
+  SBCRegistrationRecord record;
+  record.aor() = aor;
+  record.contact() = contact;
+  record.expires() = expires;
+  record.timeStamp() = timeStamp;
+  return record;
+}
+
+TEST(SBCLocationServiceTest, test_bindings_per_aor)
+{
+  SBCLocationService locations;
+  locations.update("alice@x.com-c1-10.0.0.1:5060", create_record("alice@x.com", "sip:alice@10.0.0.1:5060", 3600, 1000));
+  locations.update("alice@x.com-c2-10.0.0.2:5060", create_record("alice@x.com", "sip:alice@10.0.0.2:5060", 3600, 1000));
+  locations.update("alice@x.com-bob-10.0.0.3:5060", create_record("alice@x.com-bob", "sip:bob@10.0.0.3:5060", 3600, 1000));
+  ASSERT_EQ(3u, locations.size());
+  ASSERT_EQ(2u, locations.aorCount());
+
+  //
+  // A wildcard scan for "alice@x.com-*" would have returned bob as well
+  //
+  SBCLocationService::Bindings bindings;
+  ASSERT_TRUE(locations.getBindings("alice@x.com", bindings, 2000));
+  ASSERT_EQ(2u, bindings.size());
+
+  //
+  // Updating an existing key replaces the record
+  //
+  locations.update("alice@x.com-c1-10.0.0.1:5060", create_record("alice@x.com", "sip:alice@10.0.0.9:5060", 3600, 1000));
+  bindings.clear();
+  ASSERT_TRUE(locations.getBindings("alice@x.com", bindings, 2000));
+  ASSERT_EQ(2u, bindings.size());
+  ASSERT_EQ(3u, locations.size());
+
+  ASSERT_TRUE(locations.remove("alice@x.com-c1-10.0.0.1:5060"));
+  ASSERT_FALSE(locations.remove("alice@x.com-c1-10.0.0.1:5060"));
+  ASSERT_TRUE(locations.remove("alice@x.com-c2-10.0.0.2:5060"));
+  bindings.clear();
+  ASSERT_FALSE(locations.getBindings("alice@x.com", bindings, 2000));
+  ASSERT_EQ(1u, locations.aorCount());
+}
+
+TEST(SBCLocationServiceTest, test_deadline_expiry)
+{
+  SBCLocationService locations;
+  locations.update("a-1-h", create_record("a", "sip:a@h1", 60, 0));
+  locations.update("a-2-h", create_record("a", "sip:a@h2", 120, 0));
+  locations.update("b-1-h", create_record("b", "sip:b@h", 0, 0));
+  ASSERT_EQ(60000u, locations.nextDeadline());
+
+  //
+  // Expired bindings are hidden before they are collected
+  //
+  SBCLocationService::Bindings bindings;
+  ASSERT_TRUE(locations.getBindings("a", bindings, 60000));
+  ASSERT_EQ(1u, bindings.size());
+  ASSERT_EQ("a-2-h", bindings.front().key);
+
+  SBCLocationService::Keys expired;
+  ASSERT_EQ(1u, locations.expire(60000, expired));
+  ASSERT_EQ("a-1-h", expired.front());
+  ASSERT_EQ(120000u, locations.nextDeadline());
+
+  //
+  // Refreshing a binding moves its deadline
+  //
+  locations.update("a-2-h", create_record("a", "sip:a@h2", 120, 100000));
+  expired.clear();
+  ASSERT_EQ(0u, locations.expire(200000, expired));
+  ASSERT_EQ(1u, locations.expire(220000, expired));
+  ASSERT_EQ(0u, locations.nextDeadline());
+
+  //
+  // Bindings without expiry are never collected
+  //
+  bindings.clear();
+  ASSERT_TRUE(locations.getBindings("b", bindings, 0xFFFFFFFF));
+  ASSERT_EQ(1u, locations.size());
+}
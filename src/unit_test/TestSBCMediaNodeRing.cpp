@@ -0,0 +1,111 @@
+#include "gtest/gtest.h"
+#include "OSS/SIP/SBC/SBCMediaNodeRing.h"
+#include "OSS/UTL/CoreUtils.h"
+#include <map>
+
+
+using OSS::SIP::SBC::SBCMediaNodeRing;
+
+
+static std::string session_key(int i)
+{
+  return "session-" + OSS::string_from_number<int>(i);
+}
+
+TEST(SBCMediaNodeRingTest, test_weighted_distribution)
+{
+  SBCMediaNodeRing ring;
+  ASSERT_TRUE(ring.addNode("tcp://10.0.0.1:40590", 1));
+  ASSERT_TRUE(ring.addNode("tcp://10.0.0.2:40590", 1));
+  ASSERT_TRUE(ring.addNode("tcp://10.0.0.3:40590", 2));
+  ASSERT_FALSE(ring.addNode("tcp://10.0.0.4:40590", 0));
+
+  std::map<std::string, int> counts;
+  for (int i = 0; i < 40000; i++)
+  {
+    std::string node;
+    ASSERT_TRUE(ring.getNode(session_key(i), node));
+    counts[node]++;
+  }
+
+  ASSERT_EQ(3u, counts.size());
+  //
+  // The node with twice the weight gets roughly half of the keys
+  //
+  ASSERT_GT(counts["tcp://10.0.0.3:40590"], 16000);
+  ASSERT_LT(counts["tcp://10.0.0.3:40590"], 24000);
+  ASSERT_GT(counts["tcp://10.0.0.1:40590"], 7000);
+  ASSERT_GT(counts["tcp://10.0.0.2:40590"], 7000);
+}
+
+TEST(SBCMediaNodeRingTest, test_minimal_remap)
+{
+  SBCMediaNodeRing ring;
+  for (int i = 0; i < 4; i++)
+    ring.addNode("node-" + OSS::string_from_number<int>(i));
+
+  std::map<std::string, std::string> before;
+  for (int i = 0; i < 10000; i++)
+    ring.getNode(session_key(i), before[session_key(i)]);
+
+  ring.addNode("node-4");
+
+  int moved = 0;
+  for (int i = 0; i < 10000; i++)
+  {
+    std::string node;
+    ring.getNode(session_key(i), node);
+    if (node != before[session_key(i)])
+    {
+      //
+      // Keys only ever move to the new node
+      //
+      ASSERT_EQ("node-4", node);
+      moved++;
+    }
+  }
+  ASSERT_GT(moved, 1000);
+  ASSERT_LT(moved, 3000);
+
+  ring.removeNode("node-4");
+  for (int i = 0; i < 10000; i++)
+  {
+    std::string node;
+    ring.getNode(session_key(i), node);
+    ASSERT_EQ(before[session_key(i)], node);
+  }
+}
+
+TEST(SBCMediaNodeRingTest, test_ejection)
+{
+  SBCMediaNodeRing ring(2, 50);
+  ring.addNode("node-0");
+  ring.addNode("node-1");
+
+  ring.markFailure("node-0");
+  ASSERT_TRUE(ring.isHealthy("node-0"));
+  ring.markFailure("node-0");
+  ASSERT_FALSE(ring.isHealthy("node-0"));
+
+  for (int i = 0; i < 1000; i++)
+  {
+    std::string node;
+    ASSERT_TRUE(ring.getNode(session_key(i), node));
+    ASSERT_EQ("node-1", node);
+  }
+
+  ring.markFailure("node-1");
+  ring.markFailure("node-1");
+  std::string node;
+  ASSERT_FALSE(ring.getNode("session", node));
+
+  //
+  // Ejected nodes are retried once the eject time elapses
+  //
+  OSS::thread_sleep(60);
+  ASSERT_TRUE(ring.getNode("session", node));
+  ring.markSuccess("node-0");
+  ring.markSuccess("node-1");
+  ASSERT_TRUE(ring.isHealthy("node-0"));
+  ASSERT_TRUE(ring.isHealthy("node-1"));
+}
@@ -0,0 +1,272 @@
+#include "gtest/gtest.h"
+#include "OSS/SIP/SBC/SBCMediaProxy.h"
+#include "OSS/UTL/CoreUtils.h"
+#include <boost/bind.hpp>
+#include <boost/atomic.hpp>
+#include <map>
+
+
+using OSS::SIP::SBC::SBCMediaProxy;
+
+
+class StandInMediaNode
+  /// ROUTER socket answering rtp.handleSDP like a media node.  Sessions
+  /// whose id starts with "full-" get the error a node at its session
+  /// limit replies with.
+{
+public:
+  StandInMediaNode(const std::string& address) :
+    _context(1),
+    _address(address),
+    _terminate(false)
+  {
+    _pThread = new boost::thread(boost::bind(&StandInMediaNode::run, this));
+  }
+
+  ~StandInMediaNode()
+  {
+    _terminate = true;
+    _pThread->join();
+    delete _pThread;
+  }
+
+  bool hasSession(const std::string& sessionId)
+  {
+    OSS::mutex_critic_sec_lock lock(_mutex);
+    return _sessions.find(sessionId) != _sessions.end();
+  }
+
+  std::size_t getSessionCount()
+  {
+    OSS::mutex_critic_sec_lock lock(_mutex);
+    return _sessions.size();
+  }
+
+  const std::string& getAddress() const
+  {
+    return _address;
+  }
+
+private:
+  void run()
+  {
+    zmq::socket_t socket(_context, ZMQ_ROUTER);
+    int linger = 0;
+    socket.setsockopt(ZMQ_LINGER, &linger, sizeof(linger));
+    socket.bind(_address.c_str());
+
+    while (!_terminate)
+    {
+      zmq::pollitem_t items[] = { { socket, 0, ZMQ_POLLIN, 0 } };
+      zmq::poll(&items[0], 1, 100);
+      if (!(items[0].revents & ZMQ_POLLIN))
+        continue;
+
+      //
+      // [identity][request-id][empty][command][payload]
+      //
+      std::vector<std::string> frames;
+      int more = 1;
+      while (more)
+      {
+        zmq::message_t frame;
+        socket.recv(&frame);
+        frames.push_back(std::string(static_cast<char*>(frame.data()), frame.size()));
+        size_t size = sizeof(more);
+        socket.getsockopt(ZMQ_RCVMORE, &more, &size);
+      }
+      if (frames.size() != 5)
+        continue;
+
+      std::string sessionId;
+      const std::string key = "\"sessionId\":\"";
+      std::size_t start = frames[4].find(key);
+      if (start != std::string::npos)
+      {
+        start += key.size();
+        sessionId = frames[4].substr(start, frames[4].find('"', start) - start);
+      }
+
+      std::string reply;
+      if (sessionId.find("full-") == 0)
+      {
+        reply = "{\"error\":\"Maximum session count reached\"}";
+      }
+      else
+      {
+        OSS::mutex_critic_sec_lock lock(_mutex);
+        _sessions[sessionId]++;
+        reply = "{\"sdp\":\"v=0\\r\\n\",\"sessionCount\":" + OSS::string_from_number<std::size_t>(_sessions.size()) + "}";
+      }
+
+      for (int i = 0; i < 3; i++)
+      {
+        zmq::message_t frame(frames[i].size());
+        memcpy(frame.data(), frames[i].data(), frames[i].size());
+        socket.send(frame, ZMQ_SNDMORE);
+      }
+      zmq::message_t payload(reply.size());
+      memcpy(payload.data(), reply.data(), reply.size());
+      socket.send(payload);
+    }
+  }
+
+  zmq::context_t _context;
+  std::string _address;
+  boost::atomic<bool> _terminate;
+  boost::thread* _pThread;
+  OSS::mutex_critic_sec _mutex;
+  std::map<std::string, int> _sessions;
+};
+
+class SweepableMediaProxy : public SBCMediaProxy
+  /// Exposes the pin sweep so it can be run without waiting for a node
+  /// reply past the sweep interval
+{
+public:
+  SweepableMediaProxy() : SBCMediaProxy(0)
+  {
+  }
+
+  using SBCMediaProxy::expireSessions;
+};
+
+static bool send_offer(SBCMediaProxy& proxy, const std::string& sessionId)
+{
+  OSS::Net::IPAddress address("127.0.0.1", 5060);
+  std::string sdp = "v=0\r\n";
+  OSS::RTP::RTPProxy::Attributes attributes;
+  return proxy.handleSDP("", sessionId, address, address, address, address, address,
+    OSS::RTP::RTPProxySession::INVITE, sdp, attributes);
+}
+
+static std::string session_id(int i)
+{
+  return "session-" + OSS::string_from_number<int>(i);
+}
+
+TEST(SBCMediaProxyTest, test_configured_nodes)
+{
+  StandInMediaNode node1("tcp://127.0.0.1:41690");
+  StandInMediaNode node2("tcp://127.0.0.1:41691");
+
+  SBCMediaProxy proxy(0);
+  SBCMediaProxy::NodeWeights nodes;
+  nodes[node1.getAddress()] = 1;
+  nodes[node2.getAddress()] = 1;
+  ASSERT_TRUE(proxy.configureNodes(nodes));
+  ASSERT_TRUE(proxy.initialize(true));
+  ASSERT_FALSE(proxy.isLegacyMode());
+
+  for (int i = 0; i < 100; i++)
+    ASSERT_TRUE(send_offer(proxy, session_id(i)));
+  ASSERT_EQ(100u, node1.getSessionCount() + node2.getSessionCount());
+  ASSERT_GT(node1.getSessionCount(), 0u);
+  ASSERT_GT(node2.getSessionCount(), 0u);
+
+  //
+  // Dropping a node from the configuration moves its sessions.  Sessions
+  // pinned to the remaining node stay there.
+  //
+  nodes.erase(node2.getAddress());
+  ASSERT_TRUE(proxy.configureNodes(nodes));
+  ASSERT_FALSE(proxy.ring().hasNode(node2.getAddress()));
+  for (int i = 0; i < 100; i++)
+    ASSERT_TRUE(send_offer(proxy, session_id(i)));
+  ASSERT_EQ(100u, node1.getSessionCount());
+
+  //
+  // Nodes can be added back at runtime
+  //
+  std::size_t count = node1.getSessionCount() + node2.getSessionCount();
+  ASSERT_TRUE(proxy.addNode(node2.getAddress(), 2));
+  ASSERT_TRUE(proxy.ring().hasNode(node2.getAddress()));
+  for (int i = 100; i < 200; i++)
+    ASSERT_TRUE(send_offer(proxy, session_id(i)));
+  ASSERT_EQ(count + 100, node1.getSessionCount() + node2.getSessionCount());
+  ASSERT_TRUE(proxy.removeNode(node2.getAddress()));
+  ASSERT_FALSE(proxy.removeNode(node2.getAddress()));
+}
+
+TEST(SBCMediaProxyTest, test_node_errors_keep_node_healthy)
+{
+  StandInMediaNode node("tcp://127.0.0.1:41692");
+
+  SBCMediaProxy proxy(0);
+  ASSERT_TRUE(proxy.addNode(node.getAddress()));
+  ASSERT_TRUE(proxy.initialize(true));
+
+  //
+  // A node at its session limit answers with an error.  It is reachable
+  // and must not be ejected.
+  //
+  for (int i = 0; i < 2 * OSS::SIP::SBC::SBCMediaNodeRing::DEFAULT_MAX_FAILURES; i++)
+    ASSERT_FALSE(send_offer(proxy, "full-" + session_id(i)));
+  ASSERT_TRUE(proxy.ring().isHealthy(node.getAddress()));
+  ASSERT_TRUE(send_offer(proxy, session_id(0)));
+  ASSERT_TRUE(node.hasSession(session_id(0)));
+}
+
+TEST(SBCMediaProxyTest, test_legacy_mapping)
+{
+  std::vector<boost::shared_ptr<StandInMediaNode> > nodes;
+  for (int i = 0; i < 5; i++)
+    nodes.push_back(boost::shared_ptr<StandInMediaNode>(new StandInMediaNode("tcp://127.0.0.1:4059" + OSS::string_from_number<int>(i))));
+
+  SBCMediaProxy proxy(0);
+  ASSERT_TRUE(proxy.initialize(true));
+  ASSERT_TRUE(proxy.isLegacyMode());
+
+  //
+  // The 5th character of the session id picks the node as it did before
+  // the ring was introduced.  Digits 5 to 9 spill over to nodes 0 to 4.
+  //
+  ASSERT_TRUE(send_offer(proxy, "abcd3-call"));
+  ASSERT_TRUE(nodes[3]->hasSession("abcd3-call"));
+  ASSERT_TRUE(send_offer(proxy, "abcd7-call"));
+  ASSERT_TRUE(nodes[2]->hasSession("abcd7-call"));
+  ASSERT_TRUE(send_offer(proxy, "abcdx-call"));
+  ASSERT_TRUE(nodes[0]->hasSession("abcdx-call"));
+  ASSERT_TRUE(send_offer(proxy, "abc"));
+  ASSERT_TRUE(nodes[0]->hasSession("abc"));
+}
+
+TEST(SBCMediaProxyTest, test_session_pins)
+{
+  StandInMediaNode node("tcp://127.0.0.1:41693");
+
+  SweepableMediaProxy proxy;
+  ASSERT_TRUE(proxy.addNode(node.getAddress()));
+  ASSERT_TRUE(proxy.initialize(true));
+
+  //
+  // Offers the node rejects leave no pin behind
+  //
+  for (int i = 0; i < 10; i++)
+    ASSERT_FALSE(send_offer(proxy, "full-" + session_id(i)));
+  ASSERT_EQ(0u, proxy.getPinnedSessionCount());
+
+  for (int i = 0; i < 10; i++)
+    ASSERT_TRUE(send_offer(proxy, session_id(i)));
+  ASSERT_EQ(10u, proxy.getPinnedSessionCount());
+  ASSERT_TRUE(proxy.removeSession(session_id(0)));
+  ASSERT_EQ(9u, proxy.getPinnedSessionCount());
+
+  //
+  // Sessions that end without being removed age out
+  //
+  proxy.expireSessions(OSS::getTime());
+  ASSERT_EQ(9u, proxy.getPinnedSessionCount());
+  proxy.expireSessions(OSS::getTime() + (OSS::UInt64)proxy.getSessionPinLifetime() * 1000 + 1);
+  ASSERT_EQ(0u, proxy.getPinnedSessionCount());
+
+  //
+  // A pin is refreshed by every SDP handled for the session
+  //
+  proxy.setSessionPinLifetime(1);
+  ASSERT_TRUE(send_offer(proxy, session_id(1)));
+  proxy.setSessionPinLifetime(3600);
+  ASSERT_TRUE(send_offer(proxy, session_id(1)));
+  proxy.expireSessions(OSS::getTime() + 2000);
+  ASSERT_EQ(1u, proxy.getPinnedSessionCount());
+}
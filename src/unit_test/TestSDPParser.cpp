@@ -0,0 +1,171 @@
+#include "gtest/gtest.h"
+#include "OSS/OSS.h"
+#include "OSS/SDP/SDPSession.h"
+#include "OSS/SDP/SDPParser.h"
+#include "OSS/SDP/SDPRewriter.h"
+
+
+using OSS::SDP::SDPMedia;
+using OSS::SDP::SDPSession;
+using OSS::SDP::SDPParser;
+using OSS::SDP::SDPRewriter;
+
+
+static std::string test_sdp()
+{
+  std::stringstream sdp;
+  sdp << "v=0" << "\r\n";
+  sdp << "o=jdoe 2890844526 2890842807 IN IP4 10.47.16.5" << "\r\n";
+  sdp << "s=SDP Seminar" << "\r\n";
+  sdp << "c=IN IP4 10.0.0.1" << "\r\n";
+  sdp << "t=0 0" << "\r\n";
+  sdp << "m=audio 49170 RTP/AVP 0 8 101" << "\r\n";
+  sdp << "a=rtpmap:101 telephone-event/8000" << "\r\n";
+  sdp << "a=ptime:20" << "\r\n";
+  sdp << "a=candidate:1 1 UDP 2130706431 10.0.0.1 49170 typ host" << "\r\n";
+  sdp << "a=candidate:2 1 UDP 1694498815 203.0.113.1 49170 typ srflx raddr 10.0.0.1 rport 49170" << "\r\n";
+  sdp << "m=video 51372/2 RTP/AVP 99" << "\r\n";
+  sdp << "i=camera" << "\r\n";
+  sdp << "a=rtcp:53020 IN IP4 10.0.0.2" << "\r\n";
+  sdp << "m=image 0 udptl t38" << "\r\n";
+  sdp << "c=IN IP4 10.0.0.3" << "\r\n";
+  sdp << "a=T38FaxVersion:0";
+  return sdp.str();
+}
+
+TEST(ParserTest, test_sdp_span_parser)
+{
+  std::string sdp = test_sdp();
+  SDPParser parser(sdp);
+  ASSERT_TRUE(parser.isValid());
+  ASSERT_EQ(parser.getSessionLineCount(), 5u);
+  ASSERT_EQ(parser.getLines().size(), 16u);
+  ASSERT_EQ(parser.getAddress(), "10.0.0.1");
+  ASSERT_EQ(parser.findHeader('s'), "SDP Seminar");
+  ASSERT_EQ(parser.getMediaCount(), 3u);
+  ASSERT_EQ(parser.getMediaCount(SDPMedia::TYPE_AUDIO), 1u);
+  ASSERT_TRUE(!parser.getMedia(SDPMedia::TYPE_AUDIO, 1));
+
+  const SDPParser::Media* audio = parser.getMedia(SDPMedia::TYPE_AUDIO);
+  ASSERT_TRUE(audio != 0);
+  ASSERT_EQ(parser.getDataPort(*audio), 49170);
+  ASSERT_EQ(parser.getControlPort(*audio), 49171);
+  ASSERT_TRUE(parser.getAddress(*audio).empty());
+  ASSERT_EQ(parser.getAttribute(*audio, "ptime"), "20");
+  SDPParser::Spans candidates;
+  ASSERT_EQ(parser.getAttributes(*audio, "candidate", candidates), 2u);
+  ASSERT_EQ(parser.getString(candidates[0]), "1 1 UDP 2130706431 10.0.0.1 49170 typ host");
+
+  const SDPParser::Media* video = parser.getMedia(SDPMedia::TYPE_VIDEO);
+  ASSERT_TRUE(video != 0);
+  ASSERT_EQ(parser.getDataPort(*video), 51372);
+  ASSERT_EQ(parser.getControlPort(*video), 53020);
+
+  const SDPParser::Media* fax = parser.getMedia(SDPMedia::TYPE_FAX);
+  ASSERT_TRUE(fax != 0);
+  ASSERT_EQ(parser.getAddress(*fax), "10.0.0.3");
+  ASSERT_EQ(parser.getValue(fax->lastLine - 1), "T38FaxVersion:0");
+
+  //
+  // The legacy parser must see the same media descriptions
+  //
+  SDPSession session(sdp.c_str());
+  ASSERT_EQ(session.getMediaCount(SDPMedia::TYPE_NONE), 3u);
+  ASSERT_EQ(session.getMedia(SDPMedia::TYPE_VIDEO)->getDataPort(), 51372);
+  ASSERT_EQ(session.getMedia(SDPMedia::TYPE_FAX)->getAddress(), "10.0.0.3");
+
+  ASSERT_TRUE(!SDPParser("v=0\r\nbogus\r\n").isValid());
+}
+
+TEST(ParserTest, test_sdp_rewriter)
+{
+  std::string sdp = test_sdp();
+  SDPParser parser(sdp);
+  SDPRewriter rewriter(parser);
+  ASSERT_EQ(rewriter.apply(), sdp);
+
+  const SDPParser::Media* audio = parser.getMedia(SDPMedia::TYPE_AUDIO);
+  const SDPParser::Media* video = parser.getMedia(SDPMedia::TYPE_VIDEO);
+  const SDPParser::Media* fax = parser.getMedia(SDPMedia::TYPE_FAX);
+
+  rewriter.changeAddress("192.168.1.1");
+  rewriter.setAddressV4(*audio, "192.168.1.2");
+  rewriter.setDataPort(*audio, 30000);
+  rewriter.setControlPort(*audio, 30005);
+  rewriter.removePtime(*audio);
+  rewriter.setFlagAttribute(*audio, "sendrecv");
+  rewriter.setAddressV4(*video, "192.168.1.3");
+  rewriter.setDataPort(*video, 30010);
+  rewriter.setControlPort(*video, 30011);
+  rewriter.setAddressV4(*fax, "192.168.1.4");
+  rewriter.setFlagAttribute(*fax, "T38FaxFillBitRemoval");
+
+  std::string result = rewriter.apply();
+  SDPParser patched(result);
+  ASSERT_TRUE(patched.isValid());
+  ASSERT_EQ(patched.getAddress(), "192.168.1.1");
+
+  audio = patched.getMedia(SDPMedia::TYPE_AUDIO);
+  ASSERT_EQ(patched.getAddress(*audio), "192.168.1.2");
+  ASSERT_EQ(patched.getValue(audio->firstLine + 1), "IN IP4 192.168.1.2");
+  ASSERT_EQ(patched.getDataPort(*audio), 30000);
+  ASSERT_EQ(patched.getControlPort(*audio), 30005);
+  ASSERT_TRUE(patched.getAttribute(*audio, "ptime").empty());
+  ASSERT_TRUE(patched.findFlagAttribute(*audio, "sendrecv") != SDPParser::npos);
+
+  video = patched.getMedia(SDPMedia::TYPE_VIDEO);
+  ASSERT_EQ(patched.getValue(video->firstLine), "video 30010/2 RTP/AVP 99");
+  ASSERT_EQ(patched.getValue(video->firstLine + 1), "camera");
+  ASSERT_EQ(patched.getValue(video->firstLine + 2), "IN IP4 192.168.1.3");
+  ASSERT_EQ(patched.getAttribute(*video, "rtcp"), "30011");
+
+  fax = patched.getMedia(SDPMedia::TYPE_FAX);
+  ASSERT_EQ(patched.getAddress(*fax), "192.168.1.4");
+  ASSERT_EQ(patched.getValue(fax->lastLine - 2), "T38FaxVersion:0");
+  ASSERT_EQ(patched.getValue(fax->lastLine - 1), "T38FaxFillBitRemoval");
+
+  //
+  // Removing a line wins over edits made within it
+  //
+  SDPRewriter overlap(parser);
+  audio = parser.getMedia(SDPMedia::TYPE_AUDIO);
+  overlap.setDataPort(*audio, 40000);
+  overlap.removeLine(audio->firstLine);
+  ASSERT_EQ(overlap.getPatchCount(), 2u);
+  ASSERT_EQ(overlap.apply().find("m=audio"), std::string::npos);
+
+  //
+  // Inserted lines use the terminator of the body
+  //
+  std::string lf = "v=0\no=- 1 1 IN IP4 10.0.0.1\ns=-\nt=0 0\nm=audio 49170 RTP/AVP 0\n";
+  SDPParser lfParser(lf);
+  SDPRewriter lfRewriter(lfParser);
+  lfRewriter.setAddressV4(*lfParser.getMedia(SDPMedia::TYPE_AUDIO), "10.0.0.2");
+  lfRewriter.setControlPort(*lfParser.getMedia(SDPMedia::TYPE_AUDIO), 49171);
+  ASSERT_EQ(lfRewriter.apply(), lf + "c=IN IP4 10.0.0.2\na=rtcp:49171\n");
+}
+
+TEST(ParserTest, test_sdp_malformed)
+{
+  //
+  // A bad line after a media description leaves nothing indexed that a
+  // rewriter could read past the end of
+  //
+  std::string sdp = "v=0\r\nc=IN IP4 10.0.0.1\r\nm=audio 49170 RTP/AVP 0\r\na=ptime:20\r\nbogus\r\n";
+  SDPParser parser(sdp);
+  ASSERT_FALSE(parser.isValid());
+  ASSERT_TRUE(parser.getLines().empty());
+  ASSERT_EQ(parser.getMediaCount(), 0u);
+  ASSERT_TRUE(parser.getMedia(SDPMedia::TYPE_AUDIO) == 0);
+  ASSERT_EQ(parser.getSessionLineCount(), 0u);
+  ASSERT_EQ(parser.getConnectionLine(), SDPParser::npos);
+  ASSERT_TRUE(parser.getAddress().empty());
+
+  //
+  // A body passed as a string is copied so it may be a temporary
+  //
+  SDPParser copied(test_sdp() + "\r\n");
+  ASSERT_TRUE(copied.isValid());
+  ASSERT_EQ(copied.getAddress(), "10.0.0.1");
+  ASSERT_EQ(copied.getMediaCount(), 3u);
+}
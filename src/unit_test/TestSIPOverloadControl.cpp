@@ -0,0 +1,191 @@
+#include "gtest/gtest.h"
+#include "OSS/SIP/SIPOverloadControl.h"
+#include "OSS/SIP/SIPVia.h"
+
+
+using OSS::SIP::SIPOverloadControl;
+using OSS::SIP::SIPMessage;
+typedef SIPOverloadControl::Time Time;
+
+static const Time MS = 1000;
+
+static const std::string invite =
+  "INVITE sip:bob@example.com SIP/2.0\r\n"
+  "Via: SIP/2.0/UDP 192.0.2.10:5060;branch=z9hG4bK-1;oc;oc-algo=\"loss,rate\",SIP/2.0/UDP 192.0.2.1;branch=z9hG4bK-2\r\n"
+  "Via: SIP/2.0/UDP 192.0.2.2;branch=z9hG4bK-3\r\n"
+  "From: <sip:alice@example.com>;tag=1\r\n"
+  "To: <sip:bob@example.com>\r\n"
+  "Call-ID: overload-test\r\n"
+  "CSeq: 1 INVITE\r\n"
+  "Contact: <sip:alice@192.0.2.10>\r\n"
+  "Content-Length: 0\r\n\r\n";
+
+static void run_intervals(SIPOverloadControl& overload, Time& now, int count, Time delay)
+{
+  for (int i = 0; i < count; i++)
+  {
+    overload.reportQueueDelay(delay, now);
+    now += overload.getInterval() * MS;
+  }
+  overload.admit(now);
+}
+
+TEST(SIPOverloadControlTest, test_reduction)
+{
+  SIPOverloadControl overload;
+  Time now = 1000 * MS;
+  ASSERT_TRUE(overload.admit(now));
+  ASSERT_FALSE(overload.isShedding());
+
+  overload.setEnabled(true);
+  overload.setTargetDelay(10 * MS);
+  overload.setInterval(100);
+  overload.admit(now);
+
+  //
+  // Delays under the target never shed
+  //
+  run_intervals(overload, now, 10, 5 * MS);
+  ASSERT_EQ(0u, overload.getReduction());
+
+  //
+  // A standing queue raises the reduction every interval up to the cap
+  //
+  run_intervals(overload, now, 3, 50 * MS);
+  ASSERT_EQ(3u * SIPOverloadControl::REDUCTION_INCREASE, overload.getReduction());
+  run_intervals(overload, now, 20, 50 * MS);
+  ASSERT_EQ((unsigned int)SIPOverloadControl::DEFAULT_MAX_REDUCTION, overload.getReduction());
+
+  //
+  // A single fast request in the interval shows there is no standing queue
+  //
+  overload.reportQueueDelay(50 * MS, now);
+  overload.reportQueueDelay(1 * MS, now + 10 * MS);
+  now += 100 * MS;
+  overload.admit(now);
+  ASSERT_EQ((unsigned int)SIPOverloadControl::DEFAULT_MAX_REDUCTION - SIPOverloadControl::REDUCTION_DECREASE, overload.getReduction());
+
+  //
+  // Idle intervals bring it back down
+  //
+  now += 10000 * MS;
+  overload.admit(now);
+  ASSERT_EQ(0u, overload.getReduction());
+  ASSERT_FALSE(overload.isShedding());
+
+  //
+  // A depleted worker pool alone is not overload
+  //
+  overload.reportSaturation(now);
+  overload.reportQueueDelay(0, now);
+  now += 100 * MS;
+  overload.admit(now);
+  ASSERT_EQ(0u, overload.getReduction());
+
+  //
+  // It is when requests wait behind it even if others start at once
+  //
+  overload.reportSaturation(now);
+  overload.reportQueueDelay(0, now);
+  overload.reportQueueDelay(50 * MS, now + 10 * MS);
+  now += 100 * MS;
+  overload.admit(now);
+  ASSERT_EQ((unsigned int)SIPOverloadControl::REDUCTION_INCREASE, overload.getReduction());
+}
+
+TEST(SIPOverloadControlTest, test_admit)
+{
+  SIPOverloadControl overload;
+  Time now = 1000 * MS;
+  overload.setEnabled(true);
+  overload.setTargetDelay(10 * MS);
+  overload.admit(now);
+  run_intervals(overload, now, 3, 50 * MS);
+  ASSERT_EQ(30u, overload.getReduction());
+
+  //
+  // Shed requests are spread evenly
+  //
+  int shed = 0;
+  int consecutive = 0;
+  for (int i = 0; i < 1000; i++)
+  {
+    if (!overload.admit(now))
+    {
+      shed++;
+      consecutive++;
+      ASSERT_LT(consecutive, 2);
+    }
+    else
+    {
+      consecutive = 0;
+    }
+  }
+  ASSERT_EQ(300, shed);
+}
+
+TEST(SIPOverloadControlTest, test_feedback)
+{
+  ASSERT_TRUE(SIPOverloadControl::supportsFeedback("SIP/2.0/UDP 192.0.2.10;branch=z9hG4bK-1;oc"));
+  ASSERT_TRUE(SIPOverloadControl::supportsFeedback("SIP/2.0/UDP 192.0.2.10;branch=z9hG4bK-1;oc;oc-algo=\"rate,loss\""));
+  ASSERT_FALSE(SIPOverloadControl::supportsFeedback("SIP/2.0/UDP 192.0.2.10;branch=z9hG4bK-1;oc;oc-algo=\"rate\""));
+  ASSERT_FALSE(SIPOverloadControl::supportsFeedback("SIP/2.0/UDP 192.0.2.10;branch=z9hG4bK-1;oc-seq=1.0"));
+  ASSERT_FALSE(SIPOverloadControl::supportsFeedback("SIP/2.0/UDP oc.example.com;branch=z9hG4bK-oc"));
+
+  SIPOverloadControl overload;
+  Time now = 1000 * MS;
+  overload.setEnabled(true);
+  overload.setTargetDelay(10 * MS);
+  overload.admit(now);
+  run_intervals(overload, now, 2, 50 * MS);
+
+  std::string via = "SIP/2.0/UDP 192.0.2.10;branch=z9hG4bK-1;oc;oc-algo=\"loss,rate\";rport";
+  ASSERT_TRUE(overload.addFeedback(via));
+  std::string value;
+  ASSERT_TRUE(OSS::SIP::SIPVia::getParam(via, "oc", value));
+  ASSERT_EQ("20", value);
+  ASSERT_TRUE(OSS::SIP::SIPVia::getParam(via, "oc-validity", value));
+  ASSERT_EQ("500", value);
+  ASSERT_TRUE(OSS::SIP::SIPVia::getParam(via, "oc-seq", value));
+  ASSERT_NE(std::string::npos, value.find('.'));
+  ASSERT_NE(std::string::npos, via.find(";oc-algo=\"loss\""));
+  ASSERT_EQ(std::string::npos, via.find("rate"));
+  ASSERT_NE(std::string::npos, via.find(";branch=z9hG4bK-1;rport;oc="));
+
+  SIPMessage::Ptr pRequest(new SIPMessage(invite));
+  ASSERT_TRUE(overload.addFeedback(pRequest.get()));
+  std::string topVia;
+  ASSERT_TRUE(OSS::SIP::SIPVia::msgGetTopVia(pRequest.get(), topVia));
+  ASSERT_TRUE(OSS::SIP::SIPVia::getParam(topVia, "oc", value));
+  ASSERT_EQ("20", value);
+  ASSERT_EQ(2u, pRequest->hdrGetSize(OSS::SIP::HDR_VIA));
+  ASSERT_NE(std::string::npos, pRequest->hdrGet(OSS::SIP::HDR_VIA).find(",SIP/2.0/UDP 192.0.2.1;branch=z9hG4bK-2"));
+
+  overload.setFeedbackEnabled(false);
+  via = "SIP/2.0/UDP 192.0.2.10;branch=z9hG4bK-1;oc";
+  ASSERT_FALSE(overload.addFeedback(via));
+}
+
+TEST(SIPOverloadControlTest, test_reject_response)
+{
+  SIPOverloadControl overload;
+  overload.setRetryAfter(7);
+  SIPMessage::Ptr pRequest(new SIPMessage(invite));
+  SIPMessage::Ptr pResponse = overload.createRejectResponse(pRequest, "abc");
+  ASSERT_TRUE(pResponse->isResponse());
+  ASSERT_EQ("SIP/2.0 503 Service Unavailable", pResponse->startLine());
+  ASSERT_EQ(2u, pResponse->hdrGetSize(OSS::SIP::HDR_VIA));
+  ASSERT_EQ(pRequest->hdrGet(OSS::SIP::HDR_VIA, 0), pResponse->hdrGet(OSS::SIP::HDR_VIA, 0));
+  ASSERT_EQ(pRequest->hdrGet(OSS::SIP::HDR_VIA, 1), pResponse->hdrGet(OSS::SIP::HDR_VIA, 1));
+  ASSERT_EQ("<sip:bob@example.com>;tag=abc", pResponse->hdrGet(OSS::SIP::HDR_TO));
+  ASSERT_EQ("overload-test", pResponse->hdrGet(OSS::SIP::HDR_CALL_ID));
+  ASSERT_EQ("1 INVITE", pResponse->hdrGet(OSS::SIP::HDR_CSEQ));
+  ASSERT_EQ("7", pResponse->hdrGet(OSS::SIP::HDR_RETRY_AFTER));
+  ASSERT_FALSE(pResponse->hdrPresent(OSS::SIP::HDR_CONTACT));
+
+  std::string id;
+  std::string responseId;
+  ASSERT_TRUE(pRequest->getTransactionId(id));
+  ASSERT_TRUE(pResponse->getTransactionId(responseId));
+  ASSERT_EQ(id, responseId);
+}
@@ -0,0 +1,102 @@
+#include "gtest/gtest.h"
+#include <boost/thread.hpp>
+#include "OSS/SIP/SIPUDPRetransmissionCache.h"
+
+
+using OSS::SIP::SIPUDPRetransmissionCache;
+typedef SIPUDPRetransmissionCache::Digest Digest;
+typedef SIPUDPRetransmissionCache::EndPoint EndPoint;
+
+static const std::string invite =
+  "INVITE sip:bob@example.com SIP/2.0\r\n"
+  "Via: SIP/2.0/UDP 192.0.2.10:5060;branch=z9hG4bK-524287-1\r\n"
+  "From: <sip:alice@example.com>;tag=1\r\n"
+  "To: <sip:bob@example.com>\r\n"
+  "Call-ID: retransmission-test\r\n"
+  "CSeq: 1 INVITE\r\n"
+  "Content-Length: 0\r\n\r\n";
+
+static const std::string ringing =
+  "SIP/2.0 180 Ringing\r\n"
+  "Via: SIP/2.0/UDP 192.0.2.10:5060;branch=z9hG4bK-524287-1\r\n"
+  "CSeq: 1 INVITE\r\n"
+  "Content-Length: 0\r\n\r\n";
+
+static EndPoint endpoint(const char* ip, unsigned short port)
+{
+  return EndPoint(boost::asio::ip::address::from_string(ip), port);
+}
+
+TEST(SIPUDPRetransmissionCacheTest, test_digest)
+{
+  EndPoint sender = endpoint("192.0.2.10", 5060);
+  Digest digest = SIPUDPRetransmissionCache::computeDigest(invite.data(), invite.size(), sender);
+  ASSERT_TRUE(digest.isValid());
+
+  Digest same = SIPUDPRetransmissionCache::computeDigest(invite.data(), invite.size(), sender);
+  ASSERT_EQ(digest.key, same.key);
+  ASSERT_EQ(digest.check, same.check);
+
+  std::string changed = invite;
+  changed[changed.size() - 5] = '1';
+  Digest other = SIPUDPRetransmissionCache::computeDigest(changed.data(), changed.size(), sender);
+  ASSERT_NE(digest.key, other.key);
+
+  other = SIPUDPRetransmissionCache::computeDigest(invite.data(), invite.size(), endpoint("192.0.2.10", 5062));
+  ASSERT_NE(digest.key, other.key);
+  other = SIPUDPRetransmissionCache::computeDigest(invite.data(), invite.size(), endpoint("2001:db8::10", 5060));
+  ASSERT_NE(digest.key, other.key);
+
+  ASSERT_FALSE(SIPUDPRetransmissionCache::computeDigest(ringing.data(), ringing.size(), sender).isValid());
+}
+
+TEST(SIPUDPRetransmissionCacheTest, test_store_absorb_release)
+{
+  SIPUDPRetransmissionCache cache;
+  EndPoint sender = endpoint("192.0.2.10", 5060);
+  Digest digest = SIPUDPRetransmissionCache::computeDigest(invite.data(), invite.size(), sender);
+  int owner = 0;
+  int stranger = 0;
+
+  SIPUDPRetransmissionCache::Bytes response;
+  EndPoint target;
+  ASSERT_FALSE(cache.lookup(digest, response, target));
+
+  cache.store(digest, &owner, ringing, sender);
+  ASSERT_TRUE(cache.lookup(digest, response, target));
+  ASSERT_TRUE(response);
+  ASSERT_EQ(ringing, *response);
+  ASSERT_EQ(sender, target);
+
+  Digest collision = digest;
+  collision.check++;
+  ASSERT_FALSE(cache.lookup(collision, response, target));
+
+  cache.absorb(digest, &stranger);
+  ASSERT_TRUE(cache.lookup(digest, response, target));
+  ASSERT_TRUE(response);
+  cache.absorb(digest, &owner);
+  ASSERT_TRUE(cache.lookup(digest, response, target));
+  ASSERT_FALSE(response);
+
+  cache.release(digest, &stranger);
+  ASSERT_EQ(1u, cache.size());
+  cache.release(digest, &owner);
+  ASSERT_EQ(0u, cache.size());
+  ASSERT_FALSE(cache.lookup(digest, response, target));
+}
+
+TEST(SIPUDPRetransmissionCacheTest, test_expire)
+{
+  SIPUDPRetransmissionCache cache(50);
+  EndPoint sender = endpoint("192.0.2.10", 5060);
+  Digest digest = SIPUDPRetransmissionCache::computeDigest(invite.data(), invite.size(), sender);
+  int owner = 0;
+  cache.store(digest, &owner, ringing, sender);
+  boost::this_thread::sleep(boost::posix_time::milliseconds(100));
+
+  SIPUDPRetransmissionCache::Bytes response;
+  EndPoint target;
+  ASSERT_FALSE(cache.lookup(digest, response, target));
+  ASSERT_EQ(0u, cache.size());
+}
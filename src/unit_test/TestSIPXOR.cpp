@@ -0,0 +1,89 @@
+#include "gtest/gtest.h"
+#include <algorithm>
+#include "OSS/SIP/SIPXOR.h"
+
+#if ENABLE_FEATURE_XOR
+
+using OSS::SIP::SIPXOR;
+
+
+static void xor_reference(char* packet, int size, const char* key)
+{
+  //
+  // The loop SIPXOR used before it was vectorized.  Deployed clients
+  // depend on its handling of the last byte of odd sized packets.
+  //
+  for (int i = 0; i < size; i += 2)
+  {
+    packet[i] = packet[i] ^ key[0];
+    if (i + 1 < size)
+      packet[i + 1] = packet[i + 1] ^ key[1];
+    if (i + 2 == size - 1)
+    {
+      packet[i + 2] = packet[i + 2] ^ key[1];
+      break;
+    }
+  }
+}
+
+static void xor_reverse(SIPXOR::MutableSpan& span)
+{
+  std::reverse(span.data, span.data + span.size);
+  span.size--;
+}
+
+TEST(SIPXORTest, test_xor_matches_reference)
+{
+  const char key[] = "GS";
+  for (int size = 0; size < 600; size++)
+  {
+    for (int offset = 0; offset < 4; offset++)
+    {
+      std::vector<char> expected(size + offset + 1);
+      for (std::size_t i = 0; i < expected.size(); i++)
+        expected[i] = (char)(i * 31 + size);
+      std::vector<char> actual = expected;
+
+      xor_reference(&expected[offset], size, key);
+      SIPXOR::xorInPlace(&actual[offset], size, key);
+      ASSERT_TRUE(expected == actual) << "size " << size << " offset " << offset;
+    }
+  }
+}
+
+TEST(SIPXORTest, test_xor_round_trip)
+{
+  SIPXOR::setKey("GS");
+  SIPXOR::enable(true);
+
+  boost::array<char, OSS_SIP_MAX_PACKET_SIZE> packet;
+  std::string msg = "OPTIONS sip:bob@example.com SIP/2.0\r\nCall-ID: 1234\r\n\r\n";
+  memcpy(packet.data(), msg.data(), msg.size());
+  std::size_t len = msg.size();
+
+  SIPXOR::sipEncrypt(packet, len);
+  ASSERT_EQ(len, msg.size());
+  ASSERT_NE(std::string(packet.data(), len), msg);
+  SIPXOR::sipDecrypt(boost::asio::buffer(packet), len);
+  ASSERT_EQ(std::string(packet.data(), len), msg);
+
+  SIPXOR::enable(false);
+}
+
+TEST(SIPXORTest, test_xor_span_handler)
+{
+  SIPXOR::enable(true);
+  SIPXOR::rtpEncryptInPlace = xor_reverse;
+
+  boost::array<char, RTP_PACKET_BUFFER_SIZE> packet;
+  memcpy(packet.data(), "abcd", 4);
+  std::size_t len = 4;
+  SIPXOR::rtpEncrypt(packet, len);
+  ASSERT_EQ(len, 3);
+  ASSERT_EQ(std::string(packet.data(), len), "dcb");
+
+  SIPXOR::rtpEncryptInPlace = SIPXOR::SpanFunc();
+  SIPXOR::enable(false);
+}
+
+#endif // ENABLE_FEATURE_XOR
@@ -0,0 +1,119 @@
+#include "gtest/gtest.h"
+#include <boost/thread.hpp>
+#include <boost/lexical_cast.hpp>
+#include "OSS/UTL/TimedQueue.h"
+
+
+static boost::mutex expiredMutex;
+static std::vector<std::string> expired;
+
+static void on_expire(const std::string& id, const boost::any& data)
+{
+  boost::mutex::scoped_lock lock(expiredMutex);
+  expired.push_back(id);
+}
+
+static OSS::TimedQueue* pRequeue = 0;
+
+static void on_expire_requeue(const std::string& id, const boost::any& data)
+{
+  on_expire(id, data);
+  int count = boost::any_cast<int>(data);
+  if (count)
+  {
+    pRequeue->enqueue(id, count - 1, on_expire_requeue, 1);
+  }
+}
+
+static std::size_t expired_count()
+{
+  boost::mutex::scoped_lock lock(expiredMutex);
+  return expired.size();
+}
+
+static bool wait_for_expired(std::size_t count, unsigned int timeout)
+{
+  //
+  // Deadlines are only checked on a tick and the wheel thread may be
+  // scheduled late on a loaded machine.  Poll instead of sleeping for
+  // an exact window.
+  //
+  for (unsigned int waited = 0; expired_count() < count && waited < timeout; waited += 10)
+  {
+    boost::this_thread::sleep(boost::posix_time::milliseconds(10));
+  }
+  return expired_count() >= count;
+}
+
+TEST(TimedQueueTest, test_get_and_dequeue)
+{
+  OSS::TimedQueue queue(10);
+  queue.enqueue("a", 1);
+  queue.enqueue("b", 2);
+  queue.enqueue("a", 3);
+  ASSERT_EQ(2u, queue.size());
+
+  boost::any data;
+  ASSERT_TRUE(queue.get("a", data));
+  ASSERT_EQ(3, boost::any_cast<int>(data));
+  ASSERT_TRUE(queue.dequeue("b", data));
+  ASSERT_EQ(2, boost::any_cast<int>(data));
+  ASSERT_FALSE(queue.get("b", data));
+  queue.erase("a");
+  ASSERT_EQ(0u, queue.size());
+
+  //
+  // Enough records to rehash the index several times
+  //
+  for (int i = 0; i < 5000; i++)
+  {
+    queue.enqueue("record-" + boost::lexical_cast<std::string>(i), i);
+  }
+  ASSERT_EQ(5000u, queue.size());
+  for (int i = 0; i < 5000; i += 2)
+  {
+    queue.erase("record-" + boost::lexical_cast<std::string>(i));
+  }
+  ASSERT_EQ(2500u, queue.size());
+  ASSERT_TRUE(queue.get("record-4999", data));
+  ASSERT_EQ(4999, boost::any_cast<int>(data));
+  ASSERT_FALSE(queue.get("record-4998", data));
+}
+
+TEST(TimedQueueTest, test_expire)
+{
+  expired.clear();
+  OSS::TimedQueue queue(10, 16);
+  for (int i = 0; i < 1000; i++)
+  {
+    queue.enqueue("record-" + boost::lexical_cast<std::string>(i), i, on_expire, 1);
+  }
+  queue.erase("record-10");
+  queue.enqueue("record-20", 20);
+  queue.enqueue("record-30", 30, on_expire, 2);
+
+  //
+  // Nothing may expire early.  Late is fine as long as it happens.
+  //
+  boost::this_thread::sleep(boost::posix_time::milliseconds(500));
+  ASSERT_EQ(0u, expired_count());
+  ASSERT_TRUE(wait_for_expired(997, 10000));
+
+  boost::any data;
+  ASSERT_TRUE(queue.get("record-20", data));
+  ASSERT_TRUE(wait_for_expired(998, 10000));
+  ASSERT_EQ(998u, expired_count());
+  ASSERT_EQ("record-30", expired.back());
+  ASSERT_EQ(1u, queue.size());
+}
+
+TEST(TimedQueueTest, test_requeue_from_handler)
+{
+  expired.clear();
+  OSS::TimedQueue queue(10);
+  pRequeue = &queue;
+  queue.enqueue("requeue", 1, on_expire_requeue, 1);
+  ASSERT_TRUE(wait_for_expired(2, 10000));
+  ASSERT_EQ(2u, expired_count());
+  ASSERT_EQ(0u, queue.size());
+}
@@ -0,0 +1,176 @@
+#include "gtest/gtest.h"
+#include "OSS/Net/TlsSessionCache.h"
+#include <openssl/x509.h>
+#include <openssl/ec.h>
+
+
+using OSS::Net::TlsSessionCache;
+
+
+static EVP_PKEY* create_key()
+{
+  EVP_PKEY* pkey = 0;
+  EVP_PKEY_CTX* pctx = EVP_PKEY_CTX_new_id(EVP_PKEY_EC, 0);
+  EVP_PKEY_keygen_init(pctx);
+  EVP_PKEY_CTX_set_ec_paramgen_curve_nid(pctx, NID_X9_62_prime256v1);
+  EVP_PKEY_keygen(pctx, &pkey);
+  EVP_PKEY_CTX_free(pctx);
+  return pkey;
+}
+
+static X509* create_certificate(EVP_PKEY* pkey)
+{
+  X509* cert = X509_new();
+  ASN1_INTEGER_set(X509_get_serialNumber(cert), 1);
+  X509_gmtime_adj(X509_get_notBefore(cert), 0);
+  X509_gmtime_adj(X509_get_notAfter(cert), 3600);
+  X509_set_pubkey(cert, pkey);
+  X509_NAME* name = X509_get_subject_name(cert);
+  X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC, (const unsigned char*)"oss_core", -1, -1, 0);
+  X509_set_issuer_name(cert, name);
+  X509_sign(cert, pkey, EVP_sha256());
+  return cert;
+}
+
+struct TlsPair
+{
+  TlsPair() :
+    server(boost::asio::ssl::context::sslv23_server),
+    client(boost::asio::ssl::context::sslv23_client)
+  {
+    EVP_PKEY* pkey = create_key();
+    X509* cert = create_certificate(pkey);
+    SSL_CTX_use_certificate(server.native_handle(), cert);
+    SSL_CTX_use_PrivateKey(server.native_handle(), pkey);
+    X509_free(cert);
+    EVP_PKEY_free(pkey);
+  }
+
+  bool connect(TlsSessionCache& cache, const std::string& peer, bool& reused, bool noTicket = false)
+  {
+    SSL* s = SSL_new(server.native_handle());
+    SSL* c = SSL_new(client.native_handle());
+    if (noTicket)
+      SSL_set_options(s, SSL_OP_NO_TICKET);
+
+    BIO* sbio = 0;
+    BIO* cbio = 0;
+    BIO_new_bio_pair(&sbio, 0, &cbio, 0);
+    SSL_set_bio(s, sbio, sbio);
+    SSL_set_bio(c, cbio, cbio);
+    SSL_set_accept_state(s);
+    SSL_set_connect_state(c);
+    cache.prepareClientSession(c, peer);
+
+    bool serverDone = false;
+    bool clientDone = false;
+    for (int i = 0; i < 100 && (!serverDone || !clientDone); i++)
+    {
+      if (!clientDone)
+        clientDone = SSL_do_handshake(c) == 1;
+      if (!serverDone)
+        serverDone = SSL_do_handshake(s) == 1;
+    }
+
+    if (serverDone && clientDone)
+    {
+      //
+      // TLS 1.3 tickets arrive after the handshake.  Exchange some data
+      // so the client processes them.
+      //
+      char buf[4];
+      SSL_write(s, "ping", 4);
+      SSL_read(c, buf, sizeof(buf));
+    }
+
+    cache.onHandshake(s, true, serverDone);
+    cache.onHandshake(c, false, clientDone);
+    reused = SSL_session_reused(c) && SSL_session_reused(s);
+
+    cache.onDisconnect(s);
+    cache.onDisconnect(c);
+    SSL_free(s);
+    SSL_free(c);
+    return serverDone && clientDone;
+  }
+
+  boost::asio::ssl::context server;
+  boost::asio::ssl::context client;
+};
+
+TEST(TlsSessionCacheTest, test_ticket_resumption_and_rotation)
+{
+  TlsPair tls;
+  TlsSessionCache cache;
+  ASSERT_TRUE(cache.enableServerCache(tls.server));
+  ASSERT_TRUE(cache.enableSessionTickets(tls.server));
+  ASSERT_TRUE(cache.enableClientCache(tls.client));
+
+  bool reused = true;
+  ASSERT_TRUE(tls.connect(cache, "10.0.0.1:5061", reused));
+  ASSERT_FALSE(reused);
+  ASSERT_EQ(1u, cache.getStats().clientCacheSize);
+
+  ASSERT_TRUE(tls.connect(cache, "10.0.0.1:5061", reused));
+  ASSERT_TRUE(reused);
+
+  //
+  // A different peer does not get the session
+  //
+  ASSERT_TRUE(tls.connect(cache, "10.0.0.2:5061", reused));
+  ASSERT_FALSE(reused);
+  ASSERT_EQ(2u, cache.getStats().clientCacheSize);
+
+  //
+  // Tickets issued with the previous key are still accepted
+  //
+  cache.rotateTicketKeys();
+  ASSERT_TRUE(tls.connect(cache, "10.0.0.1:5061", reused));
+  ASSERT_TRUE(reused);
+
+  //
+  // The peer was handed a ticket with the new key on the last connection
+  // but 10.0.0.2 still holds one encrypted with a key that is now gone
+  //
+  cache.rotateTicketKeys();
+  ASSERT_TRUE(tls.connect(cache, "10.0.0.2:5061", reused));
+  ASSERT_FALSE(reused);
+
+  TlsSessionCache::Stats stats = cache.getStats();
+  ASSERT_EQ(5u, stats.serverHandshakes);
+  ASSERT_EQ(2u, stats.serverResumed);
+  ASSERT_EQ(5u, stats.clientHandshakes);
+  ASSERT_EQ(2u, stats.clientResumed);
+  ASSERT_EQ(2u, stats.ticketKeyRotations);
+  ASSERT_EQ(0u, stats.failedHandshakes);
+  ASSERT_GE(stats.handshakesPerSecond, 0u);
+
+  cache.removeClientSession("10.0.0.1:5061");
+  ASSERT_EQ(1u, cache.getStats().clientCacheSize);
+}
+
+TEST(TlsSessionCacheTest, test_server_session_cache)
+{
+  TlsPair tls;
+  TlsSessionCache cache;
+  ASSERT_TRUE(cache.enableServerCache(tls.server));
+  ASSERT_TRUE(cache.enableClientCache(tls.client, 2));
+
+  //
+  // Without tickets the server keeps the session state
+  //
+  bool reused = true;
+  ASSERT_TRUE(tls.connect(cache, "10.0.0.1:5061", reused, true));
+  ASSERT_FALSE(reused);
+  ASSERT_GE(cache.getStats().serverCacheSize, 1u);
+
+  ASSERT_TRUE(tls.connect(cache, "10.0.0.1:5061", reused, true));
+  ASSERT_TRUE(reused);
+
+  //
+  // The least recently used peer is evicted beyond maxPeers
+  //
+  ASSERT_TRUE(tls.connect(cache, "10.0.0.2:5061", reused, true));
+  ASSERT_TRUE(tls.connect(cache, "10.0.0.3:5061", reused, true));
+  ASSERT_EQ(2u, cache.getStats().clientCacheSize);
+}
@@ -0,0 +1,185 @@
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "GNU Lesser General Public License (LGPL)".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+
+#include "OSS/UTL/MemoryArena.h"
+#include <cstdlib>
+#include <boost/atomic.hpp>
+
+
+namespace OSS {
+namespace UTL {
+
+
+//
+// Process wide counters
+//
+static boost::atomic<OSS::UInt64> gAllocations(0);
+static boost::atomic<OSS::UInt64> gBytesAllocated(0);
+static boost::atomic<OSS::UInt64> gHeapAllocations(0);
+static boost::atomic<OSS::UInt64> gHeapBytes(0);
+static boost::atomic<OSS::UInt64> gReleases(0);
+
+
+static inline char* align_pointer(char* ptr, std::size_t alignment)
+{
+  std::size_t address = reinterpret_cast<std::size_t>(ptr);
+  std::size_t aligned = (address + alignment - 1) & ~(alignment - 1);
+  return reinterpret_cast<char*>(aligned);
+}
+
+MemoryArena::Stats::Stats() :
+  allocations(0),
+  bytesAllocated(0),
+  heapAllocations(0),
+  heapBytes(0),
+  releases(0)
+{
+}
+
+MemoryArena::MemoryArena(std::size_t initialChunkSize) :
+  _chunks(0),
+  _current(0),
+  _end(0),
+  _nextChunkSize(initialChunkSize ? initialChunkSize : (std::size_t)DEFAULT_CHUNK_SIZE),
+  _initialChunkSize(_nextChunkSize)
+{
+}
+
+MemoryArena::~MemoryArena()
+{
+  release();
+}
+
+void* MemoryArena::allocate(std::size_t size, std::size_t alignment)
+{
+  if (!size)
+    size = 1;
+  if (!alignment || (alignment & (alignment - 1)))
+    alignment = sizeof(void*);
+
+  OSS::mutex_critic_sec_lock lock(_mutex);
+  _stats.allocations++;
+  _stats.bytesAllocated += size;
+  gAllocations++;
+  gBytesAllocated += size;
+
+  if (_current)
+  {
+    char* ptr = align_pointer(_current, alignment);
+    if (ptr + size <= _end)
+    {
+      _current = ptr + size;
+      return ptr;
+    }
+  }
+  return allocateChunk(size, alignment);
+}
+
+void* MemoryArena::allocateChunk(std::size_t size, std::size_t alignment)
+{
+  //
+  // Chunks grow geometrically up to MAX_CHUNK_SIZE.  Requests that would
+  // not fit in a regular chunk get a dedicated one so they do not waste
+  // the remaining space of the current chunk.
+  //
+  std::size_t required = sizeof(Chunk) + size + alignment;
+  std::size_t chunkSize = _nextChunkSize;
+  bool dedicated = required > chunkSize;
+  if (dedicated)
+    chunkSize = required;
+
+  Chunk* chunk = static_cast<Chunk*>(std::malloc(chunkSize));
+  if (!chunk)
+    throw std::bad_alloc();
+
+  chunk->size = chunkSize;
+  _stats.heapAllocations++;
+  _stats.heapBytes += chunkSize;
+  gHeapAllocations++;
+  gHeapBytes += chunkSize;
+
+  char* begin = reinterpret_cast<char*>(chunk) + sizeof(Chunk);
+  char* end = reinterpret_cast<char*>(chunk) + chunkSize;
+  char* ptr = align_pointer(begin, alignment);
+
+  if (dedicated && _chunks)
+  {
+    //
+    // Insert behind the active chunk so that the bump pointer keeps
+    // serving small requests from the chunk it is currently in.
+    //
+    chunk->next = _chunks->next;
+    _chunks->next = chunk;
+    return ptr;
+  }
+
+  chunk->next = _chunks;
+  _chunks = chunk;
+  _current = ptr + size;
+  _end = end;
+
+  if (!dedicated && _nextChunkSize < (std::size_t)MAX_CHUNK_SIZE)
+    _nextChunkSize *= 2;
+
+  return ptr;
+}
+
+void MemoryArena::deallocate(void* /*ptr*/, std::size_t /*size*/)
+{
+}
+
+void MemoryArena::release()
+{
+  OSS::mutex_critic_sec_lock lock(_mutex);
+  if (!_chunks)
+    return;
+
+  while (_chunks)
+  {
+    Chunk* next = _chunks->next;
+    std::free(_chunks);
+    _chunks = next;
+  }
+  _current = 0;
+  _end = 0;
+  _nextChunkSize = _initialChunkSize;
+  _stats.releases++;
+  gReleases++;
+}
+
+MemoryArena::Stats MemoryArena::getStats() const
+{
+  OSS::mutex_critic_sec_lock lock(_mutex);
+  return _stats;
+}
+
+MemoryArena::Stats MemoryArena::getGlobalStats()
+{
+  Stats stats;
+  stats.allocations = gAllocations;
+  stats.bytesAllocated = gBytesAllocated;
+  stats.heapAllocations = gHeapAllocations;
+  stats.heapBytes = gHeapBytes;
+  stats.releases = gReleases;
+  return stats;
+}
+
+
+} } // OSS::UTL
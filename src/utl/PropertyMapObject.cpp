@@ -27,10 +27,19 @@ PropertyMapObject::PropertyMapObject()
 {
 }
 
+PropertyMapObject::PropertyMapObject(OSS::UTL::MemoryArena* pArena) :
+  _internalProperties(std::less<PropertyKey>(), InternalAllocator(pArena))
+{
+}
+
 PropertyMapObject::PropertyMapObject(const PropertyMapObject& copy)
 {
+  //
+  // Copies always allocate from the heap.  The arena of the source object
+  // is scoped to its owner and must not leak into the copy.
+  //
   OSS::mutex_read_lock lock(copy._internalPropertiesMutex);
-  _internalProperties = copy._internalProperties;
+  assignProperties(_internalProperties, copy._internalProperties);
 }
 
 PropertyMapObject& PropertyMapObject::operator = (const PropertyMapObject& copy)
@@ -44,7 +53,18 @@ void PropertyMapObject::swap(PropertyMapObject& copy)
 {
   OSS::mutex_write_lock lock_theirs(copy._internalPropertiesMutex);
   OSS::mutex_write_lock lock_ours(_internalPropertiesMutex);
-  std::swap(_internalProperties, copy._internalProperties);
+  if (_internalProperties.get_allocator() == copy._internalProperties.get_allocator())
+  {
+    _internalProperties.swap(copy._internalProperties);
+    return;
+  }
+  //
+  // Each side keeps its own arena.  Rebuild the entries in place.
+  //
+  InternalProperties ours;
+  assignProperties(ours, _internalProperties);
+  assignProperties(_internalProperties, copy._internalProperties);
+  assignProperties(copy._internalProperties, ours);
 }
 
 void PropertyMapObject::setProperty(const std::string& property, const std::string& value)
@@ -53,7 +73,7 @@ void PropertyMapObject::setProperty(const std::string& property, const std::stri
     return;
   
   OSS::mutex_write_lock lock(_internalPropertiesMutex);
-  _internalProperties[property] = value;
+  setProperty(_internalProperties, property.data(), property.size(), value.data(), value.size());
 }
 
 bool PropertyMapObject::getProperty(const std::string&  property, std::string& value) const
@@ -62,10 +82,10 @@ bool PropertyMapObject::getProperty(const std::string&  property, std::string& v
     return false;
   
   OSS::mutex_read_lock lock_theirs(_internalPropertiesMutex);
-  InternalProperties::const_iterator iter = _internalProperties.find(property);
+  InternalProperties::const_iterator iter = _internalProperties.find(PropertyKey(property.data(), property.size()));
   if (iter != _internalProperties.end())
   {
-    value = iter->second;
+    value.assign(iter->second.data(), iter->second.size());
     return true;
   }
   return false;
@@ -84,6 +104,45 @@ void PropertyMapObject::clearProperties()
   _internalProperties.clear();
 }
 
+void PropertyMapObject::assignProperties(InternalProperties& target, const InternalProperties& source)
+{
+  target.clear();
+  for (InternalProperties::const_iterator iter = source.begin(); iter != source.end(); iter++)
+  {
+    setProperty(target, iter->first.data(), iter->first.size(), iter->second.data(), iter->second.size());
+  }
+}
+
+void PropertyMapObject::setProperty(InternalProperties& properties, const char* property, std::size_t propertySize,
+  const char* value, std::size_t valueSize)
+{
+  InternalAllocator allocator = properties.get_allocator();
+  std::pair<InternalProperties::iterator, bool> result = properties.insert(
+    InternalProperties::value_type(PropertyKey(property, propertySize, allocator), ArenaString(allocator)));
+  if (result.second)
+  {
+    try
+    {
+      result.first->first.own();
+    }
+    catch(...)
+    {
+      //
+      // The key still points to the bytes of the caller
+      //
+      properties.erase(result.first);
+      throw;
+    }
+  }
+
+  ArenaString& current = result.first->second;
+  if (valueSize > current.capacity())
+  {
+    current.reserve(valueSize > 2 * current.capacity() ? valueSize : 2 * current.capacity());
+  }
+  current.assign(value, valueSize);
+}
+
 } // OSS
 
 